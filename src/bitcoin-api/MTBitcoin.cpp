@@ -77,7 +77,13 @@ BtcRawTransactionPtr MTBitcoin::WaitGetRawTransaction(const std::string &txId)
 
 int32_t MTBitcoin::GetConfirmations(const std::string &txId)
 {
-    return this->modules->btcHelper->GetConfirmations(txId);
+    bool deeperThanSearched = false;
+    int32_t confirmations = this->modules->btcHelper->GetConfirmations(txId, BtcHelper::BlockSearchDepth, &deeperThanSearched);
+
+    if(deeperThanSearched)
+        return -1;
+
+    return confirmations < 0 ? 0 : confirmations;   // conflicted
 }
 
 bool MTBitcoin::TransactionSuccessful(const int64_t &amount, BtcRawTransactionPtr rawTransaction, const std::string &targetAddress, const int32_t &confirmations)
@@ -86,6 +86,7 @@ public:
     virtual BtcRawTransactionPtr WaitGetRawTransaction(const std::string &txId);
 
     // Returns the number of confirmations of a raw transaction
+    // -1 if it's older than the blocks that were searched (or unknown), 0 if it's conflicted
     virtual int32_t GetConfirmations(const std::string &txId);
 
     virtual bool TransactionSuccessful(const int64_t &amount, BtcRawTransactionPtr rawTransaction, const std::string &targetAddress, const int32_t &confirmations = BtcHelper::WaitForConfirms);
@@ -4,6 +4,8 @@ HEADERS += \
     $${PWD}/FastDelegate.hpp \
     $${PWD}/FastDelegateBind.hpp \
     $${PWD}/bitcoinapi.hpp \
+    $${PWD}/btcblockindex.hpp \
+    $${PWD}/btccoinselection.hpp \
     $${PWD}/btchelper.hpp \
     $${PWD}/btcjson.hpp \
     $${PWD}/btcjsonlegacy.hpp \
@@ -19,6 +21,8 @@ HEADERS += \
 
 SOURCES += \
     $${PWD}/bitcoinapi.cpp \
+    $${PWD}/btcblockindex.cpp \
+    $${PWD}/btccoinselection.cpp \
     $${PWD}/btchelper.cpp \
     $${PWD}/btcjson.cpp \
     $${PWD}/btcjsonlegacy.cpp \
@@ -0,0 +1,288 @@
+#ifndef __STABLE_HPP__
+#include <core/stable.hpp>
+#endif
+
+#include <bitcoin-api/btcblockindex.hpp>
+
+#include <bitcoin-api/btcmodules.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// first line of the index file, bump it if the format changes
+#define INDEX_FILE_HEADER "btcblockindex 1"
+
+
+BtcBlockIndex::BtcBlockIndex(BtcModules *modules, int32_t maxDepth)
+{
+    this->modules = modules;
+    this->maxDepth = maxDepth > 0 ? maxDepth : DefaultMaxDepth;
+    this->savedBlocks = 0;
+}
+
+void BtcBlockIndex::SetFile(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(this->indexMutex);
+
+    this->filePath = path;
+
+    this->blocks.clear();
+    this->txHeights.clear();
+    this->savedBlocks = 0;
+
+    Load();
+}
+
+bool BtcBlockIndex::Update()
+{
+    std::lock_guard<std::mutex> lock(this->indexMutex);
+
+    int32_t chainHeight = this->modules->btcJson->GetBlockCount();
+    if(chainHeight < 0)
+        return false;
+
+    bool removed = false;   // blocks were taken off the top, the file has to be rewritten
+    size_t added = 0;
+
+    // drop blocks that aren't in bitcoind's chain anymore, or never were (wrong chain in the file)
+    while(!this->blocks.empty())
+    {
+        const BlockEntry &tip = this->blocks.back();
+        if(tip.height <= chainHeight)
+        {
+            std::string chainHash = this->modules->btcJson->GetBlockHash(tip.height);
+            if(chainHash.empty())
+                return false;   // don't throw the index away just because bitcoind didn't answer
+
+            if(chainHash == tip.hash)
+                break;
+        }
+
+        RemoveTopBlock();
+        removed = true;
+    }
+
+    // we don't need anything older than maxDepth, start there if we're that far behind
+    int32_t nextHeight = chainHeight - this->maxDepth + 1;
+    if(nextHeight < 0)
+        nextHeight = 0;
+    if(!this->blocks.empty() && this->blocks.back().height + 1 >= nextHeight)
+        nextHeight = this->blocks.back().height + 1;
+    else if(!this->blocks.empty())
+    {
+        this->blocks.clear();   // the gap is too big to fill, start over
+        this->txHeights.clear();
+        removed = true;
+    }
+
+    while(nextHeight <= chainHeight)
+    {
+        BtcBlockPtr block = this->modules->btcJson->GetBlock(this->modules->btcJson->GetBlockHash(nextHeight));
+        if(block == NULL)
+            break;
+
+        // reorg while we were fetching: go back one and try again
+        if(!this->blocks.empty() && block->previousHash != this->blocks.back().hash)
+        {
+            RemoveTopBlock();
+            nextHeight--;
+            removed = true;
+            if(added > 0)
+                added--;
+            continue;
+        }
+
+        BlockEntry entry;
+        entry.height = nextHeight;
+        entry.hash = block->hash;
+        entry.previousHash = block->previousHash;
+        entry.transactions = block->transactions;
+        AddBlock(entry);
+        added++;
+
+        nextHeight++;
+    }
+
+    while(static_cast<int32_t>(this->blocks.size()) > this->maxDepth)
+        RemoveBottomBlock();
+
+    // new blocks are appended, the file is only rewritten after a reorg or once it's twice as long as needed
+    if(removed || this->savedBlocks + static_cast<int32_t>(added) > 2 * this->maxDepth)
+        Save();
+    else if(added > 0)
+        Append(added);
+
+    return true;
+}
+
+int32_t BtcBlockIndex::GetConfirmations(const std::string &txId)
+{
+    std::lock_guard<std::mutex> lock(this->indexMutex);
+
+    std::unordered_map<std::string, int32_t>::const_iterator it = this->txHeights.find(txId);
+    if(it == this->txHeights.end() || this->blocks.empty())
+        return -1;
+
+    return this->blocks.back().height - it->second + 1;
+}
+
+int32_t BtcBlockIndex::GetTipHeight()
+{
+    std::lock_guard<std::mutex> lock(this->indexMutex);
+
+    return this->blocks.empty() ? -1 : this->blocks.back().height;
+}
+
+int32_t BtcBlockIndex::GetBottomHeight()
+{
+    std::lock_guard<std::mutex> lock(this->indexMutex);
+
+    return this->blocks.empty() ? -1 : this->blocks.front().height;
+}
+
+void BtcBlockIndex::AddBlock(const BlockEntry &block)
+{
+    this->blocks.push_back(block);
+
+    for(btc::stringList::const_iterator txId = block.transactions.begin(); txId != block.transactions.end(); txId++)
+        this->txHeights[(*txId)] = block.height;
+}
+
+void BtcBlockIndex::RemoveTopBlock()
+{
+    const BlockEntry &block = this->blocks.back();
+
+    for(btc::stringList::const_iterator txId = block.transactions.begin(); txId != block.transactions.end(); txId++)
+    {
+        std::unordered_map<std::string, int32_t>::iterator it = this->txHeights.find((*txId));
+        if(it != this->txHeights.end() && it->second == block.height)
+            this->txHeights.erase(it);
+    }
+
+    this->blocks.pop_back();
+}
+
+void BtcBlockIndex::RemoveBottomBlock()
+{
+    const BlockEntry &block = this->blocks.front();
+
+    for(btc::stringList::const_iterator txId = block.transactions.begin(); txId != block.transactions.end(); txId++)
+    {
+        std::unordered_map<std::string, int32_t>::iterator it = this->txHeights.find((*txId));
+        if(it != this->txHeights.end() && it->second == block.height)
+            this->txHeights.erase(it);
+    }
+
+    this->blocks.pop_front();
+}
+
+// one block per line: height hash previousHash txId txId ...
+// the file can hold more than maxDepth blocks, only the latest are kept
+bool BtcBlockIndex::Load()
+{
+    if(this->filePath.empty())
+        return false;
+
+    std::ifstream file(this->filePath.c_str());
+    if(!file.is_open())
+        return false;
+
+    std::string line;
+    if(!std::getline(file, line) || line != INDEX_FILE_HEADER)
+        return false;
+
+    while(std::getline(file, line))
+    {
+        std::istringstream lineStream(line);
+
+        BlockEntry entry;
+        if(!(lineStream >> entry.height >> entry.hash >> entry.previousHash))
+            break;
+
+        // a file that doesn't continue the chain is broken, keep what came before
+        if(!this->blocks.empty() && (entry.height != this->blocks.back().height + 1 || entry.previousHash != this->blocks.back().hash))
+            break;
+
+        if(entry.previousHash == "-")
+            entry.previousHash = std::string();     // genesis
+
+        std::string txId;
+        while(lineStream >> txId)
+            entry.transactions.push_back(txId);
+
+        AddBlock(entry);
+        this->savedBlocks++;
+    }
+
+    while(static_cast<int32_t>(this->blocks.size()) > this->maxDepth)
+        RemoveBottomBlock();
+
+    return true;
+}
+
+bool BtcBlockIndex::Save()
+{
+    if(this->filePath.empty())
+        return false;
+
+    // write to a temporary file first so a crash doesn't leave half an index behind
+    const std::string tempPath = this->filePath + ".tmp";
+
+    {
+        std::ofstream file(tempPath.c_str(), std::ios::out | std::ios::trunc);
+        if(!file.is_open())
+            return false;
+
+        file << INDEX_FILE_HEADER << "\n";
+
+        for(std::deque<BlockEntry>::const_iterator block = this->blocks.begin(); block != this->blocks.end(); block++)
+            WriteBlock(file, (*block));
+
+        if(!file.good())
+            return false;
+    }
+
+    if(std::rename(tempPath.c_str(), this->filePath.c_str()) != 0)
+    {
+        // windows won't rename over an existing file
+        std::remove(this->filePath.c_str());
+        if(std::rename(tempPath.c_str(), this->filePath.c_str()) != 0)
+            return false;
+    }
+
+    this->savedBlocks = static_cast<int32_t>(this->blocks.size());
+    return true;
+}
+
+bool BtcBlockIndex::Append(size_t count)
+{
+    if(this->filePath.empty())
+        return false;
+
+    // a missing file needs the header
+    if(this->savedBlocks == 0)
+        return Save();
+
+    std::ofstream file(this->filePath.c_str(), std::ios::out | std::ios::app);
+    if(!file.is_open())
+        return false;
+
+    for(size_t i = this->blocks.size() - count; i < this->blocks.size(); i++)
+        WriteBlock(file, this->blocks[i]);
+
+    if(!file.good())
+        return false;
+
+    this->savedBlocks += static_cast<int32_t>(count);
+    return true;
+}
+
+void BtcBlockIndex::WriteBlock(std::ostream &file, const BlockEntry &block)
+{
+    file << block.height << " " << block.hash << " " << (block.previousHash.empty() ? "-" : block.previousHash);
+    for(btc::stringList::const_iterator txId = block.transactions.begin(); txId != block.transactions.end(); txId++)
+        file << " " << (*txId);
+    file << "\n";
+}
@@ -0,0 +1,89 @@
+#ifndef BTCBLOCKINDEX_HPP
+#define BTCBLOCKINDEX_HPP
+
+#include "core/WinsockWrapper.h"
+#include "core/ExportWrapper.h"
+#include "core/TR1_Wrapper.hpp"
+
+#include <bitcoin-api/btcobjects.hpp>
+
+#include _CINTTYPES
+#include _MEMORY
+
+#include <deque>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+
+class BtcModules;
+
+/*
+ * Remembers which block each transaction of the last few blocks went into,
+ * so we can count confirmations without asking bitcoind for block after block.
+ *
+ * Update() only fetches blocks that are new since the last time. Every new block
+ * has to point back at the one before it, if it doesn't there was a reorg and
+ * blocks are dropped from the top until the index agrees with bitcoind again.
+ *
+ * Only the latest maxDepth blocks are kept. Transactions older than that
+ * aren't found, GetConfirmations() then returns -1 and the caller decides.
+ *
+ * If a file is set the index is saved there after each update and read back on start.
+ */
+class BtcBlockIndex
+{
+public:
+    BtcBlockIndex(BtcModules* modules, int32_t maxDepth = DefaultMaxDepth);
+
+    // default number of blocks to keep, a day's worth
+    static const int32_t DefaultMaxDepth = 288;
+
+    // sets where the index is saved and loads whatever is there
+    void SetFile(const std::string &path);
+
+    // fetches new blocks from bitcoind and handles reorgs
+    // returns false if bitcoind couldn't be asked
+    bool Update();
+
+    // confirmations of a transaction in the indexed blocks, counting from the index's tip
+    // returns -1 if it isn't in them
+    int32_t GetConfirmations(const std::string &txId);
+
+    // heights of the newest and oldest indexed block, -1 if there are none
+    int32_t GetTipHeight();
+    int32_t GetBottomHeight();
+
+private:
+    struct BlockEntry
+    {
+        int32_t height;
+        std::string hash;
+        std::string previousHash;
+        btc::stringList transactions;
+    };
+
+    void AddBlock(const BlockEntry &block);
+    void RemoveTopBlock();
+    void RemoveBottomBlock();
+
+    bool Load();
+    bool Save();                    // writes the whole index
+    bool Append(size_t count);      // adds the latest count blocks to the file
+    static void WriteBlock(std::ostream &file, const BlockEntry &block);
+
+    BtcModules* modules;
+
+    int32_t maxDepth;
+    std::string filePath;
+    int32_t savedBlocks;                                        // blocks in the file, some may be older than maxDepth
+
+    std::mutex indexMutex;
+    std::deque<BlockEntry> blocks;                              // oldest first
+    std::unordered_map<std::string, int32_t> txHeights;         // txid -> height of its block
+};
+
+typedef _SharedPtr<BtcBlockIndex> BtcBlockIndexPtr;
+
+#endif // BTCBLOCKINDEX_HPP
@@ -0,0 +1,522 @@
+#ifndef __STABLE_HPP__
+#include <core/stable.hpp>
+#endif
+
+#include <bitcoin-api/btccoinselection.hpp>
+
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <unordered_set>
+
+
+BtcCoinSelectionParams::BtcCoinSelectionParams()
+{
+    this->feePerKb = DefaultFeePerKb;
+    this->minFee = 0;
+    this->dustLimit = DefaultDustLimit;
+    this->baseSize = BaseSize;
+    this->inputSize = P2PKHInputSize;
+    this->outputSize = OutputSize;
+}
+
+int64_t BtcCoinSelectionParams::EstimateFee(size_t inputs, size_t outputs) const
+{
+    int64_t size = this->baseSize + static_cast<int64_t>(inputs) * this->inputSize + static_cast<int64_t>(outputs) * this->outputSize;
+    int64_t fee = (size * this->feePerKb + 999) / 1000;   // round up, paying a satoshi too little gets the tx stuck
+    return std::max(fee, this->minFee);
+}
+
+int64_t BtcCoinSelectionParams::InputFee() const
+{
+    return (this->inputSize * this->feePerKb + 999) / 1000;
+}
+
+int32_t BtcCoinSelectionParams::MultiSigInputSize(int32_t sigsRequired, int32_t keys)
+{
+    // OP_m <pubkey>... OP_n OP_CHECKMULTISIG, compressed keys
+    int32_t redeemScript = 3 + keys * 34;
+    // OP_0 <sig>... <redeemScript>, signatures are up to 72 bytes plus their push
+    int32_t scriptSig = 1 + sigsRequired * 73 + (redeemScript < 76 ? 1 : redeemScript < 256 ? 2 : 3) + redeemScript;
+    // outpoint, script length, script, sequence
+    return 36 + (scriptSig < 253 ? 1 : 3) + scriptSig + 4;
+}
+
+
+BtcCoinSelectionPtr BtcCoinSelectionStrategy::MakeSelection(const BtcUnspentOutputs &outputs, int64_t amount, const BtcCoinSelectionParams &params)
+{
+    if(outputs.empty() || amount <= 0)
+        return BtcCoinSelectionPtr();
+
+    int64_t total = 0;
+    for(BtcUnspentOutputs::const_iterator output = outputs.begin(); output != outputs.end(); output++)
+        total += (*output)->amount;
+
+    int64_t feeNoChange = params.EstimateFee(outputs.size(), 1);
+    if(total < amount + feeNoChange)
+        return BtcCoinSelectionPtr();
+
+    BtcCoinSelectionPtr selection = BtcCoinSelectionPtr(new BtcCoinSelection());
+    selection->outputs = outputs;
+    selection->amount = amount;
+    selection->total = total;
+
+    int64_t feeWithChange = params.EstimateFee(outputs.size(), 2);
+    int64_t change = total - amount - feeWithChange;
+    if(change >= params.dustLimit)
+    {
+        selection->fee = feeWithChange;
+        selection->change = change;
+    }
+    else
+    {
+        // not worth an output, the miner gets it
+        selection->fee = total - amount;
+        selection->change = 0;
+    }
+
+    return selection;
+}
+
+
+BtcCoinSelectionPtr BtcLargestFirstSelection::Select(const BtcUnspentOutputs &outputs, int64_t amount, const BtcCoinSelectionParams &params)
+{
+    BtcUnspentOutputs selected;
+    for(BtcUnspentOutputs::const_iterator output = outputs.begin(); output != outputs.end(); output++)
+    {
+        selected.push_back((*output));
+
+        BtcCoinSelectionPtr selection = MakeSelection(selected, amount, params);
+        if(selection != NULL)
+            return selection;
+    }
+
+    return BtcCoinSelectionPtr();
+}
+
+
+BtcCoinSelectionPtr BtcBranchAndBoundSelection::Select(const BtcUnspentOutputs &outputs, int64_t amount, const BtcCoinSelectionParams &params)
+{
+    // work with what each output is worth after paying for its input
+    std::vector<BtcUnspentOutputPtr> candidates(outputs.begin(), outputs.end());
+    std::vector<int64_t> values;
+    values.reserve(candidates.size());
+    int64_t remaining = 0;
+    for(size_t i = 0; i < candidates.size(); i++)
+    {
+        values.push_back(candidates[i]->amount - params.InputFee());
+        remaining += values[i];
+    }
+
+    // anything within costOfChange above the target wouldn't get a change output anyway
+    const int64_t target = amount + params.EstimateFee(0, 1);
+    const int64_t costOfChange = params.EstimateFee(0, 2) - params.EstimateFee(0, 1) + params.dustLimit;
+
+    std::vector<bool> included(candidates.size(), false);
+    std::vector<bool> best;
+    int64_t bestWaste = -1;
+
+    int64_t current = 0;
+    size_t count = 0;
+    size_t index = 0;       // next output to decide on
+
+    for(int tries = 0; tries < MaxTries; tries++)
+    {
+        bool backtrack = false;
+        if(current + remaining < target || current >= target + costOfChange)
+            backtrack = true;       // can't reach the target anymore or already too far over it
+        else if(bestWaste >= 0 && count > 1 && static_cast<int64_t>(count - 1) * params.InputFee() >= bestWaste)
+            backtrack = true;       // more inputs can only be worse than what we have
+        else if(current >= target)
+        {
+            // what goes to the miner beyond a one input transaction, so a close match with
+            // many inputs doesn't beat one with a few
+            int64_t waste = current - target + static_cast<int64_t>(count - 1) * params.InputFee();
+            if(bestWaste < 0 || waste < bestWaste)
+            {
+                best = included;
+                bestWaste = waste;
+            }
+
+            if(waste == 0)
+                break;          // can't do better than that
+            backtrack = true;
+        }
+
+        if(backtrack)
+        {
+            // undo the decisions after the last output we took, then leave that one out instead
+            while(index > 0 && !included[index - 1])
+            {
+                index--;
+                remaining += values[index];
+            }
+
+            if(index == 0)
+                break;          // searched everything
+
+            included[index - 1] = false;
+            current -= values[index - 1];
+            count--;
+            continue;
+        }
+
+        // take the next output
+        remaining -= values[index];
+        current += values[index];
+        included[index] = true;
+        count++;
+        index++;
+    }
+
+    if(bestWaste < 0)
+        return BtcCoinSelectionPtr();
+
+    BtcUnspentOutputs selected;
+    for(size_t i = 0; i < candidates.size(); i++)
+    {
+        if(best[i])
+            selected.push_back(candidates[i]);
+    }
+
+    return MakeSelection(selected, amount, params);
+}
+
+
+BtcCoinSelectionPtr BtcKnapsackSelection::Select(const BtcUnspentOutputs &outputs, int64_t amount, const BtcCoinSelectionParams &params)
+{
+    // enough for amount, fee and change worth keeping
+    const int64_t target = amount + params.EstimateFee(0, 2) + params.dustLimit;
+
+    std::vector<BtcUnspentOutputPtr> lower;
+    std::vector<int64_t> values;
+    int64_t lowerTotal = 0;
+    BtcUnspentOutputPtr smallestLarger;
+    int64_t smallestLargerValue = 0;
+
+    for(BtcUnspentOutputs::const_iterator output = outputs.begin(); output != outputs.end(); output++)
+    {
+        int64_t value = (*output)->amount - params.InputFee();
+        if(value >= target)
+        {
+            // sorted largest first, so the last one we see is the smallest
+            smallestLarger = (*output);
+            smallestLargerValue = value;
+        }
+        else
+        {
+            lower.push_back((*output));
+            values.push_back(value);
+            lowerTotal += value;
+        }
+    }
+
+    if(lowerTotal < target)
+    {
+        BtcUnspentOutputs selected;
+        if(smallestLarger != NULL)
+            selected.push_back(smallestLarger);
+        else
+            selected.insert(selected.end(), lower.begin(), lower.end());    // maybe enough without change
+
+        return MakeSelection(selected, amount, params);
+    }
+
+    // random passes over the smaller outputs, keep the set that overshoots the least
+    std::mt19937 random(0x5eed);
+    std::vector<bool> best(lower.size(), true);
+    int64_t bestTotal = lowerTotal;
+
+    for(int pass = 0; pass < Passes && bestTotal != target; pass++)
+    {
+        std::vector<bool> included(lower.size(), false);
+        int64_t total = 0;
+        bool reached = false;
+
+        // first take each output with even odds, then whatever is left, until the target is reached
+        for(int round = 0; round < 2 && !reached; round++)
+        {
+            for(size_t i = 0; i < lower.size(); i++)
+            {
+                if(round == 0 ? (random() & 1) == 0 : included[i])
+                    continue;
+
+                total += values[i];
+                included[i] = true;
+                if(total >= target)
+                {
+                    reached = true;
+                    if(total < bestTotal)
+                    {
+                        bestTotal = total;
+                        best = included;
+                    }
+
+                    // try to get closer without this one
+                    total -= values[i];
+                    included[i] = false;
+                }
+            }
+        }
+    }
+
+    BtcUnspentOutputs selected;
+    if(smallestLarger != NULL && smallestLargerValue <= bestTotal)
+        selected.push_back(smallestLarger);
+    else
+    {
+        for(size_t i = 0; i < lower.size(); i++)
+        {
+            if(best[i])
+                selected.push_back(lower[i]);
+        }
+    }
+
+    return MakeSelection(selected, amount, params);
+}
+
+
+BtcCoinSelector::BtcCoinSelector()
+{
+    this->strategies.push_back(BtcCoinSelectionStrategyPtr(new BtcBranchAndBoundSelection()));
+    this->strategies.push_back(BtcCoinSelectionStrategyPtr(new BtcKnapsackSelection()));
+    this->strategies.push_back(BtcCoinSelectionStrategyPtr(new BtcLargestFirstSelection()));
+}
+
+void BtcCoinSelector::SetStrategies(const std::vector<BtcCoinSelectionStrategyPtr> &strategies)
+{
+    this->strategies = strategies;
+}
+
+static bool LargerOutput(const BtcUnspentOutputPtr &a, const BtcUnspentOutputPtr &b)
+{
+    // ties are broken by outpoint so the order doesn't depend on how bitcoind listed them
+    if(a->amount != b->amount)
+        return a->amount > b->amount;
+    if(a->txId != b->txId)
+        return a->txId < b->txId;
+    return a->vout < b->vout;
+}
+
+BtcCoinSelectionPtr BtcCoinSelector::Select(const BtcUnspentOutputs &outputs, int64_t amount, const BtcCoinSelectionParams &params)
+{
+    if(amount <= 0)
+        return BtcCoinSelectionPtr();
+
+    std::vector<BtcUnspentOutputPtr> candidates;
+    for(BtcUnspentOutputs::const_iterator output = outputs.begin(); output != outputs.end(); output++)
+    {
+        // conflicted outputs and dust that costs more to spend than it's worth
+        if((*output) == NULL || (*output)->confirmations < 0 || (*output)->amount <= params.InputFee())
+            continue;
+
+        candidates.push_back((*output));
+    }
+
+    std::sort(candidates.begin(), candidates.end(), LargerOutput);
+    BtcUnspentOutputs sorted(candidates.begin(), candidates.end());
+
+    BtcCoinSelectionPtr best;
+    int64_t bestCost = 0;
+    for(std::vector<BtcCoinSelectionStrategyPtr>::iterator strategy = this->strategies.begin(); strategy != this->strategies.end(); strategy++)
+    {
+        BtcCoinSelectionPtr selection = (*strategy)->Select(sorted, amount, params);
+        if(selection == NULL)
+            continue;
+
+        int64_t cost = GetCost(selection, params);
+        if(best == NULL || cost < bestCost)
+        {
+            best = selection;
+            bestCost = cost;
+        }
+    }
+
+    return best;
+}
+
+int64_t BtcCoinSelector::GetCost(BtcCoinSelectionPtr selection, const BtcCoinSelectionParams &params)
+{
+    // change comes back as an output that needs an input of its own some day
+    return selection->fee + (selection->change > 0 ? params.InputFee() : 0);
+}
+
+
+std::string BtcUtxoSet::OutPoint(const std::string &txId, int64_t vout)
+{
+    std::ostringstream outPoint;
+    outPoint << txId << ":" << vout;
+    return outPoint.str();
+}
+
+void BtcUtxoSet::Update(const btc::stringList &addresses, const BtcUnspentOutputs &unspentOutputs)
+{
+    std::lock_guard<std::mutex> lock(this->utxoMutex);
+
+    std::unordered_set<std::string> listed;
+    for(BtcUnspentOutputs::const_iterator output = unspentOutputs.begin(); output != unspentOutputs.end(); output++)
+    {
+        const std::string outPoint = OutPoint((*output)->txId, (*output)->vout);
+        listed.insert(outPoint);
+
+        if(this->outputs.find(outPoint) == this->outputs.end())
+            AddEntry(outPoint, (*output));
+    }
+
+    // whatever these addresses had that isn't listed anymore was spent
+    for(btc::stringList::const_iterator address = addresses.begin(); address != addresses.end(); address++)
+    {
+        std::unordered_map<std::string, SortedOutputs>::iterator addressOutputs = this->byAddress.find((*address));
+        if(addressOutputs == this->byAddress.end())
+            continue;
+
+        std::vector<std::string> spent;
+        for(SortedOutputs::iterator key = addressOutputs->second.begin(); key != addressOutputs->second.end(); key++)
+        {
+            if(listed.find(key->second) == listed.end())
+                spent.push_back(key->second);
+        }
+
+        for(size_t i = 0; i < spent.size(); i++)
+            RemoveEntry(this->outputs.find(spent[i]));
+    }
+}
+
+void BtcUtxoSet::SetOwner(const std::string &address, const std::string &owner)
+{
+    std::lock_guard<std::mutex> lock(this->utxoMutex);
+
+    this->owners[address] = owner;
+
+    std::unordered_map<std::string, SortedOutputs>::iterator addressOutputs = this->byAddress.find(address);
+    if(addressOutputs == this->byAddress.end())
+        return;
+
+    for(SortedOutputs::iterator key = addressOutputs->second.begin(); key != addressOutputs->second.end(); key++)
+    {
+        Entry &entry = this->outputs[key->second];
+        if(entry.owner == owner)
+            continue;
+
+        if(!entry.owner.empty())
+        {
+            this->byOwner[entry.owner].erase((*key));
+            if(this->byOwner[entry.owner].empty())
+                this->byOwner.erase(entry.owner);
+        }
+
+        entry.owner = owner;
+        if(!owner.empty())
+            this->byOwner[owner].insert((*key));
+    }
+}
+
+bool BtcUtxoSet::Add(BtcUnspentOutputPtr output)
+{
+    std::lock_guard<std::mutex> lock(this->utxoMutex);
+
+    const std::string outPoint = OutPoint(output->txId, output->vout);
+    if(this->outputs.find(outPoint) != this->outputs.end())
+        return false;
+
+    AddEntry(outPoint, output);
+    return true;
+}
+
+bool BtcUtxoSet::Remove(const std::string &txId, int64_t vout)
+{
+    std::lock_guard<std::mutex> lock(this->utxoMutex);
+
+    std::unordered_map<std::string, Entry>::iterator entry = this->outputs.find(OutPoint(txId, vout));
+    if(entry == this->outputs.end())
+        return false;
+
+    RemoveEntry(entry);
+    return true;
+}
+
+BtcUnspentOutputs BtcUtxoSet::GetByAddress(const std::string &address)
+{
+    std::lock_guard<std::mutex> lock(this->utxoMutex);
+
+    return GetSorted(this->byAddress, address);
+}
+
+BtcUnspentOutputs BtcUtxoSet::GetByOwner(const std::string &owner)
+{
+    std::lock_guard<std::mutex> lock(this->utxoMutex);
+
+    return GetSorted(this->byOwner, owner);
+}
+
+int64_t BtcUtxoSet::GetBalance(const std::string &address)
+{
+    std::lock_guard<std::mutex> lock(this->utxoMutex);
+
+    int64_t balance = 0;
+    std::unordered_map<std::string, SortedOutputs>::const_iterator addressOutputs = this->byAddress.find(address);
+    if(addressOutputs == this->byAddress.end())
+        return balance;
+
+    for(SortedOutputs::const_iterator key = addressOutputs->second.begin(); key != addressOutputs->second.end(); key++)
+        balance += key->first;
+
+    return balance;
+}
+
+size_t BtcUtxoSet::size()
+{
+    std::lock_guard<std::mutex> lock(this->utxoMutex);
+
+    return this->outputs.size();
+}
+
+void BtcUtxoSet::AddEntry(const std::string &outPoint, BtcUnspentOutputPtr output)
+{
+    Entry entry;
+    entry.output = output;
+
+    std::unordered_map<std::string, std::string>::iterator owner = this->owners.find(output->address);
+    if(owner != this->owners.end())
+        entry.owner = owner->second;
+
+    this->outputs[outPoint] = entry;
+
+    const SortKey key(output->amount, outPoint);
+    this->byAddress[output->address].insert(key);
+    if(!entry.owner.empty())
+        this->byOwner[entry.owner].insert(key);
+}
+
+void BtcUtxoSet::RemoveEntry(std::unordered_map<std::string, Entry>::iterator entry)
+{
+    const SortKey key(entry->second.output->amount, entry->first);
+    const std::string &address = entry->second.output->address;
+
+    this->byAddress[address].erase(key);
+    if(this->byAddress[address].empty())
+        this->byAddress.erase(address);
+
+    if(!entry->second.owner.empty())
+    {
+        this->byOwner[entry->second.owner].erase(key);
+        if(this->byOwner[entry->second.owner].empty())
+            this->byOwner.erase(entry->second.owner);
+    }
+
+    this->outputs.erase(entry);
+}
+
+BtcUnspentOutputs BtcUtxoSet::GetSorted(const std::unordered_map<std::string, SortedOutputs> &index, const std::string &key)
+{
+    BtcUnspentOutputs sorted;
+
+    std::unordered_map<std::string, SortedOutputs>::const_iterator found = index.find(key);
+    if(found == index.end())
+        return sorted;
+
+    for(SortedOutputs::const_iterator output = found->second.begin(); output != found->second.end(); output++)
+        sorted.push_back(this->outputs[output->second].output);
+
+    return sorted;
+}
@@ -0,0 +1,192 @@
+#ifndef BTCCOINSELECTION_HPP
+#define BTCCOINSELECTION_HPP
+
+#include "core/WinsockWrapper.h"
+#include "core/ExportWrapper.h"
+#include "core/TR1_Wrapper.hpp"
+
+#include <bitcoin-api/btcobjects.hpp>
+
+#include _CINTTYPES
+#include _MEMORY
+
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+/*
+ * Picks which unspent outputs pay for a transaction.
+ *
+ * The fee is estimated from the size of the transaction, so every input has to
+ * be worth more than it costs to spend it. Change below the dust limit isn't
+ * worth an output of its own and goes to the fee instead.
+ *
+ * BtcCoinSelector asks several strategies and takes the cheapest answer: a set of
+ * outputs that pays amount + fee without needing change (branch and bound),
+ * a knapsack search that leaves change, or simply the largest outputs.
+ * Strategies can be swapped with SetStrategies().
+ */
+
+// sizes in bytes and fee rate used to estimate what a transaction costs
+struct BtcCoinSelectionParams
+{
+    BtcCoinSelectionParams();
+
+    int64_t feePerKb;           // satoshis per 1000 bytes
+    int64_t minFee;             // never pay less than this
+    int64_t dustLimit;          // smallest change that gets its own output
+    int32_t baseSize;           // version, locktime, input and output counts
+    int32_t inputSize;          // one input including its signatures
+    int32_t outputSize;         // one output
+
+    // fee for a transaction with this many inputs and outputs
+    int64_t EstimateFee(size_t inputs, size_t outputs) const;
+    // what an input adds to the fee
+    int64_t InputFee() const;
+
+    // size of an input spending a m-of-n p2sh multisig output
+    static int32_t MultiSigInputSize(int32_t sigsRequired, int32_t keys);
+
+    static const int64_t DefaultFeePerKb = 10000;   // 0.0001 btc/kb
+    static const int64_t DefaultDustLimit = 546;    // bitcoind's limit for p2pkh outputs
+    static const int32_t P2PKHInputSize = 148;
+    static const int32_t OutputSize = 34;
+    static const int32_t BaseSize = 10;
+};
+
+// the outputs to spend and where the money goes
+struct BtcCoinSelection
+{
+    BtcUnspentOutputs outputs;
+    int64_t amount;             // sent to the recipient
+    int64_t fee;
+    int64_t change;             // 0 if the transaction has no change output
+    int64_t total;              // sum of the outputs
+};
+
+typedef _SharedPtr<BtcCoinSelection> BtcCoinSelectionPtr;
+
+class BtcCoinSelectionStrategy
+{
+public:
+    virtual ~BtcCoinSelectionStrategy() {}
+
+    // outputs are sorted by amount, largest first
+    // returns NULL if they can't pay amount + fee
+    virtual BtcCoinSelectionPtr Select(const BtcUnspentOutputs &outputs, int64_t amount, const BtcCoinSelectionParams &params) = 0;
+
+    virtual const char* GetName() const = 0;
+
+    // fee and change for spending these outputs, NULL if they aren't enough
+    static BtcCoinSelectionPtr MakeSelection(const BtcUnspentOutputs &outputs, int64_t amount, const BtcCoinSelectionParams &params);
+};
+
+typedef _SharedPtr<BtcCoinSelectionStrategy> BtcCoinSelectionStrategyPtr;
+
+// takes the largest outputs until they're enough
+class BtcLargestFirstSelection : public BtcCoinSelectionStrategy
+{
+public:
+    virtual BtcCoinSelectionPtr Select(const BtcUnspentOutputs &outputs, int64_t amount, const BtcCoinSelectionParams &params);
+    virtual const char* GetName() const { return "largest first"; }
+};
+
+// depth-first search for outputs that pay amount + fee so closely that change wouldn't be worth it
+// returns NULL if it doesn't find such a set within MaxTries steps
+class BtcBranchAndBoundSelection : public BtcCoinSelectionStrategy
+{
+public:
+    virtual BtcCoinSelectionPtr Select(const BtcUnspentOutputs &outputs, int64_t amount, const BtcCoinSelectionParams &params);
+    virtual const char* GetName() const { return "branch and bound"; }
+
+    static const int MaxTries = 100000;
+};
+
+// bitcoind's old approach: an exact match, or random passes for the smallest
+// set that leaves enough change, or else the smallest single output that does.
+// the random numbers are seeded the same every time, so the result is reproducible
+class BtcKnapsackSelection : public BtcCoinSelectionStrategy
+{
+public:
+    virtual BtcCoinSelectionPtr Select(const BtcUnspentOutputs &outputs, int64_t amount, const BtcCoinSelectionParams &params);
+    virtual const char* GetName() const { return "knapsack"; }
+
+    static const int Passes = 1000;
+};
+
+class BtcCoinSelector
+{
+public:
+    // branch and bound, knapsack and largest first
+    BtcCoinSelector();
+
+    // all of them are asked, the cheapest selection wins, on a tie the one that comes first
+    void SetStrategies(const std::vector<BtcCoinSelectionStrategyPtr> &strategies);
+
+    // the fee plus what it will cost to spend the change later
+    static int64_t GetCost(BtcCoinSelectionPtr selection, const BtcCoinSelectionParams &params);
+
+    // outputs can be in any order, unspendable ones and ones that cost more to spend than they're worth are skipped
+    // returns NULL if all of them together aren't enough
+    BtcCoinSelectionPtr Select(const BtcUnspentOutputs &outputs, int64_t amount, const BtcCoinSelectionParams &params = BtcCoinSelectionParams());
+
+private:
+    std::vector<BtcCoinSelectionStrategyPtr> strategies;
+};
+
+typedef _SharedPtr<BtcCoinSelector> BtcCoinSelectorPtr;
+
+/*
+ * Unspent outputs by address and by owner, largest first.
+ * Fed from listunspent, only the differences to what's already there are applied.
+ */
+class BtcUtxoSet
+{
+public:
+    // makes the outputs of these addresses match a listunspent result.
+    // outputs that aren't listed anymore are removed, new ones get the owner the address was assigned
+    void Update(const btc::stringList &addresses, const BtcUnspentOutputs &unspentOutputs);
+
+    // outputs to this address belong to owner from now on, e.g. the client of a multisig address
+    void SetOwner(const std::string &address, const std::string &owner);
+
+    bool Add(BtcUnspentOutputPtr output);
+    bool Remove(const std::string &txId, int64_t vout);
+
+    BtcUnspentOutputs GetByAddress(const std::string &address);
+    BtcUnspentOutputs GetByOwner(const std::string &owner);
+    int64_t GetBalance(const std::string &address);
+
+    size_t size();
+
+private:
+    typedef std::pair<int64_t, std::string> SortKey;    // amount, outpoint
+    typedef std::set<SortKey, std::greater<SortKey> > SortedOutputs;
+
+    struct Entry
+    {
+        BtcUnspentOutputPtr output;
+        std::string owner;
+    };
+
+    static std::string OutPoint(const std::string &txId, int64_t vout);
+
+    void AddEntry(const std::string &outPoint, BtcUnspentOutputPtr output);
+    void RemoveEntry(std::unordered_map<std::string, Entry>::iterator entry);
+    BtcUnspentOutputs GetSorted(const std::unordered_map<std::string, SortedOutputs> &index, const std::string &key);
+
+    std::mutex utxoMutex;
+    std::unordered_map<std::string, Entry> outputs;                 // outpoint -> output
+    std::unordered_map<std::string, SortedOutputs> byAddress;
+    std::unordered_map<std::string, SortedOutputs> byOwner;
+    std::unordered_map<std::string, std::string> owners;            // address -> owner
+};
+
+typedef _SharedPtr<BtcUtxoSet> BtcUtxoSetPtr;
+
+#endif // BTCCOINSELECTION_HPP
@@ -49,11 +49,15 @@ int32_t BtcHelper::MinConfirms = 0;         // used for listunspent, should be z
 int32_t BtcHelper::MaxConfirms = 9999999;   // used for listunspent, it's 9999999 in bitcoin-qt
 int32_t BtcHelper::WaitForConfirms = 2;     // confirmations to wait for before accepting a transaction as confirmed. should be higher.
 int64_t BtcHelper::FeeMultiSig = BtcHelper::CoinsToSatoshis(0.001);
+int32_t BtcHelper::BlockSearchDepth = 144;  // a day's worth of blocks beyond the index
 
 BtcHelper::BtcHelper(BtcModules *modules)
 {
     this->modules = modules;
 
+    this->blockIndex = BtcBlockIndexPtr(new BtcBlockIndex(modules));
+    this->coinSelector = BtcCoinSelectorPtr(new BtcCoinSelector());
+
     std::string str = btc::to_string(0);
 }
 
@@ -106,6 +110,54 @@ bool BtcHelper::IsMine(const std::string &address)
     return false;
 }
 
+std::vector<bool> BtcHelper::IsMine(const btc::stringList &addresses)
+{
+    std::vector<bool> isMine(addresses.size(), false);
+
+    std::vector<BtcAddressInfoPtr> addrInfos = this->modules->btcJson->ValidateAddresses(addresses);
+
+    // addresses making up multisigs, and which of the addresses above they belong to
+    btc::stringList multiSigSigningAddrs;
+    std::vector<size_t> multiSigOwners;
+
+    for(size_t i = 0; i < addrInfos.size(); i++)
+    {
+        BtcAddressInfoPtr addrInfo = addrInfos[i];
+        if(addrInfo == NULL || !addrInfo->isvalid)
+            continue;
+
+        // is it ours and do we own the public key? then we also know the private key.
+        if(addrInfo->ismine && !addrInfo->pubkey.empty())
+        {
+            isMine[i] = true;
+            continue;
+        }
+
+        if(addrInfo->isScript)
+        {
+            for(btc::stringList::const_iterator multiSigSigningAddr = addrInfo->addresses.begin(); multiSigSigningAddr != addrInfo->addresses.end(); multiSigSigningAddr++)
+            {
+                multiSigSigningAddrs.push_back((*multiSigSigningAddr));
+                multiSigOwners.push_back(i);
+            }
+        }
+    }
+
+    if(multiSigSigningAddrs.empty())
+        return isMine;
+
+    // multisig addresses can't be made from multisig addresses, so one more level is all there is
+    std::vector<BtcAddressInfoPtr> signingAddrInfos = this->modules->btcJson->ValidateAddresses(multiSigSigningAddrs);
+    for(size_t i = 0; i < signingAddrInfos.size(); i++)
+    {
+        BtcAddressInfoPtr addrInfo = signingAddrInfos[i];
+        if(addrInfo != NULL && addrInfo->isvalid && addrInfo->ismine && !addrInfo->pubkey.empty())
+            isMine[multiSigOwners[i]] = true;
+    }
+
+    return isMine;
+}
+
 BtcBalancesPtr BtcHelper::GetBalances()
 {
     BtcBalancesPtr balances = BtcBalancesPtr(new BtcBalances());
@@ -149,6 +201,21 @@ BtcRawTransactionPtr BtcHelper::GetDecodedRawTransaction(const std::string &txId
     return this->modules->btcJson->GetDecodedRawTransaction(txId);
 }
 
+std::vector<BtcRawTransactionPtr> BtcHelper::GetDecodedRawTransactions(const btc::stringList &txIds) const
+{
+    std::vector<BtcRawTransactionPtr> rawTransactions = this->modules->btcJson->GetDecodedRawTransactions(txIds);
+
+    // without -txindex bitcoind only finds some of them in the block database, the wallet might know the others
+    btc::stringList::const_iterator txId = txIds.begin();
+    for(size_t i = 0; i < rawTransactions.size(); i++, txId++)
+    {
+        if(rawTransactions[i] == NULL)
+            rawTransactions[i] = GetDecodedRawTransaction((*txId));
+    }
+
+    return rawTransactions;
+}
+
 int64_t BtcHelper::GetTotalOutput(const std::string &txId, const std::string &targetAddress)
 {
     if(txId.empty() || targetAddress.empty())
@@ -192,8 +259,11 @@ int64_t BtcHelper::GetTotalOutput(BtcRawTransactionPtr transaction, const std::s
     return amountReceived;
 }
 
-int32_t BtcHelper::GetConfirmations(const std::string &txId)
+int32_t BtcHelper::GetConfirmations(const std::string &txId, const int32_t &maxSearchDepth, bool *deeperThanSearched)
 {
+    if(deeperThanSearched != NULL)
+        *deeperThanSearched = false;
+
     if(txId.empty())
         return 0;
 
@@ -203,44 +273,76 @@ int32_t BtcHelper::GetConfirmations(const std::string &txId)
         return transaction->Confirmations;
 
 
-    // otherwise we will have to crawl through the blockchain:
+    // otherwise we will have to look through the blockchain:
 
     // firstly, see if the transaction isn't included in a block yet
     std::vector<std::string> rawMemPool = this->modules->btcJson->GetRawMemPool();
     if(std::find(rawMemPool.begin(), rawMemPool.end(), txId) != rawMemPool.end())
         return 0;    // 0 confirmations if still in mempool
 
-    // if it is, we'll need to loop through the latest blocks until we find it
-    // getblockcount --> getblockhash(count) --> getblock(hash) --> getblock(block->previous) -->...
-    // get number of latest block (this is also called 'height')
-    int latestBlock = this->modules->btcJson->GetBlockCount();
-    // get hash of latest block
-    std::string blockHash = this->modules->btcJson->GetBlockHash(latestBlock);
+    // the block index knows the latest blocks, it only fetches the ones that are new since last time
+    std::string blockHash;
+    int64_t confirmations = 1;  // first block = first confirmation
+
+    if(this->blockIndex->Update())
+    {
+        int32_t indexedConfirmations = this->blockIndex->GetConfirmations(txId);
+        if(indexedConfirmations > 0)
+            return indexedConfirmations;
+
+        // not in there, so it's older than the index (or bogus). continue below the index's oldest block.
+        int32_t bottomHeight = this->blockIndex->GetBottomHeight();
+        if(bottomHeight <= 0)
+            return 0;   // the index goes all the way back to genesis
+
+        blockHash = this->modules->btcJson->GetBlockHash(bottomHeight - 1);
+        confirmations = this->blockIndex->GetTipHeight() - bottomHeight + 2;
+    }
+    else
+    {
+        // index can't be updated, so start at the top
+        // getblockcount --> getblockhash(count) --> getblock(hash) --> getblock(block->previous) -->...
+        int latestBlock = this->modules->btcJson->GetBlockCount();
+        blockHash = this->modules->btcJson->GetBlockHash(latestBlock);
+    }
+
     // get the actual block
     BtcBlockPtr currentBlock = this->modules->btcJson->GetBlock(blockHash);
     // the block might not be downloaded yet, in that case return
     if(currentBlock == NULL)    // I'm not sure how this can happen but i think it did.
         return 0;
 
-    int64_t confirmations = 1;  // first block = first confirmation
+    int32_t blocksSearched = 1;
 
     // see if txId is NOT in the block's transaction list
     while(std::find(currentBlock->transactions.begin(), currentBlock->transactions.end(), txId) == currentBlock->transactions.end())
     {
+        // limited so a bogus txId doesn't make us walk the whole chain
+        if(blocksSearched >= maxSearchDepth)
+        {
+            // older than we're willing to look, or not in the chain at all
+            if(deeperThanSearched != NULL)
+                *deeperThanSearched = true;
+            return 0;
+        }
+
         confirmations++;
+        blocksSearched++;
 
         currentBlock = this->modules->btcJson->GetBlock(currentBlock->previousHash);
         if(currentBlock == NULL)
-            return 0;   // Genesis block - this should never happen I think. except maybe during forks
-                        // oh shit this could also happen if we check for a bogus txId
-                        // ==> DoS
-                        // TODO: optional argument to limit number of blocks to check?
+            return 0;   // Genesis block
     }
 
     // if we find it in an old enough block, return number of confirmations
     return confirmations;
 }
 
+void BtcHelper::SetBlockIndexFile(const std::string &path)
+{
+    this->blockIndex->SetFile(path);
+}
+
 btc::stringList BtcHelper::GetDoubleSpends(const std::string &txId)
 {
     if(txId.empty())
@@ -255,7 +357,15 @@ btc::stringList BtcHelper::GetDoubleSpends(const std::string &txId)
 
 int64_t BtcHelper::TransactionConfirmed(const std::string &txId, const int32_t &minConfirms)
 {
-    return GetConfirmations(txId) >= minConfirms;
+    bool deeperThanSearched = false;
+    int32_t confirmations = GetConfirmations(txId, BlockSearchDepth, &deeperThanSearched);
+
+    // not in the blocks that were searched, so it's in an older one if it exists at all
+    if(deeperThanSearched)
+        return !this->modules->btcJson->GetRawTransaction(txId).empty();
+
+    // negative: conflicted, it will never confirm
+    return confirmations >= 0 && confirmations >= minConfirms;
 }
 
 bool BtcHelper::TransactionSuccessfull(int64_t amount, BtcTransactionPtr transaction, const std::string &targetAddress, int minConfirms)
@@ -432,17 +542,18 @@ BtcUnspentOutputs BtcHelper::ListNewOutputs(BtcUnspentOutputs knownOutputs, cons
 BtcUnspentOutputs BtcHelper::FindSignableOutputs(const btc::stringList &txIds)
 {
     BtcUnspentOutputs outputsToCheck;
-    std::string lastTxId = std::string();   // prevent double inserts
 
-    // iterate through txids
-    for(btc::stringList::const_iterator txId = txIds.begin(); txId != txIds.end(); txId++)
+    // get transaction details
+    btc::stringList uniqueTxIds = UniqueTxIds(txIds);
+    std::vector<BtcRawTransactionPtr> txRaws = GetDecodedRawTransactions(uniqueTxIds);
+
+    btc::stringList::const_iterator txId = uniqueTxIds.begin();
+    for(size_t i = 0; i < txRaws.size(); i++, txId++)
     {
-        if((*txId) == lastTxId)
+        BtcRawTransactionPtr txRaw = txRaws[i];
+        if(txRaw == NULL)
             continue;
-        lastTxId = (*txId);
 
-        // get transaction details
-        BtcRawTransactionPtr txRaw = GetDecodedRawTransaction((*txId));
         // iterate through raw transaction VOUT array
         for(std::vector<BtcRawTransaction::VOUT>::const_iterator vout = txRaw->outputs.begin(); vout != txRaw->outputs.end(); vout++)
         {
@@ -464,9 +575,16 @@ BtcUnspentOutputs BtcHelper::FindSignableOutputs(const BtcUnspentOutputs &output
 {
     BtcUnspentOutputs signableOutputs;
 
+    btc::stringList addresses;
     for(BtcUnspentOutputs::const_iterator output = outputs.begin(); output != outputs.end(); output++)
+        addresses.push_back((*output)->address);
+
+    std::vector<bool> isMine = IsMine(addresses);
+
+    BtcUnspentOutputs::const_iterator output = outputs.begin();
+    for(size_t i = 0; i < isMine.size(); i++, output++)
     {
-        if(IsMine((*output)->address))
+        if(isMine[i])
             signableOutputs.push_back((*output));
     }
 
@@ -476,9 +594,11 @@ BtcUnspentOutputs BtcHelper::FindSignableOutputs(const BtcUnspentOutputs &output
 BtcUnspentOutputs BtcHelper::FindUnspentOutputs(BtcUnspentOutputs possiblySpentOutputs)
 {
     BtcUnspentOutputs unspentOutputs;
-    for(BtcUnspentOutputs::iterator outputToCheck = possiblySpentOutputs.begin(); outputToCheck != possiblySpentOutputs.end(); outputToCheck++)
+
+    std::vector<BtcUnspentOutputPtr> outputs = this->modules->btcJson->GetTxOuts(possiblySpentOutputs);
+    for(size_t i = 0; i < outputs.size(); i++)
     {
-        BtcUnspentOutputPtr output = this->modules->btcJson->GetTxOut((*outputToCheck)->txId, (*outputToCheck)->vout);
+        BtcUnspentOutputPtr output = outputs[i];
         if(output != NULL)
         {
             std::printf ("found unspent output %s : %ld, %f BTC\n", output->txId.c_str(), output->vout, SatoshisToCoins(output->amount));
@@ -491,34 +611,57 @@ BtcUnspentOutputs BtcHelper::FindUnspentOutputs(BtcUnspentOutputs possiblySpentO
 
 BtcUnspentOutputs BtcHelper::FindUnspentOutputs(const btc::stringList &txIdsToCheck)
 {
-    BtcUnspentOutputs unspentOutputs;
-    std::string lastTxId = std::string();   // prevent double inserts
+    BtcUnspentOutputs outputsToCheck;
 
-    for(btc::stringList::const_iterator txId = txIdsToCheck.begin(); txId != txIdsToCheck.end(); txId++)
+    std::vector<BtcRawTransactionPtr> rawTxs = GetDecodedRawTransactions(UniqueTxIds(txIdsToCheck));
+    for(size_t i = 0; i < rawTxs.size(); i++)
     {
-        if((*txId) == lastTxId)
-            continue;
-        lastTxId = (*txId);
-
-        BtcRawTransactionPtr rawTx = GetDecodedRawTransaction((*txId));
+        BtcRawTransactionPtr rawTx = rawTxs[i];
         if(rawTx == NULL)
             continue;
 
         // iterate through raw transaction VOUT array
         for(std::vector<BtcRawTransaction::VOUT>::const_iterator vout = rawTx->outputs.begin(); vout != rawTx->outputs.end(); vout++)
         {
-            BtcUnspentOutputPtr output = this->modules->btcJson->GetTxOut(rawTx->txId, vout->n);
-            if(output == NULL)
-                continue;
-
-            if(!output->address.empty())
-                unspentOutputs.push_back(output);
+            BtcUnspentOutputPtr output = BtcUnspentOutputPtr(new BtcUnspentOutput(Json::Value()));
+            output->txId = rawTx->txId;
+            output->vout = vout->n;
+            outputsToCheck.push_back(output);
         }
     }
 
+    BtcUnspentOutputs unspentOutputs;
+
+    std::vector<BtcUnspentOutputPtr> outputs = this->modules->btcJson->GetTxOuts(outputsToCheck);
+    for(size_t i = 0; i < outputs.size(); i++)
+    {
+        if(outputs[i] == NULL)
+            continue;
+
+        if(!outputs[i]->address.empty())
+            unspentOutputs.push_back(outputs[i]);
+    }
+
     return unspentOutputs;
 }
 
+btc::stringList BtcHelper::UniqueTxIds(const btc::stringList &txIds)
+{
+    btc::stringList uniqueTxIds;
+    std::string lastTxId = std::string();   // prevent double inserts
+
+    for(btc::stringList::const_iterator txId = txIds.begin(); txId != txIds.end(); txId++)
+    {
+        if((*txId) == lastTxId)
+            continue;
+        lastTxId = (*txId);
+
+        uniqueTxIds.push_back((*txId));
+    }
+
+    return uniqueTxIds;
+}
+
 BtcUnspentOutputs BtcHelper::FindUnspentSignableOutputs(const btc::stringList &txIds)
 {
     BtcUnspentOutputs signableOutputs = FindSignableOutputs(txIds);
@@ -571,7 +714,8 @@ BtcSignedTransactionPtr BtcHelper::CreateSpendTransaction(const BtcUnspentOutput
     // set amount=0 to sweep all funds to change address
     if(amount > 0)
         targets.SetTarget(toAddress, amount);
-    if(change > 0)
+    // dust change would cost more to spend than it's worth, leave it to the miner
+    if(change > 0 && (change >= BtcCoinSelectionParams::DefaultDustLimit || amount <= 0))
         targets.SetTarget(changeAddress, change);
 
     BtcSignedTransactionPtr transactionPtr = BtcSignedTransactionPtr(new BtcSignedTransaction(Json::Value(Json::objectValue)));
@@ -580,6 +724,25 @@ BtcSignedTransactionPtr BtcHelper::CreateSpendTransaction(const BtcUnspentOutput
     return transactionPtr;
 }
 
+BtcSignedTransactionPtr BtcHelper::CreateSpendTransaction(BtcCoinSelectionPtr selection, const std::string &toAddress, const std::string &changeAddress)
+{
+    if(selection == NULL)
+        return BtcSignedTransactionPtr();
+
+    // the fee includes change too small for an output, so there's none left over here
+    return CreateSpendTransaction(selection->outputs, selection->amount, toAddress, changeAddress, selection->fee);
+}
+
+BtcCoinSelectionPtr BtcHelper::SelectOutputs(const BtcUnspentOutputs &outputs, const int64_t &amount, const BtcCoinSelectionParams &params)
+{
+    return this->coinSelector->Select(outputs, amount, params);
+}
+
+void BtcHelper::SetCoinSelector(BtcCoinSelectorPtr coinSelector)
+{
+    this->coinSelector = coinSelector;
+}
+
 BtcSignedTransactionPtr BtcHelper::WithdrawAllFromAddress(const std::string &txToSourceId, const std::string &sourceAddress, const std::string &destinationAddress, const int64_t fee, const std::string &redeemScript /* = "" */, const std::string &signingAddress /* = "" */)
 {
     // This function will check a txId for outputs leading to sourceAddress
@@ -6,6 +6,8 @@
 //#include <opentxs/MemoryWrapper.hpp>
 
 #include <bitcoin-api/btcobjects.hpp>
+#include <bitcoin-api/btcblockindex.hpp>
+#include <bitcoin-api/btccoinselection.hpp>
 
 #include _CINTTYPES
 #include _MEMORY
@@ -55,6 +57,9 @@ public:
     // to set default fee for all transactions, use BtcJson::SetTxFee()
     static int64_t FeeMultiSig;
 
+    // default number of blocks older than the block index to look through for a transaction
+    static int32_t BlockSearchDepth;
+
     BtcHelper(BtcModules* modules);
 
     ~BtcHelper();
@@ -68,6 +73,10 @@ public:
     // returns true if we own the address or any address making up a multisig
     bool IsMine(const std::string &address);
 
+    // same for a list of addresses, one entry per address
+    // at most two calls to bitcoind in total: one for the addresses, one for multisig members
+    std::vector<bool> IsMine(const btc::stringList &addresses);
+
     BtcBalancesPtr GetBalances();
 
     // Returns the public key of an address (addresses are just hashes)
@@ -81,13 +90,25 @@ public:
 
     BtcRawTransactionPtr GetDecodedRawTransaction(const std::string &txId) const;
 
+    // fetches all transactions in one batch, falls back to the wallet for those bitcoind can't find that way
+    // one entry per txId, NULL if it wasn't found at all
+    std::vector<BtcRawTransactionPtr> GetDecodedRawTransactions(const btc::stringList &txIds) const;
+
     // Counts how many coins are sent to targetAddress through this transaction
     int64_t GetTotalOutput(const std::string &txId, const std::string &targetAddress);
 
     // Counts how many coins are sent to targetAddress through this transaction
     int64_t GetTotalOutput(BtcRawTransactionPtr transaction, const std::string &targetAddress);
 
-    int32_t GetConfirmations(const std::string &txId);
+    // asks bitcoind, or looks it up in the block index if bitcoind's wallet doesn't know it.
+    // negative if bitcoind's wallet says it conflicts with (was double spent by) a confirmed transaction.
+    // transactions older than the index are searched for in at most maxSearchDepth more blocks,
+    // if it's not found there either 0 is returned and deeperThanSearched is set:
+    // it's older than that, or not in the chain at all.
+    int32_t GetConfirmations(const std::string &txId, const int32_t &maxSearchDepth = BlockSearchDepth, bool *deeperThanSearched = NULL);
+
+    // keeps the block index in this file, so it doesn't have to be fetched again after a restart
+    void SetBlockIndexFile(const std::string &path);
 
     // returns a list of double spends/conflicts
     btc::stringList GetDoubleSpends(const std::string &txId);
@@ -96,6 +117,8 @@ public:
     bool TransactionConfirmed(BtcTransactionPtr transaction, int32_t minconfirms = WaitForConfirms);
 
     // Checks whether a transaction (can be non-wallet) has been confirmed often enough
+    // conflicted and unknown transactions never are. one that's deeper than GetConfirmations() looks
+    // is, if bitcoind can find it (wallet or -txindex=1)
     int64_t TransactionConfirmed(const std::string &txId, const int32_t &minConfirms = WaitForConfirms);
 
     // Checks a transaction for correct amount and confirmations.
@@ -157,6 +180,16 @@ public:
     // signingKeys:             optional, only sign with those keys
     BtcSignedTransactionPtr CreateSpendTransaction(const BtcUnspentOutputs &outputs, const int64_t &amount, const std::string &toAddress, const std::string &changeAddress, const int64_t &fee = FeeMultiSig);
 
+    // Same for outputs picked by SelectOutputs(), with the fee and change it worked out
+    BtcSignedTransactionPtr CreateSpendTransaction(BtcCoinSelectionPtr selection, const std::string &toAddress, const std::string &changeAddress);
+
+    // Picks outputs to pay amount plus a fee estimated from the transaction's size, see btccoinselection.hpp
+    // returns NULL if they aren't enough
+    BtcCoinSelectionPtr SelectOutputs(const BtcUnspentOutputs &outputs, const int64_t &amount, const BtcCoinSelectionParams &params = BtcCoinSelectionParams());
+
+    // use other coin selection strategies than the default ones
+    void SetCoinSelector(BtcCoinSelectorPtr coinSelector);
+
     // Creates an unsigned raw transaction that sends all unspent outputs from an address to another
     // txSourceId: transaction that sends funds to sourceAddress
     // sourceAddress: address from which you want to withdraw
@@ -167,7 +200,14 @@ public:
 
 
 private:
+    // drops repeated txIds that follow each other, like the loops over txIds always did
+    static btc::stringList UniqueTxIds(const btc::stringList &txIds);
+
     BtcModules* modules;
+
+    BtcBlockIndexPtr blockIndex;
+
+    BtcCoinSelectorPtr coinSelector;
 };
 
 typedef _SharedPtr<BtcHelper> BtcHelperPtr;
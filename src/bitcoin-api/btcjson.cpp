@@ -6,6 +6,7 @@
 
 #include <json/json.h>
 
+#include <algorithm>
 #include <iostream>
 #include <map>
 #include <cstdio>
@@ -42,9 +43,11 @@ using namespace btc::json;
 #define METHOD_SIGNRAWTRANSACTION    "signrawtransaction"
 #define METHOD_SENDRAWTRANSACTION    "sendrawtransaction"
 #define METHOD_GETRAWMEMPOOL         "getrawmempool"
+#define METHOD_GETMEMPOOLINFO        "getmempoolinfo"
 #define METHOD_GETBLOCKCOUNT         "getblockcount"
 #define METHOD_GETBLOCKHASH          "getblockhash"
 #define METHOD_GETBLOCK              "getblock"
+#define METHOD_GETBESTBLOCKHASH      "getbestblockhash"
 #define METHOD_SETGENERATE           "setgenerate"
 #define METHOD_WALLETPASSPHRASE      "walletpassphrase"
 
@@ -115,6 +118,83 @@ BtcRpcPacketPtr BtcJson::CreateJsonQuery(const std::string &command, const Json:
     return BtcRpcPacketPtr(new BtcRpcPacket(writer.write(jsonObj)));
 }
 
+BtcRpcPacketPtr BtcJson::CreateJsonBatchQuery(const std::string &command, const std::vector<Json::Value> &paramsList)
+{
+    Json::Value batch = Json::Value(Json::arrayValue);
+    for(size_t i = 0; i < paramsList.size(); i++)
+    {
+        Json::Value jsonObj = Json::Value();
+        jsonObj["jsonrpc"] = 1.0;
+        jsonObj["id"] = static_cast<Json::UInt>(i);
+        jsonObj["method"] = command;
+        jsonObj["params"] = paramsList[i];
+        batch.append(jsonObj);
+    }
+
+    Json::FastWriter writer;
+    return BtcRpcPacketPtr(new BtcRpcPacket(writer.write(batch)));
+}
+
+bool BtcJson::SendJsonBatchQuery(const std::string &command, const std::vector<Json::Value> &paramsList, std::vector<Json::Value> &results, size_t *failedCount)
+{
+    results.assign(paramsList.size(), Json::Value());
+    if(failedCount != NULL)
+        *failedCount = paramsList.size();
+
+    if(paramsList.empty())
+        return true;
+
+    BtcRpcPacketPtr reply = this->modules->btcRpc->SendRpc(CreateJsonBatchQuery(command, paramsList));
+    if(reply == NULL || reply->GetData() == NULL || reply->size() <= 0)
+        return false;
+
+    Json::Value replyObj;
+    Json::Reader reader;
+    if(!reader.parse(reply->GetData(), reply->GetData() + reply->size(), replyObj))
+        return false;
+
+    // bitcoind answers a batch it can't handle at all with a single error object
+    if(!replyObj.isArray())
+    {
+        std::printf("Error in reply to %s batch: %s\n\n", command.c_str(),
+                    replyObj.isObject() && replyObj["error"].isObject() ? replyObj["error"]["message"].asString().c_str() : "");
+        std::cout.flush();
+        return false;
+    }
+
+    std::printf("Received JSON batch: %u replies to %s\n", replyObj.size(), command.c_str());
+    std::cout.flush();
+
+    // replies can come back in any order
+    std::vector<bool> answered(results.size(), false);
+    for(Json::Value::ArrayIndex i = 0; i < replyObj.size(); i++)
+    {
+        const Json::Value &replyItem = replyObj[i];
+        if(!replyItem.isObject() || !replyItem["id"].isIntegral())
+            continue;
+
+        const Json::UInt id = replyItem["id"].asUInt();
+        if(id >= results.size())
+            continue;
+
+        const Json::Value &error = replyItem["error"];
+        if(!error.isNull())
+        {
+            std::printf("Error in reply to \"%s\" #%u: %s\n\n", command.c_str(), id, error.isObject() ? (error["message"]).asString().c_str() : "");
+            std::cout.flush();
+            continue;
+        }
+
+        results[id] = replyItem["result"];
+        answered[id] = true;
+    }
+
+    if(failedCount != NULL)
+        *failedCount = static_cast<size_t>(std::count(answered.begin(), answered.end(), false));
+
+    return true;
+}
+
 bool BtcJson::ProcessRpcString(BtcRpcPacketPtr jsonString, Json::Value &result)
 {
     std::string id;
@@ -299,6 +379,31 @@ BtcAddressInfoPtr BtcJson::ValidateAddress(const std::string &address)
     return addressInfo;
 }
 
+std::vector<BtcAddressInfoPtr> BtcJson::ValidateAddresses(const btc::stringList &addresses)
+{
+    std::vector<Json::Value> paramsList;
+    for(btc::stringList::const_iterator address = addresses.begin(); address != addresses.end(); address++)
+    {
+        Json::Value params = Json::Value();
+        params.append((*address));
+        paramsList.push_back(params);
+    }
+
+    std::vector<BtcAddressInfoPtr> addressInfos(addresses.size());
+
+    std::vector<Json::Value> results;
+    if(!SendJsonBatchQuery(METHOD_VALIDATEADDRESS, paramsList, results))
+        return addressInfos;
+
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        if(results[i].isObject())
+            addressInfos[i] = BtcAddressInfoPtr(new BtcAddressInfo(results[i]));
+    }
+
+    return addressInfos;
+}
+
 std::string BtcJson::GetPublicKey(const std::string &address)
 {
     BtcAddressInfoPtr addrInfo = ValidateAddress(address);
@@ -443,8 +548,11 @@ BtcTransactions BtcJson::ListTransactions(const std::string &account, const int3
     return transactions;
 }
 
-BtcUnspentOutputs BtcJson::ListUnspent(const int32_t &minConf, const int32_t &maxConf, const btc::stringList &addresses)
+BtcUnspentOutputs BtcJson::ListUnspent(const int32_t &minConf, const int32_t &maxConf, const btc::stringList &addresses, bool *ok)
 {
+    if(ok != NULL)
+        *ok = false;
+
     Json::Value params = Json::Value();
     params.append(minConf);
     params.append(maxConf);
@@ -471,6 +579,9 @@ BtcUnspentOutputs BtcJson::ListUnspent(const int32_t &minConf, const int32_t &ma
         outputs.push_back(BtcUnspentOutputPtr(new BtcUnspentOutput(result[i])));
     }
 
+    if(ok != NULL)
+        *ok = true;
+
     return outputs;
 }
 
@@ -551,6 +662,43 @@ BtcUnspentOutputPtr BtcJson::GetTxOut(const std::string &txId, const int64_t &vo
     return transaction;
 }
 
+std::vector<BtcUnspentOutputPtr> BtcJson::GetTxOuts(const BtcUnspentOutputs &outputs, bool *ok)
+{
+    std::vector<Json::Value> paramsList;
+    for(BtcUnspentOutputs::const_iterator output = outputs.begin(); output != outputs.end(); output++)
+    {
+        Json::Value params = Json::Value();
+        params.append((*output)->txId);
+        params.append(static_cast<Json::Int64>((*output)->vout));
+        paramsList.push_back(params);
+    }
+
+    std::vector<BtcUnspentOutputPtr> unspentOutputs(outputs.size());
+
+    // a call that failed leaves a NULL just like a spent output, the caller has to know the difference
+    std::vector<Json::Value> results;
+    size_t failedCount = 0;
+    bool batchSent = SendJsonBatchQuery(METHOD_GETTXOUT, paramsList, results, &failedCount);
+    if(ok != NULL)
+        *ok = batchSent && failedCount == 0;
+    if(!batchSent)
+        return unspentOutputs;
+
+    BtcUnspentOutputs::const_iterator output = outputs.begin();
+    for(size_t i = 0; i < results.size(); i++, output++)
+    {
+        // spent outputs come back as null
+        if(!results[i].isObject() || results[i].empty())
+            continue;
+
+        unspentOutputs[i] = BtcUnspentOutputPtr(new BtcUnspentOutput(results[i]));
+        unspentOutputs[i]->txId = (*output)->txId;
+        unspentOutputs[i]->vout = (*output)->vout;
+    }
+
+    return unspentOutputs;
+}
+
 BtcTransactionPtr BtcJson::GetTransaction(const std::string &txId, const bool &includeWatchonly)
 {
     Json::Value params = Json::Value();
@@ -608,6 +756,32 @@ BtcRawTransactionPtr BtcJson::GetDecodedRawTransaction(const std::string &txId)
 
 }
 
+std::vector<BtcRawTransactionPtr> BtcJson::GetDecodedRawTransactions(const btc::stringList &txIds)
+{
+    std::vector<Json::Value> paramsList;
+    for(btc::stringList::const_iterator txId = txIds.begin(); txId != txIds.end(); txId++)
+    {
+        Json::Value params = Json::Value();
+        params.append((*txId));
+        params.append(1);
+        paramsList.push_back(params);
+    }
+
+    std::vector<BtcRawTransactionPtr> decodedRawTransactions(txIds.size());
+
+    std::vector<Json::Value> results;
+    if(!SendJsonBatchQuery(METHOD_GETRAWTRANSACTION, paramsList, results))
+        return decodedRawTransactions;
+
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        if(results[i].isObject())
+            decodedRawTransactions[i] = BtcRawTransactionPtr(new BtcRawTransaction(results[i]));
+    }
+
+    return decodedRawTransactions;
+}
+
 BtcRawTransactionPtr BtcJson::DecodeRawTransaction(const std::string &rawTransaction)
 {
     Json::Value params = Json::Value();
@@ -748,6 +922,20 @@ btc::stringList BtcJson::GetRawMemPool()
     return rawMemPool;
 }
 
+BtcMemPoolInfoPtr BtcJson::GetMemPoolInfo()
+{
+    Json::Value result = Json::Value();
+    if(!ProcessRpcString(
+                this->modules->btcRpc->SendRpc(
+                    CreateJsonQuery(METHOD_GETMEMPOOLINFO, Json::Value())), result))
+        return BtcMemPoolInfoPtr();
+
+    if(!result.isObject())
+        return BtcMemPoolInfoPtr();
+
+    return BtcMemPoolInfoPtr(new BtcMemPoolInfo(result));
+}
+
 int BtcJson::GetBlockCount()
 {
     Json::Value result = Json::Value();
@@ -773,6 +961,17 @@ std::string BtcJson::GetBlockHash(const int32_t &blockNumber)
     return result.asString();
 }
 
+std::string BtcJson::GetBestBlockHash()
+{
+    Json::Value result = Json::Value();
+    if(!ProcessRpcString(
+                this->modules->btcRpc->SendRpc(
+                    CreateJsonQuery(METHOD_GETBESTBLOCKHASH, Json::Value())), result))
+        return std::string();
+
+    return result.asString();
+}
+
 BtcBlockPtr BtcJson::GetBlock(const std::string &blockHash)
 {
     Json::Value params = Json::Value();
@@ -75,6 +75,9 @@ public:
     // Validate an address
     virtual BtcAddressInfoPtr ValidateAddress(const std::string &address);
 
+    // Validate addresses, batched
+    virtual std::vector<BtcAddressInfoPtr> ValidateAddresses(const btc::stringList &addresses);
+
     virtual std::string GetPublicKey(const std::string& address);
 
     // Get private key for address (calls DumpPrivKey())
@@ -111,7 +114,7 @@ public:
     // account: "*" for all accounts, "" for default account, "<whatever> for <whatever>
     virtual BtcTransactions ListTransactions(const std::string &account = "*", const int32_t &count = 20, const int32_t &from = 0, const bool &includeWatchonly = true);
 
-    virtual BtcUnspentOutputs ListUnspent(const int32_t &minConf = BtcHelper::MinConfirms, const int32_t &maxConf = BtcHelper::MaxConfirms, const btc::stringList &addresses = btc::stringList());
+    virtual BtcUnspentOutputs ListUnspent(const int32_t &minConf = BtcHelper::MinConfirms, const int32_t &maxConf = BtcHelper::MaxConfirms, const btc::stringList &addresses = btc::stringList(), bool *ok = NULL);
 
     virtual std::string SendToAddress(const std::string &btcAddress, const int64_t &amount);
 
@@ -123,12 +126,16 @@ public:
 
     BtcUnspentOutputPtr GetTxOut(const std::string &txId, const int64_t &vout);
 
+    virtual std::vector<BtcUnspentOutputPtr> GetTxOuts(const BtcUnspentOutputs &outputs, bool *ok = NULL);
+
     virtual BtcTransactionPtr GetTransaction(const std::string &txId, const bool& includeWatchonly = true);
 
     virtual std::string GetRawTransaction(const std::string &txId);
 
     virtual BtcRawTransactionPtr GetDecodedRawTransaction(const std::string &txId);
 
+    virtual std::vector<BtcRawTransactionPtr> GetDecodedRawTransactions(const btc::stringList &txIds);
+
     virtual BtcRawTransactionPtr DecodeRawTransaction(const std::string &rawTransaction);
 
     virtual std::string CreateRawTransaction(BtcTxIdVouts unspentOutputs, BtcTxTargets txTargets);
@@ -151,10 +158,15 @@ public:
     // returns txIds
     virtual btc::stringList GetRawMemPool();
 
+    // size of the mempool, cheap way to see if it changed
+    virtual BtcMemPoolInfoPtr GetMemPoolInfo();
+
     virtual int GetBlockCount();
 
     virtual std::string GetBlockHash(const int32_t &blockNumber);
 
+    virtual std::string GetBestBlockHash();
+
     virtual BtcBlockPtr GetBlock(const std::string &blockHash);
 
     virtual bool SetGenerate(const bool &generate);
@@ -164,6 +176,16 @@ public:
 protected:
     virtual BtcRpcPacketPtr CreateJsonQuery(const std::string &command, const Json::Value &params = Json::Value(), std::string id = std::string());
 
+    // Creates a json-rpc batch: an array with one call to command per entry in paramsList.
+    // The calls' ids are their index in paramsList.
+    virtual BtcRpcPacketPtr CreateJsonBatchQuery(const std::string &command, const std::vector<Json::Value> &paramsList);
+
+    // Sends all calls in one batch and sorts the replies by id.
+    // results gets one entry per entry in paramsList, a null value where that call failed.
+    // failedCount, if given, is set to the number of calls that returned an error or no reply at all.
+    // Returns false if the batch as a whole failed.
+    virtual bool SendJsonBatchQuery(const std::string &command, const std::vector<Json::Value> &paramsList, std::vector<Json::Value> &results, size_t *failedCount = NULL);
+
     // sends a query and processes errors. useless now but maybe not in the future.
     virtual bool SendJsonQuery(BtcRpcPacketPtr jsonString, Json::Value &result);
 
@@ -10,6 +10,8 @@
 
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
+#include <algorithm>
 
 
 BtcInfo::BtcInfo(Json::Value result)
@@ -287,6 +289,12 @@ BtcBlock::BtcBlock(Json::Value block)
     }
 }
 
+BtcMemPoolInfo::BtcMemPoolInfo(Json::Value result)
+{
+    this->size = result["size"].asInt64();
+    this->bytes = result["bytes"].asInt64();
+}
+
 BtcTxIdVout::BtcTxIdVout(const std::string &txID, const int64_t &vout)
 {
     (*this)["txid"] = txID;
@@ -351,14 +359,14 @@ BtcRpcPacket::BtcRpcPacket()
 BtcRpcPacket::BtcRpcPacket(const std::string &strData)
     :data(strData.begin(), strData.end()), pointerOffset(0)
 {
-    if(*(data.end()-1) != '\0')
+    if(this->data.empty() || this->data.back() != '\0')
         this->data.push_back('\0');
 }
 
 BtcRpcPacket::BtcRpcPacket(const BtcRpcPacketPtr packet)
     : data(packet->data.begin(), packet->data.end()), pointerOffset(0)
 {
-    if(*(data.end()-1) != '\0')
+    if(this->data.empty() || this->data.back() != '\0')
         this->data.push_back('\0');
 }
 
@@ -380,15 +388,26 @@ void BtcRpcPacket::ResetOffset()
     this->pointerOffset = 0;
 }
 
-bool BtcRpcPacket::AddData(const std::string strData)
+void BtcRpcPacket::Reserve(size_t bytes)
 {
-    // cut off the trailing '\0' as otherwise multipart messages won't work:
-    std::string data(this->data.begin(), this->data.end() - 1);
-    data.append(strData.begin(), strData.end());
-    this->data.clear();
-    this->data = std::vector<char>(data.begin(), data.end());
-    if(*(data.end()-1) != '\0')
-        this->data.push_back('\0');
+    this->data.reserve(bytes + 1);
+}
+
+bool BtcRpcPacket::AddData(const std::string &strData)
+{
+    return AddData(strData.data(), strData.size());
+}
+
+bool BtcRpcPacket::AddData(const char *buffer, size_t length)
+{
+    if(length == 0)
+        return true;
+
+    if(buffer == NULL)
+        return false;
+
+    // goes in front of the trailing '\0', the vector grows geometrically so appending is amortized O(length)
+    this->data.insert(this->data.end() - 1, buffer, buffer + length);
 
     return true;
 }
@@ -400,6 +419,19 @@ const char *BtcRpcPacket::ReadNextChar()
     else return NULL;
 }
 
+size_t BtcRpcPacket::ReadData(char *buffer, size_t maxLength)
+{
+    if (buffer == NULL || this->pointerOffset >= size())
+        return 0;
+
+    const size_t length = std::min(maxLength, size() - this->pointerOffset);
+
+    memcpy(buffer, &this->data[this->pointerOffset], length);
+    this->pointerOffset += length;
+
+    return length;
+}
+
 size_t BtcRpcPacket::size()
 {
     return this->data.size()-1;
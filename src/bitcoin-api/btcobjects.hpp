@@ -247,6 +247,15 @@ struct BtcBlock
     BtcBlock(Json::Value block);
 };
 
+// result of getmempoolinfo
+struct BtcMemPoolInfo
+{
+    int64_t size;       // number of transactions
+    int64_t bytes;      // their total size
+
+    BtcMemPoolInfo(Json::Value result);
+};
+
 // a json object containing txid and vout
 // used in CreateRawTransaction
 struct BtcTxIdVout : Json::Value
@@ -286,6 +295,9 @@ struct BtcSigningPrerequisite : Json::Value
     BtcSigningPrerequisite(const std::string &txId, const int64_t &vout, const std::string &scriptPubKey, const std::string &redeemScript);
 };
 
+// An append-only byte buffer for one http body, sent or received.
+// The data is always followed by a '\0' so GetData() can be parsed as a string,
+// size() doesn't count it.
 struct BtcRpcPacket
 {
     BtcRpcPacket();
@@ -299,12 +311,20 @@ struct BtcRpcPacket
 
     void ResetOffset();
 
+    // makes room for this many bytes in total, e.g. from the Content-Length header
+    void Reserve(size_t bytes);
+
     // appends data to data
-    bool AddData(const std::string strData);
+    bool AddData(const std::string &strData);
+    bool AddData(const char* buffer, size_t length);
 
     // returns char and offsets the data pointer (makes no sense, will fix sometime)
     const char* ReadNextChar();
 
+    // copies up to maxLength unread bytes to buffer and offsets the data pointer
+    // returns the number of bytes copied, 0 once everything has been read
+    size_t ReadData(char* buffer, size_t maxLength);
+
     const char* GetData();
 
     size_t size();
@@ -327,6 +347,7 @@ typedef _SharedPtr<BtcAddressBalance>      BtcAddressBalancePtr;
 typedef _SharedPtr<BtcAddressInfo>         BtcAddressInfoPtr;
 typedef _SharedPtr<BtcMultiSigAddress>     BtcMultiSigAddressPtr;
 typedef _SharedPtr<BtcBlock>               BtcBlockPtr;
+typedef _SharedPtr<BtcMemPoolInfo>         BtcMemPoolInfoPtr;
 typedef _SharedPtr<BtcTxIdVout>            BtcTxIdVoutPtr;
 typedef _SharedPtr<BtcTxTargets>           BtcTxTargetPtr;
 typedef _SharedPtr<BtcSignedTransaction>   BtcSignedTransactionPtr;
@@ -4,11 +4,22 @@
 
 #include <bitcoin-api/btcrpccurl.hpp>
 
+#include <bitcoin-api/btchelper.hpp>
+
 #include <curl/curl.h>
 
 #include <iostream>
 #include <string.h>
 #include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
+
+// largest Content-Length we'll allocate for before any of the reply has arrived
+#define MAX_RESERVE_BYTES (256 * 1024 * 1024)
+
+// how many calls can be talking to one bitcoind at once, unless SetMaxConnections() says otherwise
+#define DEFAULT_MAX_CONNECTIONS 4
 
 BtcRpcPacketPtr BtcRpcCurl::connectString = BtcRpcPacketPtr(new BtcRpcPacket("{\"jsonrpc\": \"1.0\", \"id\":\"curltest\", \"method\": \"getinfo\", \"params\": [] }"));
 
@@ -16,34 +27,31 @@ BtcRpcCurl::BtcRpcCurl(BtcModules *modules)
 {
     this->modules = modules;
 
-    this->curl = NULL;
-
     /* In windows, this will init the winsock stuff */
-    this->res = curl_global_init(CURL_GLOBAL_DEFAULT);
+    this->globalInit = curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    if(this->globalInit != CURLE_OK)
+    {
+        fprintf(stderr, "curl_global_init() failed: %s\n",
+                curl_easy_strerror(this->globalInit));
+    }
 
     this->currentServer = BitcoinServerPtr();
 
-    this->mutex = false;
+    this->maxConnections = DEFAULT_MAX_CONNECTIONS;
 }
 
 BtcRpcCurl::~BtcRpcCurl()
 {
     this->modules = NULL;
 
-    this->currentServer = BitcoinServerPtr();
-
     this->CleanUpCurl();
-}
 
-void BtcRpcCurl::WaitMutex()
-{
-    while (this->mutex)
-    {
-        btc::Sleep(5);
-    }
-    this->mutex = true;
+    if(this->globalInit == CURLE_OK)
+        curl_global_cleanup();
 }
 
+// curl asks for up to size*nmemb bytes of the request body at a time
 static size_t read_callback(void *ptr, size_t size, size_t nmemb, void *userp)
 {
     BtcRpcPacket *pooh = (BtcRpcPacket *)userp;
@@ -51,41 +59,20 @@ static size_t read_callback(void *ptr, size_t size, size_t nmemb, void *userp)
     if(size*nmemb < 1)
         return 0;
 
-    const char* dataPtr = pooh->ReadNextChar();  
-
-    if(dataPtr == NULL)
-        return 0;
-
-    *(char *)ptr = dataPtr[0];
-    return 1;
-
-    //if(pooh->size)
-    //{
-    //    *(char *)ptr = pooh->data[0];       /* copy one single byte */
-    //    pooh->data++;                       /* advance pointer */
-    //    pooh->pointerOffset++;              // offset pointer so correct memory is freed
-    //    pooh->size--;                       /* less data left */
-
-    //    return 1;                        /* we return 1 byte at a time! */
-    //}
-
-    //return 0;                          /* no more data left to deliver */
+    return pooh->ReadData(static_cast<char*>(ptr), size * nmemb);
 }
 
+// curl hands over the reply body a chunk at a time, it's appended as is
 static size_t write_callback(void *ptr, size_t size, size_t nmemb, void *userp)
 {
     BtcRpcPacket *pooh = (BtcRpcPacket *)userp;
 
-    int newSize = size * nmemb;
+    size_t newSize = size * nmemb;
 
     if(size < 1)
         return 0;
 
-    const char *charBuf = static_cast<const char*>(ptr);
-    std::vector<char> data(charBuf, charBuf + newSize);
-    std::string strData(data.begin(), data.end());
-
-    if (pooh->AddData(strData))
+    if (pooh->AddData(static_cast<const char*>(ptr), newSize))
     {
         return newSize;
     }
@@ -93,83 +80,182 @@ static size_t write_callback(void *ptr, size_t size, size_t nmemb, void *userp)
     {
         return 0;
     }
+}
 
-    //int newLength = pooh->size + size * nmemb;
+// we only look at Content-Length, so the reply buffer can be allocated once up front
+static size_t header_callback(char *buffer, size_t size, size_t nitems, void *userp)
+{
+    BtcRpcPacket *pooh = (BtcRpcPacket *)userp;
+
+    const size_t length = size * nitems;
+    static const char contentLength[] = "content-length:";
+    static const size_t contentLengthSize = sizeof(contentLength) - 1;
 
-    //if(pooh->data == NULL)
-    //    pooh->data = (char*)realloc(pooh->data, newLength + 1);
+    if(length <= contentLengthSize)
+        return length;
+
+    for(size_t i = 0; i < contentLengthSize; i++)
+    {
+        if(tolower(static_cast<unsigned char>(buffer[i])) != contentLength[i])
+            return length;
+    }
 
-    //if(pooh->data == NULL)
-    //{
-    //    std::printf("realloc failed when reading data from bitcoin-qt\n");
-    //    std::cout.flush();
-    //    return 0;
-    //}
+    std::string value(buffer + contentLengthSize, length - contentLengthSize);
+    unsigned long long bytes = strtoull(value.c_str(), NULL, 10);
 
-    //memcpy(pooh->data + pooh->size, ptr, size * nmemb);
-    //pooh->data[newLength] = '\0';
-    //pooh->size = newLength;
+    // don't trust it further than this, a bigger reply still works but grows as it arrives
+    if(bytes > 0 && bytes <= MAX_RESERVE_BYTES)
+        pooh->Reserve(static_cast<size_t>(bytes));
 
-    //return size * nmemb;
+    return length;
 }
 
 bool BtcRpcCurl::ConnectToBitcoin(BitcoinServerPtr server)
 {
-    WaitMutex();
-
-    if(server == NULL)
     {
+        std::lock_guard<std::mutex> lock(this->poolMutex);
         this->currentServer = server;
-        CleanUpCurl();
-        mutex = false;
+    }
+
+    if(server == NULL)
         return false;
+
+    if(SendRpc(BtcRpcPacketPtr(new BtcRpcPacket(connectString))) != NULL)
+        return true;
+
+    // don't keep handles around for a server we can't talk to
+    ClosePool(server);
+    return false;
+}
+
+bool BtcRpcCurl::ConnectToBitcoin(const std::string &user, const std::string &password, const std::string &url, int32_t port)
+{
+    return ConnectToBitcoin(BitcoinServerPtr(new BitcoinServer(user, password, url, port)));
+}
+
+void BtcRpcCurl::SetMaxConnections(size_t connections)
+{
+    std::lock_guard<std::mutex> lock(this->poolMutex);
+
+    this->maxConnections = std::max(connections, size_t(1));
+
+    // pools that are already open get the new limit too
+    for(std::map<std::string, CurlPoolPtr>::iterator it = this->pools.begin(); it != this->pools.end(); it++)
+        it->second->maxHandles = this->maxConnections;
+
+    this->handleReturned.notify_all();
+}
+
+size_t BtcRpcCurl::GetMaxConnections()
+{
+    std::lock_guard<std::mutex> lock(this->poolMutex);
+
+    return this->maxConnections;
+}
+
+std::string BtcRpcCurl::PoolKey(BitcoinServerPtr server)
+{
+    return server->user + '\n' + server->password + '\n' + server->url + ':' + btc::to_string(server->port);
+}
+
+CURL* BtcRpcCurl::CheckOutHandle(BitcoinServerPtr server, CurlPoolPtr &pool)
+{
+    std::unique_lock<std::mutex> lock(this->poolMutex);
+
+    const std::string key = PoolKey(server);
+
+    std::map<std::string, CurlPoolPtr>::iterator it = this->pools.find(key);
+    if(it == this->pools.end())
+    {
+        pool = CurlPoolPtr(new CurlPool());
+        pool->handlesOut = 0;
+        pool->maxHandles = this->maxConnections;
+        pool->closed = false;
+        this->pools[key] = pool;
     }
+    else
+        pool = it->second;
 
-    if(this->currentServer != server || !this->curl || this->res != CURLE_OK)
+    // wait for a handle to come back if all of them are in use
+    while(pool->idleHandles.empty() && pool->handlesOut >= pool->maxHandles)
+        this->handleReturned.wait(lock);
+
+    CURL* handle = NULL;
+
+    if(!pool->idleHandles.empty())
     {
-        this->currentServer = server;
-        CleanUpCurl();
-
-        /* In windows, this will init the winsock stuff */
-        this->res = curl_global_init(CURL_GLOBAL_DEFAULT);
-
-        /* Check for errors */
-        if(res != CURLE_OK)
-        {
-          fprintf(stderr, "curl_global_init() failed: %s\n",
-                  curl_easy_strerror(res));
-          mutex = false;
-          return false;
-        }
-
-        /* get a curl handle */
-        curl = curl_easy_init();
-
-        if(!curl)
-        {
-            mutex = false;
-            return false;
-        }
+        handle = pool->idleHandles.back();
+        pool->idleHandles.pop_back();
     }
+    else
+    {
+        handle = curl_easy_init();
+
+        if(handle == NULL)
+            return NULL;
 
-    /* First set the URL that is about to receive our POST. */
-    curl_easy_setopt(curl, CURLOPT_URL, server->url.c_str());
+        /* First set the URL that is about to receive our POST. */
+        curl_easy_setopt(handle, CURLOPT_URL, server->url.c_str());
+        curl_easy_setopt(handle, CURLOPT_PORT, server->port);
+        curl_easy_setopt(handle, CURLOPT_PASSWORD, server->password.c_str());
+        curl_easy_setopt(handle, CURLOPT_USERNAME, server->user.c_str());
+        curl_easy_setopt(handle, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
 
-    curl_easy_setopt(curl, CURLOPT_PORT, server->port);
+        /* Now specify we want to POST data */
+        curl_easy_setopt(handle, CURLOPT_POST, 1L);
 
-    curl_easy_setopt(curl, CURLOPT_PASSWORD, server->password.c_str());
+        /* we want to use our own read function (called when sending) */
+        curl_easy_setopt(handle, CURLOPT_READFUNCTION, read_callback);
+        /* we want to use our own write function (called when receiving) */
+        curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, write_callback);
+        /* reserve the reply buffer from the Content-Length header */
+        curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, header_callback);
 
-    curl_easy_setopt(curl, CURLOPT_USERNAME, server->user.c_str());
+        /* get verbose debug output please */
+        curl_easy_setopt(handle, CURLOPT_VERBOSE, 0L);
 
-    curl_easy_setopt(curl, CURLOPT_HTTPAUTH, CURLAUTH_BASIC);
+        /* several threads use curl at once, so no signals (timeouts use them otherwise) */
+        curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
 
-    mutex = false;
-    return SendRpc(BtcRpcPacketPtr(new BtcRpcPacket(connectString))) != NULL;
+        /* keep the connection to bitcoind open between calls */
+        curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+    }
+
+    pool->handlesOut++;
+    return handle;
 }
 
-bool BtcRpcCurl::ConnectToBitcoin(const std::string &user, const std::string &password, const std::string &url, int32_t port)
+void BtcRpcCurl::ReturnHandle(CurlPoolPtr pool, CURL *handle, bool reusable)
 {
-    return ConnectToBitcoin(BitcoinServerPtr(new BitcoinServer(user, password, url, port)));
+    std::lock_guard<std::mutex> lock(this->poolMutex);
+
+    pool->handlesOut--;
+
+    if(reusable && !pool->closed)
+        pool->idleHandles.push_back(handle);
+    else
+        curl_easy_cleanup(handle);
+
+    this->handleReturned.notify_all();
+}
+
+void BtcRpcCurl::ClosePool(BitcoinServerPtr server)
+{
+    std::lock_guard<std::mutex> lock(this->poolMutex);
+
+    std::map<std::string, CurlPoolPtr>::iterator it = this->pools.find(PoolKey(server));
+    if(it == this->pools.end())
+        return;
+
+    // handles that are checked out right now get cleaned up when they come back
+    it->second->closed = true;
+
+    for(size_t i = 0; i < it->second->idleHandles.size(); i++)
+        curl_easy_cleanup(it->second->idleHandles[i]);
+    it->second->idleHandles.clear();
+
+    this->pools.erase(it);
+    this->handleReturned.notify_all();
 }
 
 BtcRpcPacketPtr BtcRpcCurl::SendRpc(const std::string &jsonString)
@@ -179,30 +265,37 @@ BtcRpcPacketPtr BtcRpcCurl::SendRpc(const std::string &jsonString)
 
 BtcRpcPacketPtr BtcRpcCurl::SendRpc(BtcRpcPacketPtr jsonString)
 {
+    BitcoinServerPtr server;
+    {
+        std::lock_guard<std::mutex> lock(this->poolMutex);
+        server = this->currentServer;
+    }
+
+    if(server == NULL || jsonString == NULL)
+    {
+        return BtcRpcPacketPtr();
+    }
+
+    CurlPoolPtr pool;
+    CURL* curl = CheckOutHandle(server, pool);
+
     if(!curl)
     {
         return BtcRpcPacketPtr();
     }
 
-    WaitMutex();
+    jsonString->ResetOffset();  // in case this packet was sent before
 
     BtcRpcPacketPtr receivedData = BtcRpcPacketPtr(new BtcRpcPacket()); // used when receiving data
 
-    /* Now specify we want to POST data */
-    curl_easy_setopt(curl, CURLOPT_POST, 1L);
-
-    /* we want to use our own read function (called when sending) */
-    curl_easy_setopt(curl, CURLOPT_READFUNCTION, read_callback);
     /* pointer to pass to our read function (cointains data to send) */
     curl_easy_setopt(curl, CURLOPT_READDATA, jsonString.get());
 
-    /* we want to use our own write function (called when receiving) */
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
     /* pointer to pass to our write function (we'll write received data into it) */
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, receivedData.get());
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, receivedData.get());
 
-    /* get verbose debug output please */
-    curl_easy_setopt(curl, CURLOPT_VERBOSE, 0L);
+    struct curl_slist *chunk = NULL;
 
     /*
         If you use POST to a HTTP 1.1 server, you can send data without knowing
@@ -212,14 +305,7 @@ BtcRpcPacketPtr BtcRpcCurl::SendRpc(BtcRpcPacketPtr jsonString)
         specify the size in the request.
     */
     #ifdef USE_CHUNKED
-    {
-        struct curl_slist *chunk = NULL;
-
         chunk = curl_slist_append(chunk, "Transfer-Encoding: chunked");
-        res = curl_easy_setopt(curl, CURLOPT_HTTPHEADER, chunk);
-        /* use curl_slist_free_all() after the *perform() call to free this
-            list again */
-    }
     #else
         /* Set the expected POST size. If you want to POST large amounts of data,
             consider CURLOPT_POSTFIELDSIZE_LARGE */
@@ -227,7 +313,6 @@ BtcRpcPacketPtr BtcRpcCurl::SendRpc(BtcRpcPacketPtr jsonString)
     #endif
 
     #ifdef DISABLE_EXPECT
-    {
         /*
             Using POST with HTTP 1.1 implies the use of a "Expect: 100-continue"
             header.  You can disable this header with CURLOPT_HTTPHEADER as usual.
@@ -236,42 +321,40 @@ BtcRpcPacketPtr BtcRpcCurl::SendRpc(BtcRpcPacketPtr jsonString)
 
         /* A less good option would be to enforce HTTP 1.0, but that might also
             have other implications. */
-        struct curl_slist *chunk = NULL;
-
         chunk = curl_slist_append(chunk, "Expect:");
-        res = curl_easy_setopt(curl, CURLOPT_HTTPHEADER, chunk);
-        /* use curl_slist_free_all() after the *perform() call to free this
-            list again */
-    }
     #endif
 
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, chunk);
+
     /* Perform the request, res will get the return code */
-    res = curl_easy_perform(curl);
+    CURLcode res = curl_easy_perform(curl);
+
+    /* the handle is reused, so it mustn't keep pointing at this call's headers and packets */
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, NULL);
+    curl_slist_free_all(chunk);
+    curl_easy_setopt(curl, CURLOPT_READDATA, NULL);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, NULL);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, NULL);
+
     /* Check for errors */
     if(res != CURLE_OK)
     {
         fprintf(stderr, "curl_easy_perform() failed: %s\n",
             curl_easy_strerror(res));
 
-        mutex = false;
+        ReturnHandle(pool, curl, false);
         return BtcRpcPacketPtr();
     }
 
-    //if(receivedData->data != NULL)
-    //    opentxs::Log::Output(0, receivedData->data);
+    long httpcode = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpcode);
 
-    // we have to copy the response because for some reason the next few lines set the smart pointer to NULL (?!?!??)
-    BtcRpcPacketPtr packetCopy = BtcRpcPacketPtr(new BtcRpcPacket(receivedData));
+    ReturnHandle(pool, curl, true);
 
-    receivedData.reset();
-
-    int httpcode = 0;
-    curl_easy_getinfo(this->curl, CURLINFO_RESPONSE_CODE, &httpcode);
     if (httpcode == 401)
     {
         std::printf("Error connecting to bitcoind: Wrong username or password\n");
         std::cout.flush();
-        mutex = false;
         return BtcRpcPacketPtr();
     }
     else if (httpcode == 500)
@@ -282,14 +365,12 @@ BtcRpcPacketPtr BtcRpcCurl::SendRpc(BtcRpcPacketPtr jsonString)
     }
     else if (httpcode != 200)
     {
-        std::printf("BtcRpc curl error:\nHTTP response code %d\n", httpcode);
+        std::printf("BtcRpc curl error:\nHTTP response code %ld\n", httpcode);
         std::cout.flush();
-        mutex = false;
         return BtcRpcPacketPtr();
     }
 
-    mutex = false;
-    return packetCopy;
+    return receivedData;
 }
 
 BtcRpcPacketPtr BtcRpcCurl::SendRpc(const char *jsonString) // TODO: also receive int size then call overloaded
@@ -304,13 +385,26 @@ bool BtcRpcCurl::IsConnected()
 
 void BtcRpcCurl::CleanUpCurl()
 {
+    std::unique_lock<std::mutex> lock(this->poolMutex);
+
     this->currentServer.reset();
 
-    if(curl)
+    for(std::map<std::string, CurlPoolPtr>::iterator it = this->pools.begin(); it != this->pools.end(); it++)
+    {
+        CurlPoolPtr pool = it->second;
+        pool->closed = true;
+
+        for(size_t i = 0; i < pool->idleHandles.size(); i++)
+            curl_easy_cleanup(pool->idleHandles[i]);
+        pool->idleHandles.clear();
+    }
+
+    // anything still sending finishes first
+    for(std::map<std::string, CurlPoolPtr>::iterator it = this->pools.begin(); it != this->pools.end(); it++)
     {
-        curl_easy_cleanup(curl);
-        curl = NULL;
+        while(it->second->handlesOut > 0)
+            this->handleReturned.wait(lock);
     }
 
-    curl_global_cleanup();
+    this->pools.clear();
 }
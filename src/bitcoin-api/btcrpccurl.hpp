@@ -15,6 +15,12 @@
 #include _CINTTYPES
 #include _MEMORY
 
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
 
 /*
  *
@@ -73,37 +79,45 @@ public:
     // returns reply
     virtual BtcRpcPacketPtr SendRpc(BtcRpcPacketPtr jsonString);
 
-private:
-    void WaitMutex();
-    void InitSession();         // Called in constructor, makes sure we have a network interface or something
-    void InitNAM();             // Also called in constr, creates the Network Access Manager.
-    void SetHeaderInformation(); // Called by ConnectToBitcoin, sets the HTTP header
-
-    void CleanUpCurl();
+    // How many calls can be talking to each bitcoind at the same time.
+    // Every server gets its own pool of up to this many keep-alive connections,
+    // a call waits for one to be free if they're all in use.
+    virtual void SetMaxConnections(size_t connections);
+    virtual size_t GetMaxConnections();
 
-    // Processes a network reply
-    // Probably not needed anymore
-    //void ProcessReply(QSharedPointer<QByteArray> replyContType, const QSharedPointer<QByteArray> replyContent);
+private:
+    // curl handles for one server (its url, port and login)
+    struct CurlPool
+    {
+        std::vector<CURL*> idleHandles;     // connected, waiting for the next call
+        size_t handlesOut;                  // checked out by a call right now
+        size_t maxHandles;
+        bool closed;                        // handles that come back get cleaned up
+    };
+    typedef _SharedPtr<CurlPool> CurlPoolPtr;
 
-    // Processes an error message
-    // These can come from a failed network connection, erroneus json-rpc calls or meta-errors like lack of funds.
-    //void ProcessErrorMessage(const QNetworkReply *reply);
+    static std::string PoolKey(BitcoinServerPtr server);
 
-    //QPointer<QNetworkSession> session;
+    // Takes an idle handle from server's pool, creates one, or waits until one is returned.
+    CURL* CheckOutHandle(BitcoinServerPtr server, CurlPoolPtr &pool);
+    void ReturnHandle(CurlPoolPtr pool, CURL* handle, bool reusable);
 
-    //QScopedPointer<QNetworkAccessManager> rpcNAM;      // this is used to send http packets to bitcoin-qt
-    //QScopedPointer<QNetworkRequest> rpcRequest;
-    //QSharedPointer<QByteArray> rpcReplyContent;
+    // Throws away server's pool
+    void ClosePool(BitcoinServerPtr server);
 
-    BitcoinServerPtr currentServer;
-    CURLcode res;
-    CURL* curl;
+    void CleanUpCurl();
 
     BtcModules* modules;
 
     static BtcRpcPacketPtr connectString;
 
-    bool mutex;
+    CURLcode globalInit;
+
+    std::mutex poolMutex;                   // guards everything below
+    std::condition_variable handleReturned;
+    BitcoinServerPtr currentServer;         // the server SendRpc() talks to
+    std::map<std::string, CurlPoolPtr> pools;
+    size_t maxConnections;
 
 
     /*
@@ -5,9 +5,43 @@
 #include <bitcoin-api/btctest.hpp>
 
 #include <bitcoin-api/btcmodules.hpp>
+#include <bitcoin-api/btcblockindex.hpp>
+#include <bitcoin-api/btccoinselection.hpp>
 
+#include <bitcoin/escrowledger.hpp>
+#include <bitcoin/sampleescrowserver.hpp>
+#include <bitcoin/samplenetmessages.hpp>
+#include <bitcoin/zmqconnectionpool.hpp>
+
+#include <opentxs/core/util/OTPaths.hpp>
+
+#include <zmq.h>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
 
 BtcModulesPtr BtcTest::modules;
 std::string BtcTest::multiSigAddress;
@@ -32,9 +66,50 @@ bool BtcTest::TestBitcoinFunctions()
         return false;
     }
 
+    if(!TestBtcRpcPacket())
+        return false;
+
+    if(!TestCoinSelection(1000))
+        return false;
+
+    if(!TestUtxoSet())
+        return false;
+
+    if(!TestNetFrames(20000))
+        return false;
+
+    if(!TestNetFrameThroughput(100, 2000))
+        return false;
+
+    const std::string dataFolder = opentxs::OTPaths::AppDataFolder().Get();
+
+    if(!TestEscrowLedger(100000, dataFolder + "mc_btctest_escrowledger"))
+        return false;
+
+    if(!TestEscrowLedgerJournal(dataFolder + "mc_btctest_escrowledger"))
+        return false;
+
     if(!TestBtcRpc())
         return false;
 
+    if(!TestBtcRpcConcurrency(16, 50, 2))
+        return false;
+
+    if(!TestZmqConnectionPool(8, 200, 0))  // what a request costs
+        return false;
+
+    if(!TestZmqConnectionPool(8, 50, 5))    // what asking all servers at once saves
+        return false;
+
+    if(!TestEscrowServerSimulation(200, 1, dataFolder + "mc_btctest_escrowserver"))
+        return false;
+
+    if(!TestConfirmations())
+        return false;
+
+    if(!TestBtcJsonBatch(100, 2))
+        return false;
+
     if(!TestBtcJson())
         return false;
 
@@ -59,128 +134,2161 @@ bool BtcTest::TestBitcoinFunctions()
     return true;
 }
 
-bool BtcTest::TestBtcRpc()
+// feeds a multi-megabyte reply through the packet the way curl does, in 16kb chunks,
+// and reads it back out in curl-sized pieces. doesn't need bitcoind.
+bool BtcTest::TestBtcRpcPacket()
 {
-    // first testnet server:
-    BitcoinServerPtr bitcoind1 = BitcoinServerPtr(new BitcoinServer("admin1", "123", "http://127.0.0.1", 19001));
+    const size_t chunkSize = 16 * 1024;
+    const size_t totalSize = 32 * 1024 * 1024;
 
-    { BtcRpcPacketPtr(new BtcRpcPacket()); }
-    { std::string str = "test"; BtcRpcPacketPtr(new BtcRpcPacket(str)); }
-    { BtcRpcPacketPtr(new BtcRpcPacket("test")); }
+    std::vector<char> chunk(chunkSize);
+    for(size_t i = 0; i < chunkSize; i++)
+        chunk[i] = 'a' + (i % 26);
+
+    for(int reserve = 0; reserve < 2; reserve++)
     {
-        BtcRpcPacketPtr ptr = BtcRpcPacketPtr(new BtcRpcPacket("test"));
-        BtcRpcPacketPtr(new BtcRpcPacket(ptr));
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        BtcRpcPacketPtr packet = BtcRpcPacketPtr(new BtcRpcPacket());
+        if(reserve)
+            packet->Reserve(totalSize);
+
+        for(size_t written = 0; written < totalSize; written += chunkSize)
+        {
+            if(!packet->AddData(&chunk[0], chunkSize))
+                return false;
+        }
+
+        std::chrono::steady_clock::time_point written = std::chrono::steady_clock::now();
+
+        if(packet->size() != totalSize || packet->GetData()[totalSize] != '\0')
+            return false;
+
+        std::vector<char> buffer(chunkSize);
+        size_t read = 0;
+        size_t length = 0;
+        while((length = packet->ReadData(&buffer[0], buffer.size())) > 0)
+        {
+            if(memcmp(&buffer[0], &chunk[read % chunkSize], length) != 0)
+                return false;
+            read += length;
+        }
+
+        std::chrono::steady_clock::time_point done = std::chrono::steady_clock::now();
+
+        if(read != totalSize)
+            return false;
+
+        std::printf("BtcRpcPacket %s: %d MB written in %lld ms, read in %lld ms\n",
+                    reserve ? "reserved" : "growing", static_cast<int>(totalSize / (1024 * 1024)),
+                    static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(written - start).count()),
+                    static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(done - written).count()));
+        std::cout.flush();
     }
+
+    return true;
+}
+
+// random wallets of 2-of-3 multisig outputs, from dust to whole coins, paid out by each strategy.
+// every selection has to pass CheckCoinSelection() and the same wallet always gives the same result.
+// the totals compare them to the escrow server's old way of spending every output with a fixed fee.
+// doesn't need bitcoind, the seed is fixed so the numbers can be compared between runs.
+bool BtcTest::TestCoinSelection(int wallets)
+{
+    BtcCoinSelectionParams params;
+    params.inputSize = BtcCoinSelectionParams::MultiSigInputSize(2, 3);
+
+    std::vector<BtcCoinSelectionStrategyPtr> strategies;
+    strategies.push_back(BtcCoinSelectionStrategyPtr(new BtcLargestFirstSelection()));
+    strategies.push_back(BtcCoinSelectionStrategyPtr(new BtcBranchAndBoundSelection()));
+    strategies.push_back(BtcCoinSelectionStrategyPtr(new BtcKnapsackSelection()));
+
+    BtcCoinSelector selector;
+
+    // the last two are the default selector and spending everything
+    const size_t columns = strategies.size() + 2;
+    std::vector<int> selected(columns, 0), changeOutputs(columns, 0), dustChange(columns, 0);
+    std::vector<int64_t> inputs(columns, 0), fees(columns, 0), underpaid(columns, 0);
+    std::vector<long long> microseconds(columns, 0);
+
+    std::mt19937 random(42);
+
+    for(int wallet = 0; wallet < wallets; wallet++)
     {
-        std::printf("\n");
-        std::cout.flush();
+        BtcUnspentOutputs available;
+        int64_t availableTotal = 0;
+        size_t outputCount = 1 + random() % 60;
+        for(size_t i = 0; i < outputCount; i++)
+        {
+            BtcUnspentOutputPtr output = BtcUnspentOutputPtr(new BtcUnspentOutput(Json::Value(Json::objectValue)));
+            output->txId = "tx" + btc::to_string(wallet) + "-" + btc::to_string(static_cast<int32_t>(i / 3));
+            output->vout = static_cast<int64_t>(i % 3);
+            output->confirmations = 1;
+
+            int kind = random() % 10;
+            if(kind < 3)
+                output->amount = 100 + random() % 5000;             // dust and change leftovers
+            else if(kind < 8)
+                output->amount = 10000 + random() % 1000000;        // everyday deposits
+            else
+                output->amount = 1000000 + random() % 50000000;     // up to half a coin
+
+            availableTotal += output->amount;
+            available.push_back(output);
+        }
 
-        BtcRpcPacketPtr ptr = BtcRpcPacketPtr(new BtcRpcPacket());
-        ptr->AddData("test");
-        ptr->AddData("moreTEST");
-        std::string data = "";
-        for(size_t i = 0; i < ptr->size() + 10; i++)
+        // now and then ask for more than there is
+        int64_t amount = random() % 10 == 0 ? availableTotal + 1 : 1 + static_cast<int64_t>(random() % availableTotal);
+
+        // the strategies expect what the selector hands them: usable outputs, largest first
+        std::vector<BtcUnspentOutputPtr> usable;
+        for(BtcUnspentOutputs::iterator output = available.begin(); output != available.end(); output++)
         {
-            const char* c = ptr->ReadNextChar();
-            if(c)
+            if((*output)->amount > params.InputFee())
+                usable.push_back((*output));
+        }
+        std::sort(usable.begin(), usable.end(), [](const BtcUnspentOutputPtr &a, const BtcUnspentOutputPtr &b)
+        {
+            if(a->amount != b->amount)
+                return a->amount > b->amount;
+            return a->txId != b->txId ? a->txId < b->txId : a->vout < b->vout;
+        });
+        BtcUnspentOutputs sorted(usable.begin(), usable.end());
+
+        for(size_t column = 0; column < columns; column++)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+            BtcCoinSelectionPtr selection;
+            if(column < strategies.size())
+                selection = strategies[column]->Select(sorted, amount, params);
+            else if(column == strategies.size())
+                selection = selector.Select(available, amount, params);
+            else if(availableTotal >= amount + BtcHelper::FeeMultiSig)
             {
-                data += *c;
-                std::printf("%c\n", *c);
+                selection = BtcCoinSelectionPtr(new BtcCoinSelection());
+                selection->outputs = available;
+                selection->amount = amount;
+                selection->total = availableTotal;
+                selection->fee = BtcHelper::FeeMultiSig;
+                selection->change = availableTotal - amount - BtcHelper::FeeMultiSig;
             }
-            std::cout.flush();
+
+            microseconds[column] += static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+
+            if(selection == NULL)
+                continue;
+
+            if(column < columns - 1 && !CheckCoinSelection(available, amount, params, selection))
+            {
+                std::printf("coin selection failed: wallet %d, column %d\n", wallet, static_cast<int>(column));
+                std::cout.flush();
+                return false;
+            }
+
+            selected[column]++;
+            inputs[column] += selection->outputs.size();
+            fees[column] += selection->fee;
+            if(selection->change > 0)
+                changeOutputs[column]++;
+            if(selection->change > 0 && selection->change < params.dustLimit)
+                dustChange[column]++;
+
+            int64_t neededFee = params.EstimateFee(selection->outputs.size(), selection->change > 0 ? 2 : 1);
+            if(selection->fee < neededFee)
+                underpaid[column]++;
         }
-        std::printf("%s\n", data.c_str());
+
+        // nothing may be lost because a strategy gave up: whoever can't pay, nobody can
+        bool payable = availableTotal >= amount && selector.Select(available, amount, params) != NULL;
+        BtcCoinSelectionPtr largestFirst = strategies[0]->Select(sorted, amount, params);
+        if(payable != (largestFirst != NULL))
+            return false;
+
+        // same wallet, same selection
+        BtcCoinSelectionPtr first = selector.Select(available, amount, params);
+        BtcCoinSelectionPtr second = selector.Select(available, amount, params);
+        if((first == NULL) != (second == NULL))
+            return false;
+        if(first != NULL && (first->fee != second->fee || first->outputs != second->outputs))
+            return false;
+    }
+
+    for(size_t column = 0; column < columns; column++)
+    {
+        const char* name = column < strategies.size() ? strategies[column]->GetName() : column == strategies.size() ? "default" : "spend all, fixed fee";
+        int count = std::max(selected[column], 1);
+        std::printf("%-22s %4d/%d paid, %5.1f inputs, fee %7lld sat, %4d with change, %3d dust change, %3d underpaid, %lld us\n",
+                    name, selected[column], wallets, static_cast<double>(inputs[column]) / count,
+                    static_cast<long long>(fees[column] / count), changeOutputs[column], dustChange[column],
+                    static_cast<int>(underpaid[column]), microseconds[column]);
         std::cout.flush();
     }
 
-    // connect to server (if this function succeeds, SendRpc() works too)
-    if(!modules->btcRpc->ConnectToBitcoin(bitcoind1))
+    return true;
+}
+
+// what has to hold for every selection, whichever strategy made it
+bool BtcTest::CheckCoinSelection(const BtcUnspentOutputs &available, int64_t amount, const BtcCoinSelectionParams &params, BtcCoinSelectionPtr selection)
+{
+    // only outputs we have, each once
+    std::set<std::string> availableOutPoints, usedOutPoints;
+    for(BtcUnspentOutputs::const_iterator output = available.begin(); output != available.end(); output++)
+        availableOutPoints.insert((*output)->txId + ":" + btc::to_string((*output)->vout));
+
+    int64_t total = 0;
+    for(BtcUnspentOutputs::const_iterator output = selection->outputs.begin(); output != selection->outputs.end(); output++)
+    {
+        std::string outPoint = (*output)->txId + ":" + btc::to_string((*output)->vout);
+        if(availableOutPoints.find(outPoint) == availableOutPoints.end() || !usedOutPoints.insert(outPoint).second)
+            return false;
+        total += (*output)->amount;
+    }
+
+    // every satoshi goes somewhere
+    if(selection->amount != amount || selection->total != total || total != amount + selection->fee + selection->change)
         return false;
 
-    if(modules->btcRpc->ConnectToBitcoin(BitcoinServerPtr()))
+    // pays for its size and makes no dust
+    size_t outputs = selection->change > 0 ? 2 : 1;
+    if(selection->fee < params.EstimateFee(selection->outputs.size(), outputs))
+        return false;
+    if(selection->change != 0 && selection->change < params.dustLimit)
         return false;
 
-    if(modules->btcRpc->ConnectToBitcoin("wronguser", "wrongpw","127.0.0.1",19001))
+    // without change, the fee doesn't have more on top than a change output would have saved
+    if(selection->change == 0 && selection->fee - params.EstimateFee(selection->outputs.size(), 1) >= params.EstimateFee(selection->outputs.size(), 2) - params.EstimateFee(selection->outputs.size(), 1) + params.dustLimit)
         return false;
 
-    if(modules->btcRpc->ConnectToBitcoin("","", "127.0.0.1", 123))
+    return true;
+}
+
+// feeds listunspent-like results into a utxo set and checks what comes out
+bool BtcTest::TestUtxoSet()
+{
+    BtcUtxoSet utxos;
+    utxos.SetOwner("addr1", "client1");
+
+    btc::stringList addresses;
+    addresses.push_back("addr1");
+    addresses.push_back("addr2");
+
+    BtcUnspentOutputs unspent;
+    for(int i = 0; i < 6; i++)
+    {
+        BtcUnspentOutputPtr output = BtcUnspentOutputPtr(new BtcUnspentOutput(Json::Value(Json::objectValue)));
+        output->txId = "tx" + btc::to_string(i);
+        output->vout = 0;
+        output->address = i % 2 == 0 ? "addr1" : "addr2";
+        output->amount = 1000 * (i + 1);
+        unspent.push_back(output);
+    }
+
+    utxos.Update(addresses, unspent);
+    if(utxos.size() != 6 || utxos.GetBalance("addr1") != 9000 || utxos.GetByOwner("client1").size() != 3)
         return false;
 
-    if(!modules->btcRpc->ConnectToBitcoin(bitcoind1))
+    // largest first
+    BtcUnspentOutputs client1 = utxos.GetByOwner("client1");
+    if(client1.front()->amount != 5000 || client1.back()->amount != 1000)
         return false;
 
-    // try sending some garbage and see if anything crashes
-    modules->btcRpc->SendRpc(NULL);
+    // tx0 got spent, tx6 is new
+    unspent.pop_front();
+    BtcUnspentOutputPtr output = BtcUnspentOutputPtr(new BtcUnspentOutput(Json::Value(Json::objectValue)));
+    output->txId = "tx6";
+    output->vout = 1;
+    output->address = "addr1";
+    output->amount = 500;
+    unspent.push_back(output);
+
+    utxos.Update(addresses, unspent);
+    if(utxos.size() != 6 || utxos.GetBalance("addr1") != 8500 || utxos.GetByOwner("client1").back()->txId != "tx6")
+        return false;
 
-    modules->btcRpc->SendRpc("garbage");
+    // addr2 changes hands, the outputs go with it
+    utxos.SetOwner("addr2", "client2");
+    if(utxos.GetByOwner("client2").size() != 3 || utxos.GetByOwner("client1").size() != 3)
+        return false;
 
-    modules->btcRpc->SendRpc("\0");
+    // addresses that weren't asked about stay as they are
+    btc::stringList onlyAddr2;
+    onlyAddr2.push_back("addr2");
+    utxos.Update(onlyAddr2, BtcUnspentOutputs());
+    if(utxos.size() != 3 || utxos.GetBalance("addr2") != 0 || utxos.GetBalance("addr1") != 8500 || !utxos.GetByOwner("client2").empty())
+        return false;
 
-    modules->btcRpc->SendRpc(BtcRpcPacketPtr(new BtcRpcPacket()));
+    if(!utxos.Remove("tx6", 1) || utxos.Remove("tx6", 1) || utxos.size() != 2)
+        return false;
 
-    return true;    // not crashing is enough to pass this test
+    return true;
 }
 
-bool BtcTest::TestBtcJson()
+// round trips of random variable-length messages, then the same frames cut short and corrupted.
+// cut frames and payloads have to be rejected, corrupted ones must not crash.
+// doesn't need a server, the seed is fixed.
+bool BtcTest::TestNetFrames(int rounds)
 {
-    BitcoinServerPtr bitcoind1 = BitcoinServerPtr(new BitcoinServer("admin1", "123", "http://127.0.0.1", 19001));
+    InitNetMessages();
 
-    // connect to server
-    if(!modules->btcRpc->ConnectToBitcoin(bitcoind1))
-        return false;
+    std::mt19937_64 random(42);
+    NetMessageType type = Unknown;
+    std::string payload;
+    int corruptedAccepted = 0;
 
-    // see if we can get some response:
-    std::string address = modules->btcJson->GetNewAddress();
-    if(address.empty())
-        return false;
+    for(int round = 0; round < rounds; round++)
+    {
+        // varints of every length and strings survive the round trip
+        uint64_t value = random() >> (random() % 64);
+        int64_t signedValue = static_cast<int64_t>(random()) >> (random() % 64);
+        std::string text(random() % 40, 'x');
+
+        NetMsgWriter writer;
+        writer.WriteVarInt(value);
+        writer.WriteSignedVarInt(signedValue);
+        writer.WriteString(text);
+
+        if(!ParseNetFrame(writer.Frame(GetTxs), type, payload) || type != GetTxs)
+            return false;
+
+        NetMsgReader reader(payload);
+        uint64_t valueRead = 0;
+        int64_t signedValueRead = 0;
+        std::string textRead;
+        if(!reader.ReadVarInt(valueRead) || !reader.ReadSignedVarInt(signedValueRead) || !reader.ReadString(textRead) ||
+                !reader.AtEnd() || valueRead != value || signedValueRead != signedValue || textRead != text)
+            return false;
+
+        // a transaction list
+        BtcNetMsgTxList list;
+        list.fromIndex = random() % 1000;
+        list.totalCount = random();
+        for(int i = static_cast<int>(random() % 20); i > 0; i--)
+        {
+            BtcNetMsgTxList::Record record;
+            record.txId = std::string(64, 'a' + i % 26);
+            record.toAddress = std::string(random() % 80, 'b');
+            record.amount = static_cast<int64_t>(random());
+            record.type = static_cast<int8_t>(random() % 2);
+            record.status = static_cast<int8_t>(random() % 6);
+            list.transactions.push_back(record);
+        }
 
-    // disconnect
-    modules->btcRpc->ConnectToBitcoin(BitcoinServerPtr(new BitcoinServer("bla", "bla", "url", 123)));
+        const std::string frame = list.Encode();
+        BtcNetMsgTxList decoded;
+        if(!ParseNetFrame(frame, type, payload) || type != TxList || !decoded.Decode(payload) ||
+                decoded.fromIndex != list.fromIndex || decoded.totalCount != list.totalCount ||
+                decoded.transactions.size() != list.transactions.size())
+            return false;
 
-    // try again
-    address = modules->btcJson->GetNewAddress();
-    if(!address.empty())
-        return false;
+        for(size_t i = 0; i < list.transactions.size(); i++)
+        {
+            if(decoded.transactions[i].txId != list.transactions[i].txId ||
+                    decoded.transactions[i].toAddress != list.transactions[i].toAddress ||
+                    decoded.transactions[i].amount != list.transactions[i].amount ||
+                    decoded.transactions[i].type != list.transactions[i].type ||
+                    decoded.transactions[i].status != list.transactions[i].status)
+                return false;
+        }
+        const std::string listPayload = payload;
 
-    // reconnect
-    if(!modules->btcRpc->ConnectToBitcoin(bitcoind1))
-        return false;
+        // trailing bytes don't belong to the message
+        BtcNetMsgGetTxs request;
+        request.client = "client";
+        if(!ParseNetFrame(request.Encode(), type, payload) || !request.Decode(payload) ||
+                request.Decode(payload + '\0') || decoded.Decode(listPayload + '\0'))
+            return false;
 
-    address = modules->btcJson->GetNewAddress();
+        // every frame that's cut short is rejected, and so is every cut payload
+        for(size_t cut = 0; cut < frame.size(); cut += 1 + random() % 7)
+        {
+            if(ParseNetFrame(frame.substr(0, cut), type, payload))
+                return false;
+        }
+        for(size_t cut = 0; cut < listPayload.size(); cut += 1 + random() % 5)
+        {
+            if(BtcNetMsgTxList().Decode(listPayload.substr(0, cut)))
+                return false;
+        }
 
-    std::string txid;
-    if((txid = modules->btcJson->SendToAddress(address, BtcHelper::CoinsToSatoshis(10))).empty())
+        // random damage, whatever still parses has to decode without crashing
+        for(int i = 0; i < 20; i++)
+        {
+            std::string damaged = frame;
+            for(int j = 1 + static_cast<int>(random() % 4); j > 0; j--)
+                damaged[random() % damaged.size()] = static_cast<char>(random());
+
+            if(ParseNetFrame(damaged, type, payload))
+            {
+                corruptedAccepted += BtcNetMsgTxList().Decode(payload);
+                corruptedAccepted += BtcNetMsgGetTxs().Decode(payload);
+            }
+        }
+
+        std::string garbage(1 + random() % 64, '\0');
+        for(size_t i = 0; i < garbage.size(); i++)
+            garbage[i] = static_cast<char>(random());
+        garbage[0] = static_cast<char>(NetFrameVersion);
+        if(ParseNetFrame(garbage, type, payload))
+            BtcNetMsgTxList().Decode(payload);
+    }
+
+    std::printf("Net frames: %d rounds passed, %d corrupted frames still decoded\n", rounds, corruptedAccepted);
+    std::cout.flush();
+
+    return true;
+}
+
+// a client fetching a history of txCount transactions: one GetTx/Tx pair per transaction
+// the old way, one GetTxs/TxList pair now. encodes and decodes both ways and prints time and bytes.
+bool BtcTest::TestNetFrameThroughput(int txCount, int rounds)
+{
+    InitNetMessages();
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t unionBytes = 0;
+
+    for(int round = 0; round < rounds; round++)
+    {
+        for(int i = 0; i < txCount; i++)
+        {
+            BtcNetMsgGetTx request;
+            memcpy(request.client, "client0123456789abc", 20);
+            request.txIndex = i;
+            char requestData[NetMsgGetTxSize];
+            memcpy(requestData, request.data, NetMsgGetTxSize);
+
+            BtcNetMsgTx reply;
+            memset(reply.txId, 'a', 64);
+            memset(reply.toAddress, 'b', 34);
+            reply.amount = 12345678;
+            char replyData[NetMsgTxSize];
+            memcpy(replyData, reply.data, NetMsgTxSize);
+
+            BtcNetMsgTx received;
+            memcpy(received.data, replyData, NetMsgTxSize);
+            if(std::string(received.txId, 64) != std::string(64, 'a'))
+                return false;
+
+            unionBytes += NetMsgGetTxSize + NetMsgTxSize;
+        }
+    }
+
+    std::chrono::steady_clock::time_point unionsDone = std::chrono::steady_clock::now();
+    size_t frameBytes = 0;
+
+    for(int round = 0; round < rounds; round++)
+    {
+        NetMessageType type = Unknown;
+        std::string payload;
+
+        BtcNetMsgGetTxs request;
+        request.client = "client0123456789abc";
+        request.fromIndex = 0;
+        request.maxCount = txCount;
+        const std::string requestFrame = request.Encode();
+        BtcNetMsgGetTxs requestReceived;
+        if(!ParseNetFrame(requestFrame, type, payload) || !requestReceived.Decode(payload))
+            return false;
+
+        BtcNetMsgTxList reply;
+        reply.totalCount = txCount;
+        for(int i = 0; i < txCount; i++)
+        {
+            BtcNetMsgTxList::Record record;
+            record.txId = std::string(64, 'a');
+            record.toAddress = std::string(34, 'b');
+            record.amount = 12345678;
+            record.type = 0;
+            record.status = 2;
+            reply.transactions.push_back(record);
+        }
+        const std::string replyFrame = reply.Encode();
+        BtcNetMsgTxList replyReceived;
+        if(!ParseNetFrame(replyFrame, type, payload) || !replyReceived.Decode(payload) ||
+                replyReceived.transactions.size() != static_cast<size_t>(txCount))
+            return false;
+
+        frameBytes += requestFrame.size() + replyFrame.size();
+    }
+
+    std::chrono::steady_clock::time_point framesDone = std::chrono::steady_clock::now();
+
+    std::printf("History of %d txs, fixed-size messages: %d messages, %d bytes, %.1f us\n",
+                txCount, 2 * txCount, static_cast<int>(unionBytes / rounds),
+                std::chrono::duration_cast<std::chrono::microseconds>(unionsDone - start).count() / static_cast<double>(rounds));
+    std::printf("History of %d txs, frames: 2 messages, %d bytes, %.1f us\n",
+                txCount, static_cast<int>(frameBytes / rounds),
+                std::chrono::duration_cast<std::chrono::microseconds>(framesDone - unionsDone).count() / static_cast<double>(rounds));
+    std::cout.flush();
+
+    return true;
+}
+
+// a server with many clients: deposits, status changes, spends and releases go into the ledger,
+// then the balance and outpoint lookups are timed and the ledger is read back from its journal.
+// doesn't need bitcoind.
+bool BtcTest::TestEscrowLedger(int clients, const std::string &journalPath)
+{
+    std::remove(journalPath.c_str());
+
+    EscrowLedgerPtr ledger = EscrowLedgerPtr(new EscrowLedger(BtcModulesPtr()));
+    if(!ledger->SetJournalFile(journalPath))
         return false;
 
-    // even when testing locally it takes a few ms
-    if(modules->btcHelper->WaitGetTransaction(txid) == NULL)
+    std::vector<std::string> clientNames;
+    for(int i = 0; i < clients; i++)
+        clientNames.push_back("client" + btc::to_string(i));
+
+    // three deposits per client, the first one is already Successfull
+    std::vector<SampleEscrowTransactionPtr> deposits;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int i = 0; i < clients; i++)
+    {
+        for(int32_t d = 0; d < 3; d++)
+        {
+            SampleEscrowTransactionPtr tx = SampleEscrowTransactionPtr(new SampleEscrowTransaction(1000 + d, BtcModulesPtr()));
+            tx->txId = "tx" + btc::to_string(i) + "_" + btc::to_string(d);
+            tx->vout = d;
+            tx->targetAddr = "address" + btc::to_string(i);
+            tx->status = d == 0 ? SampleEscrowTransaction::Successfull : SampleEscrowTransaction::Pending;
+            if(!ledger->AddDeposit(clientNames[i], tx, false))
+                return false;
+            deposits.push_back(tx);
+        }
+    }
+    std::chrono::steady_clock::time_point added = std::chrono::steady_clock::now();
+
+    // the same output can't belong to two clients
+    if(ledger->AddDeposit("someone else", deposits[0], false))
         return false;
 
-    // list unspent outputs
-    BtcUnspentOutputs unspentOutputs = modules->btcJson->ListUnspent(/*optional*/);
-    if(unspentOutputs.empty())
+    // the second deposit of every client confirms, the third one of every tenth client is spent
+    for(int i = 0; i < clients; i++)
+    {
+        deposits[i * 3 + 1]->status = SampleEscrowTransaction::Successfull;
+        ledger->DepositChanged(clientNames[i], deposits[i * 3 + 1]);
+        if(i % 10 == 0 && !ledger->RemoveDeposit(clientNames[i], deposits[i * 3 + 2]->txId, 2))
+            return false;
+    }
+    std::chrono::steady_clock::time_point changed = std::chrono::steady_clock::now();
+
+    int64_t total = 0;
+    for(int round = 0; round < 10; round++)
+    {
+        for(int i = 0; i < clients; i++)
+            total += ledger->GetBalance(clientNames[i]);
+    }
+    std::chrono::steady_clock::time_point balances = std::chrono::steady_clock::now();
+
+    if(total != 10 * static_cast<int64_t>(clients) * 2001)
         return false;
 
-    // now to spend an output
-    // create a list of txid/vout pairs as input for our raw transaction:
-    BtcTxIdVouts outputsToSpend;
-    outputsToSpend.push_back(BtcTxIdVoutPtr(new BtcTxIdVout(unspentOutputs.front()->txId, unspentOutputs.front()->vout)));
+    for(int i = 0; i < clients; i++)
+    {
+        std::string owner;
+        SampleEscrowTransactionPtr found = ledger->FindDeposit(deposits[i * 3 + 1]->txId, 1, &owner);
+        if(found != deposits[i * 3 + 1] || owner != clientNames[i])
+            return false;
+    }
+    std::chrono::steady_clock::time_point lookups = std::chrono::steady_clock::now();
 
-    // create a list of address:vout mappings to which the inputs will be sent
-    BtcTxTargets txTargets;
-    txTargets[address] = (Json::Int64)(unspentOutputs.front()->amount - BtcHelper::FeeMultiSig);
+    // threads asking about different clients at the same time as releases are added
+    std::vector<std::thread> workers;
+    for(int t = 0; t < 8; t++)
+    {
+        workers.push_back(std::thread([t, clients, &ledger, &clientNames]()
+        {
+            for(int i = t; i < clients; i += 8)
+            {
+                ledger->GetBalance(clientNames[i]);
+                SampleEscrowTransactionPtr release = SampleEscrowTransactionPtr(new SampleEscrowTransaction(5, BtcModulesPtr()));
+                release->txId = "release" + btc::to_string(i);
+                release->type = SampleEscrowTransaction::Release;
+                ledger->AddToHistory(clientNames[i], release);
+            }
+        }));
+    }
+    for(size_t t = 0; t < workers.size(); t++)
+        workers[t].join();
+    std::chrono::steady_clock::time_point concurrent = std::chrono::steady_clock::now();
 
-    // create raw transaction
-    std::string rawTx = modules->btcJson->CreateRawTransaction(outputsToSpend, txTargets);
-    BtcSignedTransactionPtr signedTx = modules->btcJson->SignRawTransaction(rawTx);
-    if(modules->btcJson->SendRawTransaction(signedTx->signedTransaction).empty())
+    // start over from the journal
+    EscrowLedgerPtr restarted = EscrowLedgerPtr(new EscrowLedger(BtcModulesPtr()));
+    if(!restarted->SetJournalFile(journalPath))
         return false;
+    std::chrono::steady_clock::time_point replayed = std::chrono::steady_clock::now();
 
-    // TODO: Test all the other functions. Nah, they should be safe to use.
+    if(restarted->GetClientCount() != static_cast<size_t>(clients))
+        return false;
+    for(int i = 0; i < clients; i++)
+    {
+        if(restarted->GetBalance(clientNames[i]) != ledger->GetBalance(clientNames[i]) ||
+                restarted->GetHistorySize(clientNames[i]) != 4 ||
+                restarted->GetDeposits(clientNames[i]).size() != (i % 10 == 0 ? 2u : 3u) ||
+                restarted->GetHistoryEntry(clientNames[i], 3)->txId != "release" + btc::to_string(i))
+            return false;
+    }
+
+    std::printf("EscrowLedger %d clients: %lld ms to add %d deposits, %lld ms for %d changes, "
+                "%lld ms for %d balances, %lld ms for %d outpoint lookups, %lld ms for 8 threads, %lld ms to replay the journal\n",
+                clients,
+                static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(added - start).count()), 3 * clients,
+                static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(changed - added).count()), clients + clients / 10,
+                static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(balances - changed).count()), 10 * clients,
+                static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(lookups - balances).count()), clients,
+                static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(concurrent - lookups).count()),
+                static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(replayed - concurrent).count()));
+    std::cout.flush();
 
+    std::remove(journalPath.c_str());
     return true;
 }
 
+// client names come from the network, so they can be anything. names with spaces, line breaks,
+// escapes and the like have to come back from the journal as they went in and must not add entries of their own.
+// a line cut short at the end is dropped, a broken line in the middle is skipped and kept in a copy of the journal.
+// a change that couldn't be written makes it into the journal once it's rewritten.
+bool BtcTest::TestEscrowLedgerJournal(const std::string &journalPath)
+{
+    std::remove(journalPath.c_str());
+    std::remove((journalPath + ".bad").c_str());
+
+    btc::stringList names;
+    names.push_back("");
+    names.push_back("-");
+    names.push_back("%2D");
+    names.push_back("two words");
+    names.push_back("tab\tand\rreturn");
+    names.push_back("injected\nD victim evil 0 100000000 - - 2 0 1");
+    names.push_back("100%");
+    names.push_back("%zz");
+    names.push_back(std::string("nul\0byte", 8));
+    names.push_back("\xc3\xbc\xc3\xa9");
+
+    {
+        EscrowLedger ledger((BtcModulesPtr()));
+        if(!ledger.SetJournalFile(journalPath))
+            return false;
+
+        for(size_t i = 0; i < names.size(); i++)
+        {
+            SampleEscrowTransactionPtr deposit = SampleEscrowTransactionPtr(new SampleEscrowTransaction(1000 + i, BtcModulesPtr()));
+            deposit->txId = "tx" + btc::to_string(static_cast<uint32_t>(i));
+            deposit->vout = 0;
+            deposit->targetAddr = names[i] + " address";
+            deposit->status = SampleEscrowTransaction::Successfull;
+            if(!ledger.AddDeposit(names[i], deposit, false))
+                return false;
+
+            SampleEscrowTransactionPtr release = SampleEscrowTransactionPtr(new SampleEscrowTransaction(7, BtcModulesPtr()));
+            release->txId = "release " + names[i];
+            release->targetAddr = names[i];
+            release->type = SampleEscrowTransaction::Release;
+            ledger.AddToHistory(names[i], release);
+
+            ledger.AddAddress(names[i], "multisig " + names[i]);
+        }
+    }
+
+    // crash in the middle of writing a line, and some damage further up
+    {
+        std::ofstream journal(journalPath.c_str(), std::ios::out | std::ios::app);
+        journal << "D broken\n";
+        journal << "A late late-address\n";
+        journal << "D half tx 0 10";
+    }
+
+    // once replaying the appended journal, once the one it was rewritten to
+    for(int pass = 0; pass < 2; pass++)
+    {
+        EscrowLedger ledger((BtcModulesPtr()));
+        if(!ledger.SetJournalFile(journalPath))
+            return false;
+
+        // nothing for "victim", "broken" or "half", the line after the broken one is there
+        if(ledger.GetClientCount() != names.size() + 1 || ledger.GetBalance("victim") != 0)
+            return false;
+
+        std::vector<std::pair<std::string, std::string> > addresses = ledger.GetAddresses();
+        if(addresses.size() != names.size() + 1 ||
+                std::find(addresses.begin(), addresses.end(), std::make_pair(std::string("late"), std::string("late-address"))) == addresses.end())
+            return false;
+
+        for(size_t i = 0; i < names.size(); i++)
+        {
+            SampleEscrowTransactions deposits = ledger.GetDeposits(names[i]);
+            SampleEscrowTransactionPtr release = ledger.GetHistoryEntry(names[i], 1);
+            if(ledger.GetBalance(names[i]) != static_cast<int64_t>(1000 + i) || deposits.size() != 1 ||
+                    deposits.front()->targetAddr != names[i] + " address" || ledger.GetHistorySize(names[i]) != 2 ||
+                    release == NULL || release->txId != "release " + names[i] || release->targetAddr != names[i] ||
+                    std::find(addresses.begin(), addresses.end(), std::make_pair(names[i], "multisig " + names[i])) == addresses.end())
+                return false;
+        }
+
+        // the broken line was kept before the journal was rewritten, after that there's nothing to keep
+        std::ifstream backup((journalPath + ".bad").c_str());
+        if(backup.is_open() != (pass == 0))
+            return false;
+        backup.close();
+        std::remove((journalPath + ".bad").c_str());
+    }
+
+    // a journal from before the escaping is still read, and something that isn't a journal is left alone
+    {
+        std::ofstream journal(journalPath.c_str(), std::ios::out | std::ios::trunc);
+        journal << "escrowledger 1\n";
+        journal << "D old tx 1 500 address - 2 3 1\n";
+    }
+    {
+        EscrowLedger ledger((BtcModulesPtr()));
+        if(!ledger.SetJournalFile(journalPath) || ledger.GetBalance("old") != 500 || ledger.GetHistorySize("old") != 1)
+            return false;
+    }
+
+    // a last line that was cut where it still reads fine is dropped all the same, and it isn't damage
+    {
+        std::ofstream journal(journalPath.c_str(), std::ios::out | std::ios::app);
+        journal << "A old old-address";
+    }
+    {
+        EscrowLedger ledger((BtcModulesPtr()));
+        if(!ledger.SetJournalFile(journalPath) || ledger.GetBalance("old") != 500 || !ledger.GetAddresses().empty())
+            return false;
+
+        std::ifstream backup((journalPath + ".bad").c_str());
+        if(backup.is_open())
+            return false;
+    }
+
+    // a change that can't be appended (disk full) is noticed and nothing is appended after it,
+    // the journal is rewritten with everything once it can be written again
+    {
+        EscrowLedger ledger((BtcModulesPtr()));
+        if(!ledger.SetJournalFile(journalPath))
+            return false;
+
+        ledger.journal.setstate(std::ios::badbit);
+
+        SampleEscrowTransactionPtr deposit = SampleEscrowTransactionPtr(new SampleEscrowTransaction(700, BtcModulesPtr()));
+        deposit->txId = "full tx";
+        deposit->status = SampleEscrowTransaction::Successfull;
+        if(!ledger.AddDeposit("full", deposit, false) || !ledger.journalFailed)
+            return false;
+        ledger.AddAddress("full", "full-address");
+
+        if(!ledger.RepairJournal() || ledger.journalFailed)
+            return false;
+    }
+    {
+        EscrowLedger ledger((BtcModulesPtr()));
+        if(!ledger.SetJournalFile(journalPath) || ledger.GetBalance("old") != 500 || ledger.GetBalance("full") != 700 ||
+                ledger.GetAddresses().size() != 1)
+            return false;
+    }
+    {
+        std::ofstream journal(journalPath.c_str(), std::ios::out | std::ios::trunc);
+        journal << "escrowledger 99\n";
+    }
+    {
+        EscrowLedger ledger((BtcModulesPtr()));
+        if(ledger.SetJournalFile(journalPath))
+            return false;
+
+        std::ifstream journal(journalPath.c_str());
+        std::string header;
+        if(!std::getline(journal, header) || header != "escrowledger 99")
+            return false;
+    }
+
+    std::printf("EscrowLedger journal: %d hostile client names survived two restarts\n", static_cast<int>(names.size()));
+    std::cout.flush();
+
+    std::remove(journalPath.c_str());
+    return true;
+}
+
+bool BtcTest::TestBtcRpc()
+{
+    // first testnet server:
+    BitcoinServerPtr bitcoind1 = BitcoinServerPtr(new BitcoinServer("admin1", "123", "http://127.0.0.1", 19001));
+
+    { BtcRpcPacketPtr(new BtcRpcPacket()); }
+    { std::string str = "test"; BtcRpcPacketPtr(new BtcRpcPacket(str)); }
+    { BtcRpcPacketPtr(new BtcRpcPacket("test")); }
+    {
+        BtcRpcPacketPtr ptr = BtcRpcPacketPtr(new BtcRpcPacket("test"));
+        BtcRpcPacketPtr(new BtcRpcPacket(ptr));
+    }
+    {
+        std::printf("\n");
+        std::cout.flush();
+
+        BtcRpcPacketPtr ptr = BtcRpcPacketPtr(new BtcRpcPacket());
+        ptr->AddData("test");
+        ptr->AddData("moreTEST");
+        std::string data = "";
+        for(size_t i = 0; i < ptr->size() + 10; i++)
+        {
+            const char* c = ptr->ReadNextChar();
+            if(c)
+            {
+                data += *c;
+                std::printf("%c\n", *c);
+            }
+            std::cout.flush();
+        }
+        std::printf("%s\n", data.c_str());
+        std::cout.flush();
+    }
+
+    // connect to server (if this function succeeds, SendRpc() works too)
+    if(!modules->btcRpc->ConnectToBitcoin(bitcoind1))
+        return false;
+
+    if(modules->btcRpc->ConnectToBitcoin(BitcoinServerPtr()))
+        return false;
+
+    if(modules->btcRpc->ConnectToBitcoin("wronguser", "wrongpw","127.0.0.1",19001))
+        return false;
+
+    if(modules->btcRpc->ConnectToBitcoin("","", "127.0.0.1", 123))
+        return false;
+
+    if(!modules->btcRpc->ConnectToBitcoin(bitcoind1))
+        return false;
+
+    // try sending some garbage and see if anything crashes
+    modules->btcRpc->SendRpc(NULL);
+
+    modules->btcRpc->SendRpc("garbage");
+
+    modules->btcRpc->SendRpc("\0");
+
+    modules->btcRpc->SendRpc(BtcRpcPacketPtr(new BtcRpcPacket()));
+
+    return true;    // not crashing is enough to pass this test
+}
+
+// answers every json-rpc call with {"result":1} after waiting latencyMs, like a busy bitcoind would.
+// a handler can answer instead, it gets the request body and returns the reply body (empty for the default).
+// keeps connections alive the way bitcoind does, one thread per connection.
+// listens on a free port on localhost, see GetPort().
+class BtcStubBitcoind
+{
+public:
+    typedef std::function<std::string(const std::string &request)> Handler;
+
+    BtcStubBitcoind(int latencyMs, Handler handler = Handler())
+        : latencyMs(latencyMs), handler(handler), port(0), stopped(false), requests(0), listenSocket(InvalidSocket)
+    {
+        listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+        if(listenSocket == InvalidSocket)
+            return;
+
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;       // any free port
+
+        socklen_t length = sizeof(address);
+        if(bind(listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+                listen(listenSocket, 64) != 0 ||
+                getsockname(listenSocket, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+        {
+            CloseSocket(listenSocket);
+            listenSocket = InvalidSocket;
+            return;
+        }
+
+        port = ntohs(address.sin_port);
+        acceptThread = std::thread(&BtcStubBitcoind::AcceptLoop, this);
+    }
+
+    ~BtcStubBitcoind()
+    {
+        stopped = true;
+
+        if(listenSocket != InvalidSocket)
+        {
+            shutdown(listenSocket, ShutdownBoth);
+            CloseSocket(listenSocket);
+        }
+        if(acceptThread.joinable())
+            acceptThread.join();
+
+        {
+            std::lock_guard<std::mutex> lock(connectionMutex);
+            for(size_t i = 0; i < connections.size(); i++)
+                shutdown(connections[i], ShutdownBoth);     // wakes up the threads waiting in recv()
+        }
+        for(size_t i = 0; i < connectionThreads.size(); i++)
+            connectionThreads[i].join();
+        for(size_t i = 0; i < connections.size(); i++)
+            CloseSocket(connections[i]);
+    }
+
+    // 0 if the server couldn't be started
+    int GetPort() const { return port; }
+
+    // http requests answered so far, a batch is one
+    int GetRequestCount() const { return requests; }
+
+private:
+#ifdef _WIN32
+    typedef SOCKET Socket;
+    typedef int socklen_t;
+    static const Socket InvalidSocket = INVALID_SOCKET;
+    static const int ShutdownBoth = SD_BOTH;
+    static void CloseSocket(Socket s) { closesocket(s); }
+#else
+    typedef int Socket;
+    static const Socket InvalidSocket = -1;
+    static const int ShutdownBoth = SHUT_RDWR;
+    static void CloseSocket(Socket s) { close(s); }
+#endif
+
+    void AcceptLoop()
+    {
+        while(!stopped)
+        {
+            Socket connection = accept(listenSocket, NULL, NULL);
+            if(connection == InvalidSocket)
+                return;
+
+            std::lock_guard<std::mutex> lock(connectionMutex);
+            if(stopped)
+            {
+                CloseSocket(connection);
+                return;
+            }
+            connections.push_back(connection);
+            connectionThreads.push_back(std::thread(&BtcStubBitcoind::Serve, this, connection));
+        }
+    }
+
+    void Serve(Socket connection)
+    {
+        std::string received;
+        char buffer[4096];
+
+        while(!stopped)
+        {
+            // wait for the headers and the body they announce
+            size_t headerEnd = received.find("\r\n\r\n");
+            size_t contentLength = 0;
+            if(headerEnd != std::string::npos)
+            {
+                size_t field = received.find("Content-Length:");
+                if(field != std::string::npos && field < headerEnd)
+                    contentLength = std::strtoul(received.c_str() + field + 15, NULL, 10);
+            }
+
+            if(headerEnd == std::string::npos || received.size() < headerEnd + 4 + contentLength)
+            {
+                int length = recv(connection, buffer, sizeof(buffer), 0);
+                if(length <= 0)
+                    return;     // client hung up
+                received.append(buffer, length);
+                continue;
+            }
+
+            const std::string body = received.substr(headerEnd + 4, contentLength);
+            received.erase(0, headerEnd + 4 + contentLength);
+
+            if(latencyMs > 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(latencyMs));
+            requests++;
+
+            std::string reply = handler ? handler(body) : std::string();
+            if(reply.empty())
+                reply = "{\"result\":1,\"error\":null,\"id\":" + GetId(body) + "}\n";
+            const std::string response = "HTTP/1.1 200 OK\r\n"
+                    "Content-Type: application/json\r\n"
+                    "Content-Length: " + btc::to_string(static_cast<uint32_t>(reply.size())) + "\r\n"
+                    "\r\n" + reply;
+
+            for(size_t sent = 0; sent < response.size(); )
+            {
+                int length = send(connection, response.c_str() + sent, static_cast<int>(response.size() - sent), 0);
+                if(length <= 0)
+                    return;
+                sent += length;
+            }
+        }
+    }
+
+    // the id of the call exactly as the caller wrote it, null if there is none
+    static std::string GetId(const std::string &request)
+    {
+        size_t pos = request.find("\"id\"");
+        if(pos == std::string::npos)
+            return "null";
+
+        pos = request.find_first_not_of(" \t:", pos + 4);
+        if(pos == std::string::npos)
+            return "null";
+
+        size_t end = request[pos] == '"' ? request.find('"', pos + 1) + 1 : request.find_first_of(",}", pos);
+        if(end == std::string::npos || end == 0)
+            return "null";
+
+        return request.substr(pos, end - pos);
+    }
+
+    const int latencyMs;
+    const Handler handler;
+    int port;
+    std::atomic<bool> stopped;
+    std::atomic<int> requests;
+
+    Socket listenSocket;
+    std::thread acceptThread;
+
+    std::mutex connectionMutex;
+    std::vector<Socket> connections;
+    std::vector<std::thread> connectionThreads;
+};
+
+// many threads calling bitcoind at once through the connection pool.
+// every reply has to match the call that asked for it, and the timings show how it scales.
+// talks to a stub bitcoind on localhost that takes latencyMs per call, so the numbers are repeatable.
+bool BtcTest::TestBtcRpcConcurrency(int threads, int callsPerThread, int latencyMs)
+{
+    BtcStubBitcoind stub(latencyMs);
+    if(stub.GetPort() == 0)
+        return false;
+
+    BitcoinServerPtr server = BitcoinServerPtr(new BitcoinServer("admin1", "123", "http://127.0.0.1", stub.GetPort()));
+
+    if(!modules->btcRpc->ConnectToBitcoin(server))
+        return false;
+
+    const size_t previousMaxConnections = modules->btcRpc->GetMaxConnections();
+    const size_t connectionCounts[] = { 1, 4, 16 };
+    bool success = true;
+
+    for(size_t c = 0; c < sizeof(connectionCounts) / sizeof(connectionCounts[0]) && success; c++)
+    {
+        modules->btcRpc->SetMaxConnections(connectionCounts[c]);
+
+        std::atomic<int> failures(0);
+        std::vector<std::thread> workers;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        for(int t = 0; t < threads; t++)
+        {
+            workers.push_back(std::thread([t, callsPerThread, &failures]()
+            {
+                for(int i = 0; i < callsPerThread; i++)
+                {
+                    const std::string id = btc::to_string(t) + "-" + btc::to_string(i);
+
+                    BtcRpcPacketPtr reply = modules->btcRpc->SendRpc(
+                                "{\"jsonrpc\": \"1.0\", \"id\":\"" + id + "\", \"method\": \"getblockcount\", \"params\": [] }");
+
+                    if(reply == NULL || std::string(reply->GetData()).find("\"id\":\"" + id + "\"") == std::string::npos)
+                        failures++;
+                }
+            }));
+        }
+
+        for(size_t t = 0; t < workers.size(); t++)
+            workers[t].join();
+
+        std::chrono::steady_clock::time_point done = std::chrono::steady_clock::now();
+
+        std::printf("BtcRpcCurl %d threads x %d calls over %d connections, %d ms per call: %lld ms, %d failed\n",
+                    threads, callsPerThread, static_cast<int>(connectionCounts[c]), latencyMs,
+                    static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(done - start).count()),
+                    failures.load());
+        std::cout.flush();
+
+        if(failures.load() > 0)
+            success = false;
+    }
+
+    modules->btcRpc->SetMaxConnections(previousMaxConnections);
+
+    return success;
+}
+
+// an escrow server that only echoes, on a free port on localhost.
+// answers like SampleEscrowServerZmq::UpdateServer() does, after waiting latencyMs.
+// the socket is only used by the server's thread once it's running.
+class ZmqStubServer
+{
+public:
+    ZmqStubServer(int latencyMs)
+        : latencyMs(latencyMs), stopped(false), socket(NULL)
+    {
+        this->socket = zmq_socket(ZmqConnectionPool::GetInstance()->GetContext(), ZMQ_ROUTER);
+        if(this->socket == NULL)
+            return;
+
+        int linger = 0;
+        zmq_setsockopt(this->socket, ZMQ_LINGER, &linger, sizeof(linger));
+
+        char endpoint[256];
+        size_t length = sizeof(endpoint);
+        if(zmq_bind(this->socket, "tcp://127.0.0.1:*") != 0 ||
+                zmq_getsockopt(this->socket, ZMQ_LAST_ENDPOINT, endpoint, &length) != 0)
+        {
+            zmq_close(this->socket);
+            this->socket = NULL;
+            return;
+        }
+
+        this->endpoint = endpoint;
+        this->serverThread = std::thread(&ZmqStubServer::Serve, this);
+    }
+
+    ~ZmqStubServer()
+    {
+        this->stopped = true;
+        if(this->serverThread.joinable())
+            this->serverThread.join();
+    }
+
+    // "tcp://127.0.0.1:port", empty if the server couldn't be started
+    const std::string &GetEndpoint() const { return this->endpoint; }
+
+    // what the server answers to request
+    static std::string Reply(const std::string &request) { return "reply to " + request; }
+
+private:
+    void Serve()
+    {
+        while(!this->stopped)
+        {
+            zmq_pollitem_t item = { this->socket, 0, ZMQ_POLLIN, 0 };
+            if(zmq_poll(&item, 1, 100) <= 0)
+                continue;
+
+            std::vector<std::string> frames;
+            while(ZmqReceiveFrames(this->socket, frames, ZMQ_DONTWAIT))
+            {
+                // [identity][empty][request id][message], or without the id from a REQ socket
+                std::vector<std::string>::iterator delimiter = std::find(frames.begin(), frames.end(), std::string());
+                if(delimiter == frames.end() || frames.end() - delimiter < 2 || frames.end() - delimiter > 3)
+                    continue;
+
+                if(this->latencyMs > 0)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(this->latencyMs));
+
+                frames.back() = Reply(frames.back());
+                ZmqSendFrames(this->socket, frames);
+            }
+        }
+
+        zmq_close(this->socket);
+    }
+
+    const int latencyMs;
+    std::atomic<bool> stopped;
+
+    void* socket;
+    std::string endpoint;
+    std::thread serverThread;
+};
+
+// asks that many escrow servers on localhost for something, rounds times, three ways:
+// a new context and REQ socket for every request like SendData() used to do,
+// the pooled sockets one server after the other, and the pooled sockets all servers at once.
+// every server takes latencyMs to answer, every reply has to match its request.
+bool BtcTest::TestZmqConnectionPool(int servers, int rounds, int latencyMs)
+{
+    std::vector<_SharedPtr<ZmqStubServer> > stubs;
+    std::vector<std::string> peers;
+    for(int s = 0; s < servers; s++)
+    {
+        stubs.push_back(_SharedPtr<ZmqStubServer>(new ZmqStubServer(latencyMs)));
+        if(stubs[s]->GetEndpoint().empty())
+            return false;
+        peers.push_back(stubs[s]->GetEndpoint());
+    }
+
+    ZmqConnectionPool* pool = ZmqConnectionPool::GetInstance();
+    int failures = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int round = 0; round < rounds; round++)
+    {
+        for(int s = 0; s < servers; s++)
+        {
+            const std::string request = "request " + btc::to_string(round) + " " + btc::to_string(s);
+
+            void* context = zmq_init(1);
+            void* socket = zmq_socket(context, ZMQ_REQ);
+            int linger = 0;
+            zmq_setsockopt(socket, ZMQ_LINGER, &linger, sizeof(linger));
+
+            std::vector<std::string> reply;
+            zmq_pollitem_t item = { socket, 0, ZMQ_POLLIN, 0 };
+            if(zmq_connect(socket, peers[s].c_str()) != 0 ||
+                    !ZmqSendFrames(socket, std::vector<std::string>(1, request)) ||
+                    zmq_poll(&item, 1, ZmqConnectionPool::ReplyTimeout) <= 0 ||
+                    !ZmqReceiveFrames(socket, reply) || reply.size() != 1 || reply[0] != ZmqStubServer::Reply(request))
+                failures++;
+
+            zmq_close(socket);
+            zmq_term(context);
+        }
+    }
+    std::chrono::steady_clock::time_point unpooled = std::chrono::steady_clock::now();
+
+    for(int round = 0; round < rounds; round++)
+    {
+        for(int s = 0; s < servers; s++)
+        {
+            const std::string request = "request " + btc::to_string(round) + " " + btc::to_string(s);
+            if(pool->SendRawRequest(peers[s], request) != ZmqStubServer::Reply(request))
+                failures++;
+        }
+    }
+    std::chrono::steady_clock::time_point pooled = std::chrono::steady_clock::now();
+
+    for(int round = 0; round < rounds; round++)
+    {
+        std::vector<std::string> requests;
+        for(int s = 0; s < servers; s++)
+            requests.push_back("request " + btc::to_string(round) + " " + btc::to_string(s));
+
+        std::vector<std::string> replies = pool->SendRawRequests(peers, requests);
+        for(int s = 0; s < servers; s++)
+        {
+            if(replies[s] != ZmqStubServer::Reply(requests[s]))
+                failures++;
+        }
+    }
+    std::chrono::steady_clock::time_point fannedOut = std::chrono::steady_clock::now();
+
+    std::printf("ZmqConnectionPool %d servers x %d rounds, %d ms per request: new socket each time %.2f ms per round, "
+                "pooled one by one %.2f ms, pooled all at once %.2f ms, %d failed\n",
+                servers, rounds, latencyMs,
+                std::chrono::duration_cast<std::chrono::microseconds>(unpooled - start).count() / 1000.0 / rounds,
+                std::chrono::duration_cast<std::chrono::microseconds>(pooled - unpooled).count() / 1000.0 / rounds,
+                std::chrono::duration_cast<std::chrono::microseconds>(fannedOut - pooled).count() / 1000.0 / rounds,
+                failures);
+    std::cout.flush();
+
+    return failures == 0;
+}
+
+// a bitcoind that lives in memory: deposits to any address, blocks are mined on request and
+// spent outputs disappear from listunspent. every call is counted and takes latencyMs,
+// like it would if bitcoind was on the other end of the connection.
+// transactions can also be double spent, or not belong to the wallet (gettransaction doesn't know them).
+class BtcStubJson : public IBtcJson
+{
+public:
+    BtcStubJson(int latencyMs)
+        : latencyMs(latencyMs), height(0), nextAddress(0), calls(0)
+    {
+    }
+
+    // while set, method ("listunspent" or "gettxout") fails like it does when bitcoind is down
+    void SetFailing(const std::string &method, bool failing)
+    {
+        std::lock_guard<std::mutex> lock(this->chainMutex);
+        if(failing)
+            this->failingMethods.insert(method);
+        else
+            this->failingMethods.erase(method);
+    }
+
+    // a new transaction paying amount to address, in the mempool until the next MineBlock()
+    std::string AddDeposit(const std::string &address, int64_t amount)
+    {
+        std::lock_guard<std::mutex> lock(this->chainMutex);
+
+        Transaction tx;
+        tx.address = address;
+        tx.amount = amount;
+        tx.height = 0;
+        tx.spent = false;
+        tx.inWallet = true;
+        tx.conflicted = false;
+
+        std::string txId = "tx" + btc::to_string(static_cast<uint64_t>(this->transactions.size()));
+        this->transactions[txId] = tx;
+        return txId;
+    }
+
+    // like AddDeposit(), but for someone else's wallet
+    std::string AddForeignTransaction(const std::string &address, int64_t amount)
+    {
+        std::string txId = AddDeposit(address, amount);
+
+        std::lock_guard<std::mutex> lock(this->chainMutex);
+        this->transactions[txId].inWallet = false;
+        return txId;
+    }
+
+    // a transaction in the mempool was double spent, it will never be mined
+    void Conflict(const std::string &txId)
+    {
+        std::lock_guard<std::mutex> lock(this->chainMutex);
+        this->transactions[txId].conflicted = true;
+    }
+
+    // the output of txId (always vout 0) is spent from now on
+    void Spend(const std::string &txId)
+    {
+        std::lock_guard<std::mutex> lock(this->chainMutex);
+        this->transactions[txId].spent = true;
+    }
+
+    // puts everything in the mempool into a new block
+    void MineBlock()
+    {
+        std::lock_guard<std::mutex> lock(this->chainMutex);
+
+        this->height++;
+        for(std::map<std::string, Transaction>::iterator tx = this->transactions.begin(); tx != this->transactions.end(); tx++)
+        {
+            if(tx->second.height == 0 && !tx->second.conflicted)
+                tx->second.height = this->height;
+        }
+    }
+
+    int GetCallCount()
+    {
+        std::lock_guard<std::mutex> lock(this->callMutex);
+        return this->calls;
+    }
+
+    int GetCallCount(const std::string &method)
+    {
+        std::lock_guard<std::mutex> lock(this->callMutex);
+        return this->callsByMethod[method];
+    }
+
+    virtual void Initialize() {}
+    virtual void SetPasswordCallback(fastdelegate::FastDelegate0<std::string>) {}
+    virtual BtcInfoPtr GetInfo() { Call("getinfo"); return BtcInfoPtr(); }
+    virtual int64_t GetBalance(const std::string &, const int32_t &, const bool &) { Call("getbalance"); return 0; }
+    virtual std::string GetAccountAddress(const std::string &) { Call("getaccountaddress"); return std::string(); }
+    virtual btc::stringList GetAddressesByAccount(const std::string &) { Call("getaddressesbyaccount"); return btc::stringList(); }
+
+    virtual std::string GetNewAddress(const std::string &)
+    {
+        Call("getnewaddress");
+
+        std::lock_guard<std::mutex> lock(this->chainMutex);
+        return "address" + btc::to_string(this->nextAddress++);
+    }
+
+    virtual bool ImportAddress(const std::string &, const std::string &, const bool &) { Call("importaddress"); return true; }
+    virtual BtcAddressInfoPtr ValidateAddress(const std::string &) { Call("validateaddress"); return BtcAddressInfoPtr(); }
+
+    virtual std::vector<BtcAddressInfoPtr> ValidateAddresses(const btc::stringList &addresses)
+    {
+        Call("validateaddress");
+        return std::vector<BtcAddressInfoPtr>(addresses.size());
+    }
+
+    virtual std::string GetPublicKey(const std::string &address) { Call("validateaddress"); return "pubkey " + address; }
+    virtual std::string GetPrivateKey(const std::string &) { Call("dumpprivkey"); return std::string(); }
+    virtual std::string DumpPrivKey(const std::string &) { Call("dumpprivkey"); return std::string(); }
+
+    virtual BtcMultiSigAddressPtr AddMultiSigAddress(const uint32_t &nRequired, const btc::stringList &keys, const std::string &)
+    {
+        Call("addmultisigaddress");
+        return MakeMultiSig(nRequired, keys);
+    }
+
+    virtual BtcMultiSigAddressPtr CreateMultiSigAddress(const uint32_t &nRequired, const btc::stringList &keys)
+    {
+        Call("createmultisig");
+        return MakeMultiSig(nRequired, keys);
+    }
+
+    virtual std::string GetRedeemScript(const uint32_t &, const btc::stringList &) { Call("createmultisig"); return std::string(); }
+    virtual btc::stringList ListAccounts(const int32_t &, const bool &) { Call("listaccounts"); return btc::stringList(); }
+    virtual BtcAddressBalances ListReceivedByAddress(const int32_t &, const bool &, const bool &) { Call("listreceivedbyaddress"); return BtcAddressBalances(); }
+    virtual BtcTransactions ListTransactions(const std::string &, const int32_t &, const int32_t &, const bool &) { Call("listtransactions"); return BtcTransactions(); }
+
+    virtual BtcUnspentOutputs ListUnspent(const int32_t &minConf, const int32_t &maxConf, const btc::stringList &addresses, bool *ok)
+    {
+        Call("listunspent");
+
+        std::lock_guard<std::mutex> lock(this->chainMutex);
+
+        bool failing = this->failingMethods.count("listunspent") != 0;
+        if(ok != NULL)
+            *ok = !failing;
+        if(failing)
+            return BtcUnspentOutputs();
+
+        std::set<std::string> wanted(addresses.begin(), addresses.end());
+        BtcUnspentOutputs outputs;
+        for(std::map<std::string, Transaction>::iterator tx = this->transactions.begin(); tx != this->transactions.end(); tx++)
+        {
+            int32_t confirmations = Confirmations(tx->second);
+            if(tx->second.spent || tx->second.conflicted || confirmations < minConf || confirmations > maxConf ||
+                    (!wanted.empty() && wanted.find(tx->second.address) == wanted.end()))
+                continue;
+
+            Json::Value output;
+            output["txid"] = tx->first;
+            output["vout"] = 0;
+            output["address"] = tx->second.address;
+            output["scriptPubKey"] = "script " + tx->second.address;
+            output["amount"] = BtcHelper::SatoshisToCoins(tx->second.amount);
+            output["confirmations"] = confirmations;
+            outputs.push_back(BtcUnspentOutputPtr(new BtcUnspentOutput(output)));
+        }
+
+        return outputs;
+    }
+
+    virtual std::string SendToAddress(const std::string &, const int64_t &) { Call("sendtoaddress"); return std::string(); }
+    virtual std::string SendMany(BtcTxTargets, const std::string &) { Call("sendmany"); return std::string(); }
+    virtual bool SetTxFee(const int64_t &) { Call("settxfee"); return false; }
+
+    virtual BtcUnspentOutputPtr GetTxOut(const std::string &txId, const int64_t &vout)
+    {
+        Call("gettxout");
+
+        std::lock_guard<std::mutex> lock(this->chainMutex);
+        return FindTxOut(txId, vout);
+    }
+
+    virtual std::vector<BtcUnspentOutputPtr> GetTxOuts(const BtcUnspentOutputs &outputs, bool *ok)
+    {
+        Call("gettxout");
+
+        std::lock_guard<std::mutex> lock(this->chainMutex);
+
+        bool failing = this->failingMethods.count("gettxout") != 0;
+        if(ok != NULL)
+            *ok = !failing;
+        if(failing)
+            return std::vector<BtcUnspentOutputPtr>(outputs.size());
+
+        std::vector<BtcUnspentOutputPtr> results;
+        for(BtcUnspentOutputs::const_iterator output = outputs.begin(); output != outputs.end(); output++)
+            results.push_back(FindTxOut((*output)->txId, (*output)->vout));
+
+        return results;
+    }
+
+    virtual BtcTransactionPtr GetTransaction(const std::string &txId, const bool &)
+    {
+        Call("gettransaction");
+
+        std::lock_guard<std::mutex> lock(this->chainMutex);
+
+        std::map<std::string, Transaction>::iterator tx = this->transactions.find(txId);
+        if(tx == this->transactions.end() || !tx->second.inWallet)
+            return BtcTransactionPtr();
+
+        Json::Value reply;
+        reply["txid"] = txId;
+        reply["amount"] = BtcHelper::SatoshisToCoins(tx->second.amount);
+        reply["confirmations"] = Confirmations(tx->second);
+        reply["hex"] = txId;        // DecodeRawTransaction() knows what to make of it
+        reply["walletconflicts"] = Json::Value(Json::arrayValue);
+        if(tx->second.conflicted)
+            reply["walletconflicts"].append("double spend of " + txId);
+        return BtcTransactionPtr(new BtcTransaction(reply));
+    }
+
+    // as if bitcoind ran with -txindex=1
+    virtual std::string GetRawTransaction(const std::string &txId)
+    {
+        Call("getrawtransaction");
+
+        std::lock_guard<std::mutex> lock(this->chainMutex);
+        return this->transactions.count(txId) > 0 ? txId : std::string();
+    }
+    virtual BtcRawTransactionPtr GetDecodedRawTransaction(const std::string &txId) { return DecodeRawTransaction(txId); }
+
+    virtual std::vector<BtcRawTransactionPtr> GetDecodedRawTransactions(const btc::stringList &txIds)
+    {
+        std::vector<BtcRawTransactionPtr> results;
+        for(btc::stringList::const_iterator txId = txIds.begin(); txId != txIds.end(); txId++)
+            results.push_back(DecodeRawTransaction(*txId));
+
+        return results;
+    }
+
+    virtual BtcRawTransactionPtr DecodeRawTransaction(const std::string &rawTransaction)
+    {
+        Call("decoderawtransaction");
+
+        std::lock_guard<std::mutex> lock(this->chainMutex);
+
+        std::map<std::string, Transaction>::iterator tx = this->transactions.find(rawTransaction);
+        if(tx == this->transactions.end())
+            return BtcRawTransactionPtr();
+
+        Json::Value output;
+        output["value"] = BtcHelper::SatoshisToCoins(tx->second.amount);
+        output["n"] = 0;
+        output["scriptPubKey"]["hex"] = "script " + tx->second.address;
+        output["scriptPubKey"]["addresses"].append(tx->second.address);
+
+        Json::Value rawTx;
+        rawTx["txid"] = tx->first;
+        rawTx["vout"].append(output);
+        return BtcRawTransactionPtr(new BtcRawTransaction(rawTx));
+    }
+
+    virtual std::string CreateRawTransaction(BtcTxIdVouts, BtcTxTargets) { Call("createrawtransaction"); return std::string(); }
+    virtual BtcSignedTransactionPtr SignRawTransaction(const std::string &, const BtcSigningPrerequisites &, const btc::stringList &) { Call("signrawtransaction"); return BtcSignedTransactionPtr(); }
+    virtual BtcSignedTransactionPtr CombineSignedTransactions(const std::string &) { Call("signrawtransaction"); return BtcSignedTransactionPtr(); }
+    virtual std::string SendRawTransaction(const std::string &, const bool &) { Call("sendrawtransaction"); return std::string(); }
+
+    virtual btc::stringList GetRawMemPool()
+    {
+        Call("getrawmempool");
+
+        std::lock_guard<std::mutex> lock(this->chainMutex);
+
+        btc::stringList txIds;
+        for(std::map<std::string, Transaction>::iterator tx = this->transactions.begin(); tx != this->transactions.end(); tx++)
+        {
+            if(tx->second.height == 0 && !tx->second.conflicted)
+                txIds.push_back(tx->first);
+        }
+
+        return txIds;
+    }
+
+    virtual BtcMemPoolInfoPtr GetMemPoolInfo()
+    {
+        Call("getmempoolinfo");
+
+        std::lock_guard<std::mutex> lock(this->chainMutex);
+
+        int64_t size = 0;
+        for(std::map<std::string, Transaction>::iterator tx = this->transactions.begin(); tx != this->transactions.end(); tx++)
+        {
+            if(tx->second.height == 0)
+                size++;
+        }
+
+        Json::Value result;
+        result["size"] = static_cast<Json::Int64>(size);
+        result["bytes"] = static_cast<Json::Int64>(size * 250);
+        return BtcMemPoolInfoPtr(new BtcMemPoolInfo(result));
+    }
+
+    virtual int32_t GetBlockCount()
+    {
+        Call("getblockcount");
+
+        std::lock_guard<std::mutex> lock(this->chainMutex);
+        return this->height;
+    }
+
+    virtual std::string GetBlockHash(const int32_t &blockNumber) { Call("getblockhash"); return "block" + btc::to_string(blockNumber); }
+
+    virtual std::string GetBestBlockHash()
+    {
+        Call("getbestblockhash");
+
+        std::lock_guard<std::mutex> lock(this->chainMutex);
+        return "block" + btc::to_string(this->height);
+    }
+
+    virtual BtcBlockPtr GetBlock(const std::string &blockHash)
+    {
+        Call("getblock");
+
+        std::lock_guard<std::mutex> lock(this->chainMutex);
+
+        if(blockHash.compare(0, 5, "block") != 0)
+            return BtcBlockPtr();
+
+        int32_t blockHeight = std::atoi(blockHash.c_str() + 5);
+        if(blockHeight < 0 || blockHeight > this->height)
+            return BtcBlockPtr();
+
+        Json::Value block;
+        block["hash"] = blockHash;
+        block["height"] = blockHeight;
+        block["confirmations"] = this->height - blockHeight + 1;
+        if(blockHeight > 0)
+            block["previousblockhash"] = "block" + btc::to_string(blockHeight - 1);
+        block["tx"] = Json::Value(Json::arrayValue);
+        for(std::map<std::string, Transaction>::iterator tx = this->transactions.begin(); tx != this->transactions.end(); tx++)
+        {
+            if(tx->second.height == blockHeight)
+                block["tx"].append(tx->first);
+        }
+
+        return BtcBlockPtr(new BtcBlock(block));
+    }
+    virtual bool SetGenerate(const bool &) { Call("setgenerate"); return false; }
+    virtual bool WalletPassphrase(const std::string &, const time_t &) { Call("walletpassphrase"); return false; }
+
+private:
+    struct Transaction
+    {
+        std::string address;
+        int64_t amount;
+        int32_t height;     // 0 while in the mempool
+        bool spent;
+        bool inWallet;      // gettransaction knows it
+        bool conflicted;    // double spent before it was mined
+    };
+
+    void Call(const std::string &method)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->callMutex);
+            this->calls++;
+            this->callsByMethod[method]++;
+        }
+
+        if(this->latencyMs > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(this->latencyMs));
+    }
+
+    // chainMutex has to be locked
+    int32_t Confirmations(const Transaction &tx)
+    {
+        if(tx.conflicted)
+            return -1;  // what bitcoind says for a wallet transaction that lost a double spend
+
+        return tx.height == 0 ? 0 : this->height - tx.height + 1;
+    }
+
+    // chainMutex has to be locked
+    BtcUnspentOutputPtr FindTxOut(const std::string &txId, int64_t vout)
+    {
+        std::map<std::string, Transaction>::iterator tx = this->transactions.find(txId);
+        if(tx == this->transactions.end() || tx->second.spent || tx->second.conflicted || vout != 0)
+            return BtcUnspentOutputPtr();
+
+        Json::Value output;
+        output["txid"] = txId;
+        output["vout"] = 0;
+        output["value"] = BtcHelper::SatoshisToCoins(tx->second.amount);
+        output["confirmations"] = Confirmations(tx->second);
+        output["scriptPubKey"]["hex"] = "script " + tx->second.address;
+        output["scriptPubKey"]["addresses"].append(tx->second.address);
+        return BtcUnspentOutputPtr(new BtcUnspentOutput(output));
+    }
+
+    static BtcMultiSigAddressPtr MakeMultiSig(uint32_t nRequired, const btc::stringList &keys)
+    {
+        std::string address = "multisig " + btc::to_string(nRequired);
+        for(btc::stringList::const_iterator key = keys.begin(); key != keys.end(); key++)
+            address += " " + (*key);
+
+        Json::Value result;
+        result["address"] = address;
+        result["redeemScript"] = "redeem " + address;
+        return BtcMultiSigAddressPtr(new BtcMultiSigAddress(result, keys));
+    }
+
+    const int latencyMs;
+
+    std::mutex chainMutex;
+    std::map<std::string, Transaction> transactions;
+    int32_t height;
+    int32_t nextAddress;
+    std::set<std::string> failingMethods;
+
+    std::mutex callMutex;
+    int calls;
+    std::map<std::string, int> callsByMethod;
+};
+
+// an escrow server with many clients running against BtcStubJson: the clients ask for deposit addresses,
+// pay to them, the deposits confirm and some are spent. the server does what its loop and CheckTxDaemon would do.
+// for each step the time it took, the cpu time and the bitcoind calls are printed,
+// the time minus calls * latencyMs is what the server spent on its own.
+bool BtcTest::TestEscrowServerSimulation(int clients, int latencyMs, const std::string &journalPath)
+{
+    std::remove(journalPath.c_str());
+
+    // the server connects on its own on construction, give it something to talk to
+    BtcStubBitcoind stubRpc(0);
+    if(stubRpc.GetPort() == 0)
+        return false;
+
+    // a pool of one, so the multisig addresses are 1-of-1 and no other server has to answer.
+    // not added with AddEscrowServer(), that would start the server loop on a thread of its own
+    EscrowPoolPtr pool = EscrowPoolPtr(new EscrowPool(1));
+    SampleEscrowServerPtr server = SampleEscrowServerPtr(new SampleEscrowServer(
+                BitcoinServerPtr(new BitcoinServer("admin1", "123", "http://127.0.0.1", stubRpc.GetPort())), pool));
+    pool->escrowServers.append(server);
+
+    _SharedPtr<BtcStubJson> stub = _SharedPtr<BtcStubJson>(new BtcStubJson(latencyMs));
+    server->modules->btcJson = stub;
+
+    if(!server->SetLedgerFile(journalPath))
+        return false;
+
+    std::vector<std::string> clientNames;
+    for(int i = 0; i < clients; i++)
+    {
+        clientNames.push_back("client" + btc::to_string(i));
+        server->clientList[clientNames[i]] = SampleEscrowClientPtr();
+    }
+
+    const int64_t amount = 10 * BtcHelper::FeeMultiSig;
+    bool success = true;
+
+    struct Step
+    {
+        std::chrono::steady_clock::time_point start;
+        std::clock_t cpuStart;
+        int callsStart;
+    } step;
+
+    auto startStep = [&]()
+    {
+        step.start = std::chrono::steady_clock::now();
+        step.cpuStart = std::clock();
+        step.callsStart = stub->GetCallCount();
+    };
+
+    auto endStep = [&](const char* name)
+    {
+        long long wallMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - step.start).count();
+        double cpuMs = 1000.0 * (std::clock() - step.cpuStart) / CLOCKS_PER_SEC;
+        int calls = stub->GetCallCount() - step.callsStart;
+
+        std::printf("EscrowServer %d clients, %d ms per call, %s: %lld ms, %lld ms without bitcoind, %.1f ms cpu, %d calls\n",
+                    clients, latencyMs, name, wallMs, wallMs - static_cast<long long>(calls) * latencyMs, cpuMs, calls);
+        std::cout.flush();
+    };
+
+    // what CheckTxDaemon does each time it wakes up, returns true if the deposits were checked.
+    // retry is set while bitcoind couldn't answer, like the daemon the next poll checks again then
+    bool retry = false;
+    auto poll = [&]() -> bool
+    {
+        bool newBlock = false;
+        if(!server->ChainStateChanged(newBlock) && !retry)
+            return false;
+
+        retry = !server->CheckTransactions(newBlock || retry);
+        return true;
+    };
+
+    // every client asks for an address, the server loop creates a key and the multisig for each
+    startStep();
+    for(int i = 0; i < clients; i++)
+    {
+        if(!server->RequestEscrowDeposit(clientNames[i], amount))
+            success = false;
+    }
+    server->Update();
+    endStep("deposit addresses");
+
+    std::vector<std::string> addresses;
+    for(int i = 0; i < clients && success; i++)
+    {
+        addresses.push_back(server->RequestDepositAddress(clientNames[i]));
+        if(addresses[i].empty() || server->addressToClientMap[addresses[i]] != clientNames[i])
+            success = false;
+    }
+
+    if(success && stub->GetCallCount("addmultisigaddress") != clients)
+        success = false;
+
+    // everyone pays, the deposits show up while they're in the mempool
+    std::vector<std::string> txIds;
+    if(success)
+    {
+        for(int i = 0; i < clients; i++)
+            txIds.push_back(stub->AddDeposit(addresses[i], amount));
+
+        startStep();
+        if(!poll())
+            success = false;
+        endStep("deposits in mempool");
+    }
+
+    for(int i = 0; i < clients && success; i++)
+    {
+        SampleEscrowTransactions deposits = server->ledger->GetDeposits(clientNames[i]);
+        if(deposits.size() != 1 || deposits.front()->status != SampleEscrowTransaction::Pending || server->GetClientBalance(clientNames[i]) != 0)
+            success = false;
+    }
+
+    // two blocks later they're confirmed
+    for(int block = 0; block < 2 && success; block++)
+    {
+        stub->MineBlock();
+
+        startStep();
+        if(!poll())
+            success = false;
+        endStep(block == 0 ? "1st confirmation" : "2nd confirmation");
+    }
+
+    for(int i = 0; i < clients && success; i++)
+    {
+        if(server->GetClientBalance(clientNames[i]) != amount)
+            success = false;
+    }
+
+    // nothing happens on the chain, the polls must be cheap
+    if(success)
+    {
+        const int idlePolls = 10;
+
+        startStep();
+        int callsBefore = stub->GetCallCount();
+        for(int p = 0; p < idlePolls; p++)
+        {
+            if(poll())
+                success = false;
+        }
+        endStep("idle polls");
+
+        if(stub->GetCallCount() - callsBefore != 2 * idlePolls)
+            success = false;
+    }
+
+    // every tenth deposit is spent, but bitcoind fails to answer listunspent and then the gettxout batch.
+    // neither may look like a spent deposit, the books and the unspent outputs have to stay as they are
+    if(success)
+    {
+        for(int i = 0; i < clients; i += 10)
+            stub->Spend(txIds[i]);
+        stub->MineBlock();
+
+        size_t utxoCount = server->utxos->size();
+        const char* failingMethods[] = { "listunspent", "gettxout" };
+        for(int f = 0; f < 2 && success; f++)
+        {
+            stub->SetFailing(failingMethods[f], true);
+
+            startStep();
+            if(!poll() || !retry)
+                success = false;
+            endStep(f == 0 ? "listunspent failed" : "gettxout failed");
+
+            stub->SetFailing(failingMethods[f], false);
+
+            if(server->utxos->size() != utxoCount)
+                success = false;
+            for(int i = 0; i < clients && success; i++)
+            {
+                if(server->ledger->GetDeposits(clientNames[i]).size() != 1 || server->GetClientBalance(clientNames[i]) != amount)
+                    success = false;
+            }
+        }
+    }
+
+    // once bitcoind is back the next poll removes them with one listunspent and one gettxout batch
+    if(success)
+    {
+        int listUnspentBefore = stub->GetCallCount("listunspent");
+        int getTxOutBefore = stub->GetCallCount("gettxout");
+
+        startStep();
+        if(!poll())
+            success = false;
+        endStep("spent deposits");
+
+        if(stub->GetCallCount("listunspent") - listUnspentBefore != 1 || stub->GetCallCount("gettxout") - getTxOutBefore != 1)
+            success = false;
+    }
+
+    for(int i = 0; i < clients && success; i++)
+    {
+        size_t expected = i % 10 == 0 ? 0 : 1;
+        if(server->ledger->GetDeposits(clientNames[i]).size() != expected ||
+                server->GetClientBalance(clientNames[i]) != (expected == 0 ? 0 : amount))
+            success = false;
+    }
+
+    // the pool and the server point at each other
+    pool->escrowServers.clear();
+    server.reset();
+
+    std::remove(journalPath.c_str());
+    return success;
+}
+
+// confirmations of wallet transactions, of other people's transactions (found in the block index or
+// further down the chain), of a double spent one and of a txid that doesn't exist.
+// only the ones that are really in a block deep enough may count as confirmed.
+bool BtcTest::TestConfirmations()
+{
+    _SharedPtr<BtcStubJson> stub = _SharedPtr<BtcStubJson>(new BtcStubJson(0));
+    BtcModulesPtr stubModules = BtcModulesPtr(new BtcModules());
+    stubModules->btcJson = stub;
+    BtcHelperPtr helper = stubModules->btcHelper;
+
+    stub->MineBlock();
+    const std::string oldForeignTx = stub->AddForeignTransaction("someone", BtcHelper::FeeMultiSig);
+    stub->MineBlock();
+
+    // deeper than the block index and BlockSearchDepth together
+    const int32_t chainLength = BtcBlockIndex::DefaultMaxDepth + BtcHelper::BlockSearchDepth + 10;
+    for(int32_t block = 0; block < chainLength; block++)
+        stub->MineBlock();
+
+    const std::string walletTx = stub->AddDeposit("me", BtcHelper::FeeMultiSig);
+    const std::string recentForeignTx = stub->AddForeignTransaction("someone", BtcHelper::FeeMultiSig);
+    const std::string conflictedTx = stub->AddDeposit("me", BtcHelper::FeeMultiSig);
+    stub->Conflict(conflictedTx);
+    for(int32_t block = 0; block < 3; block++)
+        stub->MineBlock();
+    const std::string unconfirmedTx = stub->AddDeposit("me", BtcHelper::FeeMultiSig);
+
+    bool deeper = false;
+    bool success = true;
+
+    if(helper->GetConfirmations(walletTx) != 3 || !helper->TransactionConfirmed(walletTx, 3) || helper->TransactionConfirmed(walletTx, 4))
+        success = false;
+
+    if(helper->GetConfirmations(recentForeignTx, BtcHelper::BlockSearchDepth, &deeper) != 3 || deeper ||
+            !helper->TransactionConfirmed(recentForeignTx, 3))
+        success = false;
+
+    if(helper->GetConfirmations(unconfirmedTx) != 0 || helper->TransactionConfirmed(unconfirmedTx, 1))
+        success = false;
+
+    // bitcoind says -1, which is no number of confirmations at all
+    if(helper->GetConfirmations(conflictedTx) >= 0 || helper->TransactionConfirmed(conflictedTx, 1) ||
+            helper->TransactionConfirmed(conflictedTx, 0) || stubModules->mtBitcoin->GetConfirmations(conflictedTx) != 0)
+        success = false;
+
+    // not anywhere in the chain, it's searched for as deep as a real one would be
+    if(helper->GetConfirmations("nosuchtx", BtcHelper::BlockSearchDepth, &deeper) != 0 || !deeper ||
+            helper->TransactionConfirmed("nosuchtx", 1))
+        success = false;
+
+    // too deep to count, but bitcoind knows it so it's in one of the older blocks
+    if(helper->GetConfirmations(oldForeignTx, BtcHelper::BlockSearchDepth, &deeper) != 0 || !deeper ||
+            !helper->TransactionConfirmed(oldForeignTx, 1) || stubModules->mtBitcoin->GetConfirmations(oldForeignTx) != -1)
+        success = false;
+
+    std::printf("Confirmations over %d blocks: wallet, foreign, deep, conflicted and unknown transactions %s\n",
+                chainLength + 5, success ? "ok" : "wrong");
+    std::cout.flush();
+
+    return success;
+}
+
+bool BtcTest::TestBtcJson()
+{
+    BitcoinServerPtr bitcoind1 = BitcoinServerPtr(new BitcoinServer("admin1", "123", "http://127.0.0.1", 19001));
+
+    // connect to server
+    if(!modules->btcRpc->ConnectToBitcoin(bitcoind1))
+        return false;
+
+    // see if we can get some response:
+    std::string address = modules->btcJson->GetNewAddress();
+    if(address.empty())
+        return false;
+
+    // disconnect
+    modules->btcRpc->ConnectToBitcoin(BitcoinServerPtr(new BitcoinServer("bla", "bla", "url", 123)));
+
+    // try again
+    address = modules->btcJson->GetNewAddress();
+    if(!address.empty())
+        return false;
+
+    // reconnect
+    if(!modules->btcRpc->ConnectToBitcoin(bitcoind1))
+        return false;
+
+    address = modules->btcJson->GetNewAddress();
+
+    std::string txid;
+    if((txid = modules->btcJson->SendToAddress(address, BtcHelper::CoinsToSatoshis(10))).empty())
+        return false;
+
+    // even when testing locally it takes a few ms
+    if(modules->btcHelper->WaitGetTransaction(txid) == NULL)
+        return false;
+
+    // list unspent outputs
+    BtcUnspentOutputs unspentOutputs = modules->btcJson->ListUnspent(/*optional*/);
+    if(unspentOutputs.empty())
+        return false;
+
+    // now to spend an output
+    // create a list of txid/vout pairs as input for our raw transaction:
+    BtcTxIdVouts outputsToSpend;
+    outputsToSpend.push_back(BtcTxIdVoutPtr(new BtcTxIdVout(unspentOutputs.front()->txId, unspentOutputs.front()->vout)));
+
+    // create a list of address:vout mappings to which the inputs will be sent
+    BtcTxTargets txTargets;
+    txTargets[address] = (Json::Int64)(unspentOutputs.front()->amount - BtcHelper::FeeMultiSig);
+
+    // create raw transaction
+    std::string rawTx = modules->btcJson->CreateRawTransaction(outputsToSpend, txTargets);
+    BtcSignedTransactionPtr signedTx = modules->btcJson->SignRawTransaction(rawTx);
+    if(modules->btcJson->SendRawTransaction(signedTx->signedTransaction).empty())
+        return false;
+
+    // TODO: Test all the other functions. Nah, they should be safe to use.
+
+    return true;
+}
+
+// a stub bitcoind that knows gettxout for made up outputs: txids starting with "spent" are spent,
+// "error" ones fail, "lost" ones get no reply at all and a batch with a "reject" txid fails as a whole.
+// the replies to a batch come back in reverse order, they have to be sorted by id.
+// checks the outputs one call at a time and then in one batch, the results have to match. prints how long both took.
+bool BtcTest::TestBtcJsonBatch(int outputCount, int latencyMs)
+{
+    auto gettxout = [](const Json::Value &call) -> Json::Value
+    {
+        Json::Value reply;
+        reply["id"] = call["id"];
+        reply["result"] = Json::Value();
+        reply["error"] = Json::Value();
+
+        const std::string txId = call["params"][0].asString();
+        const Json::Int64 vout = call["params"][1].asInt64();
+        if(txId.compare(0, 5, "error") == 0)
+        {
+            reply["error"]["code"] = -5;
+            reply["error"]["message"] = "No such mempool or blockchain transaction";
+        }
+        else if(txId.compare(0, 5, "spent") != 0)
+        {
+            reply["result"]["value"] = BtcHelper::SatoshisToCoins((vout + 1) * 1000);
+            reply["result"]["confirmations"] = 3;
+            reply["result"]["scriptPubKey"]["hex"] = "script " + txId;
+            reply["result"]["scriptPubKey"]["addresses"].append("address " + txId);
+        }
+        return reply;
+    };
+
+    BtcStubBitcoind stub(latencyMs, [&gettxout](const std::string &request) -> std::string
+    {
+        Json::Value calls;
+        Json::Reader reader;
+        if(!reader.parse(request, calls))
+            return std::string();
+
+        Json::FastWriter writer;
+        if(calls.isObject())
+            return calls["method"] == "gettxout" ? writer.write(gettxout(calls)) : std::string();
+
+        Json::Value replies = Json::Value(Json::arrayValue);
+        for(Json::Value::ArrayIndex i = calls.size(); i-- > 0; )
+        {
+            const std::string txId = calls[i]["params"][0].asString();
+            if(txId == "reject")
+            {
+                Json::Value reply;
+                reply["id"] = Json::Value();
+                reply["result"] = Json::Value();
+                reply["error"]["code"] = -32600;
+                reply["error"]["message"] = "Invalid Request object";
+                return writer.write(reply);
+            }
+
+            if(txId.compare(0, 4, "lost") != 0)
+                replies.append(gettxout(calls[i]));
+        }
+        return writer.write(replies);
+    });
+    if(stub.GetPort() == 0)
+        return false;
+
+    BtcModulesPtr stubModules = BtcModulesPtr(new BtcModules());
+    if(!stubModules->btcRpc->ConnectToBitcoin(BitcoinServerPtr(new BitcoinServer("admin1", "123", "http://127.0.0.1", stub.GetPort()))))
+        return false;
+
+    auto makeOutput = [](const std::string &txId, int64_t vout) -> BtcUnspentOutputPtr
+    {
+        BtcUnspentOutputPtr output = BtcUnspentOutputPtr(new BtcUnspentOutput(Json::Value()));
+        output->txId = txId;
+        output->vout = vout;
+        return output;
+    };
+
+    // what gettxout says about output, NULL if it's spent
+    auto matches = [](BtcUnspentOutputPtr asked, BtcUnspentOutputPtr output) -> bool
+    {
+        if(asked->txId.compare(0, 5, "spent") == 0)
+            return output == NULL;
+        return output != NULL && output->txId == asked->txId && output->vout == asked->vout &&
+                output->amount == (asked->vout + 1) * 1000 && output->address == "address " + asked->txId;
+    };
+
+    std::vector<BtcUnspentOutputPtr> outputList;
+    for(int i = 0; i < outputCount; i++)
+        outputList.push_back(makeOutput((i % 3 == 0 ? "spent" : "unspent") + btc::to_string(i), i));
+    const BtcUnspentOutputs outputs(outputList.begin(), outputList.end());
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    bool success = true;
+    for(size_t i = 0; i < outputList.size(); i++)
+    {
+        if(!matches(outputList[i], stubModules->btcJson->GetTxOut(outputList[i]->txId, outputList[i]->vout)))
+            success = false;
+    }
+
+    std::chrono::steady_clock::time_point single = std::chrono::steady_clock::now();
+
+    int requestsBefore = stub.GetRequestCount();
+    bool ok = false;
+    std::vector<BtcUnspentOutputPtr> batchOutputs = stubModules->btcJson->GetTxOuts(outputs, &ok);
+
+    std::chrono::steady_clock::time_point batch = std::chrono::steady_clock::now();
+
+    if(!ok || batchOutputs.size() != outputs.size() || stub.GetRequestCount() - requestsBefore != 1)
+        success = false;
+    for(size_t i = 0; i < batchOutputs.size() && success; i++)
+    {
+        if(!matches(outputList[i], batchOutputs[i]))
+            success = false;
+    }
+
+    // a call that fails or isn't answered is NULL like a spent output, but the batch isn't ok then.
+    // the other outputs still get their results
+    std::vector<BtcUnspentOutputPtr> partialList = outputList;
+    partialList.insert(partialList.begin() + partialList.size() / 2, makeOutput("error", 0));
+    partialList.insert(partialList.begin() + 1, makeOutput("lost", 0));
+
+    batchOutputs = stubModules->btcJson->GetTxOuts(BtcUnspentOutputs(partialList.begin(), partialList.end()), &ok);
+    if(ok || batchOutputs.size() != partialList.size())
+        success = false;
+    for(size_t i = 0; i < batchOutputs.size() && success; i++)
+    {
+        if(partialList[i]->txId == "error" || partialList[i]->txId == "lost")
+        {
+            if(batchOutputs[i] != NULL)
+                success = false;
+        }
+        else if(!matches(partialList[i], batchOutputs[i]))
+            success = false;
+    }
+
+    // bitcoind refuses the whole batch
+    BtcUnspentOutputs rejected = outputs;
+    rejected.back() = makeOutput("reject", 0);
+
+    batchOutputs = stubModules->btcJson->GetTxOuts(rejected, &ok);
+    if(ok || batchOutputs.size() != rejected.size() ||
+            std::count(batchOutputs.begin(), batchOutputs.end(), BtcUnspentOutputPtr()) != static_cast<long>(rejected.size()))
+        success = false;
+
+    std::printf("gettxout for %d outputs, %d ms per call: %d round trips in %lld ms, batched 1 round trip in %lld ms, "
+                "out of order, failed and missing replies %s\n",
+                outputCount, latencyMs, outputCount,
+                static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(single - start).count()),
+                static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(batch - single).count()),
+                success ? "ok" : "wrong");
+    std::cout.flush();
+
+    return success;
+}
+
 bool BtcTest::TestRawTransactions()
 {
     BitcoinServerPtr bitcoind1 = BitcoinServerPtr(new BitcoinServer("admin1", "123", "http://127.0.0.1", 19001));
@@ -13,8 +13,34 @@ public:
     static bool TestBitcoinFunctions();
 
 private:
+    static bool TestBtcRpcPacket();
+
+    static bool TestCoinSelection(int wallets);
+
+    static bool CheckCoinSelection(const BtcUnspentOutputs &available, int64_t amount, const BtcCoinSelectionParams &params, BtcCoinSelectionPtr selection);
+
+    static bool TestUtxoSet();
+
+    static bool TestNetFrames(int rounds);
+
+    static bool TestNetFrameThroughput(int txCount, int rounds);
+
+    static bool TestEscrowLedger(int clients, const std::string &journalPath);
+
+    static bool TestEscrowLedgerJournal(const std::string &journalPath);
+
     static bool TestBtcRpc();
 
+    static bool TestBtcRpcConcurrency(int threads, int callsPerThread, int latencyMs);
+
+    static bool TestZmqConnectionPool(int servers, int rounds, int latencyMs);
+
+    static bool TestEscrowServerSimulation(int clients, int latencyMs, const std::string &journalPath);
+
+    static bool TestConfirmations();
+
+    static bool TestBtcJsonBatch(int outputCount, int latencyMs);
+
     static bool TestBtcJson();
 
     static bool TestRawTransactions();
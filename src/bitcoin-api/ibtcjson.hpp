@@ -81,6 +81,10 @@ public:
     // This function is quite slow so use in moderation
     virtual BtcAddressInfoPtr ValidateAddress(const std::string &address) = 0;
 
+    // Validates all addresses with one call to bitcoind
+    // returns one entry per address, in the same order, NULL where that address failed
+    virtual std::vector<BtcAddressInfoPtr> ValidateAddresses(const btc::stringList &addresses) = 0;
+
     virtual std::string GetPublicKey(const std::string& address) = 0;
 
     // Get private key for address (calls DumpPrivKey())
@@ -116,7 +120,8 @@ public:
 
     // Returns vector of unspent outputs
     // does not work with non-wallet addresses (multisig)
-    virtual BtcUnspentOutputs ListUnspent(const int32_t &minConf = BtcHelper::MinConfirms, const int32_t &maxConf = BtcHelper::MaxConfirms, const btc::stringList &addresses = btc::stringList()) = 0;
+    // ok is set to false if bitcoind couldn't be asked, the list is empty then but that doesn't mean nothing is unspent
+    virtual BtcUnspentOutputs ListUnspent(const int32_t &minConf = BtcHelper::MinConfirms, const int32_t &maxConf = BtcHelper::MaxConfirms, const btc::stringList &addresses = btc::stringList(), bool *ok = NULL) = 0;
 
     virtual std::string SendToAddress(const std::string &btcAddress, const int64_t &amount) = 0;
 
@@ -128,12 +133,21 @@ public:
 
     virtual BtcUnspentOutputPtr GetTxOut(const std::string &txId, const int64_t &vout) = 0;
 
+    // gettxout for each output's txId and vout, with one call to bitcoind
+    // returns one entry per output, in the same order, NULL where it's spent or unknown
+    // ok is set to false if the batch or any call in it failed, a NULL entry doesn't mean spent then
+    virtual std::vector<BtcUnspentOutputPtr> GetTxOuts(const BtcUnspentOutputs &outputs, bool *ok = NULL) = 0;
+
     virtual BtcTransactionPtr GetTransaction(const std::string &txId, const bool& includeWatchonly = true) = 0;
 
     virtual std::string GetRawTransaction(const std::string &txId) = 0;
 
     virtual BtcRawTransactionPtr GetDecodedRawTransaction(const std::string &txId) = 0;
 
+    // Same as above for each txId, with one call to bitcoind
+    // returns one entry per txId, in the same order, NULL where it wasn't found
+    virtual std::vector<BtcRawTransactionPtr> GetDecodedRawTransactions(const btc::stringList &txIds) = 0;
+
     virtual BtcRawTransactionPtr DecodeRawTransaction(const std::string &rawTransaction) = 0;
 
     virtual std::string CreateRawTransaction(BtcTxIdVouts unspentOutputs, BtcTxTargets txTargets) = 0;
@@ -146,10 +160,14 @@ public:
 
     virtual btc::stringList GetRawMemPool() = 0;
 
+    virtual BtcMemPoolInfoPtr GetMemPoolInfo() = 0;
+
     virtual int32_t GetBlockCount() = 0;
 
     virtual std::string GetBlockHash(const int32_t &blockNumber) = 0;
 
+    virtual std::string GetBestBlockHash() = 0;
+
     virtual BtcBlockPtr GetBlock(const std::string &blockHash) = 0;
 
     virtual bool SetGenerate(const bool &generate) = 0;
@@ -84,6 +84,11 @@ public:
     // sends an array of a certain size over the network
     // returns reply
     virtual BtcRpcPacketPtr SendRpc(BtcRpcPacketPtr jsonString) = 0;
+
+    // Limits how many calls can be talking to one bitcoind at once.
+    // SendRpc() can be called from several threads, the rest wait their turn.
+    virtual void SetMaxConnections(size_t connections) = 0;
+    virtual size_t GetMaxConnections() = 0;
 };
 
 typedef _SharedPtr<IBtcRpc> IBtcRpcPtr;
@@ -90,6 +90,7 @@ public:
     virtual BtcRawTransactionPtr WaitGetRawTransaction(const std::string &txId) = 0;
 
     // Returns the number of confirmations of a raw transaction
+    // -1 if it's older than the blocks that were searched (or unknown), 0 if it's conflicted
     virtual int32_t GetConfirmations(const std::string &txId) = 0;
 
     // Checks whether transaction sends correct amount and is confirmed
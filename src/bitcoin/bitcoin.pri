@@ -1,5 +1,6 @@
 
 HEADERS += \
+    $${PWD}/escrowledger.hpp \
     $${PWD}/escrowpool.hpp \
     $${PWD}/poolmanager.hpp \
     $${PWD}/sampleescrowclient.hpp \
@@ -9,9 +10,11 @@ HEADERS += \
     $${PWD}/samplenetmessages.hpp \
     $${PWD}/sampleescrowtransaction.hpp \
     $${PWD}/sampletypedefs.hpp \
-    $${PWD}/transactionmanager.hpp
+    $${PWD}/transactionmanager.hpp \
+    $${PWD}/zmqconnectionpool.hpp
 
 SOURCES += \
+    $${PWD}/escrowledger.cpp \
     $${PWD}/escrowpool.cpp \
     $${PWD}/poolmanager.cpp \
     $${PWD}/sampleescrowclient.cpp \
@@ -20,4 +23,5 @@ SOURCES += \
     $${PWD}/sampleescrowserverzmq.cpp \
     $${PWD}/samplenetmessages.cpp \
     $${PWD}/sampleescrowtransaction.cpp \
-    $${PWD}/transactionmanager.cpp
+    $${PWD}/transactionmanager.cpp \
+    $${PWD}/zmqconnectionpool.cpp
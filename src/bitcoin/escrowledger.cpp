@@ -0,0 +1,748 @@
+#ifndef __STABLE_HPP__
+#include <core/stable.hpp>
+#endif
+
+#include <bitcoin/escrowledger.hpp>
+
+#include <QMutex>
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <set>
+#include <sstream>
+
+// first line of the journal, bump it if the format changes
+#define JOURNAL_HEADER "escrowledger 2"
+#define JOURNAL_HEADER_V1 "escrowledger 1"     // fields weren't escaped yet
+
+// the journal is split by spaces. client names come from the network, so every string is escaped:
+// spaces, control characters, non-ascii bytes and '%' become %XX, empty strings are written as "-"
+static std::string ToField(const std::string &value)
+{
+    if(value.empty())
+        return "-";
+    if(value == "-")
+        return "%2D";
+
+    static const char hexDigits[] = "0123456789ABCDEF";
+
+    std::string field;
+    field.reserve(value.size());
+    for(std::string::const_iterator c = value.begin(); c != value.end(); c++)
+    {
+        unsigned char byte = static_cast<unsigned char>(*c);
+        if(byte <= ' ' || byte >= 0x7F || byte == '%')
+        {
+            field += '%';
+            field += hexDigits[byte >> 4];
+            field += hexDigits[byte & 0x0F];
+        }
+        else
+            field += (*c);
+    }
+
+    return field;
+}
+
+static int HexValue(char c)
+{
+    if(c >= '0' && c <= '9')
+        return c - '0';
+    if(c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    if(c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+
+// returns false if field isn't something ToField() wrote
+static bool FromField(const std::string &field, std::string &value, bool escaped)
+{
+    value.clear();
+    if(field == "-")
+        return true;
+    if(!escaped)
+    {
+        value = field;
+        return true;
+    }
+
+    value.reserve(field.size());
+    for(size_t i = 0; i < field.size(); i++)
+    {
+        if(field[i] != '%')
+        {
+            value += field[i];
+            continue;
+        }
+
+        if(i + 2 >= field.size())
+            return false;
+        int high = HexValue(field[i + 1]), low = HexValue(field[i + 2]);
+        if(high < 0 || low < 0)
+            return false;
+        value += static_cast<char>(high * 16 + low);
+        i += 2;
+    }
+
+    return true;
+}
+
+// keeps a copy of a journal that had lines we couldn't read, before it's rewritten without them
+static bool BackUpFile(const std::string &path, const std::string &backupPath)
+{
+    std::ifstream source(path.c_str(), std::ios::in | std::ios::binary);
+    std::ofstream backup(backupPath.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+    if(!source.is_open() || !backup.is_open())
+        return false;
+
+    backup << source.rdbuf();
+    return backup.good();
+}
+
+
+EscrowLedger::EscrowLedger(BtcModulesPtr modules, size_t stripeCount)
+{
+    this->modules = modules;
+
+    this->stripes.resize(stripeCount > 0 ? stripeCount : DefaultStripeCount);
+    for(std::vector<Stripe>::iterator stripe = this->stripes.begin(); stripe != this->stripes.end(); stripe++)
+        stripe->mutex = new QMutex();
+
+    this->journalMutex = new QMutex();
+    this->journalFailed = false;
+}
+
+EscrowLedger::~EscrowLedger()
+{
+    for(std::vector<Stripe>::iterator stripe = this->stripes.begin(); stripe != this->stripes.end(); stripe++)
+    {
+        delete stripe->mutex;
+        stripe->mutex = NULL;
+    }
+
+    this->journal.close();
+    delete this->journalMutex;
+    this->journalMutex = NULL;
+}
+
+EscrowLedger::Stripe &EscrowLedger::GetStripe(const std::string &key)
+{
+    return this->stripes[std::hash<std::string>()(key) % this->stripes.size()];
+}
+
+std::string EscrowLedger::OutPoint(const std::string &txId, int32_t vout)
+{
+    return txId + ":" + btc::to_string(vout);
+}
+
+bool EscrowLedger::SetJournalFile(const std::string &path)
+{
+    this->journalMutex->lock();
+    this->journal.close();
+    this->journalPath = path;
+    this->journalFailed = false;
+    this->journalMutex->unlock();
+
+    // replaying doesn't write anything since the journal is closed,
+    // afterwards it's rewritten so it only has what's still needed
+    int badLines = 0;
+    if(!Load(badLines))
+        return false;   // not a journal we can read, leave it alone
+
+    // the lines we couldn't read would be lost, keep them somewhere
+    if(badLines > 0 && !BackUpFile(path, path + ".bad"))
+        return false;
+
+    return Save();
+}
+
+bool EscrowLedger::AddDeposit(const std::string &client, SampleEscrowTransactionPtr transaction, bool oldTx)
+{
+    const std::string outPoint = OutPoint(transaction->txId, transaction->vout);
+
+    // claim the outpoint first so the same output can't end up with two clients
+    Stripe &outPointStripe = GetStripe(outPoint);
+    outPointStripe.mutex->lock();
+    if(outPointStripe.owners.find(outPoint) != outPointStripe.owners.end())
+    {
+        outPointStripe.mutex->unlock();
+        return false;
+    }
+    outPointStripe.owners[outPoint] = client;
+    outPointStripe.mutex->unlock();
+
+    Stripe &clientStripe = GetStripe(client);
+    clientStripe.mutex->lock();
+
+    ClientEntry &entry = clientStripe.clients[client];
+
+    Deposit deposit;
+    deposit.transaction = transaction;
+    deposit.counted = transaction->status == SampleEscrowTransaction::Successfull;
+    entry.deposits.push_back(deposit);
+    if(deposit.counted)
+        entry.balance += transaction->amountToSend;
+
+    if(!oldTx)
+        entry.history.push_back(transaction);
+
+    WriteEntry(DepositEntry(client, transaction, !oldTx));
+
+    clientStripe.mutex->unlock();
+    return true;
+}
+
+bool EscrowLedger::RemoveDeposit(const std::string &client, const std::string &txId, int32_t vout)
+{
+    Stripe &clientStripe = GetStripe(client);
+    clientStripe.mutex->lock();
+
+    std::unordered_map<std::string, ClientEntry>::iterator entry = clientStripe.clients.find(client);
+    if(entry == clientStripe.clients.end())
+    {
+        clientStripe.mutex->unlock();
+        return false;
+    }
+
+    std::vector<Deposit> &deposits = entry->second.deposits;
+    std::vector<Deposit>::iterator deposit = deposits.begin();
+    for(; deposit != deposits.end(); deposit++)
+    {
+        if(deposit->transaction->txId == txId && deposit->transaction->vout == vout)
+            break;
+    }
+
+    if(deposit == deposits.end())
+    {
+        clientStripe.mutex->unlock();
+        return false;
+    }
+
+    if(deposit->counted)
+        entry->second.balance -= deposit->transaction->amountToSend;
+    deposits.erase(deposit);
+
+    WriteEntry("R " + ToField(client) + " " + ToField(txId) + " " + btc::to_string(vout));
+
+    clientStripe.mutex->unlock();
+
+    const std::string outPoint = OutPoint(txId, vout);
+    Stripe &outPointStripe = GetStripe(outPoint);
+    outPointStripe.mutex->lock();
+    outPointStripe.owners.erase(outPoint);
+    outPointStripe.mutex->unlock();
+
+    return true;
+}
+
+void EscrowLedger::DepositChanged(const std::string &client, SampleEscrowTransactionPtr transaction)
+{
+    Stripe &clientStripe = GetStripe(client);
+    clientStripe.mutex->lock();
+
+    std::unordered_map<std::string, ClientEntry>::iterator entry = clientStripe.clients.find(client);
+    if(entry == clientStripe.clients.end())
+    {
+        clientStripe.mutex->unlock();
+        return;
+    }
+
+    for(std::vector<Deposit>::iterator deposit = entry->second.deposits.begin(); deposit != entry->second.deposits.end(); deposit++)
+    {
+        if(deposit->transaction != transaction)
+            continue;
+
+        bool counted = transaction->status == SampleEscrowTransaction::Successfull;
+        if(counted != deposit->counted)
+        {
+            entry->second.balance += counted ? transaction->amountToSend : -transaction->amountToSend;
+            deposit->counted = counted;
+        }
+
+        WriteEntry(StatusEntry(client, transaction));
+        break;
+    }
+
+    clientStripe.mutex->unlock();
+}
+
+SampleEscrowTransactionPtr EscrowLedger::FindDeposit(const std::string &txId, int32_t vout, std::string* owner)
+{
+    const std::string outPoint = OutPoint(txId, vout);
+
+    Stripe &outPointStripe = GetStripe(outPoint);
+    outPointStripe.mutex->lock();
+    std::unordered_map<std::string, std::string>::iterator found = outPointStripe.owners.find(outPoint);
+    if(found == outPointStripe.owners.end())
+    {
+        outPointStripe.mutex->unlock();
+        return SampleEscrowTransactionPtr();
+    }
+    std::string client = found->second;
+    outPointStripe.mutex->unlock();
+
+    SampleEscrowTransactions deposits = GetDeposits(client);
+    foreach(SampleEscrowTransactionPtr tx, deposits)
+    {
+        if(tx->txId == txId && tx->vout == vout)
+        {
+            if(owner != NULL)
+                *owner = client;
+            return tx;
+        }
+    }
+
+    return SampleEscrowTransactionPtr();
+}
+
+SampleEscrowTransactions EscrowLedger::GetDeposits(const std::string &client)
+{
+    SampleEscrowTransactions transactions;
+
+    Stripe &clientStripe = GetStripe(client);
+    clientStripe.mutex->lock();
+
+    std::unordered_map<std::string, ClientEntry>::iterator entry = clientStripe.clients.find(client);
+    if(entry != clientStripe.clients.end())
+    {
+        for(std::vector<Deposit>::iterator deposit = entry->second.deposits.begin(); deposit != entry->second.deposits.end(); deposit++)
+            transactions.push_back(deposit->transaction);
+    }
+
+    clientStripe.mutex->unlock();
+    return transactions;
+}
+
+std::vector<std::pair<std::string, SampleEscrowTransactionPtr> > EscrowLedger::GetAllDeposits()
+{
+    std::vector<std::pair<std::string, SampleEscrowTransactionPtr> > transactions;
+
+    // one stripe after the other, the rest of the ledger stays usable meanwhile
+    for(std::vector<Stripe>::iterator stripe = this->stripes.begin(); stripe != this->stripes.end(); stripe++)
+    {
+        stripe->mutex->lock();
+        for(std::unordered_map<std::string, ClientEntry>::iterator entry = stripe->clients.begin(); entry != stripe->clients.end(); entry++)
+        {
+            for(std::vector<Deposit>::iterator deposit = entry->second.deposits.begin(); deposit != entry->second.deposits.end(); deposit++)
+                transactions.push_back(std::make_pair(entry->first, deposit->transaction));
+        }
+        stripe->mutex->unlock();
+    }
+
+    return transactions;
+}
+
+int64_t EscrowLedger::GetBalance(const std::string &client)
+{
+    Stripe &clientStripe = GetStripe(client);
+    clientStripe.mutex->lock();
+
+    std::unordered_map<std::string, ClientEntry>::iterator entry = clientStripe.clients.find(client);
+    int64_t balance = entry == clientStripe.clients.end() ? int64_t(0) : entry->second.balance;
+
+    clientStripe.mutex->unlock();
+    return balance;
+}
+
+void EscrowLedger::AddToHistory(const std::string &client, SampleEscrowTransactionPtr transaction)
+{
+    Stripe &clientStripe = GetStripe(client);
+    clientStripe.mutex->lock();
+
+    clientStripe.clients[client].history.push_back(transaction);
+    WriteEntry(HistoryEntry(client, transaction));
+
+    clientStripe.mutex->unlock();
+}
+
+u_int64_t EscrowLedger::GetHistorySize(const std::string &client)
+{
+    Stripe &clientStripe = GetStripe(client);
+    clientStripe.mutex->lock();
+
+    std::unordered_map<std::string, ClientEntry>::iterator entry = clientStripe.clients.find(client);
+    u_int64_t size = entry == clientStripe.clients.end() ? 0 : entry->second.history.size();
+
+    clientStripe.mutex->unlock();
+    return size;
+}
+
+SampleEscrowTransactionPtr EscrowLedger::GetHistoryEntry(const std::string &client, u_int64_t index)
+{
+    Stripe &clientStripe = GetStripe(client);
+    clientStripe.mutex->lock();
+
+    SampleEscrowTransactionPtr transaction = SampleEscrowTransactionPtr();
+    std::unordered_map<std::string, ClientEntry>::iterator entry = clientStripe.clients.find(client);
+    if(entry != clientStripe.clients.end() && index < entry->second.history.size())
+        transaction = entry->second.history[index];
+
+    clientStripe.mutex->unlock();
+    return transaction;
+}
+
+u_int64_t EscrowLedger::GetHistory(const std::string &client, u_int64_t fromIndex, u_int64_t maxCount, SampleEscrowTransactions &transactions)
+{
+    transactions.clear();
+
+    Stripe &clientStripe = GetStripe(client);
+    clientStripe.mutex->lock();
+
+    std::unordered_map<std::string, ClientEntry>::iterator entry = clientStripe.clients.find(client);
+    if(entry == clientStripe.clients.end())
+    {
+        clientStripe.mutex->unlock();
+        return 0;
+    }
+
+    const std::vector<SampleEscrowTransactionPtr> &history = entry->second.history;
+    for(u_int64_t index = fromIndex; index < history.size() && transactions.size() < maxCount; index++)
+        transactions.push_back(history[index]);
+
+    u_int64_t size = history.size();
+    clientStripe.mutex->unlock();
+    return size;
+}
+
+size_t EscrowLedger::GetClientCount()
+{
+    size_t count = 0;
+    for(std::vector<Stripe>::iterator stripe = this->stripes.begin(); stripe != this->stripes.end(); stripe++)
+    {
+        stripe->mutex->lock();
+        count += stripe->clients.size();
+        stripe->mutex->unlock();
+    }
+
+    return count;
+}
+
+void EscrowLedger::AddAddress(const std::string &client, const std::string &address)
+{
+    Stripe &clientStripe = GetStripe(client);
+    clientStripe.mutex->lock();
+
+    btc::stringList &addresses = clientStripe.clients[client].addresses;
+    if(std::find(addresses.begin(), addresses.end(), address) == addresses.end())
+    {
+        addresses.push_back(address);
+        WriteEntry(AddressEntry(client, address));
+    }
+
+    clientStripe.mutex->unlock();
+}
+
+std::vector<std::pair<std::string, std::string> > EscrowLedger::GetAddresses()
+{
+    std::vector<std::pair<std::string, std::string> > addresses;
+
+    for(std::vector<Stripe>::iterator stripe = this->stripes.begin(); stripe != this->stripes.end(); stripe++)
+    {
+        stripe->mutex->lock();
+        for(std::unordered_map<std::string, ClientEntry>::iterator entry = stripe->clients.begin(); entry != stripe->clients.end(); entry++)
+        {
+            for(btc::stringList::iterator address = entry->second.addresses.begin(); address != entry->second.addresses.end(); address++)
+                addresses.push_back(std::make_pair(entry->first, (*address)));
+        }
+        stripe->mutex->unlock();
+    }
+
+    return addresses;
+}
+
+// one change per line:
+// D client txId vout amount address scriptPubKey status confirmations inHistory    deposit added
+// S client txId vout status confirmations                                          deposit status changed
+// R client txId vout                                                               deposit spent
+// H client txId vout amount address type status                                    history entry (releases)
+// A client address                                                                 multisig address created
+bool EscrowLedger::Load(int &badLines)
+{
+    badLines = 0;
+
+    if(this->journalPath.empty())
+        return false;
+
+    std::ifstream file(this->journalPath.c_str());
+    if(!file.is_open())
+        return true;    // nothing there yet
+
+    std::string line;
+    if(!std::getline(file, line))
+        return true;    // empty file
+    if(line != JOURNAL_HEADER && line != JOURNAL_HEADER_V1)
+        return false;
+
+    const bool escaped = line == JOURNAL_HEADER;
+
+    while(std::getline(file, line))
+    {
+        // a crash while writing leaves the last line without its newline. it could be cut anywhere,
+        // even where it still reads fine, so it's dropped either way
+        if(file.eof())
+            break;
+
+        if(line.empty())
+            continue;
+
+        // anything else that can't be read is damage worth keeping
+        if(!LoadEntry(line, escaped))
+        {
+            badLines++;
+
+            std::printf("escrow ledger: skipping unreadable line in %s\n", this->journalPath.c_str());
+            std::cout.flush();
+        }
+    }
+
+    return true;
+}
+
+bool EscrowLedger::LoadEntry(const std::string &line, bool escaped)
+{
+    std::istringstream lineStream(line);
+
+    std::string entryType, clientField, client;
+    if(!(lineStream >> entryType >> clientField) || !FromField(clientField, client, escaped))
+        return false;
+
+    if(entryType == "A")
+    {
+        std::string addressField, address;
+        if(!(lineStream >> addressField) || !FromField(addressField, address, escaped) || !(lineStream >> std::ws).eof())
+            return false;
+
+        AddAddress(client, address);
+        return true;
+    }
+
+    std::string txIdField, txId;
+    int32_t vout;
+    if(!(lineStream >> txIdField >> vout) || !FromField(txIdField, txId, escaped))
+        return false;
+
+    if(entryType == "D")
+    {
+        int64_t amount;
+        std::string addressField, address, scriptPubKeyField, scriptPubKey;
+        int status, inHistory;
+        int32_t confirmations;
+        if(!(lineStream >> amount >> addressField >> scriptPubKeyField >> status >> confirmations >> inHistory) ||
+                !FromField(addressField, address, escaped) || !FromField(scriptPubKeyField, scriptPubKey, escaped) ||
+                !(lineStream >> std::ws).eof())
+            return false;
+
+        SampleEscrowTransactionPtr tx = SampleEscrowTransactionPtr(new SampleEscrowTransaction(amount, this->modules));
+        tx->txId = txId;
+        tx->vout = vout;
+        tx->targetAddr = address;
+        tx->scriptPubKey = scriptPubKey;
+        tx->status = static_cast<SampleEscrowTransaction::SUCCESS>(status);
+        tx->confirmations = confirmations;
+        tx->type = SampleEscrowTransaction::Deposit;
+        AddDeposit(client, tx, inHistory == 0);
+    }
+    else if(entryType == "S")
+    {
+        int status;
+        int32_t confirmations;
+        if(!(lineStream >> status >> confirmations) || !(lineStream >> std::ws).eof())
+            return false;
+
+        SampleEscrowTransactions deposits = GetDeposits(client);
+        foreach(SampleEscrowTransactionPtr tx, deposits)
+        {
+            if(tx->txId != txId || tx->vout != vout)
+                continue;
+
+            tx->status = static_cast<SampleEscrowTransaction::SUCCESS>(status);
+            tx->confirmations = confirmations;
+            DepositChanged(client, tx);
+            break;
+        }
+    }
+    else if(entryType == "R")
+    {
+        if(!(lineStream >> std::ws).eof())
+            return false;
+
+        RemoveDeposit(client, txId, vout);
+    }
+    else if(entryType == "H")
+    {
+        int64_t amount;
+        std::string addressField, address;
+        int type, status;
+        if(!(lineStream >> amount >> addressField >> type >> status) || !FromField(addressField, address, escaped) ||
+                !(lineStream >> std::ws).eof())
+            return false;
+
+        SampleEscrowTransactionPtr tx = SampleEscrowTransactionPtr(new SampleEscrowTransaction(amount, this->modules));
+        tx->txId = txId;
+        tx->vout = vout;
+        tx->targetAddr = address;
+        tx->type = static_cast<SampleEscrowTransaction::Type>(type);
+        tx->status = static_cast<SampleEscrowTransaction::SUCCESS>(status);
+        AddToHistory(client, tx);
+    }
+    else
+        return false;
+
+    return true;
+}
+
+bool EscrowLedger::Save()
+{
+    if(this->journalPath.empty())
+        return false;
+
+    // write to a temporary file first so a crash doesn't leave half a ledger behind
+    const std::string tempPath = this->journalPath + ".tmp";
+
+    {
+        std::ofstream file(tempPath.c_str(), std::ios::out | std::ios::trunc);
+        if(!file.is_open())
+            return false;
+
+        file << JOURNAL_HEADER << "\n";
+
+        for(std::vector<Stripe>::iterator stripe = this->stripes.begin(); stripe != this->stripes.end(); stripe++)
+        {
+            stripe->mutex->lock();
+            for(std::unordered_map<std::string, ClientEntry>::iterator entry = stripe->clients.begin(); entry != stripe->clients.end(); entry++)
+            {
+                for(btc::stringList::iterator address = entry->second.addresses.begin(); address != entry->second.addresses.end(); address++)
+                    file << AddressEntry(entry->first, (*address)) << "\n";
+
+                std::set<SampleEscrowTransaction*> deposits;
+                for(std::vector<Deposit>::iterator deposit = entry->second.deposits.begin(); deposit != entry->second.deposits.end(); deposit++)
+                    deposits.insert(deposit->transaction.get());
+
+                // the history in its order, deposits that are still there are written as such
+                std::set<SampleEscrowTransaction*> written;
+                for(std::vector<SampleEscrowTransactionPtr>::iterator tx = entry->second.history.begin(); tx != entry->second.history.end(); tx++)
+                {
+                    if(deposits.find(tx->get()) != deposits.end())
+                    {
+                        file << DepositEntry(entry->first, (*tx), true) << "\n";
+                        written.insert(tx->get());
+                    }
+                    else
+                        file << HistoryEntry(entry->first, (*tx)) << "\n";
+                }
+
+                for(std::vector<Deposit>::iterator deposit = entry->second.deposits.begin(); deposit != entry->second.deposits.end(); deposit++)
+                {
+                    if(written.find(deposit->transaction.get()) == written.end())
+                        file << DepositEntry(entry->first, deposit->transaction, false) << "\n";
+                }
+            }
+            stripe->mutex->unlock();
+        }
+
+        if(!file.good())
+            return false;
+    }
+
+    this->journalMutex->lock();
+
+    this->journal.close();
+    if(std::rename(tempPath.c_str(), this->journalPath.c_str()) != 0)
+    {
+        // windows won't rename over an existing file
+        std::remove(this->journalPath.c_str());
+        if(std::rename(tempPath.c_str(), this->journalPath.c_str()) != 0)
+        {
+            this->journalMutex->unlock();
+            return false;
+        }
+    }
+
+    this->journal.open(this->journalPath.c_str(), std::ios::out | std::ios::app);
+    bool opened = this->journal.is_open();
+
+    this->journalMutex->unlock();
+    return opened;
+}
+
+bool EscrowLedger::WriteEntry(const std::string &entry)
+{
+    this->journalMutex->lock();
+
+    bool written = true;
+    if(this->journal.is_open())
+    {
+        this->journal << entry << "\n";
+        this->journal.flush();
+
+        // the stream stays failed, nothing is appended after the missing change until RepairJournal() rewrites it
+        if(!this->journal.good())
+        {
+            if(!this->journalFailed)
+            {
+                std::printf("escrow ledger: writing to %s failed, the journal is rewritten on the next check\n", this->journalPath.c_str());
+                std::cout.flush();
+            }
+
+            this->journalFailed = true;
+            written = false;
+        }
+    }
+
+    this->journalMutex->unlock();
+    return written;
+}
+
+bool EscrowLedger::RepairJournal()
+{
+    this->journalMutex->lock();
+    bool failed = this->journalFailed;
+    // changes made while Save() runs fail again and set it again
+    this->journalFailed = false;
+    this->journalMutex->unlock();
+
+    if(!failed)
+        return true;
+
+    if(Save())
+        return true;
+
+    this->journalMutex->lock();
+    this->journalFailed = true;
+    this->journalMutex->unlock();
+    return false;
+}
+
+std::string EscrowLedger::DepositEntry(const std::string &client, SampleEscrowTransactionPtr transaction, bool inHistory)
+{
+    std::ostringstream entry;
+    entry << "D " << ToField(client) << " " << ToField(transaction->txId) << " " << transaction->vout
+          << " " << transaction->amountToSend << " " << ToField(transaction->targetAddr) << " " << ToField(transaction->scriptPubKey)
+          << " " << static_cast<int>(transaction->status) << " " << transaction->confirmations << " " << (inHistory ? 1 : 0);
+    return entry.str();
+}
+
+std::string EscrowLedger::HistoryEntry(const std::string &client, SampleEscrowTransactionPtr transaction)
+{
+    std::ostringstream entry;
+    entry << "H " << ToField(client) << " " << ToField(transaction->txId) << " " << transaction->vout
+          << " " << transaction->amountToSend << " " << ToField(transaction->targetAddr)
+          << " " << static_cast<int>(transaction->type) << " " << static_cast<int>(transaction->status);
+    return entry.str();
+}
+
+std::string EscrowLedger::StatusEntry(const std::string &client, SampleEscrowTransactionPtr transaction)
+{
+    std::ostringstream entry;
+    entry << "S " << ToField(client) << " " << ToField(transaction->txId) << " " << transaction->vout
+          << " " << static_cast<int>(transaction->status) << " " << transaction->confirmations;
+    return entry.str();
+}
+
+std::string EscrowLedger::AddressEntry(const std::string &client, const std::string &address)
+{
+    return "A " + ToField(client) + " " + ToField(address);
+}
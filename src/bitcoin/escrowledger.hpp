@@ -0,0 +1,139 @@
+#ifndef ESCROWLEDGER_HPP
+#define ESCROWLEDGER_HPP
+
+#include "core/TR1_Wrapper.hpp"
+
+#include <bitcoin/sampleescrowtransaction.hpp>
+
+#include _CINTTYPES
+#include _MEMORY
+
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class QMutex;
+
+/*
+ * Deposits and transaction history of all clients of an escrow server.
+ *
+ * Clients are spread over a fixed number of stripes by the hash of their name
+ * and each stripe has its own lock, so asking about one client doesn't wait
+ * for the server to finish with all the others.
+ * Deposits can also be looked up by outpoint (txid:vout) without knowing the client.
+ *
+ * The balance of every client (its Successfull deposits) is kept up to date as
+ * deposits come and go. Deposits are shared with the caller, whoever changes
+ * a deposit's status has to call DepositChanged() afterwards.
+ *
+ * If a journal file is set every change is appended to it, on start the
+ * journal is replayed and written back without the entries that don't matter anymore.
+ */
+class EscrowLedger
+{
+    friend class BtcTest;
+
+public:
+    // modules are handed to the transactions read from the journal
+    EscrowLedger(BtcModulesPtr modules, size_t stripeCount = DefaultStripeCount);
+    ~EscrowLedger();
+
+    static const size_t DefaultStripeCount = 64;
+
+    // loads whatever is in the journal, later changes are appended to it.
+    // lines that can't be read are skipped, the journal is copied to path.bad before it's rewritten without them.
+    // returns false if the journal couldn't be read or written
+    bool SetJournalFile(const std::string &path);
+
+    // adds a deposit, also to the client's history unless oldTx
+    // returns false if a deposit with this outpoint is already there
+    bool AddDeposit(const std::string &client, SampleEscrowTransactionPtr transaction, bool oldTx);
+    // returns false if the client has no such deposit
+    bool RemoveDeposit(const std::string &client, const std::string &txId, int32_t vout);
+    // call after changing the status of one of the client's deposits
+    void DepositChanged(const std::string &client, SampleEscrowTransactionPtr transaction);
+
+    // returns NULL if nobody has a deposit with this outpoint, owner is set to the client otherwise
+    SampleEscrowTransactionPtr FindDeposit(const std::string &txId, int32_t vout, std::string* owner = NULL);
+
+    SampleEscrowTransactions GetDeposits(const std::string &client);
+    // deposits of all clients together with their owner
+    std::vector<std::pair<std::string, SampleEscrowTransactionPtr> > GetAllDeposits();
+
+    // sum of the client's Successfull deposits
+    int64_t GetBalance(const std::string &client);
+
+    void AddToHistory(const std::string &client, SampleEscrowTransactionPtr transaction);
+    u_int64_t GetHistorySize(const std::string &client);
+    // returns NULL if index is out of range
+    SampleEscrowTransactionPtr GetHistoryEntry(const std::string &client, u_int64_t index);
+    // up to maxCount entries starting at fromIndex, returns the size of the whole history
+    u_int64_t GetHistory(const std::string &client, u_int64_t fromIndex, u_int64_t maxCount, SampleEscrowTransactions &transactions);
+
+    size_t GetClientCount();
+
+    // the client's multisig addresses, so outputs to them can be told apart after a restart
+    void AddAddress(const std::string &client, const std::string &address);
+    // all clients and their addresses, oldest address first
+    std::vector<std::pair<std::string, std::string> > GetAddresses();
+
+    // if a change couldn't be appended to the journal (disk full...), rewrites it from what's in memory.
+    // returns false if the journal is still missing changes
+    bool RepairJournal();
+
+private:
+    struct Deposit
+    {
+        SampleEscrowTransactionPtr transaction;
+        bool counted;       // part of the balance right now
+    };
+
+    struct ClientEntry
+    {
+        ClientEntry() : balance(0) {}
+
+        int64_t balance;
+        std::vector<Deposit> deposits;                          // oldest first
+        std::vector<SampleEscrowTransactionPtr> history;        // oldest first
+        btc::stringList addresses;                              // oldest first
+    };
+
+    // a stripe holds the clients whose name hashes to it and the outpoints that hash to it,
+    // only one stripe is ever locked at a time
+    struct Stripe
+    {
+        QMutex* mutex;
+        std::unordered_map<std::string, ClientEntry> clients;
+        std::unordered_map<std::string, std::string> owners;   // outpoint -> client
+    };
+
+    Stripe &GetStripe(const std::string &key);
+    static std::string OutPoint(const std::string &txId, int32_t vout);
+
+    // returns false if there is a file but it's not a journal, badLines counts the lines that were skipped
+    bool Load(int &badLines);
+    // replays one line, returns false if it's malformed
+    bool LoadEntry(const std::string &line, bool escaped);
+    bool Save();        // writes everything, replacing the journal
+    bool WriteEntry(const std::string &entry);      // appends to the journal, if there is one. false if that failed
+
+    static std::string DepositEntry(const std::string &client, SampleEscrowTransactionPtr transaction, bool inHistory);
+    static std::string HistoryEntry(const std::string &client, SampleEscrowTransactionPtr transaction);
+    static std::string StatusEntry(const std::string &client, SampleEscrowTransactionPtr transaction);
+    static std::string AddressEntry(const std::string &client, const std::string &address);
+
+    BtcModulesPtr modules;
+
+    std::vector<Stripe> stripes;
+
+    QMutex* journalMutex;
+    std::string journalPath;
+    std::ofstream journal;
+    bool journalFailed;         // a change is missing from the journal
+};
+
+typedef _SharedPtr<EscrowLedger> EscrowLedgerPtr;
+
+#endif // ESCROWLEDGER_HPP
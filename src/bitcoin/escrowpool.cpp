@@ -5,9 +5,13 @@
 #include <bitcoin/escrowpool.hpp>
 
 #include <bitcoin/sampleescrowserver.hpp>
+#include <bitcoin/sampleescrowserverzmq.hpp>
 
 #include <QThread>
 
+#include <algorithm>
+#include <cstring>
+
 
 EscrowPool::EscrowPool(uint32_t sigsRequired)
 {
@@ -52,3 +56,123 @@ void EscrowPool::RemoveEscrowServer(SampleEscrowServerPtr server)
     serverThread = NULL;
     this->escrowServers.removeAll(server);
 }
+
+btc::stringList EscrowPool::GetPubKeys(const std::string &client, const std::string &skipServer)
+{
+    std::vector<SampleEscrowServerPtr> servers = GetServers(skipServer);
+
+    BtcNetMsgGetKey message;
+    memcpy(message.client, client.c_str(), std::min(client.size(), sizeof(message.client)));
+
+    std::vector<BtcNetMsg*> replies = SampleEscrowServerZmq::SendDataToAll(servers, (BtcNetMsg*)&message);
+
+    btc::stringList pubKeys;
+    for(size_t i = 0; i < servers.size(); i++)
+    {
+        if(!SampleEscrowServerZmq::IsRemote(servers[i]))
+        {
+            pubKeys.push_back(servers[i]->GetPubKey(client));
+            continue;
+        }
+
+        if(replies[i] == NULL || replies[i]->MessageType != MultiSigKey)
+        {
+            pubKeys.push_back(std::string());
+            delete[] replies[i];
+            continue;
+        }
+
+        BtcNetMsgPubKey reply;
+        memcpy(reply.data, replies[i]->data, NetMsgPubKeySize);
+        pubKeys.push_back(std::string(reply.pubKey, strnlen(reply.pubKey, sizeof(reply.pubKey))));
+
+        delete[] replies[i];
+    }
+
+    return pubKeys;
+}
+
+btc::stringList EscrowPool::RequestSignedWithdrawals(const std::string &client, const std::string &skipServer)
+{
+    std::vector<SampleEscrowServerPtr> servers = GetServers(skipServer);
+
+    BtcNetMsgReqSignedTx message;
+    memcpy(message.client, client.c_str(), std::min(client.size(), sizeof(message.client)));
+
+    std::vector<BtcNetMsg*> replies = SampleEscrowServerZmq::SendDataToAll(servers, (BtcNetMsg*)&message);
+
+    btc::stringList signedTransactions;
+    for(size_t i = 0; i < servers.size(); i++)
+    {
+        if(!SampleEscrowServerZmq::IsRemote(servers[i]))
+        {
+            signedTransactions.push_back(servers[i]->RequestSignedWithdrawal(client));
+            continue;
+        }
+
+        if(replies[i] == NULL || replies[i]->MessageType != SignedTx)
+        {
+            signedTransactions.push_back(std::string());
+            delete[] replies[i];
+            continue;
+        }
+
+        BtcNetMsgSignedTx* reply = new BtcNetMsgSignedTx();     // too big for the stack
+        memcpy(reply->data, replies[i]->data, NetMsgSignedTxSize);
+        signedTransactions.push_back(std::string(reply->rawTx, strnlen(reply->rawTx, sizeof(reply->rawTx))));
+        delete reply;
+
+        delete[] replies[i];
+    }
+
+    return signedTransactions;
+}
+
+btc::stringList EscrowPool::RequestDepositAddresses(const std::string &client)
+{
+    std::vector<SampleEscrowServerPtr> servers = GetServers(std::string(), true);
+
+    BtcNetMsgGetDepositAddr message;
+    memcpy(message.client, client.c_str(), std::min(client.size(), sizeof(message.client)));
+
+    std::vector<BtcNetMsg*> replies = SampleEscrowServerZmq::SendDataToAll(servers, (BtcNetMsg*)&message);
+
+    btc::stringList addresses;
+    for(size_t i = 0; i < servers.size(); i++)
+    {
+        if(!SampleEscrowServerZmq::IsRemote(servers[i]))
+        {
+            addresses.push_back(servers[i]->RequestDepositAddress(client));
+            continue;
+        }
+
+        if(replies[i] == NULL || replies[i]->MessageType != MultiSigAddr)
+        {
+            addresses.push_back(std::string());
+            delete[] replies[i];
+            continue;
+        }
+
+        BtcNetMsgDepositAddr reply;
+        memcpy(reply.data, replies[i]->data, NetMsgDepositAddrSize);
+        addresses.push_back(std::string(reply.address, strnlen(reply.address, sizeof(reply.address))));
+
+        delete[] replies[i];
+    }
+
+    return addresses;
+}
+
+std::vector<SampleEscrowServerPtr> EscrowPool::GetServers(const std::string &skipServer, bool onlyClients)
+{
+    std::vector<SampleEscrowServerPtr> servers;
+    foreach(SampleEscrowServerPtr server, this->escrowServers)
+    {
+        if(server->serverName == skipServer || (onlyClients && !server->isClient))
+            continue;
+
+        servers.push_back(server);
+    }
+
+    return servers;
+}
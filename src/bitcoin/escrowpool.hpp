@@ -5,12 +5,16 @@
 #include "core/ExportWrapper.h"
 #include "core/TR1_Wrapper.hpp"
 
+#include <bitcoin-api/btcobjects.hpp>
+
 #include _CINTTYPES
 #include _MEMORY
 
 #include <QList>
 #include <QString>
 #include <map>
+#include <string>
+#include <vector>
 
 class SampleEscrowServer;
 class QThread;
@@ -27,6 +31,14 @@ public:
 
     void RemoveEscrowServer(SampleEscrowServerPtr server);
 
+    // these ask all servers except skipServer at once instead of one after the other
+    // results are in the order of escrowServers, empty strings for servers that didn't answer
+    btc::stringList GetPubKeys(const std::string &client, const std::string &skipServer);
+    btc::stringList RequestSignedWithdrawals(const std::string &client, const std::string &skipServer);
+
+    // same for the servers we're a client of
+    btc::stringList RequestDepositAddresses(const std::string &client);
+
     QList<SampleEscrowServerPtr> escrowServers;     // servers that are part of this pool
 
     std::string poolName;
@@ -39,7 +51,7 @@ public:
     bool containsHostedServer;
 
 private:
-
+    std::vector<SampleEscrowServerPtr> GetServers(const std::string &skipServer, bool onlyClients = false);
 };
 
 typedef _SharedPtr<EscrowPool> EscrowPoolPtr;
@@ -4,6 +4,7 @@
 
 #include <bitcoin/sampleescrowclient.hpp>
 #include <bitcoin/sampleescrowserver.hpp>
+#include <bitcoin/samplenetmessages.hpp>
 
 #include <core/modules.hpp>
 
@@ -267,13 +268,9 @@ void SampleEscrowClient::AskForDepositAddress(ActionPtr action)
 
     // ask the servers for an address to send money to
     std::string depositAddress = std::string();
-    foreach(SampleEscrowServerPtr server, action->pool->escrowServers)
+    btc::stringList serverMultisigs = action->pool->RequestDepositAddresses(this->clientName);
+    foreach(const std::string &serverMultisig, serverMultisigs)
     {
-        if(!server->isClient)
-            continue;
-
-        std::string serverMultisig = server->RequestDepositAddress(this->clientName);
-
         if(depositAddress.empty())
             depositAddress = serverMultisig;
         else if(depositAddress != serverMultisig)
@@ -352,17 +349,28 @@ void SampleEscrowClient::FetchPoolTx(ActionPtr action)
     if(!action->pool->escrowServers.first()->isClient)
         return;
 
+    // get all new transactions at once instead of one request per transaction
     SampleEscrowServerPtr server = action->pool->escrowServers.first();
-    SampleEscrowTransactionPtr tx = server->GetClientTransaction(this->clientName, this->poolTxMap[action->pool->poolName].size());
-    if(tx == NULL)
+    SampleEscrowTransactions transactions;
+    u_int64_t totalCount = 0;
+    if(!server->GetClientTransactions(this->clientName, this->poolTxMap[action->pool->poolName].size(), NetMaxTxsPerReply, transactions, totalCount))
         return;
 
-    tx->modules = this->modules;
-    this->poolTxMap[action->pool->poolName].push_back(tx);
+    foreach(SampleEscrowTransactionPtr tx, transactions)
+    {
+        tx->modules = this->modules;
+        this->poolTxMap[action->pool->poolName].push_back(tx);
+    }
+    this->poolTxCountMap[action->pool->poolName] = totalCount;
 
-    ActionPtr fetchNextTx = ActionPtr(new Action());
-    fetchNextTx->type = Action::FetchTransaction;
-    fetchNextTx->pool = action->pool;
+    // more than fit in one reply
+    if(!transactions.empty() && this->poolTxMap[action->pool->poolName].size() < totalCount)
+    {
+        ActionPtr fetchNextTx = ActionPtr(new Action());
+        fetchNextTx->type = Action::FetchTransaction;
+        fetchNextTx->pool = action->pool;
+        this->actionsToDo.push_back(fetchNextTx);
+    }
 }
 
 void SampleEscrowClient::InitializePool(EscrowPoolPtr pool)
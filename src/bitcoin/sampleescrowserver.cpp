@@ -11,10 +11,15 @@
 
 #include <QTimer>
 #include <QMutex>
+#include <QWaitCondition>
 
 #include <cstdio>
 #include <cstdlib>
 #include <algorithm>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
 
 time_t prevTime = 0;
 
@@ -33,8 +38,15 @@ struct SampleEscrowServer::ClientRequest
     std::string address;
     int64_t amount;
     Action action;
+    qint64 notBefore;       // don't handle before this time (ms on the server's clock)
 };
 
+// key to find an output by txid and vout
+static std::string OutPoint(const std::string &txId, const int64_t &vout)
+{
+    return txId + ":" + btc::to_string(vout);
+}
+
 CheckTxDaemon::CheckTxDaemon(SampleEscrowServer *master, QObject *parent)
     :QObject(parent)
 {
@@ -43,10 +55,16 @@ CheckTxDaemon::CheckTxDaemon(SampleEscrowServer *master, QObject *parent)
 
 void CheckTxDaemon::StartDaemon()
 {
+    // set when bitcoind couldn't answer, the next round checks everything again
+    bool retry = false;
     while(!this->master->shutDown && !Modules::shutDown)
     {
-        btc::Sleep(10000);
-        this->master->CheckTransactions();
+        // a cheap probe instead of checking every deposit each time
+        bool newBlock = false;
+        if(this->master->ChainStateChanged(newBlock) || retry)
+            retry = !this->master->CheckTransactions(newBlock || retry);
+
+        this->master->WaitForChainEvent(SampleEscrowServer::ChainPollInterval);
     }
 
     this->master = NULL;
@@ -70,8 +88,25 @@ SampleEscrowServer::SampleEscrowServer(BitcoinServerPtr rpcServer, EscrowPoolPtr
     this->serverName = "                   ";
     gen_random((char*)this->serverName.c_str(), this->serverName.size());
 
+    this->ledger = EscrowLedgerPtr(new EscrowLedger(this->modules));
+    this->utxos = BtcUtxoSetPtr(new BtcUtxoSet());
+
     this->mutex = new QMutex(QMutex::Recursive);
 
+    this->requestMutex = new QMutex();
+    this->requestArrived = new QWaitCondition();
+
+    this->chainMutex = new QMutex();
+    this->chainChanged = new QWaitCondition();
+    this->chainNotified = false;
+
+    this->bestBlockHash = std::string();
+    this->memPoolSize = -1;
+    this->memPoolBytes = -1;
+    this->lastFallbackCheck = 0;
+
+    this->clock.start();
+
     this->shutDown = false;
 
     this->modules->btcRpc->ConnectToBitcoin(this->rpcServer);
@@ -80,9 +115,19 @@ SampleEscrowServer::SampleEscrowServer(BitcoinServerPtr rpcServer, EscrowPoolPtr
 SampleEscrowServer::~SampleEscrowServer()
 {
     this->shutDown = true;
+    this->requestArrived->wakeAll();
+    this->chainChanged->wakeAll();
     wait();
     delete this->mutex;
     this->mutex = NULL;
+    delete this->requestArrived;
+    this->requestArrived = NULL;
+    delete this->requestMutex;
+    this->requestMutex = NULL;
+    delete this->chainChanged;
+    this->chainChanged = NULL;
+    delete this->chainMutex;
+    this->chainMutex = NULL;
 }
 
 bool SampleEscrowServer::ClientConnected(SampleEscrowClient *client)
@@ -123,215 +168,263 @@ void SampleEscrowServer::StartServerLoop()
     checkTxThread->start();
     QMetaObject::invokeMethod(checkTx, "StartDaemon", Qt::QueuedConnection);
 
+    // sleep until there's something to do
     while(!this->shutDown && !Modules::shutDown)
     {
+        WaitForEvents(ServerLoopTimeout);
         Update();
-        btc::Sleep(10);
     }
 }
 
+void SampleEscrowServer::QueueRequest(ClientRequestPtr request, int delay)
+{
+    request->notBefore = this->clock.elapsed() + delay;
+
+    this->requestMutex->lock();
+    this->clientRequests.push_back(request);
+    this->requestArrived->wakeAll();
+    this->requestMutex->unlock();
+}
+
+SampleEscrowServer::ClientRequestPtr SampleEscrowServer::TakeRequest()
+{
+    this->requestMutex->lock();
+
+    qint64 now = this->clock.elapsed();
+    for(ClientRequests::iterator request = this->clientRequests.begin(); request != this->clientRequests.end(); request++)
+    {
+        if((*request)->notBefore > now)
+            continue;
+
+        ClientRequestPtr nextRequest = (*request);
+        this->clientRequests.erase(request);
+        this->requestMutex->unlock();
+        return nextRequest;
+    }
+
+    this->requestMutex->unlock();
+    return ClientRequestPtr();
+}
+
+int SampleEscrowServer::TimeUntilNextRequest(int timeout)
+{
+    this->requestMutex->lock();
+    int wait = NextRequestDelay(timeout);
+    this->requestMutex->unlock();
+
+    return wait;
+}
+
+int SampleEscrowServer::NextRequestDelay(int timeout)
+{
+    qint64 now = this->clock.elapsed();
+    qint64 wait = timeout;
+    foreach(ClientRequestPtr request, this->clientRequests)
+        wait = std::min(wait, std::max(request->notBefore - now, qint64(0)));
+
+    return static_cast<int>(wait);
+}
+
+void SampleEscrowServer::WaitForEvents(int timeout)
+{
+    // keep the lock until we wait or we might miss a request that comes in just now
+    this->requestMutex->lock();
+
+    int wait = NextRequestDelay(timeout);
+    if(wait > 0 && !this->shutDown)
+        this->requestArrived->wait(this->requestMutex, static_cast<unsigned long>(wait));
+
+    this->requestMutex->unlock();
+}
+
 void SampleEscrowServer::Update()
+{
+    ClientRequestPtr request;
+    while(!this->shutDown && (request = TakeRequest()) != NULL)
+        ProcessRequest(request);
+}
+
+void SampleEscrowServer::ProcessRequest(ClientRequestPtr request)
 {
     this->mutex->lock();
 
-    foreach(ClientRequestPtr request, this->clientRequests)
+    switch(request->action)
     {
-        switch(request->action)
-        {
-        case ClientRequest::CreatePubKey:
-        {
-            // create new address to be used for creation of the multi-sig address
-            // and get its public key:
-            std::string pubKey = CreatePubKey(request->client);
+    case ClientRequest::CreatePubKey:
+    {
+        // create new address to be used for creation of the multi-sig address
+        // and get its public key:
+        std::string pubKey = CreatePubKey(request->client);
 
+        break;
+    }
+    case ClientRequest::CreateMultisig:
+    {
+        // also ask the other servers for their public keys, all at once
+        btc::stringList pubKeysOther = this->serverPool->GetPubKeys(request->client, this->serverName);
+        foreach(const std::string &pubKeyOther, pubKeysOther)
+            this->AddPubKey(request->client, pubKeyOther);
+
+        // if we don't have enough keys, try again later
+        if(this->publicKeys[request->client].size() < static_cast<size_t>(this->serverPool->escrowServers.size()) || this->publicKeys[request->client].size() < this->serverPool->sigsRequired)
+        {
+            ClientRequestPtr createMultiSig = ClientRequestPtr(new ClientRequest());
+            createMultiSig->action = ClientRequest::CreateMultisig;
+            createMultiSig->client = request->client;
+            QueueRequest(createMultiSig, RequestRetryDelay);
             break;
         }
-        case ClientRequest::CreateMultisig:
-        {
-            // also ask the other servers for their public keys
-            foreach(SampleEscrowServerPtr server, this->serverPool->escrowServers)
-            {
-                // skip ourselves
-                if(server->serverName == this->serverName)
-                    continue;
 
-                // ask server for his public key
-                std::string pubKeyOther = server->GetPubKey(request->client);
-
-                this->AddPubKey(request->client, pubKeyOther);
-            }
-
-            // if we don't have enough keys, try again later
-            if(this->publicKeys[request->client].size() < static_cast<size_t>(this->serverPool->escrowServers.size()) || this->publicKeys[request->client].size() < this->serverPool->sigsRequired)
-            {
-                ClientRequestPtr createMultiSig = ClientRequestPtr(new ClientRequest());
-                createMultiSig->action = ClientRequest::CreateMultisig;
-                createMultiSig->client = request->client;
-                this->clientRequests.push_back(createMultiSig);
-                break;
-            }
+        if(this->publicKeys[request->client].size() > static_cast<size_t>(this->serverPool->escrowServers.size()))
+        {
+            InitializeClient(request->client);
+            break;
+        }
 
-            if(this->publicKeys[request->client].size() > static_cast<size_t>(this->serverPool->escrowServers.size()))
-            {
-                InitializeClient(request->client);
-                break;
-            }
+        // generate the multisig address
+        BtcMultiSigAddressPtr multiSigAddrInfo = this->modules->mtBitcoin->GetMultiSigAddressInfo(this->minSignatures, this->publicKeys[request->client], true, "multiSigDeposit");
+        if(multiSigAddrInfo != NULL)
+        {
+            this->multiSigAddress[request->client] = multiSigAddrInfo->address;
+            this->ledger->AddAddress(request->client, multiSigAddrInfo->address);
+            this->addressToClientMap[multiSigAddrInfo->address] = request->client;
+            this->utxos->SetOwner(multiSigAddrInfo->address, request->client);
+            this->modules->btcJson->ImportAddress(multiSigAddrInfo->address, "multisigdeposit", false);
+            if(std::find(this->multiSigAddresses.begin(), this->multiSigAddresses.end(), multiSigAddrInfo->address) == this->multiSigAddresses.end())
+                this->multiSigAddresses.push_back(multiSigAddrInfo->address);
+
+            std::printf("server %s generated multisig address %s\n", this->serverName.c_str(), multiSigAddrInfo->address.c_str());
+            std::cout.flush();
+        }
 
-            // generate the multisig address
-            BtcMultiSigAddressPtr multiSigAddrInfo = this->modules->mtBitcoin->GetMultiSigAddressInfo(this->minSignatures, this->publicKeys[request->client], true, "multiSigDeposit");
-            if(multiSigAddrInfo != NULL)
-            {
-                this->multiSigAddress[request->client] = multiSigAddrInfo->address;
-                this->addressToClientMap[multiSigAddrInfo->address] = request->client;
-                this->modules->btcJson->ImportAddress(multiSigAddrInfo->address, "multisigdeposit", false);
-                if(std::find(this->multiSigAddresses.begin(), this->multiSigAddresses.end(), multiSigAddrInfo->address) == this->multiSigAddresses.end())
-                    this->multiSigAddresses.push_back(multiSigAddrInfo->address);
-
-                std::printf("server %s generated multisig address %s\n", this->serverName.c_str(), multiSigAddrInfo->address.c_str());
-                std::cout.flush();
-            }
+        break;
+    }
+    case ClientRequest::StartReleaseDeposit:
+    {
+        // find enough outputs to cover transaction + fee
+        BtcCoinSelectionPtr outputsToSpend = SelectOutputsToSpend(request->client, request->amount);
 
+        if (outputsToSpend == NULL)
+        {
+            std::printf("Insufficient funds.\n");
+            std::cout.flush();
             break;
         }
-        case ClientRequest::StartReleaseDeposit:
+        else if (this->multiSigAddress[request->client].empty())
         {
-            // find enough outputs to cover transaction + fee
-            BtcUnspentOutputs outputsToSpend = GetOutputsToSpend(request->client, request->amount + BtcHelper::FeeMultiSig);
-
-            if (outputsToSpend.size() == 0)
-            {
-                std::printf("Insufficient funds.\n");
-                std::cout.flush();
-                break;
-            }
-            else if (this->multiSigAddress[request->client].empty())
-            {
-                // create change key
-                ClientRequestPtr createPubKey = ClientRequestPtr(new ClientRequest());
-                createPubKey->action = ClientRequest::CreatePubKey;
-                createPubKey->client = request->client;
-                this->clientRequests.push_back(createPubKey);
-
-                // create change address
-                ClientRequestPtr createMultisig = ClientRequestPtr(new ClientRequest());
-                createMultisig->action = ClientRequest::CreateMultisig;
-                createMultisig->client = request->client;
-                this->clientRequests.push_back(createMultisig);
-
-                ClientRequestPtr startRelease = ClientRequestPtr(new ClientRequest());
-                startRelease->client = request->client;
-                startRelease->action = request->action;
-                startRelease->address = request->address;
-                startRelease->amount = request->amount;
-                this->clientRequests.push_back(startRelease);
+            // create change key
+            ClientRequestPtr createPubKey = ClientRequestPtr(new ClientRequest());
+            createPubKey->action = ClientRequest::CreatePubKey;
+            createPubKey->client = request->client;
+            QueueRequest(createPubKey);
+
+            // create change address
+            ClientRequestPtr createMultisig = ClientRequestPtr(new ClientRequest());
+            createMultisig->action = ClientRequest::CreateMultisig;
+            createMultisig->client = request->client;
+            QueueRequest(createMultisig);
+
+            // try again once the change address is there
+            ClientRequestPtr startRelease = ClientRequestPtr(new ClientRequest());
+            startRelease->client = request->client;
+            startRelease->action = request->action;
+            startRelease->address = request->address;
+            startRelease->amount = request->amount;
+            QueueRequest(startRelease, RequestRetryDelay);
 
-                break;
-            }
+            break;
+        }
 
-            // create unsigned transaction to send to client address and change in case there is any to change address
-            BtcSignedTransactionPtr releaseTx = this->modules->btcHelper->CreateSpendTransaction(outputsToSpend, request->amount, request->address, this->multiSigAddress[request->client]);
-            if(releaseTx == NULL)
-                break;
+        // create unsigned transaction to send to client address and change in case there is any to change address
+        BtcSignedTransactionPtr releaseTx = this->modules->btcHelper->CreateSpendTransaction(outputsToSpend, request->address, this->multiSigAddress[request->client]);
+        if(releaseTx == NULL)
+            break;
 
-            size_t txLength = releaseTx->signedTransaction.size();
-            releaseTx = this->modules->btcJson->SignRawTransaction(releaseTx->signedTransaction);
+        size_t txLength = releaseTx->signedTransaction.size();
+        releaseTx = this->modules->btcJson->SignRawTransaction(releaseTx->signedTransaction);
 
-            // check if signing failed
-            if(releaseTx->signedTransaction.size() <= txLength)
-                break;
+        // check if signing failed
+        if(releaseTx->signedTransaction.size() <= txLength)
+            break;
 
-            this->clientReleaseTxMap[request->client] = releaseTx;
+        this->clientReleaseTxMap[request->client] = releaseTx;
 
-            // ask other servers for signed transactions
-            ClientRequestPtr sendTx = ClientRequestPtr(new ClientRequest());
-            sendTx->action = ClientRequest::SendReleaseTx;
-            sendTx->client = request->client;
-            sendTx->address = request->address;
-            sendTx->amount = request->amount;
-            this->clientRequests.push_back(sendTx);
+        // ask other servers for signed transactions
+        ClientRequestPtr sendTx = ClientRequestPtr(new ClientRequest());
+        sendTx->action = ClientRequest::SendReleaseTx;
+        sendTx->client = request->client;
+        sendTx->address = request->address;
+        sendTx->amount = request->amount;
+        QueueRequest(sendTx);
 
+        break;
+    }
+    case ClientRequest::SendReleaseTx:
+    {
+        BtcSignedTransactionPtr releaseTx = this->clientReleaseTxMap[request->client];
+        if(releaseTx == NULL || releaseTx->signedTransaction.empty())
             break;
-        }
-        case ClientRequest::SendReleaseTx:
-        {
-            BtcSignedTransactionPtr releaseTx = this->clientReleaseTxMap[request->client];
-            if(releaseTx == NULL || releaseTx->signedTransaction.empty())
-                break;
 
-            bool serverReturnedNull = false;
-            foreach(SampleEscrowServerPtr server, this->serverPool->escrowServers)
-            {
-                if(server->serverName == this->serverName)
-                    continue;
+        // ask the other servers for their signatures, all at once
+        btc::stringList partiallySignedTxs = this->serverPool->RequestSignedWithdrawals(request->client, this->serverName);
 
-                std::string partiallySignedTx = server->RequestSignedWithdrawal(request->client);
-                if(partiallySignedTx.empty())
-                    serverReturnedNull = true;
+        bool serverReturnedNull = false;
+        foreach(const std::string &partiallySignedTx, partiallySignedTxs)
+        {
+            if(partiallySignedTx.empty())
+                serverReturnedNull = true;
 
-                releaseTx->signedTransaction += partiallySignedTx;
-                releaseTx = this->modules->btcJson->CombineSignedTransactions(releaseTx->signedTransaction);
+            releaseTx->signedTransaction += partiallySignedTx;
+            releaseTx = this->modules->btcJson->CombineSignedTransactions(releaseTx->signedTransaction);
 
-                // don't add more signatures than necessary
-                if(releaseTx != NULL && releaseTx->complete)
-                    break;
-            }
+            // don't add more signatures than necessary
+            if(releaseTx == NULL || releaseTx->complete)
+                break;
+        }
 
-            if(releaseTx == NULL || !releaseTx->complete)
+        if(releaseTx == NULL || !releaseTx->complete)
+        {
+            if(serverReturnedNull)
             {
-                if(serverReturnedNull)
+                bool failed = false;
+                foreach (SampleEscrowServerPtr server, this->serverPool->escrowServers)
                 {
-                    bool failed = false;
-                    foreach (SampleEscrowServerPtr server, this->serverPool->escrowServers)
-                    {
-                        if(server->serverName == this->serverName)
-                            continue;
-
-                        if(!server->RequestEscrowWithdrawal(request->client, request->amount, request->address))
-                        {
-                            failed = true;
-                            InitializeClient(request->client);
-                            break;
-                        }
-                    }
+                    if(server->serverName == this->serverName)
+                        continue;
 
-                    if(failed)
+                    if(!server->RequestEscrowWithdrawal(request->client, request->amount, request->address))
+                    {
+                        failed = true;
+                        InitializeClient(request->client);
                         break;
-
-                    ClientRequestPtr reStartRelease = ClientRequestPtr(new ClientRequest());
-                    reStartRelease->client = request->client;
-                    reStartRelease->action = request->action;
-                    reStartRelease->address = request->address;
-                    reStartRelease->amount = request->amount;
-                    this->clientRequests.push_back(reStartRelease);
+                    }
                 }
-                break;
-            }
-
-            SampleEscrowTransactionPtr tx = SampleEscrowTransactionPtr(new SampleEscrowTransaction(request->amount, this->modules));
-            tx->targetAddr = request->address;
-            tx->type = SampleEscrowTransaction::Release;
-            this->clientHistoryMap[request->client].push_back(tx);
 
-            tx->txId = this->modules->btcJson->SendRawTransaction(releaseTx->signedTransaction);
+                if(failed)
+                    break;
 
-            break;
-        }
-        default:
+                ClientRequestPtr reStartRelease = ClientRequestPtr(new ClientRequest());
+                reStartRelease->client = request->client;
+                reStartRelease->action = request->action;
+                reStartRelease->address = request->address;
+                reStartRelease->amount = request->amount;
+                QueueRequest(reStartRelease, RequestRetryDelay);
+            }
             break;
         }
 
-        this->clientRequests.remove(request);
-        if(!(std::rand() % 5))
-        {
-            ClientRequestPtr request = ClientRequestPtr(new ClientRequest());
-            request->action = ClientRequest::Unknown;
-            this->clientRequests.push_back(request);
-            request = ClientRequestPtr(new ClientRequest());
-            request->action = ClientRequest::Unknown;
-            this->clientRequests.push_back(request);
-        }
+        SampleEscrowTransactionPtr tx = SampleEscrowTransactionPtr(new SampleEscrowTransaction(request->amount, this->modules));
+        tx->targetAddr = request->address;
+        tx->type = SampleEscrowTransaction::Release;
+        tx->txId = this->modules->btcJson->SendRawTransaction(releaseTx->signedTransaction);
+        this->ledger->AddToHistory(request->client, tx);
+
+        break;
+    }
+    default:
         break;
     }
+
     this->mutex->unlock();
 }
 
@@ -347,12 +440,12 @@ bool SampleEscrowServer::RequestEscrowDeposit(const std::string &client, const i
     ClientRequestPtr createPubKey = ClientRequestPtr(new ClientRequest());
     createPubKey->action = ClientRequest::CreatePubKey;
     createPubKey->client = client;
-    this->clientRequests.push_back(createPubKey);
+    QueueRequest(createPubKey);
 
     ClientRequestPtr request = ClientRequestPtr(new ClientRequest());
     request->action = ClientRequest::CreateMultisig;
     request->client = client;
-    this->clientRequests.push_back(request);
+    QueueRequest(request);
 
     this->mutex->unlock();
 
@@ -422,72 +515,168 @@ void SampleEscrowServer::AddPubKey(const std::string &client, const std::string
 
 void SampleEscrowServer::AddClientDeposit(const std::string &client, SampleEscrowTransactionPtr transaction, bool oldTx)
 {
-    this->mutex->lock();
-
     transaction->type = SampleEscrowTransaction::Deposit;
 
-    foreach(SampleEscrowTransactionPtr tx, this->clientBalancesMap[client])
-    {
-        if(tx->txId == transaction->txId && tx->targetAddr == transaction->targetAddr)
-        {
-            this->mutex->unlock();
-            return;
-        }
-    }
-    this->clientBalancesMap[client].push_back(transaction);
-    if(!oldTx)
-        this->clientHistoryMap[client].push_back(transaction);
-
-    opentxs::Log::vOutput(0, "Added %s\n to %s\nClient %s now has %d deposit transaction(s)\n", transaction->txId.c_str(), transaction->targetAddr.c_str(), client.c_str(), this->clientBalancesMap[client].size());
+    // the ledger knows every outpoint, no need to look through the client's deposits
+    if(!this->ledger->AddDeposit(client, transaction, oldTx))
+        return;
 
-    this->mutex->unlock();
+    opentxs::Log::vOutput(0, "Added %s\n to %s\nClient %s now has %d deposit transaction(s)\n", transaction->txId.c_str(), transaction->targetAddr.c_str(), client.c_str(), this->ledger->GetDeposits(client).size());
 }
 
 void SampleEscrowServer::RemoveClientDeposit(const std::string &client, SampleEscrowTransactionPtr transaction)
 {
-    this->mutex->lock();
+    this->ledger->RemoveDeposit(client, transaction->txId, transaction->vout);
+}
+
+bool SampleEscrowServer::ChainStateChanged(bool &newBlock)
+{
+    this->chainMutex->lock();
+    bool notified = this->chainNotified;
+    this->chainNotified = false;
+    this->chainMutex->unlock();
+
+    std::string blockHash = this->modules->btcJson->GetBestBlockHash();
+    if(blockHash.empty())
+        return false;   // bitcoind isn't answering, try again next time
+
+    newBlock = blockHash != this->bestBlockHash;
+    this->bestBlockHash = blockHash;
 
-    for(SampleEscrowTransactions::iterator tx = this->clientBalancesMap[client].begin(); tx != this->clientBalancesMap[client].end(); tx++)
+    bool memPoolChanged = false;
+    BtcMemPoolInfoPtr memPool = this->modules->btcJson->GetMemPoolInfo();
+    if(memPool != NULL)
     {
-        if((*tx)->txId == transaction->txId && (*tx)->vout == transaction->vout)
-        {
-            this->clientBalancesMap[client].remove((*tx));
-            tx = this->clientBalancesMap[client].begin();
-        }
+        memPoolChanged = memPool->size != this->memPoolSize || memPool->bytes != this->memPoolBytes;
+        this->memPoolSize = memPool->size;
+        this->memPoolBytes = memPool->bytes;
+    }
+    else if(this->clock.elapsed() - this->lastFallbackCheck >= MemPoolFallbackInterval)
+    {
+        // old bitcoind without getmempoolinfo, check every now and then like we used to
+        memPoolChanged = true;
+        this->lastFallbackCheck = this->clock.elapsed();
     }
 
-    this->mutex->unlock();
+    return notified || newBlock || memPoolChanged;
 }
 
-void SampleEscrowServer::CheckTransactions()
+void SampleEscrowServer::WaitForChainEvent(int timeout)
+{
+    this->chainMutex->lock();
+
+    if(!this->chainNotified && !this->shutDown)
+        this->chainChanged->wait(this->chainMutex, static_cast<unsigned long>(timeout));
+
+    this->chainMutex->unlock();
+}
+
+void SampleEscrowServer::NotifyChainChanged()
+{
+    this->chainMutex->lock();
+    this->chainNotified = true;
+    this->chainChanged->wakeAll();
+    this->chainMutex->unlock();
+}
+
+bool SampleEscrowServer::CheckTransactions(bool newBlock)
 {
     this->mutex->lock();
 
-    BtcUnspentOutputs unspentOutputs = BtcUnspentOutputs();
-    for(ClientBalanceMap::iterator clientBalances = this->clientBalancesMap.begin(); clientBalances != this->clientBalancesMap.end(); clientBalances++)
+    // changes the journal missed since last time (disk full...), the next check tries again if it's still failing
+    bool journalComplete = this->ledger->RepairJournal();
+
+    // one listunspent over all multisig addresses tells us which deposits are still there and which are new.
+    // if bitcoind doesn't answer, an empty list would look like every deposit was spent
+    std::map<std::string, BtcUnspentOutputPtr> unlistedOutputs;
+    BtcUnspentOutputs outputs;
+    if(!this->multiSigAddresses.empty())
     {
-        foreach(SampleEscrowTransactionPtr tx, clientBalances->second)
+        bool listed = false;
+        outputs = this->modules->btcJson->ListUnspent(BtcHelper::MinConfirms, BtcHelper::MaxConfirms, this->multiSigAddresses, &listed);
+        if(!listed)
         {
-            BtcUnspentOutputPtr outputFromTx;
-            if((outputFromTx = this->modules->btcJson->GetTxOut(tx->txId, tx->vout)) == NULL)
+            std::printf("listunspent failed, deposits are left as they are until the next check\n");
+            this->mutex->unlock();
+            return false;
+        }
+
+        foreach(BtcUnspentOutputPtr output, outputs)
+            unlistedOutputs[OutPoint(output->txId, output->vout)] = output;
+    }
+
+    // deposits that weren't listed are probably spent, gettxout has the final word on those
+    std::vector<std::pair<std::string, SampleEscrowTransactionPtr> > missingDeposits;
+    BtcUnspentOutputs missingOutputs;
+    std::vector<std::pair<std::string, SampleEscrowTransactionPtr> > deposits = this->ledger->GetAllDeposits();
+    for(std::vector<std::pair<std::string, SampleEscrowTransactionPtr> >::iterator deposit = deposits.begin(); deposit != deposits.end(); deposit++)
+    {
+        SampleEscrowTransactionPtr tx = deposit->second;
+
+        std::map<std::string, BtcUnspentOutputPtr>::iterator listed = unlistedOutputs.find(OutPoint(tx->txId, tx->vout));
+        if(listed != unlistedOutputs.end())
+        {
+            unlistedOutputs.erase(listed);
+
+            // confirmations only change with new blocks
+            if(newBlock && tx->status == SampleEscrowTransaction::Pending)
             {
-                InitializeClient(clientBalances->first);
-                RemoveClientDeposit(clientBalances->first, tx);
-                continue;
+                tx->CheckTransaction(this->minConfirms);
+                this->ledger->DepositChanged(deposit->first, tx);
             }
+            continue;
+        }
 
-            if(tx->status == SampleEscrowTransaction::Pending)
-                tx->CheckTransaction(this->minConfirms);
+        BtcUnspentOutputPtr output = BtcUnspentOutputPtr(new BtcUnspentOutput(Json::Value()));
+        output->txId = tx->txId;
+        output->vout = tx->vout;
+        missingOutputs.push_back(output);
+
+        missingDeposits.push_back((*deposit));
+    }
 
-            unspentOutputs.push_back(outputFromTx);           
+    std::vector<BtcUnspentOutputPtr> outputsFromTxs;
+    if(!missingOutputs.empty())
+    {
+        // same as above, a failed call is no proof that anything was spent
+        bool checked = false;
+        outputsFromTxs = this->modules->btcJson->GetTxOuts(missingOutputs, &checked);
+        if(!checked)
+        {
+            std::printf("gettxout failed for %u deposits, they are left as they are until the next check\n", static_cast<unsigned>(missingOutputs.size()));
+            this->mutex->unlock();
+            return false;
         }
     }
 
-    // look for new transactions to multisig addresses
-    BtcUnspentOutputs incomingTransactions = this->modules->btcHelper->ListNewOutputs(unspentOutputs, this->multiSigAddresses);
+    // withdrawals pick from these, only what changed since last time is applied
+    if(!this->multiSigAddresses.empty())
+        this->utxos->Update(this->multiSigAddresses, outputs);
 
-    foreach(BtcUnspentOutputPtr output, incomingTransactions)
+    for(size_t i = 0; i < missingDeposits.size(); i++)
     {
+        const std::string &client = missingDeposits[i].first;
+        SampleEscrowTransactionPtr tx = missingDeposits[i].second;
+
+        if(outputsFromTxs[i] == NULL)
+        {
+            InitializeClient(client);
+            RemoveClientDeposit(client, tx);
+            continue;
+        }
+
+        if(newBlock && tx->status == SampleEscrowTransaction::Pending)
+        {
+            tx->CheckTransaction(this->minConfirms);
+            this->ledger->DepositChanged(client, tx);
+        }
+    }
+
+    // whatever is left over are new transactions to multisig addresses
+    for(std::map<std::string, BtcUnspentOutputPtr>::iterator it = unlistedOutputs.begin(); it != unlistedOutputs.end(); it++)
+    {
+        BtcUnspentOutputPtr output = it->second;
+
         int64_t amount = output->amount;
         SampleEscrowTransactionPtr clientTx = SampleEscrowTransactionPtr(new SampleEscrowTransaction(amount, this->modules));
         clientTx->txId = output->txId;
@@ -501,148 +690,79 @@ void SampleEscrowServer::CheckTransactions()
         AddClientDeposit(client, clientTx, false);
         // clear temporary deposit info after new deposits so that we generate a new address next time client asks
         InitializeClient(client);
-
     }
 
     this->mutex->unlock();
+
+    return journalComplete;
 }
 
 SampleEscrowTransactionPtr SampleEscrowServer::FindClientTransaction(const std::string &targetAddress, const std::string &txId, const std::string &client)
 {
-    this->mutex->lock();
-
-    if(this->clientBalancesMap.find(client) == this->clientBalancesMap.end())
-    {
-        this->mutex->unlock();
-        return SampleEscrowTransactionPtr();
-    }
-
-    foreach(SampleEscrowTransactionPtr tx, this->clientBalancesMap[client])
+    SampleEscrowTransactions deposits = this->ledger->GetDeposits(client);
+    foreach(SampleEscrowTransactionPtr tx, deposits)
     {
         if(tx->txId == txId && tx->targetAddr == targetAddress)
-        {
-            this->mutex->unlock();
             return tx;
-        }
     }
 
-    this->mutex->unlock();
     return SampleEscrowTransactionPtr();
 }
 
 int64_t SampleEscrowServer::GetClientBalance(const std::string &client)
 {
-    this->mutex->lock();
-
-    ClientBalanceMap::iterator clientBalanceMap = this->clientBalancesMap.find(client);
-    if(clientBalanceMap == this->clientBalancesMap.end())
-    {
-        this->mutex->unlock();
-        return int64_t(0);
-    }
-
-    // iterate through all transactions associated with this client
-    int64_t balance = int64_t(0);
-    foreach(SampleEscrowTransactionPtr tx, clientBalanceMap->second)
-    {
-        if(tx->status == tx->Successfull)
-            balance += tx->amountToSend;    // add value to overall balance
-    }
-
-    this->mutex->unlock();
-    return balance;
+    // kept up to date by the ledger, no need to add up the deposits
+    return this->ledger->GetBalance(client);
 }
 
 u_int64_t SampleEscrowServer::GetClientTransactionCount(const std::string &client)
 {
-    this->mutex->lock();
-
-    ClientBalanceMap::iterator clientHistory = this->clientHistoryMap.find(client);
-
-    if(clientHistory == this->clientHistoryMap.end())
-    {
-        this->mutex->unlock();
-        return 0;
-    }
-
-    u_int64_t size = clientHistory->second.size();
-    this->mutex->unlock();
-    return size;
+    return this->ledger->GetHistorySize(client);
 }
 
 SampleEscrowTransactionPtr SampleEscrowServer::GetClientTransaction(const std::string &client, u_int64_t txIndex)
 {
-    this->mutex->lock();
-
-    ClientBalanceMap::iterator clientHistory = this->clientHistoryMap.find(client);
-    if(clientHistory == this->clientHistoryMap.end())
-    {
-        this->mutex->unlock();
-        return SampleEscrowTransactionPtr();
-    }
-
-    if(clientHistory->second.size() <= txIndex)
-    {
-        this->mutex->unlock();
-        return SampleEscrowTransactionPtr();
-    }
-
-    SampleEscrowTransactions::iterator tx = clientHistory->second.begin();
-    std::advance(tx, txIndex);      // silly c++03
-    if(tx == clientHistory->second.end())
-    {
-        this->mutex->unlock();
-        return SampleEscrowTransactionPtr();
-    }
-
-    this->mutex->unlock();
-    return (*tx);
+    return this->ledger->GetHistoryEntry(client, txIndex);
 }
 
-BtcUnspentOutputs SampleEscrowServer::GetOutputsToSpend(const std::string &client, const int64_t &amountToSpend)
+bool SampleEscrowServer::GetClientTransactions(const std::string &client, u_int64_t fromIndex, u_int64_t maxCount, SampleEscrowTransactions &transactions, u_int64_t &totalCount)
 {
-    this->mutex->lock();
-
-    BtcUnspentOutputs outputsToSpend = BtcUnspentOutputs();
+    totalCount = this->ledger->GetHistory(client, fromIndex, maxCount, transactions);
+    return true;
+}
 
-    ClientBalanceMap::iterator clientBalanceMap = this->clientBalancesMap.find(client);
-    if(clientBalanceMap == this->clientBalancesMap.end())
+BtcCoinSelectionPtr SampleEscrowServer::SelectOutputsToSpend(const std::string &client, const int64_t &amount)
+{
+    // the fee depends on how many inputs are needed, each one carrying minSignatures signatures
+    BtcCoinSelectionParams params;
+    params.inputSize = BtcCoinSelectionParams::MultiSigInputSize(this->minSignatures, this->serverPool->escrowServers.size());
+
+    // only outputs that count towards the balance, listunspent also has unconfirmed ones
+    std::set<std::string> successfull;
+    SampleEscrowTransactions deposits = this->ledger->GetDeposits(client);
+    foreach(SampleEscrowTransactionPtr tx, deposits)
     {
-        this->mutex->unlock();
-        return outputsToSpend;        
+        if(tx->status == SampleEscrowTransaction::Successfull)
+            successfull.insert(OutPoint(tx->txId, tx->vout));
     }
 
-    int64_t currentBalance = int64_t(0);
-    foreach(SampleEscrowTransactionPtr tx, clientBalanceMap->second)
+    BtcUnspentOutputs spendable;
+    BtcUnspentOutputs outputs = this->utxos->GetByOwner(client);
+    foreach(BtcUnspentOutputPtr output, outputs)
     {
-        if(std::find(this->multiSigAddresses.begin(), this->multiSigAddresses.end(), tx->targetAddr) == this->multiSigAddresses.end())
-            continue;
-
-        BtcUnspentOutputPtr output = BtcUnspentOutputPtr(new BtcUnspentOutput(Json::Value(Json::objectValue)));
-        output->txId = tx->txId;
-        output->address = tx->targetAddr;
-        output->amount = tx->amountToSend;
-        output->vout = tx->vout;
-        output->scriptPubKey = tx->scriptPubKey;
-        outputsToSpend.push_back(output);
-        currentBalance += tx->amountToSend;
+        if(successfull.find(OutPoint(output->txId, output->vout)) != successfull.end())
+            spendable.push_back(output);
     }
 
-    this->mutex->unlock();
-
-    if(currentBalance >= amountToSpend)
-        return outputsToSpend;
-    else
-        return BtcUnspentOutputs();
+    return this->modules->btcHelper->SelectOutputs(spendable, amount, params);
 }
 
 bool SampleEscrowServer::RequestEscrowWithdrawal(const std::string &client, const int64_t &amount, const std::string &toAddress)
 {
     this->mutex->lock();
 
-    // check client balance
-    int64_t spendable = GetClientBalance(client);
-    if(spendable < amount + BtcHelper::FeeMultiSig)
+    // the client's confirmed deposits have to pay the amount and the fee for spending them
+    if(SelectOutputsToSpend(client, amount) == NULL)
     {
         this->mutex->unlock();
         return false;
@@ -653,7 +773,7 @@ bool SampleEscrowServer::RequestEscrowWithdrawal(const std::string &client, cons
     request->amount = amount;
     request->address = toAddress;
     request->action = ClientRequest::StartReleaseDeposit;
-    this->clientRequests.push_back(request);
+    QueueRequest(request);
 
     this->mutex->unlock();
 
@@ -675,3 +795,25 @@ std::string SampleEscrowServer::RequestSignedWithdrawal(const std::string &clien
         return std::string();
     }
 }
+
+bool SampleEscrowServer::SetLedgerFile(const std::string &path)
+{
+    if(!this->ledger->SetJournalFile(path))
+        return false;
+
+    // the multisig addresses from before the restart, so their outputs are found again
+    std::vector<std::pair<std::string, std::string> > addresses = this->ledger->GetAddresses();
+
+    this->mutex->lock();
+    for(std::vector<std::pair<std::string, std::string> >::iterator address = addresses.begin(); address != addresses.end(); address++)
+    {
+        this->multiSigAddress[address->first] = address->second;   // the newest one is the current address
+        this->addressToClientMap[address->second] = address->first;
+        this->utxos->SetOwner(address->second, address->first);
+        if(std::find(this->multiSigAddresses.begin(), this->multiSigAddresses.end(), address->second) == this->multiSigAddresses.end())
+            this->multiSigAddresses.push_back(address->second);
+    }
+    this->mutex->unlock();
+
+    return true;
+}
@@ -5,9 +5,11 @@
 #include "core/ExportWrapper.h"
 #include "core/TR1_Wrapper.hpp"
 
+#include <bitcoin/escrowledger.hpp>
 #include <bitcoin/escrowpool.hpp>
 #include <bitcoin/sampleescrowtransaction.hpp>
 
+#include <QElapsedTimer>
 #include <QObject>
 #include <QThread>
 
@@ -18,10 +20,12 @@
 
 class QTimer;
 class QMutex;
+class QWaitCondition;
 
 class SampleEscrowClient;
 typedef _SharedPtr<SampleEscrowClient> SampleEscrowClientPtr;
 
+// watches bitcoind and checks the deposits whenever a block comes in or the mempool changes
 class CheckTxDaemon : public QObject
 {
     Q_OBJECT
@@ -40,6 +44,7 @@ private:
 class SampleEscrowServer : public QThread
 {
     friend class CheckTxDaemon;
+    friend class BtcTest;
     Q_OBJECT
 public:
     SampleEscrowServer(BitcoinServerPtr rpcServer, EscrowPoolPtr pool, QObject* parent = NULL);
@@ -62,12 +67,24 @@ public:
 
     virtual SampleEscrowTransactionPtr GetClientTransaction(const std::string &client, u_int64_t txIndex);
 
+    // up to maxCount transactions of the client's history starting at fromIndex,
+    // totalCount is the length of the whole history. returns false if the server couldn't be asked
+    virtual bool GetClientTransactions(const std::string &client, u_int64_t fromIndex, u_int64_t maxCount, SampleEscrowTransactions &transactions, u_int64_t &totalCount);
+
     virtual bool RequestEscrowWithdrawal(const std::string &client, const int64_t &amount, const std::string &toAddress);
 
     // called from server to server
     // returns a partially signed raw transaction
     virtual std::string RequestSignedWithdrawal(const std::string &client);
 
+    // keeps the deposits, history and multisig addresses in this file across restarts
+    bool SetLedgerFile(const std::string &path);
+
+    static const int RequestRetryDelay = 250;           // ms before a request that couldn't be completed is tried again
+    static const int ServerLoopTimeout = 1000;          // ms the server loop waits for requests before checking for shutdown
+    static const int ChainPollInterval = 1000;          // ms between checks if bitcoind has a new block or mempool
+    static const int MemPoolFallbackInterval = 10000;   // ms between deposit checks if bitcoind can't tell us about its mempool
+
     std::string serverName;             // name of this server
 
     EscrowPoolPtr serverPool;           // the pool that this server is part of
@@ -105,12 +122,29 @@ protected:
     void AddClientDeposit(const std::string &client, SampleEscrowTransactionPtr transaction, bool oldTx);
     void RemoveClientDeposit(const std::string &client, SampleEscrowTransactionPtr transaction);
     SampleEscrowTransactionPtr FindClientTransaction(const std::string &targetAddress, const std::string &txId, const std::string &client);
-    BtcUnspentOutputs GetOutputsToSpend(const std::string &client, const int64_t &amountToSpend);
+    // Successfull deposits of the client that pay amount plus fee, NULL if there aren't enough
+    BtcCoinSelectionPtr SelectOutputsToSpend(const std::string &client, const int64_t &amount);
 
     struct ClientRequest;
     typedef _SharedPtr<ClientRequest> ClientRequestPtr;
     typedef std::list<ClientRequestPtr> ClientRequests;
-    ClientRequests clientRequests;
+    ClientRequests clientRequests;      // guarded by requestMutex
+
+    // adds a request and wakes up the server loop, delay in ms
+    void QueueRequest(ClientRequestPtr request, int delay = 0);
+    // returns the next request that is due or NULL, doesn't wait
+    ClientRequestPtr TakeRequest();
+    // ms until the next request is due, at most timeout
+    int TimeUntilNextRequest(int timeout);
+    void ProcessRequest(ClientRequestPtr request);
+
+    // blocks until a request is due or timeout ms have passed
+    virtual void WaitForEvents(int timeout);
+
+    // asks bitcoind if there's a new block or the mempool changed since last time
+    bool ChainStateChanged(bool &newBlock);
+    // blocks until NotifyChainChanged() is called or timeout ms have passed
+    void WaitForChainEvent(int timeout);
 
     BtcModulesPtr modules;
 
@@ -118,6 +152,8 @@ private:
     virtual std::string CreatePubKey(const std::string &client);
     virtual void AddPubKey(const std::string &client, const std::string &key);
 
+    int NextRequestDelay(int timeout);  // requestMutex has to be locked
+
     BitcoinServerPtr rpcServer;     // login info for bitcoin-qt rpc
 
     int32_t minSignatures;          // minimum required signatures
@@ -125,16 +161,37 @@ private:
     int minConfirms;            // minimum required confirmations
 
     std::map<std::string, SampleEscrowClientPtr> clientList;
-    typedef std::map<std::string, SampleEscrowTransactions> ClientBalanceMap;
-    ClientBalanceMap clientBalancesMap;  // list of deposit transactions
-    ClientBalanceMap clientHistoryMap;     // list of all transactions
+
+    EscrowLedgerPtr ledger;         // deposits and history of all clients, has its own locks
+    BtcUtxoSetPtr utxos;            // unspent outputs of the multisig addresses by client, from the last listunspent
 
     QMutex* mutex;
 
+    QMutex* requestMutex;
+    QWaitCondition* requestArrived;
+
+    QMutex* chainMutex;
+    QWaitCondition* chainChanged;
+    bool chainNotified;
+
+    std::string bestBlockHash;      // chain state seen by the last check
+    int64_t memPoolSize;
+    int64_t memPoolBytes;
+    qint64 lastFallbackCheck;
+
+    QElapsedTimer clock;            // used for request delays
+
 public slots:
+    // handles all requests that are due
     virtual void Update();
     void StartServerLoop();
-    void CheckTransactions();
+    // newBlock: also recheck the confirmations of pending deposits
+    // returns false if bitcoind couldn't tell which deposits are spent (nothing was removed then)
+    // or if the ledger's journal couldn't be written
+    bool CheckTransactions(bool newBlock = true);
+    // checks the deposits right away instead of waiting for the next poll,
+    // e.g. when bitcoind's -blocknotify or -walletnotify fires
+    void NotifyChainChanged();
 };
 
 typedef _SharedPtr<SampleEscrowServer> SampleEscrowServerPtr;
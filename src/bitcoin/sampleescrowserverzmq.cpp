@@ -1,5 +1,6 @@
 #include "sampleescrowserverzmq.hpp"
 #include "sampleescrowclientzmq.hpp"
+#include "zmqconnectionpool.hpp"
 
 #include <core/modules.hpp>
 
@@ -13,7 +14,9 @@
 //    #include <zmq.hpp>
 //#endif
 
+#include <algorithm>
 #include <string>
+#include <vector>
 #include <cstdio>
 #include <QTime>
 
@@ -30,6 +33,7 @@ SampleEscrowServerZmq::SampleEscrowServerZmq(BitcoinServerPtr bitcoind, EscrowPo
     this->serverInfo = BitcoinServerPtr(new BitcoinServer(this->serverName, "", "*", port));
 
     this->isClient = false;
+    this->legacyServer = false;
 
     this->master = SampleEscrowServerZmqPtr();
 
@@ -48,6 +52,7 @@ SampleEscrowServerZmq::SampleEscrowServerZmq(BitcoinServerPtr bitcoind, EscrowPo
     this->context = NULL;
 
     this->master = master;
+    this->legacyServer = false;
 
     this->connectString = "tcp://";
     this->connectString += this->serverInfo->url + ":";
@@ -61,12 +66,9 @@ SampleEscrowServerZmq::~SampleEscrowServerZmq()
     this->shutDown = true;
     wait();
 
-    zmq_close(this->serverSocket);
-#ifdef OT_USE_ZMQ4
-    zmq_ctx_term(this->context);
-#else
-    zmq_term(this->context);
-#endif
+    // the context belongs to ZmqConnectionPool
+    if(this->serverSocket != NULL)
+        zmq_close(this->serverSocket);
 }
 
 void SampleEscrowServerZmq::Update()
@@ -75,6 +77,24 @@ void SampleEscrowServerZmq::Update()
     UpdateServer();
 }
 
+void SampleEscrowServerZmq::WaitForEvents(int timeout)
+{
+    if(this->serverSocket == NULL)
+    {
+        SampleEscrowServer::WaitForEvents(timeout);
+        return;
+    }
+
+    // requests are mostly queued by this thread while it answers messages,
+    // so waiting on the socket is enough most of the time
+    int wait = std::min(TimeUntilNextRequest(timeout), static_cast<int>(ZmqPollInterval));
+    if(wait <= 0)
+        return;
+
+    zmq_pollitem_t items[] = { { this->serverSocket, 0, ZMQ_POLLIN, 0 } };
+    zmq_poll(&items[0], 1, wait);
+}
+
 bool SampleEscrowServerZmq::ClientConnected(SampleEscrowClient *client)
 {
     if(!this->isClient)
@@ -264,6 +284,104 @@ SampleEscrowTransactionPtr SampleEscrowServerZmq::GetClientTransaction(BtcNetMsg
     return SampleEscrowServer::GetClientTransaction(message->client, message->txIndex);
 }
 
+bool SampleEscrowServerZmq::GetClientTransactions(const std::string &client, u_int64_t fromIndex, u_int64_t maxCount, SampleEscrowTransactions &transactions, u_int64_t &totalCount)
+{
+    if(!this->isClient)
+        return SampleEscrowServer::GetClientTransactions(client, fromIndex, maxCount, transactions, totalCount);
+
+    if(this->legacyServer)
+        return GetClientTransactionsLegacy(client, fromIndex, maxCount, transactions, totalCount);
+
+    BtcNetMsgGetTxs message;
+    message.client = client;
+    message.fromIndex = fromIndex;
+    message.maxCount = maxCount;
+
+    ZmqConnectionPool::WaitCallback whileWaiting;
+    if(this->master != NULL)
+        whileWaiting = fastdelegate::MakeDelegate(this->master.get(), &SampleEscrowServerZmq::UpdateServer);
+
+    std::string rawReply = ZmqConnectionPool::GetInstance()->SendRawRequest(this->connectString, message.Encode(), whileWaiting);
+
+    NetMessageType messageType = Unknown;
+    std::string payload;
+    BtcNetMsgTxList reply;
+    if(!ParseNetFrame(rawReply, messageType, payload) || messageType != TxList || !reply.Decode(payload))
+    {
+        // servers from before the frames don't answer them. if it still answers the old messages, stick to those
+        if(!GetClientTransactionsLegacy(client, fromIndex, maxCount, transactions, totalCount))
+            return false;
+
+        this->legacyServer = true;
+        return true;
+    }
+
+    transactions.clear();
+    for(std::vector<BtcNetMsgTxList::Record>::iterator record = reply.transactions.begin(); record != reply.transactions.end(); record++)
+    {
+        SampleEscrowTransactionPtr tx = SampleEscrowTransactionPtr(new SampleEscrowTransaction(record->amount, BtcModulesPtr()));
+        tx->txId = record->txId;
+        tx->targetAddr = record->toAddress;
+        tx->type = (SampleEscrowTransaction::Type)record->type;
+        tx->status = (SampleEscrowTransaction::SUCCESS)record->status;
+        transactions.push_back(tx);
+    }
+
+    totalCount = reply.totalCount;
+    return true;
+}
+
+bool SampleEscrowServerZmq::GetClientTransactionsLegacy(const std::string &client, u_int64_t fromIndex, u_int64_t maxCount, SampleEscrowTransactions &transactions, u_int64_t &totalCount)
+{
+    BtcNetMsgGetTxCountPtr message = BtcNetMsgGetTxCountPtr(new BtcNetMsgGetTxCount());
+    memcpy(message->client, client.c_str(), 20);
+
+    BtcNetMsg* rawReply = SendData((BtcNetMsg*)message.get());
+    if(rawReply == NULL)
+        return false;
+
+    BtcNetMsgTxCountPtr reply = BtcNetMsgTxCountPtr(new BtcNetMsgTxCount());
+    memcpy(reply->data, rawReply->data, NetMsgTxCountSize);
+
+    delete[] rawReply;
+
+    totalCount = reply->txCount;
+
+    transactions.clear();
+    for(u_int64_t txIndex = fromIndex; txIndex < totalCount && txIndex - fromIndex < maxCount; txIndex++)
+    {
+        SampleEscrowTransactionPtr tx = GetClientTransaction(client, txIndex);
+        if(tx == NULL)
+            break;      // keep what we got, the rest is fetched next time
+        transactions.push_back(tx);
+    }
+
+    return true;
+}
+
+std::string SampleEscrowServerZmq::GetClientTransactions(const BtcNetMsgGetTxs &message)
+{
+    SampleEscrowTransactions transactions;
+    u_int64_t totalCount = 0;
+    SampleEscrowServer::GetClientTransactions(message.client, message.fromIndex, std::min<u_int64_t>(message.maxCount, NetMaxTxsPerReply), transactions, totalCount);
+
+    BtcNetMsgTxList reply;
+    reply.fromIndex = message.fromIndex;
+    reply.totalCount = totalCount;
+    foreach(SampleEscrowTransactionPtr tx, transactions)
+    {
+        BtcNetMsgTxList::Record record;
+        record.txId = tx->txId;
+        record.toAddress = tx->targetAddr;
+        record.amount = tx->amountToSend;
+        record.type = static_cast<int8_t>(tx->type);
+        record.status = static_cast<int8_t>(tx->status);
+        reply.transactions.push_back(record);
+    }
+
+    return reply.Encode();
+}
+
 bool SampleEscrowServerZmq::RequestEscrowWithdrawal(const std::string &client, const int64_t &amount, const std::string &toAddress)
 {
     if(!this->isClient)
@@ -318,108 +436,78 @@ std::string SampleEscrowServerZmq::RequestSignedWithdrawal(BtcNetMsgReqSignedTxP
 
 BtcNetMsg* SampleEscrowServerZmq::SendData(BtcNetMsg* message)
 {
-    // Prepare our context and socket
-    zmq_context_t* context = zmq_init(1);
-    zmq_socket_t* socket = zmq_socket(context, ZMQ_REQ);
+    // keep answering requests while we wait, the reply might depend on it
+    ZmqConnectionPool::WaitCallback whileWaiting;
+    if(this->master != NULL)
+        whileWaiting = fastdelegate::MakeDelegate(this->master.get(), &SampleEscrowServerZmq::UpdateServer);
 
-    // Configure socket to not wait at close time
-    int timeOut = 3000;
-#ifdef OT_USE_ZMQ4
-    zmq_setsockopt(socket, ZMQ_RCVTIMEO, &timeOut, sizeof(timeOut));
-    zmq_setsockopt(socket, ZMQ_SNDTIMEO, &timeOut, sizeof(timeOut));
-#endif
-    int linger = 0;
-    zmq_setsockopt(socket, ZMQ_LINGER, &linger, sizeof (linger));
-
-    if(zmq_connect(socket, this->connectString.c_str()) != 0)
-    {
-        int error = zmq_errno();
+    return ZmqConnectionPool::GetInstance()->SendRequest(this->connectString, message, whileWaiting);
+}
 
-        zmq_close(socket);
-        zmq_term(context);
-        return NULL;
-    }
+bool SampleEscrowServerZmq::IsRemote(SampleEscrowServerPtr server)
+{
+    SampleEscrowServerZmq* zmqServer = dynamic_cast<SampleEscrowServerZmq*>(server.get());
+    return zmqServer != NULL && zmqServer->isClient;
+}
 
-    size_t size = NetMessageSizes[static_cast<NetMessageType>(message->MessageType)];
-    zmq_msg_t* request = new zmq_msg_t();
-    zmq_msg_init_size(request, size);
-    zmq_msg_init_data(request, message->data, size, NULL, NULL);
+std::vector<BtcNetMsg*> SampleEscrowServerZmq::SendDataToAll(const std::vector<SampleEscrowServerPtr> &servers, BtcNetMsg *message)
+{
+    std::vector<BtcNetMsg*> replies(servers.size(), static_cast<BtcNetMsg*>(NULL));
 
-//#ifdef OT_USE_ZMQ4
-    if(zmq_msg_send(request, socket, 0) == -1)
-//#else
-//    if(zmq_send(socket, request, 0 ) == -1)
-//#endif
+    std::vector<std::string> peers;
+    std::vector<BtcNetMsg*> messages;
+    std::vector<size_t> remoteServers;
+    ZmqConnectionPool::WaitCallback whileWaiting;
+    for(size_t i = 0; i < servers.size(); i++)
     {
-        zmq_close(socket);
-        zmq_term(context);
-        return NULL;
-    }
+        if(!IsRemote(servers[i]))
+            continue;
 
-    zmq_msg_t reply;
-    zmq_msg_init(&reply);
+        SampleEscrowServerZmq* server = static_cast<SampleEscrowServerZmq*>(servers[i].get());
+        peers.push_back(server->connectString);
+        messages.push_back(message);
+        remoteServers.push_back(i);
 
-    bool incomingData = false;
-    for(int i = 0; i < 3; i++)
-    {
-        // Wait for response from server
-        zmq_pollitem_t items[] = { { socket, 0, ZMQ_POLLIN, 0 } };
-        zmq_poll (&items[0], 1, 1000);
-
-        // Cancel if there is no response
-        if ((items[0].revents & ZMQ_POLLIN))
-        {
-            incomingData = true;
-            break;
-        }
-
-        if(master != NULL)
-        {
-            master->UpdateServer();
-        }
+        if(whileWaiting.empty() && server->master != NULL)
+            whileWaiting = fastdelegate::MakeDelegate(server->master.get(), &SampleEscrowServerZmq::UpdateServer);
     }
 
-    if(!incomingData)
-    {
-        zmq_close(socket);
-        zmq_term(context);
-        zmq_msg_close(&reply);
-        return NULL;
-    }
+    if(peers.empty())
+        return replies;
 
-//#ifdef OT_USE_ZMQ4
-    zmq_msg_recv(&reply, socket, 0);
-//#else
-//    zmq_recv(socket, &reply, 0);
-//#endif
-
-    if(zmq_msg_size(&reply) < NetMessageSizes[Unknown])
-    {
-        zmq_close(socket);
-        zmq_term(context);
-        zmq_msg_close(&reply);
-        return NULL;
-    }
+    std::vector<BtcNetMsg*> remoteReplies = ZmqConnectionPool::GetInstance()->SendRequests(peers, messages, whileWaiting);
+    for(size_t i = 0; i < remoteServers.size(); i++)
+        replies[remoteServers[i]] = remoteReplies[i];
 
-    NetMessageType messageType = static_cast<NetMessageType>(static_cast<BtcNetMsg*>(zmq_msg_data(&reply))->MessageType);
+    return replies;
+}
 
-    if(messageType == Unknown || zmq_msg_size(&reply) < NetMessageSizes[messageType])
+std::string SampleEscrowServerZmq::HandleFrame(const std::string &frame)
+{
+    NetMessageType messageType = Unknown;
+    std::string payload;
+    if(ParseNetFrame(frame, messageType, payload))
     {
-        zmq_close(socket);
-        zmq_term(context);
-        zmq_msg_close(&reply);
-        return NULL;
-    }
-
-    char* data = new char[NetMessageSizes[messageType]];
-    memcpy(data, zmq_msg_data(&reply), NetMessageSizes[messageType]);
+        switch(messageType)
+        {
+        case GetTxs:
+        {
+            BtcNetMsgGetTxs message;
+            if(!message.Decode(payload))
+                break;
 
-    zmq_close(socket);
-    zmq_term(context);
-    zmq_msg_close(&reply);
+            return GetClientTransactions(message);
+        }
+        default:
+            break;
+        }
+    }
 
-    return (BtcNetMsg*) data;
+    std::printf("received malformed message\n");
+    std::cout.flush();
 
+    // an empty frame of type Unknown, like the NULL packet for fixed-size messages
+    return NetMsgWriter().Frame(Unknown);
 }
 
 void SampleEscrowServerZmq::StartServer()
@@ -427,9 +515,9 @@ void SampleEscrowServerZmq::StartServer()
     std::printf("starting server %s on port %d\n", this->serverName.c_str(), this->serverInfo->port);
     std::cout.flush();
 
-    // Prepare our context and socket
-    this->context = zmq_init(1);
-    this->serverSocket = zmq_socket(this->context, ZMQ_REP);
+    // ROUTER so we can answer pooled DEALER sockets, see ZmqConnectionPool
+    this->context = ZmqConnectionPool::GetInstance()->GetContext();
+    this->serverSocket = zmq_socket(this->context, ZMQ_ROUTER);
 
     // Configure socket to not wait at close time
     int timeOut = 3000;
@@ -452,47 +540,34 @@ void SampleEscrowServerZmq::UpdateServer()
 {
     //while (!Modules::shutDown)
     {
-        zmq_msg_t request; // = new zmq_msg_t();
-        zmq_msg_init(&request);
-
-        // Wait for next request from client
-        zmq_pollitem_t item;
-        item.socket = this->serverSocket;
-        item.fd = 0;
-        item.events = ZMQ_POLLIN;
-        item.revents = 0;
-        /*zmq_pollitem_t items[] = { item }; //{ this->serverSocket, 0, ZMQ_POLLIN, 0 } };
-        zmq_poll(&items[0], 1, 1000);
-
-        // Return if no request
-        if (!(items[0].revents & ZMQ_POLLIN))
-        {
-            zmq_msg_close(&request);
+        // the ROUTER socket gives us [identity][empty][request id][message] from ZmqConnectionPool,
+        // plain REQ sockets leave out the request id
+        std::vector<std::string> frames;
+        if(!ZmqReceiveFrames(this->serverSocket, frames, ZMQ_DONTWAIT))
             return;
-        }*/
 
-//#ifdef OT_USE_ZMQ4
-        if(zmq_msg_recv(&request, this->serverSocket, ZMQ_DONTWAIT) == -1)
-//#else
-//        if(zmq_recv(this->serverSocket, &request, ZMQ_NOBLOCK) == -1)
-//#endif
-        {
-            zmq_msg_close(&request);
+        std::vector<std::string>::iterator delimiter = std::find(frames.begin(), frames.end(), std::string());
+        if(delimiter == frames.end() || frames.end() - delimiter < 2 || frames.end() - delimiter > 3)
             return;
-        }
 
-        if(zmq_msg_size(&request) < NetMessageSizes[Unknown])
+        // the reply goes back with everything in front of the message
+        std::vector<std::string> envelope(frames.begin(), frames.end() - 1);
+        const std::string &request = frames.back();
+
+        if(IsNetFrame(request.data(), request.size()))
         {
-            zmq_msg_close(&request);
+            envelope.push_back(HandleFrame(request));
+            ZmqSendFrames(this->serverSocket, envelope);
             return;
         }
 
-        NetMessageType messageType = static_cast<NetMessageType>(static_cast<BtcNetMsg*>(zmq_msg_data(&request))->MessageType);
-        if(zmq_msg_size(&request) != NetMessageSizes[messageType])
-        {
-            zmq_msg_close(&request);
+        if(request.size() < NetMessageSizes[Unknown])
+            return;
+
+        NetMessageType messageType = static_cast<NetMessageType>(reinterpret_cast<const BtcNetMsg*>(request.data())->MessageType);
+        std::map<NetMessageType, size_t>::const_iterator expectedSize = NetMessageSizes.find(messageType);
+        if(expectedSize == NetMessageSizes.end() || request.size() != expectedSize->second)
             return;
-        }
 
         BtcNetMsg* replyPtr = new BtcNetMsg();
 
@@ -505,7 +580,7 @@ void SampleEscrowServerZmq::UpdateServer()
         case Connect:
         {
             BtcNetMsgConnectPtr message = BtcNetMsgConnectPtr(new BtcNetMsgConnect());
-            memcpy(message->data, zmq_msg_data(&request), NetMessageSizes[messageType]);
+            memcpy(message->data, request.data(), NetMessageSizes[messageType]);
             ClientConnected(message);
             std::printf("client connected\n");
             std::cout.flush();
@@ -514,7 +589,7 @@ void SampleEscrowServerZmq::UpdateServer()
         case ReqDeposit:
         {
             BtcNetMsgReqDepositPtr message = BtcNetMsgReqDepositPtr(new BtcNetMsgReqDeposit());
-            memcpy(message->data, zmq_msg_data(&request), NetMessageSizes[messageType]);
+            memcpy(message->data, request.data(), NetMessageSizes[messageType]);
             bool accepted = RequestEscrowDeposit(message);
 
             BtcNetMsgDepositReply* replyMsg = new BtcNetMsgDepositReply();
@@ -525,7 +600,7 @@ void SampleEscrowServerZmq::UpdateServer()
         case GetMultiSigAddr:
         {
             BtcNetMsgGetDepositAddrPtr message = BtcNetMsgGetDepositAddrPtr(new BtcNetMsgGetDepositAddr());
-            memcpy(message->data, zmq_msg_data(&request), NetMessageSizes[messageType]);
+            memcpy(message->data, request.data(), NetMessageSizes[messageType]);
             std::string multiSigAddr = RequestDepositAddress(message);
 
             if(multiSigAddr.empty())
@@ -541,7 +616,7 @@ void SampleEscrowServerZmq::UpdateServer()
         case GetMultiSigKey:
         {
             BtcNetMsgGetKeyPtr message = BtcNetMsgGetKeyPtr(new BtcNetMsgGetKey());
-            memcpy(message->data, zmq_msg_data(&request), NetMessageSizes[messageType]);
+            memcpy(message->data, request.data(), NetMessageSizes[messageType]);
             std::string pubKey = GetPubKey(message);
 
             if(pubKey.empty())
@@ -555,7 +630,7 @@ void SampleEscrowServerZmq::UpdateServer()
         case GetBalance:
         {
             BtcNetMsgGetBalancePtr message = BtcNetMsgGetBalancePtr(new BtcNetMsgGetBalance());
-            memcpy(message->data, zmq_msg_data(&request), NetMessageSizes[messageType]);
+            memcpy(message->data, request.data(), NetMessageSizes[messageType]);
             int64_t balance = GetClientBalance(message);
 
             BtcNetMsgBalance* replyMsg = new BtcNetMsgBalance();
@@ -566,7 +641,7 @@ void SampleEscrowServerZmq::UpdateServer()
         case GetTxCount:
         {
             BtcNetMsgGetTxCountPtr message = BtcNetMsgGetTxCountPtr(new BtcNetMsgGetTxCount());
-            memcpy(message->data, zmq_msg_data(&request), NetMessageSizes[messageType]);
+            memcpy(message->data, request.data(), NetMessageSizes[messageType]);
             int32_t txCount = GetClientTransactionCount(message);
 
             BtcNetMsgTxCount* replyMsg = new BtcNetMsgTxCount();
@@ -577,7 +652,7 @@ void SampleEscrowServerZmq::UpdateServer()
         case GetTx:
         {
             BtcNetMsgGetTxPtr message = BtcNetMsgGetTxPtr(new BtcNetMsgGetTx());
-            memcpy(message->data, zmq_msg_data(&request), NetMessageSizes[messageType]);
+            memcpy(message->data, request.data(), NetMessageSizes[messageType]);
             SampleEscrowTransactionPtr tx = GetClientTransaction(message);
 
             if(tx == NULL)
@@ -596,7 +671,7 @@ void SampleEscrowServerZmq::UpdateServer()
         case RequestRelease:
         {      
             BtcNetMsgReqWithdrawPtr message = BtcNetMsgReqWithdrawPtr(new BtcNetMsgReqWithdraw());
-            memcpy(message->data, zmq_msg_data(&request), NetMessageSizes[messageType]);
+            memcpy(message->data, request.data(), NetMessageSizes[messageType]);
             bool accepted = RequestEscrowWithdrawal(message);
 
             BtcNetMsgWithdrawReply* replyMsg = new BtcNetMsgWithdrawReply();
@@ -607,7 +682,7 @@ void SampleEscrowServerZmq::UpdateServer()
         case ReqSignedTx:
         {
             BtcNetMsgReqSignedTxPtr message = BtcNetMsgReqSignedTxPtr(new BtcNetMsgReqSignedTx());
-            memcpy(message->data, zmq_msg_data(&request), NetMessageSizes[messageType]);
+            memcpy(message->data, request.data(), NetMessageSizes[messageType]);
             std::string partiallySignedTx = RequestSignedWithdrawal(message);
 
             if(partiallySignedTx.empty())
@@ -624,9 +699,10 @@ void SampleEscrowServerZmq::UpdateServer()
             break;
         }
 
-        zmq_msg_close(&request);
-
         // Send reply back to client
+        for(size_t i = 0; i < envelope.size(); i++)
+            zmq_send(this->serverSocket, envelope[i].data(), envelope[i].size(), ZMQ_SNDMORE);
+
         size_t size = NetMessageSizes[(NetMessageType)replyPtr->MessageType];
         zmq_msg_t reply;
         zmq_msg_init_size(&reply, size);
@@ -4,6 +4,8 @@
 #include "sampleescrowserver.hpp"
 #include "samplenetmessages.hpp"
 
+#include <vector>
+
 //#ifdef OT_USE_ZMQ4
     #include <zmq.h>
 //#else
@@ -50,6 +52,9 @@ public:
     virtual SampleEscrowTransactionPtr GetClientTransaction(const std::string &client, const u_int64_t txIndex);
     virtual SampleEscrowTransactionPtr GetClientTransaction(BtcNetMsgGetTxPtr message);
 
+    virtual bool GetClientTransactions(const std::string &client, u_int64_t fromIndex, u_int64_t maxCount, SampleEscrowTransactions &transactions, u_int64_t &totalCount);
+    virtual std::string GetClientTransactions(const BtcNetMsgGetTxs &message);  // returns a TxList frame
+
     virtual bool RequestEscrowWithdrawal(const std::string &sender, const int64_t &amount, const std::string &toAddress);
     virtual bool RequestEscrowWithdrawal(BtcNetMsgReqWithdrawPtr message);
 
@@ -60,13 +65,34 @@ public:
 
     BtcNetMsg *SendData(BtcNetMsg *message);
 
+    // true if server is reached over the network
+    static bool IsRemote(SampleEscrowServerPtr server);
+
+    // sends message to all remote servers at once, replies[i] belongs to servers[i]
+    // and is NULL if servers[i] isn't remote or didn't answer, delete[] the replies after use
+    static std::vector<BtcNetMsg*> SendDataToAll(const std::vector<SampleEscrowServerPtr> &servers, BtcNetMsg *message);
+
+    // ms we wait on the socket before looking for requests queued from other threads
+    static const int ZmqPollInterval = 100;
+
+protected:
+    // waits for a message on the socket or a queued request
+    virtual void WaitForEvents(int timeout);
+
 private:
+    // answers a variable-length request, returns the reply frame
+    std::string HandleFrame(const std::string &frame);
+
+    // asks for the transactions one at a time, for servers that don't understand frames yet
+    bool GetClientTransactionsLegacy(const std::string &client, u_int64_t fromIndex, u_int64_t maxCount, SampleEscrowTransactions &transactions, u_int64_t &totalCount);
+
     typedef void zmq_socket_t;
     typedef void zmq_context_t;
     zmq_socket_t* serverSocket;
     zmq_context_t* context;
     SampleEscrowServerZmqPtr master;
     std::string connectString;
+    bool legacyServer;          // didn't answer a frame, but did answer a fixed-size message
 
 public slots:
     virtual void Update();
@@ -86,5 +86,8 @@ void SampleEscrowTransaction::CheckTransaction(int minConfirms)
             this->status = Conflicted;
     }
 
-    this->confirmations = this->modules->mtBitcoin->GetConfirmations(rawTx->txId);
+    // -1 if it's too deep to count, it can't have fewer confirmations than last time then
+    int32_t confirmations = this->modules->mtBitcoin->GetConfirmations(rawTx->txId);
+    if(confirmations >= 0)
+        this->confirmations = confirmations;
 }
@@ -1,4 +1,5 @@
 #include "samplenetmessages.hpp"
+#include <algorithm>
 #include <cstring>
 
 std::map<NetMessageType, size_t> NetMessageSizes = std::map<NetMessageType, size_t>();
@@ -132,3 +133,203 @@ BtcNetMsgSignedTx::BtcNetMsgSignedTx()
     memset(this->data, 0, NetMsgSignedTxSize);
     this->MessageType = SignedTx;
 }
+
+void NetMsgWriter::Reserve(size_t size)
+{
+    this->data.reserve(size);
+}
+
+void NetMsgWriter::WriteVarInt(uint64_t value)
+{
+    while(value >= 0x80)
+    {
+        this->data.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    this->data.push_back(static_cast<char>(value));
+}
+
+void NetMsgWriter::WriteSignedVarInt(int64_t value)
+{
+    WriteVarInt((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+void NetMsgWriter::WriteString(const std::string &value)
+{
+    WriteVarInt(value.size());
+    this->data.append(value);
+}
+
+std::string NetMsgWriter::Frame(NetMessageType type) const
+{
+    NetMsgWriter header;
+    header.WriteVarInt(static_cast<uint64_t>(type));
+    header.WriteVarInt(this->data.size());
+
+    std::string frame;
+    frame.reserve(1 + header.data.size() + this->data.size());
+    frame.push_back(static_cast<char>(NetFrameVersion));
+    frame.append(header.data);
+    frame.append(this->data);
+    return frame;
+}
+
+NetMsgReader::NetMsgReader(const std::string &payload, size_t offset)
+    :data(payload)
+{
+    this->offset = std::min(offset, payload.size());
+}
+
+bool NetMsgReader::ReadVarInt(uint64_t &value)
+{
+    value = 0;
+    for(int shift = 0; shift < 64; shift += 7)
+    {
+        if(this->offset >= this->data.size())
+            return false;
+
+        uint64_t byte = static_cast<unsigned char>(this->data[this->offset++]);
+
+        // the 10th byte may only hold the last bit
+        if(shift == 63 && byte > 1)
+            return false;
+
+        value |= (byte & 0x7F) << shift;
+        if(!(byte & 0x80))
+            return true;
+    }
+
+    return false;
+}
+
+bool NetMsgReader::ReadSignedVarInt(int64_t &value)
+{
+    uint64_t zigzag = 0;
+    if(!ReadVarInt(zigzag))
+        return false;
+
+    value = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+    return true;
+}
+
+bool NetMsgReader::ReadString(std::string &value)
+{
+    uint64_t length = 0;
+    if(!ReadVarInt(length) || length > this->data.size() - this->offset)
+        return false;
+
+    value.assign(this->data, this->offset, static_cast<size_t>(length));
+    this->offset += static_cast<size_t>(length);
+    return true;
+}
+
+bool NetMsgReader::AtEnd() const
+{
+    return this->offset == this->data.size();
+}
+
+size_t NetMsgReader::GetOffset() const
+{
+    return this->offset;
+}
+
+bool IsNetFrame(const char *data, size_t size)
+{
+    return size > 0 && static_cast<unsigned char>(data[0]) == NetFrameVersion;
+}
+
+bool ParseNetFrame(const std::string &frame, NetMessageType &type, std::string &payload)
+{
+    if(!IsNetFrame(frame.data(), frame.size()) || frame.size() > NetMaxFrameSize)
+        return false;
+
+    NetMsgReader reader(frame, 1);
+
+    uint64_t rawType = 0, length = 0;
+    if(!reader.ReadVarInt(rawType) || !reader.ReadVarInt(length) || rawType > 0xFFFF)
+        return false;
+
+    // the frame has to be exactly as long as it says
+    if(length != frame.size() - reader.GetOffset())
+        return false;
+
+    type = static_cast<NetMessageType>(rawType);
+    payload.assign(frame, reader.GetOffset(), static_cast<size_t>(length));
+    return true;
+}
+
+BtcNetMsgGetTxs::BtcNetMsgGetTxs()
+{
+    this->fromIndex = 0;
+    this->maxCount = 0;
+}
+
+std::string BtcNetMsgGetTxs::Encode() const
+{
+    NetMsgWriter writer;
+    writer.WriteString(this->client);
+    writer.WriteVarInt(this->fromIndex);
+    writer.WriteVarInt(this->maxCount);
+    return writer.Frame(GetTxs);
+}
+
+bool BtcNetMsgGetTxs::Decode(const std::string &payload)
+{
+    NetMsgReader reader(payload);
+    return reader.ReadString(this->client) &&
+           reader.ReadVarInt(this->fromIndex) &&
+           reader.ReadVarInt(this->maxCount) &&
+           reader.AtEnd();
+}
+
+BtcNetMsgTxList::BtcNetMsgTxList()
+{
+    this->fromIndex = 0;
+    this->totalCount = 0;
+}
+
+std::string BtcNetMsgTxList::Encode() const
+{
+    NetMsgWriter writer;
+    writer.Reserve(32 + this->transactions.size() * 128);      // txid + address + a few varints
+    writer.WriteVarInt(this->fromIndex);
+    writer.WriteVarInt(this->totalCount);
+    writer.WriteVarInt(this->transactions.size());
+    for(std::vector<Record>::const_iterator tx = this->transactions.begin(); tx != this->transactions.end(); tx++)
+    {
+        writer.WriteString(tx->txId);
+        writer.WriteString(tx->toAddress);
+        writer.WriteSignedVarInt(tx->amount);
+        writer.WriteSignedVarInt(tx->type);
+        writer.WriteSignedVarInt(tx->status);
+    }
+    return writer.Frame(TxList);
+}
+
+bool BtcNetMsgTxList::Decode(const std::string &payload)
+{
+    NetMsgReader reader(payload);
+
+    uint64_t count = 0;
+    if(!reader.ReadVarInt(this->fromIndex) || !reader.ReadVarInt(this->totalCount) || !reader.ReadVarInt(count))
+        return false;
+
+    // count comes from the network, so no reserve(), a short payload just fails below
+    this->transactions.clear();
+    for(uint64_t i = 0; i < count; i++)
+    {
+        this->transactions.push_back(Record());
+        Record &tx = this->transactions.back();
+
+        int64_t type = 0, status = 0;
+        if(!reader.ReadString(tx.txId) || !reader.ReadString(tx.toAddress) || !reader.ReadSignedVarInt(tx.amount) ||
+           !reader.ReadSignedVarInt(type) || !reader.ReadSignedVarInt(status))
+            return false;
+
+        tx.type = static_cast<int8_t>(type);
+        tx.status = static_cast<int8_t>(status);
+    }
+
+    // anything left over means the message isn't what we think it is
+    return reader.AtEnd();
+}
@@ -2,6 +2,8 @@
 #define SAMPLENETMESSAGES_H
 
 #include <map>
+#include <string>
+#include <vector>
 #include "core/TR1_Wrapper.hpp"
 #include <stdint.h>
 
@@ -26,7 +28,9 @@ enum NetMessageType
     RequestRelease,
     WithdrawReply,
     ReqSignedTx,
-    SignedTx
+    SignedTx,
+    GetTxs,         // only sent as a variable-length frame, see below
+    TxList
 };
 
 
@@ -278,6 +282,99 @@ extern std::map<NetMessageType, size_t> NetMessageSizes;
 
 void InitNetMessages();
 
+
+/*
+ * Variable-length messages
+ *
+ * frame: [version][type][payload length][payload]
+ * The version is one byte, type and length are varints. The payload is made of
+ * varints and length-prefixed strings, so nothing is padded or cut off.
+ *
+ * The version byte can't be mistaken for the start of a fixed-size message above,
+ * those begin with their MessageType which is a small number.
+ */
+
+#define NetFrameVersion 0xB1
+#define NetMaxFrameSize (1024 * 1024)
+#define NetMaxTxsPerReply 1000
+
+// builds a payload
+class NetMsgWriter
+{
+public:
+    void Reserve(size_t size);
+
+    void WriteVarInt(uint64_t value);           // LEB128, 1 byte for values < 128
+    void WriteSignedVarInt(int64_t value);      // zigzag, so small negative numbers stay small
+    void WriteString(const std::string &value);
+
+    // puts the payload into a frame ready to be sent
+    std::string Frame(NetMessageType type) const;
+
+private:
+    std::string data;
+};
+
+// reads a payload, every Read fails once the data is used up or malformed
+// payload has to outlive the reader
+class NetMsgReader
+{
+public:
+    NetMsgReader(const std::string &payload, size_t offset = 0);
+
+    bool ReadVarInt(uint64_t &value);
+    bool ReadSignedVarInt(int64_t &value);
+    bool ReadString(std::string &value);
+
+    bool AtEnd() const;
+    size_t GetOffset() const;
+
+private:
+    const std::string &data;
+    size_t offset;
+};
+
+// true if data starts like a frame
+bool IsNetFrame(const char* data, size_t size);
+
+// splits a frame into type and payload, false if it's not a complete and valid frame
+bool ParseNetFrame(const std::string &frame, NetMessageType &type, std::string &payload);
+
+// asks for up to maxCount transactions of a client's history starting at fromIndex
+struct BtcNetMsgGetTxs
+{
+    std::string client;
+    uint64_t fromIndex;
+    uint64_t maxCount;
+
+    BtcNetMsgGetTxs();
+
+    std::string Encode() const;
+    bool Decode(const std::string &payload);
+};
+
+// the transactions asked for, all in one frame
+struct BtcNetMsgTxList
+{
+    struct Record
+    {
+        std::string txId;
+        std::string toAddress;
+        int64_t amount;
+        int8_t type;
+        int8_t status;
+    };
+
+    uint64_t fromIndex;
+    uint64_t totalCount;        // number of transactions the client has, including those not sent
+    std::vector<Record> transactions;
+
+    BtcNetMsgTxList();
+
+    std::string Encode() const;
+    bool Decode(const std::string &payload);
+};
+
 typedef _SharedPtr<BtcNetMsg>               BtcNetMsgPtr;
 typedef _SharedPtr<BtcNetMsgConnect>        BtcNetMsgConnectPtr;
 typedef _SharedPtr<BtcNetMsgReqDeposit>     BtcNetMsgReqDepositPtr;
@@ -296,6 +393,8 @@ typedef _SharedPtr<BtcNetMsgReqWithdraw>    BtcNetMsgReqWithdrawPtr;
 typedef _SharedPtr<BtcNetMsgWithdrawReply>  BtcNetMsgWithdrawReplyPtr;
 typedef _SharedPtr<BtcNetMsgReqSignedTx>    BtcNetMsgReqSignedTxPtr;
 typedef _SharedPtr<BtcNetMsgSignedTx>       BtcNetMsgSignedTxPtr;
+typedef _SharedPtr<BtcNetMsgGetTxs>         BtcNetMsgGetTxsPtr;
+typedef _SharedPtr<BtcNetMsgTxList>         BtcNetMsgTxListPtr;
 
 
 #endif // SAMPLENETMESSAGES_H
@@ -0,0 +1,281 @@
+#ifndef __STABLE_HPP__
+#include <core/stable.hpp>
+#endif
+
+#include <bitcoin/zmqconnectionpool.hpp>
+
+#include <zmq.h>
+
+#include <QElapsedTimer>
+#include <QMutex>
+
+#include <algorithm>
+#include <cstring>
+
+
+ZmqConnectionPool* ZmqConnectionPool::GetInstance()
+{
+    static ZmqConnectionPool* instance = new ZmqConnectionPool();
+    return instance;
+}
+
+ZmqConnectionPool::ZmqConnectionPool()
+{
+    this->context = zmq_init(1);
+    this->mutex = new QMutex();
+    this->nextRequestId = 1;
+}
+
+void* ZmqConnectionPool::GetContext()
+{
+    return this->context;
+}
+
+BtcNetMsg* ZmqConnectionPool::SendRequest(const std::string &peer, BtcNetMsg *message, WaitCallback whileWaiting)
+{
+    std::vector<std::string> peers(1, peer);
+    std::vector<BtcNetMsg*> messages(1, message);
+
+    return SendRequests(peers, messages, whileWaiting)[0];
+}
+
+std::vector<BtcNetMsg*> ZmqConnectionPool::SendRequests(const std::vector<std::string> &peers, const std::vector<BtcNetMsg*> &messages, WaitCallback whileWaiting)
+{
+    std::vector<BtcNetMsg*> replies(peers.size(), static_cast<BtcNetMsg*>(NULL));
+    if(peers.size() != messages.size())
+        return replies;
+
+    std::vector<std::string> requests(messages.size());
+    for(size_t i = 0; i < messages.size(); i++)
+    {
+        std::map<NetMessageType, size_t>::const_iterator size = NetMessageSizes.find(static_cast<NetMessageType>(messages[i]->MessageType));
+        if(size != NetMessageSizes.end())
+            requests[i] = std::string(messages[i]->data, size->second);
+    }
+
+    std::vector<std::string> rawReplies = SendRawRequests(peers, requests, whileWaiting);
+    for(size_t i = 0; i < rawReplies.size(); i++)
+        replies[i] = CopyReply(rawReplies[i]);
+
+    return replies;
+}
+
+std::string ZmqConnectionPool::SendRawRequest(const std::string &peer, const std::string &request, WaitCallback whileWaiting)
+{
+    std::vector<std::string> peers(1, peer);
+    std::vector<std::string> requests(1, request);
+
+    return SendRawRequests(peers, requests, whileWaiting)[0];
+}
+
+std::vector<std::string> ZmqConnectionPool::SendRawRequests(const std::vector<std::string> &peers, const std::vector<std::string> &requests, WaitCallback whileWaiting)
+{
+    std::vector<std::string> replies(peers.size());
+    if(peers.size() != requests.size())
+        return replies;
+
+    // send everything first, then wait for all replies together
+    std::vector<void*> sockets(peers.size(), static_cast<void*>(NULL));
+    std::vector<std::string> requestIds(peers.size());
+    size_t pending = 0;
+    for(size_t i = 0; i < peers.size(); i++)
+    {
+        if(requests[i].empty())
+            continue;
+
+        sockets[i] = CheckOutSocket(peers[i]);
+        if(sockets[i] == NULL)
+            continue;
+
+        this->mutex->lock();
+        uint64_t requestId = this->nextRequestId++;
+        this->mutex->unlock();
+        requestIds[i] = std::string(reinterpret_cast<const char*>(&requestId), sizeof(requestId));
+
+        std::vector<std::string> frames;
+        frames.push_back(std::string());        // empty delimiter, like a REQ socket would send
+        frames.push_back(requestIds[i]);
+        frames.push_back(requests[i]);
+
+        if(!ZmqSendFrames(sockets[i], frames))
+        {
+            CloseSocket(sockets[i]);
+            sockets[i] = NULL;
+            continue;
+        }
+
+        pending++;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    while(pending > 0)
+    {
+        int timeLeft = ReplyTimeout - static_cast<int>(timer.elapsed());
+        if(timeLeft <= 0)
+            break;
+
+        std::vector<zmq_pollitem_t> items;
+        std::vector<size_t> itemPeers;
+        for(size_t i = 0; i < sockets.size(); i++)
+        {
+            if(sockets[i] == NULL)
+                continue;
+
+            zmq_pollitem_t item = { sockets[i], 0, ZMQ_POLLIN, 0 };
+            items.push_back(item);
+            itemPeers.push_back(i);
+        }
+
+        zmq_poll(&items[0], static_cast<int>(items.size()), std::min(timeLeft, static_cast<int>(PollInterval)));
+
+        for(size_t item = 0; item < items.size(); item++)
+        {
+            if(!(items[item].revents & ZMQ_POLLIN))
+                continue;
+
+            size_t i = itemPeers[item];
+            std::vector<std::string> frames;
+            while(ZmqReceiveFrames(sockets[i], frames, ZMQ_DONTWAIT))
+            {
+                // anything but [empty][our id][message] is a late reply to an older request
+                if(frames.size() != 3 || !frames[0].empty() || frames[1] != requestIds[i])
+                    continue;
+
+                replies[i].swap(frames[2]);
+
+                ReturnSocket(peers[i], sockets[i]);
+                sockets[i] = NULL;
+                pending--;
+                break;
+            }
+        }
+
+        if(pending > 0 && !whileWaiting.empty())
+            whileWaiting();
+    }
+
+    // the reply might still come in later, don't hand out these sockets again
+    for(size_t i = 0; i < sockets.size(); i++)
+    {
+        if(sockets[i] != NULL)
+            CloseSocket(sockets[i]);
+    }
+
+    return replies;
+}
+
+void* ZmqConnectionPool::CheckOutSocket(const std::string &peer)
+{
+    this->mutex->lock();
+
+    std::vector<void*> &sockets = this->idleSockets[peer];
+    if(!sockets.empty())
+    {
+        void* socket = sockets.back();
+        sockets.pop_back();
+        this->mutex->unlock();
+        return socket;
+    }
+
+    this->mutex->unlock();
+
+    void* socket = zmq_socket(this->context, ZMQ_DEALER);
+    if(socket == NULL)
+        return NULL;
+
+    // Configure socket to not wait at close time
+    int linger = 0;
+    zmq_setsockopt(socket, ZMQ_LINGER, &linger, sizeof(linger));
+#ifdef OT_USE_ZMQ4
+    int timeOut = ReplyTimeout;
+    zmq_setsockopt(socket, ZMQ_SNDTIMEO, &timeOut, sizeof(timeOut));
+#endif
+
+    if(zmq_connect(socket, peer.c_str()) != 0)
+    {
+        zmq_close(socket);
+        return NULL;
+    }
+
+    return socket;
+}
+
+void ZmqConnectionPool::ReturnSocket(const std::string &peer, void *socket)
+{
+    this->mutex->lock();
+
+    std::vector<void*> &sockets = this->idleSockets[peer];
+    if(sockets.size() < MaxIdleSockets)
+    {
+        sockets.push_back(socket);
+        socket = NULL;
+    }
+
+    this->mutex->unlock();
+
+    if(socket != NULL)
+        CloseSocket(socket);
+}
+
+void ZmqConnectionPool::CloseSocket(void *socket)
+{
+    zmq_close(socket);
+}
+
+BtcNetMsg* ZmqConnectionPool::CopyReply(const std::string &reply)
+{
+    if(reply.size() < NetMsgSize)
+        return NULL;
+
+    int64_t messageType = Unknown;
+    memcpy(&messageType, reply.data(), sizeof(messageType));
+    if(messageType == Unknown)
+        return NULL;
+
+    std::map<NetMessageType, size_t>::const_iterator size = NetMessageSizes.find(static_cast<NetMessageType>(messageType));
+    if(size == NetMessageSizes.end() || reply.size() < size->second)
+        return NULL;
+
+    char* data = new char[size->second];
+    memcpy(data, reply.data(), size->second);
+
+    return (BtcNetMsg*) data;
+}
+
+bool ZmqReceiveFrames(void *socket, std::vector<std::string> &frames, int flags)
+{
+    frames.clear();
+
+    bool more = true;
+    while(more)
+    {
+        zmq_msg_t frame;
+        zmq_msg_init(&frame);
+
+        // the other frames of a message arrive together with the first one
+        if(zmq_msg_recv(&frame, socket, frames.empty() ? flags : 0) == -1)
+        {
+            zmq_msg_close(&frame);
+            return false;
+        }
+
+        frames.push_back(std::string(static_cast<char*>(zmq_msg_data(&frame)), zmq_msg_size(&frame)));
+        more = zmq_msg_more(&frame) != 0;
+
+        zmq_msg_close(&frame);
+    }
+
+    return true;
+}
+
+bool ZmqSendFrames(void *socket, const std::vector<std::string> &frames)
+{
+    for(size_t i = 0; i < frames.size(); i++)
+    {
+        if(zmq_send(socket, frames[i].data(), frames[i].size(), i + 1 < frames.size() ? ZMQ_SNDMORE : 0) == -1)
+            return false;
+    }
+
+    return true;
+}
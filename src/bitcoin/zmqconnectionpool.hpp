@@ -0,0 +1,82 @@
+#ifndef ZMQCONNECTIONPOOL_HPP
+#define ZMQCONNECTIONPOOL_HPP
+
+#include "core/TR1_Wrapper.hpp"
+
+#include "samplenetmessages.hpp"
+
+#include <bitcoin-api/FastDelegate.hpp>
+
+#include _CINTTYPES
+
+#include <map>
+#include <string>
+#include <vector>
+
+class QMutex;
+
+/*
+ * One zmq context for the whole process and a few open DEALER sockets per peer,
+ * so talking to other escrow servers doesn't cost a new context and tcp connection every time.
+ *
+ * Every request carries an id that the server sends back with the reply.
+ * That way several requests can be in flight at once and late replies to
+ * requests that already timed out are recognized and dropped.
+ *
+ * Wire format (frames): [empty][request id][message]
+ * The server is a ROUTER socket, it still answers plain REQ sockets that leave out the id.
+ *
+ * The pool lives until the process exits.
+ */
+class ZmqConnectionPool
+{
+public:
+    static ZmqConnectionPool* GetInstance();
+
+    // called while waiting for replies, e.g. to keep answering our own requests
+    typedef fastdelegate::FastDelegate0<> WaitCallback;
+
+    // sends message to peer ("tcp://host:port") and waits for the reply
+    // returns NULL on timeout or a malformed reply, delete[] the reply after use
+    BtcNetMsg* SendRequest(const std::string &peer, BtcNetMsg* message, WaitCallback whileWaiting = WaitCallback());
+
+    // sends messages[i] to peers[i], all at once, and waits for the replies
+    // returns the replies in the same order, NULL for peers that didn't answer
+    std::vector<BtcNetMsg*> SendRequests(const std::vector<std::string> &peers, const std::vector<BtcNetMsg*> &messages, WaitCallback whileWaiting = WaitCallback());
+
+    // same for messages in any format, e.g. frames from samplenetmessages.hpp
+    // returns an empty string if there was no reply
+    std::string SendRawRequest(const std::string &peer, const std::string &request, WaitCallback whileWaiting = WaitCallback());
+    std::vector<std::string> SendRawRequests(const std::vector<std::string> &peers, const std::vector<std::string> &requests, WaitCallback whileWaiting = WaitCallback());
+
+    // shared by all sockets of this process
+    void* GetContext();
+
+    static const int ReplyTimeout = 3000;       // ms to wait for replies
+    static const int PollInterval = 100;        // ms between calls to whileWaiting
+    static const size_t MaxIdleSockets = 4;     // open sockets kept per peer
+
+private:
+    ZmqConnectionPool();
+
+    void* CheckOutSocket(const std::string &peer);
+    void ReturnSocket(const std::string &peer, void* socket);
+    void CloseSocket(void* socket);
+
+    // copies the message out of a reply, NULL if it's not a valid one
+    static BtcNetMsg* CopyReply(const std::string &reply);
+
+    void* context;
+
+    QMutex* mutex;
+    std::map<std::string, std::vector<void*> > idleSockets;    // peer -> connected sockets nobody uses right now
+    uint64_t nextRequestId;
+};
+
+// receives all frames of a multipart message, returns false if there wasn't one
+bool ZmqReceiveFrames(void* socket, std::vector<std::string> &frames, int flags = 0);
+
+// sends frames as one multipart message
+bool ZmqSendFrames(void* socket, const std::vector<std::string> &frames);
+
+#endif // ZMQCONNECTIONPOOL_HPP
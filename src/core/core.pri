@@ -6,6 +6,8 @@ HEADERS += \
     $${PWD}/httpinterface.hpp \
     $${PWD}/modules.hpp \
     $${PWD}/moneychanger.hpp \
+    $${PWD}/recordlistpopulator.hpp \
+    $${PWD}/otlock.hpp \
     $${PWD}/ot_worker.hpp \
     $${PWD}/passwordcallback.hpp \
     $${PWD}/translation.hpp \
@@ -19,12 +21,16 @@ HEADERS += \
     ../../src/core/mtcomms.h \
     ../../src/core/network/base64.h \
     ../../src/core/network/BitMessageQueue.h \
+    ../../src/core/network/NetworkTest.h \
     $$PWD/handlers/focuser.h \
     $$PWD/handlers/modeltradearchive.hpp \
     $$PWD/handlers/modelmessages.hpp \
     $$PWD/handlers/modelpayments.hpp \
     $$PWD/handlers/modelclaims.hpp \
     $$PWD/handlers/modelverifications.hpp \
+    $$PWD/handlers/searchindex.hpp \
+    $$PWD/handlers/handlertest.hpp \
+    $$PWD/handlers/recordarchiver.hpp \
     $$PWD/mapidname.hpp
 
 SOURCES += \
@@ -34,6 +40,8 @@ SOURCES += \
     $${PWD}/main.cpp \
     $${PWD}/modules.cpp \
     $${PWD}/moneychanger.cpp \
+    $${PWD}/recordlistpopulator.cpp \
+    $${PWD}/otlock.cpp \
     $${PWD}/ot_worker.cpp \
     $${PWD}/passwordcallback.cpp \
     $${PWD}/translation.cpp \
@@ -47,11 +55,15 @@ SOURCES += \
     ../../src/core/mtcomms.cpp \
     ../../src/core/network/base64.cpp \
     ../../src/core/network/BitMessageQueue.cpp \
+    ../../src/core/network/NetworkTest.cpp \
     $$PWD/handlers/modeltradearchive.cpp \
     $$PWD/handlers/modelmessages.cpp \
     $$PWD/handlers/modelpayments.cpp \
     $$PWD/handlers/modelclaims.cpp \
-    $$PWD/handlers/modelverifications.cpp
+    $$PWD/handlers/modelverifications.cpp \
+    $$PWD/handlers/searchindex.cpp \
+    $$PWD/handlers/handlertest.cpp \
+    $$PWD/handlers/recordarchiver.cpp
 
 mac: {
   OBJECTIVE_SOURCES += ../../src/core/handlers/focuser.mm
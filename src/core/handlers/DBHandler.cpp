@@ -34,6 +34,7 @@ DBHandler::~DBHandler()
 }
 
 DBHandler::DBHandler()
+: ownerThread_(QThread::currentThread())
 {
 
     if (!QSqlDatabase::isDriverAvailable (dbDriverStr))
@@ -47,15 +48,20 @@ DBHandler::DBHandler()
     
     bool flag = isDbExist();
     qDebug() << QString(opentxs::OTPaths::AppDataFolder().Get()) + dbFileNameStr;
-    db.setDatabaseName( QString(opentxs::OTPaths::AppDataFolder().Get()) + dbFileNameStr);
+    dbPath_ = QString(opentxs::OTPaths::AppDataFolder().Get()) + dbFileNameStr;
+    db.setDatabaseName(dbPath_);
     if(!dbConnect())
         qDebug() << "Error Opening Database";
     
+    dbConfigure();
+
 //    if (!flag)  // The database now creates the tables if they don't exist, so we call this every time now.
     {
         qDebug() << "Running dbCreateInstance";
         dbCreateInstance();
     }
+
+    dbMigrate();
 }
 
 /*
@@ -77,6 +83,7 @@ bool DBHandler::dbConnect()
 
 bool DBHandler::dbDisconnect()
 {
+    clearStatementCache();
 
     db.close();
     if(!db.isOpen())
@@ -387,6 +394,220 @@ bool DBHandler::dbCreateInstance()
     return error;
 }
 
+// --------------------------------------------
+// Schema migrations.
+//
+// dbCreateInstance() only ever creates missing tables, so anything that has to
+// change on a database that already exists goes here instead. The schema
+// version is kept in SQLite's own PRAGMA user_version (0 for every database
+// created before this existed). Migration N takes the schema from version N-1
+// to N; each one runs in a transaction along with the version bump, so it
+// either applies completely or not at all.
+//
+// Append new migrations to the end. Never edit one that has shipped.
+//
+static const char * const db_migration_1[] =
+{
+    // Claims by Nym and section (contact details, claim upserts.)
+    "CREATE INDEX IF NOT EXISTS idx_claim_nym_section ON claim(claim_nym_id, claim_section)",
+    // Relationship claims about a Nym.
+    "CREATE INDEX IF NOT EXISTS idx_claim_value_section ON claim(claim_value, claim_section)",
+    // A verifier's verification of a claim; covers the ver_id/ver_polarity lookup.
+    "CREATE INDEX IF NOT EXISTS idx_claim_verification_claim ON claim_verification(ver_claim_id, ver_verifier_nym_id, ver_id, ver_polarity)",
+    "CREATE INDEX IF NOT EXISTS idx_claim_verification_verifier ON claim_verification(ver_verifier_nym_id)",
+    // Nyms of a contact.
+    "CREATE INDEX IF NOT EXISTS idx_nym_contact ON nym(contact_id)",
+    // Reverse lookups from a messaging address.
+    "CREATE INDEX IF NOT EXISTS idx_nym_method_address ON nym_method(address)",
+    "CREATE INDEX IF NOT EXISTS idx_contact_method_address ON contact_method(address)",
+    "CREATE INDEX IF NOT EXISTS idx_msg_method_type ON msg_method(method_type)",
+    // Finding an existing payment record when archiving or updating it.
+    "CREATE INDEX IF NOT EXISTS idx_payment_txn_display_nym ON payment(txn_id_display, my_nym_id)",
+    // trade_archive has no key. Existing databases may already hold duplicate
+    // receipts, so this can't be UNIQUE.
+    "CREATE INDEX IF NOT EXISTS idx_trade_archive_receipt ON trade_archive(receipt_id)",
+    "ANALYZE",
+    NULL
+};
+
+static const char * const * const db_migrations[] =
+{
+    db_migration_1
+};
+
+static const int db_schema_version = sizeof(db_migrations) / sizeof(db_migrations[0]);
+
+/*
+ * Connection settings. These are per connection, not stored in the schema.
+ */
+bool DBHandler::dbConfigure()
+{
+    QMutexLocker locker(&dbMutex);
+
+    if (!db.isOpen())
+        return false;
+
+    return configureConnection(db);
+}
+
+//static
+bool DBHandler::configureConnection(QSqlDatabase & theDb)
+{
+    QSqlQuery query(theDb);
+
+    bool bSuccess = true;
+
+    // WAL lets the GUI keep reading while a write is in progress, and makes
+    // each commit an append instead of a rewrite of the journal.
+    if (!query.exec("PRAGMA journal_mode=WAL"))
+    {
+        qDebug() << "dbConfigure: Failed setting journal_mode: " << query.lastError();
+        bSuccess = false;
+    }
+    // Safe with WAL: a power failure can lose the last commits, not corrupt the file.
+    if (!query.exec("PRAGMA synchronous=NORMAL"))
+    {
+        qDebug() << "dbConfigure: Failed setting synchronous: " << query.lastError();
+        bSuccess = false;
+    }
+    // Negative means KiB, so 8 MB of page cache.
+    if (!query.exec("PRAGMA cache_size=-8192"))
+    {
+        qDebug() << "dbConfigure: Failed setting cache_size: " << query.lastError();
+        bSuccess = false;
+    }
+    if (!query.exec("PRAGMA temp_store=MEMORY"))
+    {
+        qDebug() << "dbConfigure: Failed setting temp_store: " << query.lastError();
+        bSuccess = false;
+    }
+
+    return bSuccess;
+}
+
+int DBHandler::schemaVersion()
+{
+    QMutexLocker locker(&dbMutex);
+
+    QSqlQuery query(db);
+
+    if (!query.exec("PRAGMA user_version") || !query.next())
+    {
+        qDebug() << "schemaVersion: " << query.lastError();
+        return -1;
+    }
+    return query.value(0).toInt();
+}
+
+bool DBHandler::dbMigrate()
+{
+    const int nVersion = schemaVersion();
+
+    QMutexLocker locker(&dbMutex);
+
+    if (!db.isOpen() || (nVersion < 0))
+        return false;
+
+    if (nVersion > db_schema_version)
+    {
+        // Opened by a newer Moneychanger. Leave it alone; the extra indexes don't hurt us.
+        qDebug() << "Database schema version" << nVersion << "is newer than this build's" << db_schema_version;
+        return true;
+    }
+
+    QSqlQuery query(db);
+
+    for (int nMigration = nVersion; nMigration < db_schema_version; ++nMigration)
+    {
+        if (!db.transaction())
+        {
+            qDebug() << "dbMigrate: Failed starting transaction: " << db.lastError();
+            return false;
+        }
+
+        bool bSuccess = true;
+
+        for (const char * const * pStatement = db_migrations[nMigration]; bSuccess && (NULL != *pStatement); ++pStatement)
+        {
+            if (!query.exec(QString(*pStatement)))
+            {
+                qDebug() << "dbMigrate: Migration" << (nMigration + 1) << "failed on: " << *pStatement << " Error: " << query.lastError();
+                bSuccess = false;
+            }
+        }
+
+        if (bSuccess && !query.exec(QString("PRAGMA user_version=%1").arg(nMigration + 1)))
+        {
+            qDebug() << "dbMigrate: Failed setting user_version: " << query.lastError();
+            bSuccess = false;
+        }
+
+        if (!bSuccess || !db.commit())
+        {
+            db.rollback();
+            return false;
+        }
+
+        qDebug() << "Database schema migrated to version" << (nMigration + 1);
+    }
+
+    locker.unlock();
+    checkQueryPlans();
+
+    return true;
+}
+
+/*
+ * Checks that the lookups the migrations were written for are still answered
+ * from an index. A full table scan here means a query or the schema changed
+ * without the other. dbMigrate() only logs it; HandlerTest fails on it.
+ */
+bool DBHandler::checkQueryPlans()
+{
+    QMutexLocker locker(&dbMutex);
+
+    static const char * const hot_queries[] =
+    {
+        "SELECT * FROM `claim` WHERE `claim_nym_id`='' AND `claim_section`=0",
+        "SELECT * FROM `claim` WHERE `claim_value`='' AND `claim_section`=0",
+        "SELECT `ver_id`,`ver_polarity` FROM `claim_verification` WHERE `ver_claim_id`='' AND `ver_verifier_nym_id`='' LIMIT 0,1",
+        "DELETE FROM `claim_verification` WHERE `ver_verifier_nym_id`=''",
+        "SELECT * FROM `nym` WHERE `contact_id`=0",
+        "SELECT `contact_id` FROM `contact_method` WHERE `address`=''",
+        "SELECT * FROM `nym_method` WHERE `address`='' LIMIT 0,1",
+        "SELECT `payment_id` FROM `payment` WHERE `txn_id_display`=0 AND `my_nym_id`='' LIMIT 0,1",
+        "SELECT * FROM `trade_archive` WHERE `receipt_id`=0 LIMIT 0,1",
+        NULL
+    };
+
+    QSqlQuery query(db);
+
+    bool bAllIndexed = true;
+
+    for (const char * const * pQuery = hot_queries; NULL != *pQuery; ++pQuery)
+    {
+        if (!query.exec(QString("EXPLAIN QUERY PLAN %1").arg(*pQuery)))
+        {
+            qDebug() << "checkQueryPlans: " << query.lastError();
+            bAllIndexed = false;
+            continue;
+        }
+
+        while (query.next())
+        {
+            const QString qstrDetail = query.record().value("detail").toString();
+
+            if (qstrDetail.startsWith("SCAN") && !qstrDetail.contains("INDEX"))
+            {
+                qDebug() << "checkQueryPlans: Full table scan: " << *pQuery << " Plan: " << qstrDetail;
+                bAllIndexed = false;
+            }
+        }
+    }
+
+    return bAllIndexed;
+}
+
 // Unused for now, but too much work to just throw away:
 //    QString qstrQuery(
 //                "SELECT contact.contact_id as contact_id, contact.contact_display_name as contact_display_name,"
@@ -655,7 +876,7 @@ QPointer<ModelTradeArchive> DBHandler::getTradeArchiveModel()
 
 bool DBHandler::isConnected()
 {
-    return db.isOpen();
+    return connection().isOpen();
 }
 
 QString DBHandler::PreparedQuery::lastQuery()
@@ -665,18 +886,18 @@ QString DBHandler::PreparedQuery::lastQuery()
 
 DBHandler::PreparedQuery* DBHandler::prepareQuery(const QString& run)
 {
-  return new PreparedQuery (db, run);
+  return new PreparedQuery (connection(), run);
 }
 
 
 QString DBHandler::formatValue(QSqlField & sqlField)
 {
-    QMutexLocker locker(&dbMutex);
+    QMutexLocker locker(connectionMutex());
 
-    if (!db.isOpen ())
+    if (!connection().isOpen ())
       return "";
 
-    return db.driver()->formatValue(sqlField);
+    return connection().driver()->formatValue(sqlField);
 }
 
 bool DBHandler::runQuery(PreparedQuery* query)
@@ -687,8 +908,8 @@ bool DBHandler::runQuery(PreparedQuery* query)
   std::auto_ptr<PreparedQuery> qu(query);
 #endif /* CXX_11?  */
 
-  QMutexLocker locker(&dbMutex);
-  if (!db.isOpen ())
+  QMutexLocker locker(connectionMutex());
+  if (!connection().isOpen ())
     return false;
 
   return qu->execute ();
@@ -702,8 +923,8 @@ QSqlRecord DBHandler::queryOne(PreparedQuery* query)
   std::auto_ptr<PreparedQuery> qu(query);
 #endif /* CXX_11?  */
 
-  QMutexLocker locker(&dbMutex);
-  if (!db.isOpen ())
+  QMutexLocker locker(connectionMutex());
+  if (!connection().isOpen ())
     throw std::runtime_error ("Database is not open.");
 
   if (!qu->execute ())
@@ -728,13 +949,13 @@ QSqlRecord DBHandler::queryOne(PreparedQuery* query)
 
 bool DBHandler::runQuery(const QString& run)
 {
-    QMutexLocker locker(&dbMutex);
+    QMutexLocker locker(connectionMutex());
     
     bool error = false;
     
-    QSqlQuery query(db);
+    QSqlQuery query(connection());
     
-    if(db.isOpen())
+    if(connection().isOpen())
     {
         error = query.exec(run);
 
@@ -755,13 +976,13 @@ bool DBHandler::runQuery(const QString& run)
 
 int DBHandler::querySize(QString run)
 {
-    QMutexLocker locker(&dbMutex);
+    QMutexLocker locker(connectionMutex());
 
     int size = 0;
     bool noerror = false;
-    QSqlQuery query(db);
+    QSqlQuery query(connection());
     
-    if(db.isOpen())
+    if(connection().isOpen())
     {
         noerror = query.exec(run);
         //size = query.size();
@@ -795,13 +1016,13 @@ int DBHandler::querySize(QString run)
 
 bool DBHandler::isNext(QString run)
 {
-    QMutexLocker locker(&dbMutex);
+    QMutexLocker locker(connectionMutex());
     
     bool isnext = false;
     
-    QSqlQuery query(db);
+    QSqlQuery query(connection());
     
-    if (db.isOpen())
+    if (connection().isOpen())
     {
         isnext = query.exec(run);
         isnext = query.next();
@@ -818,14 +1039,14 @@ bool DBHandler::isNext(QString run)
 
 int DBHandler::queryInt(QString run, int value, int at)
 {
-    QMutexLocker locker(&dbMutex);
+    QMutexLocker locker(connectionMutex());
 
     bool noerror = false;
     int queryResult;
 
-    QSqlQuery query(db);
+    QSqlQuery query(connection());
 
-    if(db.isOpen())
+    if(connection().isOpen())
     {
         noerror = query.exec(run);
         noerror = query.next();
@@ -847,14 +1068,14 @@ int DBHandler::queryInt(QString run, int value, int at)
 
 QString DBHandler::queryString(QString run, int value, int at)
 {
-    QMutexLocker locker(&dbMutex);
+    QMutexLocker locker(connectionMutex());
 
     bool noerror = false;
     QString queryResult;
 
-    QSqlQuery query(db);
+    QSqlQuery query(connection());
 
-    if(db.isOpen())
+    if(connection().isOpen())
     {
         noerror = query.exec(run);
         noerror = query.next();
@@ -875,6 +1096,259 @@ QString DBHandler::queryString(QString run, int value, int at)
 }
 
 
+// -------------------------------------------------------------------------
+// Per-thread connections.
+//
+// The record list populator and the RPC executor resolve names and look up
+// contacts through here. QSqlDatabase only works in the thread that opened it,
+// so instead of sharing db, each of those threads opens the same file again.
+// (WAL lets them read while the GUI thread is writing.)
+
+DBHandler::ThreadConnection::~ThreadConnection()
+{
+    statementCache.clear();
+    db.close();
+    db = QSqlDatabase(); // removeDatabase() complains while a handle is still around.
+
+    QSqlDatabase::removeDatabase(name);
+}
+
+QSqlDatabase & DBHandler::connection()
+{
+    if (QThread::currentThread() == ownerThread_)
+        return db;
+    // ------------------------------------
+    if (!threadConnections_.hasLocalData())
+    {
+        ThreadConnection * pConnection = new ThreadConnection;
+        pConnection->name = QString("%1_%2").arg(dbConnNameStr)
+                .arg(reinterpret_cast<quintptr>(QThread::currentThread()), 0, 16);
+        pConnection->db = QSqlDatabase::addDatabase(dbDriverStr, pConnection->name);
+        pConnection->db.setDatabaseName(dbPath_);
+
+        if (!pConnection->db.open())
+            qDebug() << "connection: Failed opening database: " << pConnection->db.lastError();
+        else
+            configureConnection(pConnection->db);
+
+        threadConnections_.setLocalData(pConnection); // Deleted when this thread exits.
+    }
+    return threadConnections_.localData()->db;
+}
+
+QMutex * DBHandler::connectionMutex()
+{
+    return (QThread::currentThread() == ownerThread_) ? &dbMutex : NULL;
+}
+
+QHash<QString, QSharedPointer<QSqlQuery> > & DBHandler::statementCache()
+{
+    if (QThread::currentThread() == ownerThread_)
+        return statementCache_;
+
+    connection(); // Opens it, if this thread doesn't have one yet.
+
+    return threadConnections_.localData()->statementCache;
+}
+
+// -------------------------------------------------------------------------
+// Statement cache.
+//
+// Building SQL with QString::arg() means every call parses and plans its
+// statement again, in a brand new QSqlQuery. The parameterized calls below
+// prepare each distinct template once and keep it for the life of the
+// connection, so repeated lookups only bind and step.
+
+// connectionMutex() must already be locked.
+QSqlQuery * DBHandler::cachedQuery(const QString& run)
+{
+    QSqlDatabase & theDb = connection();
+
+    if (!theDb.isOpen())
+        return nullptr;
+
+    QHash<QString, QSharedPointer<QSqlQuery> > & theCache = statementCache();
+    QHash<QString, QSharedPointer<QSqlQuery> >::const_iterator it = theCache.constFind(run);
+
+    if (it != theCache.constEnd())
+        return it.value().data();
+    // ------------------------------------
+    // Callers still splice table and column names into the template, so the
+    // set of templates is large but not unbounded. If it does fill up, start over.
+    if (theCache.size() >= maxCachedStatements)
+        theCache.clear();
+
+    QSharedPointer<QSqlQuery> query(new QSqlQuery(theDb));
+    query->setForwardOnly(true);
+
+    if (!query->prepare(run))
+    {
+        qDebug() << "cachedQuery: QSqlQuery::lastError: " << query->lastError().text();
+        qDebug() << QString("THE QUERY (that caused the error): %1").arg(run);
+        return nullptr;
+    }
+
+    theCache.insert(run, query);
+
+    return query.data();
+}
+
+// connectionMutex() must already be locked.
+bool DBHandler::execCached(QSqlQuery * query, const QString& run, const QVariantList& params)
+{
+    for (int ii = 0; ii < params.size(); ++ii)
+        query->bindValue(ii, params.at(ii));
+
+    if (!query->exec())
+    {
+        qDebug() << "execCached: QSqlQuery::lastError: " << query->lastError().text();
+        qDebug() << QString("THE QUERY (that caused the error): %1").arg(run);
+        return false;
+    }
+    return true;
+}
+
+void DBHandler::clearStatementCache()
+{
+    QMutexLocker locker(connectionMutex());
+
+    statementCache().clear();
+}
+
+bool DBHandler::runQuery(const QString& run, const QVariantList& params)
+{
+    QMutexLocker locker(connectionMutex());
+
+    QSqlQuery * query = cachedQuery(run);
+
+    if (nullptr == query)
+        return false;
+
+    const bool bSuccess = execCached(query, run, params);
+
+    query->finish();
+
+    return bSuccess;
+}
+
+QVariant DBHandler::queryValue(const QString& run, const QVariantList& params, int column)
+{
+    QMutexLocker locker(connectionMutex());
+
+    QSqlQuery * query = cachedQuery(run);
+
+    if (nullptr == query || !execCached(query, run, params))
+        return QVariant();
+
+    QVariant value;
+
+    if (query->next())
+        value = query->value(column);
+
+    query->finish(); // Otherwise the statement holds its read lock until the next exec.
+
+    return value;
+}
+
+QString DBHandler::queryString(const QString& run, const QVariantList& params, int column)
+{
+    const QVariant value = queryValue(run, params, column);
+
+    return value.isValid() ? value.toString() : QString("");
+}
+
+int DBHandler::queryInt(const QString& run, const QVariantList& params, int column)
+{
+    const QVariant value = queryValue(run, params, column);
+
+    return value.isValid() ? value.toInt() : 0;
+}
+
+// Values that are spliced into the SQL would make every statement unique, so
+// only parameterized queries go through the statement cache.
+QVariant DBHandler::queryScalar(const QString& run, const QVariantList& params)
+{
+    if (!params.isEmpty())
+        return queryValue(run, params);
+    // ------------------------------------
+    QMutexLocker locker(connectionMutex());
+
+    if (!connection().isOpen())
+        return QVariant();
+
+    QSqlQuery query(connection());
+    query.setForwardOnly(true);
+
+    if (!query.exec(run))
+    {
+        qDebug() << "queryScalar: QSqlQuery::lastError: " << query.lastError().text();
+        qDebug() << QString("THE QUERY (that caused the error): %1").arg(run);
+        return QVariant();
+    }
+
+    return query.next() ? query.value(0) : QVariant();
+}
+
+bool DBHandler::queryExists(const QString& run, const QVariantList& params, bool * pbFailed)
+{
+    const QVariant exists = queryScalar(QString("SELECT EXISTS(%1)").arg(run), params);
+
+    // EXISTS always returns a row, so no value means an error.
+    if (nullptr != pbFailed)
+        *pbFailed = !exists.isValid();
+
+    return exists.isValid() && (exists.toInt() != 0);
+}
+
+bool DBHandler::beginTransaction()
+{
+    QMutexLocker locker(connectionMutex());
+
+    if (!connection().isOpen() || !connection().transaction())
+    {
+        qDebug() << "beginTransaction: Failed starting transaction: " << connection().lastError();
+        return false;
+    }
+    return true;
+}
+
+bool DBHandler::commitTransaction()
+{
+    QMutexLocker locker(connectionMutex());
+
+    if (!connection().commit())
+    {
+        qDebug() << "commitTransaction: Failed committing transaction: " << connection().lastError();
+        return false;
+    }
+    return true;
+}
+
+bool DBHandler::rollbackTransaction()
+{
+    QMutexLocker locker(connectionMutex());
+
+    return connection().rollback();
+}
+
+bool DBHandler::savepoint(const QString& name)
+{
+    return runQuery(QString("SAVEPOINT `%1`").arg(name));
+}
+
+bool DBHandler::releaseSavepoint(const QString& name)
+{
+    return runQuery(QString("RELEASE SAVEPOINT `%1`").arg(name));
+}
+
+// Undoes everything since the savepoint.  ROLLBACK TO leaves the savepoint
+// open, so it's released afterwards as well.
+bool DBHandler::rollbackToSavepoint(const QString& name)
+{
+    return runQuery(QString("ROLLBACK TO SAVEPOINT `%1`").arg(name)) &&
+           releaseSavepoint(name);
+}
+
 // -------------------------------------------------------------------------
 
 /*
@@ -921,13 +1395,13 @@ Assuming that salary is column 2, we can rewrite the last line as follows:
 
 QVariant DBHandler::AddressBookInsertNym(QString nym_id_string, QString nym_display_name_string)
 {
-    QMutexLocker locker(&dbMutex);
+    QMutexLocker locker(connectionMutex());
 
     QString queryResult;
 
-    QSqlQuery query(db);
+    QSqlQuery query(connection());
     
-    if (db.isOpen())
+    if (connection().isOpen())
     {
         if (query.exec(QString("INSERT INTO `address_book` (`id`, `nym_id`, `nym_display_name`) VALUES(NULL, '%1', '%2')").arg(nym_id_string).arg(nym_display_name_string)))
             return query.lastInsertId();
@@ -947,13 +1421,13 @@ QVariant DBHandler::AddressBookInsertNym(QString nym_id_string, QString nym_disp
 
 bool DBHandler::AddressBookUpdateNym(QString nym_id_string, QString nym_display_name_string, QString index_id_string)
 {
-    QMutexLocker locker(&dbMutex);
+    QMutexLocker locker(connectionMutex());
     
     QString queryResult;
     
-    QSqlQuery query(db);
+    QSqlQuery query(connection());
     
-    if (db.isOpen())
+    if (connection().isOpen())
     {
         return query.exec(QString("UPDATE `address_book` SET `nym_id` = '%1', `nym_display_name` = '%2' WHERE `id`='%3'").
                           arg(nym_id_string).arg(nym_display_name_string).arg(index_id_string));
@@ -968,13 +1442,13 @@ bool DBHandler::AddressBookUpdateNym(QString nym_id_string, QString nym_display_
 
 bool DBHandler::AddressBookRemoveID(int ID)
 {
-    QMutexLocker locker(&dbMutex);
+    QMutexLocker locker(connectionMutex());
     
     QString queryResult;
     
-    QSqlQuery query(db);
+    QSqlQuery query(connection());
 
-    if (db.isOpen())
+    if (connection().isOpen())
     {
         return query.exec(QString("DELETE FROM `address_book` WHERE `id` = '%1'").arg(ID));
     }
@@ -988,13 +1462,13 @@ bool DBHandler::AddressBookRemoveID(int ID)
 
 bool DBHandler::AddressBookUpdateDefaultNym(QString ID)
 {
-    QMutexLocker locker(&dbMutex);
+    QMutexLocker locker(connectionMutex());
     
     QString queryResult;
     
-    QSqlQuery query(db);
+    QSqlQuery query(connection());
 
-    if (db.isOpen())
+    if (connection().isOpen())
     {
         if(query.exec(QString("UPDATE `default_nym` SET `nym` = '%1' WHERE `default_id`='1'").arg(ID)))
             return true;
@@ -1015,13 +1489,13 @@ bool DBHandler::AddressBookUpdateDefaultNym(QString ID)
 
 bool DBHandler::AddressBookUpdateDefaultAsset(QString ID)
 {
-    QMutexLocker locker(&dbMutex);
+    QMutexLocker locker(connectionMutex());
     
     QString queryResult;
     
-    QSqlQuery query(db);
+    QSqlQuery query(connection());
 
-    if (db.isOpen())
+    if (connection().isOpen())
     {
         if(query.exec(QString("UPDATE `default_asset` SET `asset` = '%1' WHERE `default_id`='1'").arg(ID)))
             return true;
@@ -1041,13 +1515,13 @@ bool DBHandler::AddressBookUpdateDefaultAsset(QString ID)
 
 bool DBHandler::AddressBookUpdateDefaultAccount(QString ID)
 {
-    QMutexLocker locker(&dbMutex);
+    QMutexLocker locker(connectionMutex());
     
     QString queryResult;
     
-    QSqlQuery query(db);
+    QSqlQuery query(connection());
 
-    if (db.isOpen())
+    if (connection().isOpen())
     {
         if(query.exec(QString("UPDATE `default_account` SET `account` = '%1' WHERE `default_id`='1'").arg(ID)))
             return true;
@@ -1068,13 +1542,13 @@ bool DBHandler::AddressBookUpdateDefaultAccount(QString ID)
 
 bool DBHandler::AddressBookUpdateDefaultServer(QString ID)
 {
-    QMutexLocker locker(&dbMutex);
+    QMutexLocker locker(connectionMutex());
     
     QString queryResult;
     
-    QSqlQuery query(db);
+    QSqlQuery query(connection());
 
-    if (db.isOpen())
+    if (connection().isOpen())
     {
         if(query.exec(QString("UPDATE `default_server` SET `server` = '%1' WHERE `default_id`='1'").arg(ID)))
             return true;
@@ -12,6 +12,8 @@
 
 #include <QDebug>
 #include <QMutex>
+#include <QThread>
+#include <QThreadStorage>
 #include <QSqlDatabase>
 #include <QPointer>
 #include <QSqlError>
@@ -20,6 +22,8 @@
 #include <QSqlRecord>
 #include <QString>
 #include <QVariant>
+#include <QHash>
+#include <QSharedPointer>
 
 #include <memory>
 
@@ -56,21 +60,69 @@ class DBHandler
     QSqlDatabase db;
     FileHandler dbFile;
     QMutex dbMutex;
+
+    // A connection may only be used from the thread that opened it, which for
+    // db (and the table models built on it) is the GUI thread. Any other thread
+    // that queries through here gets its own connection to the same file, with
+    // its own statement cache. Those are closed when the thread exits.
+    struct ThreadConnection
+    {
+        QString      name;
+        QSqlDatabase db;
+        QHash<QString, QSharedPointer<QSqlQuery> > statementCache;
+
+        ~ThreadConnection();
+    };
+    QThreadStorage<ThreadConnection *> threadConnections_;
+    QThread * ownerThread_;
+    QString   dbPath_;
+
+    QSqlDatabase & connection();  // db on the GUI thread, otherwise this thread's own.
+    QMutex * connectionMutex();   // dbMutex guards db. The other connections aren't shared.
+    QHash<QString, QSharedPointer<QSqlQuery> > & statementCache();
     
     QPointer<ModelTradeArchive> pTradeArchiveModel_;
     QPointer<ModelMessages>     pMessageModel_;
     QPointer<ModelPayments>     pPaymentModel_;
 
+    // Prepared statements kept alive for db, keyed by SQL text. Only the
+    // parameterized calls below use it, so the keys are templates rather than
+    // SQL with the values baked in.
+    QHash<QString, QSharedPointer<QSqlQuery> > statementCache_;
+
+    static const int maxCachedStatements = 128;
+
+    QSqlQuery * cachedQuery(const QString& run);
+    bool execCached(QSqlQuery * query, const QString& run, const QVariantList& params);
+    QVariant queryScalar(const QString& run, const QVariantList& params);
+    void clearStatementCache();
+
     bool dbConnect();
     bool isConnected();
     bool dbDisconnect();
     bool isDbExist();
     bool dbRemove();
     bool dbCreateInstance();
+    bool dbConfigure();
+    static bool configureConnection(QSqlDatabase & theDb);
+    bool dbMigrate();
 
   public:
     static DBHandler * getInstance();
 
+    /**
+     * The schema version stored in PRAGMA user_version.
+     * @return The version, or -1 if it couldn't be read.
+     */
+    int schemaVersion();
+
+    /**
+     * EXPLAIN QUERY PLAN for each of the hot lookups the migrations added
+     * indexes for.
+     * @return false if any of them scans a whole table (or can't be planned).
+     */
+    bool checkQueryPlans();
+
     QPointer<ModelTradeArchive> getTradeArchiveModel();
     QPointer<ModelMessages>     getMessageModel();
     QPointer<ModelPayments>     getPaymentModel();
@@ -115,6 +167,63 @@ class DBHandler
     int queryInt(QString run, int value, int at=0);
     QString queryString(QString run, int value, int at=0);
 
+    /**
+     * Run a parameterized query.  The statement is prepared once per
+     * connection and reused; params are bound to its '?' placeholders
+     * in order.
+     * @param run The SQL template string.
+     * @param params The values for its placeholders.
+     * @return True in case of success.
+     */
+    bool runQuery(const QString& run, const QVariantList& params);
+
+    /**
+     * Fetch one column of the first row of a parameterized query.
+     * @param run The SQL template string.
+     * @param params The values for its placeholders.
+     * @param column The column to return.
+     * @return The value, or an invalid QVariant if there was no row or the
+     *         query failed.
+     */
+    QVariant queryValue (const QString& run, const QVariantList& params, int column=0);
+    QString  queryString(const QString& run, const QVariantList& params, int column=0);
+    int      queryInt   (const QString& run, const QVariantList& params, int column=0);
+
+    /**
+     * Whether a SELECT returns any rows.  The SELECT is wrapped in
+     * EXISTS(...), so SQLite stops at the first match instead of stepping
+     * through each row the way querySize() does.
+     * @param run The SELECT to test.
+     * @param params The values for its placeholders, if any.  Without
+     *               params the statement isn't cached.
+     * @param pbFailed If given, set to whether the query failed.  A failed
+     *                 query returns false, so callers that insert a row when
+     *                 there is none must check it, or they'd write over a
+     *                 row that's there.
+     * @return True if there is at least one row.
+     */
+    bool queryExists(const QString& run, const QVariantList& params=QVariantList(), bool * pbFailed=nullptr);
+
+    /**
+     * Group several writes into one SQLite transaction, so they are
+     * committed (and synced) once instead of once per statement.  Every
+     * query on the calling thread's connection runs inside it until commit
+     * or rollback, including those from the table models on the GUI thread.
+     * @return True in case of success.
+     */
+    bool beginTransaction();
+    bool commitTransaction();
+    bool rollbackTransaction();
+
+    /**
+     * Savepoints nest inside a transaction, so one part of it can be undone
+     * without giving up the rest.  The name must be a plain identifier.
+     * @return True in case of success.
+     */
+    bool savepoint(const QString& name);
+    bool releaseSavepoint(const QString& name);
+    bool rollbackToSavepoint(const QString& name);
+
     /**
      * Run a query and for each returned record, execute a callback.  The
      * callback is passed the QSqlRecord for each result.
@@ -126,6 +235,8 @@ class DBHandler
       bool queryMultiple(const QString& run, T cb);
     template<typename T>
       bool queryMultiple(PreparedQuery* run, T cb);
+    template<typename T>
+      bool queryMultiple(const QString& run, const QVariantList& params, T cb);
 
     QVariant AddressBookInsertNym(QString nym_id_string, QString nym_display_name_string);
 
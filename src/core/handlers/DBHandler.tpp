@@ -11,10 +11,10 @@ template<typename T>
   bool
   DBHandler::queryMultiple (const QString& run, T cb)
 {
-  QMutexLocker locker(&dbMutex);
-  QSqlQuery query(db);
+  QMutexLocker locker(connectionMutex());
+  QSqlQuery query(connection());
 
-  if (!db.isOpen ())
+  if (!connection().isOpen ())
     return false;
 
   const bool ok = query.exec (run);
@@ -48,9 +48,9 @@ template<typename T>
 #else /* CXX_11?  */
   std::auto_ptr<PreparedQuery> query(run);
 #endif /* CXX_11?  */
-  QMutexLocker locker(&dbMutex);
+  QMutexLocker locker(connectionMutex());
 
-  if (!db.isOpen ())
+  if (!connection().isOpen ())
     return false;
 
   const bool ok = query->execute ();
@@ -62,3 +62,31 @@ template<typename T>
 
   return true;
 }
+
+/**
+ * Run a parameterized query from the statement cache and for each returned
+ * record, execute a callback.  The callback is passed the QSqlRecord for
+ * each result.
+ * @param run The SQL template string.
+ * @param params The values for its placeholders.
+ * @param cb The callback function called.
+ * @return True in case of success.
+ */
+template<typename T>
+  bool
+  DBHandler::queryMultiple (const QString& run, const QVariantList& params, T cb)
+{
+  QMutexLocker locker(connectionMutex());
+
+  QSqlQuery* query = cachedQuery (run);
+
+  if (nullptr == query || !execCached (query, run, params))
+    return false;
+
+  while (query->next ())
+    cb (query->record ());
+
+  query->finish ();
+
+  return true;
+}
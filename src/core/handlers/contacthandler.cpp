@@ -25,9 +25,103 @@
 #include <QStringList>
 #include <QSqlField>
 #include <QFlags>
+#include <QThread>
 
 #include <tuple>
 
+
+//static
+MTNameCache * MTNameCache::getInstance()
+{
+    // The record list populator and the RPC threads get here too, so let the compiler
+    // make sure only one of them constructs it.
+    static MTNameCache instance;
+    return &instance;
+}
+
+MTNameCache::MTNameCache() : m_generation(0), m_hits(0), m_misses(0)
+{
+}
+
+quint64 MTNameCache::generation()
+{
+    QMutexLocker locker(&m_Mutex);
+    return m_generation;
+}
+
+bool MTNameCache::lookup(NameType type, const std::string & str_id, std::string & str_name)
+{
+    QMutexLocker locker(&m_Mutex);
+
+    std::map<std::string, std::string>::const_iterator it = m_names[type].find(str_id);
+
+    if (it == m_names[type].end())
+    {
+        ++m_misses;
+        return false;
+    }
+    ++m_hits;
+    str_name = it->second;
+    return true;
+}
+
+void MTNameCache::insert(NameType type, const std::string & str_id, const std::string & str_name, quint64 nGeneration)
+{
+    QMutexLocker locker(&m_Mutex);
+
+    if (nGeneration != m_generation) // Something was invalidated while this name was being resolved.
+        return;
+
+    m_names[type][str_id] = str_name;
+}
+
+void MTNameCache::invalidate(NameType type, const std::string & str_id)
+{
+    QMutexLocker locker(&m_Mutex);
+    ++m_generation;
+    m_names[type].erase(str_id);
+}
+
+void MTNameCache::invalidateType(NameType type)
+{
+    QMutexLocker locker(&m_Mutex);
+    ++m_generation;
+    m_names[type].clear();
+}
+
+void MTNameCache::invalidateNym(const std::string & str_nym_id)
+{
+    QMutexLocker locker(&m_Mutex);
+    ++m_generation;
+    m_names[NymName].erase(str_nym_id);
+    // Account and address names can fall back to the owning Nym's name,
+    // and there's no cheap way to tell which ones did.
+    m_names[AcctName].clear();
+    m_names[AddressName].clear();
+}
+
+void MTNameCache::clear()
+{
+    QMutexLocker locker(&m_Mutex);
+    ++m_generation;
+    for (int ii = 0; ii < NameTypeCount; ++ii)
+        m_names[ii].clear();
+}
+
+quint64 MTNameCache::hits()
+{
+    QMutexLocker locker(&m_Mutex);
+    return m_hits;
+}
+
+quint64 MTNameCache::misses()
+{
+    QMutexLocker locker(&m_Mutex);
+    return m_misses;
+}
+
+// ---------------------------------------------------
+
 void MTNameLookupQT::notifyOfSuccessfulNotarization(const std::string & str_acct_id,
                                                     const std::string   p_nym_id,
                                                     const std::string   p_notary_id,
@@ -38,9 +132,27 @@ void MTNameLookupQT::notifyOfSuccessfulNotarization(const std::string & str_acct
     // Add/update record to payments table for whatever
     // transaction just occurred.
 
-    Moneychanger::It()->AddPaymentBasedOnNotification(str_acct_id,
-                                                      p_nym_id, p_notary_id,
-                                                      p_txn_contents, lTransactionNum, lTransNumForDisplay);
+    Moneychanger * pMoneychanger = Moneychanger::It();
+
+    // The record list populator calls this from its own thread, but the payment
+    // model belongs to the GUI thread. (Queued, since the populator is holding
+    // the OT lock, and the GUI thread needs that lock to handle anything.)
+    //
+    if (QThread::currentThread() != pMoneychanger->thread())
+    {
+        QMetaObject::invokeMethod(pMoneychanger, "onSuccessfulNotarization", Qt::QueuedConnection,
+                                  Q_ARG(QString, QString::fromStdString(str_acct_id)),
+                                  Q_ARG(QString, QString::fromStdString(p_nym_id)),
+                                  Q_ARG(QString, QString::fromStdString(p_notary_id)),
+                                  Q_ARG(QString, QString::fromStdString(p_txn_contents)),
+                                  Q_ARG(qint64,  static_cast<qint64>(lTransactionNum)),
+                                  Q_ARG(qint64,  static_cast<qint64>(lTransNumForDisplay)));
+        return;
+    }
+
+    pMoneychanger->AddPaymentBasedOnNotification(str_acct_id,
+                                                 p_nym_id, p_notary_id,
+                                                 p_txn_contents, lTransactionNum, lTransNumForDisplay);
 }
 
 
@@ -51,6 +163,16 @@ std::string MTNameLookupQT::GetNymName(const std::string & str_id,
     // ------------------------
 //    qDebug() << QString("Attempting Name Lookup on: ") << QString(str_id.c_str());
 
+    MTNameCache * pCache = MTNameCache::getInstance();
+    std::string   str_cached;
+
+    // A notary ID means the caller also wants the Nym/server pairing recorded,
+    // so that case always goes the long way round (and refreshes the cache.)
+    if (p_notary_id.empty() && pCache->lookup(MTNameCache::NymName, str_id, str_cached))
+        return str_cached;
+
+    const quint64 nGeneration = pCache->generation();
+
     std::string str_result = this->OTNameLookup::GetNymName(str_id, p_notary_id);
 
 //    qDebug() << QString("Result of Name Lookup: ") << QString(str_result.c_str());
@@ -102,6 +224,8 @@ std::string MTNameLookupQT::GetNymName(const std::string & str_id,
         }
     }
     // ------------------------
+    pCache->insert(MTNameCache::NymName, str_id, str_result, nGeneration);
+
     return str_result;
 }
 
@@ -110,7 +234,14 @@ std::string MTNameLookupQT::GetAcctName(const std::string & str_id,
                                         const std::string   p_notary_id,
                                         const std::string   p_asset_id) const
 {
+    MTNameCache * pCache = MTNameCache::getInstance();
+    const std::string str_key = str_id + "|" + p_nym_id + "|" + p_notary_id + "|" + p_asset_id;
     std::string str_result("");
+
+    if (pCache->lookup(MTNameCache::AcctName, str_key, str_result))
+        return str_result;
+
+    const quint64 nGeneration = pCache->generation();
     // ------------------------
     str_result = this->OTNameLookup::GetAcctName(str_id, p_nym_id, p_notary_id, p_asset_id);
     // ------------------------
@@ -129,6 +260,8 @@ std::string MTNameLookupQT::GetAcctName(const std::string & str_id,
         }
     }
     // ------------------------
+    pCache->insert(MTNameCache::AcctName, str_key, str_result, nGeneration);
+
     return str_result;
 }
 
@@ -136,7 +269,13 @@ std::string MTNameLookupQT::GetAcctName(const std::string & str_id,
 //virtual
 std::string MTNameLookupQT::GetAddressName(const std::string & str_address) const // Used for Bitmessage addresses (etc.)
 {
+    MTNameCache * pCache = MTNameCache::getInstance();
     std::string str_result("");
+
+    if (pCache->lookup(MTNameCache::AddressName, str_address, str_result))
+        return str_result;
+
+    const quint64 nGeneration = pCache->generation();
     // ------------------------
     if (!str_address.empty())
     {
@@ -171,6 +310,44 @@ std::string MTNameLookupQT::GetAddressName(const std::string & str_address) cons
         }
     }
     // ------------------------
+    pCache->insert(MTNameCache::AddressName, str_address, str_result, nGeneration);
+
+    return str_result;
+}
+
+
+std::string MTNameLookupQT::GetServerName(const std::string & str_id) const
+{
+    MTNameCache * pCache = MTNameCache::getInstance();
+    std::string str_result("");
+
+    if (str_id.empty() || pCache->lookup(MTNameCache::ServerName, str_id, str_result))
+        return str_result;
+
+    const quint64 nGeneration = pCache->generation();
+
+    str_result = opentxs::OTAPI_Wrap::It()->GetServer_Name(str_id);
+
+    pCache->insert(MTNameCache::ServerName, str_id, str_result, nGeneration);
+
+    return str_result;
+}
+
+
+std::string MTNameLookupQT::GetAssetName(const std::string & str_id) const
+{
+    MTNameCache * pCache = MTNameCache::getInstance();
+    std::string str_result("");
+
+    if (str_id.empty() || pCache->lookup(MTNameCache::AssetName, str_id, str_result))
+        return str_result;
+
+    const quint64 nGeneration = pCache->generation();
+
+    str_result = opentxs::OTAPI_Wrap::It()->GetAssetType_Name(str_id);
+
+    pCache->insert(MTNameCache::AssetName, str_id, str_result, nGeneration);
+
     return str_result;
 }
 
@@ -202,9 +379,8 @@ MTContactHandler * MTContactHandler::getInstance()
 bool MTContactHandler::claimRecordExists(const QString & claim_id)
 {
     QMutexLocker locker(&m_Mutex);
-    QString str_select_count = QString("SELECT claim_section FROM `claim` WHERE `claim_id`='%1' LIMIT 0,1").arg(claim_id);
-    int nRows = DBHandler::getInstance()->querySize(str_select_count);
-    return (nRows > 0);
+    return DBHandler::getInstance()->queryExists("SELECT claim_section FROM `claim` WHERE `claim_id`=?",
+                                                 QVariantList() << claim_id);
 }
 
 
@@ -572,17 +748,15 @@ bool MTContactHandler::getPolarityIfAny(const QString & claim_id, const QString
 
     bool bReturnValue = false;
 
-    QString str_select = QString("SELECT `ver_id`,`ver_polarity` FROM `claim_verification` WHERE `ver_claim_id`='%1' AND `ver_verifier_nym_id`='%2' LIMIT 0,1").
-            arg(claim_id).arg(verifier_nym_id);
+    QString str_select = "SELECT `ver_polarity` FROM `claim_verification` WHERE `ver_claim_id`=? AND `ver_verifier_nym_id`=? LIMIT 0,1";
 
-    int nRows = 0;
     try
     {
-       nRows = DBHandler::getInstance()->querySize(str_select);
+       const QVariant varPolarity = DBHandler::getInstance()->queryValue(str_select, QVariantList() << claim_id << verifier_nym_id);
        // ---------------------------------------
-       if (nRows > 0)
+       if (varPolarity.isValid()) // Invalid if there's no row.
        {
-           const int polarity = DBHandler::getInstance()->queryInt(str_select, 1, 0);
+           const int polarity = varPolarity.toInt();
            opentxs::OT_API::ClaimPolarity claimPolarity = intToClaimPolarity(polarity);
 
            if (opentxs::OT_API::ClaimPolarity::NEUTRAL == claimPolarity)
@@ -614,51 +788,44 @@ QString MTContactHandler::getDisplayNameFromClaims(const QString & claimant_nym_
     QMutexLocker locker(&m_Mutex);
 
     QString qstrReturnVal;
-    QString str_select = QString("SELECT `claim_value`, `claim_att_active`, `claim_att_primary` FROM `claim` WHERE `claim_nym_id`='%1' AND `claim_section`=%2").
-            arg(claimant_nym_id).arg(opentxs::proto::CONTACTSECTION_NAME);
-
-    int nRows = 0;
-    try
-    {
-       nRows = DBHandler::getInstance()->querySize(str_select);
-    }
-    catch (const std::exception& exc)
-    {
-        qDebug () << "Error: " << exc.what ();
-        return qstrReturnVal;
-    }
-    // ---------------------------------------
-    if (nRows > 0)
-    {
-        QString qstrName, qstrFirstName, qstrInactiveName;
-        bool bActive  = false;
-        bool bPrimary = false;
-
-        for (int nCurrentRow = 0; nCurrentRow < nRows; ++nCurrentRow)
+    QString str_select = "SELECT `claim_value`, `claim_att_active`, `claim_att_primary` FROM `claim` WHERE `claim_nym_id`=? AND `claim_section`=?";
+
+    QString qstrName, qstrFirstName, qstrInactiveName;
+    bool bActive  = false;
+    bool bPrimary = false;
+    bool bDone    = false;
+    int  nCurrentRow = 0;
+
+    // One pass over the rows, instead of running the SELECT again for every column of every row.
+    const bool bRan = DBHandler::getInstance()->queryMultiple(str_select,
+        QVariantList() << claimant_nym_id << static_cast<int>(opentxs::proto::CONTACTSECTION_NAME),
+        [&](const QSqlRecord & record)
         {
-            const QString temp = DBHandler::getInstance()->queryString(str_select, 0, nCurrentRow);
-            const int nActive  = DBHandler::getInstance()->queryInt(str_select, 1, nCurrentRow);
-            const int nPrimary = DBHandler::getInstance()->queryInt(str_select, 2, nCurrentRow);
+            if (bDone) // Found the primary one already.
+                return;
+
+            const int nRow = nCurrentRow++;
+            const QString temp = record.value(0).toString();
 
-            bActive  = !(0 == nActive);
-            bPrimary = !(0 == nPrimary);
+            bActive  = !(0 == record.value(1).toInt());
+            bPrimary = !(0 == record.value(2).toInt());
             // --------------------------
             if (temp.isEmpty())
-                continue;
+                return;
             qstrName = temp;
             // --------------------------
             if (!bActive)
                 qstrInactiveName = qstrName;
-            else if (0 == nCurrentRow)
+            else if (0 == nRow)
                 qstrFirstName = qstrName;
             // --------------------------
             if (bPrimary)
-                break;
-        }
-
+                bDone = true;
+        });
+    // ---------------------------------------
+    if (bRan && (nCurrentRow > 0))
         qstrReturnVal = bPrimary ? qstrName :
                                    (!qstrFirstName.isEmpty() ? qstrFirstName : qstrInactiveName);
-    }
     // ---------------------------------------
     return qstrReturnVal;
 }
@@ -668,42 +835,26 @@ QString MTContactHandler::getNymIdFromClaimsByBtMsg(const QString & bitmessage_a
     QMutexLocker locker(&m_Mutex);
 
     QString qstrReturnVal;
-    QString str_select = QString("SELECT `claim_nym_id` FROM `claim` WHERE `claim_value`='%1' AND `claim_section`=%2").
-            arg(bitmessage_address).arg(opentxs::proto::CONTACTSECTION_BITMESSAGE);
+    QString str_select = "SELECT `claim_nym_id` FROM `claim` WHERE `claim_value`=? AND `claim_section`=?";
 
-    int nRows = 0;
-    try
-    {
-       nRows = DBHandler::getInstance()->querySize(str_select);
-    }
-    catch (const std::exception& exc)
-    {
-        qDebug () << "Error: " << exc.what ();
-        return qstrReturnVal;
-    }
-    // ---------------------------------------
-    if (nRows > 0)
-    {
-        QString qstrNymId;
+    int nFound = 0;
 
-        int nFound = 0;
-        for (int nCurrentRow = 0; nCurrentRow < nRows; ++nCurrentRow)
+    DBHandler::getInstance()->queryMultiple(str_select,
+        QVariantList() << bitmessage_address << static_cast<int>(opentxs::proto::CONTACTSECTION_BITMESSAGE),
+        [&](const QSqlRecord & record)
         {
-            const QString temp = DBHandler::getInstance()->queryString(str_select, 0, nCurrentRow);
+            const QString temp = record.value(0).toString();
             // --------------------------
             if (temp.isEmpty())
-                continue;
+                return;
             nFound++;
             // --------------------------
             if (1 == nFound)
-                qstrNymId = temp;
+                qstrReturnVal = temp;
             else
                 qDebug() << "WARNING JUSTUS: Right now we're just grabbing the first NymId that matches a Bitmessage address, BUT there were multiple matches! CLAIM RETURNED MAY BE FALSE. Need rules "
                             "here so we only return a verified claim!";
-        }
-
-        qstrReturnVal = qstrNymId;
-    }
+        });
     // ---------------------------------------
     return qstrReturnVal;
 }
@@ -713,38 +864,30 @@ QString MTContactHandler::getBitmessageAddressFromClaims(const QString & claiman
     QMutexLocker locker(&m_Mutex);
 
     QString qstrReturnVal;
-    QString str_select = QString("SELECT `claim_value`, `claim_att_active`, `claim_att_primary` FROM `claim` WHERE `claim_nym_id`='%1' AND `claim_section`=%2").
-            arg(claimant_nym_id).arg(opentxs::proto::CONTACTSECTION_BITMESSAGE);
-
-    int nRows = 0;
-    try
-    {
-       nRows = DBHandler::getInstance()->querySize(str_select);
-    }
-    catch (const std::exception& exc)
-    {
-        qDebug () << "Error: " << exc.what ();
-        return qstrReturnVal;
-    }
-    // ---------------------------------------
-    if (nRows > 0)
-    {
-        QString qstrAddress, qstrFirstAddress, qstrInactiveAddress;
-        bool bActive  = false;
-        bool bPrimary = false;
-
-        int nFound = 0;
-        for (int nCurrentRow = 0; nCurrentRow < nRows; ++nCurrentRow)
+    QString str_select = "SELECT `claim_value`, `claim_att_active`, `claim_att_primary` FROM `claim` WHERE `claim_nym_id`=? AND `claim_section`=?";
+
+    QString qstrAddress, qstrFirstAddress, qstrInactiveAddress;
+    bool bActive  = false;
+    bool bPrimary = false;
+    bool bDone    = false;
+    int  nRows    = 0;
+    int  nFound   = 0;
+
+    const bool bRan = DBHandler::getInstance()->queryMultiple(str_select,
+        QVariantList() << claimant_nym_id << static_cast<int>(opentxs::proto::CONTACTSECTION_BITMESSAGE),
+        [&](const QSqlRecord & record)
         {
-            const QString temp = DBHandler::getInstance()->queryString(str_select, 0, nCurrentRow);
-            const int nActive  = DBHandler::getInstance()->queryInt(str_select, 1, nCurrentRow);
-            const int nPrimary = DBHandler::getInstance()->queryInt(str_select, 2, nCurrentRow);
+            if (bDone) // Found the primary one already.
+                return;
+
+            nRows++;
+            const QString temp = record.value(0).toString();
 
-            bActive  = !(0 == nActive);
-            bPrimary = !(0 == nPrimary);
+            bActive  = !(0 == record.value(1).toInt());
+            bPrimary = !(0 == record.value(2).toInt());
             // --------------------------
             if (temp.isEmpty())
-                continue;
+                return;
             qstrAddress = temp;
             nFound++;
             // --------------------------
@@ -754,12 +897,12 @@ QString MTContactHandler::getBitmessageAddressFromClaims(const QString & claiman
                 qstrFirstAddress = qstrAddress;
             // --------------------------
             if (bPrimary)
-                break;
-        }
-
+                bDone = true;
+        });
+    // ---------------------------------------
+    if (bRan && (nRows > 0))
         qstrReturnVal = bPrimary ? qstrAddress :
                                    (!qstrFirstAddress.isEmpty() ? qstrFirstAddress : qstrInactiveAddress);
-    }
     // ---------------------------------------
     return qstrReturnVal;
 }
@@ -772,18 +915,20 @@ void MTContactHandler::clearClaimsForNym(const QString & qstrNymId)
     if (qstrNymId.isEmpty())
         return;
     // ------------------------------------------------------------
-    QString str_delete_claim  = QString("DELETE FROM `claim` WHERE `claim_nym_id`='%1'").arg(qstrNymId);
-    QString str_delete_verify = QString("DELETE FROM `claim_verification` WHERE `ver_verifier_nym_id`='%1'").arg(qstrNymId);
+    QString str_delete_claim  = "DELETE FROM `claim` WHERE `claim_nym_id`=?";
+    QString str_delete_verify = "DELETE FROM `claim_verification` WHERE `ver_verifier_nym_id`=?";
 
     try {
-        DBHandler::getInstance()->runQuery(str_delete_claim);
-        DBHandler::getInstance()->runQuery(str_delete_verify);
+        DBHandler::getInstance()->runQuery(str_delete_claim,  QVariantList() << qstrNymId);
+        DBHandler::getInstance()->runQuery(str_delete_verify, QVariantList() << qstrNymId);
     }
     catch (const std::exception& exc)
     {
         qDebug () << "Error: " << exc.what ();
         return;
     }
+
+    MTNameCache::getInstance()->invalidateNym(qstrNymId.toStdString());
 }
 
 bool MTContactHandler::upsertClaim(opentxs::Nym& nym, const opentxs::Claim& claim)
@@ -822,9 +967,11 @@ bool MTContactHandler::upsertClaim(opentxs::Nym& nym, const opentxs::Claim& clai
     const std::string str_attributes(strAttributes.Get());
     const QString qstrAttributes(QString::fromStdString(str_attributes));
     // ------------------------------------------------------------
-    QString str_select_count = QString("SELECT claim_section FROM `claim` WHERE `claim_id`='%1' LIMIT 0,1").arg(claim_id);
-
-    const bool bClaimExists = (DBHandler::getInstance()->querySize(str_select_count) > 0);
+    bool bQueryFailed = false;
+    const bool bClaimExists = DBHandler::getInstance()->queryExists("SELECT claim_section FROM `claim` WHERE `claim_id`=?",
+                                                                    QVariantList() << claim_id, &bQueryFailed);
+    if (bQueryFailed) // Couldn't tell, so don't insert over a claim that may be there.
+        return false;
     // ------------------------------------------------------------
     // TODO: Do a real upsert here instead of this crap.
     // UPDATE: Upsert is only possible if you replace ALL fields.
@@ -873,6 +1020,8 @@ bool MTContactHandler::upsertClaim(opentxs::Nym& nym, const opentxs::Claim& clai
         return false;
     }
     // -----------------------------
+    MTNameCache::getInstance()->invalidateNym(str_nym_id); // The Nym's display name may come from its claims.
+    // -----------------------------
     if (bClaimExists)
     {
         if (bRan)
@@ -928,9 +1077,11 @@ bool MTContactHandler::upsertClaimVerification(const std::string & claimant_nym_
     // able to verify it, probably in a background process, download the related Nym, verify his
     // signature, then mark it as verified in the DB.
     // ---------------------------------------------------
-    QString str_select_count = QString("SELECT ver_id FROM `claim_verification` WHERE `ver_id`='%1' LIMIT 0,1").arg(ver_id);
-
-    const bool bVerificationExists = (DBHandler::getInstance()->querySize(str_select_count) > 0);
+    bool bQueryFailed = false;
+    const bool bVerificationExists = DBHandler::getInstance()->queryExists("SELECT ver_id FROM `claim_verification` WHERE `ver_id`=?",
+                                                                           QVariantList() << ver_id, &bQueryFailed);
+    if (bQueryFailed) // Couldn't tell, so don't insert over a verification that may be there.
+        return false;
     // ------------------------------------------------------------
 //    QString create_claim_verification_table = "CREATE TABLE IF NOT EXISTS claim_verification"
 //           "(ver_id TEXT PRIMARY KEY,"
@@ -946,27 +1097,29 @@ bool MTContactHandler::upsertClaimVerification(const std::string & claimant_nym_
 
     // TODO: Do a real upsert here instead of this crap.
     //
-    QString str_insert;
+    const int nPolarity = ver_polarity ? claimPolarityToInt(opentxs::OT_API::ClaimPolarity::POSITIVE) : claimPolarityToInt(opentxs::OT_API::ClaimPolarity::NEGATIVE);
+
+    QString      str_insert;
+    QVariantList params;
+
     if (!bVerificationExists)
-        str_insert = QString("INSERT INTO `claim_verification`"
-                                 " (`ver_id`, `ver_claimant_nym_id`, `ver_verifier_nym_id`, `ver_claim_id`, `ver_polarity`,"
-                                 "  `ver_start`, `ver_end`, `ver_signature`, `ver_signature_verified`)"
-                                 "  VALUES('%1', '%2', '%3', '%4', %5, %6, %7, '%8', %9)").
-                arg(ver_id).arg(QString::fromStdString(claimant_nym_id)).arg(qstrVerifierNymId).arg(ver_claim_id).
-                arg(ver_polarity ? claimPolarityToInt(opentxs::OT_API::ClaimPolarity::POSITIVE) : claimPolarityToInt(opentxs::OT_API::ClaimPolarity::NEGATIVE)).
-                arg(ver_start).
-                arg(ver_end).arg(ver_sig).
-                arg(bIsInternal ? 1 : 0);
+    {
+        str_insert = "INSERT INTO `claim_verification`"
+                     " (`ver_id`, `ver_claimant_nym_id`, `ver_verifier_nym_id`, `ver_claim_id`, `ver_polarity`,"
+                     "  `ver_start`, `ver_end`, `ver_signature`, `ver_signature_verified`)"
+                     "  VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?)";
+        params << ver_id << QString::fromStdString(claimant_nym_id) << qstrVerifierNymId << ver_claim_id << nPolarity
+               << static_cast<qlonglong>(ver_start) << static_cast<qlonglong>(ver_end) << ver_sig << (bIsInternal ? 1 : 0);
+    }
     else
-        str_insert = QString("UPDATE `claim_verification` SET"
-                             " `ver_claimant_nym_id`='%1', `ver_verifier_nym_id`='%2',`ver_claim_id`='%3',`ver_polarity`=%4,`ver_start`=%5,`ver_end`=%6,"
-                             " `ver_signature`='%7' WHERE `ver_id`='%8'").
-                arg(QString::fromStdString(claimant_nym_id)).arg(qstrVerifierNymId).arg(ver_claim_id).
-                arg(ver_polarity ? claimPolarityToInt(opentxs::OT_API::ClaimPolarity::POSITIVE) : claimPolarityToInt(opentxs::OT_API::ClaimPolarity::NEGATIVE)).
-                arg(ver_start).
-                arg(ver_end).arg(ver_sig).
-                arg(ver_id);
-    const bool bRan = DBHandler::getInstance()->runQuery(str_insert);
+    {
+        str_insert = "UPDATE `claim_verification` SET"
+                     " `ver_claimant_nym_id`=?, `ver_verifier_nym_id`=?,`ver_claim_id`=?,`ver_polarity`=?,`ver_start`=?,`ver_end`=?,"
+                     " `ver_signature`=? WHERE `ver_id`=?";
+        params << QString::fromStdString(claimant_nym_id) << qstrVerifierNymId << ver_claim_id << nPolarity
+               << static_cast<qlonglong>(ver_start) << static_cast<qlonglong>(ver_end) << ver_sig << ver_id;
+    }
+    const bool bRan = DBHandler::getInstance()->runQuery(str_insert, params);
 
     if (bVerificationExists)
     {
@@ -983,17 +1136,15 @@ bool MTContactHandler::upsertClaimVerification(const std::string & claimant_nym_
 bool MTContactHandler::ArchivedTradeReceiptExists(int64_t lReceiptID)
 {
     QMutexLocker locker(&m_Mutex);
-    QString str_select = QString("SELECT * FROM `trade_archive` WHERE `receipt_id`=%1 LIMIT 0,1").arg(lReceiptID);
-    int nRows = DBHandler::getInstance()->querySize(str_select);
-    return (nRows > 0);
+    return DBHandler::getInstance()->queryExists("SELECT * FROM `trade_archive` WHERE `receipt_id`=?",
+                                                 QVariantList() << static_cast<qlonglong>(lReceiptID));
 }
 
 bool MTContactHandler::ContactExists(int nContactID)
 {
     QMutexLocker locker(&m_Mutex);
-    QString str_select = QString("SELECT * FROM `contact` WHERE `contact_id`=%1 LIMIT 0,1").arg(nContactID);
-    int nRows = DBHandler::getInstance()->querySize(str_select);
-    return (nRows > 0);
+    return DBHandler::getInstance()->queryExists("SELECT * FROM `contact` WHERE `contact_id`=?",
+                                                 QVariantList() << nContactID);
 }
 
 
@@ -1001,13 +1152,23 @@ bool MTContactHandler::DeleteContact(int nContactID)
 {
     QMutexLocker locker(&m_Mutex);
 
-    QString str_delete_nym     = QString("DELETE FROM `nym` WHERE `contact_id`=%1").arg(nContactID);
-    QString str_delete_method  = QString("DELETE FROM `contact_method` WHERE `contact_id`=%1").arg(nContactID);
-    QString str_delete_contact = QString("DELETE FROM `contact` WHERE `contact_id`=%1").arg(nContactID);
+    const QVariantList params = QVariantList() << nContactID;
 
-    return (DBHandler::getInstance()->runQuery(str_delete_nym)     &&
-            DBHandler::getInstance()->runQuery(str_delete_method)  &&
-            DBHandler::getInstance()->runQuery(str_delete_contact));
+    // Collect the contact's Nyms for the name cache while they're still in the table.
+    QStringList listNymIds;
+    DBHandler::getInstance()->queryMultiple("SELECT `nym_id` FROM `nym` WHERE `contact_id`=?", params,
+                                            [&listNymIds](const QSqlRecord & record) { listNymIds << record.value(0).toString(); });
+
+    const bool bDeleted = (DBHandler::getInstance()->runQuery("DELETE FROM `nym` WHERE `contact_id`=?",            params) &&
+                           DBHandler::getInstance()->runQuery("DELETE FROM `contact_method` WHERE `contact_id`=?", params) &&
+                           DBHandler::getInstance()->runQuery("DELETE FROM `contact` WHERE `contact_id`=?",        params));
+
+    foreach (const QString & qstrNymId, listNymIds)
+        MTNameCache::getInstance()->invalidate(MTNameCache::NymName, qstrNymId.toStdString());
+    MTNameCache::getInstance()->invalidateType(MTNameCache::AcctName);
+    MTNameCache::getInstance()->invalidateType(MTNameCache::AddressName);
+
+    return bDeleted;
 }
 
 // See if a given Contact ID is associated with a given NymID.
@@ -1027,37 +1188,47 @@ bool MTContactHandler::AddNymToExistingContact(int nContactID, QString nym_id_st
 {
     QMutexLocker locker(&m_Mutex);
 
-    // Todo security: Make sure we don't need to encode the NymID here to prevent a SQL injection vulnerability...
-
     if ((nContactID > 0) && !nym_id_string.isEmpty())
     {
         // First, see if a contact already exists for this Nym, and if so,
         // save its ID and return at the bottom.
         //
-        QString str_select = QString("SELECT `contact_id` FROM `nym` WHERE `nym_id`='%1'").arg(nym_id_string);
-
-//      qDebug() << QString("Running query: %1").arg(str_select);
-
-        int  nRows      = DBHandler::getInstance()->querySize(str_select);
-        bool bNymExists = (nRows > 0); // Whether the contact ID was good or not, the Nym itself DOES exist.
+        bool bQueryFailed = false;
+        const bool bNymExists = DBHandler::getInstance()->queryExists("SELECT `contact_id` FROM `nym` WHERE `nym_id`=?",
+                                                                      QVariantList() << nym_id_string, &bQueryFailed); // Whether the contact ID was good or not, the Nym itself DOES exist.
+        if (bQueryFailed) // Couldn't tell, so don't insert over a Nym that may be there.
+            return false;
         // ----------------------------------------
-        QString str_insert_nym;
+        QString      str_insert_nym;
+        QVariantList params;
 
         if (!bNymExists)
-            str_insert_nym = QString("INSERT INTO `nym` "
-                                     "(`nym_id`, `contact_id`, `nym_payment_code`) "
-                                     "VALUES('%1', %2, '%3')").arg(nym_id_string).arg(nContactID).arg(payment_code);
+        {
+            str_insert_nym = "INSERT INTO `nym` "
+                             "(`nym_id`, `contact_id`, `nym_payment_code`) "
+                             "VALUES(?, ?, ?)";
+            params << nym_id_string << nContactID << payment_code;
+        }
         else if (!payment_code.isEmpty())
-            str_insert_nym = QString("UPDATE `nym` SET `contact_id`=%1,`nym_payment_code`='%2' WHERE `nym_id`='%3'")
-                    .arg(nContactID).arg(payment_code).arg(nym_id_string);
+        {
+            str_insert_nym = "UPDATE `nym` SET `contact_id`=?,`nym_payment_code`=? WHERE `nym_id`=?";
+            params << nContactID << payment_code << nym_id_string;
+        }
         else
-            str_insert_nym = QString("UPDATE `nym` SET `contact_id`=%1 WHERE `nym_id`='%2'").arg(nContactID).arg(nym_id_string);
+        {
+            str_insert_nym = "UPDATE `nym` SET `contact_id`=? WHERE `nym_id`=?";
+            params << nContactID << nym_id_string;
+        }
 
         if (!str_insert_nym.isEmpty())
         {
             qDebug() << QString("Running query: %1").arg(str_insert_nym);
 
-            return DBHandler::getInstance()->runQuery(str_insert_nym);
+            const bool bRan = DBHandler::getInstance()->runQuery(str_insert_nym, params);
+
+            MTNameCache::getInstance()->invalidateNym(nym_id_string.toStdString());
+
+            return bRan;
         }
     }
 
@@ -1086,15 +1257,16 @@ bool MTContactHandler::GetServers(mapIDName & theMap, QString filterByNym, bool
 {
     QMutexLocker locker(&m_Mutex);
 
-    QString str_select = QString("SELECT (`notary_id`) FROM `nym_server` WHERE `nym_id`='%1'").arg(filterByNym);
+    QString str_select = "SELECT (`notary_id`) FROM `nym_server` WHERE `nym_id`=?";
+
+    QStringList listNotaryIds;
+    DBHandler::getInstance()->queryMultiple(str_select, QVariantList() << filterByNym,
+                                            [&listNotaryIds](const QSqlRecord & record) { listNotaryIds << record.value(0).toString(); });
 
     bool bFoundAny = false;
-    int  nRows     = DBHandler::getInstance()->querySize(str_select);
 
-    for(int ii=0; ii < nRows; ii++)
+    foreach (const QString & notary_id, listNotaryIds)
     {
-        QString notary_id = DBHandler::getInstance()->queryString(str_select, 0, ii);
-
         if (!notary_id.isEmpty())
         {
             QString server_name = QString::fromStdString(opentxs::OTAPI_Wrap::It()->GetServer_Name(notary_id.toStdString()));
@@ -1173,15 +1345,16 @@ bool MTContactHandler::GetServers(mapIDName & theMap, int nFilterByContact, bool
                                  "FROM `nym_server` "
                                  "INNER JOIN `nym` "
                                  "ON nym.nym_id=nym_server.nym_id "
-                                 "WHERE nym.contact_id=%1").arg(nFilterByContact);
+                                 "WHERE nym.contact_id=?");
+
+    QStringList listNotaryIds;
+    DBHandler::getInstance()->queryMultiple(str_select, QVariantList() << nFilterByContact,
+                                            [&listNotaryIds](const QSqlRecord & record) { listNotaryIds << record.value(0).toString(); });
 
     bool bFoundAny = false;
-    int  nRows     = DBHandler::getInstance()->querySize(str_select);
 
-    for(int ii=0; ii < nRows; ii++)
+    foreach (const QString & notary_id, listNotaryIds)
     {
-        QString notary_id = DBHandler::getInstance()->queryString(str_select, 0, ii);
-
         if (!notary_id.isEmpty())
         {
             QString server_name = QString::fromStdString(opentxs::OTAPI_Wrap::It()->GetServer_Name(notary_id.toStdString()));
@@ -1255,18 +1428,18 @@ bool MTContactHandler::DeleteSmartContract(int nID)
 {
     QMutexLocker locker(&m_Mutex);
 
-    QString str_delete = QString("DELETE FROM `smart_contract` WHERE `template_id`=%1").arg(nID);
+    QString str_delete = "DELETE FROM `smart_contract` WHERE `template_id`=?";
 
-    return DBHandler::getInstance()->runQuery(str_delete);
+    return DBHandler::getInstance()->runQuery(str_delete, QVariantList() << nID);
 }
 
 bool MTContactHandler::DeleteManagedPassphrase(int nID)
 {
     QMutexLocker locker(&m_Mutex);
 
-    QString str_delete = QString("DELETE FROM `managed_passphrase` WHERE `passphrase_id`=%1").arg(nID);
+    QString str_delete = "DELETE FROM `managed_passphrase` WHERE `passphrase_id`=?";
 
-    return DBHandler::getInstance()->runQuery(str_delete);
+    return DBHandler::getInstance()->runQuery(str_delete, QVariantList() << nID);
 }
 
 QString MTContactHandler::GetSmartContract(int nID)
@@ -1292,9 +1465,9 @@ bool MTContactHandler::DeleteMessageBody(int nID)
 {
     QMutexLocker locker(&m_Mutex);
 
-    QString str_delete = QString("DELETE FROM `message_body` WHERE `message_id`=%1").arg(nID);
+    QString str_delete = "DELETE FROM `message_body` WHERE `message_id`=?";
 
-    return DBHandler::getInstance()->runQuery(str_delete);
+    return DBHandler::getInstance()->runQuery(str_delete, QVariantList() << nID);
 }
 
 
@@ -1312,10 +1485,10 @@ bool MTContactHandler::CreateMessageBody(QString qstrBody)
     // ----------------------------------------
     if (nID > 0)
     {
-        QString str_insert = QString("INSERT INTO `message_body` "
-                                     "(`message_id`) "
-                                     "VALUES(%1)").arg(nID);
-        DBHandler::getInstance()->runQuery(str_insert);
+        QString str_insert = "INSERT INTO `message_body` "
+                             "(`message_id`) "
+                             "VALUES(?)";
+        DBHandler::getInstance()->runQuery(str_insert, QVariantList() << nID);
         // ----------------------------------------
         const int nMessageID = DBHandler::getInstance()->queryInt("SELECT last_insert_rowid() from `message_body`", 0, 0);
 
@@ -1334,6 +1507,25 @@ bool MTContactHandler::CreateMessageBody(QString qstrBody)
     return false;
 }
 
+// For callers that already know the message_id, such as a batch of inserts
+// where last_insert_rowid() only refers to the last one.
+//
+bool MTContactHandler::CreateMessageBody(int nMessageID, QString qstrBody)
+{
+    QMutexLocker locker(&m_Mutex);
+
+    if ((nMessageID <= 0) ||
+        !DBHandler::getInstance()->runQuery("INSERT INTO `message_body` (`message_id`) VALUES(?)", QVariantList() << nMessageID))
+        return false;
+
+    if (!LowLevelUpdateMessageBody(nMessageID, qstrBody))
+    {
+        qDebug() << QString("Failed updating message body for message_id: %1").arg(nMessageID);
+        return false;
+    }
+    return true;
+}
+
 bool MTContactHandler::LowLevelUpdateMessageBody(int nMessageID, const QString & qstrBody)
 {
 //  NOTE: This function ASSUMES that the calling function already locked the Mutex.
@@ -1393,9 +1585,9 @@ bool MTContactHandler::DeletePaymentBody(int nID)
 {
     QMutexLocker locker(&m_Mutex);
 
-    QString str_delete = QString("DELETE FROM `payment_body` WHERE `payment_id`=%1").arg(nID);
+    QString str_delete = "DELETE FROM `payment_body` WHERE `payment_id`=?";
 
-    return DBHandler::getInstance()->runQuery(str_delete);
+    return DBHandler::getInstance()->runQuery(str_delete, QVariantList() << nID);
 }
 
 // Returns 0 if not found.
@@ -1404,13 +1596,8 @@ int MTContactHandler::GetPaymentIdByTxnDisplayId(int64_t lTxnDisplayId, QString
 {
     QMutexLocker locker(&m_Mutex);
 
-    QString str_select = QString("SELECT `payment_id` FROM `payment` WHERE `txn_id_display`=%1 AND `my_nym_id`='%2' LIMIT 0,1").arg(lTxnDisplayId).arg(qstrNymId);
-    int nRows = DBHandler::getInstance()->querySize(str_select);
-
-    if (0 >= nRows)
-        return 0;
-
-    return DBHandler::getInstance()->queryInt(str_select, 0, 0);
+    return DBHandler::getInstance()->queryInt("SELECT `payment_id` FROM `payment` WHERE `txn_id_display`=? AND `my_nym_id`=? LIMIT 0,1",
+                                              QVariantList() << static_cast<qlonglong>(lTxnDisplayId) << qstrNymId); // 0 if there's no row.
 }
 
 // Since there is a payment table, the payment_id is already pre-existing by the time
@@ -1427,10 +1614,10 @@ bool MTContactHandler::CreatePaymentBody(QString qstrBody, QString qstrPendingBo
     // ----------------------------------------
     if (nID > 0)
     {
-        QString str_insert = QString("INSERT INTO `payment_body` "
-                                     "(`payment_id`) "
-                                     "VALUES(%1)").arg(nID);
-        DBHandler::getInstance()->runQuery(str_insert);
+        QString str_insert = "INSERT INTO `payment_body` "
+                             "(`payment_id`) "
+                             "VALUES(?)";
+        DBHandler::getInstance()->runQuery(str_insert, QVariantList() << nID);
         // ----------------------------------------
         const int nPaymentID = DBHandler::getInstance()->queryInt("SELECT last_insert_rowid() from `payment_body`", 0, 0);
 
@@ -1449,6 +1636,24 @@ bool MTContactHandler::CreatePaymentBody(QString qstrBody, QString qstrPendingBo
     return false;
 }
 
+// Same as above, but for a payment_id the caller already knows.
+//
+bool MTContactHandler::CreatePaymentBody(int nPaymentID, QString qstrBody, QString qstrPendingBody)
+{
+    QMutexLocker locker(&m_Mutex);
+
+    if ((nPaymentID <= 0) ||
+        !DBHandler::getInstance()->runQuery("INSERT INTO `payment_body` (`payment_id`) VALUES(?)", QVariantList() << nPaymentID))
+        return false;
+
+    if (!LowLevelUpdatePaymentBody(nPaymentID, qstrBody, qstrPendingBody))
+    {
+        qDebug() << QString("Failed updating payment body for payment_id: %1").arg(nPaymentID);
+        return false;
+    }
+    return true;
+}
+
 bool MTContactHandler::LowLevelUpdatePaymentBody(int nPaymentID, const QString qstrBody, const QString qstrPendingBody)
 {
 //  NOTE: This function ASSUMES that the calling function already locked the Mutex.
@@ -1540,17 +1745,20 @@ bool MTContactHandler::GetPaymentCodes(mapIDName & theMap, int nFilterByContact)
 {
     QMutexLocker locker(&m_Mutex);
 
-    QString str_select = QString("SELECT * FROM `nym` WHERE `contact_id`=%1").arg(nFilterByContact);
+    QString str_select = "SELECT * FROM `nym` WHERE `contact_id`=?";
 //  QString str_select = QString("SELECT * FROM `nym` WHERE `contact_id`=%1 LIMIT 0,1").arg(nFilterByContact);
 
+    QList<QSqlRecord> listRows;
+    DBHandler::getInstance()->queryMultiple(str_select, QVariantList() << nFilterByContact,
+                                            [&listRows](const QSqlRecord & record) { listRows << record; });
+
     bool bFoundAny = false;
-    int  nRows     = DBHandler::getInstance()->querySize(str_select);
 
-    for (int ii=0; ii < nRows; ii++)
+    for (int ii=0; ii < listRows.size(); ii++)
     {
-        QString nym_id       = DBHandler::getInstance()->queryString(str_select, 0, ii);
-        QString nym_name     = DBHandler::getInstance()->queryString(str_select, 2, ii);
-        QString payment_code = DBHandler::getInstance()->queryString(str_select, 3, ii);
+        QString nym_id       = listRows[ii].value(0).toString();
+        QString nym_name     = listRows[ii].value(2).toString();
+        QString payment_code = listRows[ii].value(3).toString();
 
         if (!nym_id.isEmpty() && !payment_code.isEmpty())
         {
@@ -1580,16 +1788,19 @@ bool MTContactHandler::GetNyms(mapIDName & theMap, int nFilterByContact)
 {
     QMutexLocker locker(&m_Mutex);
 
-    QString str_select = QString("SELECT * FROM `nym` WHERE `contact_id`=%1").arg(nFilterByContact);
+    QString str_select = "SELECT * FROM `nym` WHERE `contact_id`=?";
 //  QString str_select = QString("SELECT * FROM `nym` WHERE `contact_id`=%1 LIMIT 0,1").arg(nFilterByContact);
 
+    QList<QSqlRecord> listRows;
+    DBHandler::getInstance()->queryMultiple(str_select, QVariantList() << nFilterByContact,
+                                            [&listRows](const QSqlRecord & record) { listRows << record; });
+
     bool bFoundAny = false;
-    int  nRows     = DBHandler::getInstance()->querySize(str_select);
 
-    for (int ii=0; ii < nRows; ii++)
+    for (int ii=0; ii < listRows.size(); ii++)
     {
-        QString nym_id   = DBHandler::getInstance()->queryString(str_select, 0, ii);
-        QString nym_name = DBHandler::getInstance()->queryString(str_select, 2, ii);
+        QString nym_id   = listRows[ii].value(0).toString();
+        QString nym_name = listRows[ii].value(2).toString();
 
         if (!nym_id.isEmpty())
         {
@@ -1634,9 +1845,11 @@ bool MTContactHandler::GetAccounts(mapIDName & theMap, QString filterByNym, QStr
     if (!filterByAsset.isEmpty())
         parameters.insert("asset_id", filterByAsset);
     // -------------------------
-    // Construct the WHERE clause.
+    // Construct the WHERE clause. The column names come from the map above;
+    // the values are bound.
     //
     QString strParams;
+    QVariantList listParams;
 
     int nIteration = 0;
     while (!parameters.empty())
@@ -1653,12 +1866,13 @@ bool MTContactHandler::GetAccounts(mapIDName & theMap, QString filterByNym, QStr
         // ----------------------------------
         if (1 == nIteration) // first iteration
         {
-            strParams = QString(" WHERE `%1`='%2'").arg(strKey).arg(strValue);
+            strParams = QString(" WHERE `%1`=?").arg(strKey);
         }
         else // subsequent iterations.
         {
-            strParams += QString(" AND `%1`='%2'").arg(strKey).arg(strValue);
+            strParams += QString(" AND `%1`=?").arg(strKey);
         }
+        listParams << strValue;
         // ----------------------------------
         parameters.remove(strKey);
     } // while
@@ -1670,14 +1884,20 @@ bool MTContactHandler::GetAccounts(mapIDName & theMap, QString filterByNym, QStr
     if (!strParams.isEmpty())
         str_select += strParams;
     // ---------------------------------
+    // Collected first: the loop below looks up contacts, and the connection
+    // is locked while queryMultiple runs its callback.
+    //
+    QList<QSqlRecord> listRows;
+    DBHandler::getInstance()->queryMultiple(str_select, listParams,
+                                            [&listRows](const QSqlRecord & record) { listRows << record; });
+
     bool bFoundAccounts = false;
-    int  nRows = DBHandler::getInstance()->querySize(str_select);
 
-    for(int ii=0; ii < nRows; ii++)
+    for(int ii=0; ii < listRows.size(); ii++)
     {
-        QString account_id     = DBHandler::getInstance()->queryString(str_select, 0, ii);
-        QString account_nym_id = DBHandler::getInstance()->queryString(str_select, 2, ii);
-        QString display_name   = DBHandler::getInstance()->queryString(str_select, 4, ii);
+        QString account_id     = listRows[ii].value(0).toString();
+        QString account_nym_id = listRows[ii].value(2).toString();
+        QString display_name   = listRows[ii].value(4).toString();
 
         if (!display_name.isEmpty())
         {
@@ -1963,43 +2183,25 @@ bool MTContactHandler::GetManagedPassphrases(mapIDName & mapTitle, mapIDName & m
     bool bFound = false, bSearchStringExists = !searchStr.isEmpty();
     DBHandler& db = *DBHandler::getInstance ();
     // ----------------------------
-    // This is a hack I'm doing to sanitize searchStr since the way it's SUPPOSED to work
-    // (named bound values) isn't working at all.
-    //
-    QSqlField sqlField;
-
-    if (bSearchStringExists)
-    {
-        sqlField.setType(QVariant::String);
-        sqlField.setValue(searchStr);
-
-        searchStr = db.formatValue(sqlField);
-        searchStr.remove(QChar('\''));
-        searchStr.remove(QChar('\"'));
-    }
-    // ----------------------------
     ManagedPassphraseFunctor passphraseHandler(mapTitle, mapURL, bFound);
     QString queryStr;
+    QVariantList params;
 
     if (bSearchStringExists)
+    {
         queryStr = QString("SELECT `passphrase_id`,`passphrase_title`,`passphrase_url` FROM `managed_passphrase` "
-                             "WHERE `passphrase_title` LIKE '%1%2%1' "
-                             "OR `passphrase_username` LIKE '%1%2%1' "
-                             "OR `passphrase_url` LIKE '%1%2%1' "
-                             ).arg("%").arg(searchStr);
+                             "WHERE `passphrase_title` LIKE ? "
+                             "OR `passphrase_username` LIKE ? "
+                             "OR `passphrase_url` LIKE ? ");
+        const QString qstrPattern = QString("%%1%").arg(searchStr);
+        params << qstrPattern << qstrPattern << qstrPattern;
+    }
     else
         queryStr = QString("SELECT `passphrase_id`,`passphrase_title`,`passphrase_url` FROM `managed_passphrase` ");
 
-  #ifdef CXX_11
-    std::unique_ptr<DBHandler::PreparedQuery> qu;
-  #else /* CXX_11?  */
-    std::auto_ptr<DBHandler::PreparedQuery> qu;
-  #endif /* CXX_11?  */
-    qu.reset (db.prepareQuery (queryStr));
-
     try
     {
-        db.queryMultiple (qu.release(), passphraseHandler);
+        db.queryMultiple (queryStr, params, passphraseHandler);
     }
     catch (const std::exception& exc)
     {
@@ -2027,14 +2229,11 @@ int  MTContactHandler::CreateSmartContractTemplate(QString template_string)
     {
         QString encoded_value = Encode(template_string);
 
-        // TODO: CHANGE THIS to use bind (there are examples in this file) so we aren't literally copying the full
-        // smart contract directly into this update statement!
-        //
-        str_insert = QString("UPDATE smart_contract SET template_contents='%1' WHERE template_id='%2'").arg(encoded_value).arg(nTemplateID);
+        str_insert = "UPDATE smart_contract SET template_contents=? WHERE template_id=?";
 
         qDebug() << QString("Running query: %1").arg(str_insert);
 
-        DBHandler::getInstance()->runQuery(str_insert);
+        DBHandler::getInstance()->runQuery(str_insert, QVariantList() << encoded_value << nTemplateID);
     }
 
     return nTemplateID;
@@ -2062,21 +2261,22 @@ int MTContactHandler::CreateContactBasedOnNym(QString nym_id_string, QString not
     // First, see if a contact already exists for this Nym, and if so,
     // save its ID and return at the bottom.
     //
-    QString str_select = QString("SELECT `contact_id` FROM `nym` WHERE `nym_id`='%1'").arg(nym_id_string);
+    QString str_select = "SELECT `contact_id` FROM `nym` WHERE `nym_id`=?";
 
     qDebug() << QString("Running query: %1").arg(str_select);
 
-    int  nRows      = DBHandler::getInstance()->querySize(str_select);
     bool bNymExists = false;
 
-    for(int ii=0; ii < nRows; ii++)
-    {
-        nContactID = DBHandler::getInstance()->queryInt(str_select, 0, ii);
+    DBHandler::getInstance()->queryMultiple(str_select, QVariantList() << nym_id_string,
+        [&nContactID, &bNymExists](const QSqlRecord & record)
+        {
+            if (bNymExists)
+                return; // In practice there should only be one row.
 
-        bNymExists = true; // Whether the contact ID was good or not, the Nym itself DOES exist.
+            nContactID = record.value(0).toInt();
 
-        break; // In practice there should only be one row.
-    }
+            bNymExists = true; // Whether the contact ID was good or not, the Nym itself DOES exist.
+        });
     // ---------------------------------------------------------------------
     // If no contact exists for this Nym, then create the contact and Nym.
     // (And save the contact ID, and return at the bottom.)
@@ -2101,24 +2301,33 @@ int MTContactHandler::CreateContactBasedOnNym(QString nym_id_string, QString not
     if (nContactID > 0)
     {
         QString str_insert_nym;
+        QVariantList params;
 
         // todo: add "upsert" code to consolidate to a single sql statement, if possible.
 
         if (!bNymExists)
-            str_insert_nym = QString("INSERT INTO `nym` "
-                                     "(`nym_id`, `contact_id`, `nym_payment_code`) "
-                                     "VALUES('%1', %2, '%3')").arg(nym_id_string).arg(nContactID).arg(payment_code);
+        {
+            str_insert_nym = "INSERT INTO `nym` "
+                             "(`nym_id`, `contact_id`, `nym_payment_code`) "
+                             "VALUES(?, ?, ?)";
+            params << nym_id_string << nContactID << payment_code;
+        }
         else if (!payment_code.isEmpty())
-            str_insert_nym = QString("UPDATE `nym` SET `contact_id`=%1,`nym_payment_code`='%2' WHERE `nym_id`='%3'")
-                    .arg(nContactID).arg(payment_code).arg(nym_id_string);
+        {
+            str_insert_nym = "UPDATE `nym` SET `contact_id`=?,`nym_payment_code`=? WHERE `nym_id`=?";
+            params << nContactID << payment_code << nym_id_string;
+        }
         else
-            str_insert_nym = QString("UPDATE `nym` SET `contact_id`=%1 WHERE `nym_id`='%2'").arg(nContactID).arg(nym_id_string);
+        {
+            str_insert_nym = "UPDATE `nym` SET `contact_id`=? WHERE `nym_id`=?";
+            params << nContactID << nym_id_string;
+        }
 
         if (!str_insert_nym.isEmpty())
         {
             qDebug() << QString("Running query: %1").arg(str_insert_nym);
 
-            DBHandler::getInstance()->runQuery(str_insert_nym);
+            DBHandler::getInstance()->runQuery(str_insert_nym, params);
         }
     }
     // ---------------------------------------------------------------------
@@ -2127,21 +2336,26 @@ int MTContactHandler::CreateContactBasedOnNym(QString nym_id_string, QString not
     //
     if (!notary_id_string.isEmpty())
     {
-        QString str_select_server = QString("SELECT `notary_id` FROM `nym_server` WHERE `nym_id`='%1' AND `notary_id`='%2' LIMIT 0,1").arg(nym_id_string).arg(notary_id_string);
-        int nRowsServer = DBHandler::getInstance()->querySize(str_select_server);
+        const QVariantList params = QVariantList() << nym_id_string << notary_id_string;
 
-        if (0 == nRowsServer) // It wasn't already there. (Add it.)
+        QString str_select_server = "SELECT `notary_id` FROM `nym_server` WHERE `nym_id`=? AND `notary_id`=? LIMIT 0,1";
+        bool bQueryFailed = false;
+        const bool bServerExists = DBHandler::getInstance()->queryExists(str_select_server, params, &bQueryFailed);
+
+        if (!bServerExists && !bQueryFailed) // It wasn't already there. (Add it.)
         {
-            QString str_insert_server = QString("INSERT INTO `nym_server` "
-                                                "(`nym_id`, `notary_id`) "
-                                                "VALUES('%1', '%2')").arg(nym_id_string).arg(notary_id_string);
+            QString str_insert_server = "INSERT INTO `nym_server` "
+                                        "(`nym_id`, `notary_id`) "
+                                        "VALUES(?, ?)";
 
             qDebug() << QString("Running query: %1").arg(str_insert_server);
 
-            DBHandler::getInstance()->runQuery(str_insert_server);
+            DBHandler::getInstance()->runQuery(str_insert_server, params);
         }
     }
     // ---------------------------------------------------------------------
+    MTNameCache::getInstance()->invalidateNym(nym_id_string.toStdString());
+
     return nContactID;
 }
 
@@ -2168,19 +2382,20 @@ int MTContactHandler::CreateContactBasedOnAddress(QString qstrAddress, QString q
     // First, see if a contact already exists for this Address, and if so,
     // save its ID and return at the bottom.
     //
-    QString str_select = QString("SELECT `contact_id` FROM `contact_method` WHERE `address`='%1'").arg(qstrEncodedAddress);
+    QString str_select = "SELECT `contact_id` FROM `contact_method` WHERE `address`=?";
 
-    int  nRows      = DBHandler::getInstance()->querySize(str_select);
     bool bAddressExists = false;
 
-    for(int ii=0; ii < nRows; ii++)
-    {
-        nContactID = DBHandler::getInstance()->queryInt(str_select, 0, ii);
+    DBHandler::getInstance()->queryMultiple(str_select, QVariantList() << qstrEncodedAddress,
+        [&nContactID, &bAddressExists](const QSqlRecord & record)
+        {
+            if (bAddressExists)
+                return; // In practice there should only be one row.
 
-        bAddressExists = true; // Whether the contact ID was good or not, the Address itself DOES exist.
+            nContactID = record.value(0).toInt();
 
-        break; // In practice there should only be one row.
-    }
+            bAddressExists = true; // Whether the contact ID was good or not, the Address itself DOES exist.
+        });
     // ---------------------------------------------------------------------
     // If no contact exists for this Address, then create the contact and Address.
     // (And save the contact ID, and return at the bottom.)
@@ -2205,20 +2420,29 @@ int MTContactHandler::CreateContactBasedOnAddress(QString qstrAddress, QString q
     if (nContactID > 0)
     {
         QString str_insert_addr;
+        QVariantList params;
 
         if (!bAddressExists)
-            str_insert_addr = QString("INSERT INTO `contact_method` "
-                                     "(`contact_id`, `method_type`, `address`) "
-                                     "VALUES(%1, '%2', '%3')").arg(nContactID).arg(qstrEncodedMethodType).arg(qstrEncodedAddress);
+        {
+            str_insert_addr = "INSERT INTO `contact_method` "
+                              "(`contact_id`, `method_type`, `address`) "
+                              "VALUES(?, ?, ?)";
+            params << nContactID << qstrEncodedMethodType << qstrEncodedAddress;
+        }
         else
-            str_insert_addr = QString("UPDATE contact_method SET contact_id=%1 WHERE address='%2'").arg(nContactID).arg(qstrEncodedAddress);
+        {
+            str_insert_addr = "UPDATE contact_method SET contact_id=? WHERE address=?";
+            params << nContactID << qstrEncodedAddress;
+        }
 
         if (!str_insert_addr.isEmpty())
         {
-            DBHandler::getInstance()->runQuery(str_insert_addr);
+            DBHandler::getInstance()->runQuery(str_insert_addr, params);
         }
     }
     // ---------------------------------------------------------------------
+    MTNameCache::getInstance()->invalidate(MTNameCache::AddressName, qstrAddress.toStdString());
+
     return nContactID;
 }
 
@@ -2268,53 +2492,37 @@ int MTContactHandler::FindOrCreateContactByNym(QString nym_id_string)
 // then we either just return a failure, or if we can find it indirectly, we add
 // it to our records.
 
-QString MTContactHandler::GetValueByIDLowLevel(QString str_select)
+QString MTContactHandler::GetValueByIDLowLevel(QString str_select, QVariantList params)
 {
     QMutexLocker locker(&m_Mutex);
 
-    int nRows = DBHandler::getInstance()->querySize(str_select);
+    QString qstr_value = DBHandler::getInstance()->queryString(str_select, params); // In practice there should only be one row.
 
-    for(int ii=0; ii < nRows; ii++)
+    if (!qstr_value.isEmpty())
     {
-        //Extract data
-        QString qstr_value = DBHandler::getInstance()->queryString(str_select, 0, ii);
-
-        if (!qstr_value.isEmpty())
-        {
-            //Decode base64.
-            qstr_value = Decode(qstr_value);
-        }
-        //---------------------------------------------------
-        return qstr_value; // In practice there should only be one row.
+        //Decode base64.
+        qstr_value = Decode(qstr_value);
     }
 
-    return ""; // Didn't find any.
+    return qstr_value;
 }
 
 
 // Warning: this call only works after OT LoadWallet is finished.
 // (Because it uses keys from the wallet.)
-QString MTContactHandler::GetEncryptedValueByIDLowLevel(QString str_select)
+QString MTContactHandler::GetEncryptedValueByIDLowLevel(QString str_select, QVariantList params)
 {
     QMutexLocker locker(&m_Mutex);
 
-    int nRows = DBHandler::getInstance()->querySize(str_select);
+    QString qstr_value = DBHandler::getInstance()->queryString(str_select, params); // In practice there should only be one row.
 
-    for(int ii=0; ii < nRows; ii++)
+    if (!qstr_value.isEmpty())
     {
-        //Extract data
-        QString qstr_value = DBHandler::getInstance()->queryString(str_select, 0, ii);
-
-        if (!qstr_value.isEmpty())
-        {
-            //Decrypt
-            qstr_value = Decrypt(qstr_value);
-        }
-        //---------------------------------------------------
-        return qstr_value; // In practice there should only be one row.
+        //Decrypt
+        qstr_value = Decrypt(qstr_value);
     }
 
-    return ""; // Didn't find any.
+    return qstr_value;
 }
 
 
@@ -2333,13 +2541,12 @@ QString MTContactHandler::GetEncryptedValueByID(QString qstrID, QString column,
     // For something like:
     // QString("SELECT `nym_display_name` FROM `nym` WHERE `nym_id`='%1' LIMIT 0,1").arg(qstrNymID);
     // ----------------------------------
-    QString str_select = QString("SELECT `%1` FROM `%2` WHERE `%3`='%4' LIMIT 0,1")
+    QString str_select = QString("SELECT `%1` FROM `%2` WHERE `%3`=? LIMIT 0,1")
             .arg(column)   // "nym_display_name"
             .arg(table)    // "nym"
-            .arg(id_name)  // "nym_id"
-            .arg(qstrID);     // (actual Nym ID goes here as string)
+            .arg(id_name); // "nym_id"
 
-    return this->GetEncryptedValueByIDLowLevel(str_select);
+    return this->GetEncryptedValueByIDLowLevel(str_select, QVariantList() << qstrID); // (actual Nym ID goes here as string)
 }
 
 // Warning: this call only works after OT LoadWallet is finished.
@@ -2350,14 +2557,14 @@ bool MTContactHandler::SetEncryptedValueByID(QString qstrID, QString value, QStr
 
     QString encrypted_value = Encrypt(value);
     // ------------------------------------------
-    QString str_update = QString("UPDATE `%1` SET `%2`='%3' WHERE `%4`='%5'")
+    QString str_update = QString("UPDATE `%1` SET `%2`=? WHERE `%3`=?")
             .arg(table)         // "contact"
             .arg(column)        // "contact_display_name"
-            .arg(encrypted_value) // (encrypted bitmessage connect string (for example))
-            .arg(id_name)       // "contact_id"
-            .arg(qstrID);       // (actual contact ID goes here)
+            .arg(id_name);      // "contact_id"
 
-    return DBHandler::getInstance()->runQuery(str_update);
+    return DBHandler::getInstance()->runQuery(str_update, QVariantList()
+            << encrypted_value  // (encrypted bitmessage connect string (for example))
+            << qstrID);         // (actual contact ID goes here)
 }
 
 
@@ -2376,13 +2583,12 @@ QString MTContactHandler::GetEncryptedValueByID(int nID, QString column, QString
     // For something like:
     // QString("SELECT `contact_display_name` FROM `contact` WHERE `contact_id`=%1 LIMIT 0,1").arg(nContactID);
     // ----------------------------------
-    QString str_select = QString("SELECT `%1` FROM `%2` WHERE `%3`=%4 LIMIT 0,1")
+    QString str_select = QString("SELECT `%1` FROM `%2` WHERE `%3`=? LIMIT 0,1")
             .arg(column)   // "contact_display_name"
             .arg(table)    // "contact"
-            .arg(id_name)  // "contact_id"
-            .arg(nID);     // (actual integer ID goes here)
+            .arg(id_name); // "contact_id"
 
-    return this->GetEncryptedValueByIDLowLevel(str_select);
+    return this->GetEncryptedValueByIDLowLevel(str_select, QVariantList() << nID); // (actual integer ID goes here)
 }
 
 
@@ -2394,14 +2600,14 @@ bool MTContactHandler::SetEncryptedValueByID(int nID, QString value, QString col
 
     QString encrypted_value = Encrypt(value);
     // ------------------------------------------
-    QString str_update = QString("UPDATE `%1` SET `%2`='%3' WHERE `%4`=%5")
+    QString str_update = QString("UPDATE `%1` SET `%2`=? WHERE `%3`=?")
             .arg(table)         // "contact"
             .arg(column)        // "contact_display_name"
-            .arg(encrypted_value) // (encrypted bitmessage connect string, say.)
-            .arg(id_name)       // "contact_id"
-            .arg(nID);          // (actual contact ID goes here)
+            .arg(id_name);      // "contact_id"
 
-    return DBHandler::getInstance()->runQuery(str_update);
+    return DBHandler::getInstance()->runQuery(str_update, QVariantList()
+            << encrypted_value  // (encrypted bitmessage connect string, say.)
+            << nID);            // (actual contact ID goes here)
 }
 
 
@@ -2419,13 +2625,12 @@ QString MTContactHandler::GetValueByID(QString qstrID, QString column, QString t
     // For something like:
     // QString("SELECT `nym_display_name` FROM `nym` WHERE `nym_id`='%1' LIMIT 0,1").arg(qstrNymID);
     // ----------------------------------
-    QString str_select = QString("SELECT `%1` FROM `%2` WHERE `%3`='%4' LIMIT 0,1")
+    QString str_select = QString("SELECT `%1` FROM `%2` WHERE `%3`=? LIMIT 0,1")
             .arg(column)   // "nym_display_name"
             .arg(table)    // "nym"
-            .arg(id_name)  // "nym_id"
-            .arg(qstrID);     // (actual Nym ID goes here as string)
+            .arg(id_name); // "nym_id"
 
-    return this->GetValueByIDLowLevel(str_select);
+    return this->GetValueByIDLowLevel(str_select, QVariantList() << qstrID); // (actual Nym ID goes here as string)
 }
 
 
@@ -2435,14 +2640,19 @@ bool MTContactHandler::SetValueByID(QString qstrID, QString value, QString colum
 
     QString encoded_value = Encode(value);
     // ------------------------------------------
-    QString str_update = QString("UPDATE `%1` SET `%2`='%3' WHERE `%4`='%5'")
+    QString str_update = QString("UPDATE `%1` SET `%2`=? WHERE `%3`=?")
             .arg(table)         // "contact"
             .arg(column)        // "contact_display_name"
-            .arg(encoded_value) // (base64-encoded display name)
-            .arg(id_name)       // "contact_id"
-            .arg(qstrID);       // (actual contact ID goes here)
+            .arg(id_name);      // "contact_id"
+
+    const bool bRan = DBHandler::getInstance()->runQuery(str_update, QVariantList()
+            << encoded_value    // (base64-encoded display name)
+            << qstrID);         // (actual contact ID goes here)
 
-    return DBHandler::getInstance()->runQuery(str_update);
+    if (0 == table.compare("nym")) // For instance, nym_display_name.
+        MTNameCache::getInstance()->invalidateNym(qstrID.toStdString());
+
+    return bRan;
 }
 
 
@@ -2459,13 +2669,12 @@ QString MTContactHandler::GetValueByID(int nID, QString column, QString table, Q
     // For something like:
     // QString("SELECT `contact_display_name` FROM `contact` WHERE `contact_id`=%1 LIMIT 0,1").arg(nContactID);
     // ----------------------------------
-    QString str_select = QString("SELECT `%1` FROM `%2` WHERE `%3`=%4 LIMIT 0,1")
+    QString str_select = QString("SELECT `%1` FROM `%2` WHERE `%3`=? LIMIT 0,1")
             .arg(column)   // "contact_display_name"
             .arg(table)    // "contact"
-            .arg(id_name)  // "contact_id"
-            .arg(nID);     // (actual integer ID goes here)
+            .arg(id_name); // "contact_id"
 
-    return this->GetValueByIDLowLevel(str_select);
+    return this->GetValueByIDLowLevel(str_select, QVariantList() << nID); // (actual integer ID goes here)
 }
 
 
@@ -2475,14 +2684,14 @@ bool MTContactHandler::SetValueByID(int nID, QString value, QString column, QStr
 
     QString encoded_value = Encode(value);
     // ------------------------------------------
-    QString str_update = QString("UPDATE `%1` SET `%2`='%3' WHERE `%4`=%5")
+    QString str_update = QString("UPDATE `%1` SET `%2`=? WHERE `%3`=?")
             .arg(table)         // "contact"
             .arg(column)        // "contact_display_name"
-            .arg(encoded_value) // (base64-encoded display name)
-            .arg(id_name)       // "contact_id"
-            .arg(nID);          // (actual contact ID goes here)
+            .arg(id_name);      // "contact_id"
 
-    return DBHandler::getInstance()->runQuery(str_update);
+    return DBHandler::getInstance()->runQuery(str_update, QVariantList()
+            << encoded_value    // (base64-encoded display name)
+            << nID);            // (actual contact ID goes here)
 }
 
 
@@ -2493,7 +2702,31 @@ QString MTContactHandler::GetContactName(int nContactID)
 
 bool MTContactHandler::SetContactName(int nContactID, QString contact_name_string)
 {
-    return this->SetValueByID(nContactID, contact_name_string, "contact_display_name", "contact", "contact_id");
+    const bool bSet = this->SetValueByID(nContactID, contact_name_string, "contact_display_name", "contact", "contact_id");
+
+    this->InvalidateCachedNamesForContact(nContactID);
+
+    return bSet;
+}
+
+// Drops every cached name that could have come from this contact's display name.
+//
+void MTContactHandler::InvalidateCachedNamesForContact(int nContactID)
+{
+    QMutexLocker locker(&m_Mutex);
+
+    QStringList listNymIds;
+    DBHandler::getInstance()->queryMultiple("SELECT `nym_id` FROM `nym` WHERE `contact_id`=?", QVariantList() << nContactID,
+                                            [&listNymIds](const QSqlRecord & record) { listNymIds << record.value(0).toString(); });
+
+    foreach (const QString & nym_id, listNymIds)
+    {
+        if (!nym_id.isEmpty())
+            MTNameCache::getInstance()->invalidate(MTNameCache::NymName, nym_id.toStdString());
+    }
+    // Account and address names are matched to contacts through joins we can't cheaply reverse.
+    MTNameCache::getInstance()->invalidateType(MTNameCache::AcctName);
+    MTNameCache::getInstance()->invalidateType(MTNameCache::AddressName);
 }
 
 // ---------------------------------------------------
@@ -2591,7 +2824,7 @@ bool MTContactHandler::MethodTypeFoundOnNym(QString method_type, QString filterB
 {
     QMutexLocker locker(&m_Mutex);
 
-    int     nReturnValue = 0;
+    bool    bReturnValue = false;
     QString encoded_type = Encode(method_type);
 
     if (!encoded_type.isEmpty())
@@ -2600,33 +2833,31 @@ bool MTContactHandler::MethodTypeFoundOnNym(QString method_type, QString filterB
                                      "FROM `nym_method` "       // ...from the nym_method table...
                                      "INNER JOIN `msg_method` " // ...where it matches the 'msg_method' table...
                                      "ON nym_method.method_id=msg_method.method_id " // ...on the method_id column. (So we only see methods that are attached to a nym.)
-                                     "WHERE msg_method.method_type='%1' AND nym_method.nym_id='%2' LIMIT 0,1").
-                             arg(encoded_type).arg(filterByNym); // ...filtered by a method_type of 'encoded_type' function parameter. (And NymID.)
+                                     "WHERE msg_method.method_type=? AND nym_method.nym_id=? LIMIT 0,1"); // ...filtered by a method_type of 'encoded_type' function parameter. (And NymID.)
 
-        nReturnValue = DBHandler::getInstance()->querySize(str_select);
+        bReturnValue = DBHandler::getInstance()->queryExists(str_select, QVariantList() << encoded_type << filterByNym);
     }
 
-    return (nReturnValue > 0);
+    return bReturnValue;
 }
 
 bool MTContactHandler::MethodTypeFoundOnContact(QString method_type, int nFilterByContact)
 {
     QMutexLocker locker(&m_Mutex);
 
-    int     nReturnValue = 0;
+    bool    bReturnValue = false;
     QString encoded_type = Encode(method_type);
 
     if (!encoded_type.isEmpty())
     {
         QString str_select = QString("SELECT * "                // Select all rows...
                                      "FROM `contact_method` "   // ...from the contact_method table...
-                                     "WHERE method_type='%1' AND contact_id=%2 LIMIT 0,1").
-                arg(encoded_type).arg(nFilterByContact); // ...filtered by a method_type of 'encoded_type' function parameter.
+                                     "WHERE method_type=? AND contact_id=? LIMIT 0,1"); // ...filtered by a method_type of 'encoded_type' function parameter.
 
-        nReturnValue = DBHandler::getInstance()->querySize(str_select);
+        bReturnValue = DBHandler::getInstance()->queryExists(str_select, QVariantList() << encoded_type << nFilterByContact);
     }
 
-    return (nReturnValue > 0);
+    return bReturnValue;
 }
 
 // = "CREATE TABLE nym_method(nym_id TEXT, method_id INTEGER, address TEXT, PRIMARY KEY(nym_id, method_id, address))";
@@ -2635,7 +2866,7 @@ bool MTContactHandler::MethodTypeFoundOnAnyNym(QString method_type)
 {
     QMutexLocker locker(&m_Mutex);
 
-    int     nReturnValue = 0;
+    bool    bReturnValue = false;
     QString encoded_type = Encode(method_type);
 
     if (!encoded_type.isEmpty())
@@ -2644,12 +2875,12 @@ bool MTContactHandler::MethodTypeFoundOnAnyNym(QString method_type)
                                      "FROM `nym_method` "       // ...from the nym_method table...
                                      "INNER JOIN `msg_method` " // ...where it matches the 'msg_method' table...
                                      "ON nym_method.method_id=msg_method.method_id " // ...on the method_id column. (So we only see methods that are attached to a nym.)
-                                     "WHERE msg_method.method_type='%1' LIMIT 0,1").arg(encoded_type); // ...filtered by a method_type of 'encoded_type' function parameter.
+                                     "WHERE msg_method.method_type=? LIMIT 0,1"); // ...filtered by a method_type of 'encoded_type' function parameter.
 
-        nReturnValue = DBHandler::getInstance()->querySize(str_select);
+        bReturnValue = DBHandler::getInstance()->queryExists(str_select, QVariantList() << encoded_type);
     }
 
-    return (nReturnValue > 0);
+    return bReturnValue;
 }
 
 // = "CREATE TABLE contact_method(contact_id INTEGER, method_type TEXT, address TEXT, PRIMARY KEY(contact_id, method_id, address))";
@@ -2658,28 +2889,27 @@ bool MTContactHandler::MethodTypeFoundOnAnyContact(QString method_type)
 {
     QMutexLocker locker(&m_Mutex);
 
-    int     nReturnValue = 0;
+    bool    bReturnValue = false;
     QString encoded_type = Encode(method_type);
 
     if (!encoded_type.isEmpty())
     {
         QString str_select = QString("SELECT * "                // Select all rows...
                                      "FROM `contact_method` "   // ...from the contact_method table...
-                                     "WHERE method_type='%1' LIMIT 0,1").arg(encoded_type); // ...filtered by a method_type of 'encoded_type' function parameter.
+                                     "WHERE method_type=? LIMIT 0,1"); // ...filtered by a method_type of 'encoded_type' function parameter.
 
-        nReturnValue = DBHandler::getInstance()->querySize(str_select);
+        bReturnValue = DBHandler::getInstance()->queryExists(str_select, QVariantList() << encoded_type);
     }
 
-    return (nReturnValue > 0);
+    return bReturnValue;
 }
 
 
 bool MTContactHandler::MethodExists(int nMethodID)
 {
     QMutexLocker locker(&m_Mutex);
-    QString str_select = QString("SELECT * FROM `msg_method` WHERE `method_id`=%1 LIMIT 0,1").arg(nMethodID);
-    int nRows = DBHandler::getInstance()->querySize(str_select);
-    return (nRows > 0);
+    return DBHandler::getInstance()->queryExists("SELECT * FROM `msg_method` WHERE `method_id`=?",
+                                                 QVariantList() << nMethodID);
 }
 
 /*
@@ -2709,18 +2939,22 @@ bool MTContactHandler::AddMsgAddressToNym(QString nym_id, int nMethodID, QString
 
     QString encoded_address = Encode(address);
 
-    QString str_select = QString("SELECT `method_id` FROM `nym_method` "
-                                 "WHERE `nym_id`='%1' AND `method_id`=%2 AND `address`='%3' LIMIT 0,1").
-            arg(nym_id).arg(nMethodID).arg(encoded_address);
+    const QVariantList params = QVariantList() << nym_id << nMethodID << encoded_address;
 
-    int nRows = DBHandler::getInstance()->querySize(str_select);
+    QString str_select = "SELECT `method_id` FROM `nym_method` "
+                         "WHERE `nym_id`=? AND `method_id`=? AND `address`=? LIMIT 0,1";
 
-    if (0 == nRows) // It wasn't already there. (Add it.)
+    bool bQueryFailed = false;
+    const bool bExists = DBHandler::getInstance()->queryExists(str_select, params, &bQueryFailed);
+
+    if (!bExists && !bQueryFailed) // It wasn't already there. (Add it.)
     {
-        QString str_insert = QString("INSERT INTO `nym_method` "
-                                     "(`nym_id`, `method_id`, `address`) "
-                                     "VALUES('%1', %2, '%3')").arg(nym_id).arg(nMethodID).arg(encoded_address);
-        return DBHandler::getInstance()->runQuery(str_insert);
+        QString str_insert = "INSERT INTO `nym_method` "
+                             "(`nym_id`, `method_id`, `address`) "
+                             "VALUES(?, ?, ?)";
+        const bool bRan = DBHandler::getInstance()->runQuery(str_insert, params);
+        MTNameCache::getInstance()->invalidate(MTNameCache::AddressName, address.toStdString());
+        return bRan;
     }
 
     return false;
@@ -2732,11 +2966,12 @@ bool MTContactHandler::RemoveMsgAddressFromNym(QString nym_id, int nMethodID, QS
 
     QString encoded_address = Encode(address);
 
-    QString str_delete = QString("DELETE FROM `nym_method` "
-                                 "WHERE `nym_id`='%1' AND `method_id`=%2 AND `address`='%3'")
-            .arg(nym_id).arg(nMethodID).arg(encoded_address);
+    QString str_delete = "DELETE FROM `nym_method` "
+                         "WHERE `nym_id`=? AND `method_id`=? AND `address`=?";
 
-    return (DBHandler::getInstance()->runQuery(str_delete));
+    const bool bRan = DBHandler::getInstance()->runQuery(str_delete, QVariantList() << nym_id << nMethodID << encoded_address);
+    MTNameCache::getInstance()->invalidate(MTNameCache::AddressName, address.toStdString());
+    return bRan;
 }
 
 //QString create_contact_method  = "CREATE TABLE contact_method(contact_id INTEGER, method_type TEXT, address TEXT, PRIMARY KEY(contact_id, method_id, address))";
@@ -2752,18 +2987,22 @@ bool MTContactHandler::AddMsgAddressToContact(int nContactID, QString qstrMethod
     // Like, does Contact #5 already have "bitmessage" and "lkjsdfkjdffd" in the table?
     // (If so, no need to re-add them.)
     //
-    QString str_select = QString("SELECT `method_type` FROM `contact_method` "
-                                 "WHERE `contact_id`=%1 AND `method_type`='%2' AND `address`='%3' LIMIT 0,1").
-            arg(nContactID).arg(encoded_type).arg(encoded_address);
+    const QVariantList params = QVariantList() << nContactID << encoded_type << encoded_address;
+
+    QString str_select = "SELECT `method_type` FROM `contact_method` "
+                         "WHERE `contact_id`=? AND `method_type`=? AND `address`=? LIMIT 0,1";
 
-    int nRows = DBHandler::getInstance()->querySize(str_select);
+    bool bQueryFailed = false;
+    const bool bExists = DBHandler::getInstance()->queryExists(str_select, params, &bQueryFailed);
 
-    if (0 == nRows) // It wasn't already there. (Add it.)
+    if (!bExists && !bQueryFailed) // It wasn't already there. (Add it.)
     {
-        QString str_insert = QString("INSERT INTO `contact_method` "
-                                     "(`contact_id`, `method_type`, `address`) "
-                                     "VALUES(%1, '%2', '%3')").arg(nContactID).arg(encoded_type).arg(encoded_address);
-        return DBHandler::getInstance()->runQuery(str_insert);
+        QString str_insert = "INSERT INTO `contact_method` "
+                             "(`contact_id`, `method_type`, `address`) "
+                             "VALUES(?, ?, ?)";
+        const bool bRan = DBHandler::getInstance()->runQuery(str_insert, params);
+        MTNameCache::getInstance()->invalidate(MTNameCache::AddressName, address.toStdString());
+        return bRan;
     }
 
     return false;
@@ -2776,11 +3015,12 @@ bool MTContactHandler::RemoveMsgAddressFromContact(int nContactID, QString qstrM
     QString encoded_type    = Encode(qstrMethodType);
     QString encoded_address = Encode(address);
 
-    QString str_delete = QString("DELETE FROM `contact_method` "
-                                 "WHERE `contact_id`=%1 AND `method_type`='%2' AND `address`='%3'")
-            .arg(nContactID).arg(encoded_type).arg(encoded_address);
+    QString str_delete = "DELETE FROM `contact_method` "
+                         "WHERE `contact_id`=? AND `method_type`=? AND `address`=?";
 
-    return (DBHandler::getInstance()->runQuery(str_delete));
+    const bool bRan = DBHandler::getInstance()->runQuery(str_delete, QVariantList() << nContactID << encoded_type << encoded_address);
+    MTNameCache::getInstance()->invalidate(MTNameCache::AddressName, address.toStdString());
+    return bRan;
 }
 
 // --------------------------------------------
@@ -2833,35 +3073,21 @@ QString MTContactHandler::GetMethodType(QString qstrAddress) // Get the method t
     QString returnVal("");
     QString encoded_address = Encode(qstrAddress);
 
-    QString str_select = QString("SELECT method_type "
-                                 "FROM `msg_method` "
-                                 "INNER JOIN `nym_method` "
-                                 "ON nym_method.method_id=msg_method.method_id "
-                                 "WHERE nym_method.address='%1' LIMIT 0,1").arg(encoded_address);
-
-    int nRows = DBHandler::getInstance()->querySize(str_select);
-
-    if (nRows > 0)
-    {
-        QString qstrEncType = DBHandler::getInstance()->queryString(str_select, 0, 0);
-        QString qstrType    = Decode(qstrEncType);
-
-        return qstrType;
-    }
+    QVariant varEncType = DBHandler::getInstance()->queryValue("SELECT method_type "
+                                                               "FROM `msg_method` "
+                                                               "INNER JOIN `nym_method` "
+                                                               "ON nym_method.method_id=msg_method.method_id "
+                                                               "WHERE nym_method.address=? LIMIT 0,1",
+                                                               QVariantList() << encoded_address);
+    if (varEncType.isValid())
+        return Decode(varEncType.toString());
     // -------------------------------------------------------
-    str_select = QString("SELECT method_type "
-                         "FROM `contact_method` "
-                         "WHERE contact_method.address='%1' LIMIT 0,1").arg(encoded_address);
-
-    nRows = DBHandler::getInstance()->querySize(str_select);
-
-    if (nRows > 0)
-    {
-        QString qstrEncType = DBHandler::getInstance()->queryString(str_select, 0, 0);
-        QString qstrType    = Decode(qstrEncType);
-
-        return qstrType;
-    }
+    varEncType = DBHandler::getInstance()->queryValue("SELECT method_type "
+                                                      "FROM `contact_method` "
+                                                      "WHERE contact_method.address=? LIMIT 0,1",
+                                                      QVariantList() << encoded_address);
+    if (varEncType.isValid())
+        return Decode(varEncType.toString());
     // -------------------------------------------------------
     return returnVal;
 }
@@ -3103,13 +3329,15 @@ int MTContactHandler::GetMethodIDByNymAndAddress(QString filterByNym, QString qs
 
         QString str_select = QString("SELECT method_id "
                                      "FROM `nym_method` "
-                                     "WHERE nym_id='%1' AND address='%2'").arg(filterByNym).arg(qstrAddress);
+                                     "WHERE nym_id=? AND address=?");
 
-        int nRows = DBHandler::getInstance()->querySize(str_select);
+        QList<QSqlRecord> listRows;
+        DBHandler::getInstance()->queryMultiple(str_select, QVariantList() << filterByNym << qstrAddress,
+                                                [&listRows](const QSqlRecord & record) { listRows << record; });
         // -----------------------------------
-        for (int ii=0; ii < nRows; ii++)
+        for (int ii=0; ii < listRows.size(); ii++)
         {
-            nReturn = DBHandler::getInstance()->queryInt(str_select, 0, ii);
+            nReturn = listRows[ii].value(0).toInt();
             break; // Should only be one.
             // (You might have multiple addresses for the same NymID/MethodID,
             // but you won't have multiple MethodIDs for the same address. Thus,
@@ -3134,17 +3362,19 @@ bool MTContactHandler::GetMethodsAndAddrByNym(mapIDName & theMap, QString filter
                                      "FROM `nym_method` "
                                      "INNER JOIN `msg_method` "
                                      "ON nym_method.method_id=msg_method.method_id "
-                                     "WHERE nym_method.nym_id='%1' AND nym_method.method_id=%2").arg(filterByNym).arg(filterByMethodID);
+                                     "WHERE nym_method.nym_id=? AND nym_method.method_id=?");
 
-        int nRows = DBHandler::getInstance()->querySize(str_select);
+        QList<QSqlRecord> listRows;
+        DBHandler::getInstance()->queryMultiple(str_select, QVariantList() << filterByNym << filterByMethodID,
+                                                [&listRows](const QSqlRecord & record) { listRows << record; });
         // -----------------------------------
-        for (int ii=0; ii < nRows; ii++)
+        for (int ii=0; ii < listRows.size(); ii++)
         {
             //Extract data
-            int     nMethodID          = DBHandler::getInstance()->queryInt   (str_select, 0, ii);
-            QString qstrEncAddress     = DBHandler::getInstance()->queryString(str_select, 1, ii);
-            QString qstrEncType        = DBHandler::getInstance()->queryString(str_select, 2, ii);
-//          QString qstrEncTypeDisplay = DBHandler::getInstance()->queryString(str_select, 3, ii);
+            int     nMethodID          = listRows[ii].value(0).toInt();
+            QString qstrEncAddress     = listRows[ii].value(1).toString();
+            QString qstrEncType        = listRows[ii].value(2).toString();
+//          QString qstrEncTypeDisplay = listRows[ii].value(3).toString();
             // -----------------------------------------------------
             QString qstrAddress        = Decode(qstrEncAddress);
             QString qstrType           = Decode(qstrEncType);
@@ -3183,16 +3413,18 @@ bool MTContactHandler::GetAddressesByNym(mapIDName & theMap, QString filterByNym
                                      "FROM `nym_method` "
                                      "INNER JOIN `msg_method` "
                                      "ON nym_method.method_id=msg_method.method_id "
-                                     "WHERE nym_method.nym_id='%1' AND nym_method.method_id=%2").arg(filterByNym).arg(filterByMethodID);
+                                     "WHERE nym_method.nym_id=? AND nym_method.method_id=?");
 
-        int nRows = DBHandler::getInstance()->querySize(str_select);
+        QList<QSqlRecord> listRows;
+        DBHandler::getInstance()->queryMultiple(str_select, QVariantList() << filterByNym << filterByMethodID,
+                                                [&listRows](const QSqlRecord & record) { listRows << record; });
         // -----------------------------------
-        for (int ii=0; ii < nRows; ii++)
+        for (int ii=0; ii < listRows.size(); ii++)
         {
             //Extract data
-            QString qstrEncAddress     = DBHandler::getInstance()->queryString(str_select, 0, ii);
-            QString qstrEncType        = DBHandler::getInstance()->queryString(str_select, 1, ii);
-//          QString qstrEncTypeDisplay = DBHandler::getInstance()->queryString(str_select, 2, ii);
+            QString qstrEncAddress     = listRows[ii].value(0).toString();
+            QString qstrEncType        = listRows[ii].value(1).toString();
+//          QString qstrEncTypeDisplay = listRows[ii].value(2).toString();
             // -----------------------------------------------------
             QString qstrAddress        = Decode(qstrEncAddress);
             QString qstrType           = Decode(qstrEncType);
@@ -3228,15 +3460,17 @@ bool MTContactHandler::GetMsgMethodTypesByNym(mapIDName & theMap, QString filter
                                      "FROM `msg_method` "
                                      "INNER JOIN `nym_method` "
                                      "ON nym_method.method_id=msg_method.method_id "
-                                     "WHERE nym_method.nym_id='%1'").arg(filterByNym);
+                                     "WHERE nym_method.nym_id=?");
 
-        int nRows = DBHandler::getInstance()->querySize(str_select);
+        QList<QSqlRecord> listRows;
+        DBHandler::getInstance()->queryMultiple(str_select, QVariantList() << filterByNym,
+                                                [&listRows](const QSqlRecord & record) { listRows << record; });
         // -----------------------------------
-        for (int ii=0; ii < nRows; ii++)
+        for (int ii=0; ii < listRows.size(); ii++)
         {
-            QString qstrEncType        = DBHandler::getInstance()->queryString(str_select, 0, ii);
-            QString qstrEncTypeDisplay = DBHandler::getInstance()->queryString(str_select, 1, ii);
-//          QString qstrEncAddress     = DBHandler::getInstance()->queryString(str_select, 2, ii);
+            QString qstrEncType        = listRows[ii].value(0).toString();
+            QString qstrEncTypeDisplay = listRows[ii].value(1).toString();
+//          QString qstrEncAddress     = listRows[ii].value(2).toString();
             // -----------------------------------------------------
             QString qstrType           = Decode(qstrEncType);
             QString qstrTypeDisplay    = Decode(qstrEncTypeDisplay);
@@ -3276,29 +3510,34 @@ bool MTContactHandler::GetMsgMethodsByNym(mapIDName & theMap, QString filterByNy
         QMutexLocker locker(&m_Mutex);
 
         QString qstrTypeFilter("");
+        QVariantList params;
+        params << filterByNym;
 
         if (!filterByType.isEmpty())
         {
             QString qstrEncType = Encode(filterByType);
-            qstrTypeFilter = QString(" AND msg_method.method_type='%1'").arg(qstrEncType);
+            qstrTypeFilter = " AND msg_method.method_type=?";
+            params << qstrEncType;
         }
 
         QString str_select = QString("SELECT msg_method.method_id, msg_method.method_display_name, msg_method.method_type, msg_method.method_type_display "
                                      "FROM `msg_method` "
                                      "INNER JOIN `nym_method` "
                                      "ON nym_method.method_id=msg_method.method_id "
-                                     "WHERE nym_method.nym_id='%1'%2").arg(filterByNym).arg(qstrTypeFilter);
+                                     "WHERE nym_method.nym_id=?%1").arg(qstrTypeFilter);
 
-        int nRows = DBHandler::getInstance()->querySize(str_select);
+        QList<QSqlRecord> listRows;
+        DBHandler::getInstance()->queryMultiple(str_select, params,
+                                                [&listRows](const QSqlRecord & record) { listRows << record; });
         // -----------------------------------
-        for (int ii=0; ii < nRows; ii++)
+        for (int ii=0; ii < listRows.size(); ii++)
         {
             //Extract data
-            int     nMethodID          = DBHandler::getInstance()->queryInt   (str_select, 0, ii);
-            QString qstrEncDisplayName = DBHandler::getInstance()->queryString(str_select, 1, ii);
-            QString qstrEncType        = DBHandler::getInstance()->queryString(str_select, 2, ii);
-            QString qstrEncTypeDisplay = DBHandler::getInstance()->queryString(str_select, 3, ii);
-//          QString qstrEncConnect     = DBHandler::getInstance()->queryString(str_select, 4, ii);
+            int     nMethodID          = listRows[ii].value(0).toInt();
+            QString qstrEncDisplayName = listRows[ii].value(1).toString();
+            QString qstrEncType        = listRows[ii].value(2).toString();
+            QString qstrEncTypeDisplay = listRows[ii].value(3).toString();
+//          QString qstrEncConnect     = listRows[ii].value(4).toString();
             // -----------------------------------------------------
             QString qstrDisplayName    = Decode(qstrEncDisplayName);
             QString qstrType           = Decode(qstrEncType);
@@ -3343,12 +3582,14 @@ QString MTContactHandler::GetNymByAddress(QString qstrAddress)
 
         QString str_select = QString("SELECT nym_id "
                                      "FROM `nym_method` "
-                                     "WHERE address='%1'").arg(encoded_address);
+                                     "WHERE address=?");
 
-        int nRows = DBHandler::getInstance()->querySize(str_select);
+        QList<QSqlRecord> listRows;
+        DBHandler::getInstance()->queryMultiple(str_select, QVariantList() << encoded_address,
+                                                [&listRows](const QSqlRecord & record) { listRows << record; });
         // -----------------------------------
-        for (int ii=0; ii < nRows; ++ii)
-            return DBHandler::getInstance()->queryString(str_select, 0, ii);
+        for (int ii=0; ii < listRows.size(); ++ii)
+            return listRows[ii].value(0).toString();
     }
 
     return qstrResult;
@@ -3368,13 +3609,15 @@ int MTContactHandler::GetContactByAddress(QString qstrAddress)
 
         QString str_select = QString("SELECT contact_id "
                                      "FROM `contact_method` "
-                                     "WHERE address='%1'").arg(encoded_address);
+                                     "WHERE address=?");
 
-        int nRows = DBHandler::getInstance()->querySize(str_select);
+        QList<QSqlRecord> listRows;
+        DBHandler::getInstance()->queryMultiple(str_select, QVariantList() << encoded_address,
+                                                [&listRows](const QSqlRecord & record) { listRows << record; });
         // -----------------------------------
-        for (int ii=0; ii < nRows; ++ii)
+        for (int ii=0; ii < listRows.size(); ++ii)
         {
-            return DBHandler::getInstance()->queryInt(str_select, 0, ii);
+            return listRows[ii].value(0).toInt();
         }
     }
 
@@ -3391,24 +3634,29 @@ bool MTContactHandler::GetMsgMethodTypesByContact(mapIDName & theMap, int nFilte
         QMutexLocker locker(&m_Mutex);
 
         QString qstrTypeFilter("");
+        QVariantList params;
+        params << nFilterByContact;
 
         if (!filterByType.isEmpty())
         {
             QString qstrEncType = Encode(filterByType);
-            qstrTypeFilter = QString(" AND method_type='%1'").arg(qstrEncType);
+            qstrTypeFilter = " AND method_type=?";
+            params << qstrEncType;
         }
 
         QString str_select = QString("SELECT contact_method.method_type, contact_method.address "
                                      "FROM `contact_method` "
-                                     "WHERE contact_id=%1%2").arg(nFilterByContact).arg(qstrTypeFilter);
+                                     "WHERE contact_id=?%1").arg(qstrTypeFilter);
 
-        int nRows = DBHandler::getInstance()->querySize(str_select);
+        QList<QSqlRecord> listRows;
+        DBHandler::getInstance()->queryMultiple(str_select, params,
+                                                [&listRows](const QSqlRecord & record) { listRows << record; });
         // -----------------------------------
-        for (int ii=0; ii < nRows; ii++)
+        for (int ii=0; ii < listRows.size(); ii++)
         {
             //Extract data
-            QString qstrEncType    = DBHandler::getInstance()->queryString(str_select, 0, ii);
-            QString qstrEncAddress = DBHandler::getInstance()->queryString(str_select, 1, ii);
+            QString qstrEncType    = listRows[ii].value(0).toString();
+            QString qstrEncAddress = listRows[ii].value(1).toString();
             // -----------------------------------------------------
             QString qstrType       = Decode(qstrEncType);
             QString qstrAddress    = Decode(qstrEncAddress);
@@ -3469,12 +3717,12 @@ int  MTContactHandler::AddMsgMethod(QString display_name, QString type, QString
     QString encoded_type_display  = Encode(type_display);
     QString encrypted_connect_str = Encrypt(connect);
 
-    QString str_insert = QString("INSERT INTO `msg_method` "
-                                 "(`method_id`, `method_display_name`, `method_type`, `method_type_display`, `method_connect`) "
-                                 "VALUES(NULL, '%1', '%2', '%3', '%4')")
-            .arg(encoded_display_name).arg(encoded_type).arg(encoded_type_display).arg(encrypted_connect_str);
+    QString str_insert = "INSERT INTO `msg_method` "
+                         "(`method_id`, `method_display_name`, `method_type`, `method_type_display`, `method_connect`) "
+                         "VALUES(NULL, ?, ?, ?, ?)";
 
-    DBHandler::getInstance()->runQuery(str_insert);
+    DBHandler::getInstance()->runQuery(str_insert, QVariantList() << encoded_display_name << encoded_type
+                                                                  << encoded_type_display << encrypted_connect_str);
 
     int nMethodID = DBHandler::getInstance()->queryInt("SELECT last_insert_rowid() from `msg_method`", 0, 0);
 
@@ -3490,13 +3738,13 @@ bool MTContactHandler::DeleteMsgMethod(int nMethodID)
 {
     QMutexLocker locker(&m_Mutex);
 
-    QString str_delete_nym     = QString("DELETE FROM `nym_method` "
-                                 "WHERE `method_id`=%1").arg(nMethodID);
-    QString str_delete_msg     = QString("DELETE FROM `msg_method` "
-                                 "WHERE `method_id`=%1").arg(nMethodID);
+    QString str_delete_nym     = "DELETE FROM `nym_method` "
+                                 "WHERE `method_id`=?";
+    QString str_delete_msg     = "DELETE FROM `msg_method` "
+                                 "WHERE `method_id`=?";
 
-    return (DBHandler::getInstance()->runQuery(str_delete_nym)     &&
-            DBHandler::getInstance()->runQuery(str_delete_msg));
+    return (DBHandler::getInstance()->runQuery(str_delete_nym, QVariantList() << nMethodID)     &&
+            DBHandler::getInstance()->runQuery(str_delete_msg, QVariantList() << nMethodID));
 }
 
 // --------------------------------------------
@@ -3510,16 +3758,18 @@ void MTContactHandler::NotifyOfNymServerPair(QString nym_id_string, QString nota
 {
     QMutexLocker locker(&m_Mutex);
 
-    QString str_select_server = QString("SELECT `notary_id` FROM `nym_server` WHERE `nym_id`='%1' AND `notary_id`='%2' LIMIT 0,1").
-            arg(nym_id_string).arg(notary_id_string);
-    int nRowsServer = DBHandler::getInstance()->querySize(str_select_server);
+    const QVariantList params = QVariantList() << nym_id_string << notary_id_string;
+
+    QString str_select_server = "SELECT `notary_id` FROM `nym_server` WHERE `nym_id`=? AND `notary_id`=? LIMIT 0,1";
+    bool bQueryFailed = false;
+    const bool bServerExists = DBHandler::getInstance()->queryExists(str_select_server, params, &bQueryFailed);
 
-    if (0 == nRowsServer) // It wasn't already there. (Add it.)
+    if (!bServerExists && !bQueryFailed) // It wasn't already there. (Add it.)
     {
-        QString str_insert_server = QString("INSERT INTO `nym_server` "
-                                            "(`nym_id`, `notary_id`) "
-                                            "VALUES('%1', '%2')").arg(nym_id_string).arg(notary_id_string);
-        DBHandler::getInstance()->runQuery(str_insert_server);
+        QString str_insert_server = "INSERT INTO `nym_server` "
+                                    "(`nym_id`, `notary_id`) "
+                                    "VALUES(?, ?)";
+        DBHandler::getInstance()->runQuery(str_insert_server, params);
     }
 }
 
@@ -3527,15 +3777,15 @@ void MTContactHandler::NotifyOfNymServerUnpair(QString nym_id_string, QString no
 {
     QMutexLocker locker(&m_Mutex);
 
-    QString str_select_server = QString("SELECT `notary_id` FROM `nym_server` WHERE `nym_id`='%1' AND `notary_id`='%2' LIMIT 0,1").
-            arg(nym_id_string).arg(notary_id_string);
-    const int nRowsServer = DBHandler::getInstance()->querySize(str_select_server);
+    const QVariantList params = QVariantList() << nym_id_string << notary_id_string;
+
+    QString str_select_server = "SELECT `notary_id` FROM `nym_server` WHERE `nym_id`=? AND `notary_id`=? LIMIT 0,1";
+    const bool bServerExists = DBHandler::getInstance()->queryExists(str_select_server, params);
 
-    if (nRowsServer > 0) // It's already there. (Remove it.)
+    if (bServerExists) // It's already there. (Remove it.)
     {
-        QString str_insert_server = QString("DELETE FROM `nym_server` WHERE `nym_id`='%1' AND `notary_id`='%2'").
-                arg(nym_id_string).arg(notary_id_string);
-        DBHandler::getInstance()->runQuery(str_insert_server);
+        QString str_insert_server = "DELETE FROM `nym_server` WHERE `nym_id`=? AND `notary_id`=?";
+        DBHandler::getInstance()->runQuery(str_insert_server, params);
     }
 }
 
@@ -3543,12 +3793,16 @@ void MTContactHandler::NotifyOfNymNamePair(QString nym_id_string, QString name_s
 {
     QMutexLocker locker(&m_Mutex);
 
-    QString str_select = QString("SELECT `nym_id` FROM `nym` WHERE `nym_id`='%1' LIMIT 0,1").arg(nym_id_string);
-    const int nRows = DBHandler::getInstance()->querySize(str_select);
+    QString str_select = "SELECT `nym_id` FROM `nym` WHERE `nym_id`=? LIMIT 0,1";
+    bool bQueryFailed = false;
+    const bool bExists = DBHandler::getInstance()->queryExists(str_select, QVariantList() << nym_id_string, &bQueryFailed);
+
+    if (bQueryFailed) // Couldn't tell, so don't insert over a Nym that may be there.
+        return;
 
     QString queryStr;
 
-    if (0 == nRows) // It wasn't already there. (Add it.)
+    if (!bExists) // It wasn't already there. (Add it.)
     {
         queryStr = QString("INSERT INTO `nym` "
                            "(`nym_id`, `nym_display_name`, `contact_id`) "
@@ -3602,14 +3856,16 @@ int MTContactHandler::FindContactIDByAcctID(QString acct_id_string,
                                  "FROM `nym` "
                                  "INNER JOIN `nym_account` "
                                  "ON nym_account.nym_id=nym.nym_id "
-                                 "WHERE nym_account.account_id='%1'").arg(acct_id_string);
+                                 "WHERE nym_account.account_id=?");
 
-    int nRows = DBHandler::getInstance()->querySize(str_select);
+    QList<QSqlRecord> listRows;
+    DBHandler::getInstance()->queryMultiple(str_select, QVariantList() << acct_id_string,
+                                            [&listRows](const QSqlRecord & record) { listRows << record; });
 
-    for(int ii=0; ii < nRows; ii++)
+    for(int ii=0; ii < listRows.size(); ii++)
     {
         //Extract data
-        nContactID = DBHandler::getInstance()->queryInt(str_select, 0, ii);
+        nContactID = listRows[ii].value(0).toInt();
         break;
 
         // IN THIS CASE, the account record already existed for the given account ID.
@@ -3658,11 +3914,15 @@ int MTContactHandler::FindContactIDByAcctID(QString acct_id_string,
     // ---------------------------------
     QString str_select_acct = QString("SELECT * "
                                       "FROM `nym_account` "
-                                      "WHERE account_id='%1'").arg(acct_id_string);
+                                      "WHERE account_id=?");
 
-    int nRowsAcct = DBHandler::getInstance()->querySize(str_select_acct);
+    bool bQueryFailed = false;
+    const bool bAcctExists = DBHandler::getInstance()->queryExists(str_select_acct, QVariantList() << acct_id_string, &bQueryFailed);
 
-    if (nRowsAcct > 0) // If the account record already existed.
+    if (bQueryFailed) // Couldn't tell, so don't insert over an account that may be there.
+        return nContactID;
+
+    if (bAcctExists) // If the account record already existed.
     {
         // Update it IF we have values worth sticking in there.
         //
@@ -3670,9 +3930,9 @@ int MTContactHandler::FindContactIDByAcctID(QString acct_id_string,
         {
       //    nym_account(account_id TEXT PRIMARY KEY, notary_id TEXT, nym_id TEXT, asset_id TEXT,
       //                account_display_name TEXT)";
-            QString existing_notary_id = DBHandler::getInstance()->queryString(str_select_acct, 1, 0);
-            QString existing_asset_id  = DBHandler::getInstance()->queryString(str_select_acct, 3, 0);
-            QString existing_nym_id    = DBHandler::getInstance()->queryString(str_select_acct, 2, 0);
+            QString existing_notary_id = DBHandler::getInstance()->queryString(str_select_acct, QVariantList() << acct_id_string, 1);
+            QString existing_asset_id  = DBHandler::getInstance()->queryString(str_select_acct, QVariantList() << acct_id_string, 3);
+            QString existing_nym_id    = DBHandler::getInstance()->queryString(str_select_acct, QVariantList() << acct_id_string, 2);
 
             // Here we're just making sure we don't run an update unless we've
             // actually added some new data.
@@ -3685,10 +3945,10 @@ int MTContactHandler::FindContactIDByAcctID(QString acct_id_string,
                 QString final_asset_id     = !existing_asset_id.isEmpty()  ? existing_asset_id  : asset_id_string;
                         final_nym_id       = !existing_nym_id.isEmpty()    ? existing_nym_id    : nym_id_string;
                 // -----------------------------------------------------------------
-                QString str_update_acct = QString("UPDATE `nym_account` SET `notary_id`='%1',`asset_id`='%2',`nym_id`='%3' WHERE `account_id`='%4'").
-                        arg(final_notary_id).arg(final_asset_id).arg(final_nym_id).arg(acct_id_string);
+                QString str_update_acct = "UPDATE `nym_account` SET `notary_id`=?,`asset_id`=?,`nym_id`=? WHERE `account_id`=?";
 
-                DBHandler::getInstance()->runQuery(str_update_acct);
+                DBHandler::getInstance()->runQuery(str_update_acct, QVariantList() << final_notary_id << final_asset_id
+                                                                                   << final_nym_id << acct_id_string);
             }
         }
     }
@@ -3696,10 +3956,11 @@ int MTContactHandler::FindContactIDByAcctID(QString acct_id_string,
     {
         // Add it then.
         //
-        QString str_insert_acct = QString("INSERT INTO `nym_account` "
-                                          "(`account_id`, `notary_id`, `nym_id`, `asset_id`) "
-                                          "VALUES('%1', '%2', '%3', '%4')").arg(acct_id_string).arg(notary_id_string).arg(nym_id_string).arg(asset_id_string);
-        DBHandler::getInstance()->runQuery(str_insert_acct);
+        QString str_insert_acct = "INSERT INTO `nym_account` "
+                                  "(`account_id`, `notary_id`, `nym_id`, `asset_id`) "
+                                  "VALUES(?, ?, ?, ?)";
+        DBHandler::getInstance()->runQuery(str_insert_acct, QVariantList() << acct_id_string << notary_id_string
+                                                                           << nym_id_string << asset_id_string);
     }
     // By this point, the record of this account definitely exists, though we may not have previously
     // had a record of it. (Thus below, we can assume to update, rather than insert, such a record.)
@@ -3710,18 +3971,20 @@ int MTContactHandler::FindContactIDByAcctID(QString acct_id_string,
     //
     if (!final_nym_id.isEmpty())
     {
-        QString str_select_nym = QString("SELECT `contact_id` FROM `nym` WHERE `nym_id`='%1' LIMIT 0,1").arg(final_nym_id);
+        QString str_select_nym = "SELECT `contact_id` FROM `nym` WHERE `nym_id`=? LIMIT 0,1";
 
-        int nRowsNym = DBHandler::getInstance()->querySize(str_select_nym);
+        QList<QSqlRecord> listRowsNym;
+        DBHandler::getInstance()->queryMultiple(str_select_nym, QVariantList() << final_nym_id,
+                                                [&listRowsNym](const QSqlRecord & record) { listRowsNym << record; });
 
-        if (nRowsNym > 0) // the nymId was found!
+        if (listRowsNym.size() > 0) // the nymId was found!
         {
-            for(int ii=0; ii < nRowsNym; ii++)
+            for(int ii=0; ii < listRowsNym.size(); ii++)
             {
                 // Found it! (If we're in this loop.) This means a Contact was found in the contact db
                 // who already contained a Nym with an ID matching the NymID on this account.
                 //
-                nContactID = DBHandler::getInstance()->queryInt(str_select_nym, 0, ii);
+                nContactID = listRowsNym[ii].value(0).toInt();
                 // ------------------------------------------------------------
                 // So we definitely found the right contact and should return it.
                 //
@@ -3740,10 +4003,10 @@ int MTContactHandler::FindContactIDByAcctID(QString acct_id_string,
 //          INSERT OR IGNORE INTO players (user_name, age) VALUES ("steven", 32);
 //          UPDATE players SET user_name="steven", age=32 WHERE user_name="steven";
 
-            QString str_insert_nym = QString("INSERT INTO `nym` "
-                                             "(`nym_id`) "
-                                             "VALUES('%1')").arg(final_nym_id);
-            DBHandler::getInstance()->runQuery(str_insert_nym);
+            QString str_insert_nym = "INSERT INTO `nym` "
+                                     "(`nym_id`) "
+                                     "VALUES(?)";
+            DBHandler::getInstance()->runQuery(str_insert_nym, QVariantList() << final_nym_id);
             // -----------------------------------------------
 //          QString str_update_nym = QString("UPDATE `nym` "
 //                                           "(`nym_id`) "
@@ -3756,15 +4019,17 @@ int MTContactHandler::FindContactIDByAcctID(QString acct_id_string,
         //
         if (!final_notary_id.isEmpty())
         {
-            QString str_select_server = QString("SELECT `notary_id` FROM `nym_server` WHERE `nym_id`='%1' AND `notary_id`='%2' LIMIT 0,1").arg(final_nym_id).arg(final_notary_id);
-            int nRowsServer = DBHandler::getInstance()->querySize(str_select_server);
+            const QVariantList params = QVariantList() << final_nym_id << final_notary_id;
+
+            QString str_select_server = "SELECT `notary_id` FROM `nym_server` WHERE `nym_id`=? AND `notary_id`=? LIMIT 0,1";
+            const bool bServerExists = DBHandler::getInstance()->queryExists(str_select_server, params, &bQueryFailed);
 
-            if (0 == nRowsServer) // It wasn't already there. (Add it.)
+            if (!bServerExists && !bQueryFailed) // It wasn't already there. (Add it.)
             {
-                QString str_insert_server = QString("INSERT INTO `nym_server` "
-                                                    "(`nym_id`, `notary_id`) "
-                                                    "VALUES('%1', '%2')").arg(final_nym_id).arg(final_notary_id);
-                DBHandler::getInstance()->runQuery(str_insert_server);
+                QString str_insert_server = "INSERT INTO `nym_server` "
+                                            "(`nym_id`, `notary_id`) "
+                                            "VALUES(?, ?)";
+                DBHandler::getInstance()->runQuery(str_insert_server, params);
             }
         }
     } // NymID is available (was passed in.)
@@ -3778,19 +4043,10 @@ int MTContactHandler::FindContactIDByNymID(QString nym_id_string)
 {
     QMutexLocker locker(&m_Mutex);
 
-    QString str_select = QString("SELECT `contact_id` FROM `nym` WHERE `nym_id`='%1'").arg(nym_id_string);
-
-    int nRows = DBHandler::getInstance()->querySize(str_select);
-
-    for(int ii=0; ii < nRows; ii++)
-    {
-        //Extract data
-        int contact_id = DBHandler::getInstance()->queryInt(str_select, 0, ii);
-
-        return contact_id; // In practice there should only be one row.
-    }
+    QString str_select = "SELECT `contact_id` FROM `nym` WHERE `nym_id`=?";
 
-    return 0; // Didn't find anyone.
+    // In practice there should only be one row. 0 if we didn't find anyone.
+    return DBHandler::getInstance()->queryInt(str_select, QVariantList() << nym_id_string);
 }
 
 
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <string>
+#include <map>
 
 #include "core/WinsockWrapper.h"
 #include "core/ExportWrapper.h"
@@ -32,11 +33,66 @@ int claimPolarityToInt(opentxs::OT_API::ClaimPolarity polarity);
 opentxs::OT_API::ClaimPolarity intToClaimPolarity(int polarity);
 
 
+// Process-wide cache of ID -> display name, shared by every MTNameLookupQT instance.
+// Resolving a single Nym name can cost several SQLite queries, and the table models
+// resolve names for every visible cell and every filtered row, so the answers
+// (including empty ones) are kept here until something that could change them happens.
+//
+// Entries are dropped by MTContactHandler when contacts, claims or addresses change,
+// and by Moneychanger when the wallet's nyms, servers, assets or accounts change.
+//
+class MTNameCache
+{
+public:
+    enum NameType
+    {
+        NymName = 0,
+        AcctName,
+        ServerName,
+        AssetName,
+        AddressName,
+        NameTypeCount
+    };
+
+    static MTNameCache * getInstance();
+
+    // The generation changes on every invalidation. Read it before resolving a
+    // name and pass it to insert(), so that a result computed while something
+    // was being invalidated is never stored.
+    quint64 generation();
+
+    bool lookup(NameType type, const std::string & str_id, std::string & str_name);
+    void insert(NameType type, const std::string & str_id, const std::string & str_name, quint64 nGeneration);
+
+    void invalidate    (NameType type, const std::string & str_id);
+    void invalidateType(NameType type);
+    void invalidateNym (const std::string & str_nym_id); // Also drops account and address names, which can derive from it.
+    void clear();
+
+    quint64 hits();
+    quint64 misses();
+
+private:
+    MTNameCache();
+
+    QMutex  m_Mutex;
+    quint64 m_generation;
+    quint64 m_hits;
+    quint64 m_misses;
+
+    std::map<std::string, std::string> m_names[NameTypeCount];
+};
+
+
 class MTNameLookupQT : public opentxs::OTNameLookup
 {
 public:
     virtual ~MTNameLookupQT() {}
 
+    // Wallet contract names; cached the same way as the virtual lookups below.
+    std::string GetServerName(const std::string & str_id) const;
+    std::string GetAssetName (const std::string & str_id) const;
+
     virtual std::string GetNymName(const std::string & str_id,
                                    const std::string   p_notary_id) const;
 
@@ -135,8 +191,8 @@ public:
   static QString Encrypt(QString plaintext);
   static QString Decrypt(QString ciphertext);
   // ---------------------------------------------
-  QString GetValueByIDLowLevel         (QString str_select);
-  QString GetEncryptedValueByIDLowLevel(QString str_select);
+  QString GetValueByIDLowLevel         (QString str_select, QVariantList params);
+  QString GetEncryptedValueByIDLowLevel(QString str_select, QVariantList params);
 
   QString GetValueByID(QString qstrID,                 QString column, QString table, QString id_name);
   bool    SetValueByID(QString qstrID, QString value,  QString column, QString table, QString id_name);
@@ -258,6 +314,7 @@ public:
 
   bool LowLevelUpdateMessageBody(int nMessageID, const QString & qstrBody);
   bool CreateMessageBody(QString qstrBody);
+  bool CreateMessageBody(int nMessageID, QString qstrBody);
   bool DeleteMessageBody(int nID);
   bool UpdateMessageBody(int nMessageID, const QString & qstrBody);
   QString GetMessageBody(int nID);
@@ -265,6 +322,7 @@ public:
   int  GetPaymentIdByTxnDisplayId(int64_t lTxnDisplayId, QString qstrNymId);
   bool LowLevelUpdatePaymentBody(int nPaymentID, const QString qstrBody, const QString qstrPendingBody);
   bool CreatePaymentBody(QString qstrBody, QString qstrPendingBody);
+  bool CreatePaymentBody(int nPaymentID, QString qstrBody, QString qstrPendingBody);
   bool DeletePaymentBody(int nID);
   bool UpdatePaymentBody(int nPaymentID, const QString qstrBody, const QString qstrPendingBody);
   QString GetPaymentBody(int nID);
@@ -308,6 +366,8 @@ protected:
   bool claimVerificationLowlevel(const QString & qstrClaimId, const QString & qstrClaimantNymId,
                                  const QString & qstrVerifierNymId, opentxs::OT_API::ClaimPolarity claimPolarity);
 
+  void InvalidateCachedNamesForContact(int nContactID);
+
   // ----------------------------------------------------------
   public:
     ~MTContactHandler();
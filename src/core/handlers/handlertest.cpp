@@ -0,0 +1,421 @@
+#ifndef __STABLE_HPP__
+#include <core/stable.hpp>
+#endif
+
+#include <core/handlers/handlertest.hpp>
+#include <core/handlers/searchindex.hpp>
+#include <core/handlers/DBHandler.hpp>
+#include <core/handlers/contacthandler.hpp>
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QStandardItemModel>
+#include <QStringList>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+
+namespace
+{
+
+// One row of the synthetic payment table, as indexes into the pools below.
+//
+struct SyntheticPayment
+{
+    qint64 lTxnId;
+    qint64 lTxnIdDisplay;
+    int    nMyNym, nSenderNym, nRecipientNym;
+    int    nMyAcct, nSenderAcct, nRecipientAcct;
+    int    nAsset, nNotary, nMemo;
+};
+
+QString randomId(std::mt19937 & rng, const QString & qstrPrefix)
+{
+    static const char s_chars[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+    std::uniform_int_distribution<int> charDist(0, static_cast<int>(sizeof(s_chars)) - 2);
+
+    QString qstrId(qstrPrefix);
+    for (int ii = 0; ii < 40; ++ii)
+        qstrId += QChar(s_chars[charDist(rng)]);
+    return qstrId;
+}
+
+// What a wallet with a long history looks like to the search box: a few hundred
+// Nyms and accounts, a handful of assets and notaries, and memos that repeat.
+//
+class SyntheticPayments
+{
+public:
+    explicit SyntheticPayments(int nRows)
+    {
+        std::mt19937 rng(100000);
+
+        static const char * const s_first[] = { "Alice", "Bob", "Carol", "Dave", "Erin", "Frank", "Grace", "Heidi",
+                                                "Ivan", "Judy", "Mallory", "Niaj", "Olivia", "Peggy", "Rupert", "Sybil" };
+        static const char * const s_last[]  = { "Smith", "Jones", "Brown", "Taylor", "Wilson", "Davies", "Evans",
+                                                "Thomas", "Johnson", "Roberts", "Walker", "Wright", "Robinson" };
+        static const char * const s_memo[]  = { "invoice", "rent", "coffee", "refund", "consulting", "groceries",
+                                                "deposit", "salary", "loan repayment", "gift", "dinner", "tickets" };
+
+        for (int ii = 0; ii < 400; ++ii)
+        {
+            m_vecNyms.push_back(randomId(rng, "ot"));
+            m_names.insert(m_vecNyms.back(), QString("%1 %2").arg(s_first[ii % 16]).arg(s_last[(ii / 16) % 13]));
+        }
+        for (int ii = 0; ii < 600; ++ii)
+        {
+            m_vecAccts.push_back(randomId(rng, "ot"));
+            m_names.insert(m_vecAccts.back(), QString("Account %1").arg(ii));
+        }
+        for (int ii = 0; ii < 6; ++ii)
+        {
+            m_vecAssets.push_back(randomId(rng, "ot"));
+            m_names.insert(m_vecAssets.back(), QString("Asset %1").arg(ii));
+        }
+        for (int ii = 0; ii < 3; ++ii)
+        {
+            m_vecNotaries.push_back(randomId(rng, "ot"));
+            m_names.insert(m_vecNotaries.back(), QString("Notary %1").arg(ii));
+        }
+        for (int ii = 0; ii < 200; ++ii)
+            m_vecMemos.push_back(QString("%1 %2").arg(s_memo[ii % 12]).arg(ii));
+        // -----------------------------------
+        std::uniform_int_distribution<int> nymDist   (0, static_cast<int>(m_vecNyms.size())  - 1);
+        std::uniform_int_distribution<int> acctDist  (0, static_cast<int>(m_vecAccts.size()) - 1);
+        std::uniform_int_distribution<int> memoDist  (0, static_cast<int>(m_vecMemos.size()) - 1);
+        std::uniform_int_distribution<int> assetDist (0, static_cast<int>(m_vecAssets.size()) - 1);
+        std::uniform_int_distribution<int> notaryDist(0, static_cast<int>(m_vecNotaries.size()) - 1);
+
+        m_vecRows.resize(nRows);
+
+        for (int ii = 0; ii < nRows; ++ii)
+        {
+            SyntheticPayment & thePayment = m_vecRows[ii];
+
+            thePayment.lTxnId         = 100000 + 3 * ii;
+            thePayment.lTxnIdDisplay  = 100000 + 3 * ii;
+            thePayment.nMyNym         = ii % 5; // Only a few of them are mine.
+            thePayment.nSenderNym     = nymDist(rng);
+            thePayment.nRecipientNym  = nymDist(rng);
+            thePayment.nMyAcct        = ii % 8;
+            thePayment.nSenderAcct    = acctDist(rng);
+            thePayment.nRecipientAcct = acctDist(rng);
+            thePayment.nAsset         = assetDist(rng);
+            thePayment.nNotary        = notaryDist(rng);
+            thePayment.nMemo          = memoDist(rng);
+        }
+    }
+
+    const QString & nym(int nIndex) const { return m_vecNyms[nIndex]; }
+
+    // The same fields ModelPayments::searchText() joins, with the names looked
+    // up in a hash (the best case for the old filter, which also asked OT).
+    //
+    QString searchText(int nRow) const
+    {
+        const SyntheticPayment & thePayment = m_vecRows[nRow];
+
+        QStringList listFields;
+
+        listFields << QString::number(thePayment.lTxnId) << QString::number(thePayment.lTxnIdDisplay)
+                   << m_vecMemos[thePayment.nMemo] << QString("") << QString("otserver")
+                   << m_vecNyms[thePayment.nMyNym] << m_vecNyms[thePayment.nSenderNym] << m_vecNyms[thePayment.nRecipientNym]
+                   << m_vecAccts[thePayment.nMyAcct] << m_vecAccts[thePayment.nSenderAcct] << m_vecAccts[thePayment.nRecipientAcct]
+                   << QString("") << QString("") << m_vecAssets[thePayment.nAsset] << m_vecNotaries[thePayment.nNotary]
+                   << m_names.value(m_vecNyms[thePayment.nMyNym])      << m_names.value(m_vecAccts[thePayment.nMyAcct])
+                   << m_names.value(m_vecNyms[thePayment.nSenderNym])  << m_names.value(m_vecNyms[thePayment.nRecipientNym])
+                   << m_names.value(m_vecAssets[thePayment.nAsset])    << m_names.value(m_vecNotaries[thePayment.nNotary]);
+
+        return listFields.join(MTSearchIndex::FieldSeparator);
+    }
+
+private:
+    std::vector<SyntheticPayment> m_vecRows;
+    std::vector<QString> m_vecNyms, m_vecAccts, m_vecAssets, m_vecNotaries, m_vecMemos;
+    QHash<QString, QString> m_names;
+};
+
+} // namespace
+
+
+//static
+bool HandlerTest::TestHandlerFunctions()
+{
+    if (!TestSearchIndex(100000))
+        return false;
+
+    if (!TestQueryPlans())
+        return false;
+
+    if (!TestStatementCache(1000, 5))
+        return false;
+
+    if (!TestQueryExists(10000))
+        return false;
+
+    return true;
+}
+
+//static
+bool HandlerTest::TestSearchIndex(int nRows)
+{
+    const SyntheticPayments thePayments(nRows);
+
+    // Only the row count comes from the model; the text comes from thePayments.
+    QStandardItemModel theModel(nRows, 1);
+
+    MTSearchIndex theIndex(&theModel, [&thePayments](int nSourceRow) { return thePayments.searchText(nSourceRow); });
+    // -----------------------------------
+    // Typing a name, a memo, and the start of a Nym ID.
+    //
+    QStringList listKeystrokes;
+
+    const QString qstrName("Alice"), qstrMemo("refund 1"), qstrNymId(thePayments.nym(3).left(10));
+
+    for (int ii = 1; ii <= qstrName.size();  ++ii) listKeystrokes << qstrName.left(ii);
+    for (int ii = 1; ii <= qstrMemo.size();  ++ii) listKeystrokes << qstrMemo.left(ii);
+    for (int ii = 1; ii <= qstrNymId.size(); ++ii) listKeystrokes << qstrNymId.left(ii);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    theIndex.rowMatches(0, QString()); // Builds the index, like the first keystroke after select().
+
+    const qint64 nBuildMs = timer.elapsed();
+
+    qint64 nIndexTotalUs = 0, nIndexMaxUs = 0;
+    qint64 nScanTotalUs  = 0, nScanMaxUs  = 0;
+    // -----------------------------------
+    for (QStringList::const_iterator it = listKeystrokes.begin(); it != listKeystrokes.end(); ++it)
+    {
+        const QString & qstrFilter = *it;
+
+        int nIndexMatches = 0, nScanMatches = 0;
+
+        // What the proxy does: ask once per row, for the same filter.
+        timer.restart();
+        for (int nRow = 0; nRow < nRows; ++nRow)
+            if (theIndex.rowMatches(nRow, qstrFilter))
+                ++nIndexMatches;
+        const qint64 nIndexUs = timer.nsecsElapsed() / 1000;
+
+        // What filterAcceptsRow used to do: rebuild every row's text on every keystroke.
+        timer.restart();
+        for (int nRow = 0; nRow < nRows; ++nRow)
+            if (thePayments.searchText(nRow).contains(qstrFilter))
+                ++nScanMatches;
+        const qint64 nScanUs = timer.nsecsElapsed() / 1000;
+
+        if (nIndexMatches != nScanMatches)
+        {
+            qDebug() << QString("HandlerTest: filter \"%1\" matched %2 rows through the index, %3 by scanning.")
+                        .arg(qstrFilter).arg(nIndexMatches).arg(nScanMatches);
+            return false;
+        }
+
+        qDebug() << QString("HandlerTest: \"%1\": %2 of %3 rows, index %4 us, rebuilding the text %5 us.")
+                    .arg(qstrFilter).arg(nIndexMatches).arg(nRows).arg(nIndexUs).arg(nScanUs);
+
+        nIndexTotalUs += nIndexUs;
+        nScanTotalUs  += nScanUs;
+        nIndexMaxUs    = std::max(nIndexMaxUs, nIndexUs);
+        nScanMaxUs     = std::max(nScanMaxUs,  nScanUs);
+    }
+    // -----------------------------------
+    const int nKeystrokes = listKeystrokes.size();
+
+    qDebug() << QString("HandlerTest: %1 rows, index built in %2 ms. Per keystroke: index %3 us average, %4 us worst; "
+                        "rebuilding the text %5 us average, %6 us worst.")
+                .arg(nRows).arg(nBuildMs)
+                .arg(nIndexTotalUs / nKeystrokes).arg(nIndexMaxUs)
+                .arg(nScanTotalUs  / nKeystrokes).arg(nScanMaxUs);
+
+    return true;
+}
+
+//static
+bool HandlerTest::TestQueryPlans()
+{
+    // checkQueryPlans() logs each query that scans.
+    if (!DBHandler::getInstance()->checkQueryPlans())
+    {
+        qDebug() << "HandlerTest: a hot query isn't using its index.";
+        return false;
+    }
+
+    qDebug() << QString("HandlerTest: every hot query uses an index (schema version %1).")
+                .arg(DBHandler::getInstance()->schemaVersion());
+
+    return true;
+}
+
+//static
+bool HandlerTest::TestStatementCache(int nRows, int nRounds)
+{
+    DBHandler        * pDB      = DBHandler::getInstance();
+    MTContactHandler * pHandler = MTContactHandler::getInstance();
+
+    // A TEMP table belongs to this connection only, and goes away with it.
+    if (!pDB->runQuery("CREATE TEMP TABLE IF NOT EXISTS `handlertest_value` (`value_id` INTEGER PRIMARY KEY, `value_text` TEXT)") ||
+        !pDB->runQuery("DELETE FROM `handlertest_value`"))
+    {
+        qDebug() << "HandlerTest: couldn't create the temporary table.";
+        return false;
+    }
+
+    for (int nID = 1; nID <= nRows; ++nID)
+        pDB->runQuery("INSERT INTO `handlertest_value` (`value_id`) VALUES(?)", QVariantList() << nID);
+    // -----------------------------------
+    QElapsedTimer timer;
+    qint64 nCachedUs = 0, nUncachedUs = 0;
+    int    nMismatches = 0;
+
+    for (int nRound = 0; nRound < nRounds; ++nRound)
+    {
+        timer.start();
+        for (int nID = 1; nID <= nRows; ++nID)
+        {
+            const QString qstrValue = QString("cached %1 %2").arg(nRound).arg(nID);
+
+            pHandler->SetValueByID(nID, qstrValue, "value_text", "handlertest_value", "value_id");
+
+            if (pHandler->GetValueByID(nID, "value_text", "handlertest_value", "value_id") != qstrValue)
+                ++nMismatches;
+        }
+        nCachedUs += timer.nsecsElapsed() / 1000;
+
+        // What the same two calls did before: the values spliced into the SQL,
+        // so every call is parsed and planned again, and a read took two
+        // executions (one to see if there's a row, one to fetch it).
+        timer.start();
+        for (int nID = 1; nID <= nRows; ++nID)
+        {
+            const QString qstrValue = QString("uncached %1 %2").arg(nRound).arg(nID);
+
+            pDB->runQuery(QString("UPDATE `handlertest_value` SET `value_text`='%1' WHERE `value_id`=%2")
+                          .arg(MTContactHandler::Encode(qstrValue)).arg(nID));
+
+            const QString str_select = QString("SELECT `value_text` FROM `handlertest_value` WHERE `value_id`=%1 LIMIT 0,1").arg(nID);
+
+            QString qstrRead;
+            if (pDB->querySize(str_select) > 0)
+                qstrRead = MTContactHandler::Decode(pDB->queryString(str_select, 0, 0));
+
+            if (qstrRead != qstrValue)
+                ++nMismatches;
+        }
+        nUncachedUs += timer.nsecsElapsed() / 1000;
+    }
+
+    pDB->runQuery("DROP TABLE IF EXISTS temp.`handlertest_value`");
+    // -----------------------------------
+    const qint64 nCalls = 2LL * nRows * nRounds;
+
+    qDebug() << QString("HandlerTest: %1 GetValueByID/SetValueByID calls: cached %2 calls/s, uncached %3 calls/s.")
+                .arg(nCalls)
+                .arg((nCachedUs   > 0) ? (1000000 * nCalls / nCachedUs)   : nCalls)
+                .arg((nUncachedUs > 0) ? (1000000 * nCalls / nUncachedUs) : nCalls);
+
+    if (nMismatches > 0)
+    {
+        qDebug() << QString("HandlerTest: %1 values didn't read back as written.").arg(nMismatches);
+        return false;
+    }
+
+    return true;
+}
+
+//static
+bool HandlerTest::TestQueryExists(int nRows)
+{
+    DBHandler * pDB = DBHandler::getInstance();
+
+    if (!pDB->runQuery("CREATE TEMP TABLE IF NOT EXISTS `handlertest_exists` (`row_id` INTEGER PRIMARY KEY, `row_group` INTEGER)") ||
+        !pDB->runQuery("DELETE FROM `handlertest_exists`"))
+    {
+        qDebug() << "HandlerTest: couldn't create the temporary table.";
+        return false;
+    }
+
+    pDB->beginTransaction();
+    for (int nID = 1; nID <= nRows; ++nID)
+        pDB->runQuery("INSERT INTO `handlertest_exists` (`row_id`, `row_group`) VALUES(?, ?)", QVariantList() << nID << (nID % 10));
+    pDB->commitTransaction();
+    // -----------------------------------
+    // Every row, a tenth of them, a handful, and none. row_group has no index,
+    // so the filtered ones scan.
+    QStringList listSelects;
+    listSelects << "SELECT * FROM `handlertest_exists`"
+                << "SELECT * FROM `handlertest_exists` WHERE `row_group`=3"
+                << QString("SELECT * FROM `handlertest_exists` WHERE `row_group`=3 AND `row_id`>%1").arg(nRows - 50)
+                << "SELECT * FROM `handlertest_exists` WHERE `row_group`=42";
+
+    QElapsedTimer timer;
+    qint64 nSizeUs = 0, nExistsUs = 0;
+    qint64 nSizeSteps = 0, nExistsSteps = 0;
+    int    nMismatches = 0;
+
+    foreach (const QString & str_select, listSelects)
+    {
+        timer.start();
+        const int nSize = pDB->querySize(str_select);
+        nSizeUs += timer.nsecsElapsed() / 1000;
+
+        bool bFailed = false;
+        timer.start();
+        const bool bExists = pDB->queryExists(str_select, QVariantList(), &bFailed);
+        nExistsUs += timer.nsecsElapsed() / 1000;
+
+        if (bFailed || nSize < 0 || (nSize > 0) != bExists)
+        {
+            qDebug() << QString("HandlerTest: querySize gave %1 rows but queryExists gave %2%3: %4")
+                        .arg(nSize).arg(bExists ? "true" : "false").arg(bFailed ? " (failed)" : "").arg(str_select);
+            ++nMismatches;
+        }
+        // querySize() steps through every row it counts, so it also counts
+        // the rows the EXISTS wrapper hands back: one, whatever the SELECT.
+        nSizeSteps   += nSize;
+        nExistsSteps += pDB->querySize(QString("SELECT EXISTS(%1)").arg(str_select));
+    }
+    // -----------------------------------
+    // The same checks with bound values, which go through the statement cache.
+    const QString str_bound = "SELECT * FROM `handlertest_exists` WHERE `row_group`=?";
+
+    if (!pDB->queryExists(str_bound, QVariantList() << 3) || pDB->queryExists(str_bound, QVariantList() << 42))
+    {
+        qDebug() << "HandlerTest: queryExists with bound values gave the wrong answer.";
+        ++nMismatches;
+    }
+    // -----------------------------------
+    // An error must not look like a missing row.
+    bool bFailed = false;
+    const bool bExists = pDB->queryExists("SELECT * FROM `handlertest_no_such_table`", QVariantList(), &bFailed);
+
+    if (bExists || !bFailed)
+    {
+        qDebug() << "HandlerTest: queryExists didn't report a failed query.";
+        ++nMismatches;
+    }
+
+    pDB->runQuery("DROP TABLE IF EXISTS temp.`handlertest_exists`");
+    // -----------------------------------
+    qDebug() << QString("HandlerTest: %1 existence checks on %2 rows. Rows stepped: querySize %3, queryExists %4. "
+                        "Time: querySize %5 us, queryExists %6 us.")
+                .arg(listSelects.size()).arg(nRows)
+                .arg(nSizeSteps).arg(nExistsSteps)
+                .arg(nSizeUs).arg(nExistsUs);
+
+    if (nMismatches > 0)
+        return false;
+
+    if (nExistsSteps > listSelects.size())
+    {
+        qDebug() << "HandlerTest: queryExists stepped through more than one row per check.";
+        return false;
+    }
+
+    return true;
+}
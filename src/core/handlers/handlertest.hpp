@@ -0,0 +1,34 @@
+#ifndef HANDLERTEST_HPP
+#define HANDLERTEST_HPP
+
+// Tests and benchmarks for the core handlers, run from the bitcoin test window
+// along with BtcTest. Results go to the debug output.
+//
+class HandlerTest
+{
+public:
+    static bool TestHandlerFunctions();
+
+private:
+    // A synthetic payment table of this many rows, filtered the way the search
+    // box does it, one keystroke at a time: through MTSearchIndex, and by
+    // rebuilding every row's text like filterAcceptsRow used to. Fails unless
+    // both find the same rows.
+    static bool TestSearchIndex(int nRows);
+
+    // The live database's plans for the lookups the schema migrations indexed.
+    // Fails if any of them scans a whole table.
+    static bool TestQueryPlans();
+
+    // GetValueByID/SetValueByID on a temporary table of this many rows, through
+    // the statement cache, against the same statements built with arg() and run
+    // uncached the way they were before. Fails if the two disagree.
+    static bool TestStatementCache(int nRows, int nRounds);
+
+    // queryExists() on a temporary table of this many rows, against querySize()
+    // on the same SELECTs. Fails if they disagree, or if a failed query isn't
+    // reported as one. Also counts the rows each of them steps through.
+    static bool TestQueryExists(int nRows);
+};
+
+#endif // HANDLERTEST_HPP
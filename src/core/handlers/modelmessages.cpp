@@ -20,6 +20,7 @@
 #include <QtGlobal>
 #include <QDateTime>
 #include <Qt>
+#include <QStringList>
 
 // ------------------------------------------------------------
 
@@ -228,7 +229,8 @@ QVariant MessagesProxyModel::data ( const QModelIndex & index, int role/* = Qt::
             // Else if the method t
             QString qstrID = sourceData.isValid() ? sourceData.toString() : "";
             const std::string str_id = qstrID.toStdString();
-            const std::string str_name = str_id.empty() ? "" : opentxs::OTAPI_Wrap::It()->GetServer_Name(str_id);
+            MTNameLookupQT theLookup;
+            const std::string str_name = str_id.empty() ? "" : theLookup.GetServerName(str_id);
             // ------------------------
             if (!str_name.empty())
                 return QVariant(QString::fromStdString(str_name));
@@ -467,7 +469,6 @@ bool MessagesProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sour
     QModelIndex indexMethodType = sourceModel()->index(sourceRow, MSG_SOURCE_COL_METHOD_TYPE, sourceParent); // method_type
     QModelIndex indexNotary     = sourceModel()->index(sourceRow, MSG_SOURCE_COL_NOTARY_ID,   sourceParent); // notary_id
     QModelIndex indexFolder     = sourceModel()->index(sourceRow, MSG_SOURCE_COL_FOLDER,      sourceParent); // folder
-    QModelIndex indexSubject    = sourceModel()->index(sourceRow, MSG_SOURCE_COL_SUBJECT,     sourceParent); // subject
 
     QAbstractItemModel * pModel    = sourceModel();
     ModelMessages      * pMsgModel = dynamic_cast<ModelMessages*>(pModel);
@@ -481,6 +482,13 @@ bool MessagesProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sour
         if ((nFolder != -1)  && (nFolder != nFolder_))
             return false;
         // ------------------------------------
+        // Here we check the filterString (optional string the user can type.)
+        // The search text for each row, resolved names and all, is kept in the
+        // model's search index, so this is a lookup rather than a rebuild.
+        //
+        if (!filterString_.isEmpty() && !pMsgModel->searchIndex()->rowMatches(sourceRow, filterString_))
+            return false;
+        // ------------------------------------
         // Grab the data for the current row.
         //
         const QVariant dataMethodType       = pMsgModel->data(indexMethodType);
@@ -489,11 +497,6 @@ bool MessagesProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sour
         const QVariant dataSenderAddress    = pMsgModel->data(indexSenderAddr);
         const QVariant dataRecipientAddress = pMsgModel->data(indexRecipAddr);
         const QVariant dataNotaryID         = pMsgModel->data(indexNotary);
-        const QVariant dataSubject          = pMsgModel->data(indexSubject);
-
-//        const QVariant dataSenderName       = this->data(mapFromSource(indexSenderNym));
-//        const QVariant dataRecipientName    = this->data(mapFromSource(indexRecipNym));
-//        const QVariant dataNotaryName       = this->data(mapFromSource(indexNotary));
 
         const QString qstrMethodType       = dataMethodType.isValid() ? dataMethodType.toString() : "";
         const QString qstrSenderNym        = dataSenderNym.isValid() ? dataSenderNym.toString() : "";
@@ -502,36 +505,6 @@ bool MessagesProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sour
         const QString qstrRecipientAddress = dataRecipientAddress.isValid() ? dataRecipientAddress.toString() : "";
         const QString qstrNotaryID         = dataNotaryID.isValid() ? dataNotaryID.toString() : "";
         // ------------------------------------
-        // Here we check the filterString (optional string the user can type.)
-        //
-        if (!filterString_.isEmpty())
-        {
-            const QString qstrSubject = dataSubject.isValid() ? dataSubject.toString() : "";
-
-            const QString qstrNotaryName = qstrNotaryID.isEmpty() ? QString("") :
-                                           QString::fromStdString(opentxs::OTAPI_Wrap::It()->GetServer_Name(qstrNotaryID.toStdString()));
-            MTNameLookupQT theLookup;
-            QString qstrSenderName    = qstrSenderNym   .isEmpty() ? "" : QString::fromStdString(theLookup.GetNymName(qstrSenderNym   .toStdString(), ""));
-            QString qstrRecipientName = qstrRecipientNym.isEmpty() ? "" : QString::fromStdString(theLookup.GetNymName(qstrRecipientNym.toStdString(), ""));
-
-            if (qstrSenderName.isEmpty() && !qstrSenderAddress.isEmpty())
-                qstrSenderName = QString::fromStdString(theLookup.GetAddressName(qstrSenderAddress.toStdString()));
-            if (qstrRecipientName.isEmpty() && !qstrRecipientAddress.isEmpty())
-                qstrRecipientName = QString::fromStdString(theLookup.GetAddressName(qstrRecipientAddress.toStdString()));
-
-            if (!qstrSubject.contains(filterString_) &&
-                !qstrMethodType.contains(filterString_) &&
-                !qstrSenderNym.contains(filterString_) &&
-                !qstrRecipientNym.contains(filterString_) &&
-                !qstrSenderAddress.contains(filterString_) &&
-                !qstrRecipientAddress.contains(filterString_) &&
-                !qstrNotaryID.contains(filterString_) &&
-                !qstrSenderName.contains(filterString_) &&
-                !qstrRecipientName.contains(filterString_) &&
-                !qstrNotaryName.contains(filterString_) )
-                return false;
-        }
-        // ------------------------------------
         // Then check the other stuff:
         switch (filterType_)
         {
@@ -637,8 +610,55 @@ QVariant MessagesProxyModel::rawData ( const QModelIndex & index, int role/* = Q
 // ------------------------------------------------------------
 
 ModelMessages::ModelMessages(QObject * parent /*= 0*/, QSqlDatabase db /*=QSqlDatabase()*/)
-: QSqlTableModel(parent, db) {}
+: QSqlTableModel(parent, db)
+{
+    pSearchIndex_ = new MTSearchIndex(this, [this](int nSourceRow) { return searchText(nSourceRow); }, this);
+}
+
 
+// Everything the search box matches against for one row, joined by
+// MTSearchIndex::FieldSeparator. This used to be rebuilt inside
+// MessagesProxyModel::filterAcceptsRow for every row on every keystroke.
+//
+QString ModelMessages::searchText(int nSourceRow) const
+{
+    const QVariant dataMethodType       = data(index(nSourceRow, MSG_SOURCE_COL_METHOD_TYPE));
+    const QVariant dataSenderNym        = data(index(nSourceRow, MSG_SOURCE_COL_SENDER_NYM));
+    const QVariant dataRecipientNym     = data(index(nSourceRow, MSG_SOURCE_COL_RECIP_NYM));
+    const QVariant dataSenderAddress    = data(index(nSourceRow, MSG_SOURCE_COL_SENDER_ADDR));
+    const QVariant dataRecipientAddress = data(index(nSourceRow, MSG_SOURCE_COL_RECIP_ADDR));
+    const QVariant dataNotaryID         = data(index(nSourceRow, MSG_SOURCE_COL_NOTARY_ID));
+    const QVariant dataSubject          = data(index(nSourceRow, MSG_SOURCE_COL_SUBJECT));
+
+    const QString qstrMethodType       = dataMethodType.isValid() ? dataMethodType.toString() : "";
+    const QString qstrSenderNym        = dataSenderNym.isValid() ? dataSenderNym.toString() : "";
+    const QString qstrRecipientNym     = dataRecipientNym.isValid() ? dataRecipientNym.toString() : "";
+    const QString qstrSenderAddress    = dataSenderAddress.isValid() ? dataSenderAddress.toString() : "";
+    const QString qstrRecipientAddress = dataRecipientAddress.isValid() ? dataRecipientAddress.toString() : "";
+    const QString qstrNotaryID         = dataNotaryID.isValid() ? dataNotaryID.toString() : "";
+    const QString qstrSubject          = dataSubject.isValid() ? dataSubject.toString() : "";
+    // ------------------------------------
+    MTNameLookupQT theLookup;
+
+    const QString qstrNotaryName = qstrNotaryID.isEmpty() ? QString("") :
+                                   QString::fromStdString(theLookup.GetServerName(qstrNotaryID.toStdString()));
+
+    QString qstrSenderName    = qstrSenderNym   .isEmpty() ? "" : QString::fromStdString(theLookup.GetNymName(qstrSenderNym   .toStdString(), ""));
+    QString qstrRecipientName = qstrRecipientNym.isEmpty() ? "" : QString::fromStdString(theLookup.GetNymName(qstrRecipientNym.toStdString(), ""));
+
+    if (qstrSenderName.isEmpty() && !qstrSenderAddress.isEmpty())
+        qstrSenderName = QString::fromStdString(theLookup.GetAddressName(qstrSenderAddress.toStdString()));
+    if (qstrRecipientName.isEmpty() && !qstrRecipientAddress.isEmpty())
+        qstrRecipientName = QString::fromStdString(theLookup.GetAddressName(qstrRecipientAddress.toStdString()));
+    // ------------------------------------
+    QStringList listFields;
+
+    listFields << qstrSubject << qstrMethodType << qstrSenderNym << qstrRecipientNym
+               << qstrSenderAddress << qstrRecipientAddress << qstrNotaryID
+               << qstrSenderName << qstrRecipientName << qstrNotaryName;
+
+    return listFields.join(MTSearchIndex::FieldSeparator);
+}
 
 // I'm overriding this so I can return the ACTUAL row or column back (depending on orientation) from the source
 // model. This way, the proxy model can call this to find out the actual column or row, whenever it needs to.
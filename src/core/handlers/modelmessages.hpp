@@ -2,6 +2,7 @@
 #define MODELMESSAGES_H
 
 #include <core/handlers/contacthandler.hpp>
+#include <core/handlers/searchindex.hpp>
 
 #include <QSqlDatabase>
 #include <QSqlTableModel>
@@ -41,12 +42,19 @@ public:
 
     bool setData(const QModelIndex & index, const QVariant & value, int role = Qt::EditRole);
 
+    // The proxy's filter string is matched against this, one entry per source row.
+    MTSearchIndex * searchIndex() const { return pSearchIndex_; }
+    QString searchText(int nSourceRow) const;
+
 //    void updateDBFromOT();
 //    void updateDBFromOT(const std::string & strNotaryID, const std::string & strNymID);
 
 signals:
 
 public slots:
+
+private:
+    MTSearchIndex * pSearchIndex_=nullptr;
 };
 
 
@@ -24,6 +24,7 @@
 #include <QLabel>
 #include <QHBoxLayout>
 #include <QTableView>
+#include <QStringList>
 
 
 // ------------------------------------------------------------
@@ -456,7 +457,8 @@ QVariant AccountRecordsProxyModel::data ( const QModelIndex & index, int role/*
         {
             QString qstrID = sourceData.isValid() ? sourceData.toString() : "";
             const std::string str_id = qstrID.toStdString();
-            const std::string str_name = str_id.empty() ? "" : opentxs::OTAPI_Wrap::It()->GetServer_Name(str_id);
+            MTNameLookupQT theLookup;
+            const std::string str_name = str_id.empty() ? "" : theLookup.GetServerName(str_id);
             // ------------------------
             if (!str_name.empty())
                 return QVariant(QString::fromStdString(str_name));
@@ -493,7 +495,8 @@ QVariant AccountRecordsProxyModel::data ( const QModelIndex & index, int role/*
         {
             QString qstrID = sourceData.isValid() ? sourceData.toString() : "";
             const std::string str_id = qstrID.toStdString();
-            const std::string str_name = str_id.empty() ? "" : opentxs::OTAPI_Wrap::It()->GetAssetType_Name(str_id);
+            MTNameLookupQT theLookup;
+            const std::string str_name = str_id.empty() ? "" : theLookup.GetAssetName(str_id);
             // ------------------------
             if (!str_name.empty())
                 return QVariant(QString::fromStdString(str_name));
@@ -721,22 +724,8 @@ bool AccountRecordsProxyModel::filterAcceptsColumn(int source_column, const QMod
 //
 bool AccountRecordsProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
 {
-    QModelIndex indexTxnId        = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_TXN_ID,         sourceParent); // txn_id
-    QModelIndex indexTxnIdDisplay = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_TXN_ID_DISPLAY, sourceParent); // txn_id_display
-    QModelIndex indexMyNym        = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_MY_NYM,         sourceParent); // my_nym_id
     QModelIndex indexMyAcct       = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_MY_ACCT,        sourceParent); // my_acct_id
-    QModelIndex indexAssetType    = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_MY_ASSET_TYPE,  sourceParent); // my_asset_type_id
-    QModelIndex indexSenderNym    = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_SENDER_NYM,     sourceParent); // sender_nym_id
-    QModelIndex indexSenderAcct   = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_SENDER_ACCT,    sourceParent); // sender_acct_id
-    QModelIndex indexSenderAddr   = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_SENDER_ADDR,    sourceParent); // sender_address
-    QModelIndex indexRecipNym     = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_RECIP_NYM,      sourceParent); // recipient_nym_id
-    QModelIndex indexRecipAcct    = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_RECIP_ACCT,     sourceParent); // recipient_acct_id
-    QModelIndex indexRecipAddr    = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_RECIP_ADDR,     sourceParent); // recipient_address
-    QModelIndex indexMethodType   = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_METHOD_TYPE,    sourceParent); // method_type
-    QModelIndex indexNotary       = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_NOTARY_ID,      sourceParent); // notary_id
     QModelIndex indexFolder       = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_FOLDER,         sourceParent); // folder
-    QModelIndex indexMemo         = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_MEMO,           sourceParent); // memo
-    QModelIndex indexDescription  = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_DESCRIPTION,    sourceParent); // description
 
     QAbstractItemModel * pModel    = sourceModel();
     ModelPayments      * pMsgModel = dynamic_cast<ModelPayments*>(pModel);
@@ -757,41 +746,8 @@ bool AccountRecordsProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex
         // ------------------------------------
         // Grab the data for the current row.
         //
-        const QVariant dataTxnId            = pMsgModel->data(indexTxnId);
-        const QVariant dataTxnIdDisplay     = pMsgModel->data(indexTxnIdDisplay);
-        const QVariant dataMyNym            = pMsgModel->data(indexMyNym);
-        const QVariant dataMyAcct           = pMsgModel->data(indexMyAcct);
-        const QVariant dataAssetType        = pMsgModel->data(indexAssetType);
-        const QVariant dataMethodType       = pMsgModel->data(indexMethodType);
-        const QVariant dataSenderNym        = pMsgModel->data(indexSenderNym);
-        const QVariant dataRecipientNym     = pMsgModel->data(indexRecipNym);
-        const QVariant dataSenderAcct       = pMsgModel->data(indexSenderAcct);
-        const QVariant dataRecipientAcct    = pMsgModel->data(indexRecipAcct);
-        const QVariant dataSenderAddress    = pMsgModel->data(indexSenderAddr);
-        const QVariant dataRecipientAddress = pMsgModel->data(indexRecipAddr);
-        const QVariant dataNotaryID         = pMsgModel->data(indexNotary);
-        const QVariant dataMemo             = pMsgModel->data(indexMemo);
-        const QVariant dataDescription      = pMsgModel->data(indexDescription);
-
-//        const QVariant dataSenderName       = this->data(mapFromSource(indexSenderNym));
-//        const QVariant dataRecipientName    = this->data(mapFromSource(indexRecipNym));
-//        const QVariant dataNotaryName       = this->data(mapFromSource(indexNotary));
-
-        const int64_t lTxnId               = dataTxnId.isValid() ? dataTxnId.toLongLong() : 0;
-        const int64_t lTxnIdDisplay        = dataTxnIdDisplay.isValid() ? dataTxnIdDisplay.toLongLong() : 0;
-        const QString qstrTxnId            = lTxnId        > 0 ? QString::fromStdString(opentxs::OTAPI_Wrap::It()->LongToString(lTxnId       )) : "";
-        const QString qstrTxnIdDisplay     = lTxnIdDisplay > 0 ? QString::fromStdString(opentxs::OTAPI_Wrap::It()->LongToString(lTxnIdDisplay)) : "";
-        const QString qstrMyNym            = dataMyNym.isValid() ? dataMyNym.toString() : "";
-        const QString qstrMyAcct           = dataMyAcct.isValid() ? dataMyAcct.toString() : "";
-        const QString qstrAssetType        = dataAssetType.isValid() ? dataAssetType.toString() : "";
-        const QString qstrMethodType       = dataMethodType.isValid() ? dataMethodType.toString() : "";
-        const QString qstrSenderNym        = dataSenderNym.isValid() ? dataSenderNym.toString() : "";
-        const QString qstrRecipientNym     = dataRecipientNym.isValid() ? dataRecipientNym.toString() : "";
-        const QString qstrSenderAcct       = dataSenderAcct.isValid() ? dataSenderAcct.toString() : "";
-        const QString qstrRecipientAcct    = dataRecipientAcct.isValid() ? dataRecipientAcct.toString() : "";
-        const QString qstrSenderAddress    = dataSenderAddress.isValid() ? dataSenderAddress.toString() : "";
-        const QString qstrRecipientAddress = dataRecipientAddress.isValid() ? dataRecipientAddress.toString() : "";
-        const QString qstrNotaryID         = dataNotaryID.isValid() ? dataNotaryID.toString() : "";
+        const QVariant dataMyAcct = pMsgModel->data(indexMyAcct);
+        const QString  qstrMyAcct = dataMyAcct.isValid() ? dataMyAcct.toString() : "";
         // ------------------------------------
         // Here we check filterAccount_, which is for the account details screen.
         // So we want to filter for records that match filterAccount_ to qstrMyAcct.
@@ -799,61 +755,10 @@ bool AccountRecordsProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex
             return false;
         // ------------------------------------
         // Here we check the filterString (optional string the user can type.)
+        // Same fields as PaymentsProxyModel, so it shares the model's search index.
         //
-        if (!filterString_.isEmpty())
-        {
-            const QString qstrMemo        = dataMemo       .isValid() ? dataMemo       .toString() : "";
-            const QString qstrDescription = dataDescription.isValid() ? dataDescription.toString() : "";
-
-            const QString qstrNotaryName = qstrNotaryID.isEmpty() ? QString("") :
-                                           QString::fromStdString(opentxs::OTAPI_Wrap::It()->GetServer_Name(qstrNotaryID.toStdString()));
-
-            const QString qstrMyAcctName = qstrMyAcct.isEmpty() ? QString("") :
-                                           QString::fromStdString(opentxs::OTAPI_Wrap::It()->GetAccountWallet_Name(qstrMyAcct.toStdString()));
-            const QString qstrAssetName = qstrAssetType.isEmpty() ? QString("") :
-                                           QString::fromStdString(opentxs::OTAPI_Wrap::It()->GetAssetType_Name(qstrAssetType.toStdString()));
-
-            MTNameLookupQT theLookup;
-            QString qstrMyName        = qstrMyNym       .isEmpty() ? "" : QString::fromStdString(theLookup.GetNymName(qstrMyNym       .toStdString(), ""));
-            QString qstrSenderName    = qstrSenderNym   .isEmpty() ? "" : QString::fromStdString(theLookup.GetNymName(qstrSenderNym   .toStdString(), ""));
-            QString qstrRecipientName = qstrRecipientNym.isEmpty() ? "" : QString::fromStdString(theLookup.GetNymName(qstrRecipientNym.toStdString(), ""));
-
-            if (qstrSenderName.isEmpty() && !qstrSenderAddress.isEmpty())
-                qstrSenderName = QString::fromStdString(theLookup.GetAddressName(qstrSenderAddress.toStdString()));
-            if (qstrRecipientName.isEmpty() && !qstrRecipientAddress.isEmpty())
-                qstrRecipientName = QString::fromStdString(theLookup.GetAddressName(qstrRecipientAddress.toStdString()));
-
-            if (qstrSenderName.isEmpty() && !qstrSenderAcct.isEmpty())
-                qstrSenderName = QString::fromStdString(theLookup.GetAcctName(qstrSenderAcct.toStdString(), "", "", ""));
-            if (qstrRecipientName.isEmpty() && !qstrRecipientAcct.isEmpty())
-                qstrRecipientName = QString::fromStdString(theLookup.GetAcctName(qstrRecipientAcct.toStdString(), "", "", ""));
-
-            if (qstrMyName.isEmpty() && !qstrMyAcctName.isEmpty())
-                qstrMyName = qstrMyAcctName;
-
-            if (!qstrTxnId.contains(filterString_) &&
-                !qstrTxnIdDisplay.contains(filterString_) &&
-                !qstrMemo.contains(filterString_) &&
-                !qstrDescription.contains(filterString_) &&
-                !qstrMethodType.contains(filterString_) &&
-                !qstrMyNym.contains(filterString_) &&
-                !qstrSenderNym.contains(filterString_) &&
-                !qstrRecipientNym.contains(filterString_) &&
-                !qstrMyAcct.contains(filterString_) &&
-                !qstrSenderAcct.contains(filterString_) &&
-                !qstrRecipientAcct.contains(filterString_) &&
-                !qstrSenderAddress.contains(filterString_) &&
-                !qstrRecipientAddress.contains(filterString_) &&
-                !qstrAssetType.contains(filterString_) &&
-                !qstrNotaryID.contains(filterString_) &&
-                !qstrMyName.contains(filterString_) &&
-                !qstrMyAcctName.contains(filterString_) &&
-                !qstrSenderName.contains(filterString_) &&
-                !qstrRecipientName.contains(filterString_) &&
-                !qstrAssetName.contains(filterString_) &&
-                !qstrNotaryName.contains(filterString_) )
-                return false;
-        }
+        if (!filterString_.isEmpty() && !pMsgModel->searchIndex()->rowMatches(sourceRow, filterString_))
+            return false;
     }
 
     return true;
@@ -1329,7 +1234,8 @@ QVariant PaymentsProxyModel::data ( const QModelIndex & index, int role/* = Qt::
         {
             QString qstrID = sourceData.isValid() ? sourceData.toString() : "";
             const std::string str_id = qstrID.toStdString();
-            const std::string str_name = str_id.empty() ? "" : opentxs::OTAPI_Wrap::It()->GetServer_Name(str_id);
+            MTNameLookupQT theLookup;
+            const std::string str_name = str_id.empty() ? "" : theLookup.GetServerName(str_id);
             // ------------------------
             if (!str_name.empty())
                 return QVariant(QString::fromStdString(str_name));
@@ -1366,7 +1272,8 @@ QVariant PaymentsProxyModel::data ( const QModelIndex & index, int role/* = Qt::
         {
             QString qstrID = sourceData.isValid() ? sourceData.toString() : "";
             const std::string str_id = qstrID.toStdString();
-            const std::string str_name = str_id.empty() ? "" : opentxs::OTAPI_Wrap::It()->GetAssetType_Name(str_id);
+            MTNameLookupQT theLookup;
+            const std::string str_name = str_id.empty() ? "" : theLookup.GetAssetName(str_id);
             // ------------------------
             if (!str_name.empty())
                 return QVariant(QString::fromStdString(str_name));
@@ -1627,22 +1534,13 @@ bool PaymentsProxyModel::filterAcceptsColumn(int source_column, const QModelInde
 //
 bool PaymentsProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
 {
-    QModelIndex indexTxnId        = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_TXN_ID,         sourceParent); // txn_id
-    QModelIndex indexTxnIdDisplay = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_TXN_ID_DISPLAY, sourceParent); // txn_id_display
-    QModelIndex indexMyNym        = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_MY_NYM,         sourceParent); // my_nym_id
-    QModelIndex indexMyAcct       = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_MY_ACCT,        sourceParent); // my_acct_id
-    QModelIndex indexAssetType    = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_MY_ASSET_TYPE,  sourceParent); // my_asset_type_id
     QModelIndex indexSenderNym    = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_SENDER_NYM,     sourceParent); // sender_nym_id
-    QModelIndex indexSenderAcct   = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_SENDER_ACCT,    sourceParent); // sender_acct_id
     QModelIndex indexSenderAddr   = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_SENDER_ADDR,    sourceParent); // sender_address
     QModelIndex indexRecipNym     = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_RECIP_NYM,      sourceParent); // recipient_nym_id
-    QModelIndex indexRecipAcct    = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_RECIP_ACCT,     sourceParent); // recipient_acct_id
     QModelIndex indexRecipAddr    = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_RECIP_ADDR,     sourceParent); // recipient_address
     QModelIndex indexMethodType   = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_METHOD_TYPE,    sourceParent); // method_type
     QModelIndex indexNotary       = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_NOTARY_ID,      sourceParent); // notary_id
     QModelIndex indexFolder       = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_FOLDER,         sourceParent); // folder
-    QModelIndex indexMemo         = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_MEMO,           sourceParent); // memo
-    QModelIndex indexDescription  = sourceModel()->index(sourceRow, PMNT_SOURCE_COL_DESCRIPTION,    sourceParent); // description
 
     QAbstractItemModel * pModel    = sourceModel();
     ModelPayments      * pMsgModel = dynamic_cast<ModelPayments*>(pModel);
@@ -1656,101 +1554,29 @@ bool PaymentsProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sour
         if ((nFolder != -1)  && (nFolder != nFolder_))
             return false;
         // ------------------------------------
+        // Here we check the filterString (optional string the user can type.)
+        // The search text for each row, resolved names and all, is kept in the
+        // model's search index, so this is a lookup rather than a rebuild.
+        //
+        if (!filterString_.isEmpty() && !pMsgModel->searchIndex()->rowMatches(sourceRow, filterString_))
+            return false;
+        // ------------------------------------
         // Grab the data for the current row.
         //
-        const QVariant dataTxnId            = pMsgModel->data(indexTxnId);
-        const QVariant dataTxnIdDisplay     = pMsgModel->data(indexTxnIdDisplay);
-        const QVariant dataMyNym            = pMsgModel->data(indexMyNym);
-        const QVariant dataMyAcct           = pMsgModel->data(indexMyAcct);
-        const QVariant dataAssetType        = pMsgModel->data(indexAssetType);
         const QVariant dataMethodType       = pMsgModel->data(indexMethodType);
         const QVariant dataSenderNym        = pMsgModel->data(indexSenderNym);
         const QVariant dataRecipientNym     = pMsgModel->data(indexRecipNym);
-        const QVariant dataSenderAcct       = pMsgModel->data(indexSenderAcct);
-        const QVariant dataRecipientAcct    = pMsgModel->data(indexRecipAcct);
         const QVariant dataSenderAddress    = pMsgModel->data(indexSenderAddr);
         const QVariant dataRecipientAddress = pMsgModel->data(indexRecipAddr);
         const QVariant dataNotaryID         = pMsgModel->data(indexNotary);
-        const QVariant dataMemo             = pMsgModel->data(indexMemo);
-        const QVariant dataDescription      = pMsgModel->data(indexDescription);
-
-//        const QVariant dataSenderName       = this->data(mapFromSource(indexSenderNym));
-//        const QVariant dataRecipientName    = this->data(mapFromSource(indexRecipNym));
-//        const QVariant dataNotaryName       = this->data(mapFromSource(indexNotary));
-
-        const int64_t lTxnId               = dataTxnId.isValid() ? dataTxnId.toLongLong() : 0;
-        const int64_t lTxnIdDisplay        = dataTxnIdDisplay.isValid() ? dataTxnIdDisplay.toLongLong() : 0;
-        const QString qstrTxnId            = lTxnId        > 0 ? QString::fromStdString(opentxs::OTAPI_Wrap::It()->LongToString(lTxnId       )) : "";
-        const QString qstrTxnIdDisplay     = lTxnIdDisplay > 0 ? QString::fromStdString(opentxs::OTAPI_Wrap::It()->LongToString(lTxnIdDisplay)) : "";
-        const QString qstrMyNym            = dataMyNym.isValid() ? dataMyNym.toString() : "";
-        const QString qstrMyAcct           = dataMyAcct.isValid() ? dataMyAcct.toString() : "";
-        const QString qstrAssetType        = dataAssetType.isValid() ? dataAssetType.toString() : "";
+
         const QString qstrMethodType       = dataMethodType.isValid() ? dataMethodType.toString() : "";
         const QString qstrSenderNym        = dataSenderNym.isValid() ? dataSenderNym.toString() : "";
         const QString qstrRecipientNym     = dataRecipientNym.isValid() ? dataRecipientNym.toString() : "";
-        const QString qstrSenderAcct       = dataSenderAcct.isValid() ? dataSenderAcct.toString() : "";
-        const QString qstrRecipientAcct    = dataRecipientAcct.isValid() ? dataRecipientAcct.toString() : "";
         const QString qstrSenderAddress    = dataSenderAddress.isValid() ? dataSenderAddress.toString() : "";
         const QString qstrRecipientAddress = dataRecipientAddress.isValid() ? dataRecipientAddress.toString() : "";
         const QString qstrNotaryID         = dataNotaryID.isValid() ? dataNotaryID.toString() : "";
         // ------------------------------------
-        // Here we check the filterString (optional string the user can type.)
-        //
-        if (!filterString_.isEmpty())
-        {
-            const QString qstrMemo        = dataMemo       .isValid() ? dataMemo       .toString() : "";
-            const QString qstrDescription = dataDescription.isValid() ? dataDescription.toString() : "";
-
-            const QString qstrNotaryName = qstrNotaryID.isEmpty() ? QString("") :
-                                           QString::fromStdString(opentxs::OTAPI_Wrap::It()->GetServer_Name(qstrNotaryID.toStdString()));
-
-            const QString qstrMyAcctName = qstrMyAcct.isEmpty() ? QString("") :
-                                           QString::fromStdString(opentxs::OTAPI_Wrap::It()->GetAccountWallet_Name(qstrMyAcct.toStdString()));
-            const QString qstrAssetName = qstrAssetType.isEmpty() ? QString("") :
-                                           QString::fromStdString(opentxs::OTAPI_Wrap::It()->GetAssetType_Name(qstrAssetType.toStdString()));
-
-            MTNameLookupQT theLookup;
-            QString qstrMyName        = qstrMyNym       .isEmpty() ? "" : QString::fromStdString(theLookup.GetNymName(qstrMyNym       .toStdString(), ""));
-            QString qstrSenderName    = qstrSenderNym   .isEmpty() ? "" : QString::fromStdString(theLookup.GetNymName(qstrSenderNym   .toStdString(), ""));
-            QString qstrRecipientName = qstrRecipientNym.isEmpty() ? "" : QString::fromStdString(theLookup.GetNymName(qstrRecipientNym.toStdString(), ""));
-
-            if (qstrSenderName.isEmpty() && !qstrSenderAddress.isEmpty())
-                qstrSenderName = QString::fromStdString(theLookup.GetAddressName(qstrSenderAddress.toStdString()));
-            if (qstrRecipientName.isEmpty() && !qstrRecipientAddress.isEmpty())
-                qstrRecipientName = QString::fromStdString(theLookup.GetAddressName(qstrRecipientAddress.toStdString()));
-
-            if (qstrSenderName.isEmpty() && !qstrSenderAcct.isEmpty())
-                qstrSenderName = QString::fromStdString(theLookup.GetAcctName(qstrSenderAcct.toStdString(), "", "", ""));
-            if (qstrRecipientName.isEmpty() && !qstrRecipientAcct.isEmpty())
-                qstrRecipientName = QString::fromStdString(theLookup.GetAcctName(qstrRecipientAcct.toStdString(), "", "", ""));
-
-            if (qstrMyName.isEmpty() && !qstrMyAcctName.isEmpty())
-                qstrMyName = qstrMyAcctName;
-
-            if (!qstrTxnId.contains(filterString_) &&
-                !qstrTxnIdDisplay.contains(filterString_) &&
-                !qstrMemo.contains(filterString_) &&
-                !qstrDescription.contains(filterString_) &&
-                !qstrMethodType.contains(filterString_) &&
-                !qstrMyNym.contains(filterString_) &&
-                !qstrSenderNym.contains(filterString_) &&
-                !qstrRecipientNym.contains(filterString_) &&
-                !qstrMyAcct.contains(filterString_) &&
-                !qstrSenderAcct.contains(filterString_) &&
-                !qstrRecipientAcct.contains(filterString_) &&
-                !qstrSenderAddress.contains(filterString_) &&
-                !qstrRecipientAddress.contains(filterString_) &&
-                !qstrAssetType.contains(filterString_) &&
-                !qstrNotaryID.contains(filterString_) &&
-                !qstrMyName.contains(filterString_) &&
-                !qstrMyAcctName.contains(filterString_) &&
-                !qstrSenderName.contains(filterString_) &&
-                !qstrRecipientName.contains(filterString_) &&
-                !qstrAssetName.contains(filterString_) &&
-                !qstrNotaryName.contains(filterString_) )
-                return false;
-        }
-        // ------------------------------------
         // Then check the other stuff:
         switch (filterType_)
         {
@@ -1856,7 +1682,90 @@ QVariant PaymentsProxyModel::rawData ( const QModelIndex & index, int role/* = Q
 // ------------------------------------------------------------
 
 ModelPayments::ModelPayments(QObject * parent /*= 0*/, QSqlDatabase db /*=QSqlDatabase()*/)
-: QSqlTableModel(parent, db) {}
+: QSqlTableModel(parent, db)
+{
+    pSearchIndex_ = new MTSearchIndex(this, [this](int nSourceRow) { return searchText(nSourceRow); }, this);
+}
+
+
+// Everything the search box matches against for one row, joined by
+// MTSearchIndex::FieldSeparator. This used to be rebuilt inside
+// PaymentsProxyModel::filterAcceptsRow for every row on every keystroke.
+//
+QString ModelPayments::searchText(int nSourceRow) const
+{
+    const QVariant dataTxnId            = data(index(nSourceRow, PMNT_SOURCE_COL_TXN_ID));
+    const QVariant dataTxnIdDisplay     = data(index(nSourceRow, PMNT_SOURCE_COL_TXN_ID_DISPLAY));
+    const QVariant dataMyNym            = data(index(nSourceRow, PMNT_SOURCE_COL_MY_NYM));
+    const QVariant dataMyAcct           = data(index(nSourceRow, PMNT_SOURCE_COL_MY_ACCT));
+    const QVariant dataAssetType        = data(index(nSourceRow, PMNT_SOURCE_COL_MY_ASSET_TYPE));
+    const QVariant dataMethodType       = data(index(nSourceRow, PMNT_SOURCE_COL_METHOD_TYPE));
+    const QVariant dataSenderNym        = data(index(nSourceRow, PMNT_SOURCE_COL_SENDER_NYM));
+    const QVariant dataRecipientNym     = data(index(nSourceRow, PMNT_SOURCE_COL_RECIP_NYM));
+    const QVariant dataSenderAcct       = data(index(nSourceRow, PMNT_SOURCE_COL_SENDER_ACCT));
+    const QVariant dataRecipientAcct    = data(index(nSourceRow, PMNT_SOURCE_COL_RECIP_ACCT));
+    const QVariant dataSenderAddress    = data(index(nSourceRow, PMNT_SOURCE_COL_SENDER_ADDR));
+    const QVariant dataRecipientAddress = data(index(nSourceRow, PMNT_SOURCE_COL_RECIP_ADDR));
+    const QVariant dataNotaryID         = data(index(nSourceRow, PMNT_SOURCE_COL_NOTARY_ID));
+    const QVariant dataMemo             = data(index(nSourceRow, PMNT_SOURCE_COL_MEMO));
+    const QVariant dataDescription      = data(index(nSourceRow, PMNT_SOURCE_COL_DESCRIPTION));
+
+    const int64_t lTxnId               = dataTxnId.isValid() ? dataTxnId.toLongLong() : 0;
+    const int64_t lTxnIdDisplay        = dataTxnIdDisplay.isValid() ? dataTxnIdDisplay.toLongLong() : 0;
+    const QString qstrTxnId            = lTxnId        > 0 ? QString::fromStdString(opentxs::OTAPI_Wrap::It()->LongToString(lTxnId       )) : "";
+    const QString qstrTxnIdDisplay     = lTxnIdDisplay > 0 ? QString::fromStdString(opentxs::OTAPI_Wrap::It()->LongToString(lTxnIdDisplay)) : "";
+    const QString qstrMyNym            = dataMyNym.isValid() ? dataMyNym.toString() : "";
+    const QString qstrMyAcct           = dataMyAcct.isValid() ? dataMyAcct.toString() : "";
+    const QString qstrAssetType        = dataAssetType.isValid() ? dataAssetType.toString() : "";
+    const QString qstrMethodType       = dataMethodType.isValid() ? dataMethodType.toString() : "";
+    const QString qstrSenderNym        = dataSenderNym.isValid() ? dataSenderNym.toString() : "";
+    const QString qstrRecipientNym     = dataRecipientNym.isValid() ? dataRecipientNym.toString() : "";
+    const QString qstrSenderAcct       = dataSenderAcct.isValid() ? dataSenderAcct.toString() : "";
+    const QString qstrRecipientAcct    = dataRecipientAcct.isValid() ? dataRecipientAcct.toString() : "";
+    const QString qstrSenderAddress    = dataSenderAddress.isValid() ? dataSenderAddress.toString() : "";
+    const QString qstrRecipientAddress = dataRecipientAddress.isValid() ? dataRecipientAddress.toString() : "";
+    const QString qstrNotaryID         = dataNotaryID.isValid() ? dataNotaryID.toString() : "";
+    const QString qstrMemo             = dataMemo       .isValid() ? dataMemo       .toString() : "";
+    const QString qstrDescription      = dataDescription.isValid() ? dataDescription.toString() : "";
+    // ------------------------------------
+    MTNameLookupQT theLookup;
+
+    const QString qstrNotaryName = qstrNotaryID.isEmpty() ? QString("") :
+                                   QString::fromStdString(theLookup.GetServerName(qstrNotaryID.toStdString()));
+
+    const QString qstrMyAcctName = qstrMyAcct.isEmpty() ? QString("") :
+                                   QString::fromStdString(opentxs::OTAPI_Wrap::It()->GetAccountWallet_Name(qstrMyAcct.toStdString()));
+    const QString qstrAssetName = qstrAssetType.isEmpty() ? QString("") :
+                                   QString::fromStdString(theLookup.GetAssetName(qstrAssetType.toStdString()));
+
+    QString qstrMyName        = qstrMyNym       .isEmpty() ? "" : QString::fromStdString(theLookup.GetNymName(qstrMyNym       .toStdString(), ""));
+    QString qstrSenderName    = qstrSenderNym   .isEmpty() ? "" : QString::fromStdString(theLookup.GetNymName(qstrSenderNym   .toStdString(), ""));
+    QString qstrRecipientName = qstrRecipientNym.isEmpty() ? "" : QString::fromStdString(theLookup.GetNymName(qstrRecipientNym.toStdString(), ""));
+
+    if (qstrSenderName.isEmpty() && !qstrSenderAddress.isEmpty())
+        qstrSenderName = QString::fromStdString(theLookup.GetAddressName(qstrSenderAddress.toStdString()));
+    if (qstrRecipientName.isEmpty() && !qstrRecipientAddress.isEmpty())
+        qstrRecipientName = QString::fromStdString(theLookup.GetAddressName(qstrRecipientAddress.toStdString()));
+
+    if (qstrSenderName.isEmpty() && !qstrSenderAcct.isEmpty())
+        qstrSenderName = QString::fromStdString(theLookup.GetAcctName(qstrSenderAcct.toStdString(), "", "", ""));
+    if (qstrRecipientName.isEmpty() && !qstrRecipientAcct.isEmpty())
+        qstrRecipientName = QString::fromStdString(theLookup.GetAcctName(qstrRecipientAcct.toStdString(), "", "", ""));
+
+    if (qstrMyName.isEmpty() && !qstrMyAcctName.isEmpty())
+        qstrMyName = qstrMyAcctName;
+    // ------------------------------------
+    QStringList listFields;
+
+    listFields << qstrTxnId << qstrTxnIdDisplay << qstrMemo << qstrDescription << qstrMethodType
+               << qstrMyNym << qstrSenderNym << qstrRecipientNym
+               << qstrMyAcct << qstrSenderAcct << qstrRecipientAcct
+               << qstrSenderAddress << qstrRecipientAddress << qstrAssetType << qstrNotaryID
+               << qstrMyName << qstrMyAcctName << qstrSenderName << qstrRecipientName
+               << qstrAssetName << qstrNotaryName;
+
+    return listFields.join(MTSearchIndex::FieldSeparator);
+}
 
 
 // I'm overriding this so I can return the ACTUAL row or column back (depending on orientation) from the source
@@ -2,6 +2,7 @@
 #define MODELPAYMENTS_H
 
 #include <core/handlers/contacthandler.hpp>
+#include <core/handlers/searchindex.hpp>
 
 #include <QSqlDatabase>
 #include <QSqlTableModel>
@@ -101,12 +102,19 @@ You can then use the MyClass::Options type to store combinations of MyClass::Opt
 
     bool setData(const QModelIndex & index, const QVariant & value, int role = Qt::EditRole);
 
+    // The proxies' filter string is matched against this, one entry per source row.
+    MTSearchIndex * searchIndex() const { return pSearchIndex_; }
+    QString searchText(int nSourceRow) const;
+
 //    void updateDBFromOT();
 //    void updateDBFromOT(const std::string & strNotaryID, const std::string & strNymID);
 
 signals:
 
 public slots:
+
+private:
+    MTSearchIndex * pSearchIndex_=nullptr;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(ModelPayments::PaymentFlags)
@@ -22,40 +22,6 @@
 #include <QDateTime>
 #include <Qt>
 
-FinalReceiptProxyModel::FinalReceiptProxyModel(QObject *parent /*= 0*/)
-: QSortFilterProxyModel(parent)
-{
-}
-
-void FinalReceiptProxyModel::setFilterOpentxsRecord(opentxs::OTRecord& recordmt)
-{
-    pRecordMT_ = &recordmt;
-    invalidateFilter();
-}
-
-bool FinalReceiptProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
-{
-    QModelIndex index6 = sourceModel()->index(sourceRow, 6, sourceParent); // OfferID
-
-    QAbstractItemModel * pModel = sourceModel();
-    ModelTradeArchive  * pTradeModel = dynamic_cast<ModelTradeArchive*>(pModel);
-
-    if (nullptr != pTradeModel)
-    {
-        int64_t lCurrentOfferID  = pTradeModel->rawData(index6).toLongLong();
-
-        if (nullptr != pRecordMT_)
-        {
-            const int64_t lTransNumForDisplay = pRecordMT_->GetTransNumForDisplay();
-            return (lTransNumForDisplay == lCurrentOfferID);
-        }
-    }
-    return false;
-}
-
-
-
-
 TradeArchiveProxyModel::TradeArchiveProxyModel(QObject *parent /*=0*/)
 : QSortFilterProxyModel(parent)
 {
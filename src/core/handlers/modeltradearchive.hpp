@@ -67,26 +67,4 @@ private:
     bool    isBid_=false;
 };
 
-// This filter is used by AddFinalReceiptToTradeArchive, which only
-// cares about rows that correspond to that final receipt. (The code
-// that uses this proxy then adds a copy of that final receipt to
-// those specific rows.)
-class FinalReceiptProxyModel : public QSortFilterProxyModel
-{
-    Q_OBJECT
-
-public:
-    FinalReceiptProxyModel(QObject *parent = 0);
-
-    opentxs::OTRecord * filterOpentxsRecord() const { return pRecordMT_; }
-    void setFilterOpentxsRecord(opentxs::OTRecord& recordmt);
-
-protected:
-    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const Q_DECL_OVERRIDE;
-
-private:
-    opentxs::OTRecord * pRecordMT_ = nullptr;
-};
-
-
 #endif // MODELTRADEARCHIVE_H
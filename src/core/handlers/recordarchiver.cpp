@@ -0,0 +1,317 @@
+#ifndef __STABLE_HPP__
+#include <core/stable.hpp>
+#endif
+
+#include <core/handlers/recordarchiver.hpp>
+#include <core/handlers/DBHandler.hpp>
+#include <core/handlers/contacthandler.hpp>
+
+#include <QSqlRecord>
+#include <QStringList>
+#include <QSet>
+#include <QDebug>
+
+#include <algorithm>
+#include <functional>
+
+
+// Each payment or message is written inside this savepoint, so a failure
+// undoes that one item and not the whole batch.
+static const QString s_strItemSavepoint("archive_item");
+
+MTRecordArchiver::MTRecordArchiver()
+{
+}
+
+//static
+bool MTRecordArchiver::paymentKey(const mapColumnValues & mapValues, PaymentKey & theKey)
+{
+    // A payment without a display number, or without a Nym, never matched an
+    // existing row before either. (The lookup was on txn_id_display and my_nym_id.)
+    const qint64  lTxnDisplayId = mapValues.value("txn_id_display").toLongLong();
+    const QString qstrNymId     = mapValues.value("my_nym_id").toString();
+
+    if ((lTxnDisplayId <= 0) || qstrNymId.isEmpty())
+        return false;
+
+    theKey = PaymentKey(lTxnDisplayId, qstrNymId);
+    return true;
+}
+
+void MTRecordArchiver::addPayment(int nRecordIndex, const mapColumnValues & mapValues, const mapColumnValues & mapNewOnly,
+                                  const QString & qstrBody, const QString & qstrPendingBody)
+{
+    PaymentKey theKey;
+    const bool bHasKey = paymentKey(mapValues, theKey);
+
+    if (bHasKey && paymentSlots_.contains(theKey))
+    {
+        // Already in this batch. Same as updating the row the first one would
+        // have inserted: later values win, and the new-only ones stay as they were.
+        PendingPayment & thePayment = payments_[paymentSlots_.value(theKey)];
+
+        for (mapColumnValues::const_iterator it = mapValues.begin(); it != mapValues.end(); ++it)
+            thePayment.values.insert(it.key(), it.value());
+
+        if (!qstrBody.isEmpty())        thePayment.body        = qstrBody;
+        if (!qstrPendingBody.isEmpty()) thePayment.pendingBody = qstrPendingBody;
+
+        thePayment.recordIndices.push_back(nRecordIndex);
+        return;
+    }
+    // ---------------------------------
+    PendingPayment thePayment;
+    thePayment.recordIndices.push_back(nRecordIndex);
+    thePayment.values        = mapValues;
+    thePayment.newOnlyValues = mapNewOnly;
+    thePayment.body          = qstrBody;
+    thePayment.pendingBody   = qstrPendingBody;
+
+    if (bHasKey)
+        paymentSlots_.insert(theKey, static_cast<int>(payments_.size()));
+
+    payments_.push_back(thePayment);
+}
+
+void MTRecordArchiver::addMessage(int nRecordIndex, const mapColumnValues & mapValues, const QString & qstrBody)
+{
+    PendingMessage theMessage;
+    theMessage.nRecordIndex = nRecordIndex;
+    theMessage.values       = mapValues;
+    theMessage.body         = qstrBody;
+
+    messages_.push_back(theMessage);
+}
+
+void MTRecordArchiver::addFinalReceipt(int nRecordIndex, qint64 lOfferId, const QString & qstrReceipt)
+{
+    PendingFinalReceipt theReceipt;
+    theReceipt.nRecordIndex = nRecordIndex;
+    theReceipt.lOfferId     = lOfferId;
+    theReceipt.receipt      = qstrReceipt;
+
+    finalReceipts_.push_back(theReceipt);
+}
+
+void MTRecordArchiver::addArchivedRecord(int nRecordIndex)
+{
+    if (nRecordIndex >= 0)
+        alreadyArchived_.push_back(nRecordIndex);
+}
+
+bool MTRecordArchiver::isEmpty() const
+{
+    return payments_.empty() && messages_.empty() && finalReceipts_.empty() && alreadyArchived_.empty();
+}
+
+void MTRecordArchiver::markArchived(int nRecordIndex)
+{
+    if (nRecordIndex >= 0) // -1 means it stays in the record box.
+        archived_.push_back(nRecordIndex);
+}
+
+std::vector<int> MTRecordArchiver::archivedRecords() const
+{
+    std::vector<int> vecIndices(archived_);
+    vecIndices.insert(vecIndices.end(), alreadyArchived_.begin(), alreadyArchived_.end());
+
+    std::sort(vecIndices.begin(), vecIndices.end(), std::greater<int>());
+    vecIndices.erase(std::unique(vecIndices.begin(), vecIndices.end()), vecIndices.end());
+
+    return vecIndices;
+}
+
+// --------------------------------------------
+
+// Returns the new rowid, or 0 on failure.
+//
+//static
+int MTRecordArchiver::insertRow(const QString & qstrTable, const mapColumnValues & mapValues)
+{
+    QStringList  listColumns, listPlaceholders;
+    QVariantList params;
+
+    for (mapColumnValues::const_iterator it = mapValues.begin(); it != mapValues.end(); ++it)
+    {
+        listColumns      << QString("`%1`").arg(it.key());
+        listPlaceholders << QString("?");
+        params           << it.value();
+    }
+
+    const QString str_insert = QString("INSERT INTO `%1` (%2) VALUES(%3)").
+            arg(qstrTable).arg(listColumns.join(", ")).arg(listPlaceholders.join(", "));
+
+    if (!DBHandler::getInstance()->runQuery(str_insert, params))
+        return 0;
+
+    return DBHandler::getInstance()->queryInt("SELECT last_insert_rowid()", QVariantList());
+}
+
+void MTRecordArchiver::writePayments()
+{
+    if (payments_.empty())
+        return;
+    // ---------------------------------
+    // Only the rows for this batch's keys, through idx_payment_txn_display_nym,
+    // a chunk of display numbers at a time. Short chunks are padded with 0
+    // (never a key, see paymentKey) so every chunk uses the same statement.
+    //
+    QHash<PaymentKey, int> mapKnown;
+
+    QSet<qint64> setDisplayIds;
+
+    for (QHash<PaymentKey, int>::const_iterator it = paymentSlots_.begin(); it != paymentSlots_.end(); ++it)
+        setDisplayIds.insert(it.key().first);
+
+    const QList<qint64> listDisplayIds = setDisplayIds.toList();
+
+    static const int s_nLookupChunk = 50;
+
+    QStringList listPlaceholders;
+    for (int nIndex = 0; nIndex < s_nLookupChunk; ++nIndex)
+        listPlaceholders << QString("?");
+
+    const QString str_select = QString("SELECT `payment_id`, `txn_id_display`, `my_nym_id` FROM `payment` "
+                                       "WHERE `txn_id_display` IN (%1)").arg(listPlaceholders.join(", "));
+
+    for (int nChunk = 0; nChunk < listDisplayIds.size(); nChunk += s_nLookupChunk)
+    {
+        QVariantList params;
+
+        for (int nIndex = nChunk; nIndex < nChunk + s_nLookupChunk; ++nIndex)
+            params << ((nIndex < listDisplayIds.size()) ? listDisplayIds.at(nIndex) : qint64(0));
+
+        DBHandler::getInstance()->queryMultiple(str_select, params,
+            [this, &mapKnown](const QSqlRecord & record)
+            {
+                const PaymentKey theKey(record.value(1).toLongLong(), record.value(2).toString());
+
+                if (paymentSlots_.contains(theKey) && !mapKnown.contains(theKey)) // LIMIT 0,1, as before.
+                    mapKnown.insert(theKey, record.value(0).toInt());
+            });
+    }
+    // ---------------------------------
+    for (std::vector<PendingPayment>::iterator it = payments_.begin(); it != payments_.end(); ++it)
+    {
+        PendingPayment & thePayment = *it;
+
+        PaymentKey theKey;
+        int  nPaymentID = paymentKey(thePayment.values, theKey) ? mapKnown.value(theKey, 0) : 0;
+        bool bWritten   = false;
+
+        if (!DBHandler::getInstance()->savepoint(s_strItemSavepoint))
+            continue;
+
+        if (nPaymentID > 0)
+        {
+            bWritten = MTContactHandler::getInstance()->UpdatePaymentRecord(nPaymentID, thePayment.values) &&
+                       MTContactHandler::getInstance()->UpdatePaymentBody(nPaymentID, thePayment.body, thePayment.pendingBody);
+        }
+        else
+        {
+            mapColumnValues mapAll(thePayment.values);
+
+            for (mapColumnValues::const_iterator it_new = thePayment.newOnlyValues.begin();
+                 it_new != thePayment.newOnlyValues.end(); ++it_new)
+                if (!mapAll.contains(it_new.key()))
+                    mapAll.insert(it_new.key(), it_new.value());
+
+            nPaymentID = insertRow("payment", mapAll);
+            bWritten   = (nPaymentID > 0) &&
+                         MTContactHandler::getInstance()->CreatePaymentBody(nPaymentID, thePayment.body, thePayment.pendingBody);
+        }
+        // ---------------------------------
+        // A row without its body (or half updated) would be committed with the
+        // rest of the batch, while the record stays in the record box and gets
+        // archived again next time. So whatever this payment wrote is undone.
+        //
+        if (!bWritten)
+        {
+            qDebug() << "MTRecordArchiver: Failed writing payment record and/or body for payment_id: " << nPaymentID;
+            DBHandler::getInstance()->rollbackToSavepoint(s_strItemSavepoint);
+            continue;
+        }
+
+        if (!DBHandler::getInstance()->releaseSavepoint(s_strItemSavepoint))
+            continue;
+
+        for (std::vector<int>::const_iterator it_index = thePayment.recordIndices.begin();
+             it_index != thePayment.recordIndices.end(); ++it_index)
+            markArchived(*it_index);
+    }
+}
+
+void MTRecordArchiver::writeMessages()
+{
+    for (std::vector<PendingMessage>::const_iterator it = messages_.begin(); it != messages_.end(); ++it)
+    {
+        if (!DBHandler::getInstance()->savepoint(s_strItemSavepoint))
+            continue;
+
+        const int nMessageID = insertRow("message", it->values);
+
+        if ((nMessageID > 0) && MTContactHandler::getInstance()->CreateMessageBody(nMessageID, it->body))
+        {
+            if (DBHandler::getInstance()->releaseSavepoint(s_strItemSavepoint))
+                markArchived(it->nRecordIndex);
+        }
+        else
+        {
+            qDebug() << "MTRecordArchiver: Failed writing message record and/or body.";
+            DBHandler::getInstance()->rollbackToSavepoint(s_strItemSavepoint); // No message row without a body.
+        }
+    }
+}
+
+void MTRecordArchiver::writeFinalReceipts()
+{
+    if (finalReceipts_.empty())
+        return;
+    // ---------------------------------
+    QSet<qint64> setOffers;
+
+    DBHandler::getInstance()->queryMultiple("SELECT DISTINCT `offer_id` FROM `trade_archive`",
+                                            [&setOffers](const QSqlRecord & record)
+                                            {
+                                                setOffers.insert(record.value(0).toLongLong());
+                                            });
+
+    for (std::vector<PendingFinalReceipt>::const_iterator it = finalReceipts_.begin(); it != finalReceipts_.end(); ++it)
+    {
+        // No trades for this offer (or it's not a market offer at all), so the
+        // final receipt stays in the record box as the user's only copy.
+        if (!setOffers.contains(it->lOfferId))
+            continue;
+
+        if (DBHandler::getInstance()->runQuery("UPDATE `trade_archive` SET `final_receipt`=? WHERE `offer_id`=?",
+                                               QVariantList() << it->receipt << it->lOfferId))
+            markArchived(it->nRecordIndex);
+    }
+}
+
+// --------------------------------------------
+
+bool MTRecordArchiver::commit()
+{
+    archived_.clear();
+
+    if (payments_.empty() && messages_.empty() && finalReceipts_.empty())
+        return true;
+    // ---------------------------------
+    DBHandler * pDB = DBHandler::getInstance();
+
+    if (!pDB->beginTransaction())
+        return false;
+
+    writePayments();
+    writeMessages();
+    writeFinalReceipts();
+
+    if (!pDB->commitTransaction())
+    {
+        pDB->rollbackTransaction();
+        archived_.clear();
+        return false;
+    }
+    return true;
+}
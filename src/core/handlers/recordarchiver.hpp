@@ -0,0 +1,102 @@
+#ifndef RECORDARCHIVER_HPP
+#define RECORDARCHIVER_HPP
+
+#include <QString>
+#include <QVariant>
+#include <QMap>
+#include <QHash>
+#include <QPair>
+
+#include <vector>
+
+
+// Collects the rows that Moneychanger::modifyRecords() moves out of the OT
+// record box (payments, mail, final receipts) and writes them to the local
+// database in one SQLite transaction, instead of one transaction per record.
+//
+// Payments are matched against the payment table by (txn_id_display, my_nym_id),
+// using one lookup of the whole key set rather than a query per record. If the
+// same payment shows up more than once in a batch, the rows are merged.
+//
+// Every payment and message is written inside a savepoint of its own. If its
+// row goes in but its body doesn't, the row is rolled back and the record
+// stays in the record box; the rest of the batch is still committed.
+//
+// Each queued record carries its index in the record list (or -1 if it has to
+// stay in the record box.) After commit(), archivedRecords() lists the ones that
+// made it into the database, so the caller can delete them from OT.
+//
+class MTRecordArchiver
+{
+public:
+    typedef QMap<QString, QVariant> mapColumnValues;
+
+    MTRecordArchiver();
+
+    // mapNewOnly holds values that are only set when the payment row is created
+    // (have_read and so on), so they don't clobber what the user did since.
+    void addPayment(int nRecordIndex, const mapColumnValues & mapValues, const mapColumnValues & mapNewOnly,
+                    const QString & qstrBody, const QString & qstrPendingBody);
+    void addMessage(int nRecordIndex, const mapColumnValues & mapValues, const QString & qstrBody);
+
+    // The final receipt is copied onto the trade_archive rows for that offer. If
+    // there are none, the record isn't counted as archived.
+    void addFinalReceipt(int nRecordIndex, qint64 lOfferId, const QString & qstrReceipt);
+
+    // For records that are already archived somewhere else (market receipts.)
+    void addArchivedRecord(int nRecordIndex);
+
+    bool isEmpty() const;
+
+    // On failure the whole batch is rolled back, and only the records added with
+    // addArchivedRecord() count as archived.
+    bool commit();
+
+    // Highest index first, so the caller can delete them in that order.
+    std::vector<int> archivedRecords() const;
+
+private:
+    typedef QPair<qint64, QString> PaymentKey; // (txn_id_display, my_nym_id)
+
+    struct PendingPayment
+    {
+        std::vector<int> recordIndices;
+        mapColumnValues  values;
+        mapColumnValues  newOnlyValues;
+        QString          body;
+        QString          pendingBody;
+    };
+
+    struct PendingMessage
+    {
+        int             nRecordIndex;
+        mapColumnValues values;
+        QString         body;
+    };
+
+    struct PendingFinalReceipt
+    {
+        int     nRecordIndex;
+        qint64  lOfferId;
+        QString receipt;
+    };
+
+    static bool paymentKey(const mapColumnValues & mapValues, PaymentKey & theKey);
+    static int  insertRow(const QString & qstrTable, const mapColumnValues & mapValues);
+
+    void markArchived(int nRecordIndex);
+
+    void writePayments();
+    void writeMessages();
+    void writeFinalReceipts();
+
+    std::vector<PendingPayment>      payments_;
+    QHash<PaymentKey, int>           paymentSlots_; // Into payments_, for merging.
+    std::vector<PendingMessage>      messages_;
+    std::vector<PendingFinalReceipt> finalReceipts_;
+
+    std::vector<int> archived_;
+    std::vector<int> alreadyArchived_;
+};
+
+#endif // RECORDARCHIVER_HPP
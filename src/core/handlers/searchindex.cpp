@@ -0,0 +1,283 @@
+#ifndef __STABLE_HPP__
+#include <core/stable.hpp>
+#endif
+
+#include <core/handlers/searchindex.hpp>
+#include <core/handlers/contacthandler.hpp>
+
+#include <QAbstractItemModel>
+
+#include <algorithm>
+#include <iterator>
+
+
+//static
+const QChar MTSearchIndex::FieldSeparator = QChar(0x1F); // ASCII unit separator. Never typed into the search box.
+
+MTSearchIndex::MTSearchIndex(QAbstractItemModel * pModel, RowTextFunction fnRowText, QObject * parent /*=0*/)
+: QObject(parent)
+, pModel_(pModel)
+, fnRowText_(fnRowText)
+, bBuilt_(false)
+, nNameGeneration_(0)
+, bMatchesValid_(false)
+{
+    connect(pModel_, SIGNAL(modelReset()),                                  this, SLOT(onModelReset()));
+    connect(pModel_, SIGNAL(rowsInserted(QModelIndex,int,int)),             this, SLOT(onRowsInserted(QModelIndex,int,int)));
+    connect(pModel_, SIGNAL(rowsRemoved(QModelIndex,int,int)),              this, SLOT(onRowsRemoved(QModelIndex,int,int)));
+    connect(pModel_, SIGNAL(dataChanged(QModelIndex,QModelIndex)),          this, SLOT(onDataChanged(QModelIndex,QModelIndex)));
+}
+
+void MTSearchIndex::invalidate()
+{
+    bBuilt_        = false;
+    bMatchesValid_ = false;
+
+    rowText_.clear();
+    postings_.clear();
+    matches_.clear();
+}
+
+// --------------------------------------------
+
+void MTSearchIndex::onModelReset()
+{
+    // select() resets the model. Rather than resolving every name in the table
+    // right away, wait until someone actually types a filter.
+    invalidate();
+}
+
+void MTSearchIndex::onRowsInserted(const QModelIndex & parent, int first, int last)
+{
+    if (parent.isValid() || !bBuilt_)
+        return;
+
+    bMatchesValid_ = false;
+
+    if (first != rowText_.size()) // Inserted in the middle: every row after it moves.
+    {
+        invalidate();
+        return;
+    }
+    // Appended, which is also what fetchMore() does as the table scrolls.
+    rowText_.resize(last + 1);
+
+    for (int nRow = first; nRow <= last; ++nRow)
+        indexRow(nRow);
+}
+
+void MTSearchIndex::onRowsRemoved(const QModelIndex & parent, int first, int last)
+{
+    if (parent.isValid() || !bBuilt_)
+        return;
+
+    bMatchesValid_ = false;
+
+    if (last != (rowText_.size() - 1))
+    {
+        invalidate();
+        return;
+    }
+
+    for (int nRow = last; nRow >= first; --nRow)
+        unindexRow(nRow);
+
+    rowText_.resize(first);
+}
+
+void MTSearchIndex::onDataChanged(const QModelIndex & topLeft, const QModelIndex & bottomRight)
+{
+    if (!bBuilt_ || !topLeft.isValid() || !bottomRight.isValid())
+        return;
+
+    bMatchesValid_ = false;
+
+    const int nLast = std::min(bottomRight.row(), rowText_.size() - 1);
+
+    for (int nRow = topLeft.row(); nRow <= nLast; ++nRow)
+    {
+        unindexRow(nRow);
+        indexRow(nRow);
+    }
+}
+
+// --------------------------------------------
+
+//static
+void MTSearchIndex::trigramsOf(const QString & qstrText, std::vector<Trigram> & vecTrigrams)
+{
+    vecTrigrams.clear();
+
+    const int    nSize  = qstrText.size();
+    const QChar * pData = qstrText.constData();
+
+    if (nSize < 3)
+        return;
+
+    vecTrigrams.reserve(nSize - 2);
+
+    for (int ii = 0; ii < (nSize - 2); ++ii)
+    {
+        if ((pData[ii] == FieldSeparator) || (pData[ii+1] == FieldSeparator) || (pData[ii+2] == FieldSeparator))
+            continue;
+
+        vecTrigrams.push_back( (static_cast<Trigram>(pData[ii  ].unicode()) << 32) |
+                               (static_cast<Trigram>(pData[ii+1].unicode()) << 16) |
+                                static_cast<Trigram>(pData[ii+2].unicode()) );
+    }
+    std::sort(vecTrigrams.begin(), vecTrigrams.end());
+    vecTrigrams.erase(std::unique(vecTrigrams.begin(), vecTrigrams.end()), vecTrigrams.end());
+}
+
+void MTSearchIndex::indexRow(int nSourceRow) const
+{
+    rowText_[nSourceRow] = fnRowText_(nSourceRow);
+
+    std::vector<Trigram> vecTrigrams;
+    trigramsOf(rowText_[nSourceRow], vecTrigrams);
+
+    for (std::vector<Trigram>::const_iterator it = vecTrigrams.begin(); it != vecTrigrams.end(); ++it)
+    {
+        std::vector<int> & vecRows = postings_[*it];
+
+        if (vecRows.empty() || (vecRows.back() < nSourceRow)) // The common case: building, or appending.
+            vecRows.push_back(nSourceRow);
+        else
+        {
+            std::vector<int>::iterator itRow = std::lower_bound(vecRows.begin(), vecRows.end(), nSourceRow);
+
+            if ((itRow == vecRows.end()) || (*itRow != nSourceRow))
+                vecRows.insert(itRow, nSourceRow);
+        }
+    }
+}
+
+void MTSearchIndex::unindexRow(int nSourceRow) const
+{
+    std::vector<Trigram> vecTrigrams;
+    trigramsOf(rowText_[nSourceRow], vecTrigrams);
+
+    for (std::vector<Trigram>::const_iterator it = vecTrigrams.begin(); it != vecTrigrams.end(); ++it)
+    {
+        QHash<Trigram, std::vector<int> >::iterator itPosting = postings_.find(*it);
+
+        if (itPosting == postings_.end())
+            continue;
+
+        std::vector<int> & vecRows = itPosting.value();
+        std::vector<int>::iterator itRow = std::lower_bound(vecRows.begin(), vecRows.end(), nSourceRow);
+
+        if ((itRow != vecRows.end()) && (*itRow == nSourceRow))
+            vecRows.erase(itRow);
+
+        if (vecRows.empty())
+            postings_.erase(itPosting);
+    }
+    rowText_[nSourceRow].clear();
+}
+
+void MTSearchIndex::ensureBuilt() const
+{
+    // Row text includes resolved names, so any change to the name cache makes it stale.
+    const quint64 nGeneration = MTNameCache::getInstance()->generation();
+
+    if (bBuilt_ && (nGeneration == nNameGeneration_))
+    {
+        // fetchMore() normally announces new rows, but catch up if it didn't.
+        const int nRowCount = pModel_->rowCount();
+
+        if (rowText_.size() < nRowCount)
+        {
+            const int nFirst = rowText_.size();
+            rowText_.resize(nRowCount);
+
+            for (int nRow = nFirst; nRow < nRowCount; ++nRow)
+                indexRow(nRow);
+
+            bMatchesValid_ = false;
+        }
+        return;
+    }
+    // ------------------------------------
+    rowText_.clear();
+    postings_.clear();
+
+    bMatchesValid_   = false;
+    nNameGeneration_ = nGeneration;
+
+    const int nRowCount = pModel_->rowCount();
+    rowText_.resize(nRowCount);
+
+    for (int nRow = 0; nRow < nRowCount; ++nRow)
+        indexRow(nRow);
+
+    bBuilt_ = true;
+}
+
+void MTSearchIndex::findMatches(const QString & qstrFilter) const
+{
+    const int nRowCount = rowText_.size();
+
+    matches_.assign(nRowCount, 0);
+    matchFilter_   = qstrFilter;
+    bMatchesValid_ = true;
+
+    std::vector<Trigram> vecTrigrams;
+    trigramsOf(qstrFilter, vecTrigrams);
+
+    if (vecTrigrams.empty()) // Too short to use the index.
+    {
+        for (int nRow = 0; nRow < nRowCount; ++nRow)
+            matches_[nRow] = rowText_[nRow].contains(qstrFilter) ? 1 : 0;
+        return;
+    }
+    // ------------------------------------
+    // Intersect the posting lists, smallest first. A row has to contain every
+    // trigram of the filter, but that alone doesn't prove it contains the filter.
+    //
+    std::vector<const std::vector<int> *> vecLists;
+    vecLists.reserve(vecTrigrams.size());
+
+    for (std::vector<Trigram>::const_iterator it = vecTrigrams.begin(); it != vecTrigrams.end(); ++it)
+    {
+        QHash<Trigram, std::vector<int> >::const_iterator itPosting = postings_.constFind(*it);
+
+        if (itPosting == postings_.constEnd())
+            return; // No row has this trigram, so nothing matches.
+
+        vecLists.push_back(&itPosting.value());
+    }
+    std::sort(vecLists.begin(), vecLists.end(),
+              [](const std::vector<int> * lhs, const std::vector<int> * rhs) { return lhs->size() < rhs->size(); });
+
+    std::vector<int> vecCandidates(*vecLists.front());
+    std::vector<int> vecNarrowed;
+
+    for (size_t ii = 1; (ii < vecLists.size()) && !vecCandidates.empty(); ++ii)
+    {
+        vecNarrowed.clear();
+        std::set_intersection(vecCandidates.begin(), vecCandidates.end(),
+                              vecLists[ii]->begin(), vecLists[ii]->end(),
+                              std::back_inserter(vecNarrowed));
+        vecCandidates.swap(vecNarrowed);
+    }
+
+    for (std::vector<int>::const_iterator it = vecCandidates.begin(); it != vecCandidates.end(); ++it)
+    {
+        if (rowText_[*it].contains(qstrFilter))
+            matches_[*it] = 1;
+    }
+}
+
+bool MTSearchIndex::rowMatches(int nSourceRow, const QString & qstrFilter) const
+{
+    ensureBuilt();
+
+    if (!bMatchesValid_ || (matchFilter_ != qstrFilter))
+        findMatches(qstrFilter);
+
+    if ((nSourceRow < 0) || (nSourceRow >= static_cast<int>(matches_.size())))
+        return false;
+
+    return (0 != matches_[nSourceRow]);
+}
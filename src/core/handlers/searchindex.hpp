@@ -0,0 +1,79 @@
+#ifndef SEARCHINDEX_HPP
+#define SEARCHINDEX_HPP
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QModelIndex>
+
+#include <functional>
+#include <vector>
+
+class QAbstractItemModel;
+
+
+// Trigram index over the searchable text of every row in a table model.
+//
+// The owning model supplies a function that renders one source row to a single
+// search string (IDs, memo, resolved names and so on). The index keeps that text
+// per row plus a posting list of rows for every trigram in it, so a filter string
+// of three or more characters only has to look at the rows that contain all of
+// its trigrams. Shorter filters fall back to scanning the stored text, which still
+// avoids re-resolving names for every row on every keystroke.
+//
+// The index is built lazily on the first probe after the model is selected, then
+// kept current as rows are appended or edited. Anything else (rows removed from
+// the middle, a name in MTNameCache changing) just marks it stale.
+//
+// Matching is exactly QString::contains() against each field, as before.
+//
+class MTSearchIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef std::function<QString(int nSourceRow)> RowTextFunction;
+
+    MTSearchIndex(QAbstractItemModel * pModel, RowTextFunction fnRowText, QObject * parent = 0);
+
+    // Separates the fields in the text returned by the row text function.
+    static const QChar FieldSeparator;
+
+    bool rowMatches(int nSourceRow, const QString & qstrFilter) const;
+
+    void invalidate(); // Forces a rebuild on the next probe.
+
+private slots:
+    void onModelReset();
+    void onRowsInserted(const QModelIndex & parent, int first, int last);
+    void onRowsRemoved (const QModelIndex & parent, int first, int last);
+    void onDataChanged (const QModelIndex & topLeft, const QModelIndex & bottomRight);
+
+private:
+    typedef quint64 Trigram;
+
+    void ensureBuilt() const;
+    void indexRow  (int nSourceRow) const;
+    void unindexRow(int nSourceRow) const;
+    void findMatches(const QString & qstrFilter) const;
+
+    static void trigramsOf(const QString & qstrText, std::vector<Trigram> & vecTrigrams);
+
+    QAbstractItemModel * pModel_;
+    RowTextFunction      fnRowText_;
+
+    // Filtering runs from const filterAcceptsRow(), so the index is built on demand.
+    mutable bool     bBuilt_;
+    mutable quint64  nNameGeneration_;
+
+    mutable QVector<QString>                 rowText_;
+    mutable QHash<Trigram, std::vector<int>> postings_; // Each list is sorted by row.
+
+    // Result of the last probe; the proxy asks once per row for the same filter.
+    mutable bool              bMatchesValid_;
+    mutable QString           matchFilter_;
+    mutable std::vector<char> matches_;
+};
+
+#endif // SEARCHINDEX_HPP
@@ -3,6 +3,7 @@
 #endif
 
 #include <core/moneychanger.hpp>
+#include <core/otlock.hpp>
 #include <core/applicationmc.hpp>
 #include <core/modules.hpp>
 #include <core/translation.hpp>
@@ -69,6 +70,8 @@ int main(int argc, char *argv[])
     MTApplicationMC theApplication(argc, argv);  // <====== THIRD constructor (they are destroyed in reverse order.)
     theApplication.setQuitOnLastWindowClosed(false);
 
+    MTOTLock::install(); // From here on, the GUI thread shares OT with the RPC executor.
+
     { Modules modules; }    // run constructor once, initialize static pointers
     BtcModulesPtr btcModules = BtcModulesPtr(new BtcModules());
 
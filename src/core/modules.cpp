@@ -14,6 +14,8 @@
 #include <gui/widgets/btcconnectdlg.hpp>
 #include <gui/widgets/btcwalletpwdlg.hpp>
 
+#include <opentxs/core/util/OTPaths.hpp>
+
 
 _SharedPtr<SampleEscrowManager> Modules::sampleEscrowManager;
 _SharedPtr<PoolManager> Modules::poolManager;
@@ -39,6 +41,7 @@ Modules::Modules()
     shutDown = false;
 
     btcModules->btcJson->SetPasswordCallback(fastdelegate::MakeDelegate(walletPwDlg.get(), &BtcWalletPwDlg::WaitForPassword));
+    btcModules->btcHelper->SetBlockIndexFile(std::string(opentxs::OTPaths::AppDataFolder().Get()) + "mc_btcblockindex");
 }
 
 Modules::~Modules()
@@ -19,11 +19,14 @@
 
 #include <core/moneychanger.hpp>
 #include <core/mtcomms.h>
+#include <core/otlock.hpp>
 #include <core/handlers/DBHandler.hpp>
 #include <core/handlers/contacthandler.hpp>
 #include <core/handlers/modeltradearchive.hpp>
+#include <core/handlers/recordarchiver.hpp>
 
 #include <rpc/rpcserver.h>
+#include <rpc/rpceventlog.h>
 
 #include <gui/widgets/compose.hpp>
 #include <gui/widgets/home.hpp>
@@ -106,7 +109,7 @@ Moneychanger * Moneychanger::It(QWidget *parent/*=0*/, bool bShuttingDown/*=fals
 
 Moneychanger::Moneychanger(QWidget *parent)
 : QWidget(parent),
-  m_list(*(new MTNameLookupQT)),
+  m_pList(new opentxs::OTRecordList(*(new MTNameLookupQT))),
   nmc(new NMC_Interface ()),
   nmc_names(NULL),
   mc_overall_init(false),
@@ -138,9 +141,12 @@ Moneychanger::Moneychanger(QWidget *parent)
     // This can be moved very easily into a different class
     // Which I will inevitably end up doing.
 
+    // A failed lookup isn't a missing row; don't insert a blank one over it.
+    bool bQueryFailed = false;
+
     /** Default Nym **/
     qDebug() << "Setting up Nym table";
-    if (DBHandler::getInstance()->querySize("SELECT `nym` FROM `default_nym` WHERE `default_id`='1' LIMIT 0,1") == 0)
+    if (!DBHandler::getInstance()->queryExists("SELECT `nym` FROM `default_nym` WHERE `default_id`='1'", QVariantList(), &bQueryFailed) && !bQueryFailed)
     {
         qDebug() << "Default Nym wasn't set in the database. Inserting blank record...";
         DBHandler::getInstance()->runQuery("INSERT INTO `default_nym` (`default_id`,`nym`) VALUES('1','')"); // Blank Row
@@ -168,7 +174,7 @@ Moneychanger::Moneychanger(QWidget *parent)
 
     /** Default Server **/
     //Query for the default server (So we know for setting later on -- Auto select server associations on later dialogs)
-    if (DBHandler::getInstance()->querySize("SELECT `server` FROM `default_server` WHERE `default_id`='1' LIMIT 0,1") == 0)
+    if (!DBHandler::getInstance()->queryExists("SELECT `server` FROM `default_server` WHERE `default_id`='1'", QVariantList(), &bQueryFailed) && !bQueryFailed)
     {
         qDebug() << "Default Server wasn't set in the database. Inserting blank record...";
         DBHandler::getInstance()->runQuery("INSERT INTO `default_server` (`default_id`, `server`) VALUES('1','')"); // Blank Row
@@ -197,7 +203,7 @@ Moneychanger::Moneychanger(QWidget *parent)
 
     /** Default Asset Type **/
     //Query for the default asset (So we know for setting later on -- Auto select asset associations on later dialogs)
-    if (DBHandler::getInstance()->querySize("SELECT `asset` FROM `default_asset` WHERE `default_id`='1' LIMIT 0,1") == 0)
+    if (!DBHandler::getInstance()->queryExists("SELECT `asset` FROM `default_asset` WHERE `default_id`='1'", QVariantList(), &bQueryFailed) && !bQueryFailed)
     {
         qDebug() << "Default Asset Type wasn't set in the database. Inserting blank record...";
         DBHandler::getInstance()->runQuery("INSERT INTO `default_asset` (`default_id`,`asset`) VALUES('1','')"); // Blank Row
@@ -225,7 +231,7 @@ Moneychanger::Moneychanger(QWidget *parent)
 
     /** Default Account **/
     //Query for the default account (So we know for setting later on -- Auto select account associations on later dialogs)
-    if (DBHandler::getInstance()->querySize("SELECT `account` FROM `default_account` WHERE `default_id`='1' LIMIT 0,1") == 0)
+    if (!DBHandler::getInstance()->queryExists("SELECT `account` FROM `default_account` WHERE `default_id`='1'", QVariantList(), &bQueryFailed) && !bQueryFailed)
     {
         qDebug() << "Default Account wasn't set in the database. Inserting blank record...";
 
@@ -255,6 +261,7 @@ Moneychanger::Moneychanger(QWidget *parent)
     // Check for RPCServer Settings (Config read will populate the database)
 
     RPCServer::getInstance()->init();
+    RPCEventLog::getInstance()->watch(this); // Turns our signals into events for RPC clients.
 
     qDebug() << "Database Populated";
 
@@ -332,6 +339,20 @@ Moneychanger::Moneychanger(QWidget *parent)
 
     bHideNav_ = (0 == qstrHideNav.compare("on"));
     // -------------------------------------------------
+    // The record list is populated on its own thread. (See onNeedToPopulateRecordlist.)
+    //
+    MTRecordListPopulator::registerMetaTypes();
+
+    m_pPopulatorThread = new QThread(this);
+    m_pPopulator       = new MTRecordListPopulator; // No parent, since it moves to the other thread.
+    m_pPopulator->moveToThread(m_pPopulatorThread);
+
+    connect(m_pPopulatorThread, SIGNAL(finished()), m_pPopulator, SLOT(deleteLater()));
+    connect(m_pPopulator, SIGNAL(recordListReady(MTRecordListSnapshotPtr)),
+            this,         SLOT(onRecordListReady(MTRecordListSnapshotPtr)));
+
+    m_pPopulatorThread->start();
+    // -------------------------------------------------
     setupRecordList();
 
     mc_overall_init = true;
@@ -675,6 +696,14 @@ static void blah()
 
 Moneychanger::~Moneychanger()
 {
+    if (m_pPopulatorThread)
+    {
+        MTOTLock::GuiRelease release; // The current job may be waiting for the OT lock.
+
+        m_pPopulatorThread->quit(); // Lets the current job finish first.
+        m_pPopulatorThread->wait();
+    }
+
     delete nmc_update_timer;
     delete nmc_names;
     delete nmc;
@@ -686,67 +715,60 @@ Moneychanger::~Moneychanger()
 
 opentxs::OTRecordList & Moneychanger::GetRecordlist()
 {
-    return m_list;
+    return *m_pList;
 }
 
 void Moneychanger::setupRecordList()
+{
+    MTRecordListJob job;
+    collectRecordListIds(job);
+
+    MTRecordListPopulator::setupRecordList(GetRecordlist(), job);
+}
+
+void Moneychanger::collectRecordListIds(MTRecordListJob & job)
 {
     int nServerCount  = opentxs::OTAPI_Wrap::It()->GetServerCount();
     int nAssetCount   = opentxs::OTAPI_Wrap::It()->GetAssetTypeCount();
     int nNymCount     = opentxs::OTAPI_Wrap::It()->GetNymCount();
     int nAccountCount = opentxs::OTAPI_Wrap::It()->GetAccountCount();
     // ----------------------------------------------------
-    GetRecordlist().ClearServers();
-    GetRecordlist().ClearAssets();
-    GetRecordlist().ClearNyms();
-    GetRecordlist().ClearAccounts();
-    // ----------------------------------------------------
     for (int ii = 0; ii < nServerCount; ++ii)
     {
         std::string NotaryID = opentxs::OTAPI_Wrap::It()->GetServer_ID(ii);
-        GetRecordlist().AddNotaryID(NotaryID);
+        job.notaryIds.push_back(NotaryID);
     }
     // ----------------------------------------------------
     for (int ii = 0; ii < nAssetCount; ++ii)
     {
         std::string InstrumentDefinitionID = opentxs::OTAPI_Wrap::It()->GetAssetType_ID(ii);
-        GetRecordlist().AddInstrumentDefinitionID(InstrumentDefinitionID);
+        job.assetIds.push_back(InstrumentDefinitionID);
     }
     // ----------------------------------------------------
     for (int ii = 0; ii < nNymCount; ++ii)
     {
         std::string nymId = opentxs::OTAPI_Wrap::It()->GetNym_ID(ii);
-        GetRecordlist().AddNymID(nymId);
+        job.nymIds.push_back(nymId);
     }
     // ----------------------------------------------------
     for (int ii = 0; ii < nAccountCount; ++ii)
     {
         std::string accountID = opentxs::OTAPI_Wrap::It()->GetAccountWallet_ID(ii);
-        GetRecordlist().AddAccountID(accountID);
+        job.accountIds.push_back(accountID);
     }
-    // ----------------------------------------------------
-    GetRecordlist().AcceptChequesAutomatically  (true);
-    GetRecordlist().AcceptReceiptsAutomatically (true);
-    GetRecordlist().AcceptTransfersAutomatically(false);
 }
 
-// Calls OTRecordList::Populate(), and then additionally adds records from Bitmessage, etc.
+// Finds the Bitmessage (etc) addresses for the Nyms that we care about, so the
+// populator can fetch their mail. (If we didn't add a Nym ID to the record list,
+// then we don't care about any Bitmessages for that Nym.)
+// This part stays on the GUI thread, since it reads the local database, and
+// MTComms isn't thread-safe.
 //
-void Moneychanger::populateRecords()
-{
-    GetRecordlist().Populate(); // Refreshes the OT data from local storage.   < << <<==============***
-    // ---------------------------------------------------------------------
-    QList<QString> listCheckOnlyOnce; // So we don't call checkMail more than once for the same connect string.
-    // ---------------------------------------------------------------------
-    // Let's see if, additionally, there are any Bitmessage records (etc)
-    // for the Nyms that we care about. (If we didn't add a Nym ID to GetRecordlist()'s
-    // list of Nyms, then we don't care about any Bitmessages for that Nym.)
-    //
-    bool bNeedsReSorting = false;
-
-    const opentxs::list_of_strings & the_nyms = GetRecordlist().GetNyms();
+void Moneychanger::collectMailTransports(MTRecordListJob & job)
+{
+    QMap<QString, int> mapTransports; // Connect string -> index in job.transports. (So we don't call checkMail more than once for the same connect string.)
 
-    for (opentxs::list_of_strings::const_iterator it = the_nyms.begin(); it != the_nyms.end(); ++it)
+    for (std::vector<std::string>::const_iterator it = job.nymIds.begin(); it != job.nymIds.end(); ++it)
     {
         const std::string str_nym_id = *it;
         // -----------------------------
@@ -755,159 +777,98 @@ void Moneychanger::populateRecords()
 
         bool bGotMethods = !filterByNym.isEmpty() ? MTContactHandler::getInstance()->GetMsgMethodsByNym(mapMethods, filterByNym, false, QString("")) : false;
 
-        if (bGotMethods)
+        if (!bGotMethods)
+            continue;
+        // -----------------------------
+        // Loop through mapMethods and for each methodID, call GetAddressesByNym.
+        // The populator grabs the inbox and outbox for each address from MTComms.
+        //
+        for (mapIDName::iterator ii = mapMethods.begin(); ii != mapMethods.end(); ++ii)
         {
-            // Loop through mapMethods and for each methodID, call GetAddressesByNym.
-            // Then for each address, grab the inbox and outbox from MTComms, and add
-            // the messages to GetRecordlist().
-            //
-            for (mapIDName::iterator ii = mapMethods.begin(); ii != mapMethods.end(); ++ii)
+            QString qstrID = ii.key();
+
+            QStringList stringlist = qstrID.split("|");
+
+            if (stringlist.size() < 2) // Should always be 2...
+                continue;
+
+            QString qstrMethodID = stringlist.at(1);
+            const int nFilterByMethodID = qstrMethodID.isEmpty() ? 0 : qstrMethodID.toInt();
+
+            if (nFilterByMethodID <= 0)
+                continue;
+            // --------------------------------------
+            QString   qstrMethodType  = MTContactHandler::getInstance()->GetMethodType       (nFilterByMethodID);
+            QString   qstrTypeDisplay = MTContactHandler::getInstance()->GetMethodTypeDisplay(nFilterByMethodID);
+            QString   qstrConnectStr  = MTContactHandler::getInstance()->GetMethodConnectStr (nFilterByMethodID);
+
+            if (qstrConnectStr.isEmpty())
+                continue;
+
+            NetworkModule * pModule = MTComms::find(qstrConnectStr.toStdString());
+
+            if ((NULL == pModule) && MTComms::add(qstrMethodType.toStdString(), qstrConnectStr.toStdString()))
+                pModule = MTComms::find(qstrConnectStr.toStdString());
+
+            if (NULL == pModule)
             {
-                QString qstrID        = ii.key();
-                int nFilterByMethodID = 0;
+                // todo probably need a messagebox here.
+                qDebug() << QString("PopulateRecords: Unable to add a %1 interface with connection string: %2").arg(qstrMethodType).arg(qstrConnectStr);
+                continue;
+            }
+            // ------------------------------
+            MTRecordListJob::MailSource theSource;
+            theSource.nymId             = str_nym_id;
+            theSource.nMethodID         = nFilterByMethodID;
+            theSource.methodType        = qstrMethodType.toStdString();
+            theSource.methodTypeDisplay = qstrTypeDisplay.toStdString();
 
-                QStringList stringlist = qstrID.split("|");
+            mapIDName mapAddresses;
 
-                if (stringlist.size() >= 2) // Should always be 2...
+            if (MTContactHandler::getInstance()->GetAddressesByNym(mapAddresses, filterByNym, nFilterByMethodID))
+            {
+                for (mapIDName::iterator jj = mapAddresses.begin(); jj != mapAddresses.end(); ++jj)
                 {
-//                  QString qstrType     = stringlist.at(0);
-                    QString qstrMethodID = stringlist.at(1);
-                    nFilterByMethodID    = qstrMethodID.isEmpty() ? 0 : qstrMethodID.toInt();
-                    // --------------------------------------
-                    if (nFilterByMethodID > 0)
-                    {
-                        QString   qstrMethodType  = MTContactHandler::getInstance()->GetMethodType       (nFilterByMethodID);
-                        QString   qstrTypeDisplay = MTContactHandler::getInstance()->GetMethodTypeDisplay(nFilterByMethodID);
-                        QString   qstrConnectStr  = MTContactHandler::getInstance()->GetMethodConnectStr (nFilterByMethodID);
+                    QString qstrAddress = jj.key();
 
-                        if (!qstrConnectStr.isEmpty())
-                        {
-                            NetworkModule * pModule = MTComms::find(qstrConnectStr.toStdString());
-
-                            if ((NULL == pModule) && MTComms::add(qstrMethodType.toStdString(), qstrConnectStr.toStdString()))
-                                pModule = MTComms::find(qstrConnectStr.toStdString());
-
-                            if (NULL == pModule)
-                                // todo probably need a messagebox here.
-                                qDebug() << QString("PopulateRecords: Unable to add a %1 interface with connection string: %2").arg(qstrMethodType).arg(qstrConnectStr);
-
-                            if ((NULL != pModule) && pModule->accessible())
-                            {
-                                if ((-1) == listCheckOnlyOnce.indexOf(qstrConnectStr)) // Not on the list yet.
-                                {
-                                    pModule->checkMail();
-                                    listCheckOnlyOnce.insert(0, qstrConnectStr);
-                                }
-                                // ------------------------------
-                                mapIDName mapAddresses;
-
-                                if (MTContactHandler::getInstance()->GetAddressesByNym(mapAddresses, filterByNym, nFilterByMethodID))
-                                {
-                                    for (mapIDName::iterator jj = mapAddresses.begin(); jj != mapAddresses.end(); ++jj)
-                                    {
-                                        QString qstrAddress = jj.key();
-
-                                        if (!qstrAddress.isEmpty())
-                                        {
-                                            // --------------------------------------------------------------------------------------------
-                                            // INBOX
-                                            //
-                                            std::vector< _SharedPtr<NetworkMail> > theInbox = pModule->getInbox(qstrAddress.toStdString());
-
-                                            for (std::vector< _SharedPtr<NetworkMail> >::size_type nIndex = 0; nIndex < theInbox.size(); ++nIndex)
-                                            {
-                                                _SharedPtr<NetworkMail> & theMsg = theInbox[nIndex];
-
-                                                std::string strSubject  = theMsg->getSubject();
-                                                std::string strContents = theMsg->getMessage();
-                                                // ----------------------------------------------------
-                                                QString qstrFinal;
-
-                                                if (!strSubject.empty())
-                                                    qstrFinal = QString("%1: %2\n%3").
-                                                            arg(tr("Subject")).
-                                                            arg(QString::fromStdString(strSubject)).
-                                                            arg(QString::fromStdString(strContents));
-                                                else
-                                                    qstrFinal = QString::fromStdString(strContents);
-                                                // ----------------------------------------------------
-                                                bNeedsReSorting = true;
-
-                                                if (!theMsg->getMessageID().empty())
-                                                    GetRecordlist().AddSpecialMsg(theMsg->getMessageID(),
-                                                                         false, //bIsOutgoing=false
-                                                                         static_cast<int32_t>(nFilterByMethodID),
-                                                                         qstrFinal.toStdString(),
-                                                                         theMsg->getTo(),
-                                                                         theMsg->getFrom(),
-                                                                         qstrMethodType.toStdString(),
-                                                                         qstrTypeDisplay.toStdString(),
-                                                                         str_nym_id,
-                                                                         static_cast<time64_t>(theMsg->getReceivedTime()));
-                                            } // for (inbox)
-                                            // --------------------------------------------------------------------------------------------
-                                            // OUTBOX
-                                            //
-                                            std::vector< _SharedPtr<NetworkMail> > theOutbox = pModule->getOutbox(qstrAddress.toStdString());
-
-                                            for (std::vector< _SharedPtr<NetworkMail> >::size_type nIndex = 0; nIndex < theOutbox.size(); ++nIndex)
-                                            {
-                                                _SharedPtr<NetworkMail> & theMsg = theOutbox[nIndex];
-
-                                                std::string strSubject  = theMsg->getSubject();
-                                                std::string strContents = theMsg->getMessage();
-                                                // ----------------------------------------------------
-                                                QString qstrFinal;
-
-                                                if (!strSubject.empty())
-                                                    qstrFinal = QString("%1: %2\n%3").
-                                                            arg(tr("Subject")).
-                                                            arg(QString::fromStdString(strSubject)).
-                                                            arg(QString::fromStdString(strContents));
-                                                else
-                                                    qstrFinal = QString::fromStdString(strContents);
-                                                // ----------------------------------------------------
-                                                bNeedsReSorting = true;
-
-//                                                qDebug() << QString("Adding OUTGOING theMsg->getMessageID(): %1 \n filterByNym: %2 \n qstrAddress: %3 \n nIndex: %4")
-//                                                            .arg(QString::fromStdString(theMsg->getMessageID()))
-//                                                            .arg(filterByNym)
-//                                                            .arg(qstrAddress)
-//                                                            .arg(nIndex)
-//                                                            ;
-
-
-                                                if (!theMsg->getMessageID().empty())
-                                                    GetRecordlist().AddSpecialMsg(theMsg->getMessageID(),
-                                                                         true, //bIsOutgoing=true
-                                                                         static_cast<int32_t>(nFilterByMethodID),
-                                                                         qstrFinal.toStdString(),
-                                                                         theMsg->getFrom(),
-                                                                         theMsg->getTo(),
-                                                                         qstrMethodType.toStdString(),
-                                                                         qstrTypeDisplay.toStdString(),
-                                                                         str_nym_id,
-                                                                         static_cast<time64_t>(theMsg->getSentTime()));
-                                            } // for (outbox)
-                                        } // if (!qstrAddress.isEmpty())
-                                    } // for (addresses)
-                                } // if GetAddressesByNym
-                            } // if ((NULL != pModule) && pModule->accessible())
-                        } // if (!qstrConnectStr.isEmpty())
-                    } // if nFilterByMethodID > 0
-                } // if (stringlist.size() >= 2)
-            } // for (methods)
-        } // if bGotMethods
+                    if (!qstrAddress.isEmpty())
+                        theSource.addresses.push_back(qstrAddress.toStdString());
+                }
+            }
+            // ------------------------------
+            if (!mapTransports.contains(qstrConnectStr))
+            {
+                mapTransports.insert(qstrConnectStr, static_cast<int>(job.transports.size()));
+
+                job.transports.push_back(MTRecordListJob::MailTransport());
+                job.transports.back().pModule = pModule;
+            }
+
+            job.transports[mapTransports.value(qstrConnectStr)].sources.push_back(theSource);
+        } // for (methods)
     } // for (nyms)
-    // -----------------------------------------------------
-    if (bNeedsReSorting)
-        GetRecordlist().SortRecords();
-    // -----------------------------------------------------
-    // This takes things like market receipts out of the record list
-    // and moves to their own database table.
-    // Same thing for mail messages, etc.
-    //
-    modifyRecords();
+}
+
+// Queues a job for the populator thread, which calls OTRecordList::Populate(),
+// and then additionally adds records from Bitmessage, etc. The result comes
+// back in onRecordListReady.
+//
+void Moneychanger::startRecordListPopulation(bool bFollowUp/*=false*/)
+{
+    MTRecordListJob job;
+    job.nSequence        = ++m_nPopulateSequence;
+    job.bFollowUp        = bFollowUp;
+    job.qstrSubjectLabel = tr("Subject");
+
+    collectRecordListIds (job);
+    collectMailTransports(job);
+
+    MTRecordListPopulator::setupRecordList(GetRecordlist(), job); // Same IDs on the current list, in the meantime.
+    // ----------------------------------------------
+    m_bPopulating    = true;
+    m_bPopulateAgain = false; // This job will pick up whatever that request was for.
+
+    QMetaObject::invokeMethod(m_pPopulator, "populate", Qt::QueuedConnection, Q_ARG(MTRecordListJob, job));
 }
 
 
@@ -2324,242 +2285,166 @@ void Moneychanger::onNeedToDownloadMail()
 
 
 
-bool Moneychanger::AddFinalReceiptToTradeArchive(opentxs::OTRecord& recordmt)
-{
-    QPointer<ModelTradeArchive> pModel = DBHandler::getInstance()->getTradeArchiveModel();
-
-    if (pModel)
-    {
-        QPointer<FinalReceiptProxyModel> pFinalReceiptProxy = new FinalReceiptProxyModel;
-        pFinalReceiptProxy->setSourceModel(pModel);
-        pFinalReceiptProxy->setFilterOpentxsRecord(recordmt);
-
-        bool bEditing = false;
-        QString qstrReceipt;
-
-        int nRowCount = pFinalReceiptProxy->rowCount();
-        for (int nIndex = 0; nIndex < nRowCount; ++nIndex)
-        {
-            if (!bEditing)
-            {
-                bEditing = true;
-                pModel->database().transaction();
-                qstrReceipt = QString::fromStdString(recordmt.GetContents());
-            }
-
-            QModelIndex proxyIndex  = pFinalReceiptProxy->index(nIndex, 0);
-            QModelIndex actualIndex = pFinalReceiptProxy->mapToSource(proxyIndex);
-            QSqlRecord  record      = pModel->record(actualIndex.row());
-            record.setValue("final_receipt", qstrReceipt);
-            pModel->setRecord(actualIndex.row(), record);
-        }
-        // ----------------------------
-        if (bEditing)
-        {
-            if (pModel->submitAll())
-            {
-                if (pModel->database().commit())
-                {
-                    // Success.
-                    return true;
-                }
-            }
-            else
-            {
-                pModel->database().rollback();
-                qDebug() << "Database Write Error" <<
-                           "The database reported an error: " <<
-                           pModel->lastError().text();
-            }
-        }
-    }
-    return false;
-}
-
-
 // Todo someday: Add a setting to the configuration so a user can choose whether or not to import Bitmessages.
 // In which case they might never be added to the database here, or deleting from Bitmessage here (as they are now in both cases), unless that setting was set to true.
 //
-bool Moneychanger::AddMailToMsgArchive(opentxs::OTRecord& recordmt)
+void Moneychanger::QueueMailForArchive(MTRecordArchiver & archiver, opentxs::OTRecord& recordmt, int nRecordIndex)
 {
-    QPointer<ModelMessages> pModel = DBHandler::getInstance()->getMessageModel();
-    bool bSuccessAddingMsg = false;
-    QString qstrBody("");
-
-    if (pModel)
-    {
-        QString myNymID;
-        if (!recordmt.GetNymID().empty())
-            myNymID = QString::fromStdString(recordmt.GetNymID());
-        // ---------------------------------
-        QString myAddress;
-        if (!recordmt.GetAddress().empty())
-            myAddress = QString::fromStdString(recordmt.GetAddress());
+    QString myNymID;
+    if (!recordmt.GetNymID().empty())
+        myNymID = QString::fromStdString(recordmt.GetNymID());
+    // ---------------------------------
+    QString myAddress;
+    if (!recordmt.GetAddress().empty())
+        myAddress = QString::fromStdString(recordmt.GetAddress());
 //          myAddress = MTContactHandler::Encode(QString::fromStdString(recordmt.GetAddress()));
-        // ---------------------------------
-        QString senderNymID,    senderAddress,
-                recipientNymID, recipientAddress;
+    // ---------------------------------
+    QString senderNymID,    senderAddress,
+            recipientNymID, recipientAddress;
 
-        if (recordmt.IsOutgoing())
-        {
-            if (!recordmt.GetOtherNymID().empty())
-                recipientNymID = QString::fromStdString(recordmt.GetOtherNymID());
+    if (recordmt.IsOutgoing())
+    {
+        if (!recordmt.GetOtherNymID().empty())
+            recipientNymID = QString::fromStdString(recordmt.GetOtherNymID());
 
-            if (!recordmt.GetOtherAddress().empty())
-                recipientAddress = QString::fromStdString(recordmt.GetOtherAddress());
+        if (!recordmt.GetOtherAddress().empty())
+            recipientAddress = QString::fromStdString(recordmt.GetOtherAddress());
 //              recipientAddress = MTContactHandler::Encode(QString::fromStdString(recordmt.GetOtherAddress()));
-        }
-        else
-        {
-            if (!recordmt.GetOtherNymID().empty())
-                senderNymID = QString::fromStdString(recordmt.GetOtherNymID());
+    }
+    else
+    {
+        if (!recordmt.GetOtherNymID().empty())
+            senderNymID = QString::fromStdString(recordmt.GetOtherNymID());
 
-            if (!recordmt.GetOtherAddress().empty())
-                senderAddress = QString::fromStdString(recordmt.GetOtherAddress());
+        if (!recordmt.GetOtherAddress().empty())
+            senderAddress = QString::fromStdString(recordmt.GetOtherAddress());
 //              senderAddress = MTContactHandler::Encode(QString::fromStdString(recordmt.GetOtherAddress()));
-        }
-        // ---------------------------------
-        QString notaryID, msgType, msgTypeDisplay;
+    }
+    // ---------------------------------
+    QString notaryID, msgType, msgTypeDisplay;
 
-        if (!recordmt.GetNotaryID().empty())
-            notaryID = QString::fromStdString(recordmt.GetNotaryID());
+    if (!recordmt.GetNotaryID().empty())
+        notaryID = QString::fromStdString(recordmt.GetNotaryID());
 
-        if (!recordmt.GetMsgType().empty())
-            msgType = QString::fromStdString(recordmt.GetMsgType());
+    if (!recordmt.GetMsgType().empty())
+        msgType = QString::fromStdString(recordmt.GetMsgType());
 //          msgType = MTContactHandler::Encode(QString::fromStdString(recordmt.GetMsgType()));
 
-        if (!recordmt.GetMsgTypeDisplay().empty())
-            msgTypeDisplay = QString::fromStdString(recordmt.GetMsgTypeDisplay());
+    if (!recordmt.GetMsgTypeDisplay().empty())
+        msgTypeDisplay = QString::fromStdString(recordmt.GetMsgTypeDisplay());
 //          msgTypeDisplay = MTContactHandler::Encode(QString::fromStdString(recordmt.GetMsgTypeDisplay()));
-        // ---------------------------------
-        time64_t tDate = static_cast<time64_t>(opentxs::OTAPI_Wrap::It()->StringToLong(recordmt.GetDate()));
-        // ---------------------------------
-        std::string str_mailDescription;
-        recordmt.FormatMailSubject(str_mailDescription);
-        QString mailDescription;
+    // ---------------------------------
+    time64_t tDate = static_cast<time64_t>(opentxs::OTAPI_Wrap::It()->StringToLong(recordmt.GetDate()));
+    // ---------------------------------
+    std::string str_mailDescription;
+    recordmt.FormatMailSubject(str_mailDescription);
+    QString mailDescription;
 
-        if (!str_mailDescription.empty())
-            mailDescription = MTContactHandler::Encode(QString::fromStdString(str_mailDescription));
-        // ---------------------------------
-        const int nFolder = recordmt.IsOutgoing() ? 0 : 1; // 0 for moneychanger's outbox, and 1 for inbox.
-        // ---------------------------------
-        pModel->database().transaction();
-        // ---------------------------------
-        // ADD THE RECORD HERE.
-        //
-        QSqlRecord record = pModel->record();
-
-        record.setGenerated("message_id", true);
-
-        if (!myNymID.isEmpty())
-            record.setValue("my_nym_id", myNymID);
-        if (!myAddress.isEmpty())
-            record.setValue("my_address", myAddress);
-        if (!senderNymID.isEmpty())
-            record.setValue("sender_nym_id", senderNymID);
-        if (!senderAddress.isEmpty())
-            record.setValue("sender_address", senderAddress);
-        if (!recipientNymID.isEmpty())
-            record.setValue("recipient_nym_id", recipientNymID);
-        if (!recipientAddress.isEmpty())
-            record.setValue("recipient_address", recipientAddress);
-        if (!msgType.isEmpty())
-            record.setValue("method_type",  msgType);
-        if (!msgTypeDisplay.isEmpty())
-            record.setValue("method_type_display", msgTypeDisplay);
-        if (!notaryID.isEmpty())
-            record.setValue("notary_id", notaryID);
-        record.setValue("timestamp", QVariant::fromValue(tDate));
-        record.setValue("have_read", recordmt.IsOutgoing() ? 1 : 0);
-        record.setValue("have_replied", 0);
-        record.setValue("have_forwarded", 0);
-        if (!mailDescription.isEmpty())
-            record.setValue("subject", mailDescription);
-        record.setValue("folder", nFolder);
-
-        pModel->insertRecord(0, record);
-        // ---------------------------------
-        if (pModel->submitAll())
-        {
-            if (pModel->database().commit())
-            {
-                // Success.
-                bSuccessAddingMsg = true;
-                qstrBody = QString::fromStdString(recordmt.GetContents());
-            }
-        }
-        else
-        {
-            pModel->database().rollback();
-            qDebug() << "Database Write Error" <<
-                       "The database reported an error: " <<
-                       pModel->lastError().text();
-        }
-    }
-    // ------------------------------------------------
-    if (bSuccessAddingMsg)
+    if (!str_mailDescription.empty())
+        mailDescription = MTContactHandler::Encode(QString::fromStdString(str_mailDescription));
+    // ---------------------------------
+    const int nFolder = recordmt.IsOutgoing() ? 0 : 1; // 0 for moneychanger's outbox, and 1 for inbox.
+    // ---------------------------------
+    MTRecordArchiver::mapColumnValues mapFinalValues;
+
+    if (!myNymID.isEmpty())
+        mapFinalValues.insert("my_nym_id", myNymID);
+    if (!myAddress.isEmpty())
+        mapFinalValues.insert("my_address", myAddress);
+    if (!senderNymID.isEmpty())
+        mapFinalValues.insert("sender_nym_id", senderNymID);
+    if (!senderAddress.isEmpty())
+        mapFinalValues.insert("sender_address", senderAddress);
+    if (!recipientNymID.isEmpty())
+        mapFinalValues.insert("recipient_nym_id", recipientNymID);
+    if (!recipientAddress.isEmpty())
+        mapFinalValues.insert("recipient_address", recipientAddress);
+    if (!msgType.isEmpty())
+        mapFinalValues.insert("method_type",  msgType);
+    if (!msgTypeDisplay.isEmpty())
+        mapFinalValues.insert("method_type_display", msgTypeDisplay);
+    if (!notaryID.isEmpty())
+        mapFinalValues.insert("notary_id", notaryID);
+    mapFinalValues.insert("timestamp", QVariant::fromValue(tDate));
+    mapFinalValues.insert("have_read", recordmt.IsOutgoing() ? 1 : 0);
+    mapFinalValues.insert("have_replied", 0);
+    mapFinalValues.insert("have_forwarded", 0);
+    if (!mailDescription.isEmpty())
+        mapFinalValues.insert("subject", mailDescription);
+    mapFinalValues.insert("folder", nFolder);
+    // ---------------------------------
+    archiver.addMessage(nRecordIndex, mapFinalValues, QString::fromStdString(recordmt.GetContents()));
+}
+
+// Once a special mail (probably a bitmessage) is safely in our database, we
+// delete it from its native source.
+//
+bool Moneychanger::DeleteSpecialMailFromSource(opentxs::OTRecord& recordmt)
+{
+    bool bSuccessDeletingSpecial = true;
+
+    if (recordmt.IsSpecialMail())
     {
-        if (!MTContactHandler::getInstance()->CreateMessageBody(qstrBody))
-        {
-            qDebug() << "AddMailToMsgArchive: Succeeded adding message record to database, but then failed writing message body.\n";
-            return false;
-        }
-        // -------------------------------------------------------
-        // Now that we've added it to our database, we need to delete it from Bitmessage.
-        bool bSuccessDeletingSpecial = true;
+        bSuccessDeletingSpecial = false;
 
-        if (recordmt.IsSpecialMail())
+        int32_t     nMethodID   = recordmt.GetMethodID();
+        std::string strMsgID    = recordmt.GetMsgID();
+        std::string strMsgType  = recordmt.GetMsgType();
+
+        if ((nMethodID > 0) && !strMsgID.empty())
         {
-            bSuccessDeletingSpecial = false;
+            // Get the comm string for this message ID.
 
-            int32_t     nMethodID   = recordmt.GetMethodID();
-            std::string strMsgID    = recordmt.GetMsgID();
-            std::string strMsgType  = recordmt.GetMsgType();
+            QString qstrConnect = MTContactHandler::getInstance()->GetMethodConnectStr(static_cast<int>(nMethodID));
 
-            if ((nMethodID > 0) && !strMsgID.empty())
+            // Then find the NetworkModule based on the comm string:
+            //
+            if (!qstrConnect.isEmpty())
             {
-                // Get the comm string for this message ID.
+                NetworkModule * pModule = MTComms::find(qstrConnect.toStdString());
 
-                QString qstrConnect = MTContactHandler::getInstance()->GetMethodConnectStr(static_cast<int>(nMethodID));
-
-                // Then find the NetworkModule based on the comm string:
+                // Use net module to delete msg ID
                 //
-                if (!qstrConnect.isEmpty())
+                if (NULL != pModule)
                 {
-                    NetworkModule * pModule = MTComms::find(qstrConnect.toStdString());
-
-                    // Use net module to delete msg ID
-                    //
-                    if (NULL != pModule)
+                    if (recordmt.IsOutgoing())
                     {
-                        if (recordmt.IsOutgoing())
-                        {
-                            if (pModule->deleteOutMessage(strMsgID))
-                                bSuccessDeletingSpecial = true;
-                        }
-                        else // incoming
-                        {
-                            if (pModule->deleteMessage(strMsgID))
-                                bSuccessDeletingSpecial = true;
-                        }
+                        if (pModule->deleteOutMessage(strMsgID))
+                            bSuccessDeletingSpecial = true;
+                    }
+                    else // incoming
+                    {
+                        if (pModule->deleteMessage(strMsgID))
+                            bSuccessDeletingSpecial = true;
                     }
                 }
             }
-        } // special mail
+        }
+    } // special mail
 
-        if (!bSuccessDeletingSpecial)
-            qDebug() << "AddMailToMsgArchive: FYI, Failed while trying to delete special mail (probably bitmessage) from its native source.";
-        else
-            qDebug() << "AddMailToMsgArchive: FYI, SUCCESS deleting special mail (probably bitmessage) from its native source.";
-        // -----------------------------------
-    }
+    if (!bSuccessDeletingSpecial)
+        qDebug() << "DeleteSpecialMailFromSource: FYI, Failed while trying to delete special mail (probably bitmessage) from its native source.";
+    else
+        qDebug() << "DeleteSpecialMailFromSource: FYI, SUCCESS deleting special mail (probably bitmessage) from its native source.";
 
-    return bSuccessAddingMsg;
+    return bSuccessDeletingSpecial;
 }
 
 
 
 
+// MTNameLookupQT queues notifications here when they come from the populator thread.
+//
+void Moneychanger::onSuccessfulNotarization(QString qstrAcctId, QString qstrNymId, QString qstrNotaryId,
+                                            QString qstrTxnContents, qint64 lTransactionNum, qint64 lTransNumForDisplay)
+{
+    int64_t lTransNum        = static_cast<int64_t>(lTransactionNum);
+    int64_t lTransNumDisplay = static_cast<int64_t>(lTransNumForDisplay);
+
+    AddPaymentBasedOnNotification(qstrAcctId.toStdString(), qstrNymId.toStdString(), qstrNotaryId.toStdString(),
+                                  qstrTxnContents.toStdString(), lTransNum, lTransNumDisplay);
+}
+
 void Moneychanger::AddPaymentBasedOnNotification(const std::string & str_acct_id,
                                                  const std::string & p_nym_id,
                                                  const std::string & p_notary_id,
@@ -2700,276 +2585,198 @@ void Moneychanger::AddPaymentBasedOnNotification(const std::string & str_acct_id
     }
 }
 
-// Adds or updates.
+// Adds or updates (when the archiver commits.)
 // The payment archive stores up to multiple receipts per record.
 // The primary key is the "display txn ID"
 //
-bool Moneychanger::AddPaymentToPmntArchive(opentxs::OTRecord& recordmt, const bool bCanDeleteRecord/*=true*/)
+void Moneychanger::QueuePaymentForArchive(MTRecordArchiver & archiver, opentxs::OTRecord& recordmt, int nRecordIndex,
+                                          const bool bCanDeleteRecord/*=true*/)
 {
     ModelPayments::PaymentFlags flags = ModelPayments::NoFlags;
 
-    QPointer<ModelPayments> pModel = DBHandler::getInstance()->getPaymentModel();
-    bool bSuccessAddingPmnt = false;
     QString qstrBody(""), qstrPendingBody("");
-    QMap<QString, QVariant> mapFinalValues;
+    MTRecordArchiver::mapColumnValues mapFinalValues, mapNewOnly;
 
-    bool bRecordAlreadyExisted = false;
-    int  nPreExistingPaymentId = 0;
-
-    if (pModel)
-    {
-        // ---------------------------------
-        if (recordmt.IsSpecialMail())           flags |= ModelPayments::IsSpecialMail;
-        if (recordmt.IsPending())               flags |= ModelPayments::IsPending;
-        if (recordmt.IsOutgoing())              flags |= ModelPayments::IsOutgoing;
-        if (recordmt.IsRecord())                flags |= ModelPayments::IsRecord;
-        if (recordmt.IsReceipt())               flags |= ModelPayments::IsReceipt;
-        if (recordmt.IsMail())                  flags |= ModelPayments::IsMail;
-        if (recordmt.IsTransfer())              flags |= ModelPayments::IsTransfer;
-        if (recordmt.IsCheque())                flags |= ModelPayments::IsCheque;
-        if (recordmt.IsInvoice())               flags |= ModelPayments::IsInvoice;
-        if (recordmt.IsVoucher())               flags |= ModelPayments::IsVoucher;
-        if (recordmt.IsContract())              flags |= ModelPayments::IsContract;
-        if (recordmt.IsPaymentPlan())           flags |= ModelPayments::IsPaymentPlan;
-        if (recordmt.IsCash())                  flags |= ModelPayments::IsCash;
-        if (recordmt.IsExpired())               flags |= ModelPayments::IsExpired;
-        if (recordmt.IsCanceled())              flags |= ModelPayments::IsCanceled;
-        if (recordmt.CanDeleteRecord())         flags |= ModelPayments::CanDelete;
-        if (recordmt.CanAcceptIncoming())       flags |= ModelPayments::CanAcceptIncoming;
-        if (recordmt.CanDiscardIncoming())      flags |= ModelPayments::CanDiscardIncoming;
-        if (recordmt.CanCancelOutgoing())       flags |= ModelPayments::CanCancelOutgoing;
-        if (recordmt.CanDiscardOutgoingCash())  flags |= ModelPayments::CanDiscardOutgoingCash;
-        // ---------------------------------
-        QString myNymID;
-        if (!recordmt.GetNymID().empty())
-            myNymID = QString::fromStdString(recordmt.GetNymID());
-        // ---------------------------------
-        QString myAcctID;
-        if (!recordmt.GetAccountID().empty())
-            myAcctID = QString::fromStdString(recordmt.GetAccountID());
-        // ---------------------------------
-        QString instrumentType;
-        if (!recordmt.GetInstrumentType().empty())
-            instrumentType = QString::fromStdString(recordmt.GetInstrumentType());
-        // ---------------------------------
-        QString myAssetTypeID;
-        if (!recordmt.GetInstrumentDefinitionID().empty())
-            myAssetTypeID = QString::fromStdString(recordmt.GetInstrumentDefinitionID());
-        // ---------------------------------
-        QString myAddress;
-        if (!recordmt.GetAddress().empty())
-            myAddress = QString::fromStdString(recordmt.GetAddress());
+    // ---------------------------------
+    if (recordmt.IsSpecialMail())           flags |= ModelPayments::IsSpecialMail;
+    if (recordmt.IsPending())               flags |= ModelPayments::IsPending;
+    if (recordmt.IsOutgoing())              flags |= ModelPayments::IsOutgoing;
+    if (recordmt.IsRecord())                flags |= ModelPayments::IsRecord;
+    if (recordmt.IsReceipt())               flags |= ModelPayments::IsReceipt;
+    if (recordmt.IsMail())                  flags |= ModelPayments::IsMail;
+    if (recordmt.IsTransfer())              flags |= ModelPayments::IsTransfer;
+    if (recordmt.IsCheque())                flags |= ModelPayments::IsCheque;
+    if (recordmt.IsInvoice())               flags |= ModelPayments::IsInvoice;
+    if (recordmt.IsVoucher())               flags |= ModelPayments::IsVoucher;
+    if (recordmt.IsContract())              flags |= ModelPayments::IsContract;
+    if (recordmt.IsPaymentPlan())           flags |= ModelPayments::IsPaymentPlan;
+    if (recordmt.IsCash())                  flags |= ModelPayments::IsCash;
+    if (recordmt.IsExpired())               flags |= ModelPayments::IsExpired;
+    if (recordmt.IsCanceled())              flags |= ModelPayments::IsCanceled;
+    if (recordmt.CanDeleteRecord())         flags |= ModelPayments::CanDelete;
+    if (recordmt.CanAcceptIncoming())       flags |= ModelPayments::CanAcceptIncoming;
+    if (recordmt.CanDiscardIncoming())      flags |= ModelPayments::CanDiscardIncoming;
+    if (recordmt.CanCancelOutgoing())       flags |= ModelPayments::CanCancelOutgoing;
+    if (recordmt.CanDiscardOutgoingCash())  flags |= ModelPayments::CanDiscardOutgoingCash;
+    // ---------------------------------
+    QString myNymID;
+    if (!recordmt.GetNymID().empty())
+        myNymID = QString::fromStdString(recordmt.GetNymID());
+    // ---------------------------------
+    QString myAcctID;
+    if (!recordmt.GetAccountID().empty())
+        myAcctID = QString::fromStdString(recordmt.GetAccountID());
+    // ---------------------------------
+    QString instrumentType;
+    if (!recordmt.GetInstrumentType().empty())
+        instrumentType = QString::fromStdString(recordmt.GetInstrumentType());
+    // ---------------------------------
+    QString myAssetTypeID;
+    if (!recordmt.GetInstrumentDefinitionID().empty())
+        myAssetTypeID = QString::fromStdString(recordmt.GetInstrumentDefinitionID());
+    // ---------------------------------
+    QString myAddress;
+    if (!recordmt.GetAddress().empty())
+        myAddress = QString::fromStdString(recordmt.GetAddress());
 //          myAddress = MTContactHandler::Encode(QString::fromStdString(recordmt.GetAddress()));
-        // ---------------------------------
-        QString senderNymID,    senderAccountID,    senderAddress,
-                recipientNymID, recipientAccountID, recipientAddress;
+    // ---------------------------------
+    QString senderNymID,    senderAccountID,    senderAddress,
+            recipientNymID, recipientAccountID, recipientAddress;
 
-        if (recordmt.IsOutgoing())
-        {
-            if (!recordmt.GetOtherNymID().empty())
-                recipientNymID = QString::fromStdString(recordmt.GetOtherNymID());
+    if (recordmt.IsOutgoing())
+    {
+        if (!recordmt.GetOtherNymID().empty())
+            recipientNymID = QString::fromStdString(recordmt.GetOtherNymID());
 
-            if (!recordmt.GetOtherAccountID().empty())
-                recipientAccountID = QString::fromStdString(recordmt.GetOtherAccountID());
+        if (!recordmt.GetOtherAccountID().empty())
+            recipientAccountID = QString::fromStdString(recordmt.GetOtherAccountID());
 
-            if (!recordmt.GetOtherAddress().empty())
-                recipientAddress = QString::fromStdString(recordmt.GetOtherAddress());
+        if (!recordmt.GetOtherAddress().empty())
+            recipientAddress = QString::fromStdString(recordmt.GetOtherAddress());
 //              recipientAddress = MTContactHandler::Encode(QString::fromStdString(recordmt.GetOtherAddress()));
-        }
-        else
-        {
-            if (!recordmt.GetOtherNymID().empty())
-                senderNymID = QString::fromStdString(recordmt.GetOtherNymID());
+    }
+    else
+    {
+        if (!recordmt.GetOtherNymID().empty())
+            senderNymID = QString::fromStdString(recordmt.GetOtherNymID());
 
-            if (!recordmt.GetOtherAccountID().empty())
-                senderAccountID = QString::fromStdString(recordmt.GetOtherAccountID());
+        if (!recordmt.GetOtherAccountID().empty())
+            senderAccountID = QString::fromStdString(recordmt.GetOtherAccountID());
 
-            if (!recordmt.GetOtherAddress().empty())
-                senderAddress = QString::fromStdString(recordmt.GetOtherAddress());
+        if (!recordmt.GetOtherAddress().empty())
+            senderAddress = QString::fromStdString(recordmt.GetOtherAddress());
 //              senderAddress = MTContactHandler::Encode(QString::fromStdString(recordmt.GetOtherAddress()));
-        }
-        // ---------------------------------
-        QString notaryID, msgType, msgTypeDisplay;
+    }
+    // ---------------------------------
+    QString notaryID, msgType, msgTypeDisplay;
 
-        if (!recordmt.GetNotaryID().empty())
-            notaryID = QString::fromStdString(recordmt.GetNotaryID());
+    if (!recordmt.GetNotaryID().empty())
+        notaryID = QString::fromStdString(recordmt.GetNotaryID());
 
-        if (!recordmt.GetMsgType().empty())
-            msgType = QString::fromStdString(recordmt.GetMsgType());
+    if (!recordmt.GetMsgType().empty())
+        msgType = QString::fromStdString(recordmt.GetMsgType());
 //          msgType = MTContactHandler::Encode(QString::fromStdString(recordmt.GetMsgType()));
 
-        if (!recordmt.GetMsgTypeDisplay().empty())
-            msgTypeDisplay = QString::fromStdString(recordmt.GetMsgTypeDisplay());
+    if (!recordmt.GetMsgTypeDisplay().empty())
+        msgTypeDisplay = QString::fromStdString(recordmt.GetMsgTypeDisplay());
 //          msgTypeDisplay = MTContactHandler::Encode(QString::fromStdString(recordmt.GetMsgTypeDisplay()));
-        // ---------------------------------
-        time64_t tDate = static_cast<time64_t>(opentxs::OTAPI_Wrap::It()->StringToLong(recordmt.GetDate()));
+    // ---------------------------------
+    time64_t tDate = static_cast<time64_t>(opentxs::OTAPI_Wrap::It()->StringToLong(recordmt.GetDate()));
 
-        int64_t transNum        = recordmt.GetTransactionNum();
-        int64_t transNumDisplay = recordmt.GetTransNumForDisplay();
+    int64_t transNum        = recordmt.GetTransactionNum();
+    int64_t transNumDisplay = recordmt.GetTransNumForDisplay();
 
-        int64_t lAmount = opentxs::OTAPI_Wrap::It()->StringToLong(recordmt.GetAmount());
+    int64_t lAmount = opentxs::OTAPI_Wrap::It()->StringToLong(recordmt.GetAmount());
 
 //      qDebug() << "DEBUGGING! recordmt.GetAmount(): " << QString::fromStdString(recordmt.GetAmount())
 //               << " lAmount: " << lAmount << "\n";
 
-        int nPending   = recordmt.CanDeleteRecord() ? 0 : 1;
-        int nCompleted = recordmt.CanDeleteRecord() ? 1 : 0;
-        // ---------------------------------
-        std::string str_Name = recordmt.GetName();
-        QString qstrName;
-        if (!str_Name.empty())
-            qstrName = MTContactHandler::Encode(QString::fromStdString(str_Name));
-        // ---------------------------------
-        std::string str_Memo = recordmt.HasMemo() ? recordmt.GetMemo() : "";
-        QString qstrMemo;
-        if (!str_Memo.empty())
-            qstrMemo = MTContactHandler::Encode(QString::fromStdString(str_Memo));
-        // ---------------------------------
-        std::string str_mailDescription;
-        recordmt.FormatDescription(str_mailDescription);
-        QString mailDescription;
-
-        if (!str_mailDescription.empty())
-            mailDescription = MTContactHandler::Encode(QString::fromStdString(str_mailDescription));
-        // ---------------------------------
-        const int nFolder = recordmt.IsOutgoing() ? 0 : 1; // 0 for moneychanger's outbox, and 1 for inbox.
-        // ---------------------------------
-        // First let's see if a record already exists:
-        //
-        nPreExistingPaymentId = MTContactHandler::getInstance()->GetPaymentIdByTxnDisplayId(transNumDisplay, myNymID);
-        bRecordAlreadyExisted = (nPreExistingPaymentId > 0);
-        // ------------------------------------------
-        // We'll start by putting all the values into our map,
-        // so we can then use that map when creating or updating
-        // database records.
-        //
-        // if (bRecordAlreadyExisted) mapFinalValues.insert("payment_id", nPreExistingPaymentId);
-        // Note: No need to insert this one.
-
-        if (!myNymID.isEmpty()) mapFinalValues.insert("my_nym_id", myNymID);
-        if (!myAcctID.isEmpty()) mapFinalValues.insert("my_acct_id", myAcctID);
-        if (!myAssetTypeID.isEmpty()) mapFinalValues.insert("my_asset_type_id", myAssetTypeID);
-        if (!myAddress.isEmpty()) mapFinalValues.insert("my_address", myAddress);
-        if (!senderNymID.isEmpty()) mapFinalValues.insert("sender_nym_id", senderNymID);
-        if (!senderAccountID.isEmpty()) mapFinalValues.insert("sender_acct_id", senderAccountID);
-        if (!senderAddress.isEmpty()) mapFinalValues.insert("sender_address", senderAddress);
-        if (!recipientNymID.isEmpty()) mapFinalValues.insert("recipient_nym_id", recipientNymID);
-        if (!recipientAccountID.isEmpty()) mapFinalValues.insert("recipient_acct_id", recipientAccountID);
-        if (!recipientAddress.isEmpty()) mapFinalValues.insert("recipient_address", recipientAddress);
-
-        if (transNum > 0)        mapFinalValues.insert("txn_id", QVariant::fromValue(transNum));
-        if (transNumDisplay > 0) mapFinalValues.insert("txn_id_display", QVariant::fromValue(transNumDisplay));
-
-
-//      qDebug() << "DEBUGGING AddPaymentToPmntArchive. " << (recordmt.IsOutgoing() ? "OUT" : "IN") << ". transNum: " << transNum << " transNumDisplay: " << transNumDisplay << "\n";
+    int nPending   = recordmt.CanDeleteRecord() ? 0 : 1;
+    int nCompleted = recordmt.CanDeleteRecord() ? 1 : 0;
+    // ---------------------------------
+    std::string str_Name = recordmt.GetName();
+    QString qstrName;
+    if (!str_Name.empty())
+        qstrName = MTContactHandler::Encode(QString::fromStdString(str_Name));
+    // ---------------------------------
+    std::string str_Memo = recordmt.HasMemo() ? recordmt.GetMemo() : "";
+    QString qstrMemo;
+    if (!str_Memo.empty())
+        qstrMemo = MTContactHandler::Encode(QString::fromStdString(str_Memo));
+    // ---------------------------------
+    std::string str_mailDescription;
+    recordmt.FormatDescription(str_mailDescription);
+    QString mailDescription;
 
-        // I receive a cheque. This is the incoming cheque I'm receiving.
+    if (!str_mailDescription.empty())
+        mailDescription = MTContactHandler::Encode(QString::fromStdString(str_mailDescription));
+    // ---------------------------------
+    const int nFolder = recordmt.IsOutgoing() ? 0 : 1; // 0 for moneychanger's outbox, and 1 for inbox.
+    // ---------------------------------
+    // We'll start by putting all the values into our map,
+    // so the archiver can use that map when creating or updating
+    // database records. (It looks up whether the record already
+    // exists, for the whole batch at once.)
+    //
+    if (!myNymID.isEmpty()) mapFinalValues.insert("my_nym_id", myNymID);
+    if (!myAcctID.isEmpty()) mapFinalValues.insert("my_acct_id", myAcctID);
+    if (!myAssetTypeID.isEmpty()) mapFinalValues.insert("my_asset_type_id", myAssetTypeID);
+    if (!myAddress.isEmpty()) mapFinalValues.insert("my_address", myAddress);
+    if (!senderNymID.isEmpty()) mapFinalValues.insert("sender_nym_id", senderNymID);
+    if (!senderAccountID.isEmpty()) mapFinalValues.insert("sender_acct_id", senderAccountID);
+    if (!senderAddress.isEmpty()) mapFinalValues.insert("sender_address", senderAddress);
+    if (!recipientNymID.isEmpty()) mapFinalValues.insert("recipient_nym_id", recipientNymID);
+    if (!recipientAccountID.isEmpty()) mapFinalValues.insert("recipient_acct_id", recipientAccountID);
+    if (!recipientAddress.isEmpty()) mapFinalValues.insert("recipient_address", recipientAddress);
 
+    if (transNum > 0)        mapFinalValues.insert("txn_id", QVariant::fromValue(transNum));
+    if (transNumDisplay > 0) mapFinalValues.insert("txn_id_display", QVariant::fromValue(transNumDisplay));
 
-        if (lAmount != 0)        mapFinalValues.insert("amount", QVariant::fromValue(lAmount));
-        if (tDate > 0)           mapFinalValues.insert("timestamp", QVariant::fromValue(tDate));
 
-        if (nPending   > 0) mapFinalValues.insert("pending_found",   QVariant::fromValue(nPending));
-        if (nCompleted > 0) mapFinalValues.insert("completed_found", QVariant::fromValue(nCompleted));
+//      qDebug() << "DEBUGGING QueuePaymentForArchive. " << (recordmt.IsOutgoing() ? "OUT" : "IN") << ". transNum: " << transNum << " transNumDisplay: " << transNumDisplay << "\n";
 
-        if (!msgType.isEmpty()) mapFinalValues.insert("method_type", msgType);
-        if (!msgTypeDisplay.isEmpty()) mapFinalValues.insert("method_type_display", msgTypeDisplay);
-        if (!notaryID.isEmpty()) mapFinalValues.insert("notary_id", notaryID);
-        if (!qstrMemo.isEmpty()) mapFinalValues.insert("memo", qstrMemo);
-        if (!mailDescription.isEmpty()) mapFinalValues.insert("description", mailDescription);
-        if (!qstrName.isEmpty()) mapFinalValues.insert("record_name", qstrName);
-        if (!instrumentType.isEmpty()) mapFinalValues.insert("instrument_type", instrumentType);
+    // I receive a cheque. This is the incoming cheque I'm receiving.
 
-        if (!bRecordAlreadyExisted) mapFinalValues.insert("have_read", QVariant::fromValue(recordmt.IsOutgoing() ? 1 : 0));
-        if (!bRecordAlreadyExisted) mapFinalValues.insert("have_replied", QVariant::fromValue(0));
-        if (!bRecordAlreadyExisted) mapFinalValues.insert("have_forwarded", QVariant::fromValue(0));
-
-        qint64 storedFlags = (qint64)flags;
-        mapFinalValues.insert("folder", QVariant::fromValue(nFolder));
-        mapFinalValues.insert("flags", QVariant::fromValue(storedFlags));
-        // -------------------------------------------------
-        if (!bCanDeleteRecord) qstrPendingBody = QString::fromStdString(recordmt.GetContents());
-        else                   qstrBody        = QString::fromStdString(recordmt.GetContents());
-        // -------------------------------------------------
-        if (bRecordAlreadyExisted)
-        {
-            // Success.
-            if (MTContactHandler::getInstance()->UpdatePaymentRecord(nPreExistingPaymentId, mapFinalValues))
-            {
-                bSuccessAddingPmnt = true;
 
-                pModel->select(); // Reset the model since we just inserted a new record.
-                // AH WAIT!!! We don't want to do this for EVERY record inserted, do we?
-                // Just the LAST ONE.
-                // TODO!
-            }
-        }
-        else // Record doesn't already exist in the database.
-        {    // In that case we can use some code we already had:
+    if (lAmount != 0)        mapFinalValues.insert("amount", QVariant::fromValue(lAmount));
+    if (tDate > 0)           mapFinalValues.insert("timestamp", QVariant::fromValue(tDate));
 
-            pModel->database().transaction();
-            // ---------------------------------
-            QSqlRecord record = pModel->record();
-            record.setGenerated("payment_id", true);
-            // ---------------------------------
-            for (QMap<QString, QVariant>::iterator it_map = mapFinalValues.begin();
-                 it_map != mapFinalValues.end(); ++it_map)
-            {
-                const QString  & qstrKey = it_map.key();
-                const QVariant & qValue  = it_map.value();
+    if (nPending   > 0) mapFinalValues.insert("pending_found",   QVariant::fromValue(nPending));
+    if (nCompleted > 0) mapFinalValues.insert("completed_found", QVariant::fromValue(nCompleted));
 
-                record.setValue(qstrKey, qValue);
-            }
+    if (!msgType.isEmpty()) mapFinalValues.insert("method_type", msgType);
+    if (!msgTypeDisplay.isEmpty()) mapFinalValues.insert("method_type_display", msgTypeDisplay);
+    if (!notaryID.isEmpty()) mapFinalValues.insert("notary_id", notaryID);
+    if (!qstrMemo.isEmpty()) mapFinalValues.insert("memo", qstrMemo);
+    if (!mailDescription.isEmpty()) mapFinalValues.insert("description", mailDescription);
+    if (!qstrName.isEmpty()) mapFinalValues.insert("record_name", qstrName);
+    if (!instrumentType.isEmpty()) mapFinalValues.insert("instrument_type", instrumentType);
 
-            pModel->insertRecord(0, record);
-            // ---------------------------------
-            if (pModel->submitAll())
-            {
-                // Success.
-                if (pModel->database().commit())
-                    bSuccessAddingPmnt = true;
-            }
-            else
-            {
-                pModel->database().rollback();
-                qDebug() << "Database Write Error" <<
-                           "The database reported an error: " <<
-                           pModel->lastError().text();
-            }
-        } // Record didn't already exist. (Adding new.)
-    } // if pModel
-    // ------------------------------------------------
-    if (bSuccessAddingPmnt)
-    {
-        qDebug() << "AddPaymentToPmntArchive: Succeeded adding payment record to database.\n";
+    // Only for new records:
+    mapNewOnly.insert("have_read", QVariant::fromValue(recordmt.IsOutgoing() ? 1 : 0));
+    mapNewOnly.insert("have_replied", QVariant::fromValue(0));
+    mapNewOnly.insert("have_forwarded", QVariant::fromValue(0));
 
-        if (bRecordAlreadyExisted)
-        {
-            if (!MTContactHandler::getInstance()->UpdatePaymentBody(nPreExistingPaymentId, qstrBody, qstrPendingBody))
-            {
-                qDebug() << "AddPaymentToPmntArchive: ...but then failed updating payment body and/or pending body.\n";
-                return false;
-            }
-        }
-        // ------------------------
-        else
-        {
-            if (!MTContactHandler::getInstance()->CreatePaymentBody(qstrBody, qstrPendingBody))
-            {
-                qDebug() << "AddPaymentToPmntArchive: ...but then failed creating payment body and/or pending body.\n";
-                return false;
-            }
-        }
-    }
+    qint64 storedFlags = (qint64)flags;
+    mapFinalValues.insert("folder", QVariant::fromValue(nFolder));
+    mapFinalValues.insert("flags", QVariant::fromValue(storedFlags));
+    // -------------------------------------------------
+    if (!bCanDeleteRecord) qstrPendingBody = QString::fromStdString(recordmt.GetContents());
+    else                   qstrBody        = QString::fromStdString(recordmt.GetContents());
     // ------------------------------------------------
-    return bSuccessAddingPmnt;
+    archiver.addPayment(nRecordIndex, mapFinalValues, mapNewOnly, qstrBody, qstrPendingBody);
 }
 
 
 
-void Moneychanger::modifyRecords()
+// Returns true if any records were deleted from the record box, in which case
+// theList is out of date and has to be populated again.
+//
+bool Moneychanger::modifyRecords(opentxs::OTRecordList & theList)
 {
-    const int listSize = GetRecordlist().size();
+    MTRecordArchiver archiver;
+
+    const int listSize = theList.size();
     // -------------------------------------------------------
     // Delete the market receipts (since they are already archived in other places)
     // and find any finalReceipts that correspond to those, so we can add them
@@ -2981,7 +2788,7 @@ void Moneychanger::modifyRecords()
     {
         const int nIndex = listSize - ii - 1; // We iterate through the list in reverse. (Since we'll be deleting stuff.)
 
-        opentxs::OTRecord record = GetRecordlist().GetRecord(nIndex);
+        opentxs::OTRecord record = theList.GetRecord(nIndex);
         {
             opentxs::OTRecord& recordmt = record;
 
@@ -2993,7 +2800,7 @@ void Moneychanger::modifyRecords()
                 if (!recordmt.IsMail() &&
                     !recordmt.IsSpecialMail() &&
                     !recordmt.IsExpired() )
-                    AddPaymentToPmntArchive(recordmt);
+                    QueuePaymentForArchive(archiver, recordmt, -1); // -1 since it stays in the record box.
 
             }
             else // record can be deleted.
@@ -3008,13 +2815,12 @@ void Moneychanger::modifyRecords()
                 // Meanwhile, for all marketReceipts, we just deleting them since they
                 // are ALREADY in the trade_archive table.
                 //
-                // -----------------------------------
-                bool bShouldDeleteRecord = false;
+                // Any record that the archiver successfully writes to the database
+                // is then deleted, below.
                 // -----------------------------------
                 if (recordmt.IsMail() || recordmt.IsSpecialMail())
                 {
-                    if (AddMailToMsgArchive(recordmt))
-                        bShouldDeleteRecord = true;
+                    QueueMailForArchive(archiver, recordmt, nIndex);
                 }
                 // -----------------------------------
                 else if (recordmt.IsRecord() && !recordmt.IsExpired())
@@ -3030,7 +2836,7 @@ void Moneychanger::modifyRecords()
                             // receipt records so the user doesn't have the hassle of deleting them himself.
                             // Now they are safe in his archive and he can do whatever he wants with them.
 
-                            bShouldDeleteRecord = true;
+                            archiver.addArchivedRecord(nIndex);
                         } // marketReceipt
                         // -----------------------------------
                         else if (0 == recordmt.GetInstrumentType().compare("finalReceipt"))
@@ -3056,13 +2862,12 @@ void Moneychanger::modifyRecords()
                             // not be a finalReceipt for a market offer! It might correspond to
                             // a smart contract or a recurring payment plan.
                             //
-                            if (AddFinalReceiptToTradeArchive(recordmt))
-                                bShouldDeleteRecord = true;
+                            archiver.addFinalReceipt(nIndex, recordmt.GetTransNumForDisplay(),
+                                                     QString::fromStdString(recordmt.GetContents()));
                         } // finalReceipt
                         else // All  other closed (deletable) receipts.
                         {
-                            if (AddPaymentToPmntArchive(recordmt))
-                                bShouldDeleteRecord = true;
+                            QueuePaymentForArchive(archiver, recordmt, nIndex);
                         }
                     }
                     // -----------------------------------
@@ -3080,30 +2885,49 @@ void Moneychanger::modifyRecords()
                         // table, which has potentially up to 3 different receipts for the same trade record. (Market receipt
                         // for asset and currency accounts, plus final receipt.)
                         //
-                        if (AddPaymentToPmntArchive(recordmt))
-                            bShouldDeleteRecord = true;
+                        QueuePaymentForArchive(archiver, recordmt, nIndex);
                     }
                 } // else if (recordmt.IsRecord() && !recordmt.IsExpired())
-                // -----------------------------------
-                if (bShouldDeleteRecord)
-                {
-                    if (recordmt.DeleteRecord())
-                    {
-                        bool bRemoved = GetRecordlist().RemoveRecord(nIndex);
-
-                        if (!bRemoved)
-                            qDebug() << "Moneychanger::modifyRecords: weird issue trying to remove deleted record from GetRecordlist() (record list.)\n";
-                    }
-                }
             } // Record can be deleted.
         }
-    } // for (GetRecordlist() in reverse)
+    } // for (theList in reverse)
+    // -------------------------------------
+    if (archiver.isEmpty())
+        return false;
     // -------------------------------------
-    // If the above process DID remove any records, then we have to repopulate them now,
-    // since every record contains its index, and so they will be wrong until re-populated.
+    // Everything goes into the database in one transaction. If that fails, nothing
+    // gets deleted, and the same records will be archived on the next pass.
     //
-    if (listSize != GetRecordlist().size())
-        populateRecords();
+    if (!archiver.commit())
+        qDebug() << "Moneychanger::modifyRecords: failed writing the archived records to the database.\n";
+
+    QPointer<ModelPayments> pPaymentModel = DBHandler::getInstance()->getPaymentModel();
+    QPointer<ModelMessages> pMessageModel = DBHandler::getInstance()->getMessageModel();
+    QPointer<ModelTradeArchive> pTradeModel = DBHandler::getInstance()->getTradeArchiveModel();
+
+    if (pPaymentModel) pPaymentModel->select(); // Once for the whole batch, instead of once per record.
+    if (pMessageModel) pMessageModel->select();
+    if (pTradeModel)   pTradeModel->select();
+    // -------------------------------------
+    // Now delete the archived records from OT, highest index first, so the
+    // indices of the ones we haven't gotten to yet are still good.
+    //
+    bool bDeletedAny = false;
+
+    const std::vector<int> vecArchived = archiver.archivedRecords();
+
+    for (std::vector<int>::const_iterator it = vecArchived.begin(); it != vecArchived.end(); ++it)
+    {
+        opentxs::OTRecord recordmt = theList.GetRecord(*it);
+
+        if (recordmt.IsSpecialMail())
+            DeleteSpecialMailFromSource(recordmt);
+
+        if (recordmt.DeleteRecord())
+            bDeletedAny = true;
+    }
+
+    return bDeletedAny;
 }
 
 
@@ -3214,12 +3038,53 @@ void Moneychanger::onNeedToDownloadSingleAcct(QString qstrAcctID, QString qstrOp
 
 // ----------------------------------------------------------------
 
+// This updates the record list. (It assumes a download has recently occurred.)
+// The work happens on the populator thread; requests that come in while it's
+// busy are folded into one more run after it finishes.
+//
 void Moneychanger::onNeedToPopulateRecordlist()
 {
-    setupRecordList();
-    populateRecords(); // This updates the record list. (It assumes a download has recently occurred.)
+    if (m_bPopulating)
+    {
+        m_bPopulateAgain = true;
+        return;
+    }
+
+    startRecordListPopulation();
+}
+
+void Moneychanger::onRecordListReady(MTRecordListSnapshotPtr snapshot)
+{
+    if (!snapshot || (snapshot->nSequence != m_nPopulateSequence))
+        return; // Superseded.
+
+    m_bPopulating = false;
+
+    qDebug() << QString("Record list populated: %1 ms in OT, %2 ms fetching mail, %3 ms merging.")
+                .arg(snapshot->msPopulate).arg(snapshot->msFetchMail).arg(snapshot->msMerge);
+
+    emit recordListLoaded(snapshot);
     // ----------------------------------------------------------------
+    // This takes things like market receipts out of the record list
+    // and moves them to their own database table.
+    // Same thing for mail messages, etc.
+    //
+    // If that DID delete any records, then we have to populate again before anyone
+    // sees this list, since every record contains its index, and so they will be wrong
+    // until re-populated. (Just once. Whatever shows up in the meantime gets archived next time.)
+    //
+    if (!snapshot->bFollowUp && modifyRecords(*snapshot->pList))
+    {
+        startRecordListPopulation(true);
+        return;
+    }
+    // ----------------------------------------------------------------
+    m_pList = snapshot->pList; // Anyone calling GetRecordlist() gets the new list from here on.
+
     emit populatedRecordlist();
+
+    if (m_bPopulateAgain)
+        startRecordListPopulation();
 }
 
 // ----------------------------------------------------------------
@@ -4448,6 +4313,8 @@ void Moneychanger::mc_overview_dialog()
 
 void Moneychanger::onServersChanged()
 {
+    MTNameCache::getInstance()->invalidateType(MTNameCache::ServerName);
+
     // Because the Nym details page has a list of servers that Nym is registered on.
     // So if we've added a new Server, we should update that page, if it's open.
     if (nullptr != nymswindow)
@@ -4460,6 +4327,8 @@ void Moneychanger::onServersChanged()
 
 void Moneychanger::onAssetsChanged()
 {
+    MTNameCache::getInstance()->invalidateType(MTNameCache::AssetName);
+
     if (menuwindow)
         menuwindow->refreshOptions();
 }
@@ -4467,6 +4336,11 @@ void Moneychanger::onAssetsChanged()
 
 void Moneychanger::onNymsChanged()
 {
+    // Wallet Nym names feed into account and address names as well.
+    MTNameCache::getInstance()->invalidateType(MTNameCache::NymName);
+    MTNameCache::getInstance()->invalidateType(MTNameCache::AcctName);
+    MTNameCache::getInstance()->invalidateType(MTNameCache::AddressName);
+
     if (menuwindow)
         menuwindow->refreshOptions();
 }
@@ -4474,6 +4348,8 @@ void Moneychanger::onNymsChanged()
 
 void Moneychanger::onAccountsChanged()
 {
+    MTNameCache::getInstance()->invalidateType(MTNameCache::AcctName);
+
     if (menuwindow)
         menuwindow->refreshOptions();
 }
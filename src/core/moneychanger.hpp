@@ -6,6 +6,7 @@
 #include "core/TR1_Wrapper.hpp"
 
 #include <core/handlers/focuser.h>
+#include <core/recordlistpopulator.hpp>
 
 #include <opentxs/client/OTRecordList.hpp>
 
@@ -39,6 +40,8 @@ class Payments;
 class QMenu;
 class QSystemTrayIcon;
 class CreateInsuranceCompany;
+class MTRecordArchiver;
+class QThread;
 
 
 
@@ -49,7 +52,13 @@ class Moneychanger : public QWidget
 
 private:
     // ------------------------------------------------
-    opentxs::OTRecordList   m_list;
+    _SharedPtr<opentxs::OTRecordList> m_pList; // Replaced by each new list from the populator.
+    // ------------------------------------------------
+    QThread               * m_pPopulatorThread  = nullptr;
+    MTRecordListPopulator * m_pPopulator        = nullptr;
+    quint64                 m_nPopulateSequence = 0;
+    bool                    m_bPopulating       = false; // A job is out on the populator thread.
+    bool                    m_bPopulateAgain    = false; // ...and someone asked for another one meanwhile.
     // ------------------------------------------------
     /** Constructor & Destructor **/
     Moneychanger(QWidget *parent = 0);
@@ -82,18 +91,20 @@ public:
     
     opentxs::OTRecordList & GetRecordlist();
     void setupRecordList();  // Sets up the RecordList object with the IDs etc.
-    void populateRecords();  // Calls OTRecordList::Populate(), and then additionally adds records from Bitmessage, etc.
-
-    void modifyRecords(); // After we populate the recordlist, we make some changes to the list (move messages to a separate db table, move receipts to a separate table, etc.)
-    bool AddMailToMsgArchive(opentxs::OTRecord& recordmt);
-    bool AddPaymentToPmntArchive(opentxs::OTRecord& recordmt, const bool bCanDeleteRecord=true);
+    void collectRecordListIds(MTRecordListJob & job);
+    void collectMailTransports(MTRecordListJob & job);
+    void startRecordListPopulation(bool bFollowUp=false); // Queues a job to the populator thread. (It calls OTRecordList::Populate(), and then additionally adds records from Bitmessage, etc.)
+
+    bool modifyRecords(opentxs::OTRecordList & theList); // After we populate the recordlist, we make some changes to the list (move messages to a separate db table, move receipts to a separate table, etc.)
+    void QueueMailForArchive   (MTRecordArchiver & archiver, opentxs::OTRecord& recordmt, int nRecordIndex);
+    void QueuePaymentForArchive(MTRecordArchiver & archiver, opentxs::OTRecord& recordmt, int nRecordIndex, const bool bCanDeleteRecord=true);
+    bool DeleteSpecialMailFromSource(opentxs::OTRecord& recordmt);
     void AddPaymentBasedOnNotification(const std::string & str_acct_id,
                                        const std::string & p_nym_id,
                                        const std::string & p_notary_id,
                                        const std::string & p_txn_contents,
                                        int64_t & lTransactionNum,
                                        int64_t & lTransNumForDisplay);
-    bool AddFinalReceiptToTradeArchive(opentxs::OTRecord& recordmt);
 
 signals:
     void balancesChanged();
@@ -101,6 +112,7 @@ signals:
     void needToUpdateMenu();
     void updateMenuAndPopulateRecords();
     void populatedRecordlist();
+    void recordListLoaded(MTRecordListSnapshotPtr snapshot); // Every list that comes back from the populator, before anything is archived out of it.
     void appendToLog(QString);
     void expertModeUpdated(bool);
     void hideNavUpdated(bool);
@@ -116,6 +128,9 @@ public slots:
     void onBalancesChanged();
     void onNeedToUpdateMenu();
     void onNeedToPopulateRecordlist();
+    void onRecordListReady(MTRecordListSnapshotPtr snapshot);
+    void onSuccessfulNotarization(QString qstrAcctId, QString qstrNymId, QString qstrNotaryId,
+                                  QString qstrTxnContents, qint64 lTransactionNum, qint64 lTransNumForDisplay);
     void onNeedToDownloadAccountData();
     void onNeedToDownloadSingleAcct(QString qstrAcctID, QString qstrOptionalAcctID);
     void onNeedToDownloadMail();
@@ -11,6 +11,8 @@
 #include <vector>
 #include <utility>
 #include <algorithm>
+#include <map>
+#include <set>
 
 #ifndef OT_USE_TR1
 #include <chrono>
@@ -25,7 +27,56 @@
 #include<boost/tokenizer.hpp>
 
 
-BitMessage::BitMessage(std::string commstring) : NetworkModule(commstring) {
+// Builds local message objects from one entry of a Bitmessage API JSON reply.
+// Both the list calls and the by-ID calls share the same per-message layout.
+
+static BitInboxMessage inboxMessageFromJson(const Json::Value & entry){
+    
+    // We need to sanitize our string, or else it will get cut off because of the newlines.
+    std::string dirtyMessage = entry.get("message", "").asString();
+    dirtyMessage.erase(std::remove(dirtyMessage.begin(), dirtyMessage.end(), '\n'), dirtyMessage.end());
+    base64 cleanMessage(dirtyMessage, true);
+    
+    return BitInboxMessage(entry.get("msgid", "").asString(), entry.get("toAddress", "").asString(), entry.get("fromAddress", "").asString(), base64(entry.get("subject", "").asString(), true), cleanMessage, entry.get("encodingType", 0).asInt(), std::atoi(entry.get("receivedTime", 0).asString().c_str()), entry.get("read", false).asBool());
+}
+
+static BitSentMessage sentMessageFromJson(const Json::Value & entry){
+    
+    // We need to sanitize our string, or else it will get cut off because of the newlines.
+    std::string dirtyMessage = entry.get("message", "").asString();
+    dirtyMessage.erase(std::remove(dirtyMessage.begin(), dirtyMessage.end(), '\n'), dirtyMessage.end());
+    base64 cleanMessage(dirtyMessage, true);
+    
+    return BitSentMessage(entry.get("msgid", "").asString(),
+                          entry.get("toAddress", "").asString(),
+                          entry.get("fromAddress", "").asString(),
+                          base64(entry.get("subject", "").asString(), true),
+                          cleanMessage,
+                          entry.get("encodingType", 0).asInt(),
+                          entry.get("lastActionTime", 0).asInt(),
+                          entry.get("status", false).asString(),
+                          entry.get("ackData", false).asString());
+}
+
+static _SharedPtr<NetworkMail> inboxMailFromMessage(BitInboxMessage & message){
+    
+    return _SharedPtr<NetworkMail>(new NetworkMail(message.getFromAddress(), message.getToAddress(), message.getSubject().decoded(), message.getMessage().decoded(), message.getRead(), message.getMessageID(), message.getReceivedTime()));
+}
+
+static _SharedPtr<NetworkMail> sentMailFromMessage(BitSentMessage & message){
+    
+    return _SharedPtr<NetworkMail>(new NetworkMail(message.getFromAddress(),
+                                                   message.getToAddress(),
+                                                   message.getSubject().decoded(),
+                                                   message.getMessage().decoded(),
+                                                   true,
+                                                   message.getMessageID(),
+                                                   0,
+                                                   message.getLastActionTime()));
+}
+
+
+BitMessage::BitMessage(std::string commstring) : NetworkModule(commstring), m_forceKill(false), m_incrementalSync(true) {
     
     parseCommstring(commstring);  // This is its own function now, purely for parsing and setting up the config as necessary.
     
@@ -260,9 +311,9 @@ bool BitMessage::checkRemoteAddresses(){
 
 bool BitMessage::checkMail(){
     try{
-        OT_STD_FUNCTION(void()) getInboxMessages = OT_STD_BIND(&BitMessage::getAllInboxMessages, this);
+        OT_STD_FUNCTION(void()) getInboxMessages = OT_STD_BIND(&BitMessage::refreshInbox, this);
         bm_queue->addToQueue(getInboxMessages);
-        OT_STD_FUNCTION(void()) getSentMessages = OT_STD_BIND(&BitMessage::getAllSentMessages, this);
+        OT_STD_FUNCTION(void()) getSentMessages = OT_STD_BIND(&BitMessage::refreshOutbox, this);
         bm_queue->addToQueue(getSentMessages);
         return true;
     }
@@ -275,16 +326,18 @@ bool BitMessage::checkMail(){
 bool BitMessage::newMailExists(std::string address){
     
     if(m_localInbox.size() == 0){
-        getAllInboxMessages(); // Blocking call, otherwise this may cause problems.
+        refreshInbox(); // Blocking call, otherwise this may cause problems.
     }
     INSTANTIATE_MLOCK(m_localInboxMutex);
     
     if(address != ""){
-        for(int x=0; x<m_localInbox.size(); x++){
-            
-            if(m_localInbox.at(x)->getTo() == address && m_localInbox.at(x)->getRead() == false){
-                mlock.unlock();
-                return true;
+        std::map<BitMessageAddress, std::vector<_SharedPtr<NetworkMail> > >::iterator it = m_inboxByAddress.find(address);
+        if(it != m_inboxByAddress.end()){
+            for(int x=0; x<it->second.size(); x++){
+                if(it->second.at(x)->getRead() == false){
+                    mlock.unlock();
+                    return true;
+                }
             }
         }
     }
@@ -304,17 +357,16 @@ bool BitMessage::newMailExists(std::string address){
 std::vector<_SharedPtr<NetworkMail> > BitMessage::getInbox(std::string address){
     
     if(m_localInbox.size() == 0){
-        getAllInboxMessages();  // Blocking call, otherwise this may cause problems.
+        refreshInbox();  // Blocking call, otherwise this may cause problems.
     }
     INSTANTIATE_MLOCK(m_localInboxMutex);
     try{
         
         if(address != ""){
+            std::map<BitMessageAddress, std::vector<_SharedPtr<NetworkMail> > >::iterator it = m_inboxByAddress.find(address);
             std::vector<_SharedPtr<NetworkMail> > inboxForAddress;
-            for(int x=0; x<m_localInbox.size(); x++){
-                if(m_localInbox.at(x)->getTo() == address)
-                    inboxForAddress.push_back(m_localInbox.at(x));
-            }
+            if(it != m_inboxByAddress.end())
+                inboxForAddress = it->second;
             mlock.unlock();
             return inboxForAddress;
         }
@@ -337,17 +389,16 @@ std::vector<_SharedPtr<NetworkMail> > BitMessage::getAllInboxes(){return getInbo
 std::vector<_SharedPtr<NetworkMail> > BitMessage::getOutbox(std::string address){
     
     if(m_localOutbox.size() == 0){
-        getAllSentMessages();  // Blocking call, otherwise this may cause problems.
+        refreshOutbox();  // Blocking call, otherwise this may cause problems.
     }
     INSTANTIATE_MLOCK(m_localOutboxMutex);
     try{
         
         if(address != ""){
+            std::map<BitMessageAddress, std::vector<_SharedPtr<NetworkMail> > >::iterator it = m_outboxByAddress.find(address);
             std::vector<_SharedPtr<NetworkMail> > outboxForAddress;
-            for(int x=0; x<m_localOutbox.size(); x++){
-                if(m_localOutbox.at(x)->getFrom() == address)
-                    outboxForAddress.push_back(m_localOutbox.at(x));
-            }
+            if(it != m_outboxByAddress.end())
+                outboxForAddress = it->second;
             mlock.unlock();
             return outboxForAddress;
         }
@@ -374,15 +425,18 @@ std::vector<_SharedPtr<NetworkMail> > BitMessage::getUnreadMail(std::string addr
     std::vector<_SharedPtr<NetworkMail> > unreadMail;
     
     if(m_localInbox.size() == 0){
-        getAllInboxMessages();  // Blocking call, otherwise this may cause problems.
+        refreshInbox();  // Blocking call, otherwise this may cause problems.
     }
     INSTANTIATE_MLOCK(m_localInboxMutex);
     try{
         
         if(address != ""){
-            for(int x=0; x<m_localInbox.size(); x++){
-                if(m_localInbox.at(x)->getTo() == address && m_localInbox.at(x)->getRead() == false)
-                    unreadMail.push_back(m_localInbox.at(x));
+            std::map<BitMessageAddress, std::vector<_SharedPtr<NetworkMail> > >::iterator it = m_inboxByAddress.find(address);
+            if(it != m_inboxByAddress.end()){
+                for(int x=0; x<it->second.size(); x++){
+                    if(it->second.at(x)->getRead() == false)
+                        unreadMail.push_back(it->second.at(x));
+                }
             }
             mlock.unlock();
             return unreadMail;
@@ -409,84 +463,72 @@ std::vector<_SharedPtr<NetworkMail> > BitMessage::getAllUnreadMail(){return getU
 bool BitMessage::deleteMessage(std::string messageID){
 
     if(m_localInbox.size() == 0){
-        getAllInboxMessages();  // Blocking call, otherwise this may cause problems.
+        refreshInbox();  // Blocking call, otherwise this may cause problems.
     }
     INSTANTIATE_MLOCK(m_localInboxMutex);
-    for(int x=0; x<m_localInbox.size(); x++){
 
-        if(m_localInbox.at(x)->getMessageID() == messageID){
-            m_localInbox.erase(m_localInbox.begin() + x);
-        }
-        try{
-            OT_STD_FUNCTION(void()) command = OT_STD_BIND(&BitMessage::trashMessage, this, messageID);
-            bm_queue->addToQueue(command);
-            mlock.unlock();
-            return true;
-        }
-        catch(...){
-            mlock.unlock();
-            return false;
-        }
-    }
+    unindexMail(messageID, m_localInbox, m_inboxByID, m_inboxByAddress, false);
+    m_localUnformattedInbox.erase(messageID);
 
-    mlock.unlock();
-    return false;
+    try{
+        OT_STD_FUNCTION(void()) command = OT_STD_BIND(&BitMessage::trashMessage, this, messageID);
+        bm_queue->addToQueue(command);
+        mlock.unlock();
+        return true;
+    }
+    catch(...){
+        mlock.unlock();
+        return false;
+    }
 
 } // Any part of the message should be able to be used to delete it from an inbox
 
 bool BitMessage::deleteOutMessage(std::string messageID){
 
     if(m_localOutbox.size() == 0){
-        getAllSentMessages();  // Blocking call, otherwise this may cause problems.
+        refreshOutbox();  // Blocking call, otherwise this may cause problems.
     }
     INSTANTIATE_MLOCK(m_localOutboxMutex);
-    for(int x=0; x<m_localOutbox.size(); x++){
 
-        if(m_localOutbox.at(x)->getMessageID() == messageID){
-            m_localOutbox.erase(m_localOutbox.begin() + x);
-        }
-        try{
-            OT_STD_FUNCTION(void()) command = OT_STD_BIND(&BitMessage::trashMessage, this, messageID);
-            bm_queue->addToQueue(command);
-            mlock.unlock();
-            return true;
-        }
-        catch(...){
-            mlock.unlock();
-            return false;
-        }
-    }
+    unindexMail(messageID, m_localOutbox, m_outboxByID, m_outboxByAddress, true);
+    m_localUnformattedOutbox.erase(messageID);
 
-    mlock.unlock();
-    return false;
+    try{
+        OT_STD_FUNCTION(void()) command = OT_STD_BIND(&BitMessage::trashMessage, this, messageID);
+        bm_queue->addToQueue(command);
+        mlock.unlock();
+        return true;
+    }
+    catch(...){
+        mlock.unlock();
+        return false;
+    }
 
 } // Any part of the message should be able to be used to delete it from an outbox
 
 bool BitMessage::markRead(std::string messageID, bool read){
     
     if(m_localInbox.size() == 0){
-        getAllInboxMessages();  // Blocking call, otherwise this may cause problems.
+        refreshInbox();  // Blocking call, otherwise this may cause problems.
     }
     
     INSTANTIATE_MLOCK(m_localInboxMutex);
-    for(int x=0; x<m_localInbox.size(); x++){
-        
-        if(m_localInbox.at(x)->getMessageID() == messageID){
-            m_localInbox.at(x)->setRead(read);
-        }
-        try{
-            OT_STD_FUNCTION(void()) command = OT_STD_BIND(&BitMessage::getInboxMessageByID, this, messageID, read);
-            bm_queue->addToQueue(command);
-            mlock.unlock();
-            return true;
-        }
-        catch(...){
-            mlock.unlock();
-            return false;
-        }
+    
+    std::map<std::string, _SharedPtr<NetworkMail> >::iterator it = m_inboxByID.find(messageID);
+    if(it != m_inboxByID.end()){
+        it->second->setRead(read);
+    }
+    
+    try{
+        OT_STD_FUNCTION(void()) command = OT_STD_BIND(&BitMessage::getInboxMessageByID, this, messageID, read);
+        bm_queue->addToQueue(command);
+        mlock.unlock();
+        return true;
+    }
+    catch(...){
+        mlock.unlock();
+        return false;
     }
-    mlock.unlock();
-    return false;
 } // By default this marks a given message as read or not, not all API's will support this and should thus return false.
 
 
@@ -597,6 +639,16 @@ int BitMessage::queueSize(){
     }
 }
 
+BitMessageQueueStats BitMessage::queueStats(){
+    if(bm_queue != nullptr){
+        return bm_queue->stats();
+    }
+    else{
+        std::cerr << "Message Queue does not exist!" << std::endl;
+        return BitMessageQueueStats();
+    }
+}
+
 
 
 
@@ -638,16 +690,7 @@ void BitMessage::getAllInboxMessages(){
     
     const Json::Value inboxMessages = root["inboxMessages"];
     for ( int index = 0; index < inboxMessages.size(); ++index ){  // Iterates over the sequence elements.
-        
-        // We need to sanitize our string, or else it will get cut off because of the newlines.
-        std::string dirtyMessage = inboxMessages[index].get("message", "").asString();
-        dirtyMessage.erase(std::remove(dirtyMessage.begin(), dirtyMessage.end(), '\n'), dirtyMessage.end());
-        base64 cleanMessage(dirtyMessage, true);
-        
-        BitInboxMessage message(inboxMessages[index].get("msgid", "").asString(), inboxMessages[index].get("toAddress", "").asString(), inboxMessages[index].get("fromAddress", "").asString(), base64(inboxMessages[index].get("subject", "").asString(), true), cleanMessage, inboxMessages[index].get("encodingType", 0).asInt(), std::atoi(inboxMessages[index].get("receivedTime", 0).asString().c_str()), inboxMessages[index].get("read", false).asBool());
-        
-        inbox.push_back(message);
-        
+        inbox.push_back(inboxMessageFromJson(inboxMessages[index]));
     }
     
     INSTANTIATE_MLOCK(m_localInboxMutex); // Lock so that we dont have a race condition.
@@ -655,13 +698,15 @@ void BitMessage::getAllInboxMessages(){
     
     m_localInbox.clear();
     m_localUnformattedInbox.clear();
+    m_inboxByID.clear();
+    m_inboxByAddress.clear();
+    
+    std::vector<_SharedPtr<NetworkMail> > fresh;
     for(int x=0; x<inbox.size(); x++){
-        m_localUnformattedInbox.push_back(inbox.at(x));
-        _SharedPtr<NetworkMail> l_mail( new NetworkMail(inbox.at(x).getFromAddress(), inbox.at(x).getToAddress(), inbox.at(x).getSubject().decoded(), inbox.at(x).getMessage().decoded(), inbox.at(x).getRead(), inbox.at(x).getMessageID(), inbox.at(x).getReceivedTime() ));
-        
-        m_localInbox.push_back(l_mail);
+        m_localUnformattedInbox.insert(std::make_pair(inbox.at(x).getMessageID(), inbox.at(x)));
+        fresh.push_back(inboxMailFromMessage(inbox.at(x)));
     }
-    std::reverse(m_localInbox.begin(), m_localInbox.end());  // New messages at the front
+    indexNewMail(fresh, m_localInbox, m_inboxByID, m_inboxByAddress, false);  // New messages at the front
     mlock.unlock(); // Release our lock so that others can access the inbox
     
 }
@@ -705,12 +750,7 @@ void BitMessage::getInboxMessageByID(std::string msgID, bool setRead){
     
     const Json::Value inboxMessage = root["inboxMessage"];
     
-    std::string dirtyMessage = inboxMessage[0].get("message", "").asString();
-    dirtyMessage.erase(std::remove(dirtyMessage.begin(), dirtyMessage.end(), '\n'), dirtyMessage.end());
-    base64 cleanMessage(dirtyMessage, true);
-    
-    
-    BitInboxMessage message(inboxMessage[0].get("msgid", "").asString(), inboxMessage[0].get("toAddress", "").asString(), inboxMessage[0].get("fromAddress", "").asString(), base64(inboxMessage[0].get("subject", "").asString(), true), cleanMessage, inboxMessage[0].get("encodingType", 0).asInt(), std::atoi(inboxMessage[0].get("receivedTime", 0).asString().c_str()), inboxMessage[0].get("read", false).asBool());
+    BitInboxMessage message = inboxMessageFromJson(inboxMessage[0]);
     
     //return message;
     
@@ -819,23 +859,7 @@ void BitMessage::getAllSentMessages(){
 
     const Json::Value sentMessages = root["sentMessages"];
     for ( int index = 0; index < sentMessages.size(); ++index ){  // Iterates over the sequence elements.
-
-        // We need to sanitize our string, or else it will get cut off because of the newlines.
-        std::string dirtyMessage = sentMessages[index].get("message", "").asString();
-        dirtyMessage.erase(std::remove(dirtyMessage.begin(), dirtyMessage.end(), '\n'), dirtyMessage.end());
-        base64 cleanMessage(dirtyMessage, true);
-
-        BitSentMessage message(sentMessages[index].get("msgid", "").asString(),
-                               sentMessages[index].get("toAddress", "").asString(),
-                               sentMessages[index].get("fromAddress", "").asString(),
-                               base64(sentMessages[index].get("subject", "").asString(), true),
-                               cleanMessage,
-                               sentMessages[index].get("encodingType", 0).asInt(),
-                               sentMessages[index].get("lastActionTime", 0).asInt(),
-                               sentMessages[index].get("status", false).asString(),
-                               sentMessages[index].get("ackData", false).asString());
-
-        outbox.push_back(message);
+        outbox.push_back(sentMessageFromJson(sentMessages[index]));
     }
 
     INSTANTIATE_MLOCK(m_localOutboxMutex); // Lock so that we dont have a race condition.
@@ -843,35 +867,253 @@ void BitMessage::getAllSentMessages(){
 
     m_localOutbox.clear();
     m_localUnformattedOutbox.clear();
+    m_outboxByID.clear();
+    m_outboxByAddress.clear();
+
+    std::vector<_SharedPtr<NetworkMail> > fresh;
     for(int x=0; x<outbox.size(); x++){
-        m_localUnformattedOutbox.push_back(outbox.at(x));
-
-//        NetworkMail(std::string from="",
-//                    std::string to="",
-//                    std::string subject="",
-//                    std::string message="",
-//                    bool isRead=false,
-//                    std::string messageID="",
-//                    std::time_t received=0,
-//                    std::time_t sent=0)
-
-        _SharedPtr<NetworkMail> l_mail( new NetworkMail(outbox.at(x).getFromAddress(),
-                                                        outbox.at(x).getToAddress(),
-                                                        outbox.at(x).getSubject().decoded(),
-                                                        outbox.at(x).getMessage().decoded(),
-                                                        true,
-                                                        outbox.at(x).getMessageID(),
-                                                        0,
-                                                        outbox.at(x).getLastActionTime()));
-
-        m_localOutbox.push_back(l_mail);
+        m_localUnformattedOutbox.insert(std::make_pair(outbox.at(x).getMessageID(), outbox.at(x)));
+        fresh.push_back(sentMailFromMessage(outbox.at(x)));
     }
-    std::reverse(m_localOutbox.begin(), m_localOutbox.end());  // New messages at the front
+    indexNewMail(fresh, m_localOutbox, m_outboxByID, m_outboxByAddress, true);  // New messages at the front
     mlock.unlock(); // Release our lock so that others can access the outbox
 
 }
 
 
+/*
+ * Incremental Mailbox Sync
+ *
+ * Instead of downloading and decoding every stored message on each checkMail(), these ask
+ * the API for the cheap list of message IDs, fetch only the IDs we have never seen, and drop
+ * any we hold that the server no longer has.  If the API is too old to list IDs we fall back
+ * to the full download.
+ */
+
+void BitMessage::setIncrementalSync(bool incremental){
+    m_incrementalSync = incremental;
+}
+
+void BitMessage::refreshInbox(){
+    if(m_incrementalSync)
+        syncInboxMessages();
+    else
+        getAllInboxMessages();
+}
+
+void BitMessage::refreshOutbox(){
+    if(m_incrementalSync)
+        syncSentMessages();
+    else
+        getAllSentMessages();
+}
+
+bool BitMessage::listMessageIDs(std::string method, std::string listKey, std::vector<std::string> & msgIDs){
+    
+    Parameters params;
+    
+    XmlResponse result = m_xmllib->run(method, params);
+    
+    if(result.first == false){
+        std::cerr << "Error: " << method << " failed" << std::endl;
+        return false;
+    }
+    else if(result.second.type() == xmlrpc_c::value::TYPE_STRING){
+        std::size_t found;
+        found=std::string(ValueString(result.second)).find("API Error");
+        if(found!=std::string::npos){
+            std::cerr << std::string(ValueString(result.second)) << std::endl;
+            return false;
+        }
+    }
+    
+    Json::Value root;
+    Json::Reader reader;
+    
+    bool parsesuccess = reader.parse( ValueString(result.second), root );
+    if ( !parsesuccess || !root.isMember(listKey) )
+    {
+        std::cerr  << "Failed to parse message ID list\n" << reader.getFormattedErrorMessages();
+        return false;
+    }
+    
+    const Json::Value idList = root[listKey];
+    for ( int index = 0; index < idList.size(); ++index ){
+        msgIDs.push_back(idList[index].get("msgid", "").asString());
+    }
+    
+    return true;
+}
+
+void BitMessage::syncInboxMessages(){
+    
+    std::vector<std::string> serverIDs;
+    
+    if(!listMessageIDs("getAllInboxMessageIds", "inboxMessageIds", serverIDs)){
+        getAllInboxMessages();
+        return;
+    }
+    
+    std::set<std::string> serverSet(serverIDs.begin(), serverIDs.end());
+    std::vector<std::string> newIDs;
+    
+    INSTANTIATE_MLOCK(m_localInboxMutex);
+    
+    for(int x=0; x<serverIDs.size(); x++){
+        if(m_inboxByID.find(serverIDs.at(x)) == m_inboxByID.end())
+            newIDs.push_back(serverIDs.at(x));
+    }
+    
+    std::vector<std::string> goneIDs;
+    for(std::map<std::string, _SharedPtr<NetworkMail> >::iterator it = m_inboxByID.begin(); it != m_inboxByID.end(); ++it){
+        if(serverSet.find(it->first) == serverSet.end())
+            goneIDs.push_back(it->first);
+    }
+    for(int x=0; x<goneIDs.size(); x++){
+        unindexMail(goneIDs.at(x), m_localInbox, m_inboxByID, m_inboxByAddress, false);
+        m_localUnformattedInbox.erase(goneIDs.at(x));
+    }
+    
+    mlock.unlock(); // Don't hold the inbox while we talk to the API server
+    
+    std::vector<BitInboxMessage> fetched;
+    for(int x=0; x<newIDs.size(); x++){
+        
+        Parameters params;
+        params.push_back(ValueString(newIDs.at(x)));  // Single-argument form leaves the read status alone
+        
+        XmlResponse result = m_xmllib->run("getInboxMessageByID", params);
+        if(result.first == false){
+            std::cerr << "Error: getInboxMessageByID failed" << std::endl;
+            continue;
+        }
+        
+        Json::Value root;
+        Json::Reader reader;
+        if(!reader.parse( ValueString(result.second), root ) || root["inboxMessage"].size() == 0){
+            std::cerr  << "Failed to parse inbox message " << newIDs.at(x) << std::endl;
+            continue;
+        }
+        
+        fetched.push_back(inboxMessageFromJson(root["inboxMessage"][0]));
+    }
+    
+    mlock.lock();
+    
+    std::vector<_SharedPtr<NetworkMail> > fresh;
+    for(int x=0; x<fetched.size(); x++){
+        if(m_inboxByID.find(fetched.at(x).getMessageID()) != m_inboxByID.end())
+            continue; // A full refresh may have landed while we were fetching.
+        m_localUnformattedInbox.insert(std::make_pair(fetched.at(x).getMessageID(), fetched.at(x)));
+        fresh.push_back(inboxMailFromMessage(fetched.at(x)));
+    }
+    indexNewMail(fresh, m_localInbox, m_inboxByID, m_inboxByAddress, false);
+    
+    mlock.unlock();
+    
+}
+
+void BitMessage::syncSentMessages(){
+    
+    std::vector<std::string> serverIDs;
+    
+    if(!listMessageIDs("getAllSentMessageIds", "sentMessageIds", serverIDs)){
+        getAllSentMessages();
+        return;
+    }
+    
+    std::set<std::string> serverSet(serverIDs.begin(), serverIDs.end());
+    std::vector<std::string> newIDs;
+    
+    INSTANTIATE_MLOCK(m_localOutboxMutex);
+    
+    for(int x=0; x<serverIDs.size(); x++){
+        if(m_outboxByID.find(serverIDs.at(x)) == m_outboxByID.end())
+            newIDs.push_back(serverIDs.at(x));
+    }
+    
+    std::vector<std::string> goneIDs;
+    for(std::map<std::string, _SharedPtr<NetworkMail> >::iterator it = m_outboxByID.begin(); it != m_outboxByID.end(); ++it){
+        if(serverSet.find(it->first) == serverSet.end())
+            goneIDs.push_back(it->first);
+    }
+    for(int x=0; x<goneIDs.size(); x++){
+        unindexMail(goneIDs.at(x), m_localOutbox, m_outboxByID, m_outboxByAddress, true);
+        m_localUnformattedOutbox.erase(goneIDs.at(x));
+    }
+    
+    mlock.unlock(); // Don't hold the outbox while we talk to the API server
+    
+    std::vector<BitSentMessage> fetched;
+    for(int x=0; x<newIDs.size(); x++){
+        BitSentMessage message = getSentMessageByID(newIDs.at(x));
+        if(message.getMessageID() != "")
+            fetched.push_back(message);
+    }
+    
+    mlock.lock();
+    
+    std::vector<_SharedPtr<NetworkMail> > fresh;
+    for(int x=0; x<fetched.size(); x++){
+        if(m_outboxByID.find(fetched.at(x).getMessageID()) != m_outboxByID.end())
+            continue; // A full refresh may have landed while we were fetching.
+        m_localUnformattedOutbox.insert(std::make_pair(fetched.at(x).getMessageID(), fetched.at(x)));
+        fresh.push_back(sentMailFromMessage(fetched.at(x)));
+    }
+    indexNewMail(fresh, m_localOutbox, m_outboxByID, m_outboxByAddress, true);
+    
+    mlock.unlock();
+    
+}
+
+// Caller must hold the matching mailbox mutex.  "fresh" arrives oldest first, as the API
+// lists it, and ends up at the front of the mailbox and of each address bucket.
+void BitMessage::indexNewMail(std::vector<_SharedPtr<NetworkMail> > & fresh, std::vector<_SharedPtr<NetworkMail> > & mailbox,
+                              std::map<std::string, _SharedPtr<NetworkMail> > & byID,
+                              std::map<BitMessageAddress, std::vector<_SharedPtr<NetworkMail> > > & byAddress, bool keyOnSender){
+    
+    if(fresh.size() == 0)
+        return;
+    
+    std::reverse(fresh.begin(), fresh.end());  // New messages at the front
+    
+    std::map<BitMessageAddress, std::vector<_SharedPtr<NetworkMail> > > freshByAddress;
+    for(int x=0; x<fresh.size(); x++){
+        byID[fresh.at(x)->getMessageID()] = fresh.at(x);
+        freshByAddress[keyOnSender ? fresh.at(x)->getFrom() : fresh.at(x)->getTo()].push_back(fresh.at(x));
+    }
+    
+    for(std::map<BitMessageAddress, std::vector<_SharedPtr<NetworkMail> > >::iterator it = freshByAddress.begin(); it != freshByAddress.end(); ++it){
+        std::vector<_SharedPtr<NetworkMail> > & bucket = byAddress[it->first];
+        bucket.insert(bucket.begin(), it->second.begin(), it->second.end());
+    }
+    
+    mailbox.insert(mailbox.begin(), fresh.begin(), fresh.end());
+}
+
+// Caller must hold the matching mailbox mutex.
+void BitMessage::unindexMail(const std::string & msgID, std::vector<_SharedPtr<NetworkMail> > & mailbox,
+                             std::map<std::string, _SharedPtr<NetworkMail> > & byID,
+                             std::map<BitMessageAddress, std::vector<_SharedPtr<NetworkMail> > > & byAddress, bool keyOnSender){
+    
+    std::map<std::string, _SharedPtr<NetworkMail> >::iterator found = byID.find(msgID);
+    if(found == byID.end())
+        return;
+    
+    _SharedPtr<NetworkMail> mail = found->second;
+    byID.erase(found);
+    
+    std::map<BitMessageAddress, std::vector<_SharedPtr<NetworkMail> > >::iterator bucket = byAddress.find(keyOnSender ? mail->getFrom() : mail->getTo());
+    if(bucket != byAddress.end()){
+        bucket->second.erase(std::remove(bucket->second.begin(), bucket->second.end(), mail), bucket->second.end());
+        if(bucket->second.empty())
+            byAddress.erase(bucket);
+    }
+    
+    mailbox.erase(std::remove(mailbox.begin(), mailbox.end(), mail), mailbox.end());
+}
+
+
 BitSentMessage BitMessage::getSentMessageByID(std::string msgID){
     
     Parameters params;
@@ -968,7 +1210,7 @@ std::vector<BitSentMessage> BitMessage::getSentMessagesBySender(std::string addr
     
     
     Parameters params;
-    BitMessageOutbox outbox;
+    std::vector<BitSentMessage> outbox;
     
     params.push_back(ValueString(address));
     
@@ -1779,8 +2021,8 @@ void BitMessage::initializeUserData(){
     
     listAddresses(); // Populates Local Owned Addresses
     listAddressBookEntries();  // Populates address book data, for remote users we have addresses for.
-    getAllInboxMessages();
-    getAllSentMessages();
+    refreshInbox();
+    refreshOutbox();
     listSubscriptions();
     
 }
@@ -6,6 +6,7 @@
 #include <memory>
 #include <string>
 #include <ctime>
+#include <map>
 //#include <mutex>
 #include "Network.h"
 #include "XmlRPC.h"
@@ -113,7 +114,7 @@ private:
     
 };
 
-typedef std::vector<BitInboxMessage> BitMessageInbox;
+typedef std::map<std::string, BitInboxMessage> BitMessageInbox;  // Keyed by msgid
 
 
 class BitSentMessage {
@@ -147,7 +148,7 @@ private:
     
 };
 
-typedef std::vector<BitSentMessage> BitMessageOutbox;
+typedef std::map<std::string, BitSentMessage> BitMessageOutbox;  // Keyed by msgid
 
 
 class BitDecodedAddress {
@@ -220,11 +221,23 @@ public:
     bool refreshSubscriptions();
     
     
+    // Mailbox Sync
+    // Incremental sync (the default) only downloads messages whose IDs we haven't seen yet.
+    // Turn it off to re-download the full inbox and outbox on every checkMail().
+    // The IDs seen are the keys of the local mailboxes, which live in memory only, so
+    // the first checkMail() after a restart still downloads everything on the server.
+    // Persisting just the IDs would hide messages whose bodies were never kept; once
+    // Moneychanger archives a message it deletes it here, which keeps that first sync small.
+    void setIncrementalSync(bool incremental);
+    bool incrementalSync(){return m_incrementalSync;}
+    
+    
     // Message Queue Interaction
     bool startQueue();
     bool stopQueue();
     bool flushQueue();
     int queueSize();
+    BitMessageQueueStats queueStats(); // Timing, depth and latency counters for the queue worker.
     
     
     //
@@ -343,6 +356,7 @@ private:
     
     bool m_serverAvailable;
     bool m_forceKill;  // If this is set, the class will ignore the status of the queue processing and force a shut down of the network.
+    bool m_incrementalSync;
     
     
     // Communication Library, XmlRPC in this case
@@ -355,6 +369,19 @@ private:
     void parseCommstring(std::string commstring);
     void checkAlive(); // Forces a health check of the BitMessage API Server
     
+    void refreshInbox();  // Incremental or full download, depending on m_incrementalSync
+    void refreshOutbox();
+    void syncInboxMessages();
+    void syncSentMessages();
+    bool listMessageIDs(std::string method, std::string listKey, std::vector<std::string> & msgIDs);
+    
+    void indexNewMail(std::vector<_SharedPtr<NetworkMail> > & fresh, std::vector<_SharedPtr<NetworkMail> > & mailbox,
+                      std::map<std::string, _SharedPtr<NetworkMail> > & byID,
+                      std::map<BitMessageAddress, std::vector<_SharedPtr<NetworkMail> > > & byAddress, bool keyOnSender);
+    void unindexMail(const std::string & msgID, std::vector<_SharedPtr<NetworkMail> > & mailbox,
+                     std::map<std::string, _SharedPtr<NetworkMail> > & byID,
+                     std::map<BitMessageAddress, std::vector<_SharedPtr<NetworkMail> > > & byAddress, bool keyOnSender);
+    
     
     // Message Queing Plugs
     
@@ -376,12 +403,16 @@ private:
     BitMessageAddressBook m_localAddressBook;   // Remote user addresses.
     
     OT_MUTEX(m_localInboxMutex);
-    std::vector<_SharedPtr<NetworkMail> > m_localInbox;
+    std::vector<_SharedPtr<NetworkMail> > m_localInbox;  // Newest first
+    std::map<std::string, _SharedPtr<NetworkMail> > m_inboxByID;  // Also serves as the set of msgids we've already downloaded
+    std::map<BitMessageAddress, std::vector<_SharedPtr<NetworkMail> > > m_inboxByAddress;  // Keyed by to-address, newest first
     BitMessageInbox m_localUnformattedInbox; // Necessary for doing operations on BitMessage-specific messages
     OT_ATOMIC(m_newMailExists);
     
     OT_MUTEX(m_localOutboxMutex);
-    std::vector<_SharedPtr<NetworkMail> > m_localOutbox;
+    std::vector<_SharedPtr<NetworkMail> > m_localOutbox;  // Newest first
+    std::map<std::string, _SharedPtr<NetworkMail> > m_outboxByID;
+    std::map<BitMessageAddress, std::vector<_SharedPtr<NetworkMail> > > m_outboxByAddress;  // Keyed by from-address, newest first
     BitMessageOutbox m_localUnformattedOutbox; // Necessary for doing operations on BitMessage-specific messages
     
     OT_MUTEX(m_localSubscriptionListMutex);
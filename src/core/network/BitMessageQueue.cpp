@@ -4,6 +4,8 @@
 
 #include "BitMessageQueue.h"
 
+#include <iostream>
+
 #include<boost/tokenizer.hpp>
 
 
@@ -12,6 +14,7 @@ bool BitMessageQueue::start() {
     
     if(m_stop){
         m_stop = false;
+        MasterQueue.resume();
         m_thread = OT_THREAD(&BitMessageQueue::run, this);
         return true;
     }
@@ -25,10 +28,9 @@ bool BitMessageQueue::start() {
 bool BitMessageQueue::stop() {
     
     if(!m_stop){
-        INSTANTIATE_MLOCK(m_processing); // Don't stop the thread in the middle of processing
         m_stop = true;
+        MasterQueue.interrupt(); // Wakes the worker; a command already running is allowed to finish first.
         m_thread.join();
-        mlock.unlock();
         return true;
     }
     else{
@@ -47,7 +49,18 @@ bool BitMessageQueue::processing(){
 
 void BitMessageQueue::addToQueue(OT_STD_FUNCTION(void()) command){
     
-    MasterQueue.push(command);
+    QueuedCommand queued;
+    queued.command = command;
+    queued.enqueued = QueueClock::now();
+    
+    MasterQueue.push(queued);
+    
+    int depth = MasterQueue.size();
+    
+    INSTANTIATE_MLOCK(m_statsMutex);
+    m_stats.commandsQueued++;
+    if(depth > m_stats.peakQueueDepth)
+        m_stats.peakQueueDepth = depth;
     
 }
 
@@ -68,35 +81,88 @@ void BitMessageQueue::clearQueue(){
 }
 
 
+BitMessageQueueStats BitMessageQueue::stats(){
+    
+    INSTANTIATE_MLOCK(m_statsMutex);
+    BitMessageQueueStats current = m_stats;
+    mlock.unlock();
+    
+    current.queueDepth = queueSize();
+    current.processing = processing();
+    
+    return current;
+    
+}
+
+
+void BitMessageQueue::resetStats(){
+    
+    INSTANTIATE_MLOCK(m_statsMutex);
+    m_stats = BitMessageQueueStats();
+    
+}
+
+
 
 
 bool BitMessageQueue::parseNextMessage(){
     
-    if(queueSize() == 0){
+    QueuedCommand message;
+    
+    if(!MasterQueue.waitPop(message)){  // Blocks without spinning until there is work or stop() is called
         return false;
     }
     
     INSTANTIATE_MLOCK(m_processing);  // Don't let other functions interfere with our message parsing
     
-    //    m_working = true; // Notify our atomic boolean that we are in the middle of a process
+    m_working = true; // Notify our atomic boolean that we are in the middle of a process
+    
+    QueueClock::time_point started = QueueClock::now();
+    bool failed = false;
+    
+    try{
+        message.command();
+    }
+    catch(...){
+        std::cerr << "BitMessageQueue: queued command threw an exception" << std::endl;
+        failed = true;
+    }
     
-    OT_STD_FUNCTION(void()) message = MasterQueue.pop();  // Pull out our function to run
+    QueueClock::time_point finished = QueueClock::now();
     
-    message();
+    m_working = false; // Notify our atomic boolean that we are done with our processing
     
     mlock.unlock();
-    m_conditional.notify_one(); // Let other functions know that we're done and they can continue.
-    // This is primarily for when a request comes in to shut down the queue
-    // While an action is in progress. This will notify our stop handler that it is safe
-    // To shut down the thread.
     
-    //    m_working = false; // Notify our atomic boolean that we are done with our processing
+    long long waitMicros = OT_CHRONO::duration_cast<OT_CHRONO::microseconds>(started - message.enqueued).count();
+    long long execMicros = OT_CHRONO::duration_cast<OT_CHRONO::microseconds>(finished - started).count();
     
+    recordExecution(waitMicros, execMicros, failed);
     
     return true;
 }
 
 
+void BitMessageQueue::recordExecution(long long waitMicros, long long execMicros, bool failed){
+    
+    INSTANTIATE_MLOCK(m_statsMutex);
+    
+    m_stats.commandsExecuted++;
+    if(failed)
+        m_stats.commandsFailed++;
+    
+    m_stats.lastExecMicros = execMicros;
+    m_stats.totalExecMicros += execMicros;
+    if(execMicros > m_stats.maxExecMicros)
+        m_stats.maxExecMicros = execMicros;
+    
+    m_stats.totalWaitMicros += waitMicros;
+    if(waitMicros > m_stats.maxWaitMicros)
+        m_stats.maxWaitMicros = waitMicros;
+    
+}
+
+
 BitMessageQueue::~BitMessageQueue(){
     
     try{
@@ -107,4 +173,4 @@ BitMessageQueue::~BitMessageQueue(){
         /* Will need to refactor this */
     }
     
-}
\ No newline at end of file
+}
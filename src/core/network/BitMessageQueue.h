@@ -2,19 +2,43 @@
 //
 //  BitMessageQueue.h
 //
-#include "BitMessage.h"
-
-//#include <mutex>
-//#include <condition_variable>
+#include "MsgQueue.h"
 
 class BitMessage;
 
 
+// Snapshot of the queue worker's counters, all times are in microseconds.
+// "Wait" is the time a command spent queued before it began executing.
+
+struct BitMessageQueueStats {
+    
+    BitMessageQueueStats() : queueDepth(0), peakQueueDepth(0), commandsQueued(0), commandsExecuted(0), commandsFailed(0),
+                             lastExecMicros(0), maxExecMicros(0), totalExecMicros(0), maxWaitMicros(0), totalWaitMicros(0), processing(false) {}
+    
+    int queueDepth;
+    int peakQueueDepth;
+    
+    long long commandsQueued;
+    long long commandsExecuted;
+    long long commandsFailed;   // Commands that threw while executing.
+    
+    long long lastExecMicros;
+    long long maxExecMicros;
+    long long totalExecMicros;
+    
+    long long maxWaitMicros;
+    long long totalWaitMicros;
+    
+    bool processing;
+    
+};
+
+
 class BitMessageQueue {
     
 public:
     
-    BitMessageQueue(BitMessage *parent) : parentInterface(parent), m_stop(true), m_thread() { }
+    BitMessageQueue(BitMessage *parent) : m_stop(true), m_thread(), m_working(false), parentInterface(parent) { }
     ~BitMessageQueue();
     
     // Public Thread Managers
@@ -28,30 +52,40 @@ public:
     int queueSize();
     void clearQueue();
     
-    // Add function to determine amount of time last command has run.
-    // Use boost::chrono?
+    BitMessageQueueStats stats();
+    void resetStats();
     
 protected:
     
     OT_ATOMIC(m_stop);
-    void run(){ while(!m_stop){parseNextMessage();} }; // Obviously this will be our message parsing loop
+    void run(){ while(!m_stop){ if(!parseNextMessage()) break; } } // Sleeps in parseNextMessage until a command arrives or stop() interrupts it
     
 private:
     
+    typedef OT_CHRONO::steady_clock QueueClock;
+    
+    struct QueuedCommand {
+        OT_STD_FUNCTION(void()) command;
+        QueueClock::time_point enqueued;
+    };
+    
     // Variables
     
     OT_THREAD m_thread;
     OT_MUTEX(m_processing);
-    CONDITION_VARIABLE(m_conditional);
     
     OT_ATOMIC(m_working);
     
     BitMessage *parentInterface;
     
-    MsgQueue<OT_STD_FUNCTION(void())> MasterQueue;
+    MsgQueue<QueuedCommand> MasterQueue;
+    
+    OT_MUTEX(m_statsMutex);
+    BitMessageQueueStats m_stats;
     
     // Functions
     
     bool parseNextMessage();
+    void recordExecution(long long waitMicros, long long execMicros, bool failed);
     
 };
@@ -11,6 +11,8 @@ class MsgQueue
 {
 public:
     
+    MsgQueue() : interrupted_(false) {}
+    
     T pop()
     {
         INSTANTIATE_MLOCK(mutex_);
@@ -34,6 +36,38 @@ public:
         queue_.pop();
     }
     
+    // Blocks until an item is available or the queue is interrupted.
+    // Returns false (leaving item untouched) if woken by interrupt().
+    bool waitPop(T& item)
+    {
+        INSTANTIATE_MLOCK(mutex_);
+        while (queue_.empty() && !interrupted_)
+        {
+            cond_.wait(mlock);
+        }
+        if (interrupted_)
+            return false;
+        item = queue_.front();
+        queue_.pop();
+        return true;
+    }
+    
+    // Wakes every thread blocked in waitPop() so a worker can shut down.
+    // Items already queued are kept until resume() is called.
+    void interrupt()
+    {
+        INSTANTIATE_MLOCK(mutex_);
+        interrupted_ = true;
+        mlock.unlock();
+        cond_.notify_all();
+    }
+    
+    void resume()
+    {
+        INSTANTIATE_MLOCK(mutex_);
+        interrupted_ = false;
+    }
+    
     void push(const T& item)
     {
         INSTANTIATE_MLOCK(mutex_);
@@ -70,6 +104,7 @@ public:
     
 private:
     std::queue<T> queue_;
+    bool interrupted_;
     OT_MUTEX(mutex_);
     CONDITION_VARIABLE(cond_);
 };
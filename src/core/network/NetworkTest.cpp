@@ -0,0 +1,399 @@
+//
+//  NetworkTest.cpp
+//
+
+#include "NetworkTest.h"
+
+#include "BitMessageQueue.h"
+#include "base64.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <ctime>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+typedef OT_CHRONO::steady_clock TestClock;
+
+long long microsSince(TestClock::time_point start){
+    return OT_CHRONO::duration_cast<OT_CHRONO::microseconds>(TestClock::now() - start).count();
+}
+
+void sleepMillis(int ms){
+#ifndef OT_USE_TR1
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+#else
+    boost::this_thread::sleep_for(boost::chrono::milliseconds(ms));
+#endif
+}
+
+// Process CPU time over a wall-clock sleep, in milliseconds.
+double cpuMillisWhileSleeping(int sleepMs){
+    std::clock_t before = std::clock();
+    sleepMillis(sleepMs);
+    return (std::clock() - before) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+
+// The codec base64.cpp had before it went table driven (René Nyffenegger's,
+// see the notice there), kept as the reference for the equivalence test and
+// the benchmark.
+
+const std::string reference_chars =
+"ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+"abcdefghijklmnopqrstuvwxyz"
+"0123456789+/";
+
+inline bool reference_is_base64(unsigned char c){
+    return (isalnum(c) || (c == '+') || (c == '/'));
+}
+
+std::string reference_encode(unsigned char const* bytes_to_encode, unsigned int in_len){
+    std::string ret;
+    int i = 0;
+    int j = 0;
+    unsigned char char_array_3[3];
+    unsigned char char_array_4[4];
+
+    while (in_len--) {
+        char_array_3[i++] = *(bytes_to_encode++);
+        if (i == 3) {
+            char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
+            char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
+            char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
+            char_array_4[3] = char_array_3[2] & 0x3f;
+
+            for(i = 0; (i <4) ; i++)
+                ret += reference_chars[char_array_4[i]];
+            i = 0;
+        }
+    }
+
+    if (i)
+    {
+        for(j = i; j < 3; j++)
+            char_array_3[j] = '\0';
+
+        char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
+        char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
+        char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
+        char_array_4[3] = char_array_3[2] & 0x3f;
+
+        for (j = 0; (j < i + 1); j++)
+            ret += reference_chars[char_array_4[j]];
+
+        while((i++ < 3))
+            ret += '=';
+    }
+
+    return ret;
+}
+
+std::string reference_decode(std::string const& encoded_string){
+    int in_len = encoded_string.size();
+    int i = 0;
+    int j = 0;
+    int in_ = 0;
+    unsigned char char_array_4[4], char_array_3[3];
+    std::string ret;
+
+    while (in_len-- && ( encoded_string[in_] != '=') && reference_is_base64(encoded_string[in_])) {
+        char_array_4[i++] = encoded_string[in_]; in_++;
+        if (i ==4) {
+            for (i = 0; i <4; i++)
+                char_array_4[i] = reference_chars.find(char_array_4[i]);
+
+            char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
+            char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
+            char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
+
+            for (i = 0; (i < 3); i++)
+                ret += char_array_3[i];
+            i = 0;
+        }
+    }
+
+    if (i) {
+        for (j = i; j <4; j++)
+            char_array_4[j] = 0;
+
+        for (j = 0; j <4; j++)
+            char_array_4[j] = reference_chars.find(char_array_4[j]);
+
+        char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
+        char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
+        char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
+
+        for (j = 0; (j < i - 1); j++) ret += char_array_3[j];
+    }
+
+    return ret;
+}
+
+std::string randomBytes(std::mt19937 & rng, std::size_t length){
+    std::uniform_int_distribution<int> byteDist(0, 255);
+    std::string bytes(length, '\0');
+    for (std::size_t i = 0; i < length; i++)
+        bytes[i] = (char)byteDist(rng);
+    return bytes;
+}
+
+// Mostly base64, with the odd '=', whitespace or other junk that ends decoding.
+std::string randomEncoded(std::mt19937 & rng, std::size_t length){
+    static const char junk[] = "= \r\n-_.*\x80\xff";
+    std::uniform_int_distribution<int> charDist(0, 63);
+    std::uniform_int_distribution<int> junkDist(0, (int)sizeof(junk) - 2);
+    std::uniform_int_distribution<int> pick(0, 99);
+
+    std::string encoded(length, '\0');
+    for (std::size_t i = 0; i < length; i++)
+        encoded[i] = (pick(rng) < 3) ? junk[junkDist(rng)] : reference_chars[charDist(rng)];
+    return encoded;
+}
+
+}
+
+
+bool NetworkTest::TestNetworkFunctions(){
+
+    if(!TestBitMessageQueueIdle(1000))
+        return false;
+
+    if(!TestBitMessageQueueLatency(4, 20000))
+        return false;
+
+    if(!TestBase64Equivalence(200000))
+        return false;
+
+    if(!TestBase64Throughput(5 * 1024 * 1024, 5))
+        return false;
+
+    return true;
+}
+
+
+bool NetworkTest::TestBitMessageQueueIdle(int idleMs){
+
+    BitMessageQueue queue(NULL);
+
+    // Whatever else the process is doing counts against both samples.
+    double baselineMs = cpuMillisWhileSleeping(idleMs);
+
+    if(!queue.start())
+        return false;
+
+    double idleCpuMs = cpuMillisWhileSleeping(idleMs);
+
+    // One command at a time, each finding the worker asleep.
+    const int wakeups = 100;
+    std::vector<long long> waits;
+    waits.reserve(wakeups);
+
+    for(int i = 0; i < wakeups; i++){
+        TestClock::time_point queued = TestClock::now();
+        queue.addToQueue([&waits, queued](){ waits.push_back(microsSince(queued)); });
+        sleepMillis(2);
+    }
+
+    BitMessageQueueStats stats = queue.stats();
+    for(int i = 0; stats.commandsExecuted < wakeups && i < 1000; i++){
+        sleepMillis(1);
+        stats = queue.stats();
+    }
+
+    queue.stop();
+
+    double workerShare = std::max(0.0, idleCpuMs - baselineMs) / idleMs;
+
+    std::printf("BitMessageQueue idle: %.1f ms CPU in %d ms (%.1f ms without the worker), %.1f%% of a core\n",
+                idleCpuMs, idleMs, baselineMs, workerShare * 100.0);
+
+    if(workerShare > 0.1){
+        std::printf("BitMessageQueue idle: the worker is using CPU with nothing queued\n");
+        return false;
+    }
+
+    if(stats.commandsExecuted != wakeups || (int)waits.size() != wakeups){
+        std::printf("BitMessageQueue idle: %lld of %d commands ran after waking the worker\n", stats.commandsExecuted, wakeups);
+        return false;
+    }
+
+    std::sort(waits.begin(), waits.end());
+
+    std::printf("BitMessageQueue idle: enqueue to execute from sleep p50 %lld us, max %lld us\n",
+                waits[wakeups / 2], waits.back());
+
+    return true;
+}
+
+
+bool NetworkTest::TestBitMessageQueueLatency(int producers, int commandsPerProducer){
+
+    BitMessageQueue queue(NULL);
+
+    const int total = producers * commandsPerProducer;
+
+    // Only the worker thread runs commands, so these need no lock of their own.
+    std::vector<long long> waits;
+    waits.reserve(total);
+    unsigned long long checksum = 0;
+
+    if(!queue.start())
+        return false;
+
+    TestClock::time_point start = TestClock::now();
+
+    std::vector<OT_THREAD> threads;
+    for(int producer = 0; producer < producers; producer++){
+        threads.push_back(OT_THREAD([&queue, &waits, &checksum, producer, commandsPerProducer](){
+            for(int i = 0; i < commandsPerProducer; i++){
+                TestClock::time_point queued = TestClock::now();
+                unsigned long long value = (unsigned long long)producer * commandsPerProducer + i;
+                queue.addToQueue([&waits, &checksum, queued, value](){
+                    waits.push_back(microsSince(queued));
+                    checksum += value;
+                });
+            }
+        }));
+    }
+
+    for(std::size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+
+    long long queuedMicros = microsSince(start);
+
+    // stats() takes the lock the worker records each command under, so once it
+    // counts them all, waits and checksum are safe to read here.
+    BitMessageQueueStats stats = queue.stats();
+    while(stats.commandsExecuted < total && microsSince(start) < 30 * 1000 * 1000){
+        sleepMillis(1);
+        stats = queue.stats();
+    }
+
+    long long drainedMicros = microsSince(start);
+
+    queue.stop();
+
+    unsigned long long expected = (unsigned long long)total * (total - 1) / 2;
+
+    if(stats.commandsExecuted != total || (int)waits.size() != total || checksum != expected){
+        std::printf("BitMessageQueue load: %lld of %d commands ran\n", stats.commandsExecuted, total);
+        return false;
+    }
+
+    if(stats.commandsQueued != total || stats.commandsFailed != 0 || stats.queueDepth != 0){
+        std::printf("BitMessageQueue load: counters disagree (%lld queued, %lld failed, depth %d)\n",
+                    stats.commandsQueued, stats.commandsFailed, stats.queueDepth);
+        return false;
+    }
+
+    std::sort(waits.begin(), waits.end());
+
+    std::printf("BitMessageQueue load: %d producers, %d commands queued in %lld ms, all run after %lld ms, peak depth %d\n",
+                producers, total, queuedMicros / 1000, drainedMicros / 1000, stats.peakQueueDepth);
+    std::printf("BitMessageQueue load: enqueue to execute p50 %lld us, p99 %lld us, max %lld us (queue's own max %lld us)\n",
+                waits[total / 2], waits[(total * 99) / 100], waits.back(), stats.maxWaitMicros);
+
+    return true;
+}
+
+
+bool NetworkTest::TestBase64Equivalence(int rounds){
+
+    std::mt19937 rng(20160712);
+    std::uniform_int_distribution<int> lengthDist(0, 96);
+
+    std::vector<char> buffer;
+
+    for(int round = 0; round < rounds; round++){
+
+        std::string plain = randomBytes(rng, lengthDist(rng));
+
+        std::string expectedEncoded = reference_encode((const unsigned char *)plain.data(), plain.size());
+        base64 fromPlain(plain);
+
+        if(fromPlain.encoded() != expectedEncoded || fromPlain.decoded() != plain){
+            std::printf("base64: encoding %d bytes differs from the old codec (round %d)\n", (int)plain.size(), round);
+            return false;
+        }
+
+        // Valid data with its padding cut or junk after it, and plain junk.
+        std::string encoded;
+        switch(round % 3){
+            case 0: encoded = expectedEncoded.substr(0, expectedEncoded.size() - std::min<std::size_t>(expectedEncoded.size(), (round / 3) % 4)); break;
+            case 1: encoded = expectedEncoded + randomEncoded(rng, lengthDist(rng) % 8); break;
+            default: encoded = randomEncoded(rng, lengthDist(rng)); break;
+        }
+
+        std::string expectedDecoded = reference_decode(encoded);
+        base64 packed(encoded, true);
+
+        if(packed.decoded() != expectedDecoded){
+            std::printf("base64: decoding \"%s\" differs from the old codec\n", encoded.c_str());
+            return false;
+        }
+
+        buffer.assign(base64::decodedSizeBound(encoded.size()), '\0');
+        std::size_t written = packed.decodeTo(buffer.empty() ? NULL : &buffer[0], buffer.size());
+
+        if(std::string(buffer.begin(), buffer.begin() + written) != expectedDecoded){
+            std::printf("base64: decodeTo() of \"%s\" differs from the old codec\n", encoded.c_str());
+            return false;
+        }
+
+        std::string other = (round % 2) ? expectedDecoded : plain;
+        if((packed == other) != (expectedDecoded == other)){
+            std::printf("base64: operator== on \"%s\" differs from the old codec\n", encoded.c_str());
+            return false;
+        }
+    }
+
+    std::printf("base64: %d rounds matched the old codec\n", rounds);
+
+    return true;
+}
+
+
+bool NetworkTest::TestBase64Throughput(int payloadBytes, int rounds){
+
+    std::mt19937 rng(4096);
+    std::string plain = randomBytes(rng, payloadBytes);
+
+    long long oldMicros = 0;
+    long long newMicros = 0;
+    std::size_t sink = 0;
+
+    for(int round = 0; round < rounds; round++){
+
+        TestClock::time_point start = TestClock::now();
+        std::string oldEncoded = reference_encode((const unsigned char *)plain.data(), plain.size());
+        std::string oldDecoded = reference_decode(oldEncoded);
+        oldMicros += microsSince(start);
+
+        start = TestClock::now();
+        base64 coded(plain);
+        std::string newDecoded = coded.decoded();
+        newMicros += microsSince(start);
+
+        if(coded.encoded() != oldEncoded || newDecoded != plain || oldDecoded != plain){
+            std::printf("base64: round trip of %d bytes failed\n", payloadBytes);
+            return false;
+        }
+
+        sink += newDecoded.size() + oldDecoded.size();
+    }
+
+    double megabytes = (double)payloadBytes * rounds / (1024.0 * 1024.0);
+
+    std::printf("base64: %d bytes encoded and decoded %d times: old codec %.1f MB/s, new codec %.1f MB/s (%.1fx)\n",
+                payloadBytes, rounds,
+                megabytes * 1000000.0 / std::max(1LL, oldMicros),
+                megabytes * 1000000.0 / std::max(1LL, newMicros),
+                (double)oldMicros / std::max(1LL, newMicros));
+
+    return sink == (std::size_t)payloadBytes * rounds * 2;
+}
@@ -0,0 +1,38 @@
+#pragma once
+//
+//  NetworkTest.h
+//
+
+
+// Tests and benchmarks for the Bitmessage plumbing that doesn't need a running
+// PyBitmessage: the queue worker and the base64 codec. Run from the bitcoin
+// test window along with BtcTest; results go to stdout.
+
+class NetworkTest {
+
+public:
+
+    static bool TestNetworkFunctions();
+
+private:
+
+    // The worker is started with nothing queued and the process CPU time is
+    // sampled while it sits idle. Fails if it uses more than a small fraction
+    // of a core (a spinning worker uses all of one). Then commands are queued
+    // one at a time, to time how fast a sleeping worker picks them up.
+    static bool TestBitMessageQueueIdle(int idleMs);
+
+    // This many threads each queue commands as fast as they can. Every command
+    // records how long it waited between addToQueue() and running. Fails if a
+    // command is lost or the queue's own counters disagree.
+    static bool TestBitMessageQueueLatency(int producers, int commandsPerProducer);
+
+    // Random payloads and random (often invalid) encoded strings, checked
+    // against the codec this one replaced: encode, decode, decodeTo() and
+    // operator==(std::string) must all give the same answers.
+    static bool TestBase64Equivalence(int rounds);
+
+    // Encode and decode a payload of this size with both codecs.
+    static bool TestBase64Throughput(int payloadBytes, int rounds);
+
+};
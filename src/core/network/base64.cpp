@@ -28,103 +28,150 @@
 /*
  
  NOTICE - This source has been modified from the original for inclusion in the "base64" class as part of the vp-auditservice project.
+ It has since been reworked to use lookup tables and single allocations.
  
  */
 
 
 #include "base64.h"
 
-static const std::string base64_chars =
+#include <cstring>
+
+/*
+ The encoder and decoder below are table driven: every character is translated with a single
+ array index instead of a search through base64_chars, and each result is sized once up front
+ rather than grown a character at a time.
+ */
+
+static const char base64_chars[] =
 "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
 "abcdefghijklmnopqrstuvwxyz"
 "0123456789+/";
 
+static const unsigned char BASE64_INVALID = 0xff;
 
-static inline bool is_base64(unsigned char c) {
-    return (isalnum(c) || (c == '+') || (c == '/'));
-}
+
+// Maps each byte value to its 6-bit value, or BASE64_INVALID. '=' is invalid too, as it ends the data.
+struct base64_decode_table {
+    
+    unsigned char value[256];
+    
+    base64_decode_table(){
+        std::memset(value, BASE64_INVALID, sizeof(value));
+        for (int i = 0; i < 64; i++)
+            value[(unsigned char)base64_chars[i]] = (unsigned char)i;
+    }
+};
+
+static const base64_decode_table base64_lookup;
 
 
 std::string base64::p_encode(unsigned char const* bytes_to_encode, unsigned int in_len) {
-    std::string ret;
-    int i = 0;
-    int j = 0;
-    unsigned char char_array_3[3];
-    unsigned char char_array_4[4];
-    
-    while (in_len--) {
-        char_array_3[i++] = *(bytes_to_encode++);
-        if (i == 3) {
-            char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-            char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-            char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-            char_array_4[3] = char_array_3[2] & 0x3f;
-            
-            for(i = 0; (i <4) ; i++)
-                ret += base64_chars[char_array_4[i]];
-            i = 0;
-        }
+    
+    std::string ret(((in_len + 2) / 3) * 4, '\0');
+    char * out = &ret[0];
+    
+    unsigned int full = in_len - (in_len % 3);
+    unsigned int in_ = 0;
+    
+    for (; in_ < full; in_ += 3) {
+        unsigned int triple = ((unsigned int)bytes_to_encode[in_] << 16) | ((unsigned int)bytes_to_encode[in_ + 1] << 8) | bytes_to_encode[in_ + 2];
+        *out++ = base64_chars[(triple >> 18) & 0x3f];
+        *out++ = base64_chars[(triple >> 12) & 0x3f];
+        *out++ = base64_chars[(triple >> 6) & 0x3f];
+        *out++ = base64_chars[triple & 0x3f];
     }
     
-    if (i)
-    {
-        for(j = i; j < 3; j++)
-            char_array_3[j] = '\0';
-        
-        char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-        char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-        char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-        char_array_4[3] = char_array_3[2] & 0x3f;
-        
-        for (j = 0; (j < i + 1); j++)
-            ret += base64_chars[char_array_4[j]];
-        
-        while((i++ < 3))
-            ret += '=';
-        
+    if (in_len - full == 1) {
+        unsigned int triple = (unsigned int)bytes_to_encode[in_] << 16;
+        *out++ = base64_chars[(triple >> 18) & 0x3f];
+        *out++ = base64_chars[(triple >> 12) & 0x3f];
+        *out++ = '=';
+        *out++ = '=';
+    }
+    else if (in_len - full == 2) {
+        unsigned int triple = ((unsigned int)bytes_to_encode[in_] << 16) | ((unsigned int)bytes_to_encode[in_ + 1] << 8);
+        *out++ = base64_chars[(triple >> 18) & 0x3f];
+        *out++ = base64_chars[(triple >> 12) & 0x3f];
+        *out++ = base64_chars[(triple >> 6) & 0x3f];
+        *out++ = '=';
     }
     
     return ret;
     
 }
 
-std::string base64::p_decode(std::string const& encoded_string) {
-    int in_len = encoded_string.size();
-    int i = 0;
-    int j = 0;
-    int in_ = 0;
-    unsigned char char_array_4[4], char_array_3[3];
-    std::string ret;
-    
-    while (in_len-- && ( encoded_string[in_] != '=') && is_base64(encoded_string[in_])) {
-        char_array_4[i++] = encoded_string[in_]; in_++;
-        if (i ==4) {
-            for (i = 0; i <4; i++)
-                char_array_4[i] = base64_chars.find(char_array_4[i]);
-            
-            char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-            char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-            char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-            
-            for (i = 0; (i < 3); i++)
-                ret += char_array_3[i];
-            i = 0;
-        }
+
+// Length of the leading run of base64 characters, which is all that gets decoded.
+static std::size_t valid_prefix(char const* in, std::size_t length) {
+    std::size_t n = 0;
+    while (n < length && base64_lookup.value[(unsigned char)in[n]] != BASE64_INVALID)
+        n++;
+    return n;
+}
+
+static std::size_t decoded_length(std::size_t validChars) {
+    std::size_t tail = validChars % 4;
+    return (validChars / 4) * 3 + (tail ? tail - 1 : 0);
+}
+
+
+std::size_t base64::decodeTo(char const* in, std::size_t length, char* out, std::size_t outCapacity) {
+    
+    std::size_t valid = valid_prefix(in, length);
+    std::size_t full = valid - (valid % 4);
+    std::size_t written = 0;
+    std::size_t in_ = 0;
+    
+    const unsigned char * table = base64_lookup.value;
+    
+    for (; in_ < full && written + 3 <= outCapacity; in_ += 4) {
+        unsigned int quad = ((unsigned int)table[(unsigned char)in[in_]] << 18)
+                          | ((unsigned int)table[(unsigned char)in[in_ + 1]] << 12)
+                          | ((unsigned int)table[(unsigned char)in[in_ + 2]] << 6)
+                          | (unsigned int)table[(unsigned char)in[in_ + 3]];
+        out[written++] = (char)((quad >> 16) & 0xff);
+        out[written++] = (char)((quad >> 8) & 0xff);
+        out[written++] = (char)(quad & 0xff);
     }
     
-    if (i) {
-        for (j = i; j <4; j++)
-            char_array_4[j] = 0;
-        
-        for (j = 0; j <4; j++)
-            char_array_4[j] = base64_chars.find(char_array_4[j]);
-        
-        char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-        char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-        char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
+    if (in_ < full) // Ran out of room mid-stream; hand back the whole groups we managed.
+        return written;
+    
+    std::size_t tail = valid - full;
+    if (tail > 1) {
+        unsigned int quad = ((unsigned int)table[(unsigned char)in[in_]] << 18)
+                          | ((unsigned int)table[(unsigned char)in[in_ + 1]] << 12);
+        if (tail == 3)
+            quad |= (unsigned int)table[(unsigned char)in[in_ + 2]] << 6;
         
-        for (j = 0; (j < i - 1); j++) ret += char_array_3[j];
+        for (std::size_t j = 0; j < tail - 1 && written < outCapacity; j++)
+            out[written++] = (char)((quad >> (16 - 8 * j)) & 0xff);
     }
     
+    return written;
+}
+
+
+std::size_t base64::p_decodedLength(std::string const& encoded_string) {
+    return decoded_length(valid_prefix(encoded_string.data(), encoded_string.size()));
+}
+
+
+std::string base64::p_decode(std::string const& encoded_string) {
+    
+    std::string ret(p_decodedLength(encoded_string), '\0');
+    if (!ret.empty())
+        decodeTo(encoded_string.data(), encoded_string.size(), &ret[0], ret.size());
+    
     return ret;
 }
+
+
+bool base64::p_equalsDecoded(std::string const& plain) const {
+    
+    if (p_decodedLength(m_data) != plain.size()) // Cheap rejection before doing any decoding.
+        return false;
+    
+    return p_decode(m_data) == plain;
+}
@@ -5,6 +5,7 @@
 
 
 #include <string>
+#include <cstddef>
 
 
 class base64 {
@@ -15,22 +16,35 @@ public:
     
     
     std::string encoded() const {return m_data;};
-    std::string decoded() {return p_decode(m_data);};
+    std::string decoded() const {return p_decode(m_data);};
+    
+    
+    // Buffer API, for callers that want to decode without building a std::string.
+    // Decoding stops at the first '=' or non-base64 character, same as decoded().
+    
+    static std::size_t decodedSizeBound(std::size_t encodedLength){return (encodedLength / 4) * 3 + 3;}
+    
+    // Writes at most outCapacity bytes to out and returns how many were written.
+    // A buffer of decodedSizeBound(length) bytes is always big enough.
+    static std::size_t decodeTo(char const* in, std::size_t length, char* out, std::size_t outCapacity);
+    std::size_t decodeTo(char* out, std::size_t outCapacity) const {return decodeTo(m_data.data(), m_data.size(), out, outCapacity);};
     
     
     // Our Operator Overloads
     friend std::string& operator<< (std::string& left, base64& right){ left = right.p_decode(right.encoded()); return left;};
     friend base64 operator>> (std::string& left, base64& right){right = base64(left); return right;};
     
-    inline bool operator==(const std::string& lhs){ if(lhs == p_decode(m_data)){return true;}else{return false;}};
+    inline bool operator==(const std::string& lhs){ return p_equalsDecoded(lhs); };
     inline bool operator==(const base64& lhs){ if(lhs.encoded() == m_data){return true;}else{return false;}};
     
     
     
 private:
     
-    std::string p_encode(unsigned char const* , unsigned int len);
-    std::string p_decode(std::string const& s);
+    static std::string p_encode(unsigned char const* , unsigned int len);
+    static std::string p_decode(std::string const& s);
+    static std::size_t p_decodedLength(std::string const& s);
+    bool p_equalsDecoded(std::string const& plain) const;
     
     std::string m_data;
     
@@ -25,6 +25,7 @@
 #define OT_ATOMIC_ISFALSE(THE_VAL) (false == THE_VAL)
 #define OT_STD_FUNCTION(FUNC_TYPE) std::function< FUNC_TYPE >
 #define OT_STD_BIND std::bind
+#define OT_CHRONO std::chrono
 #else
 #include <boost/chrono.hpp>
 #include <boost/thread.hpp>
@@ -42,6 +43,7 @@
 #define OT_ATOMIC_ISFALSE(THE_VAL) (false == THE_VAL)
 #define OT_STD_FUNCTION(FUNC_TYPE) std::tr1::function< FUNC_TYPE >
 #define OT_STD_BIND std::tr1::bind
+#define OT_CHRONO boost::chrono
 #ifndef nullptr
 #define nullptr NULL
 #endif
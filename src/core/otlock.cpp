@@ -0,0 +1,87 @@
+#ifndef __STABLE_HPP__
+#include <core/stable.hpp>
+#endif
+
+#include <core/otlock.hpp>
+
+#include <QCoreApplication>
+#include <QAbstractEventDispatcher>
+#include <QThread>
+
+
+MTOTLock * MTOTLock::s_pInstance = NULL;
+
+//static
+QMutex & MTOTLock::mutex()
+{
+    static QMutex theMutex(QMutex::Recursive);
+    return theMutex;
+}
+
+MTOTLock::MTOTLock()
+: QObject(QCoreApplication::instance())
+, m_bHeld(false)
+{
+}
+
+//static
+void MTOTLock::install()
+{
+    if (NULL != s_pInstance)
+        return;
+
+    QAbstractEventDispatcher * pDispatcher = QAbstractEventDispatcher::instance();
+
+    if (NULL == pDispatcher)
+        return;
+
+    s_pInstance = new MTOTLock;
+
+    mutex().lock();
+    s_pInstance->m_bHeld = true;
+
+    connect(pDispatcher, SIGNAL(aboutToBlock()), s_pInstance, SLOT(onAboutToBlock()), Qt::DirectConnection);
+    connect(pDispatcher, SIGNAL(awake()),        s_pInstance, SLOT(onAwake()),        Qt::DirectConnection);
+}
+
+void MTOTLock::onAboutToBlock()
+{
+    if (m_bHeld && (QThread::currentThread()->loopLevel() <= 1))
+    {
+        m_bHeld = false;
+        mutex().unlock();
+    }
+}
+
+// In a nested loop it's only let go of on purpose, by a GuiRelease.
+//
+void MTOTLock::onAwake()
+{
+    if (!m_bHeld && (QThread::currentThread()->loopLevel() <= 1))
+    {
+        mutex().lock(); // Waits if the executor is in the middle of a call.
+        m_bHeld = true;
+    }
+}
+
+// --------------------------------------------
+
+MTOTLock::GuiRelease::GuiRelease()
+: m_bReleased(false)
+{
+    if ((NULL != s_pInstance) && s_pInstance->m_bHeld && (QThread::currentThread() == s_pInstance->thread()))
+    {
+        s_pInstance->m_bHeld = false;
+        mutex().unlock();
+        m_bReleased = true;
+    }
+}
+
+MTOTLock::GuiRelease::~GuiRelease()
+{
+    if (m_bReleased)
+    {
+        mutex().lock();
+        s_pInstance->m_bHeld = true;
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef OTLOCK_HPP
+#define OTLOCK_HPP
+
+#include <QObject>
+#include <QMutex>
+
+
+// OTAPI isn't thread-safe, and it's called from the GUI thread and from the RPC
+// OT executor. Everything that goes into OT holds this lock.
+//
+// The GUI thread calls OT from too many places to lock each one, so it holds
+// the lock whenever it's handling events, and lets go only while its main event
+// loop waits for more. (Not in a nested loop: a modal dialog, or the password
+// callback, may be in the middle of an OT call.) The executor takes the lock
+// for each call, so an RPC call runs between two GUI events, never during one.
+//
+class MTOTLock : public QObject
+{
+    Q_OBJECT
+
+public:
+    static QMutex & mutex();
+
+    // GUI thread, once the application object exists.
+    static void install();
+
+    // GUI thread. Lets go of the lock for as long as it's in scope, so it can
+    // wait for a call on the executor without deadlocking.
+    class GuiRelease
+    {
+    public:
+        GuiRelease();
+        ~GuiRelease();
+
+    private:
+        bool m_bReleased;
+    };
+
+private slots:
+    void onAboutToBlock();
+    void onAwake();
+
+private:
+    MTOTLock();
+
+    static MTOTLock * s_pInstance;
+
+    bool m_bHeld;
+};
+
+#endif // OTLOCK_HPP
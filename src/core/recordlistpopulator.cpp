@@ -0,0 +1,221 @@
+#ifndef __STABLE_HPP__
+#include <core/stable.hpp>
+#endif
+
+#include <core/recordlistpopulator.hpp>
+#include <core/handlers/contacthandler.hpp>
+#include <core/network/Network.h>
+#include <core/otlock.hpp>
+
+#include <QMutexLocker>
+#include <QElapsedTimer>
+#include <QDebug>
+
+
+namespace
+{
+
+// An OTRecordList only keeps a reference to its name lookup, and the lists built
+// here outlive any one job. MTNameLookupQT has no state of its own (names come
+// from MTNameCache), so they all share this one.
+//
+opentxs::OTNameLookup & recordListNameLookup()
+{
+    static MTNameLookupQT theLookup;
+    return theLookup;
+}
+
+// One message from a transport, waiting to be added to the record list.
+//
+struct FetchedMail
+{
+    std::string messageId;
+    bool        bIsOutgoing = false;
+    int         nMethodID   = 0;
+    std::string contents;
+    std::string myAddress;
+    std::string otherAddress;
+    std::string methodType;
+    std::string methodTypeDisplay;
+    std::string nymId;
+    time64_t    tTime       = 0;
+};
+
+QString formatMail(const _SharedPtr<NetworkMail> & theMsg, const QString & qstrSubjectLabel)
+{
+    const std::string strSubject  = theMsg->getSubject();
+    const std::string strContents = theMsg->getMessage();
+
+    if (strSubject.empty())
+        return QString::fromStdString(strContents);
+
+    return QString("%1: %2\n%3").
+            arg(qstrSubjectLabel).
+            arg(QString::fromStdString(strSubject)).
+            arg(QString::fromStdString(strContents));
+}
+
+void addMail(const MTRecordListJob::MailSource & theSource,
+             const std::vector< _SharedPtr<NetworkMail> > & theBox, bool bIsOutgoing,
+             const QString & qstrSubjectLabel, std::vector<FetchedMail> & vecOutput)
+{
+    for (std::vector< _SharedPtr<NetworkMail> >::const_iterator it = theBox.begin(); it != theBox.end(); ++it)
+    {
+        const _SharedPtr<NetworkMail> & theMsg = *it;
+
+        FetchedMail theMail;
+        theMail.messageId         = theMsg->getMessageID();
+        theMail.bIsOutgoing       = bIsOutgoing;
+        theMail.nMethodID         = theSource.nMethodID;
+        theMail.contents          = formatMail(theMsg, qstrSubjectLabel).toStdString();
+        theMail.myAddress         = bIsOutgoing ? theMsg->getFrom() : theMsg->getTo();
+        theMail.otherAddress      = bIsOutgoing ? theMsg->getTo()   : theMsg->getFrom();
+        theMail.methodType        = theSource.methodType;
+        theMail.methodTypeDisplay = theSource.methodTypeDisplay;
+        theMail.nymId             = theSource.nymId;
+        theMail.tTime             = static_cast<time64_t>(bIsOutgoing ? theMsg->getSentTime() : theMsg->getReceivedTime());
+
+        vecOutput.push_back(theMail);
+    }
+}
+
+// Fetches every mailbox on one transport. Each call into the module holds the
+// OT lock, since the GUI thread uses the same modules (and holds that lock
+// while it does.) In between calls, the GUI gets a turn.
+//
+void fetchTransportMail(const MTRecordListJob::MailTransport & theTransport,
+                        const QString & qstrSubjectLabel, std::vector<FetchedMail> & vecOutput)
+{
+    NetworkModule * pModule = theTransport.pModule;
+
+    if (NULL == pModule)
+        return;
+    {
+        QMutexLocker locker(&MTOTLock::mutex());
+
+        if (!pModule->accessible())
+            return;
+
+        pModule->checkMail(); // Once per connect string.
+    }
+
+    for (std::vector<MTRecordListJob::MailSource>::const_iterator it_source = theTransport.sources.begin();
+         it_source != theTransport.sources.end(); ++it_source)
+    {
+        const MTRecordListJob::MailSource & theSource = *it_source;
+
+        for (std::vector<std::string>::const_iterator it_address = theSource.addresses.begin();
+             it_address != theSource.addresses.end(); ++it_address)
+        {
+            std::vector< _SharedPtr<NetworkMail> > theInbox, theOutbox;
+            {
+                QMutexLocker locker(&MTOTLock::mutex());
+                theInbox = pModule->getInbox(*it_address);
+            }
+            {
+                QMutexLocker locker(&MTOTLock::mutex());
+                theOutbox = pModule->getOutbox(*it_address);
+            }
+            addMail(theSource, theInbox,  false, qstrSubjectLabel, vecOutput);
+            addMail(theSource, theOutbox, true,  qstrSubjectLabel, vecOutput);
+        }
+    }
+}
+
+} // namespace
+
+
+MTRecordListPopulator::MTRecordListPopulator(QObject * parent /*=0*/)
+: QObject(parent)
+{
+}
+
+//static
+void MTRecordListPopulator::registerMetaTypes()
+{
+    qRegisterMetaType<MTRecordListJob>("MTRecordListJob");
+    qRegisterMetaType<MTRecordListSnapshotPtr>("MTRecordListSnapshotPtr");
+}
+
+//static
+void MTRecordListPopulator::setupRecordList(opentxs::OTRecordList & theList, const MTRecordListJob & job)
+{
+    theList.ClearServers();
+    theList.ClearAssets();
+    theList.ClearNyms();
+    theList.ClearAccounts();
+    // ----------------------------------------------------
+    for (std::vector<std::string>::const_iterator it = job.notaryIds.begin(); it != job.notaryIds.end(); ++it)
+        theList.AddNotaryID(*it);
+
+    for (std::vector<std::string>::const_iterator it = job.assetIds.begin(); it != job.assetIds.end(); ++it)
+        theList.AddInstrumentDefinitionID(*it);
+
+    for (std::vector<std::string>::const_iterator it = job.nymIds.begin(); it != job.nymIds.end(); ++it)
+        theList.AddNymID(*it);
+
+    for (std::vector<std::string>::const_iterator it = job.accountIds.begin(); it != job.accountIds.end(); ++it)
+        theList.AddAccountID(*it);
+    // ----------------------------------------------------
+    theList.AcceptChequesAutomatically  (true);
+    theList.AcceptReceiptsAutomatically (true);
+    theList.AcceptTransfersAutomatically(false);
+}
+
+void MTRecordListPopulator::populate(MTRecordListJob job)
+{
+    MTRecordListSnapshot * pSnapshot = new MTRecordListSnapshot;
+    pSnapshot->nSequence = job.nSequence;
+    pSnapshot->bFollowUp = job.bFollowUp;
+    pSnapshot->pList     = _SharedPtr<opentxs::OTRecordList>(new opentxs::OTRecordList(recordListNameLookup()));
+
+    opentxs::OTRecordList & theList = *pSnapshot->pList;
+
+    QElapsedTimer timer;
+    timer.start();
+    // ----------------------------------------------------
+    // Bitmessage (etc) for the Nyms that we care about, one connect string at a time.
+    //
+    std::vector<FetchedMail> vecFetched;
+
+    for (std::vector<MTRecordListJob::MailTransport>::const_iterator it = job.transports.begin();
+         it != job.transports.end(); ++it)
+        fetchTransportMail(*it, job.qstrSubjectLabel, vecFetched);
+
+    pSnapshot->msFetchMail = timer.restart();
+    // ----------------------------------------------------
+    // AddSpecialMsg looks up names through OTAPI as well, so the merge happens
+    // under the same lock.
+    //
+    QMutexLocker locker(&MTOTLock::mutex()); // Waits while the GUI thread is handling an event.
+
+    setupRecordList(theList, job);
+
+    theList.Populate(); // Refreshes the OT data from local storage.
+
+    pSnapshot->msPopulate = timer.restart();
+    // ----------------------------------------------------
+    for (std::vector<FetchedMail>::const_iterator it = vecFetched.begin(); it != vecFetched.end(); ++it)
+    {
+        if (!it->messageId.empty())
+            theList.AddSpecialMsg(it->messageId,
+                                  it->bIsOutgoing,
+                                  static_cast<int32_t>(it->nMethodID),
+                                  it->contents,
+                                  it->myAddress,
+                                  it->otherAddress,
+                                  it->methodType,
+                                  it->methodTypeDisplay,
+                                  it->nymId,
+                                  it->tTime);
+    }
+
+    if (!vecFetched.empty())
+        theList.SortRecords();
+
+    pSnapshot->msMerge = timer.elapsed();
+
+    locker.unlock();
+    // ----------------------------------------------------
+    emit recordListReady(MTRecordListSnapshotPtr(pSnapshot));
+}
@@ -0,0 +1,106 @@
+#ifndef RECORDLISTPOPULATOR_HPP
+#define RECORDLISTPOPULATOR_HPP
+
+#include "core/WinsockWrapper.h"
+#include "core/ExportWrapper.h"
+#include "core/TR1_Wrapper.hpp"
+
+#include <opentxs/client/OTRecordList.hpp>
+
+#include _MEMORY
+
+#include <QObject>
+#include <QString>
+#include <QSharedPointer>
+#include <QMetaType>
+
+#include <string>
+#include <vector>
+
+class NetworkModule;
+
+
+// Everything the populator needs to build a record list, gathered on the GUI
+// thread. (The mail sources come from the local database, and MTComms isn't
+// thread-safe, so the network modules are looked up there as well.)
+//
+struct MTRecordListJob
+{
+    quint64 nSequence  = 0;
+    bool    bFollowUp  = false; // Reloading after records were archived, so don't archive again.
+
+    std::vector<std::string> notaryIds;
+    std::vector<std::string> assetIds;
+    std::vector<std::string> nymIds;
+    std::vector<std::string> accountIds;
+
+    // One Nym's addresses on one messaging method.
+    struct MailSource
+    {
+        std::string nymId;
+        int         nMethodID = 0;
+        std::string methodType;
+        std::string methodTypeDisplay;
+        std::vector<std::string> addresses;
+    };
+    // Every source that goes through the same connect string, so checkMail()
+    // runs once per transport.
+    struct MailTransport
+    {
+        NetworkModule *         pModule = nullptr;
+        std::vector<MailSource> sources;
+    };
+    std::vector<MailTransport> transports;
+
+    QString qstrSubjectLabel; // tr("Subject"), which has to be translated on the GUI thread.
+};
+
+// The finished record list, plus how long each stage took. Once it's handed
+// over, the populator doesn't touch it again.
+//
+struct MTRecordListSnapshot
+{
+    quint64 nSequence   = 0;
+    bool    bFollowUp   = false;
+    _SharedPtr<opentxs::OTRecordList> pList;
+
+    qint64  msPopulate  = 0; // OTRecordList::Populate()
+    qint64  msFetchMail = 0; // checkMail, getInbox and getOutbox on every transport.
+    qint64  msMerge     = 0; // AddSpecialMsg and SortRecords.
+};
+
+typedef QSharedPointer<const MTRecordListSnapshot> MTRecordListSnapshotPtr;
+
+Q_DECLARE_METATYPE(MTRecordListJob)
+Q_DECLARE_METATYPE(MTRecordListSnapshotPtr)
+
+
+// Builds record lists on a worker thread, so populating doesn't freeze the GUI.
+// Moneychanger moves it to its own QThread and queues jobs to populate().
+//
+// Populate() goes through OTAPI, so it holds MTOTLock, the same as the RPC
+// executor. The name lookups it makes use this thread's own database connection.
+// MTComms and its network modules aren't thread-safe either, and the GUI thread
+// uses them while it holds MTOTLock, so each call into a module takes the lock
+// as well. (One call at a time, so a slow transport holds up the GUI for no more
+// than a single checkMail or getInbox.)
+//
+class MTRecordListPopulator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MTRecordListPopulator(QObject * parent = 0);
+
+    static void registerMetaTypes(); // Before the first queued job.
+
+    static void setupRecordList(opentxs::OTRecordList & theList, const MTRecordListJob & job);
+
+signals:
+    void recordListReady(MTRecordListSnapshotPtr snapshot);
+
+public slots:
+    void populate(MTRecordListJob job);
+};
+
+#endif // RECORDLISTPOPULATOR_HPP
@@ -11,7 +11,9 @@
 Translation::Translation(QObject *parent) :
     QObject(parent)
 {
-    if (DBHandler::getInstance()->querySize("SELECT `setting`,`parameter1` FROM `settings` WHERE `setting`='language'") <= 0)
+    bool bQueryFailed = false; // Then the row may be there; don't insert over it.
+
+    if (!DBHandler::getInstance()->queryExists("SELECT `setting` FROM `settings` WHERE `setting`=?", QVariantList() << "language", &bQueryFailed) && !bQueryFailed)
     {
         DBHandler::getInstance()->runQuery(QString("INSERT INTO `settings` (`setting`, `parameter1`) VALUES('language','%1')").arg(QLocale::system().name()));
         ui_language = QLocale::system().name();
@@ -10,6 +10,8 @@
 
 #include <core/modules.hpp>
 
+#include <opentxs/core/util/OTPaths.hpp>
+
 
 BtcAddPoolServer::BtcAddPoolServer(QWidget *parent) :
     QWidget(parent, Qt::Window),
@@ -48,6 +50,8 @@ void BtcAddPoolServer::on_buttonCreate_clicked()
     EscrowPoolPtr pool = Modules::poolManager->GetPoolByName(Modules::poolManager->selectedPool);
 
     SampleEscrowServerZmqPtr server = SampleEscrowServerZmqPtr(new SampleEscrowServerZmq(Modules::connectionManager->rpcServer, pool, port));
+    // one ledger per port, so the server finds its deposits again after a restart
+    server->SetLedgerFile(std::string(opentxs::OTPaths::AppDataFolder().Get()) + "mc_escrowledger_" + btc::to_string(port));
     pool->AddEscrowServer(server);
 
     this->hide();
@@ -11,6 +11,11 @@
 
 #include <bitcoin-api/btctest.hpp>
 
+#include <core/network/NetworkTest.h>
+#include <core/handlers/handlertest.hpp>
+
+#include <rpc/rpctest.h>
+
 #include <opentxs/core/Log.hpp>
 
 
@@ -40,6 +45,21 @@ void BtcGuiTest::on_testButton_clicked()
         opentxs::Log::Output(0, "Error testing bitcoin functionality.\nMaybe test environment is not set up properly?");
     }
 
+    if(NetworkTest::TestNetworkFunctions())
+        opentxs::Log::Output(0, "Successfully tested the Bitmessage queue and base64 codec.\n");
+    else
+        opentxs::Log::Output(0, "Error testing the Bitmessage queue or base64 codec.\n");
+
+    if(HandlerTest::TestHandlerFunctions())
+        opentxs::Log::Output(0, "Successfully tested the core handlers.\n");
+    else
+        opentxs::Log::Output(0, "Error testing the core handlers.\n");
+
+    if(RPCTest::TestRPCFunctions())
+        opentxs::Log::Output(0, "Successfully load-tested the RPC dispatcher.\n");
+    else
+        opentxs::Log::Output(0, "Error load-testing the RPC dispatcher.\n");
+
     /*  deprecated:
     if(!Modules::btcInterface->TestBtcJson())
         opentxs::Log::vOutput(0, "Error testing bitcoin integration. Maybe test environment is not set up.\n");
@@ -40,7 +40,9 @@ Settings::Settings(QWidget *parent) :
     ui->comboBoxLanguage->blockSignals(false);
 #endif
     // *************************************************************
-    if (DBHandler::getInstance()->querySize("SELECT `setting`,`parameter1` FROM `settings` WHERE `setting`='expertmode'") <= 0)
+    bool bQueryFailed = false; // Then the row may be there; don't insert over it.
+
+    if (!DBHandler::getInstance()->queryExists("SELECT `setting` FROM `settings` WHERE `setting`=?", QVariantList() << "expertmode", &bQueryFailed) && !bQueryFailed)
     {
         DBHandler::getInstance()->runQuery(QString("INSERT INTO `settings` (`setting`, `parameter1`) VALUES('expertmode','off')"));
         qDebug() << "expertmode setting wasn't set in the database. Setting to 'off'.";
@@ -58,7 +60,7 @@ Settings::Settings(QWidget *parent) :
         ui->checkBoxExpertMode->setChecked(false);
     ui->checkBoxExpertMode->blockSignals(false);
     // *************************************************************
-    if (DBHandler::getInstance()->querySize("SELECT `setting`,`parameter1` FROM `settings` WHERE `setting`='hidenav'") <= 0)
+    if (!DBHandler::getInstance()->queryExists("SELECT `setting` FROM `settings` WHERE `setting`=?", QVariantList() << "hidenav", &bQueryFailed) && !bQueryFailed)
     {
         DBHandler::getInstance()->runQuery(QString("INSERT INTO `settings` (`setting`, `parameter1`) VALUES('hidenav','off')"));
         qDebug() << "hide navigation setting wasn't set in the database. Setting to 'off'.";
@@ -11,6 +11,15 @@
 #include <QEventLoop>
 #include <QThreadPool>
 #include <QRunnable>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QCryptographicHash>
+#include <QMetaMethod>
+
+#include <qjsonrpcmessage.h>
+
+#include <algorithm>
+#include <utility>
 
 #include <opentxs/client/OTAPI.hpp>
 #include <opentxs/client/OTAPI_Exec.hpp>
@@ -18,6 +27,8 @@
 #include <opentxs/core/Log.hpp>
 
 #include <core/moneychanger.hpp>
+#include "rpceventlog.h"
+#include "rpcmetrics.h"
 #include <core/handlers/contacthandler.hpp>
 
 
@@ -1845,6 +1856,12 @@ QJsonValue MCRPCService::setNymName(QString Username, QString APIKey,
     bool result = opentxs::OTAPI_Wrap::It()->SetNym_Name(NymID.toStdString(),
                                                          SignerNymID.toStdString(),
                                                          NewName.toStdString());
+    if (result)
+    {
+        // Drop the cached name right away for the other RPC calls; menus and lists refresh on the GUI thread.
+        MTNameCache::getInstance()->invalidateNym(NymID.toStdString());
+        QMetaObject::invokeMethod(Moneychanger::It(), "onNymsChanged", Qt::QueuedConnection);
+    }
     QJsonObject object{{"SetNymNameResult", result}};
     return QJsonValue(object);
 }
@@ -1864,6 +1881,11 @@ QJsonValue MCRPCService::setServerName(QString Username, QString APIKey,
 
     bool result = opentxs::OTAPI_Wrap::It()->SetServer_Name(NotaryID.toStdString(),
                                                             NewName.toStdString());
+    if (result)
+    {
+        MTNameCache::getInstance()->invalidate(MTNameCache::ServerName, NotaryID.toStdString());
+        QMetaObject::invokeMethod(Moneychanger::It(), "onServersChanged", Qt::QueuedConnection);
+    }
     QJsonObject object{{"SetServerNameResult", result}};
     return QJsonValue(object);
 }
@@ -1883,6 +1905,11 @@ QJsonValue MCRPCService::setAssetTypeName(QString Username, QString APIKey,
 
     bool result = opentxs::OTAPI_Wrap::It()->SetAssetType_Name(InstrumentDefinitionID.toStdString(),
                                                                NewName.toStdString());
+    if (result)
+    {
+        MTNameCache::getInstance()->invalidate(MTNameCache::AssetName, InstrumentDefinitionID.toStdString());
+        QMetaObject::invokeMethod(Moneychanger::It(), "onAssetsChanged", Qt::QueuedConnection);
+    }
     QJsonObject object{{"SetAssetTypeNameResult", result}};
     return QJsonValue(object);
 }
@@ -2305,6 +2332,12 @@ QJsonValue MCRPCService::setAccountWalletName(QString Username, QString APIKey,
     bool result = opentxs::OTAPI_Wrap::It()->SetAccountWallet_Name(AccountID.toStdString(),
                                                                    SignerNymID.toStdString(),
                                                                    AccountName.toStdString());
+    if (result)
+    {
+        // Account names are cached under id|nym|notary|asset, so there's no one key to drop.
+        MTNameCache::getInstance()->invalidateType(MTNameCache::AcctName);
+        QMetaObject::invokeMethod(Moneychanger::It(), "onAccountsChanged", Qt::QueuedConnection);
+    }
     QJsonObject object{{"SetAccountWalletNameResult", result}};
     return QJsonValue(object);
 }
@@ -7018,18 +7051,64 @@ QJsonValue MCRPCService::mcListSmartContracts(QString Username, QString APIKey)
 
 
 // RecordList Methods
+//
+// recordListPopulate is the only thing that re-reads the wallet. It converts
+// the whole list to JSON once, and Count/Retrieve/Page read from that snapshot
+// until the next populate. (The first read populates if nobody has yet.)
+
+
+//static
+QJsonObject MCRPCService::recordToJson(const opentxs::OTRecord & record)
+{
+    QJsonObject object{{"AccountID", QString(record.GetAccountID().c_str())},
+                       {"Address", QString(record.GetAddress().c_str())},
+                       {"Amount", QString(record.GetAmount().c_str())},
+                       {"BoxIndex", record.GetBoxIndex()},
+                       {"Contents", QString(record.GetContents().c_str())},
+                       {"CurrencyTLA", QString(record.GetCurrencyTLA().c_str())},
+                       {"Date", QString(record.GetDate().c_str())},
+                       {"InitialPaymentAmount", qint64(record.GetInitialPaymentAmount())},
+                       {"InitialPaymentDate", qint64(record.GetInitialPaymentDate())},
+                       {"InstrumentDefinitionID", QString(record.GetInstrumentDefinitionID().c_str())},
+                       {"InstrumentType", QString(record.GetInstrumentType().c_str())},
+                       {"MaximumNoPayments", record.GetMaximumNoPayments()},
+                       {"Memo", QString(record.GetMemo().c_str())},
+                       {"MethodID", record.GetMethodID()},
+                       {"MesssageID", QString(record.GetMsgID().c_str())},
+                       {"MessageType", QString(record.GetMsgType().c_str())},
+                       {"MessageTypeDisplay", QString(record.GetMsgTypeDisplay().c_str())},
+                       {"Name", QString(record.GetName().c_str())},
+                       {"NotaryID", QString(record.GetNotaryID().c_str())},
+                       {"NymID", QString(record.GetNymID().c_str())},
+                       {"OtherAccountID", QString(record.GetOtherAccountID().c_str())},
+                       {"OtherAddress", QString(record.GetOtherAddress().c_str())},
+                       {"OtherNymID", QString(record.GetOtherNymID().c_str())},
+                       {"PaymentPlanAmount", qint64(record.GetPaymentPlanAmount())},
+                       {"PaymentPlanStartDate", qint64(record.GetPaymentPlanStartDate())},
+                       {"RecordType", record.GetRecordType()},
+                       {"TimeBetweenPayments", qint64(record.GetTimeBetweenPayments())},
+                       {"TransactionNum", qint64(record.GetTransactionNum())},
+                       {"TransNumForDisplay", qint64(record.GetTransNumForDisplay())},
+                       {"ValidFrom", qint64(record.GetValidFrom())},
+                       {"ValidTo", qint64(record.GetValidTo())}
+                      };
+    return object;
+}
 
-
-QJsonValue MCRPCService::recordListPopulate(QString Username, QString APIKey)
+MCRPCService::RecordListSnapshotPtr MCRPCService::refreshRecordList()
 {
-    if(!validateAPIKey(Username, APIKey)){
-        QJsonObject object{{"Error", "Invalid API Key"}};
-        return QJsonValue(object);
-    }
-
+    QMutexLocker populateLocker(&m_RecordListMutex);
 
+    // This runs on the OT executor. The names are looked up through this
+    // thread's own database connection (see DBHandler::connection()), and
+    // notifications of deposits are queued to the GUI thread.
     if(m_RecordList == nullptr)
-        createRecordList(Username, APIKey);
+        m_RecordList = new opentxs::OTRecordList(*(new MTNameLookupQT));
+
+    m_RecordList->ClearServers();
+    m_RecordList->ClearAssets();
+    m_RecordList->ClearNyms();
+    m_RecordList->ClearAccounts();
 
     int nServerCount  = opentxs::OTAPI_Wrap::It()->GetServerCount();
     int nAssetCount   = opentxs::OTAPI_Wrap::It()->GetAssetTypeCount();
@@ -7065,8 +7144,60 @@ QJsonValue MCRPCService::recordListPopulate(QString Username, QString APIKey)
     m_RecordList->AcceptTransfersAutomatically(false);
 
     m_RecordList->Populate();
+    // ----------------------------------------------------
+    RecordListSnapshot * pSnapshot = new RecordListSnapshot;
 
-    QJsonObject object{{"RecordListPopulated", "True"}};
+    const int count = m_RecordList->size();
+
+    for (int ii = 0; ii < count; ++ii)
+    {
+        const opentxs::OTRecord record = m_RecordList->GetRecord(ii); // One copy per record.
+        pSnapshot->Records.append(recordToJson(record));
+    }
+    // The ETag only changes when the records do, so a client can tell whether
+    // a refresh actually changed anything.
+    pSnapshot->ETag = QString(QCryptographicHash::hash(QJsonDocument(pSnapshot->Records).toJson(QJsonDocument::Compact),
+                                                       QCryptographicHash::Sha1).toHex());
+    // ----------------------------------------------------
+    QMutexLocker snapshotLocker(&m_RecordListSnapshotMutex);
+
+    pSnapshot->Version = ++m_RecordListVersion;
+    m_RecordListSnapshot = RecordListSnapshotPtr(pSnapshot);
+
+    return m_RecordListSnapshot;
+}
+
+bool MCRPCService::hasRecordListSnapshot()
+{
+    QMutexLocker snapshotLocker(&m_RecordListSnapshotMutex);
+    return !m_RecordListSnapshot.isNull();
+}
+
+MCRPCService::RecordListSnapshotPtr MCRPCService::currentRecordList()
+{
+    {
+        QMutexLocker snapshotLocker(&m_RecordListSnapshotMutex);
+
+        if (m_RecordListSnapshot)
+            return m_RecordListSnapshot;
+    }
+    qDebug() << QString("Record List not populated yet, populating it now.");
+    return refreshRecordList();
+}
+
+QJsonValue MCRPCService::recordListPopulate(QString Username, QString APIKey)
+{
+    if(!validateAPIKey(Username, APIKey)){
+        QJsonObject object{{"Error", "Invalid API Key"}};
+        return QJsonValue(object);
+    }
+
+    RecordListSnapshotPtr snapshot = refreshRecordList();
+
+    QJsonObject object{{"RecordListPopulated", "True"},
+                       {"RecordListVersion", qint64(snapshot->Version)},
+                       {"ETag", snapshot->ETag},
+                       {"RecordListCount", snapshot->Records.size()}};
 
     return object;
 }
@@ -7078,206 +7209,415 @@ QJsonValue MCRPCService::recordListCount(QString Username, QString APIKey)
         return QJsonValue(object);
     }
 
+    RecordListSnapshotPtr snapshot = currentRecordList();
 
-    QJsonObject reply_obj;
-    if(m_RecordList == nullptr)
-    {
-        qDebug() << QString("Record List Null");
-        QJsonValue reply_val = recordListPopulate(Username, APIKey);
-        reply_obj.insert("RecordListPopulated", reply_val);
-    }
+    QJsonObject object{{"RecordListCount", snapshot->Records.size()},
+                       {"RecordListVersion", qint64(snapshot->Version)},
+                       {"ETag", snapshot->ETag}};
 
-    if (m_RecordList == nullptr)
-    {
-        QJsonObject object{{"Error", "Recordlist is a null pointer."}};
-        return object;
+    return object;
+}
+
+QJsonValue MCRPCService::recordListRetrieve(QString Username, QString APIKey,
+                                            int Index)
+{
+    if(!validateAPIKey(Username, APIKey)){
+        QJsonObject object{{"Error", "Invalid API Key"}};
+        return QJsonValue(object);
     }
-    /*
-    if (QJsonValue("True") != reply_obj.value("RecordListPopulated"))
-    {
-        qDebug() << QString("Recordlist didn't populate properly: %1").arg(reply_obj.value("RecordListPopulated").toString());
-        QJsonObject object{{"Error", QString("Recordlist didn't populate properly: %1").arg(reply_obj.value("RecordListPopulated").toString())}};
+
+    RecordListSnapshotPtr snapshot = currentRecordList();
+    int count = snapshot->Records.size();
+
+    if(Index >= count || Index < 0){
+        QJsonObject object{{"Error", "Out of Bound Request"}};
         return object;
     }
-*/
-    m_RecordList->Populate();
-    int count = m_RecordList->size();
 
-    QJsonObject object{{"RecordListCount", count}};
+    QJsonObject object;
+    object.insert(QString::number(Index), snapshot->Records.at(Index));
 
     return object;
 }
 
 QJsonValue MCRPCService::recordListRetrieve(QString Username, QString APIKey,
-                                            int Index)
+                                            int BeginIndex, int EndIndex)
 {
     if(!validateAPIKey(Username, APIKey)){
         QJsonObject object{{"Error", "Invalid API Key"}};
         return QJsonValue(object);
     }
 
+    //enum OTRecordType { Mail = 0, Transfer, Receipt, Instrument,ErrorState };
 
-    //if(m_RecordList == nullptr)
-    //    recordListPopulate(Username, APIKey);
-    m_RecordList->Populate();
-    int count = m_RecordList->size();
+    RecordListSnapshotPtr snapshot = currentRecordList();
+    int count = snapshot->Records.size();
 
-    if(Index >= count)
-        Index = count;
+    // Swap if Begin > End
+    if(BeginIndex > EndIndex)
+        std::swap(BeginIndex, EndIndex);
 
-    if(Index < 0)
-        Index = 0;
+    if(BeginIndex < 0)
+        BeginIndex = 0;
 
+    if(BeginIndex > count){
+        QJsonObject object{{"Error", "Out of Bound Request"}};
+        return object;
+    }
 
+    if(EndIndex > count)
+        EndIndex = count;
 
     QJsonObject object;
+    for(auto x = BeginIndex; x < EndIndex; x++)
+        object.insert(QString::number(x), snapshot->Records.at(x));
 
-    QJsonObject record{{"AccountID", QString(m_RecordList->GetRecord(Index).GetAccountID().c_str())},
-                       {"Address", QString(m_RecordList->GetRecord(Index).GetAddress().c_str())},
-                       {"Amount", QString(m_RecordList->GetRecord(Index).GetAmount().c_str())},
-                       {"BoxIndex", m_RecordList->GetRecord(Index).GetBoxIndex()},
-                       {"Contents", QString(m_RecordList->GetRecord(Index).GetContents().c_str())},
-                       {"CurrencyTLA", QString(m_RecordList->GetRecord(Index).GetCurrencyTLA().c_str())},
-                       {"Date", QString(m_RecordList->GetRecord(Index).GetDate().c_str())},
-                       {"InitialPaymentAmount", qint64(m_RecordList->GetRecord(Index).GetInitialPaymentAmount())},
-                       {"InitialPaymentDate", qint64(m_RecordList->GetRecord(Index).GetInitialPaymentDate())},
-                       {"InstrumentDefinitionID", QString(m_RecordList->GetRecord(Index).GetInstrumentDefinitionID().c_str())},
-                       {"InstrumentType", QString(m_RecordList->GetRecord(Index).GetInstrumentType().c_str())},
-                       {"MaximumNoPayments", m_RecordList->GetRecord(Index).GetMaximumNoPayments()},
-                       {"Memo", QString(m_RecordList->GetRecord(Index).GetMemo().c_str())},
-                       {"MethodID", m_RecordList->GetRecord(Index).GetMethodID()},
-                       {"MesssageID", QString(m_RecordList->GetRecord(Index).GetMsgID().c_str())},
-                       {"MessageType", QString(m_RecordList->GetRecord(Index).GetMsgType().c_str())},
-                       {"MessageTypeDisplay", QString(m_RecordList->GetRecord(Index).GetMsgTypeDisplay().c_str())},
-                       {"Name", QString(m_RecordList->GetRecord(Index).GetName().c_str())},
-                       {"NotaryID", QString(m_RecordList->GetRecord(Index).GetNotaryID().c_str())},
-                       {"NymID", QString(m_RecordList->GetRecord(Index).GetNymID().c_str())},
-                       {"OtherAccountID", QString(m_RecordList->GetRecord(Index).GetOtherAccountID().c_str())},
-                       {"OtherAddress", QString(m_RecordList->GetRecord(Index).GetOtherAddress().c_str())},
-                       {"OtherNymID", QString(m_RecordList->GetRecord(Index).GetOtherNymID().c_str())},
-                       {"PaymentPlanAmount", qint64(m_RecordList->GetRecord(Index).GetPaymentPlanAmount())},
-                       {"PaymentPlanStartDate", qint64(m_RecordList->GetRecord(Index).GetPaymentPlanStartDate())},
-                       {"RecordType", m_RecordList->GetRecord(Index).GetRecordType()},
-                       {"TimeBetweenPayments", qint64(m_RecordList->GetRecord(Index).GetTimeBetweenPayments())},
-                       {"TransactionNum", qint64(m_RecordList->GetRecord(Index).GetTransactionNum())},
-                       {"TransNumForDisplay", qint64(m_RecordList->GetRecord(Index).GetTransNumForDisplay())},
-                       {"ValidFrom", qint64(m_RecordList->GetRecord(Index).GetValidFrom())},
-                       {"ValidTo", qint64(m_RecordList->GetRecord(Index).GetValidTo())}
-                      };
+    return object;
+}
+
+QJsonValue MCRPCService::recordListPage(QString Username, QString APIKey,
+                                        int BeginIndex, int EndIndex)
+{
+    if(!validateAPIKey(Username, APIKey)){
+        QJsonObject object{{"Error", "Invalid API Key"}};
+        return QJsonValue(object);
+    }
 
-    object.insert(QString(Index), record);
+    RecordListSnapshotPtr snapshot = currentRecordList();
+    int count = snapshot->Records.size();
 
+    if(BeginIndex < 0)
+        BeginIndex = 0;
+
+    if(EndIndex > count)
+        EndIndex = count;
+
+    if(BeginIndex > count || BeginIndex > EndIndex){
+        QJsonObject object{{"Error", "Out of Bound Request"},
+                           {"RecordListCount", count}};
+        return object;
+    }
+
+    QJsonArray records;
+    for(auto x = BeginIndex; x < EndIndex; x++)
+        records.append(snapshot->Records.at(x));
+
+    // Pages from different versions don't line up, so the client should start
+    // over (or call recordListPopulate) when RecordListVersion changes.
+    QJsonObject object{{"RecordListVersion", qint64(snapshot->Version)},
+                       {"ETag", snapshot->ETag},
+                       {"RecordListCount", count},
+                       {"BeginIndex", BeginIndex},
+                       {"EndIndex", EndIndex},
+                       {"Records", records}};
 
     return object;
 }
 
-QJsonValue MCRPCService::recordListRetrieve(QString Username, QString APIKey,
-                                            int BeginIndex, int EndIndex)
+
+// Batches and composite calls
+
+namespace
+{
+
+// Good for one batch. Not an API key, so a client can't send it in.
+//
+QString newBatchKey()
+{
+    opentxs::OTPassword thePassword;
+    thePassword.randomizePassword(32);
+
+    return QString(QByteArray(thePassword.getPassword(), thePassword.getPasswordSize()).toHex());
+}
+
+QJsonObject batchError(int nCode, QString qstrMessage)
+{
+    QJsonObject error{{"code", nCode},
+                      {"message", qstrMessage}};
+    return error;
+}
+
+} // namespace
+
+
+// Calls: [{"id": ..., "method": "getNymCount", "params": [...]}, ...]
+//
+// The params leave out Username and APIKey, which come from the batch itself.
+// The key is checked once, here. Each call gets a key of its own for this batch
+// instead, which validateAPIKey() accepts for this user until the batch is done.
+// Results come back in the same order, as JSON-RPC 2.0 style {"id", "result"} /
+// {"id", "error"}.
+//
+QJsonValue MCRPCService::batch(QString Username, QString APIKey, QJsonArray Calls)
 {
     if(!validateAPIKey(Username, APIKey)){
         QJsonObject object{{"Error", "Invalid API Key"}};
         return QJsonValue(object);
     }
 
+    if(Calls.size() > MaxBatchSize){
+        QJsonObject object{{"Error", QString("Too many calls in one batch (the limit is %1)").arg(MaxBatchSize)}};
+        return object;
+    }
 
-    //enum OTRecordType { Mail = 0, Transfer, Receipt, Instrument,ErrorState };
+    const QString BatchKey = beginBatch(Username);
 
-    QJsonObject reply_obj;
-    if(m_RecordList == nullptr)
-    {
-        QJsonValue reply_val = recordListPopulate(Username, APIKey);
-        reply_obj.insert("RecordListPopulated", reply_val);
+    QJsonArray results;
+    for(auto it = Calls.begin(); it != Calls.end(); ++it)
+        results.append(invokeBatchCall(Username, BatchKey, (*it).toObject()));
+
+    endBatch(Username, BatchKey);
+
+    QJsonObject object{{"BatchResults", results}};
+    return object;
+}
+
+QJsonObject MCRPCService::invokeBatchCall(QString Username, QString APIKey, const QJsonObject & call)
+{
+    QJsonObject reply;
+
+    if(call.contains("id"))
+        reply.insert("id", call.value("id"));
+
+    // Either "moneychanger.getNymCount" or just "getNymCount".
+    const QByteArray method = call.value("method").toString().section('.', -1).toLatin1();
+    const QJsonArray params = call.value("params").toArray();
+
+    // Neither can answer from inside a batch. (waitForEvents answers later.)
+    if(method.isEmpty() || method == "batch" || method == "waitForEvents"){
+        reply.insert("error", batchError(QJsonRpc::InvalidRequest, "Invalid method in batch"));
+        return reply;
     }
+    // ----------------------------------------------------
+    // Find the overload that takes this many params, not counting the credentials.
+    //
+    QMetaMethod theMethod;
 
-    if (m_RecordList == nullptr)
+    for(int ii = MCRPCService::staticMetaObject.methodOffset(); ii < MCRPCService::staticMetaObject.methodCount(); ++ii)
     {
-        QJsonObject object{{"Error", "Recordlist is a null pointer."}};
-        return object;
+        const QMetaMethod candidate = MCRPCService::staticMetaObject.method(ii);
+
+        if(candidate.methodType() != QMetaMethod::Slot || candidate.name() != method)
+            continue;
+
+        int nPositional = 0;
+        foreach(const QByteArray & name, candidate.parameterNames())
+            if(name != "Username" && name != "APIKey")
+                ++nPositional;
+
+        if(nPositional == params.size()){
+            theMethod = candidate;
+            break;
+        }
+    }
+
+    if(!theMethod.isValid()){
+        reply.insert("error", batchError(QJsonRpc::MethodNotFound, QString("No method %1 taking %2 params").
+                                         arg(QString(method)).arg(params.size())));
+        return reply;
     }
+    // ----------------------------------------------------
+    const QList<QByteArray> parameterNames = theMethod.parameterNames();
+    std::vector<QVariant>   values;
+    int                     nNext = 0;
 
-    /*if (QJsonValue("True") != reply_obj.value("RecordListPopulated"))
+    for(int ii = 0; ii < theMethod.parameterCount(); ++ii)
     {
-        qDebug() << QString("Recordlist didn't populate properly: %1").arg(reply_obj.value("RecordListPopulated").toString());
-        QJsonObject object{{"Error", QString("Recordlist didn't populate properly: %1").arg(reply_obj.value("RecordListPopulated").toString())}};
-        return object;
-    }*/
+        const int type = theMethod.parameterType(ii);
+        QVariant  value;
 
-    m_RecordList->Populate();
-    int count = m_RecordList->size();
+        if(parameterNames.at(ii) == "Username")
+            value = Username;
+        else if(parameterNames.at(ii) == "APIKey")
+            value = APIKey;
+        else{
+            const QJsonValue param = params.at(nNext++);
+
+            if(type == QMetaType::QJsonValue)
+                value = QVariant::fromValue(param);
+            else if(type == QMetaType::QJsonArray)
+                value = QVariant::fromValue(param.toArray());
+            else if(type == QMetaType::QJsonObject)
+                value = QVariant::fromValue(param.toObject());
+            else
+                value = param.toVariant();
+        }
 
-    // Swap if Begin > End
-    if(BeginIndex > EndIndex){
-        BeginIndex^=EndIndex;
-        EndIndex^=BeginIndex;
-        BeginIndex^=EndIndex;
+        if(value.userType() != type && !value.convert(type)){
+            reply.insert("error", batchError(QJsonRpc::InvalidParams, QString("Param %1 of %2 has the wrong type").
+                                             arg(QString(parameterNames.at(ii))).arg(QString(method))));
+            return reply;
+        }
+        values.push_back(value);
     }
+    // ----------------------------------------------------
+    // Straight into MCRPCService's own qt_metacall(). QMetaMethod::invoke() would
+    // go through the virtual one, and MCRPCAsyncService's override would hand the
+    // call to its dispatcher all over again, from inside this one.
+    //
+    void * argv[1 + MaxBatchCallParams] = { nullptr };
 
-    if(BeginIndex < 0)
-        BeginIndex = 0;
+    if(values.size() > static_cast<size_t>(MaxBatchCallParams)){
+        reply.insert("error", batchError(QJsonRpc::InvalidParams, QString("Too many params for %1").arg(QString(method))));
+        return reply;
+    }
 
-    if(BeginIndex > count){
-        QJsonObject object{{"Error", "Out of Bound Request"}};
-        return object;
+    QVariant returnValue;
+
+    if(theMethod.returnType() != QMetaType::Void){
+        returnValue = QVariant(theMethod.returnType(), static_cast<const void *>(nullptr));
+        argv[0] = returnValue.data();
     }
 
-    if(EndIndex > count)
-        EndIndex = count;
+    for(size_t ii = 0; ii < values.size(); ++ii)
+        argv[ii + 1] = values[ii].data();
 
-    QJsonObject object;
-    for(auto x = BeginIndex; x < EndIndex; x++){
-
-        QJsonObject record{{"AccountID", QString(m_RecordList->GetRecord(x).GetAccountID().c_str())},
-                           {"Address", QString(m_RecordList->GetRecord(x).GetAddress().c_str())},
-                           {"Amount", QString(m_RecordList->GetRecord(x).GetAmount().c_str())},
-                           {"BoxIndex", m_RecordList->GetRecord(x).GetBoxIndex()},
-                           {"Contents", QString(m_RecordList->GetRecord(x).GetContents().c_str())},
-                           {"CurrencyTLA", QString(m_RecordList->GetRecord(x).GetCurrencyTLA().c_str())},
-                           {"Date", QString(m_RecordList->GetRecord(x).GetDate().c_str())},
-                           {"InitialPaymentAmount", qint64(m_RecordList->GetRecord(x).GetInitialPaymentAmount())},
-                           {"InitialPaymentDate", qint64(m_RecordList->GetRecord(x).GetInitialPaymentDate())},
-                           {"InstrumentDefinitionID", QString(m_RecordList->GetRecord(x).GetInstrumentDefinitionID().c_str())},
-                           {"InstrumentType", QString(m_RecordList->GetRecord(x).GetInstrumentType().c_str())},
-                           {"MaximumNoPayments", m_RecordList->GetRecord(x).GetMaximumNoPayments()},
-                           {"Memo", QString(m_RecordList->GetRecord(x).GetMemo().c_str())},
-                           {"MethodID", m_RecordList->GetRecord(x).GetMethodID()},
-                           {"MesssageID", QString(m_RecordList->GetRecord(x).GetMsgID().c_str())},
-                           {"MessageType", QString(m_RecordList->GetRecord(x).GetMsgType().c_str())},
-                           {"MessageTypeDisplay", QString(m_RecordList->GetRecord(x).GetMsgTypeDisplay().c_str())},
-                           {"Name", QString(m_RecordList->GetRecord(x).GetName().c_str())},
-                           {"NotaryID", QString(m_RecordList->GetRecord(x).GetNotaryID().c_str())},
-                           {"NymID", QString(m_RecordList->GetRecord(x).GetNymID().c_str())},
-                           {"OtherAccountID", QString(m_RecordList->GetRecord(x).GetOtherAccountID().c_str())},
-                           {"OtherAddress", QString(m_RecordList->GetRecord(x).GetOtherAddress().c_str())},
-                           {"OtherNymID", QString(m_RecordList->GetRecord(x).GetOtherNymID().c_str())},
-                           {"PaymentPlanAmount", qint64(m_RecordList->GetRecord(x).GetPaymentPlanAmount())},
-                           {"PaymentPlanStartDate", qint64(m_RecordList->GetRecord(x).GetPaymentPlanStartDate())},
-                           {"RecordType", m_RecordList->GetRecord(x).GetRecordType()},
-                           {"TimeBetweenPayments", qint64(m_RecordList->GetRecord(x).GetTimeBetweenPayments())},
-                           {"TransactionNum", qint64(m_RecordList->GetRecord(x).GetTransactionNum())},
-                           {"TransNumForDisplay", qint64(m_RecordList->GetRecord(x).GetTransNumForDisplay())},
-                           {"ValidFrom", qint64(m_RecordList->GetRecord(x).GetValidFrom())},
-                           {"ValidTo", qint64(m_RecordList->GetRecord(x).GetValidTo())}
-                          };
-
-        object.insert(QString(x), record);
+    if(MCRPCService::qt_metacall(QMetaObject::InvokeMetaMethod, theMethod.methodIndex(), argv) >= 0){
+        reply.insert("error", batchError(QJsonRpc::InternalError, QString("Failed invoking %1").arg(QString(method))));
+        return reply;
+    }
+
+    if(returnValue.userType() == QMetaType::QJsonValue)
+        reply.insert("result", returnValue.value<QJsonValue>());
+    else
+        reply.insert("result", QJsonValue::fromVariant(returnValue));
+
+    return reply;
+}
+
+// Everything a client needs to draw its main screen, in one pass: the Nyms,
+// the accounts with their balances, the servers, the asset types, and the
+// defaults.
+//
+QJsonValue MCRPCService::dashboard(QString Username, QString APIKey)
+{
+    if(!validateAPIKey(Username, APIKey)){
+        QJsonObject object{{"Error", "Invalid API Key"}};
+        return QJsonValue(object);
+    }
+
+    QJsonArray nyms, accounts, servers, assets;
+
+    const int nNymCount     = opentxs::OTAPI_Wrap::It()->GetNymCount();
+    const int nServerCount  = opentxs::OTAPI_Wrap::It()->GetServerCount();
+    const int nAssetCount   = opentxs::OTAPI_Wrap::It()->GetAssetTypeCount();
+    const int nAccountCount = opentxs::OTAPI_Wrap::It()->GetAccountCount();
+    // ----------------------------------------------------
+    for (int ii = 0; ii < nNymCount; ++ii)
+    {
+        const std::string nymId = opentxs::OTAPI_Wrap::It()->GetNym_ID(ii);
+
+        QJsonObject nym{{"NymID", QString(nymId.c_str())},
+                        {"NymName", QString(opentxs::OTAPI_Wrap::It()->GetNym_Name(nymId).c_str())}};
+        nyms.append(nym);
+    }
+    // ----------------------------------------------------
+    for (int ii = 0; ii < nServerCount; ++ii)
+    {
+        const std::string NotaryID = opentxs::OTAPI_Wrap::It()->GetServer_ID(ii);
 
+        QJsonObject server{{"NotaryID", QString(NotaryID.c_str())},
+                           {"ServerName", QString(opentxs::OTAPI_Wrap::It()->GetServer_Name(NotaryID).c_str())}};
+        servers.append(server);
     }
+    // ----------------------------------------------------
+    for (int ii = 0; ii < nAssetCount; ++ii)
+    {
+        const std::string InstrumentDefinitionID = opentxs::OTAPI_Wrap::It()->GetAssetType_ID(ii);
+
+        QJsonObject asset{{"InstrumentDefinitionID", QString(InstrumentDefinitionID.c_str())},
+                          {"AssetName", QString(opentxs::OTAPI_Wrap::It()->GetAssetType_Name(InstrumentDefinitionID).c_str())},
+                          {"CurrencyTLA", QString(opentxs::OTAPI_Wrap::It()->GetAssetType_TLA(InstrumentDefinitionID).c_str())}};
+        assets.append(asset);
+    }
+    // ----------------------------------------------------
+    for (int ii = 0; ii < nAccountCount; ++ii)
+    {
+        const std::string accountID = opentxs::OTAPI_Wrap::It()->GetAccountWallet_ID(ii);
+
+        QJsonObject account{{"AccountID", QString(accountID.c_str())},
+                            {"AccountName", QString(opentxs::OTAPI_Wrap::It()->GetAccountWallet_Name(accountID).c_str())},
+                            {"Balance", qint64(opentxs::OTAPI_Wrap::It()->GetAccountWallet_Balance(accountID))},
+                            {"AccountType", QString(opentxs::OTAPI_Wrap::It()->GetAccountWallet_Type(accountID).c_str())},
+                            {"NymID", QString(opentxs::OTAPI_Wrap::It()->GetAccountWallet_NymID(accountID).c_str())},
+                            {"NotaryID", QString(opentxs::OTAPI_Wrap::It()->GetAccountWallet_NotaryID(accountID).c_str())},
+                            {"InstrumentDefinitionID", QString(opentxs::OTAPI_Wrap::It()->GetAccountWallet_InstrumentDefinitionID(accountID).c_str())}};
+        accounts.append(account);
+    }
+    // ----------------------------------------------------
+    QJsonObject defaults{{"NymID", Moneychanger::It()->getDefaultNymID()},
+                         {"NymName", Moneychanger::It()->getDefaultNymName()},
+                         {"AccountID", Moneychanger::It()->getDefaultAccountID()},
+                         {"AccountName", Moneychanger::It()->getDefaultAccountName()},
+                         {"NotaryID", Moneychanger::It()->getDefaultNotaryID()},
+                         {"ServerName", Moneychanger::It()->getDefaultServerName()},
+                         {"AssetID", Moneychanger::It()->getDefaultAssetID()},
+                         {"AssetName", Moneychanger::It()->getDefaultAssetName()}};
+
+    QJsonObject object{{"Nyms", nyms},
+                       {"Accounts", accounts},
+                       {"Servers", servers},
+                       {"Assets", assets},
+                       {"Defaults", defaults}};
 
     return object;
 }
 
 
-bool MCRPCService::createRecordList(QString Username, QString APIKey)
+// Events
+
+// Long poll. Answers right away if there are events after SinceSequence (or
+// TimeoutSeconds is 0, or it's a Gap), otherwise as soon as there are, or when
+// TimeoutSeconds run out. Start with an empty Epoch and SinceSequence 0, then
+// pass the Epoch and LastSequence from each reply.
+//
+QJsonValue MCRPCService::waitForEvents(QString Username, QString APIKey,
+                                       QString Epoch, qint64 SinceSequence, int TimeoutSeconds)
 {
     if(!validateAPIKey(Username, APIKey)){
         QJsonObject object{{"Error", "Invalid API Key"}};
-        return false;
+        return QJsonValue(object);
     }
 
-    if(m_RecordList == nullptr)
-        m_RecordList = new opentxs::OTRecordList(*(new MTNameLookupQT));
-    qDebug() << QString("Record List Created");
-    return true;
+    RPCEventLog * pEventLog = RPCEventLog::getInstance();
+    QJsonObject   events    = pEventLog->eventsSince(Epoch, SinceSequence);
+
+    if(TimeoutSeconds <= 0 || events.value("Gap").toBool() || !events.value("Events").toArray().isEmpty())
+        return events;
+
+    TimeoutSeconds = std::min(TimeoutSeconds, MaxEventWaitSeconds);
+
+    if(!pEventLog->addWaiter(currentRequest(), SinceSequence, TimeoutSeconds))
+        return events; // Too many waiting already, so this one doesn't.
+
+    beginDelayedResponse(); // RPCEventLog answers it.
+    return QJsonValue();
+}
+
+
+QJsonValue MCRPCService::rpcStats(QString Username, QString APIKey)
+{
+    if(!validateAPIKey(Username, APIKey)){
+        QJsonObject object{{"Error", "Invalid API Key"}};
+        return QJsonValue(object);
+    }
+
+    return QJsonValue(RPCMetrics::getInstance()->toJson());
+}
+
+
+// The Prometheus text exposition format, for a scraper to pick up through
+// whatever sits in front of the RPC listener.
+//
+QJsonValue MCRPCService::rpcStatsPrometheus(QString Username, QString APIKey)
+{
+    if(!validateAPIKey(Username, APIKey)){
+        QJsonObject object{{"Error", "Invalid API Key"}};
+        return QJsonValue(object);
+    }
+
+    QJsonObject object{{"Prometheus", QString::fromUtf8(RPCMetrics::getInstance()->toPrometheus())}};
+    return QJsonValue(object);
 }
 
 
@@ -7451,8 +7791,43 @@ QJsonValue MCRPCService::refreshAPIKey(QString Username, QString PlaintextPasswo
     }
 }
 
+QString MCRPCService::beginBatch(const QString & Username)
+{
+    const QString BatchKey = newBatchKey();
+
+    QMutexLocker locker(&m_batchMutex);
+    m_batchKeys.insert(Username, BatchKey);
+
+    return BatchKey;
+}
+
+void MCRPCService::endBatch(const QString & Username, const QString & BatchKey)
+{
+    QMutexLocker locker(&m_batchMutex);
+    m_batchKeys.remove(Username, BatchKey);
+}
+
+// Same constant-time comparison as the API keys, against each batch this user
+// has running (usually none.)
+//
+bool MCRPCService::isBatchKey(const QString & Username, const QString & APIKey)
+{
+    QMutexLocker locker(&m_batchMutex);
+
+    bool bMatches = false;
+
+    for(auto it = m_batchKeys.constFind(Username); it != m_batchKeys.constEnd() && it.key() == Username; ++it)
+        bMatches |= RPCUser::keysMatch(APIKey, it.value());
+
+    return bMatches;
+}
+
 bool MCRPCService::validateAPIKey(QString Username, QString APIKey)
 {
+    // Calls inside a batch carry the batch's own key. (batch() checked the user's.)
+    if(isBatchKey(Username, APIKey))
+        return true;
+
     if(!m_userManager.checkUserActivated(Username)){
             return false;
     }
@@ -7,6 +7,12 @@
 #include "rpcusermanager.h"
 
 #include <qjsonrpcservice.h>
+#include <QJsonArray>
+#include <QSharedPointer>
+#include <QMutex>
+#include <QHash>
+#include <QJsonObject>
+
 #include <opentxs/client/OTRecordList.hpp>
 #include <opentxs/core/crypto/OTPassword.hpp>
 
@@ -904,6 +910,20 @@ public Q_SLOTS:
                                   int Index);
     QJsonValue recordListRetrieve(QString Username, QString APIKey,
                                   int BeginIndex, int EndIndex);
+    QJsonValue recordListPage(QString Username, QString APIKey,
+                              int BeginIndex, int EndIndex);
+
+    // Batches and composite calls
+    QJsonValue batch(QString Username, QString APIKey, QJsonArray Calls);
+    QJsonValue dashboard(QString Username, QString APIKey);
+
+    // Events
+    QJsonValue waitForEvents(QString Username, QString APIKey,
+                             QString Epoch, qint64 SinceSequence, int TimeoutSeconds);
+
+    // Per-method call counts, errors and latency
+    QJsonValue rpcStats(QString Username, QString APIKey);
+    QJsonValue rpcStatsPrometheus(QString Username, QString APIKey);
 
     QJsonValue setDefaultNym(QString Username, QString APIKey,
                              QString nym_id, QString nym_name);
@@ -924,11 +944,44 @@ public Q_SLOTS:
     QJsonValue isValidID(QString ID, QString Username, QString APIKey);
 
 
+protected:
+
+    bool hasRecordListSnapshot();
+
 private:
 
     // RecordList Methods
+    struct RecordListSnapshot
+    {
+        quint64    Version=0;
+        QString    ETag;
+        QJsonArray Records;
+    };
+    typedef QSharedPointer<const RecordListSnapshot> RecordListSnapshotPtr;
+
     opentxs::OTRecordList * m_RecordList=nullptr;
-    bool createRecordList(QString Username, QString APIKey);
+    QMutex                  m_RecordListMutex;         // Held while populating.
+    RecordListSnapshotPtr   m_RecordListSnapshot;
+    quint64                 m_RecordListVersion=0;
+    QMutex                  m_RecordListSnapshotMutex;
+
+    RecordListSnapshotPtr refreshRecordList();
+    RecordListSnapshotPtr currentRecordList();
+    static QJsonObject recordToJson(const opentxs::OTRecord & record);
+
+    static const int        MaxEventWaitSeconds=60;
+
+    // Batches
+    static const int        MaxBatchSize=256;
+    static const int        MaxBatchCallParams=10;
+    QMutex                       m_batchMutex;
+    QMultiHash<QString, QString> m_batchKeys; // Username -> the key for each of that user's batches, while it runs.
+    QString beginBatch(const QString & Username);
+    void    endBatch(const QString & Username, const QString & BatchKey);
+    bool    isBatchKey(const QString & Username, const QString & APIKey);
+    QJsonObject invokeBatchCall(QString Username, QString APIKey, const QJsonObject & call);
+
+    friend class RPCTest;
 
     RPCUserManager m_userManager;
 
@@ -1,12 +1,20 @@
 
 HEADERS += \
     $$PWD/mcrpcservice.h \
+    $$PWD/rpcdispatcher.h \
+    $$PWD/rpceventlog.h \
+    $$PWD/rpcmetrics.h \
     $$PWD/rpcserver.h \
+    $$PWD/rpctest.h \
     $$PWD/rpcuser.h \
     $$PWD/rpcusermanager.h
 
 SOURCES += \
     $$PWD/mcrpcservice.cpp \
+    $$PWD/rpcdispatcher.cpp \
+    $$PWD/rpceventlog.cpp \
+    $$PWD/rpcmetrics.cpp \
     $$PWD/rpcserver.cpp \
+    $$PWD/rpctest.cpp \
     $$PWD/rpcuser.cpp \
     $$PWD/rpcusermanager.cpp
@@ -0,0 +1,336 @@
+#include "rpcdispatcher.h"
+
+#ifndef __STABLE_HPP__
+#include <core/stable.hpp>
+#endif
+
+#include <QDebug>
+#include <QThread>
+#include <QRunnable>
+#include <QSet>
+#include <QSharedPointer>
+#include <QMetaMethod>
+#include <QMetaType>
+#include <QJsonValue>
+#include <QJsonObject>
+#include <QElapsedTimer>
+
+#include "rpcmetrics.h"
+
+#include <core/otlock.hpp>
+
+#include <qjsonrpcmessage.h>
+
+#include <algorithm>
+#include <vector>
+
+
+namespace
+{
+
+// A copy of a slot's return value and arguments. The ones qt_metacall() gets
+// belong to dispatch(), and are gone as soon as it returns.
+//
+class CallArguments
+{
+public:
+    CallArguments(const QMetaMethod & method, void ** args)
+    : returnType_(method.returnType())
+    {
+        values_.push_back((QMetaType::Void == returnType_) ? nullptr : QMetaType::create(returnType_));
+
+        for (int ii = 0; ii < method.parameterCount(); ++ii)
+        {
+            types_.push_back(method.parameterType(ii));
+            values_.push_back(QMetaType::create(method.parameterType(ii), args[ii + 1]));
+        }
+    }
+
+    ~CallArguments()
+    {
+        if (nullptr != values_[0])
+            QMetaType::destroy(returnType_, values_[0]);
+
+        for (size_t ii = 0; ii < types_.size(); ++ii)
+            QMetaType::destroy(types_[ii], values_[ii + 1]);
+    }
+
+    void ** data() { return values_.data(); }
+
+    QVariant returnValue() const
+    {
+        return (nullptr == values_[0]) ? QVariant() : QVariant(returnType_, values_[0]);
+    }
+
+private:
+    int                 returnType_;
+    std::vector<int>    types_;
+    std::vector<void *> values_;
+};
+
+QJsonValue toJsonValue(const QVariant & result)
+{
+    if (QMetaType::QJsonValue == result.userType())
+        return result.value<QJsonValue>();
+
+    return QJsonValue::fromVariant(result);
+}
+
+class DispatchTask : public QRunnable
+{
+public:
+    DispatchTask(RPCDispatcher * pDispatcher, quint64 nTicket, std::function<QVariant()> work)
+    : pDispatcher_(pDispatcher)
+    , nTicket_(nTicket)
+    , work_(work)
+    {
+    }
+
+    void run()
+    {
+        QVariant result;
+
+        try
+        {
+            result = work_();
+        }
+        catch (...)
+        {
+            qDebug() << "RPCDispatcher: RPC method threw an exception.";
+        }
+
+        QMetaObject::invokeMethod(pDispatcher_, "onWorkDone", Qt::QueuedConnection,
+                                  Q_ARG(quint64, nTicket_), Q_ARG(QVariant, result));
+    }
+
+private:
+    RPCDispatcher *           pDispatcher_;
+    quint64                   nTicket_;
+    std::function<QVariant()> work_;
+};
+
+} // namespace
+
+
+RPCDispatcher::RPCDispatcher(QObject * parent /*=0*/)
+: QObject(parent)
+, m_nNextTicket(0)
+{
+    m_readPool.setMaxThreadCount(std::max(QThread::idealThreadCount(), 2));
+
+    m_otPool.setMaxThreadCount(1);
+    m_otPool.setExpiryTimeout(-1); // Keep the same thread for the life of the server.
+
+    for (int ii = 0; ii < MethodClassCount; ++ii)
+        m_nPending[ii] = 0;
+
+    m_nMaxPending[GuiThread] = 0; // Never queued.
+    m_nMaxPending[ReadOnly]  = 64;
+    m_nMaxPending[Mutating]  = 32;
+    m_nMaxPending[Network]   = 8;
+}
+
+RPCDispatcher::~RPCDispatcher()
+{
+    m_readPool.waitForDone();
+
+    MTOTLock::GuiRelease release; // A call on the executor may be waiting for the OT lock.
+    m_otPool.waitForDone();
+}
+
+//static
+RPCDispatcher::MethodClass RPCDispatcher::classify(const QByteArray & method)
+{
+    static const QSet<QByteArray> setGuiThread
+    {
+        "mcMessagesDialog", "mcExchangeDialog", "mcPaymentsDialog", "mcManageAccountsDialog",
+        "mcManageNymsDialog", "mcManageAssetsDialog", "mcManageSmartContractsDialog",
+        "mcSendDialog", "mcRequestFundsDialog", "mcActivateSmartContract", "mcListSmartContracts",
+        "userLogin", "userLogout", "refreshAPIKey",
+        "setDefaultNym", "getDefaultNym", "setDefaultAccount", "getDefaultAccount",
+        "setDefaultServer", "getDefaultServer", "setDefaultAsset", "getDefaultAsset",
+        "dashboard", // Reads the defaults along with the wallet, and it's all local.
+        "registerAccount", // On failure it calls Moneychanger::HasUsageCredits(), which shows a spinner and error boxes.
+        "waitForEvents" // Answers from RPCEventLog, later.
+    };
+
+    static const QSet<QByteArray> setReadOnly
+    {
+        "recordListCount", "recordListRetrieve", "recordListPage",
+        "rpcStats", "rpcStatsPrometheus"
+    };
+
+    static const QSet<QByteArray> setNetwork
+    {
+        "checkNym", "registerNym", "unregisterNym", "getAccountData", "processInbox", "processNymbox",
+        "getMarketList", "getMarketOffers", "getMarketRecentTrades", "getNymMarketOffers",
+        "issueMarketOffer", "killMarketOffer", "killPaymentPlan", "depositCheque", "depositPaymentPlan",
+        "notarizeDeposit", "notarizeTransfer", "notarizeWithdrawal", "withdrawVoucher",
+        "sendNymMessage", "sendNymInstrument", "pingNotary",
+        "registerInstrumentDefinition", "issueBasket", "exchangeBasket", "payDividend",
+        "getBoxReceipt", "getMint", "getNymbox", "getTransactionNumbers", "getRequestNumber",
+        "queryInstrumentDefinitions", "usageCredits", "triggerClause", "activateSmartContract",
+        "getInstrumentDefinition", "exchangePurse", "deleteAssetAccount"
+    };
+
+    if (setGuiThread.contains(method))
+        return GuiThread;
+
+    if (setReadOnly.contains(method))
+        return ReadOnly;
+
+    if (setNetwork.contains(method))
+        return Network;
+
+    return Mutating; // Anything else goes into OT, which isn't safe to call from more than one thread.
+}
+
+//static
+RPCDispatcher::MethodClass RPCDispatcher::classifyBatch(const QJsonArray & calls)
+{
+    MethodClass batchClass = ReadOnly;
+
+    for (QJsonArray::const_iterator it = calls.begin(); it != calls.end(); ++it)
+    {
+        const QByteArray method = (*it).toObject().value("method").toString().section('.', -1).toLatin1();
+        const MethodClass methodClass = classify(method);
+
+        if (GuiThread == methodClass)
+            return GuiThread;
+
+        batchClass = std::max(batchClass, methodClass); // ReadOnly < Mutating < Network
+    }
+
+    return batchClass;
+}
+
+//static
+bool RPCDispatcher::needsRecordList(const QByteArray & method)
+{
+    return method.startsWith("recordList") || (method == "batch");
+}
+
+void RPCDispatcher::setMaxPending(MethodClass methodClass, int nMax)
+{
+    if ((methodClass > GuiThread) && (methodClass < MethodClassCount))
+        m_nMaxPending[methodClass] = nMax;
+}
+
+bool RPCDispatcher::submit(MethodClass methodClass, std::function<QVariant()> work, std::function<void(QVariant)> onDone)
+{
+    if ((methodClass <= GuiThread) || (methodClass >= MethodClassCount))
+        return false;
+
+    if (m_nPending[methodClass] >= m_nMaxPending[methodClass])
+    {
+        qDebug() << QString("RPCDispatcher: queue %1 is full (%2 pending), refusing the call.")
+                    .arg(methodClass).arg(m_nPending[methodClass]);
+        return false;
+    }
+    // -----------------------------------
+    const quint64 nTicket = ++m_nNextTicket;
+
+    PendingCall theCall;
+    theCall.methodClass = methodClass;
+    theCall.onDone      = onDone;
+
+    m_pendingCalls.insert(nTicket, theCall);
+    ++m_nPending[methodClass];
+
+    if (ReadOnly == methodClass)
+        m_readPool.start(new DispatchTask(this, nTicket, work));
+    else
+        m_otPool.start(new DispatchTask(this, nTicket, [work]()
+        {
+            QMutexLocker locker(&MTOTLock::mutex()); // Shared with the GUI thread.
+            return work();
+        }));
+
+    return true;
+}
+
+void RPCDispatcher::onWorkDone(quint64 nTicket, QVariant result)
+{
+    if (!m_pendingCalls.contains(nTicket))
+        return;
+
+    PendingCall theCall = m_pendingCalls.take(nTicket);
+    --m_nPending[theCall.methodClass];
+
+    if (theCall.onDone)
+        theCall.onDone(result);
+}
+
+// --------------------------------------------
+
+MCRPCAsyncService::MCRPCAsyncService(QObject * parent /*=0*/)
+: MCRPCService(parent)
+{
+    RPCMetrics::getInstance()->registerService(metaObject());
+}
+
+int MCRPCAsyncService::qt_metacall(QMetaObject::Call call, int id, void ** args)
+{
+    if ((QMetaObject::InvokeMetaMethod != call) || (id < MCRPCService::staticMetaObject.methodOffset()))
+        return MCRPCService::qt_metacall(call, id, args);
+
+    const QMetaMethod            method         = metaObject()->method(id);
+    const QJsonRpcServiceRequest serviceRequest = currentRequest();
+
+    RPCDispatcher::MethodClass methodClass = RPCDispatcher::classify(method.name());
+
+    if ((method.name() == "batch") && (3 == method.parameterCount()) && (QMetaType::QJsonArray == method.parameterType(2)))
+        methodClass = RPCDispatcher::classifyBatch(*reinterpret_cast<const QJsonArray *>(args[3]));
+
+    // Until there's a snapshot, the first read populates one, which goes into OT.
+    if ((RPCDispatcher::ReadOnly == methodClass) && RPCDispatcher::needsRecordList(method.name()) &&
+        !hasRecordListSnapshot())
+        methodClass = RPCDispatcher::Mutating;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const int nMetricsHandle = RPCMetrics::getInstance()->callStarted(id);
+
+    if ((RPCDispatcher::GuiThread == methodClass) || (QMetaMethod::Slot != method.methodType()) ||
+        !serviceRequest.isValid() || (QJsonRpcMessage::Request != serviceRequest.request().type()))
+    {
+        const int nResult = MCRPCService::qt_metacall(call, id, args);
+
+        const QVariant result = ((NULL == args[0]) || (QMetaType::Void == method.returnType())) ?
+                    QVariant() : QVariant(method.returnType(), args[0]);
+
+        // A delayed response (waitForEvents) is counted up to here only.
+        RPCMetrics::getInstance()->callFinished(nMetricsHandle, timer.nsecsElapsed(), RPCMetrics::isErrorResult(result));
+        return nResult;
+    }
+    // -----------------------------------
+    QSharedPointer<CallArguments> pArguments(new CallArguments(method, args));
+
+    std::function<QVariant()> work = [this, id, pArguments]()
+    {
+        MCRPCService::qt_metacall(QMetaObject::InvokeMetaMethod, id, pArguments->data());
+        return pArguments->returnValue();
+    };
+
+    std::function<void(QVariant)> onDone = [serviceRequest, timer, nMetricsHandle](QVariant result)
+    {
+        RPCMetrics::getInstance()->callFinished(nMetricsHandle, timer.nsecsElapsed(), RPCMetrics::isErrorResult(result));
+
+        QJsonRpcServiceRequest theRequest(serviceRequest);
+        theRequest.respond(theRequest.request().createResponse(toJsonValue(result)));
+    };
+
+    beginDelayedResponse();
+
+    if (!m_dispatcher.submit(methodClass, work, onDone))
+    {
+        RPCMetrics::getInstance()->callRejected(nMetricsHandle);
+
+        QJsonRpcServiceRequest theRequest(serviceRequest);
+        theRequest.respond(theRequest.request().createErrorResponse(QJsonRpc::ServerErrorBase,
+                                                                    "Server busy, try again later"));
+    }
+
+    return -1; // Handled.
+}
@@ -0,0 +1,95 @@
+#ifndef RPCDISPATCHER_H
+#define RPCDISPATCHER_H
+
+#include "mcrpcservice.h"
+
+#include <QObject>
+#include <QThreadPool>
+#include <QHash>
+#include <QVariant>
+#include <QByteArray>
+#include <QJsonArray>
+
+#include <functional>
+
+
+// Decides where each MCRPCService method runs, and runs it there.
+//
+// ReadOnly methods only read state that the RPC layer owns (the record list
+// snapshot), so they run concurrently on a worker pool. Everything that goes
+// into OT runs on a single OT executor thread, one call at a time, in the order
+// received, and holds MTOTLock while it does, since the GUI thread uses OT too.
+// Network methods also wait on a notary round-trip, so they get a smaller
+// queue. GuiThread methods touch widgets, Moneychanger's own state or the local
+// database, and still run inline like before.
+//
+// Each class has a bounded queue. When it's full, submit() returns false and
+// the caller answers "busy" instead of piling up more work.
+//
+class RPCDispatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum MethodClass
+    {
+        GuiThread = 0,
+        ReadOnly,
+        Mutating,
+        Network,
+        MethodClassCount
+    };
+
+    explicit RPCDispatcher(QObject * parent = 0);
+    ~RPCDispatcher();
+
+    static MethodClass classify(const QByteArray & method);
+    static MethodClass classifyBatch(const QJsonArray & calls); // The strictest class of any call in it.
+    static bool        needsRecordList(const QByteArray & method); // ReadOnly, but reads the record list snapshot.
+
+    void setMaxPending(MethodClass methodClass, int nMax);
+
+    // work runs on the executor for methodClass. onDone runs afterwards on this
+    // object's thread, with whatever work returned.
+    bool submit(MethodClass methodClass, std::function<QVariant()> work, std::function<void(QVariant)> onDone);
+
+private slots:
+    void onWorkDone(quint64 nTicket, QVariant result);
+
+private:
+    struct PendingCall
+    {
+        MethodClass                   methodClass;
+        std::function<void(QVariant)> onDone;
+    };
+
+    QThreadPool m_readPool;
+    QThreadPool m_otPool;   // One thread: the OT executor.
+
+    int m_nPending   [MethodClassCount];
+    int m_nMaxPending[MethodClassCount];
+
+    quint64                     m_nNextTicket;
+    QHash<quint64, PendingCall> m_pendingCalls;
+};
+
+
+// MCRPCService, with its methods handed to an RPCDispatcher.
+//
+// QJsonRpcService::dispatch() invokes the slot through qt_metacall(), so this
+// intercepts it there: it copies the arguments, starts a delayed response and
+// returns right away. The method runs on its executor, and the response is sent
+// to the client's socket from the GUI thread once it's done.
+//
+class MCRPCAsyncService : public MCRPCService
+{
+public:
+    MCRPCAsyncService(QObject * parent = 0);
+
+    int qt_metacall(QMetaObject::Call call, int id, void ** args);
+
+private:
+    RPCDispatcher m_dispatcher;
+};
+
+#endif // RPCDISPATCHER_H
@@ -0,0 +1,284 @@
+#include "rpceventlog.h"
+
+#ifndef __STABLE_HPP__
+#include <core/stable.hpp>
+#endif
+
+#include <core/moneychanger.hpp>
+
+#include <opentxs/client/OTAPI.hpp>
+#include <opentxs/client/OTRecord.hpp>
+
+#include <qjsonrpcmessage.h>
+
+#include <QDateTime>
+#include <QUuid>
+#include <QJsonArray>
+#include <QDebug>
+
+#include <algorithm>
+
+
+RPCEventLog * RPCEventLog::_instance = NULL;
+
+RPCEventLog * RPCEventLog::getInstance()
+{
+    if (NULL == _instance)
+    {
+        _instance = new RPCEventLog;
+    }
+    return _instance;
+}
+
+RPCEventLog::RPCEventLog()
+: m_pMoneychanger(NULL)
+, m_qstrEpoch(QUuid::createUuid().toString())
+, m_nLastSequence(0)
+, m_bSeenRecords(false)
+, m_bSeenBalances(false)
+{
+    m_clock.start();
+
+    m_waitTimer.setInterval(1000);
+    connect(&m_waitTimer, SIGNAL(timeout()), this, SLOT(onWaitTimer()));
+}
+
+void RPCEventLog::watch(Moneychanger * pMoneychanger)
+{
+    if ((NULL == pMoneychanger) || (m_pMoneychanger == pMoneychanger))
+        return;
+
+    m_pMoneychanger = pMoneychanger;
+
+    connect(pMoneychanger, SIGNAL(balancesChanged()),                         this, SLOT(onBalancesChanged()));
+    connect(pMoneychanger, SIGNAL(recordListLoaded(MTRecordListSnapshotPtr)), this, SLOT(onRecordListLoaded(MTRecordListSnapshotPtr)));
+    connect(pMoneychanger, SIGNAL(newServerAdded(QString)),                   this, SLOT(onNewServerAdded(QString)));
+    connect(pMoneychanger, SIGNAL(newAssetAdded(QString)),                    this, SLOT(onNewAssetAdded(QString)));
+    connect(pMoneychanger, SIGNAL(nymWasJustChecked(QString)),                this, SLOT(onNymWasJustChecked(QString)));
+}
+
+// --------------------------------------------
+
+void RPCEventLog::append(const QString & qstrType, const QJsonObject & data)
+{
+    QJsonObject event{{"Sequence", ++m_nLastSequence},
+                      {"Type", qstrType},
+                      {"Time", QDateTime::currentDateTimeUtc().toMSecsSinceEpoch() / 1000},
+                      {"Data", data}};
+
+    m_events.push_back(event);
+
+    while (m_events.size() > static_cast<size_t>(MaxEvents))
+        m_events.pop_front();
+
+    answerWaiters(false);
+}
+
+QJsonObject RPCEventLog::eventsSince(const QString & Epoch, qint64 SinceSequence)
+{
+    // The client's sequence is from before a restart, or from nowhere. Either
+    // way, it gets everything from the start.
+    const bool bOtherEpoch = (!Epoch.isEmpty() && (Epoch != m_qstrEpoch)) || (SinceSequence > m_nLastSequence);
+
+    if (bOtherEpoch)
+        SinceSequence = 0;
+
+    const qint64 nFirstSequence = m_nLastSequence - static_cast<qint64>(m_events.size()) + 1;
+
+    // Some of the events after SinceSequence have already been dropped.
+    const bool bGap = bOtherEpoch || ((SinceSequence < nFirstSequence - 1) && (SinceSequence < m_nLastSequence));
+
+    QJsonArray events;
+
+    for (std::deque<QJsonObject>::const_iterator it = m_events.begin(); it != m_events.end(); ++it)
+    {
+        if (static_cast<qint64>((*it).value("Sequence").toDouble()) <= SinceSequence)
+            continue;
+
+        if (events.size() >= MaxEventsPerReply)
+            break;
+
+        events.append(*it);
+    }
+
+    const qint64 nLastSent = events.isEmpty() ? std::max(SinceSequence, qint64(0)) :
+                                                static_cast<qint64>(events.last().toObject().value("Sequence").toDouble());
+
+    QJsonObject object{{"Epoch", m_qstrEpoch},
+                       {"Events", events},
+                       {"LastSequence", nLastSent},
+                       {"Gap", bGap},
+                       {"More", nLastSent < m_nLastSequence}};
+    return object;
+}
+
+bool RPCEventLog::addWaiter(const QJsonRpcServiceRequest & request, qint64 SinceSequence, int TimeoutSeconds)
+{
+    if (m_waiters.size() >= MaxWaiters)
+        return false;
+
+    Waiter theWaiter;
+    theWaiter.request        = request;
+    theWaiter.nSinceSequence = SinceSequence;
+    theWaiter.nDeadline      = m_clock.elapsed() + qint64(std::max(TimeoutSeconds, 1)) * 1000;
+
+    m_waiters.append(theWaiter);
+
+    if (!m_waitTimer.isActive())
+        m_waitTimer.start();
+
+    return true;
+}
+
+void RPCEventLog::answerWaiters(bool bTimedOutOnly)
+{
+    const qint64 nNow = m_clock.elapsed();
+
+    for (QList<Waiter>::iterator it = m_waiters.begin(); it != m_waiters.end(); )
+    {
+        const bool bHasEvents = ((*it).nSinceSequence < m_nLastSequence);
+        const bool bTimedOut  = ((*it).nDeadline <= nNow);
+
+        if (!(bTimedOutOnly ? bTimedOut : (bHasEvents || bTimedOut)))
+        {
+            ++it;
+            continue;
+        }
+
+        QJsonRpcServiceRequest & theRequest = (*it).request;
+        theRequest.respond(theRequest.request().createResponse(QJsonValue(eventsSince(m_qstrEpoch, (*it).nSinceSequence))));
+
+        it = m_waiters.erase(it);
+    }
+
+    if (m_waiters.isEmpty())
+        m_waitTimer.stop();
+}
+
+void RPCEventLog::onWaitTimer()
+{
+    answerWaiters(true);
+}
+
+// --------------------------------------------
+
+void RPCEventLog::onBalancesChanged()
+{
+    QMap<QString, qint64> mapBalances;
+
+    const int nAccountCount = opentxs::OTAPI_Wrap::It()->GetAccountCount();
+
+    for (int ii = 0; ii < nAccountCount; ++ii)
+    {
+        const std::string accountID = opentxs::OTAPI_Wrap::It()->GetAccountWallet_ID(ii);
+        mapBalances.insert(QString::fromStdString(accountID),
+                           opentxs::OTAPI_Wrap::It()->GetAccountWallet_Balance(accountID));
+    }
+
+    if (m_bSeenBalances)
+    {
+        for (QMap<QString, qint64>::const_iterator it = mapBalances.begin(); it != mapBalances.end(); ++it)
+        {
+            const bool bKnown = m_balances.contains(it.key());
+
+            if (bKnown && (m_balances.value(it.key()) == it.value()))
+                continue;
+
+            QJsonObject data{{"AccountID", it.key()},
+                             {"Balance", it.value()}};
+            if (bKnown)
+                data.insert("PreviousBalance", m_balances.value(it.key()));
+
+            append("BalanceChanged", data);
+        }
+    }
+
+    m_balances      = mapBalances;
+    m_bSeenBalances = true;
+}
+
+// This gets every list the populator produces, before anything is archived out
+// of it, so new mail and payments show up here even though they don't stay in
+// the record box for long.
+//
+void RPCEventLog::onRecordListLoaded(MTRecordListSnapshotPtr snapshot)
+{
+    if (!snapshot || !snapshot->pList)
+        return;
+
+    opentxs::OTRecordList & theList = *snapshot->pList;
+
+    QSet<QString> setKeys;
+
+    for (int ii = 0; ii < theList.size(); ++ii)
+    {
+        const opentxs::OTRecord record = theList.GetRecord(ii);
+        const bool bIsMail = record.IsMail() || record.IsSpecialMail();
+
+        const QString qstrKey = QString("%1|%2|%3|%4|%5|%6|%7|%8|%9").
+                arg(record.GetRecordType()).
+                arg(QString::fromStdString(record.GetNymID())).
+                arg(QString::fromStdString(record.GetAccountID())).
+                arg(QString::fromStdString(record.GetNotaryID())).
+                arg(record.GetTransactionNum()).
+                arg(QString::fromStdString(record.GetInstrumentType())).
+                arg(QString::fromStdString(record.GetMsgID())).
+                arg(QString::fromStdString(record.GetDate())).
+                arg(record.IsPending() ? 1 : 0);
+
+        setKeys.insert(qstrKey);
+
+        // The first list is just what was already there.
+        if (!m_bSeenRecords || m_recordKeys.contains(qstrKey))
+            continue;
+        // ---------------------------------
+        if (bIsMail)
+        {
+            QJsonObject data{{"NymID", QString::fromStdString(record.GetNymID())},
+                             {"OtherNymID", QString::fromStdString(record.GetOtherNymID())},
+                             {"OtherAddress", QString::fromStdString(record.GetOtherAddress())},
+                             {"MessageID", QString::fromStdString(record.GetMsgID())},
+                             {"MessageType", QString::fromStdString(record.GetMsgType())},
+                             {"Date", QString::fromStdString(record.GetDate())},
+                             {"Outgoing", record.IsOutgoing()}};
+            append("NewMessage", data);
+        }
+        else
+        {
+            QJsonObject data{{"NymID", QString::fromStdString(record.GetNymID())},
+                             {"AccountID", QString::fromStdString(record.GetAccountID())},
+                             {"NotaryID", QString::fromStdString(record.GetNotaryID())},
+                             {"OtherNymID", QString::fromStdString(record.GetOtherNymID())},
+                             {"InstrumentType", QString::fromStdString(record.GetInstrumentType())},
+                             {"Amount", QString::fromStdString(record.GetAmount())},
+                             {"TransNumForDisplay", qint64(record.GetTransNumForDisplay())},
+                             {"Date", QString::fromStdString(record.GetDate())},
+                             {"Outgoing", record.IsOutgoing()},
+                             {"Pending", record.IsPending()}};
+            append("NewRecord", data);
+        }
+    }
+
+    m_recordKeys   = setKeys;
+    m_bSeenRecords = true;
+}
+
+void RPCEventLog::onNewServerAdded(QString qstrID)
+{
+    QJsonObject data{{"ContractType", "Server"},
+                     {"NotaryID", qstrID}};
+    append("ContractAdded", data);
+}
+
+void RPCEventLog::onNewAssetAdded(QString qstrID)
+{
+    QJsonObject data{{"ContractType", "Asset"},
+                     {"InstrumentDefinitionID", qstrID}};
+    append("ContractAdded", data);
+}
+
+void RPCEventLog::onNymWasJustChecked(QString qstrID)
+{
+    QJsonObject data{{"NymID", qstrID}};
+    append("NymUpdated", data);
+}
@@ -0,0 +1,101 @@
+#ifndef RPCEVENTLOG_H
+#define RPCEVENTLOG_H
+
+#include <core/recordlistpopulator.hpp>
+
+#include <qjsonrpcservice.h>
+
+#include <QObject>
+#include <QString>
+#include <QSet>
+#include <QMap>
+#include <QList>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include <deque>
+
+class Moneychanger;
+
+
+// Change events for RPC clients, so they don't have to poll.
+//
+// Watches Moneychanger's signals and turns them into typed events, each with a
+// sequence number: NewRecord, NewMessage, BalanceChanged, ContractAdded and
+// NymUpdated. The last MaxEvents are kept. A client passes the last sequence it
+// saw to waitForEvents, which answers as soon as there's anything newer (or when
+// it times out.) If the client fell further behind than that, the reply says
+// "Gap", and it should re-read whatever it shows (recordListPopulate, dashboard.)
+//
+// Sequence numbers start over when Moneychanger does, so every reply also has
+// the log's "Epoch", which the client passes back. If it's another one, or the
+// client is ahead of the log, its sequence means nothing here: the reply says
+// "Gap", and has the events from the start of this epoch.
+//
+// Everything here runs on the GUI thread.
+//
+class RPCEventLog : public QObject
+{
+    Q_OBJECT
+
+public:
+    static RPCEventLog * getInstance();
+
+    void watch(Moneychanger * pMoneychanger);
+
+    // {"Epoch": "...", "Events": [...], "LastSequence": n, "Gap": bool, "More": bool}
+    // An empty Epoch is taken to be this one.
+    QJsonObject eventsSince(const QString & Epoch, qint64 SinceSequence);
+
+    // Holds the request open until there are events after SinceSequence, or
+    // until TimeoutSeconds go by. Returns false if too many are waiting already.
+    // (Only for an Epoch and SinceSequence that eventsSince() didn't call a Gap.)
+    bool addWaiter(const QJsonRpcServiceRequest & request, qint64 SinceSequence, int TimeoutSeconds);
+
+    void append(const QString & qstrType, const QJsonObject & data);
+
+private slots:
+    void onBalancesChanged();
+    void onRecordListLoaded(MTRecordListSnapshotPtr snapshot);
+    void onNewServerAdded(QString qstrID);
+    void onNewAssetAdded(QString qstrID);
+    void onNymWasJustChecked(QString qstrID);
+    void onWaitTimer();
+
+private:
+    RPCEventLog();
+
+    static RPCEventLog * _instance;
+
+    static const int MaxEvents         = 1024;
+    static const int MaxEventsPerReply = 256;
+    static const int MaxWaiters        = 256;
+
+    struct Waiter
+    {
+        QJsonRpcServiceRequest request;
+        qint64                 nSinceSequence;
+        qint64                 nDeadline; // On m_clock.
+    };
+
+    void answerWaiters(bool bTimedOutOnly);
+
+    Moneychanger *          m_pMoneychanger;
+
+    const QString           m_qstrEpoch; // New every time the log is created.
+    std::deque<QJsonObject> m_events;
+    qint64                  m_nLastSequence;
+
+    QList<Waiter>           m_waiters;
+    QElapsedTimer           m_clock;
+    QTimer                  m_waitTimer;
+
+    // What the last record list / balances looked like, to tell what's new.
+    bool                    m_bSeenRecords;
+    QSet<QString>           m_recordKeys;
+    bool                    m_bSeenBalances;
+    QMap<QString, qint64>   m_balances;
+};
+
+#endif // RPCEVENTLOG_H
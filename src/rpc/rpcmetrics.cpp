@@ -0,0 +1,282 @@
+#include "rpcmetrics.h"
+
+#ifndef __STABLE_HPP__
+#include <core/stable.hpp>
+#endif
+
+#include <QMetaMethod>
+#include <QJsonArray>
+#include <QJsonValue>
+#include <QString>
+
+#include <algorithm>
+
+
+RPCMetrics * RPCMetrics::_instance = NULL;
+
+RPCMetrics * RPCMetrics::getInstance()
+{
+    if (NULL == _instance)
+    {
+        _instance = new RPCMetrics;
+    }
+    return _instance;
+}
+
+RPCMetrics::RPCMetrics()
+: m_pMetaObject(NULL)
+, m_nMethodOffset(0)
+{
+}
+
+RPCMetrics::~RPCMetrics()
+{
+    for (size_t ii = 0; ii < m_stats.size(); ++ii)
+        delete m_stats[ii];
+}
+
+void RPCMetrics::registerService(const QMetaObject * pMetaObject)
+{
+    if ((NULL == pMetaObject) || (NULL != m_pMetaObject)) // Once, before any calls.
+        return;
+
+    m_pMetaObject   = pMetaObject;
+    m_nMethodOffset = pMetaObject->methodOffset();
+
+    QHash<QByteArray, int> mapHandles;
+
+    for (int ii = m_nMethodOffset; ii < pMetaObject->methodCount(); ++ii)
+    {
+        const QMetaMethod method = pMetaObject->method(ii);
+        int nHandle = -1;
+
+        if (QMetaMethod::Slot == method.methodType())
+        {
+            nHandle = mapHandles.value(method.name(), -1);
+
+            if (-1 == nHandle)
+            {
+                nHandle = static_cast<int>(m_stats.size());
+                mapHandles.insert(method.name(), nHandle);
+
+                MethodStats * pStats = new MethodStats;
+                pStats->name = method.name();
+                m_stats.push_back(pStats);
+            }
+        }
+        m_methodHandles.push_back(nHandle);
+    }
+}
+
+int RPCMetrics::callStarted(int nMethodIndex)
+{
+    const int nIndex = nMethodIndex - m_nMethodOffset;
+
+    if ((nIndex < 0) || (nIndex >= static_cast<int>(m_methodHandles.size())))
+        return -1;
+
+    const int nHandle = m_methodHandles[nIndex];
+
+    if (nHandle >= 0)
+    {
+        m_stats[nHandle]->calls.fetchAndAddRelaxed(1);
+        m_stats[nHandle]->inFlight.fetchAndAddRelaxed(1);
+    }
+    return nHandle;
+}
+
+void RPCMetrics::callFinished(int nHandle, qint64 nNanoseconds, bool bError)
+{
+    if ((nHandle < 0) || (nHandle >= static_cast<int>(m_stats.size())))
+        return;
+
+    MethodStats & stats = *m_stats[nHandle];
+    const quint64 nMicros = static_cast<quint64>(std::max(nNanoseconds, qint64(0)) / 1000);
+
+    stats.inFlight.fetchAndAddRelaxed(-1);
+    stats.totalMicros.fetchAndAddRelaxed(nMicros);
+    stats.buckets[bucketForMicros(nMicros)].fetchAndAddRelaxed(1);
+
+    if (bError)
+        stats.errors.fetchAndAddRelaxed(1);
+}
+
+void RPCMetrics::callRejected(int nHandle)
+{
+    if ((nHandle < 0) || (nHandle >= static_cast<int>(m_stats.size())))
+        return;
+
+    m_stats[nHandle]->rejected.fetchAndAddRelaxed(1);
+    callFinished(nHandle, 0, true);
+}
+
+//static
+bool RPCMetrics::isErrorResult(const QVariant & result)
+{
+    if (QMetaType::QJsonValue == result.userType())
+    {
+        const QJsonValue value = result.value<QJsonValue>();
+
+        if (value.isObject())
+            return value.toObject().contains("Error");
+
+        if (value.isString())
+            return value.toString().startsWith("Error");
+
+        return false;
+    }
+
+    if (QMetaType::QString == result.userType())
+        return result.toString().startsWith("Error");
+
+    return !result.isValid(); // Threw.
+}
+
+// --------------------------------------------
+
+// 0-3us get a bucket each. After that, each power of two is split in four.
+//
+//static
+int RPCMetrics::bucketForMicros(quint64 nMicros)
+{
+    if (nMicros < 4)
+        return static_cast<int>(nMicros);
+
+    int nExponent = 2;
+    while ((nMicros >> (nExponent + 1)) != 0)
+        ++nExponent;
+
+    const int nSub    = static_cast<int>((nMicros >> (nExponent - 2)) & 3);
+    const int nBucket = 4 * (nExponent - 1) + nSub;
+
+    return std::min(nBucket, BucketCount - 1);
+}
+
+//static
+qint64 RPCMetrics::bucketUpperMicros(int nBucket)
+{
+    if (nBucket < 4)
+        return nBucket + 1;
+
+    const int nExponent = nBucket / 4 + 1;
+    const int nSub      = nBucket % 4;
+
+    return qint64(5 + nSub) << (nExponent - 2);
+}
+
+qint64 RPCMetrics::percentileMicros(const MethodStats & stats, quint64 nTotal, double dPercentile)
+{
+    if (0 == nTotal)
+        return 0;
+
+    const quint64 nTarget = std::max(quint64(1), static_cast<quint64>(nTotal * dPercentile + 0.5));
+    quint64 nSeen = 0;
+
+    for (int ii = 0; ii < BucketCount; ++ii)
+    {
+        nSeen += stats.buckets[ii].load();
+
+        if (nSeen >= nTarget)
+            return bucketUpperMicros(ii);
+    }
+    return bucketUpperMicros(BucketCount - 1);
+}
+
+QJsonObject RPCMetrics::toJson()
+{
+    QJsonArray methods;
+
+    for (std::vector<MethodStats *>::const_iterator it = m_stats.begin(); it != m_stats.end(); ++it)
+    {
+        const MethodStats & stats = **it;
+        const quint64 nCalls = stats.calls.load();
+
+        if (0 == nCalls)
+            continue;
+
+        quint64 nFinished = 0;
+        for (int ii = 0; ii < BucketCount; ++ii)
+            nFinished += stats.buckets[ii].load();
+
+        QJsonObject method{{"Method", QString(stats.name)},
+                           {"Calls", qint64(nCalls)},
+                           {"Errors", qint64(stats.errors.load())},
+                           {"Rejected", qint64(stats.rejected.load())},
+                           {"InFlight", qint64(stats.inFlight.load())},
+                           {"MeanMicros", nFinished ? qint64(stats.totalMicros.load() / nFinished) : qint64(0)},
+                           {"P50Micros", percentileMicros(stats, nFinished, 0.50)},
+                           {"P90Micros", percentileMicros(stats, nFinished, 0.90)},
+                           {"P99Micros", percentileMicros(stats, nFinished, 0.99)}};
+        methods.append(method);
+    }
+
+    QJsonObject object{{"Methods", methods}};
+    return object;
+}
+
+// Prometheus text format. The histogram is reported at each power of two of
+// microseconds, which keeps the page short; the finer buckets are in toJson().
+//
+QByteArray RPCMetrics::toPrometheus()
+{
+    QByteArray output;
+
+    output += "# HELP moneychanger_rpc_calls_total RPC calls received, by method.\n"
+              "# TYPE moneychanger_rpc_calls_total counter\n";
+    for (std::vector<MethodStats *>::const_iterator it = m_stats.begin(); it != m_stats.end(); ++it)
+        if ((*it)->calls.load() > 0)
+            output += QString("moneychanger_rpc_calls_total{method=\"%1\"} %2\n").
+                    arg(QString((*it)->name)).arg((*it)->calls.load()).toUtf8();
+
+    output += "# HELP moneychanger_rpc_errors_total RPC calls that answered with an error, by method.\n"
+              "# TYPE moneychanger_rpc_errors_total counter\n";
+    for (std::vector<MethodStats *>::const_iterator it = m_stats.begin(); it != m_stats.end(); ++it)
+        if ((*it)->calls.load() > 0)
+            output += QString("moneychanger_rpc_errors_total{method=\"%1\"} %2\n").
+                    arg(QString((*it)->name)).arg((*it)->errors.load()).toUtf8();
+
+    output += "# HELP moneychanger_rpc_rejected_total RPC calls turned away because the queue was full, by method.\n"
+              "# TYPE moneychanger_rpc_rejected_total counter\n";
+    for (std::vector<MethodStats *>::const_iterator it = m_stats.begin(); it != m_stats.end(); ++it)
+        if ((*it)->calls.load() > 0)
+            output += QString("moneychanger_rpc_rejected_total{method=\"%1\"} %2\n").
+                    arg(QString((*it)->name)).arg((*it)->rejected.load()).toUtf8();
+
+    output += "# HELP moneychanger_rpc_in_flight RPC calls currently running or queued, by method.\n"
+              "# TYPE moneychanger_rpc_in_flight gauge\n";
+    for (std::vector<MethodStats *>::const_iterator it = m_stats.begin(); it != m_stats.end(); ++it)
+        if ((*it)->calls.load() > 0)
+            output += QString("moneychanger_rpc_in_flight{method=\"%1\"} %2\n").
+                    arg(QString((*it)->name)).arg((*it)->inFlight.load()).toUtf8();
+
+    output += "# HELP moneychanger_rpc_latency_seconds RPC latency from receipt to response, by method.\n"
+              "# TYPE moneychanger_rpc_latency_seconds histogram\n";
+    for (std::vector<MethodStats *>::const_iterator it = m_stats.begin(); it != m_stats.end(); ++it)
+    {
+        const MethodStats & stats = **it;
+
+        if (0 == stats.calls.load())
+            continue;
+
+        const QString qstrMethod = QString(stats.name);
+        quint64 nCumulative = 0;
+
+        // Buckets 4k..4k+3 all end at or below 2^(k+1)us.
+        for (int ii = 0; ii < BucketCount; ++ii)
+        {
+            nCumulative += stats.buckets[ii].load();
+
+            if ((ii % 4) == 3)
+                output += QString("moneychanger_rpc_latency_seconds_bucket{method=\"%1\",le=\"%2\"} %3\n").
+                        arg(qstrMethod).arg(double(bucketUpperMicros(ii)) / 1000000.0).arg(nCumulative).toUtf8();
+        }
+        output += QString("moneychanger_rpc_latency_seconds_bucket{method=\"%1\",le=\"+Inf\"} %2\n").
+                arg(qstrMethod).arg(nCumulative).toUtf8();
+        output += QString("moneychanger_rpc_latency_seconds_sum{method=\"%1\"} %2\n").
+                arg(qstrMethod).arg(double(stats.totalMicros.load()) / 1000000.0).toUtf8();
+        output += QString("moneychanger_rpc_latency_seconds_count{method=\"%1\"} %2\n").
+                arg(qstrMethod).arg(nCumulative).toUtf8();
+    }
+
+    return output;
+}
@@ -0,0 +1,75 @@
+#ifndef RPCMETRICS_H
+#define RPCMETRICS_H
+
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QHash>
+#include <QJsonObject>
+#include <QMetaObject>
+#include <QVariant>
+
+#include <vector>
+
+
+// Per-method RPC call counts, error counts, in-flight gauges and latency
+// histograms.
+//
+// The methods are registered once, up front, from the service's meta-object.
+// After that, recording a call is only atomic increments on that method's
+// counters: no locks and no allocation, since it's on every call.
+//
+// Latency goes into HDR-style buckets: four per power of two of microseconds,
+// so the error in any bucket is under 25%, from 1us up to about 12 days.
+//
+class RPCMetrics
+{
+public:
+    static RPCMetrics * getInstance();
+
+    void registerService(const QMetaObject * pMetaObject);
+
+    // Returns a handle for the method at nMethodIndex (or -1), for the calls below.
+    int  callStarted (int nMethodIndex);
+    void callFinished(int nHandle, qint64 nNanoseconds, bool bError);
+    void callRejected(int nHandle); // Busy. Counts as finished, and as an error.
+
+    // Our methods answer errors as {"Error": ...} or "Error: ..." rather than as
+    // JSON-RPC errors.
+    static bool isErrorResult(const QVariant & result);
+
+    QJsonObject toJson();
+    QByteArray  toPrometheus();
+
+private:
+    friend class RPCTest; // Times its own instance, so the live stats aren't touched.
+
+    RPCMetrics();
+    ~RPCMetrics();
+
+    static RPCMetrics * _instance;
+
+    static const int BucketCount = 4 * 40;
+
+    static int    bucketForMicros(quint64 nMicros);
+    static qint64 bucketUpperMicros(int nBucket); // Exclusive.
+
+    struct MethodStats
+    {
+        QByteArray              name;
+        QAtomicInteger<quint64> calls;
+        QAtomicInteger<quint64> errors;
+        QAtomicInteger<quint64> rejected;
+        QAtomicInteger<qint64>  inFlight;
+        QAtomicInteger<quint64> totalMicros;
+        QAtomicInteger<quint64> buckets[BucketCount];
+    };
+
+    qint64 percentileMicros(const MethodStats & stats, quint64 nTotal, double dPercentile);
+
+    const QMetaObject *         m_pMetaObject;
+    int                         m_nMethodOffset;
+    std::vector<int>            m_methodHandles; // Method index - offset -> handle. (Overloads share one.)
+    std::vector<MethodStats *>  m_stats;         // By handle.
+};
+
+#endif // RPCMETRICS_H
@@ -1,5 +1,6 @@
 #include "rpcserver.h"
 #include "mcrpcservice.h"
+#include "rpcdispatcher.h"
 
 #include <core/handlers/DBHandler.hpp>
 
@@ -18,7 +19,7 @@ RPCServer* RPCServer::getInstance()
 
 RPCServer::RPCServer()
 {
-    m_httpserver.addService(new MCRPCService);
+    m_httpserver.addService(new MCRPCAsyncService);
 
     readConfig();
     setupDebugUser();
@@ -73,18 +74,19 @@ void RPCServer::readConfig()
 
 void RPCServer::readAutorun()
 {
-    if (DBHandler::getInstance()->querySize("SELECT `setting`,`parameter1` FROM `settings` WHERE `setting`='rpcserver_autorun'") <= 0)
+    const QVariant varSetting = DBHandler::getInstance()->queryValue("SELECT `parameter1` FROM `settings` WHERE `setting`=?",
+                                                                     QVariantList() << "rpcserver_autorun");
+    if (!varSetting.isValid())
     {
         m_rpcserver_autorun = "true";
-        DBHandler::getInstance()->runQuery(QString("INSERT INTO `settings` (`setting`, `parameter1`) VALUES('rpcserver_autorun','true')"));
+        DBHandler::getInstance()->runQuery("INSERT INTO `settings` (`setting`, `parameter1`) VALUES(?,?)",
+                                           QVariantList() << "rpcserver_autorun" << m_rpcserver_autorun);
         qDebug() << "rpcserver_autorun setting wasn't set in the database. Inserting default: true";
     }
     else
     {
-        if (DBHandler::getInstance()->runQuery("SELECT `setting`,`parameter1` FROM `settings` WHERE `setting`='rpcserver_autorun'"))
-        {
-            m_rpcserver_autorun = DBHandler::getInstance()->queryString("SELECT `parameter1` FROM `settings` WHERE `setting`='rpcserver_autorun'", 0, 0);
-        }
+        m_rpcserver_autorun = varSetting.toString();
+
         if (m_rpcserver_autorun.isEmpty())
         {
             m_rpcserver_autorun = "true";
@@ -101,34 +103,27 @@ void RPCServer::setAutorun(bool setting)
     else
         l_setting = "false";
 
-    if (DBHandler::getInstance()->querySize("SELECT `setting`,`parameter1` FROM `settings` WHERE `setting`='rpcserver_autorun'") <= 0)
-    {
-        DBHandler::getInstance()->runQuery(QString("INSERT INTO `settings` (`setting`, `parameter1`) VALUES('rpcserver_autorun','%1')").arg(l_setting));
-        qDebug() << "rpcserver_autorun setting wasn't set in the database. Inserting: " << l_setting;
-    }
-    else
-    {
-        DBHandler::getInstance()->runQuery(QString("INSERT OR REPLACE INTO 'settings' VALUES('rpcserver_autorun','%1')").arg(l_setting));
-    }
-
+    DBHandler::getInstance()->runQuery("INSERT OR REPLACE INTO `settings` (`setting`, `parameter1`) VALUES(?,?)",
+                                       QVariantList() << "rpcserver_autorun" << l_setting);
     readAutorun();
 }
 
 
 int RPCServer::readListenPort()
 {
-    if (DBHandler::getInstance()->querySize("SELECT `setting`,`parameter1` FROM `settings` WHERE `setting`='rpcserver_listenport'") <= 0)
+    const QVariant varSetting = DBHandler::getInstance()->queryValue("SELECT `parameter1` FROM `settings` WHERE `setting`=?",
+                                                                     QVariantList() << "rpcserver_listenport");
+    if (!varSetting.isValid())
     {
-        DBHandler::getInstance()->runQuery(QString("INSERT INTO `settings` (`setting`, `parameter1`) VALUES('rpcserver_listenport','9500')"));
+        DBHandler::getInstance()->runQuery("INSERT INTO `settings` (`setting`, `parameter1`) VALUES(?,?)",
+                                           QVariantList() << "rpcserver_listenport" << "9500");
         qDebug() << "rpcserver_listenport setting wasn't set in the database. Inserting default: 9500";
         m_rpcserver_listenPort = 9500;
     }
     else
     {
-        if (DBHandler::getInstance()->runQuery("SELECT `setting`,`parameter1` FROM `settings` WHERE `setting`='rpcserver_listenport'"))
-        {
-            m_rpcserver_listenPort = DBHandler::getInstance()->queryString("SELECT `parameter1` FROM `settings` WHERE `setting`='rpcserver_listenport'", 0, 0).toInt();
-        }
+        m_rpcserver_listenPort = varSetting.toString().toInt();
+
         if (m_rpcserver_listenPort <= 0 || m_rpcserver_listenPort > 65535)
         {
             m_rpcserver_listenPort = 9500;
@@ -148,16 +143,8 @@ void RPCServer::setListenPort(int port)
         return;
     }
 
-    if (DBHandler::getInstance()->querySize("SELECT `setting`,`parameter1` FROM `settings` WHERE `setting`='rpcserver_listenport'") <= 0)
-    {
-        DBHandler::getInstance()->runQuery(QString("INSERT INTO `settings` (`setting`, `parameter1`) VALUES('rpcserver_listenport','%1')").arg(port));
-        qDebug() << "rpcserver_listenport setting wasn't set in the database. Inserting: " << port;
-    }
-    else
-    {
-        DBHandler::getInstance()->runQuery(QString("INSERT OR REPLACE INTO 'settings' VALUES('rpcserver_listenport','%1')").arg(port));
-    }
-
+    DBHandler::getInstance()->runQuery("INSERT OR REPLACE INTO `settings` (`setting`, `parameter1`) VALUES(?,?)",
+                                       QVariantList() << "rpcserver_listenport" << QString::number(port));
     readListenPort();
 }
 
@@ -0,0 +1,706 @@
+#include "rpctest.h"
+
+#ifndef __STABLE_HPP__
+#include <core/stable.hpp>
+#endif
+
+#include "rpcdispatcher.h"
+#include "rpcmetrics.h"
+#include "rpcusermanager.h"
+
+#include <qjsonrpchttpserver.h>
+
+#include <core/otlock.hpp>
+#include <core/utils.hpp>
+
+#include <QAtomicInt>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMetaMethod>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QTimer>
+#include <QUrl>
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+
+// Stands in for OT: counts who's in it, and remembers if that was ever more than one.
+//
+class FakeOT
+{
+public:
+    FakeOT() : m_nInside(0), m_nOverlaps(0), m_nCalls(0) {}
+
+    void call(int nLatencyMs)
+    {
+        if (m_nInside.fetchAndAddOrdered(1) != 0)
+            m_nOverlaps.ref();
+
+        m_nCalls.ref();
+        utils::qSleep(nLatencyMs);
+
+        m_nInside.deref();
+    }
+
+    int overlaps() const { return m_nOverlaps.load(); }
+    int calls()    const { return m_nCalls.load(); }
+
+private:
+    QAtomicInt m_nInside;
+    QAtomicInt m_nOverlaps;
+    QAtomicInt m_nCalls;
+};
+
+QJsonDocument rpcRequest(int nId, const QString & qstrMethod, const QJsonArray & params)
+{
+    return QJsonDocument(QJsonObject{{"jsonrpc", "2.0"},
+                                     {"id", nId},
+                                     {"method", QString("moneychanger.%1").arg(qstrMethod)},
+                                     {"params", params}});
+}
+
+// Posts one request and waits for the answer, with the OT lock let go so the
+// executor can run the call. An empty object if there was no answer.
+//
+QJsonObject postRequest(QNetworkAccessManager & theClient, const QUrl & theUrl, const QJsonDocument & theRequest)
+{
+    QNetworkRequest theHttpRequest(theUrl);
+    theHttpRequest.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+
+    QNetworkReply * pReply = theClient.post(theHttpRequest, theRequest.toJson(QJsonDocument::Compact));
+
+    QEventLoop theLoop;
+    QObject::connect(pReply, SIGNAL(finished()), &theLoop, SLOT(quit()));
+
+    if (!pReply->isFinished())
+    {
+        MTOTLock::GuiRelease release;
+
+        QTimer::singleShot(60000, &theLoop, SLOT(quit()));
+        theLoop.exec();
+    }
+
+    QJsonObject theReply;
+
+    if (!pReply->isFinished())
+        pReply->abort();
+    else if (QNetworkReply::NoError == pReply->error())
+        theReply = QJsonDocument::fromJson(pReply->readAll()).object();
+
+    pReply->deleteLater();
+
+    return theReply;
+}
+
+} // namespace
+
+
+//static
+bool RPCTest::TestRPCFunctions()
+{
+    if (!TestDispatcherLoad(32, 0))  // what the dispatcher costs
+        return false;
+
+    if (!TestDispatcherLoad(16, 5))  // GUI and executor taking turns at OT
+        return false;
+
+    if (!TestAPIKeyValidation(1000, 20))
+        return false;
+
+    if (!TestHttpLoad(8, 25))
+        return false;
+
+    if (!TestBatchCalls(20))
+        return false;
+
+    if (!TestMetricsOverhead(4, 1000000))
+        return false;
+
+    return true;
+}
+
+//static
+bool RPCTest::TestDispatcherLoad(int nCallsPerClass, int nLatencyMs)
+{
+    FakeOT theOT;
+
+    RPCDispatcher theDispatcher;
+    theDispatcher.setMaxPending(RPCDispatcher::ReadOnly, nCallsPerClass);
+    theDispatcher.setMaxPending(RPCDispatcher::Mutating, nCallsPerClass);
+    theDispatcher.setMaxPending(RPCDispatcher::Network,  nCallsPerClass);
+
+    QEventLoop theLoop;
+
+    const int nTotal = 3 * nCallsPerClass;
+    int nExpected    = nTotal; // Less the rejected ones. (None, below the limits.)
+    int nDone        = 0;
+    int nRejected    = 0;
+
+    qint64 nMaxReadMs = 0;
+    qint64 nMaxOTMs   = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    // -----------------------------------
+    // The GUI thread goes into OT between the calls, like it does whenever it
+    // handles an event. It has to take the lock itself here, since it's in a
+    // nested event loop, which doesn't.
+    //
+    QTimer theGuiTimer;
+    theGuiTimer.setInterval(1);
+
+    int nGuiCalls = 0;
+
+    QObject::connect(&theGuiTimer, &QTimer::timeout, [&theOT, &nGuiCalls, nLatencyMs]()
+    {
+        QMutexLocker locker(&MTOTLock::mutex());
+        theOT.call(nLatencyMs);
+        ++nGuiCalls;
+    });
+    // -----------------------------------
+    const RPCDispatcher::MethodClass classes[] = { RPCDispatcher::ReadOnly, RPCDispatcher::Mutating, RPCDispatcher::Network };
+
+    for (int ii = 0; ii < nCallsPerClass; ++ii)
+    {
+        for (int jj = 0; jj < 3; ++jj)
+        {
+            const RPCDispatcher::MethodClass methodClass = classes[jj];
+            const qint64 nStarted = timer.elapsed();
+
+            std::function<QVariant()> work = [&theOT, methodClass, nLatencyMs]()
+            {
+                if (RPCDispatcher::ReadOnly == methodClass)
+                    utils::qSleep(nLatencyMs); // A record list read, no OT.
+                else
+                    theOT.call(nLatencyMs);
+
+                return QVariant(static_cast<int>(methodClass));
+            };
+
+            std::function<void(QVariant)> onDone = [&, methodClass, nStarted](QVariant result)
+            {
+                const qint64 nElapsed = timer.elapsed() - nStarted;
+
+                if (result.toInt() != static_cast<int>(methodClass))
+                    qDebug() << "RPCTest: call came back with the wrong result.";
+                else if (RPCDispatcher::ReadOnly == methodClass)
+                    nMaxReadMs = std::max(nMaxReadMs, nElapsed);
+                else
+                    nMaxOTMs = std::max(nMaxOTMs, nElapsed);
+
+                if (++nDone == nExpected)
+                    theLoop.quit();
+            };
+
+            if (!theDispatcher.submit(methodClass, work, onDone))
+                ++nRejected;
+        }
+    }
+    // -----------------------------------
+    nExpected = nTotal - nRejected; // The answers are queued to this thread, so none are in yet.
+
+    if (nExpected > 0)
+    {
+        MTOTLock::GuiRelease release; // Otherwise the executor waits for this thread.
+
+        theGuiTimer.start();
+        QTimer::singleShot(60000, &theLoop, SLOT(quit()));
+        theLoop.exec();
+        theGuiTimer.stop();
+    }
+
+    const qint64 nElapsedMs = timer.elapsed();
+    // -----------------------------------
+    qDebug() << QString("RPCTest: %1 calls per class, %2 ms latency: %3 ms, %4 calls/s, "
+                        "slowest read %5 ms, slowest OT call %6 ms, %7 GUI calls in between, %8 rejected.")
+                .arg(nCallsPerClass).arg(nLatencyMs).arg(nElapsedMs)
+                .arg((nElapsedMs > 0) ? (1000 * nTotal / nElapsedMs) : nTotal)
+                .arg(nMaxReadMs).arg(nMaxOTMs).arg(nGuiCalls).arg(nRejected);
+
+    if (nDone != nTotal)
+    {
+        qDebug() << QString("RPCTest: only %1 of %2 calls came back.").arg(nDone).arg(nTotal);
+        return false;
+    }
+
+    if (theOT.overlaps() > 0)
+    {
+        qDebug() << QString("RPCTest: %1 of %2 OT calls ran alongside another one.").arg(theOT.overlaps()).arg(theOT.calls());
+        return false;
+    }
+
+    // Reads don't wait for OT: the slowest one shouldn't take as long as
+    // the OT queue does.
+    if ((nLatencyMs > 0) && (nMaxReadMs >= nMaxOTMs))
+    {
+        qDebug() << "RPCTest: reads waited for the OT executor.";
+        return false;
+    }
+
+    return true;
+}
+
+//static
+bool RPCTest::TestAPIKeyValidation(int nSessions, int nRounds)
+{
+    RPCUserManager theManager;
+
+    std::vector<QString> vecUsers;
+    std::vector<QString> vecKeys;
+
+    for (int ii = 0; ii < nSessions; ++ii)
+    {
+        const QString qstrUser = QString("rpctest%1").arg(ii);
+
+        vecUsers.push_back(qstrUser);
+        vecKeys.push_back(loginTestUser(theManager, qstrUser));
+    }
+    // -----------------------------------
+    qint64 nsValid = 0, nsOther = 0, nsUnknown = 0, nsNearMiss = 0;
+    int    nWrong  = 0;
+
+    const QString qstrUnknownKey(vecKeys[0].size(), QChar('x'));
+
+    // The right key with only its last character changed. If the comparison
+    // stopped at the first difference, these would take longer than the others.
+    std::vector<QString> vecNearMisses;
+
+    for (int ii = 0; ii < nSessions; ++ii)
+    {
+        QString qstrNearMiss = vecKeys[ii];
+        qstrNearMiss[qstrNearMiss.size() - 1] = (qstrNearMiss.at(qstrNearMiss.size() - 1) == QChar('x')) ? QChar('y') : QChar('x');
+        vecNearMisses.push_back(qstrNearMiss);
+    }
+
+    QElapsedTimer timer;
+
+    for (int round = 0; round < nRounds; ++round)
+    {
+        timer.start();
+        for (int ii = 0; ii < nSessions; ++ii)
+            if (!theManager.validateAPIKey(vecUsers[ii], vecKeys[ii]))
+                ++nWrong;
+        nsValid += timer.nsecsElapsed();
+
+        timer.start();
+        for (int ii = 0; ii < nSessions; ++ii)
+            if (theManager.validateAPIKey(vecUsers[ii], vecKeys[(ii + 1) % nSessions]))
+                ++nWrong;
+        nsOther += timer.nsecsElapsed();
+
+        timer.start();
+        for (int ii = 0; ii < nSessions; ++ii)
+            if (theManager.validateAPIKey(vecUsers[ii], qstrUnknownKey))
+                ++nWrong;
+        nsUnknown += timer.nsecsElapsed();
+
+        timer.start();
+        for (int ii = 0; ii < nSessions; ++ii)
+            if (theManager.validateAPIKey(vecUsers[ii], vecNearMisses[ii]))
+                ++nWrong;
+        nsNearMiss += timer.nsecsElapsed();
+    }
+    // -----------------------------------
+    const qint64 nCalls = qint64(nSessions) * nRounds;
+
+    qDebug() << QString("RPCTest: %1 sessions, validateAPIKey: %2 ns with the right key, %3 ns with another user's, "
+                        "%4 ns with one never issued, %5 ns with the right one but its last character.")
+                .arg(nSessions).arg(nsValid / nCalls).arg(nsOther / nCalls).arg(nsUnknown / nCalls)
+                .arg(nsNearMiss / nCalls);
+
+    if (nWrong > 0)
+    {
+        qDebug() << QString("RPCTest: validateAPIKey answered wrong %1 times.").arg(nWrong);
+        return false;
+    }
+
+    if (theManager.activeSessionCount() != nSessions)
+    {
+        qDebug() << "RPCTest: validateAPIKey dropped sessions.";
+        return false;
+    }
+
+    return true;
+}
+
+//static
+bool RPCTest::TestMetricsOverhead(int nThreads, int nCallsPerThread)
+{
+    RPCMetrics theMetrics; // Not the live one, so rpcStats doesn't count these.
+    theMetrics.registerService(&MCRPCService::staticMetaObject);
+
+    // Any slot will do; they all take the same path.
+    const QMetaObject & theMetaObject = MCRPCService::staticMetaObject;
+    int nMethodIndex = -1;
+
+    for (int ii = theMetaObject.methodOffset(); (ii < theMetaObject.methodCount()) && (nMethodIndex < 0); ++ii)
+        if (QMetaMethod::Slot == theMetaObject.method(ii).methodType())
+            nMethodIndex = ii;
+
+    if (nMethodIndex < 0)
+    {
+        qDebug() << "RPCTest: MCRPCService has no slots to time.";
+        return false;
+    }
+    // -----------------------------------
+    // The same steps MCRPCAsyncService::qt_metacall takes around each call.
+    //
+    const QVariant result(QString("ok"));
+
+    auto recordCalls = [&theMetrics, &result, nMethodIndex, nCallsPerThread]() -> qint64
+    {
+        QElapsedTimer total;
+        total.start();
+
+        for (int ii = 0; ii < nCallsPerThread; ++ii)
+        {
+            QElapsedTimer timer;
+            timer.start();
+
+            const int nHandle = theMetrics.callStarted(nMethodIndex);
+            theMetrics.callFinished(nHandle, timer.nsecsElapsed(), RPCMetrics::isErrorResult(result));
+        }
+
+        return total.nsecsElapsed();
+    };
+
+    const qint64 nsSingle = recordCalls();
+    // -----------------------------------
+    // Every thread on the same method's counters, the worst case for them.
+    std::vector<qint64>      vecNs(nThreads, 0);
+    std::vector<std::thread> vecThreads;
+
+    for (int ii = 0; ii < nThreads; ++ii)
+        vecThreads.push_back(std::thread([&vecNs, &recordCalls, ii]() { vecNs[ii] = recordCalls(); }));
+
+    for (size_t ii = 0; ii < vecThreads.size(); ++ii)
+        vecThreads[ii].join();
+
+    const qint64 nsShared = *std::max_element(vecNs.begin(), vecNs.end());
+    // -----------------------------------
+    const int nHandle = theMetrics.callStarted(nMethodIndex);
+    theMetrics.callRejected(nHandle); // Only to read the counts back; it adds one of each.
+
+    const RPCMetrics::MethodStats & theStats = *theMetrics.m_stats[nHandle];
+    const quint64 nExpected = quint64(nCallsPerThread) * (nThreads + 1) + 1;
+
+    const qint64 nsPerCall       = nsSingle / nCallsPerThread;
+    const qint64 nsPerCallShared = nsShared / nCallsPerThread;
+
+    qDebug() << QString("RPCTest: metrics overhead per call: %1 ns on one thread, %2 ns with %3 threads on the same method.")
+                .arg(nsPerCall).arg(nsPerCallShared).arg(nThreads);
+
+    if ((theStats.calls.load() != nExpected) || (0 != theStats.inFlight.load()))
+    {
+        qDebug() << QString("RPCTest: the metrics counted %1 calls of %2, with %3 still in flight.")
+                    .arg(theStats.calls.load()).arg(nExpected).arg(theStats.inFlight.load());
+        return false;
+    }
+
+    if (nsPerCall >= 1000)
+    {
+        qDebug() << "RPCTest: the metrics cost a microsecond or more per call.";
+        return false;
+    }
+
+    return true;
+}
+
+//static
+QString RPCTest::loginTestUser(RPCUserManager & theManager, const QString & qstrUser)
+{
+    QMutexLocker locker(&theManager.m_Mutex);
+
+    RPCUserManager::RPCUserPtr pUser(new RPCUser(qstrUser, QString("password")));
+    theManager.m_sessions.insert(qstrUser, pUser);
+    theManager.issueAPIKey(qstrUser, *pUser);
+
+    return pUser->currentAPIKey();
+}
+
+//static
+bool RPCTest::TestHttpLoad(int nClients, int nCallsPerClient)
+{
+    QJsonRpcHttpServer theServer;
+
+    MCRPCAsyncService * pService = new MCRPCAsyncService;
+    theServer.addService(pService); // The server deletes it.
+
+    const QString qstrUser("rpctest");
+    const QString qstrKey = loginTestUser(pService->m_userManager, qstrUser);
+
+    if (!theServer.listen(QHostAddress::LocalHost, 0))
+    {
+        qDebug() << "RPCTest: couldn't listen on localhost:" << theServer.errorString();
+        return false;
+    }
+
+    const QUrl theUrl(QString("http://127.0.0.1:%1/").arg(theServer.serverPort()));
+    // -----------------------------------
+    // One of each class: a record list read, an OT call, and a read of the
+    // RPC layer's own state.
+    //
+    static const char * methods[] = { "recordListCount", "getNymCount", "rpcStats" };
+    static const int    nMethods  = sizeof(methods) / sizeof(methods[0]);
+
+    qint64 nMaxMs  [nMethods] = { 0, 0, 0 };
+    qint64 nTotalMs[nMethods] = { 0, 0, 0 };
+    int    nCalls  [nMethods] = { 0, 0, 0 };
+
+    const int nTotal  = nClients * nCallsPerClient;
+    int       nDone   = 0;
+    int       nFailed = 0;
+
+    bool          bStopped = false; // Replies still out when the clients are deleted get aborted, and come back.
+    QEventLoop    theLoop;
+    QElapsedTimer timer;
+    timer.start();
+
+    std::function<void(QNetworkAccessManager *, int)> sendCall;
+
+    sendCall = [&](QNetworkAccessManager * pClient, int nCall)
+    {
+        const int nMethod = nCall % nMethods;
+
+        QJsonObject theRequest{{"jsonrpc", "2.0"},
+                               {"id", nCall},
+                               {"method", QString("moneychanger.%1").arg(methods[nMethod])},
+                               {"params", QJsonArray{qstrUser, qstrKey}}};
+
+        QNetworkRequest theHttpRequest(theUrl);
+        theHttpRequest.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+
+        QNetworkReply * pReply = pClient->post(theHttpRequest, QJsonDocument(theRequest).toJson(QJsonDocument::Compact));
+        const qint64    nStarted = timer.elapsed();
+
+        QObject::connect(pReply, &QNetworkReply::finished, [&, pClient, pReply, nCall, nMethod, nStarted]()
+        {
+            if (bStopped)
+                return;
+
+            const qint64      nElapsed = timer.elapsed() - nStarted;
+            const QJsonObject theReply = QJsonDocument::fromJson(pReply->readAll()).object();
+            pReply->deleteLater();
+
+            // Methods turn away a bad key with an "Error" in the result, not a JSON-RPC error.
+            if ((QNetworkReply::NoError != pReply->error()) || (theReply.value("id").toInt(-1) != nCall) ||
+                !theReply.contains("result") || theReply.value("result").toObject().contains("Error"))
+            {
+                if (0 == nFailed++)
+                    qDebug() << "RPCTest: call" << methods[nMethod] << "failed:" << pReply->errorString() << theReply;
+            }
+
+            nMaxMs  [nMethod] = std::max(nMaxMs[nMethod], nElapsed);
+            nTotalMs[nMethod] += nElapsed;
+            ++nCalls[nMethod];
+
+            if (++nDone == nTotal)
+                theLoop.quit();
+            else if ((nCall + nClients) < nTotal)
+                sendCall(pClient, nCall + nClients);
+        });
+    };
+
+    QObject theClients; // Each client is a QNetworkAccessManager, so each one has its own connection.
+
+    for (int ii = 0; ii < nClients && ii < nTotal; ++ii)
+        sendCall(new QNetworkAccessManager(&theClients), ii);
+    // -----------------------------------
+    if (nTotal > 0)
+    {
+        MTOTLock::GuiRelease release; // Otherwise the executor waits for this thread.
+
+        QTimer::singleShot(120000, &theLoop, SLOT(quit()));
+        theLoop.exec();
+    }
+
+    const qint64 nElapsedMs = timer.elapsed();
+
+    bStopped = true;
+    theServer.close();
+    // -----------------------------------
+    QString qstrLatencies;
+
+    for (int ii = 0; ii < nMethods; ++ii)
+        qstrLatencies += QString(", %1 avg %2 ms max %3 ms").arg(methods[ii])
+                .arg((nCalls[ii] > 0) ? (nTotalMs[ii] / nCalls[ii]) : 0).arg(nMaxMs[ii]);
+
+    qDebug() << QString("RPCTest: HTTP, %1 clients x %2 calls: %3 ms, %4 calls/s%5.")
+                .arg(nClients).arg(nCallsPerClient).arg(nElapsedMs)
+                .arg((nElapsedMs > 0) ? (1000 * nTotal / nElapsedMs) : nTotal)
+                .arg(qstrLatencies);
+
+    if (nDone != nTotal)
+    {
+        qDebug() << QString("RPCTest: only %1 of %2 HTTP calls came back.").arg(nDone).arg(nTotal);
+        return false;
+    }
+
+    if (nFailed > 0)
+    {
+        qDebug() << QString("RPCTest: %1 of %2 HTTP calls failed.").arg(nFailed).arg(nTotal);
+        return false;
+    }
+
+    return true;
+}
+
+//static
+bool RPCTest::TestBatchCalls(int nRounds)
+{
+    QJsonRpcHttpServer theServer;
+
+    MCRPCAsyncService * pService = new MCRPCAsyncService;
+    theServer.addService(pService); // The server deletes it.
+
+    const QString qstrUser("rpctest");
+    const QString qstrKey = loginTestUser(pService->m_userManager, qstrUser);
+
+    if (!theServer.listen(QHostAddress::LocalHost, 0))
+    {
+        qDebug() << "RPCTest: couldn't listen on localhost:" << theServer.errorString();
+        return false;
+    }
+
+    const QUrl theUrl(QString("http://127.0.0.1:%1/").arg(theServer.serverPort()));
+
+    QNetworkAccessManager theClient; // One keep-alive connection, so a stray second answer would show up on the next call.
+    // -----------------------------------
+    // The first four go into OT. The defaults run on the GUI thread, which
+    // takes the whole batch with them.
+    //
+    static const char * methods[] = { "getNymCount", "getServerCount", "getAssetTypeCount", "getAccountCount",
+                                      "getDefaultNym", "getDefaultAccount", "getDefaultServer", "getDefaultAsset" };
+    static const int    nMethods   = sizeof(methods) / sizeof(methods[0]);
+    static const int    nOTMethods = 4;
+
+    const QJsonArray theCredentials{qstrUser, qstrKey};
+
+    QJsonArray callsOT, callsAll;
+
+    for (int ii = 0; ii < nMethods; ++ii)
+    {
+        const QJsonObject theCall{{"id", ii}, {"method", QString(methods[ii])}, {"params", QJsonArray()}};
+
+        if (ii < nOTMethods)
+            callsOT.append(theCall);
+        callsAll.append(theCall);
+    }
+    // -----------------------------------
+    int nId    = 0;
+    int nWrong = 0;
+
+    // The result of one call, after checking that the answer is for that call.
+    auto call = [&](const QString & qstrMethod, const QJsonArray & params) -> QJsonValue
+    {
+        const int nThisId = ++nId;
+        const QJsonObject theReply = postRequest(theClient, theUrl, rpcRequest(nThisId, qstrMethod, params));
+
+        if ((theReply.value("id").toInt(-1) != nThisId) || !theReply.contains("result"))
+        {
+            if (0 == nWrong++)
+                qDebug() << "RPCTest:" << qstrMethod << "got the wrong answer:" << theReply;
+            return QJsonValue();
+        }
+        return theReply.value("result");
+    };
+
+    // The same results as the calls one at a time, none of them missing.
+    auto checkBatch = [&](const QJsonValue & theBatch, const std::vector<QJsonValue> & vecExpected)
+    {
+        const QJsonArray results = theBatch.toObject().value("BatchResults").toArray();
+
+        if (results.size() != static_cast<int>(vecExpected.size()))
+        {
+            if (0 == nWrong++)
+                qDebug() << "RPCTest: batch came back with" << results.size() << "results:" << theBatch;
+            return;
+        }
+
+        for (int ii = 0; ii < results.size(); ++ii)
+        {
+            const QJsonObject theResult = results.at(ii).toObject();
+
+            if ((theResult.value("id").toInt(-1) != ii) || theResult.value("result").isNull() ||
+                (theResult.value("result") != vecExpected[ii]))
+            {
+                if (0 == nWrong++)
+                    qDebug() << "RPCTest: batch call" << methods[ii] << "came back as" << theResult
+                             << "instead of" << vecExpected[ii];
+            }
+        }
+    };
+    // -----------------------------------
+    qint64 nsSingle = 0, nsBatchOT = 0, nsBatchAll = 0, nsDashboard = 0;
+
+    QElapsedTimer timer;
+
+    for (int round = 0; round < nRounds; ++round)
+    {
+        std::vector<QJsonValue> vecSingle;
+
+        timer.start();
+        for (int ii = 0; ii < nMethods; ++ii)
+            vecSingle.push_back(call(methods[ii], theCredentials));
+        nsSingle += timer.nsecsElapsed();
+
+        timer.start();
+        const QJsonValue theBatchOT = call("batch", QJsonArray{qstrUser, qstrKey, callsOT});
+        nsBatchOT += timer.nsecsElapsed();
+
+        timer.start();
+        const QJsonValue theBatchAll = call("batch", QJsonArray{qstrUser, qstrKey, callsAll});
+        nsBatchAll += timer.nsecsElapsed();
+
+        timer.start();
+        const QJsonValue theDashboard = call("dashboard", theCredentials);
+        nsDashboard += timer.nsecsElapsed();
+
+        checkBatch(theBatchOT,  std::vector<QJsonValue>(vecSingle.begin(), vecSingle.begin() + nOTMethods));
+        checkBatch(theBatchAll, vecSingle);
+
+        if (!theDashboard.toObject().value("Nyms").isArray() && (0 == nWrong++))
+            qDebug() << "RPCTest: dashboard came back as" << theDashboard;
+    }
+    // -----------------------------------
+    // The batch's own key is checked once, and only the user's key gets it in.
+    //
+    const QJsonValue theRefused = call("batch", QJsonArray{qstrUser, QString(qstrKey).append('x'), callsOT});
+
+    if (!theRefused.toObject().contains("Error"))
+    {
+        qDebug() << "RPCTest: a batch with the wrong key came back as" << theRefused;
+        ++nWrong;
+    }
+
+    theServer.close();
+    // -----------------------------------
+    const qint64 nScreens = std::max(nRounds, 1);
+
+    qDebug() << QString("RPCTest: one screen over HTTP, %1 calls one at a time: %2 us, as an OT batch of %3: %4 us, "
+                        "as one batch: %5 us, as the dashboard: %6 us.")
+                .arg(nMethods).arg(nsSingle / nScreens / 1000)
+                .arg(nOTMethods).arg(nsBatchOT / nScreens / 1000)
+                .arg(nsBatchAll / nScreens / 1000).arg(nsDashboard / nScreens / 1000);
+
+    if (nWrong > 0)
+    {
+        qDebug() << QString("RPCTest: %1 batch answers were wrong.").arg(nWrong);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,50 @@
+#ifndef RPCTEST_H
+#define RPCTEST_H
+
+#include <QString>
+
+class RPCUserManager;
+
+// Load tests for the RPC layer, run from the bitcoin test window along with
+// BtcTest. Needs the GUI thread's event loop, and no running RPC server.
+//
+class RPCTest
+{
+public:
+    static bool TestRPCFunctions();
+
+private:
+    // Clients keep this many calls of each class out at once, while the GUI
+    // thread keeps going into OT on a timer. Fails if the GUI thread and the OT
+    // executor are ever in OT at the same time, if a call is lost, or if reads
+    // have to wait for the executor.
+    static bool TestDispatcherLoad(int nCallsPerClass, int nLatencyMs);
+
+    // This many sessions are logged in (without the database), then every key
+    // is checked: the right one, another user's, one that was never issued,
+    // and the right one with its last character changed.
+    static bool TestAPIKeyValidation(int nSessions, int nRounds);
+
+    // A real HTTP server on a free localhost port, with the same service the
+    // RPC server runs, and this many clients each posting calls one after
+    // another: a record list read, an OT read and the stats. Fails if any call
+    // doesn't come back with a result. (OT and the database are the live ones.)
+    static bool TestHttpLoad(int nClients, int nCallsPerClient);
+
+    // What one screen of a client costs over HTTP: the counts and defaults one
+    // call at a time, the same calls as one batch (with and without the ones
+    // that run on the GUI thread), and the dashboard. Fails unless the batch
+    // answers once, with the same results as the single calls.
+    static bool TestBatchCalls(int nRounds);
+
+    // What the dispatcher adds to every call for the metrics: the timer,
+    // callStarted(), isErrorResult() and callFinished(), on one thread and then
+    // on this many at once, all on the same method. Fails if a call costs a
+    // microsecond or more on one thread, or if any calls go uncounted.
+    static bool TestMetricsOverhead(int nThreads, int nCallsPerThread);
+
+    // Logs a session in without the database, and returns its API key.
+    static QString loginTestUser(RPCUserManager & theManager, const QString & qstrUser);
+};
+
+#endif // RPCTEST_H
@@ -1,6 +1,8 @@
 #include "rpcuser.h"
 #include <QDebug>
 
+#include <algorithm>
+
 RPCUser::RPCUser(QString Username, QString Password)
 {
     m_username = Username;
@@ -16,6 +18,26 @@ RPCUser::~RPCUser()
 }
 
 
+// Takes the same time whether the keys differ in the first character or the
+// last, so the key can't be guessed one character at a time.
+//
+//static
+bool RPCUser::keysMatch(const QString & lhs, const QString & rhs)
+{
+    const QByteArray left  = lhs.toUtf8();
+    const QByteArray right = rhs.toUtf8();
+
+    if(right.isEmpty())
+        return false;
+
+    int nDiff = left.size() ^ right.size();
+
+    for(int x = 0; x < left.size(); x++)
+        nDiff |= left.at(x) ^ right.at(x % right.size());
+
+    return (0 == nDiff);
+}
+
 bool RPCUser::checkAPIKey(QString APIKey)
 {
     if(APIKey != ""){
@@ -24,9 +46,8 @@ bool RPCUser::checkAPIKey(QString APIKey)
             return false;
         }
         else{
-            if(APIKey == m_APIKey){
-                // 300,000 ms to 5 minutes
-                if(m_APIKeyTimestamp.elapsed() < m_keyTimeout)
+            if(keysMatch(APIKey, m_APIKey)){
+                if(!isKeyExpired())
                 {
                     resetTimeStamp();
                     return true;
@@ -46,12 +67,26 @@ bool RPCUser::checkAPIKey(QString APIKey)
     }
 }
 
+bool RPCUser::isKeyExpired() const
+{
+    // No key yet, so nothing to expire.
+    if(!m_APIKeyTimestamp.isValid())
+        return false;
 
-void RPCUser::resetTimeStamp()
+    return m_APIKeyTimestamp.hasExpired(m_keyTimeout);
+}
+
+qint64 RPCUser::keyExpiresIn() const
 {
-    // Note that the counter wraps to zero
-    // 24 hours after the last call to start() or restart.
+    if(!m_APIKeyTimestamp.isValid())
+        return m_keyTimeout;
+
+    return m_keyTimeout - m_APIKeyTimestamp.elapsed();
+}
 
+
+void RPCUser::resetTimeStamp()
+{
     m_APIKeyTimestamp.restart();
 }
 
@@ -67,12 +102,9 @@ QString RPCUser::generateAPIKey(int length)
 
     std::string sanitizedString(password.getPassword());
     std::string illegalChars = "\\/:;%$!@*`'?\"<>|";
-    for (auto it = sanitizedString.begin(); it < sanitizedString.end() ; ++it){
-        bool found = illegalChars.find(*it) != std::string::npos;
-        if(found){
-            sanitizedString.erase(it);
-        }
-    }
+    sanitizedString.erase(std::remove_if(sanitizedString.begin(), sanitizedString.end(),
+                                         [&illegalChars](char c){ return illegalChars.find(c) != std::string::npos; }),
+                          sanitizedString.end());
 
     QString outputString(sanitizedString.c_str());
 
@@ -104,6 +136,6 @@ void RPCUser::refreshAPIKey()
 void RPCUser::setKeyTimeout(int seconds)
 {
     // m_keyTimeout is time in milliseconds
-    m_keyTimeout = seconds * 1000;
+    m_keyTimeout = qint64(seconds) * 1000;
 
 }
@@ -2,7 +2,7 @@
 #define RPCUSER_H
 
 #include <string>
-#include <QTime>
+#include <QElapsedTimer>
 
 #include "core/WinsockWrapper.h"
 #include "core/ExportWrapper.h"
@@ -19,24 +19,30 @@ public:
     ~RPCUser();
 
     QString generateAPIKey(int length=32);
-    bool checkAPIKey(QString APIKey);
+    bool checkAPIKey(QString APIKey); // Constant-time comparison. Also keeps the key alive.
+    static bool keysMatch(const QString & lhs, const QString & rhs); // The comparison itself.
     void refreshAPIKey();
     QString getAPIKey();
+    QString currentAPIKey() const {return m_APIKey;} // Without generating one.
     QString getUsername(){return m_username;}
     QString getPassword(){return m_password;}
 
     void setKeyTimeout(int seconds); // timeout in seconds
     bool isKeyActive(){return m_keyActive;}
 
+    // Both on the monotonic clock, so changing the system time doesn't matter.
+    bool isKeyExpired() const;
+    qint64 keyExpiresIn() const; // In milliseconds.
+
 
 private:
 
     QString m_username;
     QString m_password;
 
-    QTime m_APIKeyTimestamp;
+    QElapsedTimer m_APIKeyTimestamp;
     int m_keyLength;
-    int m_keyTimeout;
+    qint64 m_keyTimeout;
     QString m_APIKey;
 
     bool m_keyActive;
@@ -1,8 +1,11 @@
 #include "rpcusermanager.h"
 
+#include <algorithm>
+
 RPCUserManager::RPCUserManager()
+    : m_wheel(WheelSlots), m_sweptSecond(0)
 {
-
+    m_clock.start();
 }
 
 
@@ -17,8 +20,13 @@ bool RPCUserManager::activateUserAccount(QString Username, QString Password)
 
     if(checkUserExistsInDatabase(Username)){
         if(validateUserInDatabase(Username, Password)){
-            if(!checkUserActivated(Username))
-                m_userList.push_back(RPCUser(Username, Password));
+            QMutexLocker locker(&m_Mutex);
+
+            if(!m_sessions.contains(Username)){
+                RPCUserPtr pUser(new RPCUser(Username, Password));
+                m_sessions.insert(Username, pUser);
+                scheduleExpiry(Username, *pUser);
+            }
             return true;
         }
         else{
@@ -27,17 +35,6 @@ bool RPCUserManager::activateUserAccount(QString Username, QString Password)
         }
     }
     else{
-        /*
-        if(addUserToDatabase(Username, Password)){
-            if(!checkUserActivated(Username))
-                m_userList.push_back(RPCUser(Username, Password));
-            return true;
-        }
-        else{
-            qDebug() << "Error adding User to Database";
-            return false;
-        }
-        */
         qDebug() << "Error: activateUserAccount() called for User that does not exist in Database: " + Username;
         return false;
     }
@@ -46,15 +43,11 @@ bool RPCUserManager::activateUserAccount(QString Username, QString Password)
 
 bool RPCUserManager::deactivateUserAccount(QString Username)
 {
-    if(checkUserActivated(Username)){
-        for(size_t x = 0; x < m_userList.size(); x++){
-            if(m_userList.at(x).getUsername() == Username){
-                m_userList.erase(m_userList.begin() + x);
-                return true;
-            }
-        }
-        qDebug() << "Error: Could not find User - " + Username + " in Userlist";
-        return false;
+    QMutexLocker locker(&m_Mutex);
+
+    if(m_sessions.contains(Username)){
+        removeSession(Username);
+        return true;
     }
     else{
         qDebug() << "Error: deactivateUserAccount() called for inactive user";
@@ -65,71 +58,145 @@ bool RPCUserManager::deactivateUserAccount(QString Username)
 
 bool RPCUserManager::validateAPIKey(QString Username, QString APIKey)
 {
-    if(checkUserActivated(Username))
-    {
-        for(size_t x = 0; x < m_userList.size(); x++){
-            if(m_userList.at(x).getUsername() == Username){
-                if(m_userList.at(x).checkAPIKey(APIKey))
-                    return true;
-                else{
-                    if(!m_userList.at(x).isKeyActive())
-                        deactivateUserAccount(Username);
-                    return false;
-                }
-            }
-        }
-        return true;
-    }
-    else{
+    QMutexLocker locker(&m_Mutex);
+
+    sweepExpiredSessions();
+
+    // Looked up by username only. Anything keyed by the API key itself would
+    // take more or less time depending on the key, so the only place the key
+    // is looked at is the constant-time comparison in checkAPIKey().
+    RPCUserPtr pUser = m_sessions.value(Username);
+
+    if(pUser.isNull()){
         qDebug() << "Error: validateAPIKey() called on inactive User: " + Username;
         return false;
     }
 
+    if(pUser->checkAPIKey(APIKey)) // RPCUser::keysMatch(). Also keeps the key alive, or notices it expired.
+        return true;
+
+    if(!pUser->isKeyActive())
+        removeSession(Username);
+
+    return false;
 }
 
 QString RPCUserManager::getAPIKey(QString Username)
 {
-    if(!checkUserActivated(Username))
+    QMutexLocker locker(&m_Mutex);
+
+    RPCUserPtr pUser = m_sessions.value(Username);
+
+    if(pUser.isNull())
         return "Error: User Not Activated";
 
-    else{
-        for(size_t x = 0; x < m_userList.size(); x++){
-            if(m_userList.at(x).getUsername() == Username){
-                return m_userList.at(x).getAPIKey();
-            }
-        }
-        return "Error: RPCUserManager::getAPIKey("+Username+") - User Not Found";
-    }
+    if(!pUser->isKeyActive())
+        issueAPIKey(Username, *pUser);
+
+    return pUser->getAPIKey();
 }
 
 
 void RPCUserManager::setTimeoutForUser(QString Username, int seconds)
 {
-    for(size_t x = 0; x < m_userList.size(); x++){
-        if(m_userList.at(x).getUsername() == Username){
-            m_userList.at(x).setKeyTimeout(seconds);
-            return;
-        }
+    QMutexLocker locker(&m_Mutex);
+
+    RPCUserPtr pUser = m_sessions.value(Username);
+
+    if(!pUser.isNull()){
+        pUser->setKeyTimeout(seconds);
+        scheduleExpiry(Username, *pUser);
     }
 }
 
 
 void RPCUserManager::setGlobalTimeout(int seconds)
 {
-    for(size_t x = 0; x < m_userList.size(); x++){
-        m_userList.at(x).setKeyTimeout(seconds);
+    QMutexLocker locker(&m_Mutex);
+
+    for(auto it = m_sessions.begin(); it != m_sessions.end(); ++it){
+        it.value()->setKeyTimeout(seconds);
+        scheduleExpiry(it.key(), *it.value());
+    }
+}
+
+
+int RPCUserManager::activeSessionCount()
+{
+    QMutexLocker locker(&m_Mutex);
+
+    sweepExpiredSessions();
+    return m_sessions.size();
+}
+
+
+// The rest of these are called with m_Mutex already locked.
+
+void RPCUserManager::sweepExpiredSessions()
+{
+    const qint64 nowSecond = m_clock.elapsed() / 1000;
+
+    if(nowSecond <= m_sweptSecond)
+        return;
+
+    // Never more than one turn of the wheel, since that covers every slot.
+    const qint64 fromSecond = std::max(m_sweptSecond + 1, nowSecond - WheelSlots + 1);
+    m_sweptSecond = nowSecond;
+
+    for(qint64 second = fromSecond; second <= nowSecond; second++){
+        QSet<QString> & slot = m_wheel[second % WheelSlots];
+
+        if(slot.isEmpty())
+            continue;
+
+        const QSet<QString> dueUsers = slot;
+        slot.clear();
+
+        foreach(const QString & Username, dueUsers){
+            RPCUserPtr pUser = m_sessions.value(Username);
+
+            if(pUser.isNull())
+                continue; // Logged out since.
+
+            if(pUser->isKeyExpired())
+                removeSession(Username);
+            else
+                scheduleExpiry(Username, *pUser); // Used since, so it expires later.
+        }
     }
 }
 
+void RPCUserManager::scheduleExpiry(const QString & Username, const RPCUser & user)
+{
+    const qint64 expirySecond = (m_clock.elapsed() + std::max(user.keyExpiresIn(), qint64(0))) / 1000 + 1;
+
+    m_wheel[expirySecond % WheelSlots].insert(Username);
+}
+
+void RPCUserManager::issueAPIKey(const QString & Username, RPCUser & user)
+{
+    user.generateAPIKey();
+    scheduleExpiry(Username, user);
+}
+
+void RPCUserManager::removeSession(const QString & Username)
+{
+    m_sessions.remove(Username);
+    // Its wheel slot is cleaned up when the sweep gets there.
+}
+
 
 bool RPCUserManager::validateUserInDatabase(QString Username, QString Password)
 {
     if(!isStringSanitized(Username))
         return false;
 
-    auto user_check = DBHandler::getInstance()->runQuery(QString("SELECT `user_id` FROM `rpc_users` WHERE `user_id`='%1' AND `password`='%2'").arg(Username).arg(Password));
+    // Has to fetch the row: runQuery() only says whether the SELECT ran, which it
+    // does for any password.
+    auto user_check = DBHandler::getInstance()->queryValue("SELECT `user_id` FROM `rpc_users` WHERE `user_id`=? AND `password`=?",
+                                                           QVariantList() << Username << Password);
 
-    if(user_check)
+    if(user_check.isValid())
         return true;
     else
         return false;
@@ -137,12 +204,10 @@ bool RPCUserManager::validateUserInDatabase(QString Username, QString Password)
 
 bool RPCUserManager::checkUserActivated(QString Username)
 {
-    for(size_t x = 0; x < m_userList.size(); x++){
-        if(m_userList.at(x).getUsername() == Username){
-            return true;
-        }
-    }
-    return false;
+    QMutexLocker locker(&m_Mutex);
+
+    sweepExpiredSessions();
+    return m_sessions.contains(Username);
 }
 
 
@@ -164,7 +229,8 @@ bool RPCUserManager::checkUserExistsInDatabase(QString Username)
     if(!isStringSanitized(Username))
         return false;
 
-    auto user_check = DBHandler::getInstance()->queryString(QString("SELECT `user_id` FROM `rpc_users` WHERE `user_id`='%1'").arg(Username), 0, 0);
+    auto user_check = DBHandler::getInstance()->queryString("SELECT `user_id` FROM `rpc_users` WHERE `user_id`=?",
+                                                            QVariantList() << Username);
 
     if(user_check.isEmpty())
         return false;
@@ -182,7 +248,8 @@ bool RPCUserManager::addUserToDatabase(QString Username, QString Password)
     if(checkUserExistsInDatabase(Username))
         return false;
 
-    auto added_user = DBHandler::getInstance()->runQuery(QString("INSERT INTO `rpc_users` (`user_id`,`password`) VALUES('%1','%2')").arg(Username).arg(Password));
+    auto added_user = DBHandler::getInstance()->runQuery("INSERT INTO `rpc_users` (`user_id`,`password`) VALUES(?,?)",
+                                                         QVariantList() << Username << Password);
 
     if(added_user)
         return true;
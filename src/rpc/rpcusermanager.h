@@ -6,6 +6,12 @@
 #include "core/handlers/DBHandler.hpp"
 #include "rpcuser.h"
 
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QElapsedTimer>
+
 class RPCUserManager
 {
 public:
@@ -24,10 +30,32 @@ public:
     bool validateAPIKey(QString Username, QString APIKey);
     bool validateUserInDatabase(QString Username, QString Password);
 
+    int activeSessionCount();
+
 private:
+    friend class RPCTest;
+
+    typedef QSharedPointer<RPCUser> RPCUserPtr;
+
+    // Sessions for activated Users, by username. Everything below is guarded
+    // by m_Mutex, since the RPC dispatcher validates keys from more than one
+    // thread.
+    QMutex                     m_Mutex;
+    QHash<QString, RPCUserPtr> m_sessions;
+
+    // Expiry wheel: one slot per second. Each session sits in the slot for the
+    // second its key expires (mod WheelSlots.) Each call sweeps the slots that
+    // went by since the last one. A session that was used in the meantime isn't
+    // expired yet, so it just moves to its new slot.
+    static const int           WheelSlots=256;
+    std::vector<QSet<QString>> m_wheel;
+    QElapsedTimer              m_clock;
+    qint64                     m_sweptSecond;
 
-    // Container for activated Users
-    std::vector<RPCUser> m_userList;
+    void sweepExpiredSessions();
+    void scheduleExpiry(const QString & Username, const RPCUser & user);
+    void issueAPIKey(const QString & Username, RPCUser & user);
+    void removeSession(const QString & Username);
 
     bool checkUserExistsInDatabase(QString Username);
     bool addUserToDatabase(QString Username, QString Password);